@@ -28,6 +28,7 @@
 #include <string>
 
 #include "QtiComposerClient.h"
+#include "hwc_command_recorder.h"
 
 namespace vendor {
 namespace qti {
@@ -65,6 +66,7 @@ void BufferCacheEntry::clear() {
 QtiComposerClient::QtiComposerClient() : mWriter(kWriterInitialSize), mReader(*this) {
   hwc_session_ = HWCSession::GetInstance();
   mHandleImporter.initialize();
+  HWCCommandRecorder::GetInstance()->Configure();
 }
 
 QtiComposerClient::~QtiComposerClient() {
@@ -332,6 +334,7 @@ Return<void> QtiComposerClient::createLayer(uint64_t display, uint32_t bufferSlo
   auto error = hwc_session_->CreateLayer(display, &layer);
   Error err = static_cast<Error>(error);
   if (err == Error::NONE) {
+    HWCCommandRecorder::GetInstance()->RecordLayerEvent(kCaptureLayerCreate, display, layer);
     std::lock_guard<std::mutex> lock(mDisplayDataMutex);
     auto dpy = mDisplayData.find(display);
     // The display entry may have already been removed by onHotplug.
@@ -354,6 +357,7 @@ Return<Error> QtiComposerClient::destroyLayer(uint64_t display, uint64_t layer)
   auto error = hwc_session_->DestroyLayer(display, layer);
   Error err = static_cast<Error>(error);
   if (err == Error::NONE) {
+    HWCCommandRecorder::GetInstance()->RecordLayerEvent(kCaptureLayerDestroy, display, layer);
     std::lock_guard<std::mutex> lock(mDisplayDataMutex);
 
     auto dpy = mDisplayData.find(display);
@@ -579,12 +583,16 @@ Return<void> QtiComposerClient::executeCommands(uint32_t inLength,
   uint32_t outLength = 0;
   hidl_vec<hidl_handle> outHandles;
 
+  HWCCommandCapture capture(0x201);
+
   if (!mReader.readQueue(inLength, inHandles)) {
     _hidl_cb(Error::BAD_PARAMETER, outChanged, outLength, outHandles);
     return Void();
   }
 
+  capture.ParseBegin();
   Error err = mReader.parse();
+  capture.ParseEnd(mReader.getData(), mReader.getDataSize(), inHandles);
   if (err == Error::NONE &&
       !mWriter.writeQueue(outChanged, outLength, outHandles)) {
     err = Error::NO_RESOURCES;
@@ -805,12 +813,16 @@ Return<void> QtiComposerClient::executeCommands_2_2(uint32_t inLength,
   uint32_t outLength = 0;
   hidl_vec<hidl_handle> outHandles;
 
+  HWCCommandCapture capture(0x202);
+
   if (!mReader.readQueue(inLength, inHandles)) {
     _hidl_cb(Error::BAD_PARAMETER, outChanged, outLength, outHandles);
     return Void();
   }
 
+  capture.ParseBegin();
   Error err = mReader.parse();
+  capture.ParseEnd(mReader.getData(), mReader.getDataSize(), inHandles);
   if (err == Error::NONE &&
       !mWriter.writeQueue(outChanged, outLength, outHandles)) {
       err = Error::NO_RESOURCES;
@@ -922,12 +934,16 @@ Return<void> QtiComposerClient::executeCommands_2_3(uint32_t inLength,
   uint32_t outLength = 0;
   hidl_vec<hidl_handle> outHandles;
 
+  HWCCommandCapture capture(0x203);
+
   if (!mReader.readQueue(inLength, inHandles)) {
     _hidl_cb(Error::BAD_PARAMETER, outChanged, outLength, outHandles);
     return Void();
   }
 
+  capture.ParseBegin();
   Error err = mReader.parse();
+  capture.ParseEnd(mReader.getData(), mReader.getDataSize(), inHandles);
   if (err == Error::NONE &&
       !mWriter.writeQueue(outChanged, outLength, outHandles)) {
       err = Error::NO_RESOURCES;
@@ -732,6 +732,10 @@ class CommandReaderBase {
     return true;
   }
 
+  // Commands read by the last readQueue, valid until reset.
+  const uint32_t* getData() const { return mData.get(); }
+  uint32_t getDataSize() const { return mDataSize; }
+
   void reset() {
     mDataSize = 0;
     mDataRead = 0;
@@ -0,0 +1,472 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "cpu_color_convert_impl.h"
+#include "gralloc_priv.h"
+
+#define __CLASS__ "CPUColorConvertImpl"
+
+namespace sdm {
+
+const int32_t CPUColorConvertImpl::kCoeffShift;
+
+static bool GetRGBFormat(int format, uint32_t *bits) {
+  switch (format) {
+    case HAL_PIXEL_FORMAT_RGBA_8888:
+    case HAL_PIXEL_FORMAT_RGBX_8888:
+      *bits = 8;
+      return true;
+    case HAL_PIXEL_FORMAT_RGBA_1010102:
+      *bits = 10;
+      return true;
+    default:
+      return false;
+  }
+}
+
+static bool GetYUVFormat(int format, uint32_t *bits, bool *swap_uv) {
+  switch (format) {
+    case HAL_PIXEL_FORMAT_YCbCr_420_SP:
+    case HAL_PIXEL_FORMAT_YCbCr_420_SP_VENUS:
+    case HAL_PIXEL_FORMAT_NV12_ENCODEABLE:
+      *bits = 8;
+      *swap_uv = false;
+      return true;
+    case HAL_PIXEL_FORMAT_YCrCb_420_SP:
+    case HAL_PIXEL_FORMAT_YCrCb_420_SP_VENUS:
+      *bits = 8;
+      *swap_uv = true;
+      return true;
+    case HAL_PIXEL_FORMAT_YCbCr_420_P010:
+    case HAL_PIXEL_FORMAT_YCbCr_420_P010_VENUS:
+      *bits = 10;
+      *swap_uv = false;
+      return true;
+    default:
+      return false;
+  }
+}
+
+static void GetLumaWeights(ColorPrimaries primaries, double *kr, double *kb) {
+  switch (primaries) {
+    case ColorPrimaries_BT709_5:
+      *kr = 0.2126;
+      *kb = 0.0722;
+      break;
+    case ColorPrimaries_BT2020:
+      *kr = 0.2627;
+      *kb = 0.0593;
+      break;
+    default:
+      *kr = 0.299;
+      *kb = 0.114;
+      break;
+  }
+}
+
+// Code ranges of a YUV format: luma offset and excursion, chroma center and excursion.
+static void GetYUVRange(ColorRange range, uint32_t bits, double *y_offset, double *y_range,
+                        double *c_offset, double *c_range) {
+  double scale = DOUBLE(1 << (bits - 8));
+  *c_offset = 128.0 * scale;
+  if (range == Range_Full) {
+    *y_offset = 0.0;
+    *y_range = DOUBLE((1 << bits) - 1);
+    *c_range = *y_range;
+  } else {
+    *y_offset = 16.0 * scale;
+    *y_range = 219.0 * scale;
+    *c_range = 224.0 * scale;
+  }
+}
+
+static int32_t ToFixed(double value) {
+  return INT32(lround(value * DOUBLE(1 << CPUColorConvertImpl::kCoeffShift)));
+}
+
+void CPUColorConvertImpl::GetRGBToYUVCoeffs(const ColorConvertCSC &csc, uint32_t rgb_bits,
+                                            uint32_t yuv_bits, RGBToYUVCoeffs *coeffs) {
+  double kr = 0.0, kb = 0.0;
+  double y_offset = 0.0, y_range = 0.0, c_offset = 0.0, c_range = 0.0;
+  GetLumaWeights(csc.primaries, &kr, &kb);
+  GetYUVRange(csc.range, yuv_bits, &y_offset, &y_range, &c_offset, &c_range);
+
+  double kg = 1.0 - kr - kb;
+  double rgb_max = DOUBLE((1 << rgb_bits) - 1);
+  double ys = y_range / rgb_max;
+  double cs = c_range / rgb_max;
+
+  coeffs->y[0] = ToFixed(kr * ys);
+  coeffs->y[1] = ToFixed(kg * ys);
+  coeffs->y[2] = ToFixed(kb * ys);
+  coeffs->u[0] = ToFixed(-kr / (2.0 * (1.0 - kb)) * cs);
+  coeffs->u[1] = ToFixed(-kg / (2.0 * (1.0 - kb)) * cs);
+  coeffs->u[2] = ToFixed(0.5 * cs);
+  coeffs->v[0] = ToFixed(0.5 * cs);
+  coeffs->v[1] = ToFixed(-kg / (2.0 * (1.0 - kr)) * cs);
+  coeffs->v[2] = ToFixed(-kb / (2.0 * (1.0 - kr)) * cs);
+  coeffs->y_offset = INT32(y_offset);
+  coeffs->c_offset = INT32(c_offset);
+  coeffs->y_max = (1 << yuv_bits) - 1;
+}
+
+void CPUColorConvertImpl::GetYUVToRGBCoeffs(const ColorConvertCSC &csc, uint32_t yuv_bits,
+                                            uint32_t rgb_bits, YUVToRGBCoeffs *coeffs) {
+  double kr = 0.0, kb = 0.0;
+  double y_offset = 0.0, y_range = 0.0, c_offset = 0.0, c_range = 0.0;
+  GetLumaWeights(csc.primaries, &kr, &kb);
+  GetYUVRange(csc.range, yuv_bits, &y_offset, &y_range, &c_offset, &c_range);
+
+  double kg = 1.0 - kr - kb;
+  double rgb_max = DOUBLE((1 << rgb_bits) - 1);
+  double cs = rgb_max / c_range;
+
+  coeffs->y = ToFixed(rgb_max / y_range);
+  coeffs->r_v = ToFixed(2.0 * (1.0 - kr) * cs);
+  coeffs->g_u = ToFixed(2.0 * kb * (1.0 - kb) / kg * cs);
+  coeffs->g_v = ToFixed(2.0 * kr * (1.0 - kr) / kg * cs);
+  coeffs->b_u = ToFixed(2.0 * (1.0 - kb) * cs);
+  coeffs->y_offset = INT32(y_offset);
+  coeffs->c_offset = INT32(c_offset);
+  coeffs->rgb_max = (1 << rgb_bits) - 1;
+}
+
+static inline int32_t Clamp(int32_t value, int32_t max) {
+  return std::min(std::max(value, 0), max);
+}
+
+void CPUColorConvertImpl::RGBToYUVRows(const RGBToYUVCoeffs &coeffs,
+                                       const int32_t *const rgb[2][3], uint32_t width,
+                                       int32_t *y[2], int32_t *u, int32_t *v) {
+  const int32_t y_round = (coeffs.y_offset << kCoeffShift) + (1 << (kCoeffShift - 1));
+  for (uint32_t row = 0; row < 2; row++) {
+    const int32_t *r = rgb[row][0];
+    const int32_t *g = rgb[row][1];
+    const int32_t *b = rgb[row][2];
+    int32_t *out = y[row];
+    for (uint32_t x = 0; x < width; x++) {
+      int32_t value = coeffs.y[0] * r[x] + coeffs.y[1] * g[x] + coeffs.y[2] * b[x] + y_round;
+      out[x] = Clamp(value >> kCoeffShift, coeffs.y_max);
+    }
+  }
+
+  // Chroma is taken from the sum of each 2x2 block, so it carries two more fraction bits.
+  const int32_t c_shift = kCoeffShift + 2;
+  const int32_t c_round = (coeffs.c_offset << c_shift) + (1 << (c_shift - 1));
+  const int32_t *r0 = rgb[0][0], *g0 = rgb[0][1], *b0 = rgb[0][2];
+  const int32_t *r1 = rgb[1][0], *g1 = rgb[1][1], *b1 = rgb[1][2];
+  for (uint32_t i = 0; i < width / 2; i++) {
+    int32_t r = r0[2 * i] + r0[2 * i + 1] + r1[2 * i] + r1[2 * i + 1];
+    int32_t g = g0[2 * i] + g0[2 * i + 1] + g1[2 * i] + g1[2 * i + 1];
+    int32_t b = b0[2 * i] + b0[2 * i + 1] + b1[2 * i] + b1[2 * i + 1];
+    int32_t cb = coeffs.u[0] * r + coeffs.u[1] * g + coeffs.u[2] * b + c_round;
+    int32_t cr = coeffs.v[0] * r + coeffs.v[1] * g + coeffs.v[2] * b + c_round;
+    u[i] = Clamp(cb >> c_shift, coeffs.y_max);
+    v[i] = Clamp(cr >> c_shift, coeffs.y_max);
+  }
+}
+
+void CPUColorConvertImpl::YUVToRGBRow(const YUVToRGBCoeffs &coeffs, const int32_t *y,
+                                      const int32_t *u, const int32_t *v, uint32_t width,
+                                      int32_t *rgb[3]) {
+  const int32_t round = 1 << (kCoeffShift - 1);
+  int32_t *r = rgb[0];
+  int32_t *g = rgb[1];
+  int32_t *b = rgb[2];
+  for (uint32_t x = 0; x < width; x++) {
+    int32_t luma = coeffs.y * (y[x] - coeffs.y_offset) + round;
+    int32_t cb = u[x] - coeffs.c_offset;
+    int32_t cr = v[x] - coeffs.c_offset;
+    r[x] = Clamp((luma + coeffs.r_v * cr) >> kCoeffShift, coeffs.rgb_max);
+    g[x] = Clamp((luma - coeffs.g_u * cb - coeffs.g_v * cr) >> kCoeffShift, coeffs.rgb_max);
+    b[x] = Clamp((luma + coeffs.b_u * cb) >> kCoeffShift, coeffs.rgb_max);
+  }
+}
+
+static void UnpackRGBRow(const uint8_t *row, uint32_t bits, const uint32_t *x_map,
+                         uint32_t width, int32_t *const rgb[3]) {
+  if (bits == 8) {
+    for (uint32_t x = 0; x < width; x++) {
+      const uint8_t *pixel = row + (x_map[x] * 4);
+      rgb[0][x] = pixel[0];
+      rgb[1][x] = pixel[1];
+      rgb[2][x] = pixel[2];
+    }
+    return;
+  }
+
+  for (uint32_t x = 0; x < width; x++) {
+    uint32_t word = 0;
+    memcpy(&word, row + (x_map[x] * 4), sizeof(word));
+    rgb[0][x] = INT32(word & 0x3FF);
+    rgb[1][x] = INT32((word >> 10) & 0x3FF);
+    rgb[2][x] = INT32((word >> 20) & 0x3FF);
+  }
+}
+
+static void PackRGBRow(int32_t *const rgb[3], uint32_t bits, uint32_t width, uint8_t *row) {
+  uint32_t shift = (bits == 8) ? 8 : 10;
+  uint32_t alpha = (bits == 8) ? (0xFFU << 24) : (0x3U << 30);
+  for (uint32_t x = 0; x < width; x++) {
+    uint32_t word = UINT32(rgb[0][x]) | (UINT32(rgb[1][x]) << shift) |
+                    (UINT32(rgb[2][x]) << (2 * shift)) | alpha;
+    memcpy(row + (x * 4), &word, sizeof(word));
+  }
+}
+
+// P010 keeps the 10 bits in the upper part of each 16 bit sample.
+static void PackPlaneRow(const int32_t *samples, uint32_t bits, uint32_t count, uint8_t *row) {
+  if (bits == 8) {
+    for (uint32_t i = 0; i < count; i++) {
+      row[i] = UINT8(samples[i]);
+    }
+  } else {
+    uint16_t *row16 = reinterpret_cast<uint16_t *>(row);
+    for (uint32_t i = 0; i < count; i++) {
+      row16[i] = UINT16(samples[i] << 6);
+    }
+  }
+}
+
+// Gathers the luma and the chroma pair each destination pixel samples, chroma is replicated.
+static void UnpackYUVRow(const uint8_t *luma, const uint8_t *chroma, uint32_t bits,
+                         uint32_t u_index, const uint32_t *x_map, uint32_t width, int32_t *y,
+                         int32_t *u, int32_t *v) {
+  if (bits == 8) {
+    for (uint32_t x = 0; x < width; x++) {
+      uint32_t src_x = x_map[x];
+      const uint8_t *pair = chroma + (src_x & ~1U);
+      y[x] = luma[src_x];
+      u[x] = pair[u_index];
+      v[x] = pair[1 - u_index];
+    }
+    return;
+  }
+
+  const uint16_t *luma16 = reinterpret_cast<const uint16_t *>(luma);
+  const uint16_t *chroma16 = reinterpret_cast<const uint16_t *>(chroma);
+  for (uint32_t x = 0; x < width; x++) {
+    uint32_t src_x = x_map[x];
+    const uint16_t *pair = chroma16 + (src_x & ~1U);
+    y[x] = luma16[src_x] >> 6;
+    u[x] = pair[u_index] >> 6;
+    v[x] = pair[1 - u_index] >> 6;
+  }
+}
+
+// Clips dst_rect to the buffer. YUV destinations start on an even pixel so that chroma pairs
+// are not split.
+static bool GetDestinationArea(const GLRect &dst_rect, const CPUBuffer &dst, bool yuv,
+                               uint32_t *x, uint32_t *y, uint32_t *width, uint32_t *height) {
+  int32_t left = std::max(INT32(dst_rect.left), 0);
+  int32_t top = std::max(INT32(dst_rect.top), 0);
+  int32_t right = std::min(INT32(dst_rect.right), INT32(dst.width));
+  int32_t bottom = std::min(INT32(dst_rect.bottom), INT32(dst.height));
+  if (yuv) {
+    left &= ~1;
+    top &= ~1;
+  }
+  if (right <= left || bottom <= top) {
+    return false;
+  }
+
+  *x = UINT32(left);
+  *y = UINT32(top);
+  *width = UINT32(right - left);
+  *height = UINT32(bottom - top);
+
+  return true;
+}
+
+int CPUColorConvertImpl::ConvertRGBToYUV(const CPUBuffer &src, const CPUBuffer &dst,
+                                         const GLRect &dst_rect) {
+  uint32_t rgb_bits = 0, yuv_bits = 0;
+  bool swap_uv = false;
+  GetRGBFormat(src.format, &rgb_bits);
+  GetYUVFormat(dst.format, &yuv_bits, &swap_uv);
+
+  uint32_t x0 = 0, y0 = 0, width = 0, height = 0;
+  if (!GetDestinationArea(dst_rect, dst, true, &x0, &y0, &width, &height) || !src.width ||
+      !src.height) {
+    return 0;
+  }
+
+  RGBToYUVCoeffs coeffs;
+  GetRGBToYUVCoeffs(csc_, rgb_bits, yuv_bits, &coeffs);
+
+  uint32_t even_width = ALIGN(width, 2U);
+  std::vector<uint32_t> x_map, y_map;
+  GetSampleMap(src.width, width, even_width, &x_map);
+  GetSampleMap(src.height, height, height, &y_map);
+
+  uint32_t sample_size = (yuv_bits == 8) ? 1 : 2;
+  uint8_t *luma = dst.base + dst.offset[0] + (y0 * dst.stride[0]) + (x0 * sample_size);
+  uint8_t *chroma = dst.base + dst.offset[1] + ((y0 / 2) * dst.stride[1]) + (x0 * sample_size);
+
+  auto convert = [&](uint32_t begin, uint32_t end) {
+    std::vector<int32_t> scratch(even_width * 9);
+    int32_t *planes[9] = {};
+    for (uint32_t i = 0; i < 9; i++) {
+      planes[i] = scratch.data() + (i * even_width);
+    }
+    int32_t *const rgb[2][3] = {{planes[0], planes[1], planes[2]},
+                                {planes[3], planes[4], planes[5]}};
+    int32_t *y[2] = {planes[6], planes[7]};
+    int32_t *u = planes[8];
+    int32_t *v = planes[8] + (even_width / 2);
+    std::vector<int32_t> uv(even_width);
+
+    for (uint32_t pair = begin; pair < end; pair++) {
+      uint32_t row = pair * 2;
+      bool has_second_row = (row + 1) < height;
+      for (uint32_t i = 0; i < 2; i++) {
+        uint32_t src_row = y_map[has_second_row ? (row + i) : row];
+        UnpackRGBRow(src.base + src.offset[0] + (src_row * src.stride[0]), rgb_bits,
+                     x_map.data(), even_width, rgb[i]);
+      }
+
+      RGBToYUVRows(coeffs, rgb, even_width, y, u, v);
+
+      PackPlaneRow(y[0], yuv_bits, width, luma + (row * dst.stride[0]));
+      if (has_second_row) {
+        PackPlaneRow(y[1], yuv_bits, width, luma + ((row + 1) * dst.stride[0]));
+      }
+
+      const int32_t *first = swap_uv ? v : u;
+      const int32_t *second = swap_uv ? u : v;
+      for (uint32_t i = 0; i < even_width / 2; i++) {
+        uv[2 * i] = first[i];
+        uv[2 * i + 1] = second[i];
+      }
+      PackPlaneRow(uv.data(), yuv_bits, even_width, chroma + (pair * dst.stride[1]));
+    }
+  };
+
+  ParallelFor((height + 1) / 2, convert);
+
+  return 0;
+}
+
+int CPUColorConvertImpl::ConvertYUVToRGB(const CPUBuffer &src, const CPUBuffer &dst,
+                                         const GLRect &dst_rect) {
+  uint32_t rgb_bits = 0, yuv_bits = 0;
+  bool swap_uv = false;
+  GetRGBFormat(dst.format, &rgb_bits);
+  GetYUVFormat(src.format, &yuv_bits, &swap_uv);
+
+  uint32_t x0 = 0, y0 = 0, width = 0, height = 0;
+  if (!GetDestinationArea(dst_rect, dst, false, &x0, &y0, &width, &height) || !src.width ||
+      !src.height) {
+    return 0;
+  }
+
+  YUVToRGBCoeffs coeffs;
+  GetYUVToRGBCoeffs(csc_, yuv_bits, rgb_bits, &coeffs);
+
+  std::vector<uint32_t> x_map, y_map;
+  GetSampleMap(src.width, width, width, &x_map);
+  GetSampleMap(src.height, height, height, &y_map);
+
+  uint32_t u_index = swap_uv ? 1 : 0;
+  uint8_t *out = dst.base + dst.offset[0] + (y0 * dst.stride[0]) + (x0 * 4);
+
+  auto convert = [&](uint32_t begin, uint32_t end) {
+    std::vector<int32_t> scratch(width * 6);
+    int32_t *y = scratch.data();
+    int32_t *u = y + width;
+    int32_t *v = u + width;
+    int32_t *rgb[3] = {v + width, v + (2 * width), v + (3 * width)};
+
+    for (uint32_t row = begin; row < end; row++) {
+      uint32_t src_row = y_map[row];
+      const uint8_t *luma = src.base + src.offset[0] + (src_row * src.stride[0]);
+      const uint8_t *chroma = src.base + src.offset[1] + ((src_row / 2) * src.stride[1]);
+      UnpackYUVRow(luma, chroma, yuv_bits, u_index, x_map.data(), width, y, u, v);
+      YUVToRGBRow(coeffs, y, u, v, width, rgb);
+      PackRGBRow(rgb, rgb_bits, width, out + (row * dst.stride[0]));
+    }
+  };
+
+  ParallelFor(height, convert);
+
+  return 0;
+}
+
+int CPUColorConvertImpl::Blit(const native_handle_t *src_hnd, const native_handle_t *dst_hnd,
+                              const GLRect &src_rect, const GLRect &dst_rect,
+                              const shared_ptr<Fence> &src_acquire_fence,
+                              const shared_ptr<Fence> &dst_acquire_fence,
+                              shared_ptr<Fence> *release_fence) {
+  DTRACE_SCOPED();
+  *release_fence = nullptr;
+
+  CPUBuffer src = {};
+  CPUBuffer dst = {};
+  int status = MapBuffer(src_hnd, &src);
+  if (!status) {
+    status = MapBuffer(dst_hnd, &dst);
+  }
+
+  uint32_t bits = 0;
+  bool swap_uv = false;
+  bool to_yuv = GetRGBFormat(src.format, &bits) && GetYUVFormat(dst.format, &bits, &swap_uv);
+  bool to_rgb = GetYUVFormat(src.format, &bits, &swap_uv) && GetRGBFormat(dst.format, &bits);
+  if (!status && !(to_yuv && target_ == kTargetYUV) && !(to_rgb && target_ == kTargetRGBA)) {
+    status = -ENOTSUP;
+  }
+  if (status) {
+    if (!unsupported_logged_) {
+      DLOGE("Cannot convert format 0x%x to 0x%x. Error = %d", src.format, dst.format, status);
+      unsupported_logged_ = true;
+    }
+    return status;
+  }
+
+  std::vector<shared_ptr<Fence>> in_fence = {Fence::Merge(src_acquire_fence, dst_acquire_fence)};
+  WaitOnInputFence(in_fence);
+
+  BeginAccess(src, false);
+  BeginAccess(dst, true);
+  status = to_yuv ? ConvertRGBToYUV(src, dst, dst_rect) : ConvertYUVToRGB(src, dst, dst_rect);
+  EndAccess(dst, true);
+  EndAccess(src, false);
+
+  // The destination is complete on return, so there is no release fence.
+  return status;
+}
+
+int CPUColorConvertImpl::Init() {
+  return InitWorkers(0);
+}
+
+int CPUColorConvertImpl::Deinit() {
+  DeinitWorkers();
+  ClearCache();
+
+  return 0;
+}
+
+CPUColorConvertImpl::~CPUColorConvertImpl() {}
+
+CPUColorConvertImpl::CPUColorConvertImpl(GLRenderTarget target, const ColorConvertCSC &csc) {
+  target_ = target;
+  csc_ = csc;
+}
+
+void CPUColorConvertImpl::Reset() {
+  ClearCache();
+  unsupported_logged_ = false;
+}
+
+}  // namespace sdm
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __CPU_COLOR_CONVERT_IMPL_H__
+#define __CPU_COLOR_CONVERT_IMPL_H__
+
+#include <vector>
+
+#include "cpu_common.h"
+#include "gl_color_convert.h"
+
+namespace sdm {
+
+// Converts between RGBA8888/RGBX8888/RGBA1010102 and NV12/NV21/P010 on the CPU, in either
+// direction. As with the GL engine the whole source is scaled into dst_rect, the scaling is
+// nearest neighbour. Rows are converted in parallel on the CPUCommon workers.
+class CPUColorConvertImpl : public GLColorConvert, public CPUCommon {
+ public:
+  // Fixed point conversion coefficients, in 1 << kCoeffShift units.
+  static const int32_t kCoeffShift = 16;
+
+  struct RGBToYUVCoeffs {
+    int32_t y[3] = {};
+    int32_t u[3] = {};
+    int32_t v[3] = {};
+    int32_t y_offset = 0;
+    int32_t c_offset = 0;
+    int32_t y_max = 0;
+  };
+
+  struct YUVToRGBCoeffs {
+    int32_t y = 0;
+    int32_t r_v = 0;
+    int32_t g_u = 0;
+    int32_t g_v = 0;
+    int32_t b_u = 0;
+    int32_t y_offset = 0;
+    int32_t c_offset = 0;
+    int32_t rgb_max = 0;
+  };
+
+  CPUColorConvertImpl(GLRenderTarget target, const ColorConvertCSC &csc);
+  virtual ~CPUColorConvertImpl();
+  virtual int Blit(const native_handle_t *src_hnd, const native_handle_t *dst_hnd,
+                   const GLRect &src_rect, const GLRect &dst_rect,
+                   const shared_ptr<Fence> &src_acquire_fence,
+                   const shared_ptr<Fence> &dst_acquire_fence, shared_ptr<Fence> *release_fence);
+  virtual int Init();
+  virtual int Deinit();
+  virtual void Reset();
+
+  static void GetRGBToYUVCoeffs(const ColorConvertCSC &csc, uint32_t rgb_bits, uint32_t yuv_bits,
+                                RGBToYUVCoeffs *coeffs);
+  static void GetYUVToRGBCoeffs(const ColorConvertCSC &csc, uint32_t yuv_bits, uint32_t rgb_bits,
+                                YUVToRGBCoeffs *coeffs);
+  // Row kernels on planar components, kept free of format details so that they vectorize.
+  // Converts two RGB rows of an even width into two luma rows and one row of chroma pairs.
+  static void RGBToYUVRows(const RGBToYUVCoeffs &coeffs, const int32_t *const rgb[2][3],
+                           uint32_t width, int32_t *y[2], int32_t *u, int32_t *v);
+  static void YUVToRGBRow(const YUVToRGBCoeffs &coeffs, const int32_t *y, const int32_t *u,
+                          const int32_t *v, uint32_t width, int32_t *rgb[3]);
+
+ private:
+  int ConvertRGBToYUV(const CPUBuffer &src, const CPUBuffer &dst, const GLRect &dst_rect);
+  int ConvertYUVToRGB(const CPUBuffer &src, const CPUBuffer &dst, const GLRect &dst_rect);
+
+  GLRenderTarget target_ = kTargetRGBA;
+  ColorConvertCSC csc_ = {};
+  bool unsupported_logged_ = false;
+};
+
+}  // namespace sdm
+
+#endif  // __CPU_COLOR_CONVERT_IMPL_H__
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <linux/dma-buf.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+
+#include <algorithm>
+
+#include "cpu_common.h"
+#include "gr_utils.h"
+#include "gralloc_priv.h"
+#include "hwc_debugger.h"
+
+#define __CLASS__ "CPUCommon"
+
+namespace sdm {
+
+const uint32_t CPUCommon::kMaxCachedMappings;
+
+int CPUCommon::MapBuffer(const native_handle_t *hnd, CPUBuffer *buffer) {
+  if (!hnd || private_handle_t::validate(hnd) != 0) {
+    return -EINVAL;
+  }
+
+  private_handle_t *handle = const_cast<private_handle_t *>(
+                             static_cast<const private_handle_t *>(hnd));
+  if (handle->flags & private_handle_t::PRIV_FLAGS_UBWC_ALIGNED) {
+    return -ENOTSUP;
+  }
+
+  auto it = mappings_.find(handle->id);
+  if (it != mappings_.end()) {
+    it->second.last_use = ++use_count_;
+    *buffer = it->second.buffer;
+    return 0;
+  }
+
+  Mapping mapping = {};
+  CPUBuffer &mapped = mapping.buffer;
+  if (gralloc::GetBufferLayout(handle, mapped.stride, mapped.offset, &mapped.num_planes) != 0) {
+    return -EINVAL;
+  }
+
+  mapping.size = handle->size + handle->offset;
+  mapping.addr = mmap(NULL, mapping.size, PROT_READ | PROT_WRITE, MAP_SHARED, handle->fd, 0);
+  if (mapping.addr == MAP_FAILED) {
+    DLOGE("mmap of buffer %" PRIu64 " failed. err = %d", handle->id, errno);
+    return -errno;
+  }
+
+  mapped.base = reinterpret_cast<uint8_t *>(mapping.addr) + handle->offset;
+  mapped.fd = handle->fd;
+  mapped.format = handle->format;
+  mapped.width = UINT32(handle->unaligned_width);
+  mapped.height = UINT32(handle->unaligned_height);
+  mapping.last_use = ++use_count_;
+
+  if (mappings_.size() >= max_cached_mappings_) {
+    auto lru = std::min_element(mappings_.begin(), mappings_.end(),
+                                [](const auto &a, const auto &b) {
+                                  return a.second.last_use < b.second.last_use;
+                                });
+    munmap(lru->second.addr, lru->second.size);
+    mappings_.erase(lru);
+  }
+
+  *buffer = mapped;
+  mappings_[handle->id] = mapping;
+
+  return 0;
+}
+
+void CPUCommon::BeginAccess(const CPUBuffer &buffer, bool write) {
+  struct dma_buf_sync sync = {};
+  sync.flags = DMA_BUF_SYNC_START | (write ? DMA_BUF_SYNC_RW : DMA_BUF_SYNC_READ);
+  if (ioctl(buffer.fd, DMA_BUF_IOCTL_SYNC, &sync) != 0) {
+    DLOGV_IF(kTagClient, "dma-buf sync start failed. err = %d", errno);
+  }
+}
+
+void CPUCommon::EndAccess(const CPUBuffer &buffer, bool write) {
+  struct dma_buf_sync sync = {};
+  sync.flags = DMA_BUF_SYNC_END | (write ? DMA_BUF_SYNC_RW : DMA_BUF_SYNC_READ);
+  if (ioctl(buffer.fd, DMA_BUF_IOCTL_SYNC, &sync) != 0) {
+    DLOGV_IF(kTagClient, "dma-buf sync end failed. err = %d", errno);
+  }
+}
+
+int CPUCommon::WaitOnInputFence(const std::vector<shared_ptr<Fence>> &in_fences) {
+  DTRACE_SCOPED();
+
+  shared_ptr<Fence> in_fence = Fence::Merge(in_fences, true /* ignore signaled*/);
+  if (in_fence == nullptr) {
+    return 0;
+  }
+
+  int status = Fence::Wait(in_fence);
+  if (status != 0) {
+    DLOGE("Failed to wait on input fence %s", Fence::GetStr(in_fence).c_str());
+  }
+
+  return status;
+}
+
+void CPUCommon::ClearCache() {
+  for (auto &mapping : mappings_) {
+    munmap(mapping.second.addr, mapping.second.size);
+  }
+  mappings_.clear();
+}
+
+int CPUCommon::InitWorkers(uint32_t num_threads) {
+  if (!num_threads) {
+    int value = 0;
+    HWCDebugHandler::Get()->GetProperty(CPU_BLIT_THREADS_PROP, &value);
+    num_threads = (value > 0) ? UINT32(value) : kDefaultWorkers;
+  }
+
+  std::lock_guard<std::mutex> lock(worker_lock_);
+  exit_workers_ = false;
+  for (uint32_t i = 0; i < num_threads; i++) {
+    workers_.push_back(std::thread(&CPUCommon::WorkerThread, this, i + 1, job_generation_));
+  }
+
+  return 0;
+}
+
+void CPUCommon::DeinitWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(worker_lock_);
+    exit_workers_ = true;
+    work_cv_.notify_all();
+  }
+
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+}
+
+void CPUCommon::ParallelFor(uint32_t count, const std::function<void(uint32_t, uint32_t)> &job) {
+  uint32_t slices = UINT32(workers_.size()) + 1;
+  if (slices == 1 || count < slices) {
+    job(0, count);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(worker_lock_);
+    job_ = &job;
+    job_count_ = count;
+    job_generation_++;
+    pending_workers_ = slices - 1;
+    work_cv_.notify_all();
+  }
+
+  // The calling thread takes the first range.
+  job(0, count / slices);
+
+  std::unique_lock<std::mutex> lock(worker_lock_);
+  done_cv_.wait(lock, [this] { return pending_workers_ == 0; });
+  job_ = nullptr;
+}
+
+void CPUCommon::GetSampleMap(uint32_t src_size, uint32_t count, uint32_t padded_count,
+                             std::vector<uint32_t> *map) {
+  map->resize(padded_count);
+  for (uint32_t i = 0; i < padded_count; i++) {
+    uint32_t dst = std::min(i, count - 1);
+    (*map)[i] = UINT32(((2 * UINT64(dst) + 1) * src_size) / (2 * UINT64(count)));
+  }
+}
+
+void CPUCommon::WorkerThread(uint32_t index, uint64_t generation) {
+  prctl(PR_SET_NAME, "HWC_CPUBlit", 0, 0, 0);
+
+  std::unique_lock<std::mutex> lock(worker_lock_);
+  while (true) {
+    work_cv_.wait(lock, [this, generation] {
+      return exit_workers_ || job_generation_ != generation;
+    });
+    if (exit_workers_) {
+      break;
+    }
+
+    generation = job_generation_;
+    const std::function<void(uint32_t, uint32_t)> *job = job_;
+    uint64_t count = job_count_;
+    uint64_t slices = workers_.size() + 1;
+    lock.unlock();
+    (*job)(UINT32(count * index / slices), UINT32(count * (index + 1) / slices));
+    lock.lock();
+
+    if (--pending_workers_ == 0) {
+      done_cv_.notify_one();
+    }
+  }
+}
+
+}  // namespace sdm
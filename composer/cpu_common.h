@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __CPU_COMMON_H__
+#define __CPU_COMMON_H__
+
+#include <utils/fence.h>
+#include <condition_variable>  // NOLINT
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gl_common.h"
+
+namespace sdm {
+
+// CPU view of a gralloc buffer. Plane strides and offsets are in bytes from base.
+struct CPUBuffer {
+  uint8_t *base = nullptr;
+  int fd = -1;
+  int format = 0;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t stride[4] = {};
+  uint32_t offset[4] = {};
+  uint32_t num_planes = 0;
+};
+
+// Counterpart of GLCommon for the CPU engines. Linear buffers only, UBWC buffers are rejected.
+class CPUCommon {
+ public:
+  // Mappings are cached by buffer id and stay valid until ClearCache.
+  virtual int MapBuffer(const native_handle_t *hnd, CPUBuffer *buffer);
+  // Brackets CPU access to a mapped buffer for the dma-buf cache maintenance.
+  virtual void BeginAccess(const CPUBuffer &buffer, bool write);
+  virtual void EndAccess(const CPUBuffer &buffer, bool write);
+  virtual int WaitOnInputFence(const std::vector<shared_ptr<Fence>> &in_fences);
+  virtual void ClearCache();
+  // Starts num_threads helper threads, zero picks the count from CPU_BLIT_THREADS_PROP.
+  virtual int InitWorkers(uint32_t num_threads);
+  virtual void DeinitWorkers();
+  // Splits [0, count) into one contiguous range per worker and the calling thread and returns
+  // once job has run on all of them.
+  virtual void ParallelFor(uint32_t count, const std::function<void(uint32_t, uint32_t)> &job);
+  // Source index sampled by each of count destination positions, at the pixel centers. Entries
+  // past count up to padded_count repeat the last one.
+  static void GetSampleMap(uint32_t src_size, uint32_t count, uint32_t padded_count,
+                           std::vector<uint32_t> *map);
+
+ protected:
+  // Upper bound on the buffers a single blit can keep mapped at the same time.
+  static const uint32_t kMaxCachedMappings = 8;
+
+  virtual ~CPUCommon() { }
+
+  // Engines that cycle through more buffers than that raise it to keep them mapped.
+  uint32_t max_cached_mappings_ = kMaxCachedMappings;
+
+ private:
+  static const uint32_t kDefaultWorkers = 3;
+
+  struct Mapping {
+    void *addr = nullptr;
+    size_t size = 0;
+    uint64_t last_use = 0;
+    CPUBuffer buffer;
+  };
+
+  // generation is the last job the worker must not run, workers can be restarted after jobs.
+  void WorkerThread(uint32_t index, uint64_t generation);
+
+  std::map<uint64_t, Mapping> mappings_;
+  uint64_t use_count_ = 0;
+
+  std::mutex worker_lock_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  std::vector<std::thread> workers_;
+  const std::function<void(uint32_t, uint32_t)> *job_ = nullptr;
+  uint32_t job_count_ = 0;
+  uint64_t job_generation_ = 0;
+  uint32_t pending_workers_ = 0;
+  bool exit_workers_ = false;
+};
+
+}  // namespace sdm
+
+#endif  // __CPU_COMMON_H__
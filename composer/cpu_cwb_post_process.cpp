@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "cpu_cwb_post_process.h"
+#include "gralloc_priv.h"
+
+#define __CLASS__ "CPUCwbPostProcess"
+
+namespace sdm {
+
+const uint32_t CPUCwbPostProcess::kMaxDownscale;
+
+static bool IsRGBFormat(int format) {
+  return (format == HAL_PIXEL_FORMAT_RGBA_8888) || (format == HAL_PIXEL_FORMAT_RGBX_8888);
+}
+
+static bool GetYUVFormat(int format, bool *swap_uv) {
+  switch (format) {
+    case HAL_PIXEL_FORMAT_YCbCr_420_SP:
+    case HAL_PIXEL_FORMAT_YCbCr_420_SP_VENUS:
+    case HAL_PIXEL_FORMAT_NV12_ENCODEABLE:
+      *swap_uv = false;
+      return true;
+    case HAL_PIXEL_FORMAT_YCrCb_420_SP:
+    case HAL_PIXEL_FORMAT_YCrCb_420_SP_VENUS:
+      *swap_uv = true;
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool CPUCwbPostProcess::IsValidFactor(uint32_t factor) {
+  return (factor == 1) || (factor == 2) || (factor == 4);
+}
+
+bool CPUCwbPostProcess::GetOutputArea(const GLRect &roi, uint32_t width, uint32_t height,
+                                      uint32_t factor, GLRect *area, uint32_t *out_width,
+                                      uint32_t *out_height) {
+  // An empty roi stands for the whole source.
+  int32_t left = 0, top = 0, right = INT32(width), bottom = INT32(height);
+  if (roi.right > roi.left && roi.bottom > roi.top) {
+    left = std::max(INT32(floorf(roi.left)), 0);
+    top = std::max(INT32(floorf(roi.top)), 0);
+    right = std::min(INT32(ceilf(roi.right)), INT32(width));
+    bottom = std::min(INT32(ceilf(roi.bottom)), INT32(height));
+  }
+  if (!IsValidFactor(factor) || right <= left || bottom <= top) {
+    return false;
+  }
+
+  *out_width = UINT32(right - left) / factor;
+  *out_height = UINT32(bottom - top) / factor;
+  if (!*out_width || !*out_height) {
+    return false;
+  }
+
+  area->left = FLOAT(left);
+  area->top = FLOAT(top);
+  area->right = FLOAT(left + INT32(*out_width * factor));
+  area->bottom = FLOAT(top + INT32(*out_height * factor));
+
+  return true;
+}
+
+bool CPUCwbPostProcess::IsValidOutput(const native_handle_t *hnd, bool yuv, uint32_t width,
+                                      uint32_t height) {
+  if (!hnd || private_handle_t::validate(hnd) != 0) {
+    return false;
+  }
+
+  const private_handle_t *handle = static_cast<const private_handle_t *>(hnd);
+  bool swap_uv = false;
+  bool format_ok = yuv ? GetYUVFormat(handle->format, &swap_uv) : IsRGBFormat(handle->format);
+
+  return format_ok && !(handle->flags & private_handle_t::PRIV_FLAGS_UBWC_ALIGNED) &&
+         (UINT32(handle->unaligned_width) >= width) && (UINT32(handle->unaligned_height) >= height);
+}
+
+// The block size is a template argument so that the inner loops have constant trip counts.
+// Both passes work on all four components at once: the vertical one adds whole rows as bytes,
+// the horizontal one adds pixels as four 16 bit lanes of a 64 bit word. 16 * 255 fits a lane.
+template <uint32_t factor>
+static void BoxFilter(const uint8_t *const *rows, uint32_t width, uint16_t *acc, uint32_t *out) {
+  const uint32_t count = width * factor * 4;
+  const uint8_t *row = rows[0];
+  for (uint32_t i = 0; i < count; i++) {
+    acc[i] = row[i];
+  }
+  for (uint32_t k = 1; k < factor; k++) {
+    row = rows[k];
+    for (uint32_t i = 0; i < count; i++) {
+      acc[i] = UINT16(acc[i] + row[i]);
+    }
+  }
+
+  const uint32_t shift = (factor == 4) ? 4 : 2;
+  const uint64_t round = 0x0001000100010001ULL << (shift - 1);
+  for (uint32_t x = 0; x < width; x++) {
+    uint64_t sum = round;
+    for (uint32_t k = 0; k < factor; k++) {
+      uint64_t pixel = 0;
+      memcpy(&pixel, acc + (4 * ((x * factor) + k)), sizeof(pixel));
+      sum += pixel;
+    }
+    // Average of each lane, then the lanes back to bytes.
+    sum = (sum >> shift) & 0x00FF00FF00FF00FFULL;
+    sum = (sum | (sum >> 8)) & 0x0000FFFF0000FFFFULL;
+    out[x] = UINT32(sum | (sum >> 16));
+  }
+}
+
+void CPUCwbPostProcess::BoxFilterRows(const uint8_t *const *rows, uint32_t factor, uint32_t width,
+                                      uint16_t *acc, uint32_t *out) {
+  switch (factor) {
+    case 2:
+      BoxFilter<2>(rows, width, acc, out);
+      break;
+    case 4:
+      BoxFilter<4>(rows, width, acc, out);
+      break;
+    default:
+      memcpy(out, rows[0], width * 4);
+      break;
+  }
+}
+
+static void UnpackRGBRow(const uint32_t *pixels, uint32_t width, int32_t *const rgb[3]) {
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(pixels);
+  for (uint32_t x = 0; x < width; x++) {
+    rgb[0][x] = bytes[4 * x];
+    rgb[1][x] = bytes[4 * x + 1];
+    rgb[2][x] = bytes[4 * x + 2];
+  }
+}
+
+int CPUCwbPostProcess::ProcessRGB(const CPUBuffer &src, const CPUBuffer &dst, const GLRect &area,
+                                  uint32_t factor, uint32_t width, uint32_t height) {
+  const uint8_t *in = src.base + src.offset[0] + (UINT32(area.top) * src.stride[0]) +
+                      (UINT32(area.left) * 4);
+  uint8_t *out = dst.base + dst.offset[0];
+
+  if (factor == 1) {
+    // Plain crop.
+    ParallelFor(height, [&](uint32_t begin, uint32_t end) {
+      for (uint32_t row = begin; row < end; row++) {
+        memcpy(out + (row * dst.stride[0]), in + (row * src.stride[0]), width * 4);
+      }
+    });
+    return 0;
+  }
+
+  auto process = [&](uint32_t begin, uint32_t end) {
+    std::vector<uint16_t> acc(width * factor * 4);
+    const uint8_t *rows[kMaxDownscale] = {};
+
+    for (uint32_t row = begin; row < end; row++) {
+      for (uint32_t i = 0; i < factor; i++) {
+        rows[i] = in + (((row * factor) + i) * src.stride[0]);
+      }
+      // Rows of a linear 32bpp buffer are word aligned.
+      BoxFilterRows(rows, factor, width, acc.data(),
+                    reinterpret_cast<uint32_t *>(out + (row * dst.stride[0])));
+    }
+  };
+
+  ParallelFor(height, process);
+
+  return 0;
+}
+
+int CPUCwbPostProcess::ProcessYUV(const CPUBuffer &src, const CPUBuffer &dst, const GLRect &area,
+                                  uint32_t factor, uint32_t width, uint32_t height) {
+  bool swap_uv = false;
+  GetYUVFormat(dst.format, &swap_uv);
+
+  CPUColorConvertImpl::RGBToYUVCoeffs coeffs;
+  CPUColorConvertImpl::GetRGBToYUVCoeffs(csc_, 8, 8, &coeffs);
+
+  const uint8_t *in = src.base + src.offset[0] + (UINT32(area.top) * src.stride[0]) +
+                      (UINT32(area.left) * 4);
+  uint8_t *luma = dst.base + dst.offset[0];
+  uint8_t *chroma = dst.base + dst.offset[1];
+  // Odd sizes repeat the last column and row into the chroma blocks.
+  uint32_t even_width = ALIGN(width, 2U);
+
+  auto process = [&](uint32_t begin, uint32_t end) {
+    std::vector<uint16_t> acc(width * factor * 4);
+    std::vector<uint32_t> pixels(even_width);
+    std::vector<int32_t> scratch(even_width * 9);
+    int32_t *planes[9] = {};
+    for (uint32_t i = 0; i < 9; i++) {
+      planes[i] = scratch.data() + (i * even_width);
+    }
+    int32_t *const rgb[2][3] = {{planes[0], planes[1], planes[2]},
+                                {planes[3], planes[4], planes[5]}};
+    int32_t *y[2] = {planes[6], planes[7]};
+    int32_t *u = planes[8];
+    int32_t *v = planes[8] + (even_width / 2);
+    const uint8_t *rows[kMaxDownscale] = {};
+
+    for (uint32_t pair = begin; pair < end; pair++) {
+      uint32_t row = pair * 2;
+      bool has_second_row = (row + 1) < height;
+      for (uint32_t i = 0; i < 2; i++) {
+        uint32_t out_row = has_second_row ? (row + i) : row;
+        for (uint32_t k = 0; k < factor; k++) {
+          rows[k] = in + (((out_row * factor) + k) * src.stride[0]);
+        }
+        BoxFilterRows(rows, factor, width, acc.data(), pixels.data());
+        pixels[even_width - 1] = pixels[width - 1];
+        UnpackRGBRow(pixels.data(), even_width, rgb[i]);
+      }
+
+      CPUColorConvertImpl::RGBToYUVRows(coeffs, rgb, even_width, y, u, v);
+
+      for (uint32_t i = 0; i < (has_second_row ? 2U : 1U); i++) {
+        uint8_t *out = luma + ((row + i) * dst.stride[0]);
+        for (uint32_t x = 0; x < width; x++) {
+          out[x] = UINT8(y[i][x]);
+        }
+      }
+
+      const int32_t *first = swap_uv ? v : u;
+      const int32_t *second = swap_uv ? u : v;
+      uint8_t *out = chroma + (pair * dst.stride[1]);
+      for (uint32_t i = 0; i < even_width / 2; i++) {
+        out[2 * i] = UINT8(first[i]);
+        out[2 * i + 1] = UINT8(second[i]);
+      }
+    }
+  };
+
+  ParallelFor((height + 1) / 2, process);
+
+  return 0;
+}
+
+int CPUCwbPostProcess::Process(const native_handle_t *src_hnd, const native_handle_t *dst_hnd,
+                               const GLRect &roi, uint32_t factor) {
+  DTRACE_SCOPED();
+
+  CPUBuffer src = {};
+  CPUBuffer dst = {};
+  int status = MapBuffer(src_hnd, &src);
+  if (!status) {
+    status = MapBuffer(dst_hnd, &dst);
+  }
+
+  bool swap_uv = false;
+  bool yuv = GetYUVFormat(dst.format, &swap_uv);
+  if (!status && (!IsRGBFormat(src.format) || (!yuv && !IsRGBFormat(dst.format)))) {
+    status = -ENOTSUP;
+  }
+
+  GLRect area = {};
+  uint32_t width = 0, height = 0;
+  if (!status && (!GetOutputArea(roi, src.width, src.height, factor, &area, &width, &height) ||
+                  width > dst.width || height > dst.height)) {
+    status = -EINVAL;
+  }
+
+  if (status) {
+    if (!unsupported_logged_) {
+      DLOGE("Cannot process format 0x%x %ux%u into format 0x%x %ux%u, factor %u. Error = %d",
+            src.format, src.width, src.height, dst.format, dst.width, dst.height, factor, status);
+      unsupported_logged_ = true;
+    }
+    return status;
+  }
+
+  BeginAccess(src, false);
+  BeginAccess(dst, true);
+  if (yuv) {
+    status = ProcessYUV(src, dst, area, factor, width, height);
+  } else {
+    status = ProcessRGB(src, dst, area, factor, width, height);
+  }
+  EndAccess(dst, true);
+  EndAccess(src, false);
+
+  return status;
+}
+
+int CPUCwbPostProcess::Init() {
+  return InitWorkers(0);
+}
+
+int CPUCwbPostProcess::Deinit() {
+  DeinitWorkers();
+  ClearCache();
+
+  return 0;
+}
+
+CPUCwbPostProcess::~CPUCwbPostProcess() {}
+
+CPUCwbPostProcess::CPUCwbPostProcess(uint32_t max_buffers, const ColorConvertCSC &csc) {
+  max_cached_mappings_ = std::max(max_buffers, kMaxCachedMappings);
+  csc_ = csc;
+}
+
+}  // namespace sdm
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __CPU_CWB_POST_PROCESS_H__
+#define __CPU_CWB_POST_PROCESS_H__
+
+#include <vector>
+
+#include "cpu_color_convert_impl.h"
+#include "cpu_common.h"
+
+namespace sdm {
+
+// Turns a full frame RGBA8888/RGBX8888 writeback buffer into a compact client frame: the ROI is
+// cropped out, downscaled by 1, 2 or 4 in both directions by averaging each factor x factor
+// block and written to the top left of an RGBA8888/RGBX8888 or NV12/NV21 buffer. Rows are
+// processed in parallel on the CPUCommon workers.
+class CPUCwbPostProcess : public CPUCommon {
+ public:
+  static const uint32_t kMaxDownscale = 4;
+
+  // max_buffers is the number of distinct buffers the caller cycles through.
+  CPUCwbPostProcess(uint32_t max_buffers, const ColorConvertCSC &csc);
+  virtual ~CPUCwbPostProcess();
+  int Init();
+  int Deinit();
+  // Blocks until dst holds the processed roi of src, the buffers must be idle.
+  int Process(const native_handle_t *src_hnd, const native_handle_t *dst_hnd, const GLRect &roi,
+              uint32_t factor);
+
+  // Clips roi to a width x height source and trims it to whole blocks. Returns false if no block
+  // is left, the output is then *out_width x *out_height.
+  static bool GetOutputArea(const GLRect &roi, uint32_t width, uint32_t height, uint32_t factor,
+                            GLRect *area, uint32_t *out_width, uint32_t *out_height);
+  static bool IsValidFactor(uint32_t factor);
+  // Whether hnd can take a width x height output, yuv selects NV12/NV21 over RGBA/RGBX.
+  static bool IsValidOutput(const native_handle_t *hnd, bool yuv, uint32_t width,
+                            uint32_t height);
+  // Row kernel: averages the factor x factor blocks of factor RGBA8888 rows, each starting at
+  // the first pixel of the crop, into width RGBA8888 pixels. acc is scratch for the vertical
+  // sums, 4 * width * factor samples.
+  static void BoxFilterRows(const uint8_t *const *rows, uint32_t factor, uint32_t width,
+                            uint16_t *acc, uint32_t *out);
+
+ private:
+  int ProcessRGB(const CPUBuffer &src, const CPUBuffer &dst, const GLRect &area, uint32_t factor,
+                 uint32_t width, uint32_t height);
+  int ProcessYUV(const CPUBuffer &src, const CPUBuffer &dst, const GLRect &area, uint32_t factor,
+                 uint32_t width, uint32_t height);
+
+  ColorConvertCSC csc_ = {};
+  bool unsupported_logged_ = false;
+};
+
+}  // namespace sdm
+
+#endif  // __CPU_CWB_POST_PROCESS_H__
@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "cpu_layer_stitch_impl.h"
+#include "gr_utils.h"
+
+#define __CLASS__ "CPULayerStitchImpl"
+
+namespace sdm {
+
+typedef CPULayerStitchImpl::StitchRect StitchRect;
+typedef CPULayerStitchImpl::StitchOp StitchOp;
+
+static const uint32_t kPixelSize = 4;
+
+// Same test as GLLayerStitchImpl, an invalid scissor rect disables the scissor.
+static bool IsValid(const GLRect &rect) {
+  return ((rect.right - rect.left) && (rect.bottom - rect.top));
+}
+
+// glViewport and glScissor take integers, the rect is truncated the same way.
+static StitchRect ToStitchRect(const GLRect &rect) {
+  StitchRect out;
+  out.left = INT32(rect.left);
+  out.top = INT32(rect.top);
+  out.right = INT32(rect.right);
+  out.bottom = INT32(rect.bottom);
+
+  return out;
+}
+
+static bool IsEmpty(const StitchRect &rect) {
+  return (rect.right <= rect.left) || (rect.bottom <= rect.top);
+}
+
+static StitchRect Intersect(const StitchRect &a, const StitchRect &b) {
+  StitchRect out;
+  out.left = std::max(a.left, b.left);
+  out.top = std::max(a.top, b.top);
+  out.right = std::min(a.right, b.right);
+  out.bottom = std::min(a.bottom, b.bottom);
+
+  return out;
+}
+
+// Extends last by op when both cover a rect together and, for copies, read one contiguous
+// source rect.
+static bool MergeOp(const StitchOp &op, StitchOp *last) {
+  if (op.type != last->type || op.type == CPULayerStitchImpl::kOpScale) {
+    return false;
+  }
+  bool copy = (op.type == CPULayerStitchImpl::kOpCopy);
+  if (copy && op.src_index != last->src_index) {
+    return false;
+  }
+
+  const StitchRect &a = last->rect;
+  const StitchRect &b = op.rect;
+  if (a.top == b.top && a.bottom == b.bottom && a.right == b.left &&
+      (!copy || (op.src_y == last->src_y && op.src_x - last->src_x == b.left - a.left))) {
+    last->rect.right = b.right;
+    return true;
+  }
+  if (a.left == b.left && a.right == b.right && a.bottom == b.top &&
+      (!copy || (op.src_x == last->src_x && op.src_y - last->src_y == b.top - a.top))) {
+    last->rect.bottom = b.bottom;
+    return true;
+  }
+
+  return false;
+}
+
+static void AddOp(const StitchOp &op, std::vector<StitchOp> *ops) {
+  if (IsEmpty(op.rect)) {
+    return;
+  }
+  if (!ops->empty() && MergeOp(op, &ops->back())) {
+    return;
+  }
+
+  ops->push_back(op);
+}
+
+static void AddClear(int32_t left, int32_t top, int32_t right, int32_t bottom,
+                     std::vector<StitchOp> *ops) {
+  StitchOp op;
+  op.type = CPULayerStitchImpl::kOpClear;
+  op.rect.left = left;
+  op.rect.top = top;
+  op.rect.right = right;
+  op.rect.bottom = bottom;
+  AddOp(op, ops);
+}
+
+void CPULayerStitchImpl::PlanStitch(const std::vector<StitchLayer> &layers, uint32_t width,
+                                    uint32_t height, std::vector<StitchOp> *ops) {
+  ops->clear();
+
+  StitchRect target;
+  target.right = INT32(width);
+  target.bottom = INT32(height);
+
+  for (auto &layer : layers) {
+    bool scissor = IsValid(layer.scissor_rect);
+    StitchRect clip = scissor ? Intersect(ToStitchRect(layer.scissor_rect), target) : target;
+    StitchRect dst = ToStitchRect(layer.dst_rect);
+    StitchRect draw = Intersect(dst, clip);
+    if (!layer.src_width || !layer.src_height || IsEmpty(draw)) {
+      draw = {};
+    }
+
+    if (scissor && !IsEmpty(clip)) {
+      // Only the part of the scissor rect that the draw leaves alone needs the clear.
+      if (IsEmpty(draw)) {
+        AddClear(clip.left, clip.top, clip.right, clip.bottom, ops);
+      } else {
+        AddClear(clip.left, clip.top, clip.right, draw.top, ops);
+        AddClear(clip.left, draw.top, draw.left, draw.bottom, ops);
+        AddClear(draw.right, draw.top, clip.right, draw.bottom, ops);
+        AddClear(clip.left, draw.bottom, clip.right, clip.bottom, ops);
+      }
+    }
+
+    if (IsEmpty(draw)) {
+      continue;
+    }
+
+    StitchOp op;
+    op.rect = draw;
+    op.src_index = layer.src_index;
+    if (UINT32(dst.right - dst.left) == layer.src_width &&
+        UINT32(dst.bottom - dst.top) == layer.src_height) {
+      op.type = kOpCopy;
+      op.src_x = draw.left - dst.left;
+      op.src_y = draw.top - dst.top;
+    } else {
+      op.type = kOpScale;
+      op.scale_rect = dst;
+      op.src_width = layer.src_width;
+      op.src_height = layer.src_height;
+    }
+    AddOp(op, ops);
+  }
+}
+
+void CPULayerStitchImpl::RunStitchOps(const std::vector<StitchOp> &ops,
+                                      const std::vector<CPUBuffer> &srcs, const CPUBuffer &dst,
+                                      uint32_t row_begin, uint32_t row_end) {
+  std::vector<uint32_t> x_map;
+  uint32_t dst_stride = dst.stride[0];
+
+  for (auto &op : ops) {
+    uint32_t top = std::max(UINT32(op.rect.top), row_begin);
+    uint32_t bottom = std::min(UINT32(op.rect.bottom), row_end);
+    if (top >= bottom) {
+      continue;
+    }
+
+    uint32_t rows = bottom - top;
+    uint32_t width = UINT32(op.rect.right - op.rect.left);
+    uint32_t row_size = width * kPixelSize;
+    uint8_t *out = dst.base + dst.offset[0] + (top * dst_stride) + (op.rect.left * kPixelSize);
+
+    if (op.type == kOpClear) {
+      // Rows spanning the whole stride are one run.
+      if (row_size == dst_stride) {
+        memset(out, 0, rows * row_size);
+        continue;
+      }
+      for (uint32_t i = 0; i < rows; i++, out += dst_stride) {
+        memset(out, 0, row_size);
+      }
+      continue;
+    }
+
+    const CPUBuffer &src = srcs[op.src_index];
+    uint32_t src_stride = src.stride[0];
+    if (op.type == kOpCopy) {
+      const uint8_t *in = src.base + src.offset[0] +
+                          ((op.src_y + (top - op.rect.top)) * src_stride) +
+                          (op.src_x * kPixelSize);
+      if (row_size == dst_stride && row_size == src_stride) {
+        memcpy(out, in, rows * row_size);
+        continue;
+      }
+      for (uint32_t i = 0; i < rows; i++, out += dst_stride, in += src_stride) {
+        memcpy(out, in, row_size);
+      }
+      continue;
+    }
+
+    // Sample positions are relative to the unclipped scale rect, as the GL viewport is.
+    uint32_t scale_width = UINT32(op.scale_rect.right - op.scale_rect.left);
+    uint32_t scale_height = UINT32(op.scale_rect.bottom - op.scale_rect.top);
+    uint32_t x_skip = UINT32(op.rect.left - op.scale_rect.left);
+    GetSampleMap(op.src_width, scale_width, scale_width, &x_map);
+    const uint32_t *columns = x_map.data() + x_skip;
+    for (uint32_t row = top; row < bottom; row++, out += dst_stride) {
+      uint64_t dy = UINT64(INT32(row) - op.scale_rect.top);
+      uint32_t src_row = UINT32(((2 * dy + 1) * op.src_height) / (2 * UINT64(scale_height)));
+      const uint32_t *in = reinterpret_cast<const uint32_t *>(src.base + src.offset[0] +
+                                                              (src_row * src_stride));
+      uint32_t *pixels = reinterpret_cast<uint32_t *>(out);
+      for (uint32_t x = 0; x < width; x++) {
+        pixels[x] = in[columns[x]];
+      }
+    }
+  }
+}
+
+int CPULayerStitchImpl::Stitch(const std::vector<StitchParams> &stitch_params, size_t begin,
+                               size_t end) {
+  CPUBuffer dst = {};
+  int status = MapBuffer(stitch_params[begin].dst_hnd, &dst);
+  if (!status && gralloc::GetBppForUncompressedRGB(dst.format) != kPixelSize) {
+    status = -ENOTSUP;
+  }
+  if (status) {
+    if (!unsupported_logged_) {
+      DLOGE("Cannot stitch into format 0x%x. Error = %d", dst.format, status);
+      unsupported_logged_ = true;
+    }
+    return status;
+  }
+
+  // Buffers stay mapped for the whole group, so they must all fit in the mapping cache.
+  std::vector<const native_handle_t *> handles;
+  std::vector<CPUBuffer> srcs;
+  std::vector<StitchLayer> layers;
+  for (size_t i = begin; i < end; i++) {
+    const StitchParams &info = stitch_params[i];
+    StitchLayer layer;
+    layer.dst_rect = info.dst_rect;
+    layer.scissor_rect = info.scissor_rect;
+
+    auto it = std::find(handles.begin(), handles.end(), info.src_hnd);
+    if (it == handles.end() && handles.size() + 1 < kMaxCachedMappings) {
+      CPUBuffer src = {};
+      int error = MapBuffer(info.src_hnd, &src);
+      if (!error && src.format != dst.format) {
+        error = -ENOTSUP;
+      }
+      if (error) {
+        if (!unsupported_logged_) {
+          DLOGE("Cannot stitch format 0x%x into 0x%x. Error = %d", src.format, dst.format, error);
+          unsupported_logged_ = true;
+        }
+        status = error;
+      }
+      handles.push_back(info.src_hnd);
+      srcs.push_back(error ? CPUBuffer() : src);
+      it = handles.end() - 1;
+    } else if (it == handles.end()) {
+      DLOGE("Too many stitch sources, layer %zu is not drawn", i);
+      status = -E2BIG;
+    }
+
+    // Layers without a usable source still clear their scissor rect, just as GL would.
+    if (it != handles.end()) {
+      layer.src_index = UINT32(it - handles.begin());
+      layer.src_width = srcs[layer.src_index].width;
+      layer.src_height = srcs[layer.src_index].height;
+    }
+    layers.push_back(layer);
+  }
+
+  std::vector<StitchOp> ops;
+  PlanStitch(layers, dst.width, dst.height, &ops);
+  if (ops.empty()) {
+    return status;
+  }
+
+  uint32_t row_begin = dst.height;
+  uint32_t row_end = 0;
+  for (auto &op : ops) {
+    row_begin = std::min(row_begin, UINT32(op.rect.top));
+    row_end = std::max(row_end, UINT32(op.rect.bottom));
+  }
+
+  for (auto &src : srcs) {
+    if (src.base) {
+      BeginAccess(src, false);
+    }
+  }
+  BeginAccess(dst, true);
+
+  // The target is split into bands of rows, each band runs all ops in order.
+  ParallelFor(row_end - row_begin, [&](uint32_t band_begin, uint32_t band_end) {
+    RunStitchOps(ops, srcs, dst, row_begin + band_begin, row_begin + band_end);
+  });
+
+  EndAccess(dst, true);
+  for (auto &src : srcs) {
+    if (src.base) {
+      EndAccess(src, false);
+    }
+  }
+
+  return status;
+}
+
+int CPULayerStitchImpl::Blit(const std::vector<StitchParams> &stitch_params,
+                             shared_ptr<Fence> *release_fence) {
+  DTRACE_SCOPED();
+  *release_fence = nullptr;
+
+  std::vector<shared_ptr<Fence>> acquire_fences;
+  for (auto &info : stitch_params) {
+    acquire_fences.push_back(info.src_acquire_fence);
+    acquire_fences.push_back(info.dst_acquire_fence);
+  }
+  WaitOnInputFence(acquire_fences);
+
+  // Consecutive params with the same target are planned together.
+  int status = 0;
+  size_t begin = 0;
+  while (begin < stitch_params.size()) {
+    size_t end = begin + 1;
+    while (end < stitch_params.size() &&
+           stitch_params[end].dst_hnd == stitch_params[begin].dst_hnd) {
+      end++;
+    }
+
+    int error = Stitch(stitch_params, begin, end);
+    status = status ? status : error;
+    begin = end;
+  }
+
+  // The target is complete on return, so there is no release fence.
+  return status;
+}
+
+int CPULayerStitchImpl::Init() {
+  return InitWorkers(0);
+}
+
+int CPULayerStitchImpl::Deinit() {
+  DeinitWorkers();
+  ClearCache();
+
+  return 0;
+}
+
+CPULayerStitchImpl::~CPULayerStitchImpl() {}
+
+CPULayerStitchImpl::CPULayerStitchImpl() {}
+
+}  // namespace sdm
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __CPU_LAYER_STITCH_IMPL_H__
+#define __CPU_LAYER_STITCH_IMPL_H__
+
+#include <vector>
+
+#include "cpu_common.h"
+#include "gl_layer_stitch.h"
+
+namespace sdm {
+
+// Stitches 32bpp layers into a stitch target of the same format on the CPU. Each StitchParams
+// is rendered like GLLayerStitchImpl does it: the scissor rect is cleared to transparent black,
+// then the whole source is scaled into dst_rect, clipped to the scissor rect if it is valid.
+// Scaling is nearest neighbour, equal sizes are plain copies.
+class CPULayerStitchImpl : public GLLayerStitch, public CPUCommon {
+ public:
+  // Integer rect in pixels, right and bottom are exclusive.
+  struct StitchRect {
+    int32_t left = 0;
+    int32_t top = 0;
+    int32_t right = 0;
+    int32_t bottom = 0;
+  };
+
+  // One StitchParams reduced to what the planner needs.
+  struct StitchLayer {
+    GLRect dst_rect;
+    GLRect scissor_rect;
+    uint32_t src_index = 0;
+    uint32_t src_width = 0;
+    uint32_t src_height = 0;
+  };
+
+  enum StitchOpType {
+    kOpClear,
+    kOpCopy,
+    kOpScale,
+  };
+
+  // Fills rect of the target. kOpCopy reads the source from (src_x, src_y) onwards, kOpScale
+  // samples the whole source scaled to scale_rect, of which rect is the visible part.
+  struct StitchOp {
+    StitchOpType type = kOpClear;
+    StitchRect rect;
+    uint32_t src_index = 0;
+    int32_t src_x = 0;
+    int32_t src_y = 0;
+    StitchRect scale_rect;
+    uint32_t src_width = 0;
+    uint32_t src_height = 0;
+  };
+
+  CPULayerStitchImpl();
+  virtual ~CPULayerStitchImpl();
+  virtual int Blit(const std::vector<StitchParams> &stitch_params,
+                   shared_ptr<Fence> *release_fence);
+  virtual int Init();
+  virtual int Deinit();
+
+  // Turns layers drawn in order into ops on a width x height target. Ops are clipped to the
+  // target, clears are trimmed by the draw of their own layer and adjacent ops that read
+  // contiguous memory are merged. Ops still have to run in order since they may overlap.
+  static void PlanStitch(const std::vector<StitchLayer> &layers, uint32_t width, uint32_t height,
+                         std::vector<StitchOp> *ops);
+  // Runs ops on the target rows [row_begin, row_end). Rows are independent, so disjoint row
+  // ranges can run concurrently.
+  static void RunStitchOps(const std::vector<StitchOp> &ops, const std::vector<CPUBuffer> &srcs,
+                           const CPUBuffer &dst, uint32_t row_begin, uint32_t row_end);
+
+ private:
+  int Stitch(const std::vector<StitchParams> &stitch_params, size_t begin, size_t end);
+
+  bool unsupported_logged_ = false;
+};
+
+}  // namespace sdm
+
+#endif  // __CPU_LAYER_STITCH_IMPL_H__
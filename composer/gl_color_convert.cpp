@@ -27,6 +27,7 @@
  * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "cpu_color_convert_impl.h"
 #include "gl_color_convert_impl.h"
 #include "gl_color_convert.h"
 
@@ -34,8 +35,20 @@
 
 namespace sdm {
 
-GLColorConvert* GLColorConvert::GetInstance(GLRenderTarget target, bool secure) {
-  GLColorConvertImpl* color_convert = new GLColorConvertImpl(target, secure);
+GLColorConvert* GLColorConvert::GetInstance(GLRenderTarget target, bool secure,
+                                            ColorConvertEngine engine,
+                                            const ColorConvertCSC &csc) {
+  GLColorConvert* color_convert = nullptr;
+  if (engine == kEngineCPU) {
+    if (secure) {
+      DLOGE("CPU color convert cannot access secure buffers");
+      return nullptr;
+    }
+    color_convert = new CPUColorConvertImpl(target, csc);
+  } else {
+    color_convert = new GLColorConvertImpl(target, secure);
+  }
+
   if (color_convert == nullptr) {
     DLOGE("Failed to create color convert instance for %d target %d secure", target, secure);
     return nullptr;
@@ -48,18 +61,17 @@ GLColorConvert* GLColorConvert::GetInstance(GLRenderTarget target, bool secure)
     return nullptr;
   }
 
-  DLOGI("Created instance successfully");
+  DLOGI("Created %s instance successfully", (engine == kEngineCPU) ? "CPU" : "GL");
 
   return color_convert;
 }
 
 void GLColorConvert::Destroy(GLColorConvert* intf) {
-  GLColorConvertImpl* color_convert = static_cast<GLColorConvertImpl*>(intf);
-  if (color_convert->Deinit() != 0) {
+  if (intf->Deinit() != 0) {
     DLOGE("De Init failed");
   }
 
-  delete color_convert;
+  delete intf;
 }
 
 }  // namespace sdm
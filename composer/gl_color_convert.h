@@ -30,6 +30,8 @@
 #ifndef __GL_COLOR_CONVERT_H__
 #define __GL_COLOR_CONVERT_H__
 
+#include <color_metadata.h>
+
 #include "gl_common.h"
 
 namespace sdm {
@@ -39,9 +41,23 @@ enum GLRenderTarget {
   kTargetYUV,
 };
 
+enum ColorConvertEngine {
+  kEngineGL,
+  kEngineCPU,  // Linear non secure buffers only
+};
+
+// Matrix and range of the YUV side. Only the CPU engine takes it, GL converts with BT.601
+// limited range.
+struct ColorConvertCSC {
+  ColorPrimaries primaries = ColorPrimaries_BT601_6_525;
+  ColorRange range = Range_Limited;
+};
+
 class GLColorConvert {
  public:
-  static GLColorConvert* GetInstance(GLRenderTarget target, bool secure);
+  static GLColorConvert* GetInstance(GLRenderTarget target, bool secure,
+                                     ColorConvertEngine engine = kEngineGL,
+                                     const ColorConvertCSC &csc = ColorConvertCSC());
   static void Destroy(GLColorConvert* intf);
 
   virtual int Blit(const native_handle_t *src_hnd, const native_handle_t *dst_hnd,
@@ -51,6 +67,8 @@ class GLColorConvert {
                    shared_ptr<Fence> *release_fence) = 0;
   virtual void Reset() = 0;
  protected:
+  virtual int Init() = 0;
+  virtual int Deinit() = 0;
   virtual ~GLColorConvert() { }
 };
 
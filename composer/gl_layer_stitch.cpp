@@ -27,6 +27,7 @@
  * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "cpu_layer_stitch_impl.h"
 #include "gl_layer_stitch_impl.h"
 #include "gl_layer_stitch.h"
 
@@ -34,8 +35,18 @@
 
 namespace sdm {
 
-GLLayerStitch* GLLayerStitch::GetInstance(bool secure) {
-  GLLayerStitchImpl *layer_stitch = new GLLayerStitchImpl(secure);
+GLLayerStitch* GLLayerStitch::GetInstance(bool secure, LayerStitchEngine engine) {
+  GLLayerStitch *layer_stitch = nullptr;
+  if (engine == kStitchEngineCPU) {
+    if (secure) {
+      DLOGE("CPU layer stitch cannot access secure buffers");
+      return nullptr;
+    }
+    layer_stitch = new CPULayerStitchImpl();
+  } else {
+    layer_stitch = new GLLayerStitchImpl(secure);
+  }
+
   if (layer_stitch == nullptr) {
     DLOGE("Failed to create layer stitch instance. secure: %d", secure);
     return nullptr;
@@ -48,18 +59,17 @@ GLLayerStitch* GLLayerStitch::GetInstance(bool secure) {
     return nullptr;
   }
 
-  DLOGI("Created instance successfully");
+  DLOGI("Created %s instance successfully", (engine == kStitchEngineCPU) ? "CPU" : "GL");
 
   return layer_stitch;
 }
 
 void GLLayerStitch::Destroy(GLLayerStitch *intf) {
-  GLLayerStitchImpl *layer_stitch = static_cast<GLLayerStitchImpl *>(intf);
-  if (layer_stitch->Deinit() != 0) {
+  if (intf->Deinit() != 0) {
     DLOGE("De Init failed");
   }
 
-  delete layer_stitch;
+  delete intf;
 }
 
 }  // namespace sdm
@@ -44,14 +44,21 @@ struct StitchParams {
   shared_ptr<Fence> dst_acquire_fence = nullptr;
 };
 
+enum LayerStitchEngine {
+  kStitchEngineGL,
+  kStitchEngineCPU,  // Linear non secure 32bpp buffers only
+};
+
 class GLLayerStitch {
  public:
-  static GLLayerStitch* GetInstance(bool secure);
+  static GLLayerStitch* GetInstance(bool secure, LayerStitchEngine engine = kStitchEngineGL);
   static void Destroy(GLLayerStitch *intf);
   virtual int Blit(const std::vector<StitchParams> &stitch_params,
                    shared_ptr<Fence> *release_fence) = 0;
 
  protected:
+  virtual int Init() = 0;
+  virtual int Deinit() = 0;
   virtual ~GLLayerStitch() { }
 };
 
@@ -735,4 +735,26 @@ int HWCBufferAllocator::UnmapBuffer(const native_handle_t *handle, int *release_
   return err;
 }
 
+const native_handle_t *HWCBufferAllocator::RetainBuffer(const native_handle_t *handle) {
+  auto err = GetGrallocInstance();
+  if (err != 0) {
+    DLOGW("Could not get gralloc instance");
+    return nullptr;
+  }
+
+  // The import dups the fds, so the retained handle outlives the one it was made from.
+  const native_handle_t *retained = nullptr;
+  mapper_->importBuffer(hidl_handle(handle), [&](const auto &_error, const auto &_buffer) {
+    if (_error == Error::NONE) {
+      retained = static_cast<const native_handle_t *>(_buffer);
+    }
+  });
+
+  return retained;
+}
+
+void HWCBufferAllocator::ReleaseBuffer(const native_handle_t *handle) {
+  mapper_->freeBuffer(const_cast<native_handle_t *>(handle));
+}
+
 }  // namespace sdm
@@ -36,6 +36,7 @@
 #include <android/hardware/graphics/mapper/4.0/IMapper.h>
 #include <vendor/qti/hardware/display/mapper/4.0/IQtiMapper.h>
 #include "gralloc_priv.h"
+#include "hwc_frame_dumper.h"
 
 using android::hardware::graphics::allocator::V4_0::IAllocator;
 using android::hardware::graphics::mapper::V4_0::IMapper;
@@ -48,7 +49,7 @@ inline Type ALIGN(Type x, Type align) {
   return (x + align - 1) & ~(align - 1);
 }
 
-class HWCBufferAllocator : public BufferAllocator {
+class HWCBufferAllocator : public BufferAllocator, public FrameDumpBufferOps {
  public:
   int AllocateBuffer(BufferInfo *buffer_info);
   int FreeBuffer(BufferInfo *buffer_info);
@@ -65,6 +66,8 @@ class HWCBufferAllocator : public BufferAllocator {
   int SetBufferInfo(LayerBufferFormat format, int *target, uint64_t *flags);
   int MapBuffer(const native_handle_t *handle, shared_ptr<Fence> acquire_fence, void **base_ptr);
   int UnmapBuffer(const native_handle_t *handle, int *release_fence);
+  const native_handle_t *RetainBuffer(const native_handle_t *handle);
+  void ReleaseBuffer(const native_handle_t *handle);
   int GetHeight(void *buf, uint32_t &height);
   int GetWidth(void *buf, uint32_t &width);
   int GetUnalignedHeight(void *buf, uint32_t &height);
@@ -32,6 +32,7 @@
 #include <utils/constants.h>
 #include <utils/debug.h>
 #include <utils/fence.h>
+#include <algorithm>
 
 #include "hwc_debugger.h"
 #include "hwc_buffer_sync_handler.h"
@@ -107,4 +108,29 @@ void HWCBufferSyncHandler::GetSyncInfo(int fd, std::ostringstream *os) {
   }
 }
 
+int HWCBufferSyncHandler::GetSignalTime(int fd, int64_t *signal_time_ns) {
+  if (fd < 0) {
+    return -EINVAL;
+  }
+
+  struct sync_file_info *file_info = sync_file_info(fd);
+  if (!file_info) {
+    return -errno;
+  }
+
+  int error = -EAGAIN;
+  struct sync_fence_info *fence_info = sync_get_fence_info(file_info);
+  if (file_info->status == 1 && fence_info) {
+    int64_t signal_time = 0;
+    for (size_t i = 0; i < file_info->num_fences; i++) {
+      signal_time = std::max(signal_time, static_cast<int64_t>(fence_info[i].timestamp_ns));
+    }
+    *signal_time_ns = signal_time;
+    error = 0;
+  }
+  sync_file_info_free(file_info);
+
+  return error;
+}
+
 }  // namespace sdm
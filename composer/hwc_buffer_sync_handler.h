@@ -42,6 +42,7 @@ class HWCBufferSyncHandler : public BufferSyncHandler {
   virtual int SyncWait(int fd, int timeout);
   virtual int SyncMerge(int fd1, int fd2, int *merged_fd);
   virtual void GetSyncInfo(int fd, std::ostringstream *os);
+  virtual int GetSignalTime(int fd, int64_t *signal_time_ns);
 
  private:
   HWCBufferSyncHandler();
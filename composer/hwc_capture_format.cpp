@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <stdio.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "hwc_capture_format.h"
+
+namespace sdm {
+
+// Reads the rest of a record whose magic has already been consumed.
+template <class T>
+static bool ReadRecord(FILE *file, uint32_t magic, T *record) {
+  record->magic = magic;
+  uint8_t *rest = reinterpret_cast<uint8_t *>(record) + sizeof(magic);
+  return fread(rest, sizeof(T) - sizeof(magic), 1, file) == 1;
+}
+
+int ReadCapture(const std::string &path, std::vector<CapturedFrame> *frames) {
+  FILE *file = fopen(path.c_str(), "rb");
+  if (!file) {
+    return -errno;
+  }
+
+  CaptureFileHeader file_header;
+  if (fread(&file_header, sizeof(file_header), 1, file) != 1 ||
+      file_header.magic != kCaptureMagic || file_header.version != kCaptureVersion ||
+      file_header.frame_header_size != sizeof(CaptureFrameHeader) ||
+      file_header.handle_size != sizeof(CaptureHandle) ||
+      file_header.layer_event_size != sizeof(CaptureLayerEvent)) {
+    fclose(file);
+    return -EINVAL;
+  }
+
+  int ret = 0;
+  frames->clear();
+  CapturedFrame frame;
+  uint32_t magic = 0;
+  // A capture cut short by a crash ends on a partial record, keep what is complete.
+  while (fread(&magic, sizeof(magic), 1, file) == 1) {
+    if (magic == kCaptureLayerMagic) {
+      CaptureLayerEvent event;
+      if (!ReadRecord(file, magic, &event)) {
+        break;
+      }
+      frame.layer_events.push_back(event);
+      continue;
+    }
+
+    if (magic != kCaptureFrameMagic) {
+      ret = -EINVAL;
+      break;
+    }
+    if (!ReadRecord(file, magic, &frame.header)) {
+      break;
+    }
+    frame.words.resize(frame.header.num_words);
+    frame.handles.resize(frame.header.num_handles);
+    if (fread(frame.words.data(), sizeof(uint32_t), frame.words.size(), file) !=
+        frame.words.size() ||
+        fread(frame.handles.data(), sizeof(CaptureHandle), frame.handles.size(), file) !=
+        frame.handles.size()) {
+      break;
+    }
+    frames->push_back(std::move(frame));
+    frame = CapturedFrame();
+  }
+  fclose(file);
+
+  if (!ret && !frame.layer_events.empty()) {
+    frame.header.num_words = 0;
+    frame.header.num_handles = 0;
+    frame.words.clear();
+    frame.handles.clear();
+    frames->push_back(std::move(frame));
+  }
+
+  return ret;
+}
+
+}  // namespace sdm
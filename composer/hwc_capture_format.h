@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HWC_CAPTURE_FORMAT_H__
+#define __HWC_CAPTURE_FORMAT_H__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace sdm {
+
+// Capture file layout, all fields little endian:
+//   CaptureFileHeader
+//   per executeCommands call: CaptureFrameHeader, num_words command words as read from the
+//   client's message queue, num_handles CaptureHandle entries in command handle order.
+//   per createLayer/destroyLayer call: CaptureLayerEvent.
+// Records are told apart by their leading magic. The format has no Android dependencies so that
+// host tools can read it.
+static const uint32_t kCaptureMagic = 0x52435748;       // "HWCR"
+static const uint32_t kCaptureFrameMagic = 0x454d5246;  // "FRME"
+static const uint32_t kCaptureLayerMagic = 0x5259414c;  // "LAYR"
+static const uint32_t kCaptureVersion = 2;
+
+struct CaptureFileHeader {
+  uint32_t magic = kCaptureMagic;
+  uint32_t version = kCaptureVersion;
+  uint32_t frame_header_size = 0;
+  uint32_t handle_size = 0;
+  uint32_t layer_event_size = 0;
+};
+
+struct CaptureFrameHeader {
+  uint32_t magic = kCaptureFrameMagic;
+  uint32_t api_version = 0;      // executeCommands variant, e.g. 0x202 for executeCommands_2_2
+  uint64_t frame = 0;
+  int64_t timestamp_ns = 0;      // CLOCK_MONOTONIC at the start of the call
+  uint32_t num_words = 0;
+  uint32_t num_handles = 0;
+  uint64_t read_ns = 0;          // message queue read
+  uint64_t parse_ns = 0;         // command parse, i.e. all HWCSession work of the call
+  uint64_t parse_cpu_ns = 0;     // thread CPU time of the parse
+};
+
+enum CaptureHandleType : uint32_t {
+  kCaptureHandleEmpty,
+  kCaptureHandleBuffer,
+  kCaptureHandleFence,
+  kCaptureHandleOther,
+};
+
+struct CaptureHandle {
+  uint32_t type = kCaptureHandleEmpty;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t format = 0;
+  uint64_t usage = 0;
+  uint64_t size = 0;
+  uint64_t id = 0;
+  int64_t signal_ns = -1;        // fence signal time, -1 if pending when recorded
+};
+
+enum CaptureLayerEventType : uint32_t {
+  kCaptureLayerCreate,
+  kCaptureLayerDestroy,
+};
+
+struct CaptureLayerEvent {
+  uint32_t magic = kCaptureLayerMagic;
+  uint32_t type = kCaptureLayerCreate;
+  uint64_t display = 0;
+  uint64_t layer = 0;
+  int64_t timestamp_ns = 0;
+};
+
+struct CapturedFrame {
+  CaptureFrameHeader header;
+  std::vector<uint32_t> words;
+  std::vector<CaptureHandle> handles;
+  std::vector<CaptureLayerEvent> layer_events;  // layer calls made since the previous frame
+};
+
+// Parses a capture file written by HWCCommandRecorder. Layer events after the last frame are
+// returned in a trailing frame without words.
+int ReadCapture(const std::string &path, std::vector<CapturedFrame> *frames);
+
+}  // namespace sdm
+
+#endif  // __HWC_CAPTURE_FORMAT_H__
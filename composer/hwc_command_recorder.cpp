@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <gralloc_priv.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+#include <utils/fence.h>
+#include <utils/worker_pool.h>
+#include <utils/Timers.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "hwc_command_recorder.h"
+#include "hwc_debugger.h"
+
+#define __CLASS__ "HWCCommandRecorder"
+
+namespace sdm {
+
+static std::string CapturePath() {
+  return std::string(HWCDebugHandler::DumpDir()) + "/hwc_command_capture.bin";
+}
+
+template <class T>
+static void Append(std::vector<uint8_t> *record, const T *data, size_t count) {
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+  record->insert(record->end(), bytes, bytes + sizeof(T) * count);
+}
+
+static CaptureHandle DescribeHandle(const native_handle_t *handle) {
+  CaptureHandle entry;
+  if (!handle) {
+    return entry;
+  }
+
+  if (private_handle_t::validate(handle) == 0) {
+    const private_handle_t *hnd = static_cast<const private_handle_t *>(handle);
+    entry.type = kCaptureHandleBuffer;
+    entry.width = UINT32(hnd->unaligned_width);
+    entry.height = UINT32(hnd->unaligned_height);
+    entry.format = UINT32(hnd->format);
+    entry.usage = UINT64(hnd->usage);
+    entry.size = UINT64(hnd->size);
+    entry.id = UINT64(hnd->id);
+  } else if (handle->numFds == 1 && handle->numInts == 0) {
+    entry.type = kCaptureHandleFence;
+    int64_t signal_ns = -1;
+    // The fence object owns the dup, the client keeps its fd.
+    shared_ptr<Fence> fence = Fence::Create(dup(handle->data[0]), "hwc_capture");
+    if (Fence::GetSignalTime(fence, &signal_ns) == 0) {
+      entry.signal_ns = signal_ns;
+    }
+  } else {
+    entry.type = kCaptureHandleOther;
+  }
+
+  return entry;
+}
+
+static int64_t GetThreadCpuTime() {
+  struct timespec ts = {};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (static_cast<int64_t>(ts.tv_sec) * 1000000000LL) + ts.tv_nsec;
+}
+
+HWCCommandRecorder *HWCCommandRecorder::GetInstance() {
+  static HWCCommandRecorder *s_instance = new HWCCommandRecorder();
+  return s_instance;
+}
+
+void HWCCommandRecorder::Configure() {
+  int frames = 0;
+  HWCDebugHandler::Get()->GetProperty(COMMAND_CAPTURE_FRAMES_PROP, &frames);
+  if (frames <= 0) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(lock_);
+  staged_.clear();
+  truncate_ = true;
+  frames_recorded_ = 0;
+  frames_dropped_ = 0;
+  bytes_written_ = 0;
+  remaining_.store(frames, std::memory_order_relaxed);
+  DLOGI("Capturing %d command buffers to %s", frames, CapturePath().c_str());
+}
+
+void HWCCommandRecorder::Record(uint32_t api_version, const uint32_t *words, uint32_t num_words,
+                                const hidl_vec<hidl_handle> &handles, const Timings &timings) {
+  if (remaining_.fetch_sub(1, std::memory_order_relaxed) <= 0) {
+    remaining_.store(0, std::memory_order_relaxed);
+    return;
+  }
+
+  CaptureFrameHeader header;
+  header.api_version = api_version;
+  header.timestamp_ns = timings.start_ns;
+  header.num_words = num_words;
+  header.num_handles = UINT32(handles.size());
+  header.read_ns = timings.read_ns;
+  header.parse_ns = timings.parse_ns;
+  header.parse_cpu_ns = timings.parse_cpu_ns;
+
+  std::vector<uint8_t> record;
+  record.reserve(sizeof(header) + (num_words * sizeof(uint32_t)) +
+                 (handles.size() * sizeof(CaptureHandle)));
+  Append(&record, &header, 1);
+  Append(&record, words, num_words);
+  for (auto &handle : handles) {
+    CaptureHandle entry = DescribeHandle(handle.getNativeHandle());
+    Append(&record, &entry, 1);
+  }
+
+  std::lock_guard<std::mutex> lock(lock_);
+  if (staged_.size() + record.size() > kMaxStagedBytes) {
+    frames_dropped_++;
+    return;
+  }
+
+  // Frame numbers count every recorded call so that replay can spot dropped ones.
+  header.frame = ++frames_recorded_;
+  memcpy(record.data() + offsetof(CaptureFrameHeader, frame), &header.frame, sizeof(header.frame));
+  Stage(record);
+}
+
+void HWCCommandRecorder::RecordLayerEvent(CaptureLayerEventType type, uint64_t display,
+                                          uint64_t layer) {
+  if (!IsActive()) {
+    return;
+  }
+
+  CaptureLayerEvent event;
+  event.type = type;
+  event.display = display;
+  event.layer = layer;
+  event.timestamp_ns = systemTime(SYSTEM_TIME_MONOTONIC);
+  std::vector<uint8_t> record;
+  Append(&record, &event, 1);
+
+  std::lock_guard<std::mutex> lock(lock_);
+  if (staged_.size() + record.size() > kMaxStagedBytes) {
+    return;
+  }
+  Stage(record);
+}
+
+void HWCCommandRecorder::Stage(const std::vector<uint8_t> &record) {
+  staged_.insert(staged_.end(), record.begin(), record.end());
+
+  // One pending writer task drains everything staged up to the time it runs.
+  WorkerPool::GetInstance()->Post(kLaneFrameDump, [this]() { WritePending(); }, kCoalesceWriter);
+}
+
+void HWCCommandRecorder::WritePending() {
+  std::vector<uint8_t> data;
+  bool truncate = false;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    data.swap(staged_);
+    truncate = truncate_;
+    truncate_ = false;
+  }
+
+  if (data.empty()) {
+    return;
+  }
+
+  std::string path = CapturePath();
+  int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : O_APPEND);
+  int fd = open(path.c_str(), flags, 0644);
+  if (fd < 0) {
+    DLOGW("Failed to open %s, errno = %d", path.c_str(), errno);
+    return;
+  }
+
+  if (truncate) {
+    CaptureFileHeader file_header;
+    file_header.frame_header_size = UINT32(sizeof(CaptureFrameHeader));
+    file_header.handle_size = UINT32(sizeof(CaptureHandle));
+    file_header.layer_event_size = UINT32(sizeof(CaptureLayerEvent));
+    std::vector<uint8_t> header;
+    Append(&header, &file_header, 1);
+    data.insert(data.begin(), header.begin(), header.end());
+  }
+
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t ret = write(fd, data.data() + written, data.size() - written);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ret <= 0) {
+      DLOGW("Failed to write %s, errno = %d", path.c_str(), errno);
+      break;
+    }
+    written += size_t(ret);
+  }
+  close(fd);
+
+  std::lock_guard<std::mutex> lock(lock_);
+  bytes_written_ += written;
+}
+
+void HWCCommandRecorder::Dump(std::ostringstream *os) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (!frames_recorded_ && !frames_dropped_) {
+    return;
+  }
+
+  *os << "\n------------Command Capture-----------";
+  *os << "\nrecorded " << frames_recorded_ << ", dropped " << frames_dropped_;
+  *os << ", remaining " << std::max(remaining_.load(std::memory_order_relaxed), 0);
+  *os << ", staged " << staged_.size() << " bytes, written " << bytes_written_ << " bytes";
+  *os << "\n---------------------------------------\n";
+}
+
+HWCCommandCapture::HWCCommandCapture(uint32_t api_version) {
+  if (!HWCCommandRecorder::GetInstance()->IsActive()) {
+    return;
+  }
+
+  active_ = true;
+  api_version_ = api_version;
+  timings_.start_ns = systemTime(SYSTEM_TIME_MONOTONIC);
+}
+
+void HWCCommandCapture::ParseBegin() {
+  if (!active_) {
+    return;
+  }
+
+  parse_start_ns_ = systemTime(SYSTEM_TIME_MONOTONIC);
+  timings_.read_ns = UINT64(parse_start_ns_ - timings_.start_ns);
+  cpu_start_ns_ = GetThreadCpuTime();
+}
+
+void HWCCommandCapture::ParseEnd(const uint32_t *words, uint32_t num_words,
+                                 const hidl_vec<hidl_handle> &handles) {
+  if (!active_) {
+    return;
+  }
+
+  timings_.parse_cpu_ns = UINT64(GetThreadCpuTime() - cpu_start_ns_);
+  timings_.parse_ns = UINT64(systemTime(SYSTEM_TIME_MONOTONIC) - parse_start_ns_);
+  HWCCommandRecorder::GetInstance()->Record(api_version_, words, num_words, handles, timings_);
+}
+
+}  // namespace sdm
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HWC_COMMAND_RECORDER_H__
+#define __HWC_COMMAND_RECORDER_H__
+
+#include <hidl/HidlSupport.h>
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "hwc_capture_format.h"
+
+namespace sdm {
+
+using ::android::hardware::hidl_handle;
+using ::android::hardware::hidl_vec;
+
+// Records the composer command stream of the client for offline replay and profiling. Capture
+// is armed through a property with the number of executeCommands calls to record; the calls are
+// serialized on the binder thread and written to the dump directory on a WorkerPool lane.
+class HWCCommandRecorder {
+ public:
+  // Stage timings of one executeCommands call.
+  struct Timings {
+    int64_t start_ns = 0;
+    uint64_t read_ns = 0;
+    uint64_t parse_ns = 0;
+    uint64_t parse_cpu_ns = 0;
+  };
+
+  static HWCCommandRecorder *GetInstance();
+
+  // Re-reads the capture property when a client connects, a new capture replaces the old file.
+  void Configure();
+  bool IsActive() const { return remaining_.load(std::memory_order_relaxed) > 0; }
+  void Record(uint32_t api_version, const uint32_t *words, uint32_t num_words,
+              const hidl_vec<hidl_handle> &handles, const Timings &timings);
+  // Layers come and go outside of executeCommands, replay needs them to rebuild the layer stacks.
+  void RecordLayerEvent(CaptureLayerEventType type, uint64_t display, uint64_t layer);
+  void Dump(std::ostringstream *os);
+
+ private:
+  HWCCommandRecorder() {}
+  void Stage(const std::vector<uint8_t> &record);  // Called with lock_ held.
+  void WritePending();
+
+  static const size_t kMaxStagedBytes = 8 * 1024 * 1024;
+  // Coalesce key of the writer task on kLaneFrameDump, distinct from the frame dumper's.
+  static const uint64_t kCoalesceWriter = 2;
+
+  std::atomic<int32_t> remaining_ {0};
+  std::mutex lock_;
+  std::vector<uint8_t> staged_;
+  bool truncate_ = false;
+  uint64_t frames_recorded_ = 0;
+  uint64_t frames_dropped_ = 0;
+  uint64_t bytes_written_ = 0;
+};
+
+// Times the stages of one executeCommands call and hands it to the recorder. Does nothing beyond
+// one atomic load unless a capture is active.
+class HWCCommandCapture {
+ public:
+  explicit HWCCommandCapture(uint32_t api_version);
+  void ParseBegin();
+  void ParseEnd(const uint32_t *words, uint32_t num_words, const hidl_vec<hidl_handle> &handles);
+
+ private:
+  bool active_ = false;
+  uint32_t api_version_ = 0;
+  HWCCommandRecorder::Timings timings_;
+  int64_t parse_start_ns_ = 0;
+  int64_t cpu_start_ns_ = 0;
+};
+
+}  // namespace sdm
+
+#endif  // __HWC_COMMAND_RECORDER_H__
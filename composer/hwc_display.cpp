@@ -50,6 +50,8 @@
 
 #include "hwc_display.h"
 #include "hwc_debugger.h"
+#include "hwc_frame_dumper.h"
+#include "hwc_frame_timing.h"
 #include "hwc_tonemapper.h"
 #include "hwc_session.h"
 
@@ -1027,10 +1029,7 @@ HWC2::Error HWCDisplay::SetPowerMode(HWC2::PowerMode mode, bool teardown) {
       HWC2::Error err = SetReadbackBuffer(handle, nullptr, cwb_config_, kCWBClientFrameDump);
       if (err != HWC2::Error::None) {
           dump_output_to_file_ = false;
-          // Unmap and Free buffer
-          if (munmap(output_buffer_base_, output_buffer_info_.alloc_buffer_info.size) != 0) {
-            DLOGW("unmap failed with err %d", errno);
-          }
+          // Free buffer
           if (buffer_allocator_->FreeBuffer(&output_buffer_info_) != 0) {
             DLOGW("FreeBuffer failed");
           }
@@ -1040,7 +1039,6 @@ HWC2::Error HWCDisplay::SetPowerMode(HWC2::PowerMode mode, bool teardown) {
 
           output_buffer_ = {};
           output_buffer_info_ = {};
-          output_buffer_base_ = nullptr;
           if (!dump_input_layers_) {
             dump_frame_count_ = 0;
           }
@@ -1361,6 +1359,8 @@ HWC2::Error HWCDisplay::SetFrameDumpConfig(uint32_t count, uint32_t bit_mask_lay
     tone_mapper_->SetFrameDumpConfig(count);
   }
 
+  HWCFrameDumper::GetInstance()->Configure();
+
   DLOGI("num_frame_dump %d, input_layer_dump_enable %d", dump_frame_count_, dump_input_layers_);
 
   return HWC2::Error::None;
@@ -1414,26 +1414,14 @@ HWC2::Error HWCDisplay::SetFrameDumpConfig(uint32_t count, uint32_t bit_mask_lay
     return HWC2::Error::NoResources;
   }
 
-  void *buffer = mmap(NULL, output_buffer_info_.alloc_buffer_info.size, PROT_READ | PROT_WRITE,
-                      MAP_SHARED, output_buffer_info_.alloc_buffer_info.fd, 0);
-
-  if (buffer == MAP_FAILED) {
-    DLOGE("mmap failed with err %d", errno);
-    buffer_allocator_->FreeBuffer(&output_buffer_info_);
-    output_buffer_info_ = {};
-    return HWC2::Error::NoResources;
-  }
-
   const native_handle_t *handle = static_cast<native_handle_t *>(output_buffer_info_.private_data);
   HWC2::Error err = SetReadbackBuffer(handle, nullptr, cwb_config, kCWBClientFrameDump);
   if (err != HWC2::Error::None) {
-    munmap(output_buffer_base_, output_buffer_info_.alloc_buffer_info.size);
     buffer_allocator_->FreeBuffer(&output_buffer_info_);
     output_buffer_info_ = {};
     return err;
   }
   dump_output_to_file_ = dump_output_to_file;
-  output_buffer_base_ = buffer;
 
   return HWC2::Error::None;
 }
@@ -1522,6 +1510,7 @@ HWC2::Error HWCDisplay::PrepareLayerStack(uint32_t *out_num_types, uint32_t *out
   layer_requests_.clear();
   has_client_composition_ = false;
   display_idle_ = false;
+  frame_timing_.validate_start_ns = systemTime(SYSTEM_TIME_MONOTONIC);
 
   DTRACE_SCOPED();
   if (shutdown_pending_) {
@@ -1529,12 +1518,16 @@ HWC2::Error HWCDisplay::PrepareLayerStack(uint32_t *out_num_types, uint32_t *out
   }
 
   if (CanSkipSdmPrepare(out_num_types, out_num_requests)) {
+    frame_timing_.validate_end_ns = systemTime(SYSTEM_TIME_MONOTONIC);
     return ((*out_num_types > 0) ? HWC2::Error::HasChanges : HWC2::Error::None);
   }
 
   UpdateRefreshRate();
   UpdateActiveConfig();
+  nsecs_t prepare_start = systemTime(SYSTEM_TIME_MONOTONIC);
   DisplayError error = display_intf_->Prepare(&layer_stack_);
+  telemetry_.prepare_us = UINT32((systemTime(SYSTEM_TIME_MONOTONIC) - prepare_start) / 1000);
+  telemetry_.max_prepare_us = std::max(telemetry_.max_prepare_us, telemetry_.prepare_us);
   auto status = HandlePrepareError(error);
   if (status != HWC2::Error::None) {
     return status;
@@ -1604,6 +1597,7 @@ HWC2::Error HWCDisplay::PostPrepareLayerStack(uint32_t *out_num_types, uint32_t
   layer_stack_.client_incompatible = false;
 
   validate_done_ = true;
+  frame_timing_.validate_end_ns = systemTime(SYSTEM_TIME_MONOTONIC);
   return (((*out_num_types > 0) || (has_client_composition_ && *out_num_requests > 0))
           ? HWC2::Error::HasChanges : HWC2::Error::None);
 }
@@ -1845,7 +1839,10 @@ HWC2::Error HWCDisplay::CommitLayerStack(void) {
     }
   }
 
+  nsecs_t commit_start = systemTime(SYSTEM_TIME_MONOTONIC);
   error = display_intf_->Commit(&layer_stack_);
+  telemetry_.commit_us = UINT32((systemTime(SYSTEM_TIME_MONOTONIC) - commit_start) / 1000);
+  telemetry_.max_commit_us = std::max(telemetry_.max_commit_us, telemetry_.commit_us);
 
   if (error == kErrorNone) {
     // A commit is successfully submitted, start flushing on failure now onwards.
@@ -1882,6 +1879,8 @@ HWC2::Error HWCDisplay::PostCommitLayerStack(shared_ptr<Fence> *out_retire_fence
   }
 
   DumpInputBuffers();
+  UpdateTelemetry();
+  UpdateFrameTiming();
 
   RetrieveFences(out_retire_fence);
   client_target_->ResetGeometryChanges();
@@ -2015,7 +2014,6 @@ void HWCDisplay::DumpInputBuffers() {
 
     const native_handle_t *handle =
         reinterpret_cast<const native_handle_t *>(layer->input_buffer.buffer_id);
-    Fence::Wait(layer->input_buffer.acquire_fence);
 
     DLOGI("Dump layer[%d] of %lu handle %p", i, layer_stack_.layers.size(), handle);
 
@@ -2024,16 +2022,7 @@ void HWCDisplay::DumpInputBuffers() {
       continue;
     }
 
-    void *base_ptr = NULL;
-    int error = buffer_allocator_->MapBuffer(handle, nullptr, &base_ptr);
-    if (error != kErrorNone) {
-      DLOGE("Failed to map buffer, error = %d", error);
-      continue;
-    }
-
     char dump_file_name[PATH_MAX];
-    size_t result = 0;
-
     uint32_t width = 0, height = 0, alloc_size = 0;
     int32_t format = 0;
 
@@ -2046,23 +2035,15 @@ void HWCDisplay::DumpInputBuffers() {
              dir_path, i, width, height, qdutils::GetHALPixelFormatString(format),
              dump_frame_index_);
 
-    if (base_ptr != nullptr) {
-      FILE *fp = fopen(dump_file_name, "w+");
-      if (fp) {
-        result = fwrite(base_ptr, alloc_size, 1, fp);
-        fclose(fp);
-      }
-    }
-
-    int release_fence = -1;
-    error = buffer_allocator_->UnmapBuffer(handle, &release_fence);
-    if (error != 0) {
-      DLOGE("Failed to unmap buffer, error = %d", error);
-      continue;
+    // The acquire fence wait, mapping and copy happen on the frame dump writer, which retains
+    // the buffer after it goes back to the client.
+    int error = HWCFrameDumper::GetInstance()->QueueBuffer(dump_file_name, handle, alloc_size,
+                                                           layer->input_buffer.acquire_fence,
+                                                           buffer_allocator_);
+    if (error) {
+      DLOGW("Frame Dump %s not queued, error = %d", dump_file_name, error);
     }
 
-    DLOGI("Frame Dump %s: is %s", dump_file_name, result ? "Successful" : "Failed");
-
     if (layer->composition == kCompositionGPUTarget) {  // Skip dumping the layers that follow
       // follow GPU Target layer in layers list (i.e. stitch layers, noise layer, demura layer).
       break;
@@ -2070,8 +2051,8 @@ void HWCDisplay::DumpInputBuffers() {
   }
 }
 
-void HWCDisplay::DumpOutputBuffer(const BufferInfo &buffer_info, void *base,
-                                  shared_ptr<Fence> &retire_fence) {
+void HWCDisplay::DumpOutputBuffer(const BufferInfo &buffer_info, const native_handle_t *handle,
+                                  const shared_ptr<Fence> &fence) {
   char dir_path[PATH_MAX];
   int  status;
 
@@ -2090,27 +2071,22 @@ void HWCDisplay::DumpOutputBuffer(const BufferInfo &buffer_info, void *base,
     return;
   }
 
-  if (base) {
+  if (handle) {
     char dump_file_name[PATH_MAX];
-    size_t result = 0;
-
-    if (Fence::Wait(retire_fence) != kErrorNone) {
-      DLOGW("sync_wait error errno = %d, desc = %s", errno, strerror(errno));
-      return;
-    }
 
     snprintf(dump_file_name, sizeof(dump_file_name), "%s/output_layer_%dx%d_%s_frame%d.raw",
              dir_path, buffer_info.alloc_buffer_info.aligned_width,
              buffer_info.alloc_buffer_info.aligned_height,
              GetFormatString(buffer_info.buffer_config.format), dump_frame_index_);
 
-    FILE *fp = fopen(dump_file_name, "w+");
-    if (fp) {
-      result = fwrite(base, buffer_info.alloc_buffer_info.size, 1, fp);
-      fclose(fp);
+    // The writer waits for fence and copies the buffer out. A writer that falls a frame behind
+    // reads a reused buffer after the next frame was written to it.
+    int error = HWCFrameDumper::GetInstance()->QueueBuffer(dump_file_name, handle,
+                                                           buffer_info.alloc_buffer_info.size,
+                                                           fence, buffer_allocator_);
+    if (error) {
+      DLOGW("Frame Dump of %s not queued, error = %d", dump_file_name, error);
     }
-
-    DLOGI("Frame Dump of %s is %s", dump_file_name, result ? "Successful" : "Failed");
   }
 }
 
@@ -2577,6 +2553,138 @@ DisplayClass HWCDisplay::GetDisplayClass() {
   return display_class_;
 }
 
+void HWCDisplay::UpdateTelemetry() {
+  nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+  if (telemetry_.last_commit_ns) {
+    int64_t interval = now - telemetry_.last_commit_ns;
+    telemetry_.avg_frame_interval_ns = telemetry_.avg_frame_interval_ns ?
+        (telemetry_.avg_frame_interval_ns * 7 + interval) / 8 : interval;
+  }
+
+  telemetry_.valid = true;
+  telemetry_.sdm_id = sdm_id_;
+  telemetry_.type = type_;
+  telemetry_.power_mode = INT32(current_power_mode_);
+  telemetry_.active_config = active_config_index_;
+  telemetry_.refresh_rate = current_refresh_rate_;
+  telemetry_.frame_count++;
+  telemetry_.last_commit_ns = now;
+  telemetry_.num_layers = UINT32(layer_set_.size());
+  telemetry_.num_device_layers = 0;
+  telemetry_.num_client_layers = 0;
+  telemetry_.num_solid_fill_layers = 0;
+  telemetry_.num_cursor_layers = 0;
+  telemetry_.num_secure_layers = 0;
+  for (auto hwc_layer : layer_set_) {
+    switch (hwc_layer->GetDeviceSelectedCompositionType()) {
+      case HWC2::Composition::Device:
+        telemetry_.num_device_layers++;
+        break;
+      case HWC2::Composition::Client:
+        telemetry_.num_client_layers++;
+        break;
+      case HWC2::Composition::SolidColor:
+        telemetry_.num_solid_fill_layers++;
+        break;
+      case HWC2::Composition::Cursor:
+        telemetry_.num_cursor_layers++;
+        break;
+      default:
+        break;
+    }
+    if (hwc_layer->IsProtected()) {
+      telemetry_.num_secure_layers++;
+    }
+  }
+  telemetry_.client_target_used = has_client_composition_;
+  if (has_client_composition_) {
+    telemetry_.client_composed_frames++;
+  }
+}
+
+void HWCDisplay::GetConfigSnapshot(HWCDisplayConfigSnapshot *snapshot) {
+  *snapshot = HWCDisplayConfigSnapshot();
+
+  uint32_t num_configs = 0;
+  GetDisplayConfigs(&num_configs, nullptr);
+  if (num_configs > HWCDisplayConfigSnapshot::kMaxConfigs) {
+    return;
+  }
+  hwc2_config_t config_ids[HWCDisplayConfigSnapshot::kMaxConfigs] = {};
+  GetDisplayConfigs(&num_configs, config_ids);
+  for (uint32_t i = 0; i < num_configs; i++) {
+    HWCDisplayConfigSnapshot::Config &config = snapshot->configs[i];
+    config.id = config_ids[i];
+    if (GetDisplayAttribute(config.id, HwcAttribute::VSYNC_PERIOD, &config.vsync_period) !=
+        HWC2::Error::None ||
+        GetDisplayAttribute(config.id, HwcAttribute::WIDTH, &config.width) != HWC2::Error::None ||
+        GetDisplayAttribute(config.id, HwcAttribute::HEIGHT, &config.height) != HWC2::Error::None ||
+        GetDisplayAttribute(config.id, HwcAttribute::DPI_X, &config.dpi_x) != HWC2::Error::None ||
+        GetDisplayAttribute(config.id, HwcAttribute::DPI_Y, &config.dpi_y) != HWC2::Error::None ||
+        GetDisplayAttribute(config.id, HwcAttribute::CONFIG_GROUP, &config.config_group) !=
+        HWC2::Error::None) {
+      return;
+    }
+  }
+  snapshot->num_configs = num_configs;
+
+  if (GetActiveConfig(&snapshot->active_config) != HWC2::Error::None) {
+    return;
+  }
+
+  uint32_t num_modes = 0;
+  GetColorModes(&num_modes, nullptr);
+  if (num_modes > HWCDisplayConfigSnapshot::kMaxColorModes) {
+    return;
+  }
+  ColorMode modes[HWCDisplayConfigSnapshot::kMaxColorModes] = {};
+  GetColorModes(&num_modes, modes);
+  for (uint32_t i = 0; i < num_modes; i++) {
+    HWCDisplayConfigSnapshot::ColorModeIntents &color_mode = snapshot->color_modes[i];
+    color_mode.mode = modes[i];
+    if (GetRenderIntents(color_mode.mode, &color_mode.num_intents, nullptr) != HWC2::Error::None ||
+        color_mode.num_intents > HWCDisplayConfigSnapshot::kMaxRenderIntents ||
+        GetRenderIntents(color_mode.mode, &color_mode.num_intents, color_mode.intents) !=
+        HWC2::Error::None) {
+      return;
+    }
+  }
+  snapshot->num_color_modes = num_modes;
+
+  // GetHdrCapabilities reports luminance only along with the types.
+  uint32_t num_types = 0;
+  if (GetHdrCapabilities(&num_types, nullptr, &snapshot->max_luminance,
+                         &snapshot->max_average_luminance, &snapshot->min_luminance) !=
+      HWC2::Error::None || num_types > HWCDisplayConfigSnapshot::kMaxHdrTypes) {
+    return;
+  }
+  if (num_types && GetHdrCapabilities(&num_types, snapshot->hdr_types, &snapshot->max_luminance,
+                                      &snapshot->max_average_luminance,
+                                      &snapshot->min_luminance) != HWC2::Error::None) {
+    return;
+  }
+  snapshot->num_hdr_types = num_types;
+
+  snapshot->valid = true;
+}
+
+void HWCDisplay::UpdateFrameTiming() {
+  HWCFrameTimingRing *ring = HWCFrameTimingRing::Get(id_);
+  if (!ring) {
+    return;
+  }
+
+  frame_timing_.strategy_us = layer_stack_.timings.strategy_us;
+  frame_timing_.hw_commit_us = layer_stack_.timings.hw_commit_us;
+  frame_timing_.fence_wait_us = layer_stack_.timings.fence_wait_us;
+  frame_timing_.vsync_period_ns = current_refresh_rate_ ? 1000000000LL / current_refresh_rate_ : 0;
+  // Retire fences signal a vsync or more after commit, the ring looks up the signal time later.
+  ring->Push(frame_timing_, layer_stack_.retire_fence);
+
+  layer_stack_.timings = {};
+  frame_timing_ = {};
+}
+
 void HWCDisplay::Dump(std::ostringstream *os) {
   *os << "\n------------HWC----------------\n";
   *os << "HWC2 display_id: " << id_ << std::endl;
@@ -3182,15 +3290,11 @@ DisplayError HWCDisplay::TeardownConcurrentWriteback(bool *needs_refresh) {
   if (cwb_state_.cwb_client == kCWBClientFrameDump) {
     dump_frame_count_ = 0;
     dump_output_to_file_ = false;
-    // Unmap and Free buffer
-    if (munmap(output_buffer_base_, output_buffer_info_.alloc_buffer_info.size) != 0) {
-      DLOGW("unmap failed with err %d", errno);
-    }
+    // Free buffer, a pending dump holds its own reference.
     if (buffer_allocator_->FreeBuffer(&output_buffer_info_) != 0) {
       DLOGW("FreeBuffer failed");
     }
     output_buffer_info_ = {};
-    output_buffer_base_ = nullptr;
   } else if (cwb_state_.cwb_client == kCWBClientColor) {
     frame_capture_buffer_queued_ = false;
     frame_capture_status_ = 0;
@@ -3469,22 +3573,14 @@ void HWCDisplay::HandleFrameDump() {
     return;
   }
 
-  int ret = 0;
-  ret = Fence::Wait(output_buffer_.release_fence);
-  if (ret != kErrorNone) {
-    DLOGE("sync_wait error errno = %d, desc = %s", errno, strerror(errno));
-  }
-
-  if (!ret) {
-    DumpOutputBuffer(output_buffer_info_, output_buffer_base_, layer_stack_.retire_fence);
-  }
+  // The frame dump writer waits for the writeback to complete and the frame to retire.
+  const native_handle_t *handle = static_cast<native_handle_t *>(output_buffer_info_.private_data);
+  DumpOutputBuffer(output_buffer_info_, handle,
+                   Fence::Merge(output_buffer_.release_fence, layer_stack_.retire_fence));
 
   if (0 == (dump_frame_count_ - 1)) {
     dump_output_to_file_ = false;
-    // Unmap and Free buffer
-    if (munmap(output_buffer_base_, output_buffer_info_.alloc_buffer_info.size) != 0) {
-      DLOGE("unmap failed with err %d", errno);
-    }
+    // Free buffer, the queued dumps hold their own references.
     if (buffer_allocator_->FreeBuffer(&output_buffer_info_) != 0) {
       DLOGE("FreeBuffer failed");
     }
@@ -3495,7 +3591,6 @@ void HWCDisplay::HandleFrameDump() {
 
     output_buffer_ = {};
     output_buffer_info_ = {};
-    output_buffer_base_ = nullptr;
     std::lock_guard<std::mutex> lock(cwb_state_lock_);
     cwb_state_.cwb_client = kCWBClientNone;
   }
@@ -44,9 +44,11 @@
 #include "histogram_collector.h"
 #include "hwc_buffer_allocator.h"
 #include "hwc_callbacks.h"
+#include "hwc_display_config_snapshot.h"
 #include "hwc_display_event_handler.h"
 #include "hwc_layers.h"
 #include "hwc_buffer_sync_handler.h"
+#include "hwc_frame_timing.h"
 #include <vendor/qti/hardware/display/composer/3.1/IQtiComposerClient.h>
 
 using android::hardware::graphics::common::V1_2::ColorMode;
@@ -116,6 +118,32 @@ struct TransientRefreshRateInfo {
   int64_t vsync_applied_time;
 };
 
+// Per display state of the last committed frame. Published by HWCSession after every commit so
+// that dumpsys can report it without taking the display lock.
+struct HWCDisplayTelemetry {
+  bool valid = false;
+  int32_t sdm_id = -1;
+  int32_t type = kDisplayTypeMax;
+  int32_t power_mode = 0;
+  int32_t active_config = -1;
+  uint32_t refresh_rate = 0;
+  uint64_t frame_count = 0;
+  int64_t last_commit_ns = 0;
+  int64_t avg_frame_interval_ns = 0;   // moving average of the time between commits
+  uint32_t num_layers = 0;
+  uint32_t num_device_layers = 0;
+  uint32_t num_client_layers = 0;
+  uint32_t num_solid_fill_layers = 0;
+  uint32_t num_cursor_layers = 0;
+  uint32_t num_secure_layers = 0;
+  bool client_target_used = false;
+  uint64_t client_composed_frames = 0;
+  uint32_t prepare_us = 0;             // time spent in DisplayInterface::Prepare
+  uint32_t commit_us = 0;              // time spent in DisplayInterface::Commit
+  uint32_t max_prepare_us = 0;
+  uint32_t max_commit_us = 0;
+};
+
 class HWCColorMode {
  public:
   HWCColorMode(){};
@@ -296,6 +324,8 @@ class HWCDisplay : public DisplayEventHandler {
                            PPPendingParams *pending_action);
   void SolidFillPrepare();
   DisplayClass GetDisplayClass();
+  const HWCDisplayTelemetry &GetTelemetry() { return telemetry_; }
+  void GetConfigSnapshot(HWCDisplayConfigSnapshot *snapshot);
   int GetVisibleDisplayRect(hwc_rect_t *rect);
   void BuildLayerStack(void);
   void BuildSolidFillStack(void);
@@ -497,8 +527,8 @@ class HWCDisplay : public DisplayEventHandler {
   virtual DisplayError HandleQsyncState(const QsyncEventData &qsync_data);
   virtual DisplayError NotifyFpsMitigation(const float fps, DisplayConcurrencyType concurrency,
                                            bool concurrency_begin);
-  virtual void DumpOutputBuffer(const BufferInfo &buffer_info, void *base,
-                                shared_ptr<Fence> &retire_fence);
+  virtual void DumpOutputBuffer(const BufferInfo &buffer_info, const native_handle_t *handle,
+                                const shared_ptr<Fence> &fence);
   virtual HWC2::Error PrepareLayerStack(uint32_t *out_num_types, uint32_t *out_num_requests);
   virtual HWC2::Error CommitLayerStack(void);
   virtual HWC2::Error PostCommitLayerStack(shared_ptr<Fence> *out_retire_fence);
@@ -543,6 +573,8 @@ class HWCDisplay : public DisplayEventHandler {
   void DumpInputBuffers(void);
   void RetrieveFences(shared_ptr<Fence> *out_retire_fence);
   void SetDrawMethod();
+  void UpdateTelemetry();
+  void UpdateFrameTiming();
 
   // CWB related methods
   void SetCwbState();
@@ -636,7 +668,6 @@ class HWCDisplay : public DisplayEventHandler {
   uint32_t dump_frame_index_ = 0;
   bool dump_input_layers_ = false;
   BufferInfo output_buffer_info_ = {};
-  void *output_buffer_base_ = nullptr;  // points to base address of output_buffer_info_
   bool dump_pending_ = false;
 
   // Members for 1 frame capture in a client provided buffer
@@ -649,6 +680,8 @@ class HWCDisplay : public DisplayEventHandler {
   int32_t client_dataspace_ = 0;
   hwc_region_t client_damage_region_ = {};
   bool validate_done_ = false;
+  HWCDisplayTelemetry telemetry_ = {};
+  FrameTimingRecord frame_timing_ = {};
 
  private:
   bool CanSkipSdmPrepare(uint32_t *num_types, uint32_t *num_requests);
@@ -46,6 +46,7 @@
 #include <string>
 #include <vector>
 
+#include "content_analyzer.h"
 #include "hwc_display_builtin.h"
 #include "hwc_color_mode_stc.h"
 #include "hwc_debugger.h"
@@ -195,6 +196,24 @@ int HWCDisplayBuiltIn::Init() {
 
   LoadMixedModePerfHintThreshold();
 
+  // Runs on the histogram thread, which histogram.stop() joins before display_intf_ goes away.
+  histogram.set_content_listener([this](histogram::ContentStats const &stats) {
+    DisplayContentStats content_stats = {};
+    content_stats.frame_count = stats.frame_count;
+    content_stats.timestamp = stats.timestamp;
+    content_stats.window_frames = stats.window_frames;
+    content_stats.mean_luma = stats.mean_luma;
+    content_stats.p10_luma = stats.p10_bin;
+    content_stats.p50_luma = stats.p50_bin;
+    content_stats.p90_luma = stats.p90_bin;
+    content_stats.dark = stats.dark;
+    content_stats.static_content = stats.static_content;
+    content_stats.scene_cut = stats.scene_cut;
+    content_stats.scene_cuts = stats.scene_cuts;
+    content_stats.last_scene_cut = stats.last_scene_cut;
+    display_intf_->SetContentStats(content_stats);
+  });
+
   return status;
 }
 
@@ -1165,7 +1184,8 @@ void HWCDisplayBuiltIn::OnTask(const LayerStitchTaskCode &task_code,
                                SyncTask<LayerStitchTaskCode>::TaskContext *task_context) {
   switch (task_code) {
     case LayerStitchTaskCode::kCodeGetInstance: {
-        gl_layer_stitch_ = GLLayerStitch::GetInstance(false /* Non-secure */);
+        gl_layer_stitch_ = GLLayerStitch::GetInstance(false /* Non-secure */,
+                                                      layer_stitch_engine_);
       }
       break;
     case LayerStitchTaskCode::kCodeStitch: {
@@ -1201,6 +1221,10 @@ bool HWCDisplayBuiltIn::InitLayerStitch() {
     return true;
   }
 
+  int cpu_stitch = 0;
+  HWCDebugHandler::Get()->GetProperty(CPU_LAYER_STITCH_PROP, &cpu_stitch);
+  layer_stitch_engine_ = (cpu_stitch == 1) ? kStitchEngineCPU : kStitchEngineGL;
+
   // Initialize stitch context. This will be non-secure.
   layer_stitch_task_.PerformTask(LayerStitchTaskCode::kCodeGetInstance, nullptr);
   if (gl_layer_stitch_ == nullptr) {
@@ -1240,7 +1264,9 @@ bool HWCDisplayBuiltIn::AllocateStitchBuffer() {
   // buffers allocated through gralloc , including framebuffer targets.
   int ubwc_disabled = 0;
   HWCDebugHandler::Get()->GetProperty(DISABLE_UBWC_PROP, &ubwc_disabled);
-  config.format = ubwc_disabled ? kFormatRGBA8888 : kFormatRGBA8888Ubwc;
+  // The CPU engine only writes linear buffers.
+  bool linear = ubwc_disabled || (layer_stitch_engine_ == kStitchEngineCPU);
+  config.format = linear ? kFormatRGBA8888 : kFormatRGBA8888Ubwc;
 
   config.gfx_client = true;
 
@@ -203,6 +203,7 @@ class HWCDisplayBuiltIn : public HWCDisplay, public SyncTask<LayerStitchTaskCode
   HWCLayer* stitch_target_ = nullptr;
   SyncTask<LayerStitchTaskCode> layer_stitch_task_;
   GLLayerStitch* gl_layer_stitch_ = nullptr;
+  LayerStitchEngine layer_stitch_engine_ = kStitchEngineGL;
   BufferInfo buffer_info_ = {};
   DisplayConfigVariableInfo fb_config_ = {};
 
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "hwc_display_config_snapshot.h"
+
+#include <algorithm>
+
+namespace sdm {
+
+void HWCDisplayConfigSnapshot::GetDisplayConfigs(uint32_t *out_num_configs,
+                                                 hwc2_config_t *out_configs) const {
+  if (out_configs == nullptr) {
+    *out_num_configs = num_configs;
+    return;
+  }
+
+  *out_num_configs = std::min(*out_num_configs, num_configs);
+  for (uint32_t i = 0; i < *out_num_configs; i++) {
+    out_configs[i] = configs[i].id;
+  }
+}
+
+bool HWCDisplayConfigSnapshot::GetDisplayAttribute(hwc2_config_t config, HwcAttribute attribute,
+                                                   int32_t *out_value) const {
+  for (uint32_t i = 0; i < num_configs; i++) {
+    const Config &info = configs[i];
+    if (info.id != config) {
+      continue;
+    }
+    switch (attribute) {
+      case HwcAttribute::VSYNC_PERIOD:
+        *out_value = info.vsync_period;
+        return true;
+      case HwcAttribute::WIDTH:
+        *out_value = info.width;
+        return true;
+      case HwcAttribute::HEIGHT:
+        *out_value = info.height;
+        return true;
+      case HwcAttribute::DPI_X:
+        *out_value = info.dpi_x;
+        return true;
+      case HwcAttribute::DPI_Y:
+        *out_value = info.dpi_y;
+        return true;
+      case HwcAttribute::CONFIG_GROUP:
+        *out_value = info.config_group;
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  return false;
+}
+
+void HWCDisplayConfigSnapshot::GetColorModes(uint32_t *out_num_modes, ColorMode *out_modes) const {
+  if (out_modes == nullptr) {
+    *out_num_modes = num_color_modes;
+    return;
+  }
+
+  *out_num_modes = std::min(*out_num_modes, num_color_modes);
+  for (uint32_t i = 0; i < *out_num_modes; i++) {
+    out_modes[i] = color_modes[i].mode;
+  }
+}
+
+bool HWCDisplayConfigSnapshot::GetRenderIntents(ColorMode mode, uint32_t *out_num_intents,
+                                                RenderIntent *out_intents) const {
+  for (uint32_t i = 0; i < num_color_modes; i++) {
+    const ColorModeIntents &color_mode = color_modes[i];
+    if (color_mode.mode != mode) {
+      continue;
+    }
+    if (out_intents == nullptr) {
+      *out_num_intents = color_mode.num_intents;
+      return true;
+    }
+    *out_num_intents = std::min(*out_num_intents, color_mode.num_intents);
+    std::copy_n(color_mode.intents, *out_num_intents, out_intents);
+    return true;
+  }
+
+  return false;
+}
+
+void HWCDisplayConfigSnapshot::GetHdrCapabilities(uint32_t *out_num_types, int32_t *out_types,
+                                                  float *out_max_luminance,
+                                                  float *out_max_average_luminance,
+                                                  float *out_min_luminance) const {
+  // Luminance is reported only along with the types, as HWCDisplay does.
+  if (out_types == nullptr || !num_hdr_types) {
+    *out_num_types = num_hdr_types;
+    return;
+  }
+
+  *out_num_types = std::min(*out_num_types, num_hdr_types);
+  std::copy_n(hdr_types, *out_num_types, out_types);
+  *out_max_luminance = max_luminance;
+  *out_max_average_luminance = max_average_luminance;
+  *out_min_luminance = min_luminance;
+}
+
+}  // namespace sdm
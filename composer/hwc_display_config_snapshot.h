@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HWC_DISPLAY_CONFIG_SNAPSHOT_H__
+#define __HWC_DISPLAY_CONFIG_SNAPSHOT_H__
+
+#include <android/hardware/graphics/common/1.2/types.h>
+#include <android/hardware/graphics/composer/2.4/IComposerClient.h>
+#include <hardware/hwcomposer2.h>
+#include <stdint.h>
+
+using android::hardware::graphics::common::V1_2::ColorMode;
+using android::hardware::graphics::common::V1_1::RenderIntent;
+namespace composer_V2_4 = ::android::hardware::graphics::composer::V2_4;
+using HwcAttribute = composer_V2_4::IComposerClient::Attribute;
+
+namespace sdm {
+
+// Configuration of a display as seen by the HWC2 getters. Published by HWCSession whenever it may
+// have changed so that frequent getters are answered without waiting for the display lock. A
+// display with more configs or color modes than fit leaves the snapshot invalid.
+//
+// The getters below follow the HWC2 calls of the same name. They return false where the display
+// has to answer instead, for an unknown config, attribute or color mode, so that the error codes
+// stay those of the display.
+struct HWCDisplayConfigSnapshot {
+  static const uint32_t kMaxConfigs = 64;
+  static const uint32_t kMaxColorModes = 16;
+  static const uint32_t kMaxRenderIntents = 16;
+  static const uint32_t kMaxHdrTypes = 8;
+
+  struct Config {
+    hwc2_config_t id = 0;
+    int32_t vsync_period = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t dpi_x = 0;
+    int32_t dpi_y = 0;
+    int32_t config_group = 0;
+  };
+
+  struct ColorModeIntents {
+    ColorMode mode = ColorMode::NATIVE;
+    uint32_t num_intents = 0;
+    RenderIntent intents[kMaxRenderIntents] = {};
+  };
+
+  void GetDisplayConfigs(uint32_t *out_num_configs, hwc2_config_t *out_configs) const;
+  bool GetDisplayAttribute(hwc2_config_t config, HwcAttribute attribute,
+                           int32_t *out_value) const;
+  void GetColorModes(uint32_t *out_num_modes, ColorMode *out_modes) const;
+  bool GetRenderIntents(ColorMode mode, uint32_t *out_num_intents,
+                        RenderIntent *out_intents) const;
+  void GetHdrCapabilities(uint32_t *out_num_types, int32_t *out_types, float *out_max_luminance,
+                          float *out_max_average_luminance, float *out_min_luminance) const;
+
+  bool valid = false;
+  hwc2_config_t active_config = 0;
+  uint32_t num_configs = 0;
+  Config configs[kMaxConfigs];
+  uint32_t num_color_modes = 0;
+  ColorModeIntents color_modes[kMaxColorModes];
+  uint32_t num_hdr_types = 0;
+  int32_t hdr_types[kMaxHdrTypes] = {};
+  float max_luminance = 0.0f;
+  float max_average_luminance = 0.0f;
+  float min_luminance = 0.0f;
+};
+
+}  // namespace sdm
+
+#endif  // __HWC_DISPLAY_CONFIG_SNAPSHOT_H__
@@ -65,6 +65,7 @@
 
 #include <utils/constants.h>
 #include <utils/debug.h>
+#include <utils/worker_pool.h>
 #include <sync/sync.h>
 #include <stdarg.h>
 #include <QtiGralloc.h>
@@ -96,12 +97,8 @@ int HWCDisplayVirtual::Init() {
 
 int HWCDisplayVirtual::Deinit() {
   int ret = HWCDisplay::Deinit();
-   for (std::thread &notify_concurrency_fps : notify_concurrency_fps_) {
-    if (notify_concurrency_fps.joinable()) {
-      notify_concurrency_fps.join();
-    }
-  }
-  notify_concurrency_fps_.clear();
+  // Pending fps notifications reference this display.
+  WorkerPool::GetInstance()->Drain(kLaneNotify);
   return ret;
 }
 
@@ -130,12 +127,6 @@ HWC2::Error HWCDisplayVirtual::DumpVDSBuffer() {
       BufferInfo buffer_info;
       const native_handle_t *output_handle =
           reinterpret_cast<const native_handle_t *>(output_buffer_.buffer_id);
-      void *base_ptr = NULL;
-      int error = buffer_allocator_->MapBuffer(output_handle, nullptr, &base_ptr);
-      if (error != 0) {
-        DLOGE("Failed to map output buffer, error = %d", error);
-        return HWC2::Error::BadParameter;
-      }
       uint32_t width, height, alloc_size = 0;
       int32_t format, flags = 0;
       buffer_allocator_->GetWidth((void *)output_handle, width);
@@ -148,14 +139,7 @@ HWC2::Error HWCDisplayVirtual::DumpVDSBuffer() {
       buffer_info.buffer_config.height = height;
       buffer_info.buffer_config.format = HWCLayer::GetSDMFormat(format, flags);
       buffer_info.alloc_buffer_info.size = alloc_size;
-      DumpOutputBuffer(buffer_info, base_ptr, layer_stack_.retire_fence);
-
-      int release_fence = -1;
-      error = buffer_allocator_->UnmapBuffer(output_handle, &release_fence);
-      if (error != 0) {
-        DLOGE("Failed to unmap buffer, error = %d", error);
-        return HWC2::Error::BadParameter;
-      }
+      DumpOutputBuffer(buffer_info, output_handle, layer_stack_.retire_fence);
     }
   }
 
@@ -253,9 +237,15 @@ DisplayError HWCDisplayVirtual::NotifyFpsMitigation(const float fps,
                                                     DisplayConcurrencyType concurrency,
                                                     bool concurrency_begin) {
   commit_done_ = false;
-  std::thread notify_concurrency_fps = std::thread(&HWCDisplayVirtual::NotifyConcurrencyFps, this, fps,
-                                        concurrency, concurrency_begin);
-  notify_concurrency_fps_.push_back(std::move(notify_concurrency_fps));
+  int ret = WorkerPool::GetInstance()->Post(kLaneNotify, [this, fps, concurrency,
+                                                          concurrency_begin]() {
+    NotifyConcurrencyFps(fps, concurrency, concurrency_begin);
+  });
+  if (ret) {
+    commit_done_ = true;
+    return kErrorResources;
+  }
+
   return kErrorNone;
 }
 
@@ -105,7 +105,6 @@ class HWCDisplayVirtual : public HWCDisplay {
  private:
   bool dump_output_layer_ = false;
   bool commit_done_ = true;
-  std::vector<std::thread> notify_concurrency_fps_;
 };
 
 }  // namespace sdm
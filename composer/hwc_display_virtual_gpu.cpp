@@ -35,6 +35,7 @@
  */
 
 #include "hwc_display_virtual_gpu.h"
+#include "hwc_debugger.h"
 #include "hwc_session.h"
 #include "QtiGralloc.h"
 
@@ -227,7 +228,15 @@ void HWCDisplayVirtualGPU::OnTask(const ColorConvertTaskCode &task_code,
                                   SyncTask<ColorConvertTaskCode>::TaskContext *task_context) {
   switch (task_code) {
     case ColorConvertTaskCode::kCodeGetInstance: {
-        gl_color_convert_ = GLColorConvert::GetInstance(kTargetYUV, output_buffer_.flags.secure);
+        bool secure = output_buffer_.flags.secure;
+        bool use_cpu = !secure && UseCPUColorConvert();
+        gl_color_convert_ = GLColorConvert::GetInstance(kTargetYUV, secure,
+                                                        use_cpu ? kEngineCPU : kEngineGL);
+        if (!gl_color_convert_ && !use_cpu && !secure) {
+          // No usable GLES, e.g. on headless test rigs.
+          DLOGW("GL color convert unavailable, falling back to CPU");
+          gl_color_convert_ = GLColorConvert::GetInstance(kTargetYUV, secure, kEngineCPU);
+        }
       }
       break;
     case ColorConvertTaskCode::kCodeBlit: {
@@ -254,6 +263,15 @@ void HWCDisplayVirtualGPU::OnTask(const ColorConvertTaskCode &task_code,
   }
 }
 
+bool HWCDisplayVirtualGPU::UseCPUColorConvert() {
+  int max_pixels = 0;
+  HWCDebugHandler::Get()->GetProperty(CPU_COLOR_CONVERT_MAX_PIXELS_PROP, &max_pixels);
+
+  // Small outputs, e.g. low resolution WFD sessions, are cheaper to convert than to wake the GPU.
+  uint64_t pixels = UINT64(output_buffer_.unaligned_width) * output_buffer_.unaligned_height;
+  return max_pixels > 0 && pixels <= UINT64(max_pixels);
+}
+
 bool HWCDisplayVirtualGPU::FreezeScreen() {
   if (!disable_animation_) {
     return false;
@@ -114,6 +114,7 @@ class HWCDisplayVirtualGPU : public HWCDisplayVirtual,
   // SyncTask methods.
   void OnTask(const ColorConvertTaskCode &task_code,
               SyncTask<ColorConvertTaskCode>::TaskContext *task_context);
+  bool UseCPUColorConvert();
 
   SyncTask<ColorConvertTaskCode> color_convert_task_;
   GLColorConvert *gl_color_convert_ = nullptr;
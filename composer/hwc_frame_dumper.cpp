@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+#include <utils/worker_pool.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "hwc_debugger.h"
+#include "hwc_frame_dumper.h"
+
+#define __CLASS__ "HWCFrameDumper"
+
+namespace sdm {
+
+HWCFrameDumper *HWCFrameDumper::GetInstance() {
+  static HWCFrameDumper *s_instance = new HWCFrameDumper();
+  return s_instance;
+}
+
+void HWCFrameDumper::Configure() {
+  int policy = 0;
+  int compress = 0;
+  int max_jobs = 0;
+  int max_staged_mb = 0;
+  HWCDebugHandler::Get()->GetProperty(FRAME_DUMP_POLICY_PROP, &policy);
+  HWCDebugHandler::Get()->GetProperty(FRAME_DUMP_COMPRESS_PROP, &compress);
+  HWCDebugHandler::Get()->GetProperty(FRAME_DUMP_MAX_FRAMES_PROP, &max_jobs);
+  HWCDebugHandler::Get()->GetProperty(FRAME_DUMP_MAX_STAGED_MB_PROP, &max_staged_mb);
+
+  SetConfig((policy == 1) ? kDropOldest : kDropNewest, (compress == 1),
+            (max_jobs > 0) ? size_t(max_jobs) : kDefaultMaxJobs,
+            (max_staged_mb > 0) ? size_t(max_staged_mb) * 1024 * 1024 : kDefaultMaxStagedBytes);
+}
+
+void HWCFrameDumper::SetConfig(OverflowPolicy policy, bool compress, size_t max_jobs,
+                               size_t max_staged_bytes) {
+  std::lock_guard<std::mutex> lock(lock_);
+  policy_ = policy;
+  compress_ = compress;
+  max_jobs_ = max_jobs;
+  max_staged_bytes_ = max_staged_bytes;
+  // A lower limit releases the spare buffers that no longer fit right away.
+  while (!spare_.empty() && (staged_bytes_ + spare_bytes_) > max_staged_bytes_) {
+    spare_bytes_ -= spare_.back().capacity();
+    spare_.pop_back();
+  }
+  DLOGI("policy %s, compress %d, max frames %zu, max staged %zu bytes",
+        (policy_ == kDropOldest) ? "drop oldest" : "drop newest", compress_, max_jobs_,
+        max_staged_bytes_);
+}
+
+int HWCFrameDumper::QueueCopy(const std::string &path, const void *base, size_t size) {
+  if (!base || !size) {
+    return -EINVAL;
+  }
+
+  std::unique_ptr<Job> job(new Job());
+  {
+    // Check for room before paying for the copy.
+    std::lock_guard<std::mutex> lock(lock_);
+    TakeSpare(size, &job->data);
+    if (!MakeRoom(size)) {
+      frames_dropped_++;
+      return -ENOBUFS;
+    }
+  }
+
+  job->path = path;
+  job->size = size;
+  const uint8_t *data = reinterpret_cast<const uint8_t *>(base);
+  job->data.assign(data, data + size);
+
+  return Enqueue(std::move(job));
+}
+
+int HWCFrameDumper::QueueBuffer(const std::string &path, const native_handle_t *handle,
+                                size_t size, const shared_ptr<Fence> &fence,
+                                FrameDumpBufferOps *ops) {
+  if (!handle || !size || !ops) {
+    return -EINVAL;
+  }
+
+  {
+    // Check for room before retaining the buffer.
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!MakeRoom(size)) {
+      frames_dropped_++;
+      return -ENOBUFS;
+    }
+  }
+
+  std::unique_ptr<Job> job(new Job());
+  job->handle = ops->RetainBuffer(handle);
+  if (!job->handle) {
+    DLOGW("Failed to retain buffer for %s", path.c_str());
+    return -ENOMEM;
+  }
+  job->path = path;
+  job->size = size;
+  job->fence = fence;
+  job->ops = ops;
+
+  return Enqueue(std::move(job));
+}
+
+// Applies the overflow policy for a frame staging staged_bytes. Called with lock_ held.
+bool HWCFrameDumper::MakeRoom(size_t staged_bytes) {
+  if (staged_bytes > max_staged_bytes_) {
+    return false;
+  }
+
+  // Spare buffers go first, they only save allocations.
+  while (!spare_.empty() && (staged_bytes_ + spare_bytes_ + staged_bytes) > max_staged_bytes_) {
+    spare_bytes_ -= spare_.back().capacity();
+    spare_.pop_back();
+  }
+
+  while (pending_.size() >= max_jobs_ || (staged_bytes_ + staged_bytes) > max_staged_bytes_) {
+    if (policy_ != kDropOldest || pending_.empty()) {
+      return false;
+    }
+    std::unique_ptr<Job> oldest = std::move(pending_.front());
+    pending_.pop_front();
+    DLOGW("Dropping frame dump %s", oldest->path.c_str());
+    staged_bytes_ -= oldest->size;
+    DropJob(std::move(oldest));
+  }
+
+  return true;
+}
+
+// Called with lock_ held.
+void HWCFrameDumper::DropJob(std::unique_ptr<Job> job) {
+  if (job->handle) {
+    job->ops->ReleaseBuffer(job->handle);
+  }
+  frames_dropped_++;
+}
+
+// Moves the smallest spare buffer holding size bytes to data. Called with lock_ held.
+void HWCFrameDumper::TakeSpare(size_t size, std::vector<uint8_t> *data) {
+  auto best = spare_.end();
+  for (auto it = spare_.begin(); it != spare_.end(); it++) {
+    if (it->capacity() >= size && (best == spare_.end() || it->capacity() < best->capacity())) {
+      best = it;
+    }
+  }
+  if (best == spare_.end()) {
+    return;
+  }
+
+  spare_bytes_ -= best->capacity();
+  data->swap(*best);
+  spare_.erase(best);
+}
+
+// Keeps a written out buffer for reuse while it fits the staging limits. Called with lock_ held.
+void HWCFrameDumper::Recycle(std::vector<uint8_t> *data) {
+  size_t capacity = data->capacity();
+  if (spare_.size() >= kMaxSpareBuffers ||
+      (staged_bytes_ + spare_bytes_ + capacity) > max_staged_bytes_) {
+    return;
+  }
+
+  spare_bytes_ += capacity;
+  spare_.push_back(std::move(*data));
+}
+
+int HWCFrameDumper::Enqueue(std::unique_ptr<Job> job) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (!MakeRoom(job->size)) {
+    DLOGW("Frame dump queue full, dropping %s", job->path.c_str());
+    DropJob(std::move(job));
+    return -ENOBUFS;
+  }
+
+  staged_bytes_ += job->size;
+  pending_.push_back(std::move(job));
+  frames_queued_++;
+
+  WorkerPool::GetInstance()->Post(kLaneFrameDump, [this]() { WritePending(); }, kCoalesceWriter);
+
+  return 0;
+}
+
+void HWCFrameDumper::WritePending() {
+  while (true) {
+    std::unique_ptr<Job> job;
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      if (pending_.empty()) {
+        return;
+      }
+      job = std::move(pending_.front());
+      pending_.pop_front();
+    }
+
+    size_t written = 0;
+    if (!job->handle || CopyBuffer(job.get())) {
+      written = WriteFile(job->path, job->data.data(), job->data.size());
+    }
+    DLOGI("Frame Dump %s is %s", job->path.c_str(), written ? "Successful" : "Failed");
+
+    std::lock_guard<std::mutex> lock(lock_);
+    staged_bytes_ -= job->size;
+    if (written) {
+      frames_written_++;
+      bytes_written_ += written;
+    } else {
+      frames_failed_++;
+    }
+    Recycle(&job->data);
+  }
+}
+
+// Waits for the fence of a QueueBuffer job, copies the buffer into the staging ring and releases
+// it, so the buffer is held no longer than the copy takes. Returns false if nothing was copied.
+bool HWCFrameDumper::CopyBuffer(Job *job) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    TakeSpare(job->size, &job->data);
+  }
+
+  bool copied = false;
+  void *base = nullptr;
+  if (Fence::Wait(job->fence) != 0) {
+    DLOGW("Fence wait failed for %s", job->path.c_str());
+  } else if (job->ops->MapBuffer(job->handle, nullptr, &base) != 0 || !base) {
+    DLOGW("Failed to map buffer for %s", job->path.c_str());
+  } else {
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(base);
+    job->data.assign(data, data + job->size);
+    int release_fence = -1;
+    job->ops->UnmapBuffer(job->handle, &release_fence);
+    if (release_fence >= 0) {
+      close(release_fence);
+    }
+    copied = true;
+  }
+
+  job->ops->ReleaseBuffer(job->handle);
+  job->handle = nullptr;
+  job->fence = nullptr;
+
+  return copied;
+}
+
+size_t HWCFrameDumper::WriteFile(const std::string &path, const void *data, size_t size) {
+  bool compress = false;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    compress = compress_;
+  }
+
+  if (!compress) {
+    FILE *fp = fopen(path.c_str(), "w+");
+    if (!fp) {
+      return 0;
+    }
+    size_t result = fwrite(data, size, 1, fp);
+    fclose(fp);
+    return result ? size : 0;
+  }
+
+  // Level 1 deflate, dumps are mostly flat color and compress well even at the fastest setting.
+  std::string gz_path = path + ".gz";
+  gzFile gz = gzopen(gz_path.c_str(), "wb1");
+  if (!gz) {
+    return 0;
+  }
+
+  const size_t kChunkSize = 1 << 20;
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+  size_t offset = 0;
+  while (offset < size) {
+    unsigned int chunk = UINT32(std::min(kChunkSize, size - offset));
+    if (gzwrite(gz, bytes + offset, chunk) != INT(chunk)) {
+      break;
+    }
+    offset += chunk;
+  }
+
+  if (gzclose(gz) != Z_OK || offset != size) {
+    return 0;
+  }
+
+  return size;
+}
+
+void HWCFrameDumper::Dump(std::ostringstream *os) {
+  std::lock_guard<std::mutex> lock(lock_);
+  *os << "\nFrame dumps: queued " << frames_queued_ << ", written " << frames_written_;
+  *os << ", dropped " << frames_dropped_ << ", failed " << frames_failed_;
+  *os << ", bytes written " << bytes_written_ << ", pending " << pending_.size();
+  *os << " (" << staged_bytes_ << " bytes staged, " << spare_.size() << " spare buffers of ";
+  *os << spare_bytes_ << " bytes)\n";
+}
+
+}  // namespace sdm
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HWC_FRAME_DUMPER_H__
+#define __HWC_FRAME_DUMPER_H__
+
+#include <cutils/native_handle.h>
+#include <utils/fence.h>
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace sdm {
+
+// Buffer access for the frame dump writer, implemented by HWCBufferAllocator.
+class FrameDumpBufferOps {
+ public:
+  // Returns a separately imported handle of the same buffer. It stays valid until ReleaseBuffer,
+  // also after the client has freed its own handle.
+  virtual const native_handle_t *RetainBuffer(const native_handle_t *handle) = 0;
+  virtual void ReleaseBuffer(const native_handle_t *handle) = 0;
+  virtual int MapBuffer(const native_handle_t *handle, shared_ptr<Fence> acquire_fence,
+                        void **base_ptr) = 0;
+  virtual int UnmapBuffer(const native_handle_t *handle, int *release_fence) = 0;
+
+ protected:
+  virtual ~FrameDumpBufferOps() {}
+};
+
+// Writes frame dumps off the composer thread. Buffers are queued with their fence and a retained
+// handle, a background WorkerPool lane waits for the fence, copies the buffer into a bounded
+// staging ring, releases it and writes the copy out. When the ring is full frames are dropped
+// according to the configured policy instead of stalling composition. Staging buffers are
+// recycled, so steady state dumps do not allocate.
+class HWCFrameDumper {
+ public:
+  enum OverflowPolicy {
+    kDropNewest,  // keep what is staged, drop the incoming frame
+    kDropOldest,  // make room by dropping the oldest staged frame
+  };
+
+  static HWCFrameDumper *GetInstance();
+
+  // Re-reads policy, compression and limits from properties, called on a new dump request.
+  void Configure();
+  void SetConfig(OverflowPolicy policy, bool compress, size_t max_jobs, size_t max_staged_bytes);
+  // Queues a dump of the first size bytes of handle once fence has signaled. The caller neither
+  // waits nor copies and may let go of the buffer as soon as this returns.
+  int QueueBuffer(const std::string &path, const native_handle_t *handle, size_t size,
+                  const shared_ptr<Fence> &fence, FrameDumpBufferOps *ops);
+  // Copies size bytes at base into the staging ring. The caller must have waited for the
+  // buffer's acquire fence and may reuse the buffer as soon as this returns.
+  int QueueCopy(const std::string &path, const void *base, size_t size);
+  void Dump(std::ostringstream *os);
+
+ private:
+  struct Job {
+    std::string path;
+    size_t size = 0;
+    std::vector<uint8_t> data;
+    // Set for QueueBuffer jobs, data is copied out on the writer thread.
+    const native_handle_t *handle = nullptr;
+    shared_ptr<Fence> fence = nullptr;
+    FrameDumpBufferOps *ops = nullptr;
+  };
+
+  HWCFrameDumper() {}
+  int Enqueue(std::unique_ptr<Job> job);
+  bool MakeRoom(size_t staged_bytes);
+  void DropJob(std::unique_ptr<Job> job);
+  bool CopyBuffer(Job *job);
+  void TakeSpare(size_t size, std::vector<uint8_t> *data);
+  void Recycle(std::vector<uint8_t> *data);
+  void WritePending();
+  size_t WriteFile(const std::string &path, const void *data, size_t size);
+
+  static const size_t kDefaultMaxJobs = 32;
+  static const size_t kDefaultMaxStagedBytes = 128 * 1024 * 1024;
+  static const size_t kMaxSpareBuffers = 8;
+  // Coalesce key of the writer task, one pending writer drains the whole ring.
+  static const uint64_t kCoalesceWriter = 1;
+
+  std::mutex lock_;
+  std::deque<std::unique_ptr<Job>> pending_;
+  // Written out buffers kept for reuse, their capacity counts against max_staged_bytes_.
+  std::vector<std::vector<uint8_t>> spare_;
+  size_t staged_bytes_ = 0;
+  size_t spare_bytes_ = 0;
+  OverflowPolicy policy_ = kDropNewest;
+  bool compress_ = false;
+  size_t max_jobs_ = kDefaultMaxJobs;
+  size_t max_staged_bytes_ = kDefaultMaxStagedBytes;
+
+  uint64_t frames_queued_ = 0;
+  uint64_t frames_written_ = 0;
+  uint64_t frames_dropped_ = 0;
+  uint64_t frames_failed_ = 0;
+  uint64_t bytes_written_ = 0;
+};
+
+}  // namespace sdm
+
+#endif  // __HWC_FRAME_DUMPER_H__
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <stdlib.h>
+#include <utils/constants.h>
+#include <utils/worker_pool.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "hwc_callbacks.h"
+#include "hwc_frame_timing.h"
+
+namespace sdm {
+
+static const char *kMetricNames[kMetricMax] = {
+  "validate", "strategy", "hw commit", "fence wait", "retire latency", "vsync deviation",
+};
+
+static HWCFrameTimingRing g_frame_timing_rings[HWCCallbacks::kNumDisplays];
+
+HWCFrameTimingRing *HWCFrameTimingRing::Get(uint64_t display_id) {
+  if (display_id >= HWCCallbacks::kNumDisplays) {
+    return nullptr;
+  }
+
+  return &g_frame_timing_rings[display_id];
+}
+
+uint64_t HWCFrameTimingRing::Push(const FrameTimingRecord &record,
+                                  const shared_ptr<Fence> &retire_fence) {
+  uint64_t frames = frames_.load(std::memory_order_relaxed);
+  FrameTimingRecord entry = record;
+  entry.frame = frames + 1;
+  slots_[frames % kCapacity].Write(entry);
+  frames_.store(frames + 1, std::memory_order_release);
+
+  // A fence still held by the frame leaving the ring is closed after the lock is dropped.
+  shared_ptr<Fence> evicted = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(retire_mutex_);
+    RetireSlot &retire_slot = retire_slots_[frames % kCapacity];
+    evicted = std::move(retire_slot.fence);
+    retire_slot.frame = entry.frame;
+    retire_slot.fence = retire_fence;
+    retire_slot.signal_ns = 0;
+  }
+
+  // The ring's address never collides with the small coalesce keys of the other lane users.
+  if (!(entry.frame % kResolveInterval)) {
+    WorkerPool::GetInstance()->Post(kLaneFrameDump, [this]() { ResolveRetireFences(); },
+                                    reinterpret_cast<uintptr_t>(this));
+  }
+
+  return entry.frame;
+}
+
+void HWCFrameTimingRing::SetRetireSignal(uint64_t frame, int64_t retire_signal_ns) {
+  if (!frame) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(retire_mutex_);
+  RetireSlot &retire_slot = retire_slots_[(frame - 1) % kCapacity];
+  if (retire_slot.frame != frame) {
+    return;
+  }
+
+  retire_slot.signal_ns = retire_signal_ns;
+  retire_slot.fence = nullptr;
+}
+
+void HWCFrameTimingRing::ResolveRetireFences() {
+  // sync_file_info runs without the lock, Push is not held up by it.
+  std::vector<std::pair<uint64_t, shared_ptr<Fence>>> pending;
+  {
+    std::lock_guard<std::mutex> lock(retire_mutex_);
+    for (auto &retire_slot : retire_slots_) {
+      if (retire_slot.fence) {
+        pending.emplace_back(retire_slot.frame, retire_slot.fence);
+      }
+    }
+  }
+
+  for (auto &frame_fence : pending) {
+    int64_t signal_ns = 0;
+    if (!Fence::GetSignalTime(frame_fence.second, &signal_ns)) {
+      SetRetireSignal(frame_fence.first, signal_ns);
+    }
+  }
+}
+
+static uint32_t Percentile(std::vector<uint32_t> *values, uint32_t percentile) {
+  size_t index = (values->size() - 1) * percentile / 100;
+  std::nth_element(values->begin(), values->begin() + INT(index), values->end());
+
+  return (*values)[index];
+}
+
+void HWCFrameTimingRing::GetPercentiles(FrameTimingPercentiles *percentiles) {
+  ResolveRetireFences();
+
+  uint64_t retire_frames[kCapacity] = {};
+  int64_t retire_signal_ns[kCapacity] = {};
+  {
+    std::lock_guard<std::mutex> lock(retire_mutex_);
+    for (uint32_t i = 0; i < kCapacity; i++) {
+      retire_frames[i] = retire_slots_[i].frame;
+      retire_signal_ns[i] = retire_slots_[i].signal_ns;
+    }
+  }
+  // Signal time of frame, 0 while unknown.
+  auto retire_signal = [&retire_frames, &retire_signal_ns](uint64_t frame) {
+    uint32_t index = (frame - 1) % kCapacity;
+    return (frame && retire_frames[index] == frame) ? retire_signal_ns[index] : 0;
+  };
+
+  std::vector<uint32_t> values[kMetricMax];
+  uint64_t frames = std::min(frames_.load(std::memory_order_acquire), UINT64(kCapacity));
+
+  for (uint32_t i = 0; i < frames; i++) {
+    FrameTimingRecord record;
+    slots_[i].Read(&record);
+    if (!record.frame) {
+      continue;
+    }
+
+    // Frames presented without a validate have no validate times.
+    bool validated = record.validate_start_ns &&
+                     (record.validate_end_ns >= record.validate_start_ns);
+    if (validated) {
+      values[kMetricValidate].push_back(
+          UINT32((record.validate_end_ns - record.validate_start_ns) / 1000));
+    }
+    values[kMetricStrategy].push_back(record.strategy_us);
+    values[kMetricHwCommit].push_back(record.hw_commit_us);
+    values[kMetricFenceWait].push_back(record.fence_wait_us);
+    int64_t retire_ns = retire_signal(record.frame);
+    if (validated && retire_ns > record.validate_start_ns) {
+      values[kMetricRetireLatency].push_back(
+          UINT32((retire_ns - record.validate_start_ns) / 1000));
+    }
+    int64_t prev_retire_ns = retire_signal(record.frame - 1);
+    int64_t period = record.vsync_period_ns;
+    if (period > 0 && prev_retire_ns && retire_ns > prev_retire_ns) {
+      int64_t interval = retire_ns - prev_retire_ns;
+      int64_t vsyncs = (interval + period / 2) / period;
+      values[kMetricVsyncDeviation].push_back(UINT32(llabs(interval - vsyncs * period) / 1000));
+    }
+  }
+
+  *percentiles = {};
+  for (int metric = 0; metric < kMetricMax; metric++) {
+    if (values[metric].empty()) {
+      continue;
+    }
+    percentiles->samples[metric] = UINT32(values[metric].size());
+    percentiles->p50[metric] = Percentile(&values[metric], 50);
+    percentiles->p95[metric] = Percentile(&values[metric], 95);
+    percentiles->p99[metric] = Percentile(&values[metric], 99);
+  }
+}
+
+void HWCFrameTimingRing::Dump(std::ostringstream *os) {
+  FrameTimingPercentiles percentiles;
+  GetPercentiles(&percentiles);
+
+  *os << "frame timing (us, last " << percentiles.samples[kMetricStrategy] << " frames):";
+  for (int metric = 0; metric < kMetricMax; metric++) {
+    *os << "\n  " << kMetricNames[metric] << ": p50 " << percentiles.p50[metric];
+    *os << " p95 " << percentiles.p95[metric] << " p99 " << percentiles.p99[metric];
+    *os << " (" << percentiles.samples[metric] << " samples)";
+  }
+  *os << std::endl;
+}
+
+}  // namespace sdm
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HWC_FRAME_TIMING_H__
+#define __HWC_FRAME_TIMING_H__
+
+#include <stdint.h>
+#include <utils/fence.h>
+#include <utils/seqlock.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+namespace sdm {
+
+enum FrameTimingMetric {
+  kMetricValidate,        // validate start to end
+  kMetricStrategy,        // SDM strategy selection
+  kMetricHwCommit,        // SDM hardware commit
+  kMetricFenceWait,       // SDM blocked on fences during commit
+  kMetricRetireLatency,   // validate start to retire fence signal
+  kMetricVsyncDeviation,  // retire signal distance from the vsync grid of the previous frame
+  kMetricMax,
+};
+
+// Times in microseconds unless noted, all timestamps are CLOCK_MONOTONIC.
+struct FrameTimingRecord {
+  uint64_t frame = 0;                 // assigned by Push, 0 marks an unused slot
+  int64_t validate_start_ns = 0;
+  int64_t validate_end_ns = 0;
+  uint32_t strategy_us = 0;
+  uint32_t hw_commit_us = 0;
+  uint32_t fence_wait_us = 0;
+  int64_t vsync_period_ns = 0;        // 0 when not known
+};
+
+struct FrameTimingPercentiles {
+  uint32_t samples[kMetricMax] = {};
+  uint32_t p50[kMetricMax] = {};
+  uint32_t p95[kMetricMax] = {};
+  uint32_t p99[kMetricMax] = {};
+};
+
+// Fixed size ring of the most recent frames of a display. Written by the composer thread holding
+// the display lock, read by dumpsys and qservice without any lock.
+// The retire fence of each frame is kept with it. Its signal time is looked up on the frame dump
+// lane every kResolveInterval frames and before percentiles are computed, never by Push.
+class HWCFrameTimingRing {
+ public:
+  static const uint32_t kCapacity = 128;
+  static const uint32_t kResolveInterval = 32;
+
+  static HWCFrameTimingRing *Get(uint64_t display_id);
+
+  // Returns the frame number assigned to the record.
+  uint64_t Push(const FrameTimingRecord &record, const shared_ptr<Fence> &retire_fence);
+  // Sets the retire signal time of frame and drops its fence, ignored if the frame has left the
+  // ring.
+  void SetRetireSignal(uint64_t frame, int64_t retire_signal_ns);
+  // Looks up the signal time of every retire fence still held.
+  void ResolveRetireFences();
+  void GetPercentiles(FrameTimingPercentiles *percentiles);
+  void Dump(std::ostringstream *os);
+
+ private:
+  struct RetireSlot {
+    uint64_t frame = 0;
+    shared_ptr<Fence> fence = nullptr;  // held until its signal time is known
+    int64_t signal_ns = 0;
+  };
+
+  SeqLock<FrameTimingRecord> slots_[kCapacity];
+  std::atomic<uint64_t> frames_ {0};
+  std::mutex retire_mutex_;  // Push holds it only to swap the fence in
+  RetireSlot retire_slots_[kCapacity];
+};
+
+}  // namespace sdm
+
+#endif  // __HWC_FRAME_TIMING_H__
@@ -66,120 +66,192 @@ namespace sdm {
 
 std::atomic<hwc2_layer_t> HWCLayer::next_id_(1);
 
-DisplayError SetCSC(const private_handle_t *handle, ColorMetaData *color_metadata) {
-  int err = getMetaData(const_cast<private_handle_t *>(handle), GET_COLOR_METADATA, color_metadata);
+// Reads all entries with a single metadata mapping. Uses the cached mapping when
+// the caller holds one, otherwise maps through the handle.
+static void FetchMetaData(const private_handle_t *handle, MetaData_t *metadata,
+                          MetaDataFetchEntry *entries, uint32_t count) {
+  if (metadata) {
+    getMetaDataBatchVa(metadata, entries, count);
+  } else {
+    getMetaDataBatch(const_cast<private_handle_t *>(handle), entries, count);
+  }
+}
+
+// Reads what SetCSC resolves the color metadata from, with a single metadata mapping.
+static void FetchCSC(const private_handle_t *handle, MetaData_t *metadata, BufferCSC *csc) {
+  MetaDataFetchEntry entries[] = {
+    {GET_COLOR_METADATA, &csc->color_metadata, -EINVAL},
+    {GET_COLOR_SPACE, &csc->color_space, -EINVAL},
+  };
+  FetchMetaData(handle, metadata, entries, UINT32(sizeof(entries) / sizeof(entries[0])));
+  csc->color_metadata_status = entries[0].status;
+  csc->color_space_status = entries[1].status;
+}
 
-  if (err != 0) {
-    ColorSpace_t csc = ITU_R_601;
-    err = getMetaData(const_cast<private_handle_t *>(handle),  GET_COLOR_SPACE, &csc);
+static DisplayError ApplyCSC(const BufferCSC &csc, ColorMetaData *color_metadata) {
+  if (csc.color_metadata_status == 0) {
+    *color_metadata = csc.color_metadata;
+    return kErrorNone;
+  }
 
-    if (err == 0) {
-      if (csc == ITU_R_601_FR || csc == ITU_R_2020_FR) {
-        color_metadata->range = Range_Full;
-      }
-      color_metadata->transfer = Transfer_sRGB;
-
-      switch (csc) {
-        case ITU_R_601:
-        case ITU_R_601_FR:
-          // video and display driver uses 601_525
-          color_metadata->colorPrimaries = ColorPrimaries_BT601_6_525;
-          break;
-        case ITU_R_709:
-          color_metadata->colorPrimaries = ColorPrimaries_BT709_5;
-          break;
-        case ITU_R_2020:
-        case ITU_R_2020_FR:
-          color_metadata->colorPrimaries = ColorPrimaries_BT2020;
-          break;
-        default:
-          DLOGE("Unsupported CSC: %d", csc);
-          return kErrorNotSupported;
-      }
+  if (csc.color_space_status == 0) {
+    if (csc.color_space == ITU_R_601_FR || csc.color_space == ITU_R_2020_FR) {
+      color_metadata->range = Range_Full;
+    }
+    color_metadata->transfer = Transfer_sRGB;
+
+    switch (csc.color_space) {
+      case ITU_R_601:
+      case ITU_R_601_FR:
+        // video and display driver uses 601_525
+        color_metadata->colorPrimaries = ColorPrimaries_BT601_6_525;
+        break;
+      case ITU_R_709:
+        color_metadata->colorPrimaries = ColorPrimaries_BT709_5;
+        break;
+      case ITU_R_2020:
+      case ITU_R_2020_FR:
+        color_metadata->colorPrimaries = ColorPrimaries_BT2020;
+        break;
+      default:
+        DLOGE("Unsupported CSC: %d", csc.color_space);
+        return kErrorNotSupported;
     }
   }
 
   return kErrorNone;
 }
 
-// Returns true when color primary is supported
-bool GetColorPrimary(const int32_t &dataspace, ColorPrimaries *color_primary) {
-  auto standard = dataspace & HAL_DATASPACE_STANDARD_MASK;
-  bool supported_csc = true;
-  switch (standard) {
-    case  HAL_DATASPACE_STANDARD_BT709:
-      *color_primary = ColorPrimaries_BT709_5;
-      break;
+DisplayError SetCSC(const private_handle_t *handle, ColorMetaData *color_metadata) {
+  BufferCSC csc = {};
+  FetchCSC(handle, nullptr, &csc);
+  return ApplyCSC(csc, color_metadata);
+}
+
+// One field of a dataspace translated to SDM color metadata. A negative value leaves the
+// metadata untouched, a value that is not supported is still reported, as for extended range.
+struct DataspaceField {
+  int32_t value;
+  bool supported;
+};
+
+static constexpr DataspaceField kUnknownField = {-1, false};
+
+static constexpr DataspaceField StandardToPrimaries(uint32_t standard) {
+  switch (standard << HAL_DATASPACE_STANDARD_SHIFT) {
+    case HAL_DATASPACE_STANDARD_BT709:
+      return {ColorPrimaries_BT709_5, true};
     case HAL_DATASPACE_STANDARD_BT601_525:
     case HAL_DATASPACE_STANDARD_BT601_525_UNADJUSTED:
-      *color_primary = ColorPrimaries_BT601_6_525;
-      break;
+      return {ColorPrimaries_BT601_6_525, true};
     case HAL_DATASPACE_STANDARD_BT601_625:
     case HAL_DATASPACE_STANDARD_BT601_625_UNADJUSTED:
-      *color_primary = ColorPrimaries_BT601_6_625;
-      break;
+      return {ColorPrimaries_BT601_6_625, true};
     case HAL_DATASPACE_STANDARD_DCI_P3:
-      *color_primary = ColorPrimaries_DCIP3;
-      break;
+      return {ColorPrimaries_DCIP3, true};
     case HAL_DATASPACE_STANDARD_BT2020:
-      *color_primary = ColorPrimaries_BT2020;
-      break;
+      return {ColorPrimaries_BT2020, true};
     default:
-      DLOGW_IF(kTagClient, "Unsupported Standard Request = %d", standard);
-      supported_csc = false;
+      return kUnknownField;
   }
-  return supported_csc;
 }
 
-bool GetTransfer(const int32_t &dataspace, GammaTransfer *gamma_transfer) {
-  auto transfer = dataspace & HAL_DATASPACE_TRANSFER_MASK;
-  bool supported_transfer = true;
-  switch (transfer) {
+static constexpr DataspaceField TransferToGamma(uint32_t transfer) {
+  switch (transfer << HAL_DATASPACE_TRANSFER_SHIFT) {
     case HAL_DATASPACE_TRANSFER_SRGB:
-      *gamma_transfer = Transfer_sRGB;
-      break;
+      return {Transfer_sRGB, true};
     case HAL_DATASPACE_TRANSFER_SMPTE_170M:
-      *gamma_transfer = Transfer_SMPTE_170M;
-      break;
+      return {Transfer_SMPTE_170M, true};
     case HAL_DATASPACE_TRANSFER_ST2084:
-      *gamma_transfer = Transfer_SMPTE_ST2084;
-      break;
+      return {Transfer_SMPTE_ST2084, true};
     case HAL_DATASPACE_TRANSFER_HLG:
-      *gamma_transfer = Transfer_HLG;
-      break;
+      return {Transfer_HLG, true};
     case HAL_DATASPACE_TRANSFER_LINEAR:
-      *gamma_transfer = Transfer_Linear;
-      break;
+      return {Transfer_Linear, true};
     case HAL_DATASPACE_TRANSFER_GAMMA2_2:
-      *gamma_transfer = Transfer_Gamma2_2;
-      break;
+      return {Transfer_Gamma2_2, true};
     case HAL_DATASPACE_TRANSFER_GAMMA2_8:
-      *gamma_transfer = Transfer_Gamma2_8;
-      break;
+      return {Transfer_Gamma2_8, true};
     default:
-      DLOGW_IF(kTagClient, "Unsupported Transfer Request = %d", transfer);
-      supported_transfer = false;
+      return kUnknownField;
   }
-  return supported_transfer;
 }
 
-bool GetRange(const int32_t &dataspace, ColorRange *color_range) {
-  auto range = dataspace & HAL_DATASPACE_RANGE_MASK;
-  switch (range) {
+static constexpr DataspaceField RangeToColorRange(uint32_t range) {
+  switch (range << HAL_DATASPACE_RANGE_SHIFT) {
     case HAL_DATASPACE_RANGE_FULL:
-      *color_range = Range_Full;
-      break;
+      return {Range_Full, true};
     case HAL_DATASPACE_RANGE_LIMITED:
-      *color_range = Range_Limited;
-      break;
+      return {Range_Limited, true};
     case HAL_DATASPACE_RANGE_EXTENDED:
-      *color_range = Range_Extended;
-      return false;
+      return {Range_Extended, false};
     default:
-      DLOGW_IF(kTagClient, "Unsupported Range Request = %d", range);
-      return false;
+      return kUnknownField;
   }
-  return true;
+}
+
+// Lookup tables over every value of a dataspace field, indexed by the field shifted down.
+template <uint32_t mask, uint32_t shift>
+struct DataspaceTable {
+  static constexpr uint32_t kSize = (mask >> shift) + 1;
+
+  constexpr explicit DataspaceTable(DataspaceField (*translate)(uint32_t)) : fields() {
+    for (uint32_t i = 0; i < kSize; i++) {
+      fields[i] = translate(i);
+    }
+  }
+  constexpr const DataspaceField &Get(int32_t dataspace) const {
+    return fields[(UINT32(dataspace) & mask) >> shift];
+  }
+
+  DataspaceField fields[kSize];
+};
+
+static constexpr DataspaceTable<HAL_DATASPACE_STANDARD_MASK, HAL_DATASPACE_STANDARD_SHIFT>
+    kPrimariesTable(StandardToPrimaries);
+static constexpr DataspaceTable<HAL_DATASPACE_TRANSFER_MASK, HAL_DATASPACE_TRANSFER_SHIFT>
+    kTransferTable(TransferToGamma);
+static constexpr DataspaceTable<HAL_DATASPACE_RANGE_MASK, HAL_DATASPACE_RANGE_SHIFT>
+    kRangeTable(RangeToColorRange);
+
+static_assert(kPrimariesTable.Get(HAL_DATASPACE_V0_SRGB).value == ColorPrimaries_BT709_5,
+              "sRGB maps to BT709 primaries");
+static_assert(kTransferTable.Get(HAL_DATASPACE_BT2020_PQ).value == Transfer_SMPTE_ST2084,
+              "BT2020 PQ maps to the ST2084 transfer");
+static_assert(!kRangeTable.Get(HAL_DATASPACE_RANGE_EXTENDED).supported,
+              "extended range is reported but not supported");
+
+// Returns true when color primary is supported
+bool GetColorPrimary(const int32_t &dataspace, ColorPrimaries *color_primary) {
+  const DataspaceField &field = kPrimariesTable.Get(dataspace);
+  if (field.value < 0) {
+    DLOGW_IF(kTagClient, "Unsupported Standard Request = %d",
+             dataspace & HAL_DATASPACE_STANDARD_MASK);
+    return false;
+  }
+  *color_primary = static_cast<ColorPrimaries>(field.value);
+  return field.supported;
+}
+
+bool GetTransfer(const int32_t &dataspace, GammaTransfer *gamma_transfer) {
+  const DataspaceField &field = kTransferTable.Get(dataspace);
+  if (field.value < 0) {
+    DLOGW_IF(kTagClient, "Unsupported Transfer Request = %d",
+             dataspace & HAL_DATASPACE_TRANSFER_MASK);
+    return false;
+  }
+  *gamma_transfer = static_cast<GammaTransfer>(field.value);
+  return field.supported;
+}
+
+bool GetRange(const int32_t &dataspace, ColorRange *color_range) {
+  const DataspaceField &field = kRangeTable.Get(dataspace);
+  if (field.value < 0) {
+    DLOGW_IF(kTagClient, "Unsupported Range Request = %d", dataspace & HAL_DATASPACE_RANGE_MASK);
+    return false;
+  }
+  *color_range = static_cast<ColorRange>(field.value);
+  return field.supported;
 }
 
 bool IsHdr(const ColorPrimaries &color_primary, const GammaTransfer &gamma_transfer) {
@@ -350,6 +422,7 @@ HWCLayer::HWCLayer(hwc2_display_t display_id, HWCBufferAllocator *buf_allocator)
 HWCLayer::~HWCLayer() {
   // Close any fences left for this layer
   release_fence_ = nullptr;
+  ReleaseMetaDataMapping();
   if (layer_) {
     if (buffer_fd_ >= 0) {
       ::close(buffer_fd_);
@@ -394,6 +467,12 @@ HWC2::Error HWCLayer::SetLayerBuffer(buffer_handle_t buffer, shared_ptr<Fence> a
   layer_buffer->unaligned_height = UINT32(handle->unaligned_height);
 
   layer_buffer->flags.video = (handle->buffer_type == BUFFER_TYPE_VIDEO) ? true : false;
+  buffer_generation_++;
+  if (!metadata_ || (metadata_buffer_id_ != handle->id)) {
+    ReleaseMetaDataMapping();
+    metadata_ = acquireMetaDataMapping(const_cast<private_handle_t *>(handle));
+    metadata_buffer_id_ = metadata_ ? handle->id : 0;
+  }
   if (SetMetaData(handle, layer_) != kErrorNone) {
     return HWC2::Error::BadLayer;
   }
@@ -536,6 +615,9 @@ HWC2::Error HWCLayer::SetLayerDataspace(int32_t dataspace) {
   if (dataspace_ != dataspace) {
     geometry_changes_ |= kDataspace;
     dataspace_ = dataspace;
+    dataspace_csc_valid_ = GetColorPrimary(dataspace_, &dataspace_primaries_) &&
+                           GetTransfer(dataspace_, &dataspace_transfer_) &&
+                           GetRange(dataspace_, &dataspace_range_);
     if (layer_->input_buffer.buffer_id) {
       ValidateAndSetCSC(reinterpret_cast<private_handle_t *>(layer_->input_buffer.buffer_id));
     }
@@ -1019,14 +1101,26 @@ DisplayError HWCLayer::SetMetaData(const private_handle_t *pvt_handle, Layer *la
   name_ = name;
 
   float fps = 0;
+  int32_t interlaced = 0;
+  uint32_t linear_format = 0;
+  struct UBWCStats cr_stats[NUM_UBWC_CR_STATS_LAYERS] = {};
+  uint32_t single_buffer = 0;
+  enum { kRefreshRate, kInterlaced, kLinearFormat, kUbwcCrStats, kSingleBuffer, kFetchMax };
+  MetaDataFetchEntry entries[kFetchMax] = {
+    {GET_REFRESH_RATE, &fps, -EINVAL},
+    {GET_PP_PARAM_INTERLACED, &interlaced, -EINVAL},
+    {GET_LINEAR_FORMAT, &linear_format, -EINVAL},
+    {GET_UBWC_CR_STATS_INFO, cr_stats, -EINVAL},
+    {GET_SINGLE_BUFFER_MODE, &single_buffer, -EINVAL},
+  };
+  FetchMetaData(handle, metadata_, entries, kFetchMax);
+
   uint32_t frame_rate = layer->frame_rate;
-  if (getMetaData(handle, GET_REFRESH_RATE, &fps) == 0) {
+  if (entries[kRefreshRate].status == 0) {
     frame_rate = (fps != 0) ? RoundToStandardFPS(fps) : layer->frame_rate;
     has_metadata_refresh_rate_ = true;
   }
 
-  int32_t interlaced = 0;
-  getMetaData(handle, GET_PP_PARAM_INTERLACED, &interlaced);
   bool interlace = interlaced ? true : false;
 
   if (interlace != layer_buffer->flags.interlace) {
@@ -1034,8 +1128,7 @@ DisplayError HWCLayer::SetMetaData(const private_handle_t *pvt_handle, Layer *la
           layer_buffer->flags.interlace, interlace);
   }
 
-  uint32_t linear_format = 0;
-  if (getMetaData(handle, GET_LINEAR_FORMAT, &linear_format) == 0) {
+  if (entries[kLinearFormat].status == 0) {
     layer_buffer->format = GetSDMFormat(INT32(linear_format), 0);
   }
 
@@ -1047,19 +1140,15 @@ DisplayError HWCLayer::SetMetaData(const private_handle_t *pvt_handle, Layer *la
   }
 
   // Check if metadata is set
-  struct UBWCStats cr_stats[NUM_UBWC_CR_STATS_LAYERS] = {};
-
   for (int i = 0; i < NUM_UBWC_CR_STATS_LAYERS; i++) {
     layer_buffer->ubwc_crstats[i].clear();
   }
 
-  if (getMetaData(handle, GET_UBWC_CR_STATS_INFO, cr_stats) == 0) {
+  if (entries[kUbwcCrStats].status == 0) {
     // Only copy top layer for now as only top field for interlaced is used
     GetUBWCStatsFromMetaData(&cr_stats[0], &(layer_buffer->ubwc_crstats[0]));
   }
 
-  uint32_t single_buffer = 0;
-  getMetaData(const_cast<private_handle_t *>(handle), GET_SINGLE_BUFFER_MODE, &single_buffer);
   single_buffer_ = (single_buffer == 1);
 
   // Handle colorMetaData / Dataspace handling now
@@ -1094,6 +1183,14 @@ DisplayError HWCLayer::SetMetaData(const private_handle_t *pvt_handle, Layer *la
   return kErrorNone;
 }
 
+void HWCLayer::ReleaseMetaDataMapping() {
+  if (metadata_) {
+    releaseMetaDataMapping(metadata_buffer_id_);
+    metadata_ = nullptr;
+    metadata_buffer_id_ = 0;
+  }
+}
+
 bool HWCLayer::IsDataSpaceSupported() {
   if (client_requested_ != HWC2::Composition::Device &&
       client_requested_ != HWC2::Composition::Cursor) {
@@ -1107,24 +1204,22 @@ bool HWCLayer::IsDataSpaceSupported() {
 void HWCLayer::ValidateAndSetCSC(const private_handle_t *handle) {
   LayerBuffer *layer_buffer = &layer_->input_buffer;
   bool use_color_metadata = true;
-  ColorMetaData csc = {};
   if (dataspace_ != HAL_DATASPACE_UNKNOWN) {
     use_color_metadata = false;
-    bool valid_csc = GetSDMColorSpace(dataspace_, &csc);
-    if (!valid_csc) {
+    if (!dataspace_csc_valid_) {
       dataspace_supported_ = false;
       return;
     }
 
-    if (layer_buffer->color_metadata.transfer != csc.transfer ||
-       layer_buffer->color_metadata.colorPrimaries != csc.colorPrimaries ||
-       layer_buffer->color_metadata.range != csc.range) {
+    if (layer_buffer->color_metadata.transfer != dataspace_transfer_ ||
+       layer_buffer->color_metadata.colorPrimaries != dataspace_primaries_ ||
+       layer_buffer->color_metadata.range != dataspace_range_) {
         // ColorMetadata updated. Needs validate.
         layer_->update_mask.set(kMetadataUpdate);
         // if we are here here, update the sdm layer csc.
-        layer_buffer->color_metadata.transfer = csc.transfer;
-        layer_buffer->color_metadata.colorPrimaries = csc.colorPrimaries;
-        layer_buffer->color_metadata.range = csc.range;
+        layer_buffer->color_metadata.transfer = dataspace_transfer_;
+        layer_buffer->color_metadata.colorPrimaries = dataspace_primaries_;
+        layer_buffer->color_metadata.range = dataspace_range_;
     }
   }
 
@@ -1136,7 +1231,14 @@ void HWCLayer::ValidateAndSetCSC(const private_handle_t *handle) {
 
   if (use_color_metadata) {
     ColorMetaData new_metadata = layer_buffer->color_metadata;
-    if (sdm::SetCSC(handle, &new_metadata) == kErrorNone) {
+    // A single buffer is written while on screen, so its metadata may change at any time.
+    if (single_buffer_ || csc_buffer_id_ != handle->id || csc_generation_ != buffer_generation_) {
+      MetaData_t *metadata = (metadata_buffer_id_ == handle->id) ? metadata_ : nullptr;
+      FetchCSC(handle, metadata, &buffer_csc_);
+      csc_buffer_id_ = handle->id;
+      csc_generation_ = buffer_generation_;
+    }
+    if (ApplyCSC(buffer_csc_, &new_metadata) == kErrorNone) {
       // If dataspace is KNOWN, overwrite the gralloc metadata CSC using the previously derived CSC
       // from dataspace.
       if (dataspace_ != HAL_DATASPACE_UNKNOWN) {
@@ -30,7 +30,9 @@
  */
 
 #include "gr_utils.h"
+#include <errno.h>
 #include <QtiGralloc.h>
+#include <qdMetaDataBatch.h>
 #include <core/layer_stack.h>
 #include <core/layer_buffer.h>
 #include <utils/utils.h>
@@ -55,6 +57,14 @@ using android::hardware::graphics::common::V1_2::Dataspace;
 
 namespace sdm {
 
+// Gralloc metadata SetCSC resolves the color metadata of a buffer from.
+struct BufferCSC {
+  int color_metadata_status = -EINVAL;
+  ColorMetaData color_metadata = {};
+  int color_space_status = -EINVAL;
+  ColorSpace_t color_space = ITU_R_601;
+};
+
 DisplayError SetCSC(const private_handle_t *pvt_handle, ColorMetaData *color_metadata);
 bool GetColorPrimary(const int32_t &dataspace, ColorPrimaries *color_primary);
 bool GetTransfer(const int32_t &dataspace, GammaTransfer *gamma_transfer);
@@ -159,6 +169,20 @@ class HWCLayer {
   bool secure_ = false;
   bool compatible_ = false;
   bool ignore_sdr_content_md_ = false;
+  // Cached metadata mapping of the current buffer, shared across layers via buffer id
+  MetaData_t *metadata_ = nullptr;
+  uint64_t metadata_buffer_id_ = 0;
+  // Color space of dataspace_, resolved when the dataspace changes
+  bool dataspace_csc_valid_ = false;
+  ColorPrimaries dataspace_primaries_ = ColorPrimaries_BT709_5;
+  GammaTransfer dataspace_transfer_ = Transfer_sRGB;
+  ColorRange dataspace_range_ = Range_Full;
+  // Color metadata read for a buffer id. Producers only update the metadata before queueing,
+  // so it stays valid until the next SetLayerBuffer, which bumps buffer_generation_.
+  uint64_t buffer_generation_ = 0;
+  uint64_t csc_buffer_id_ = 0;
+  uint64_t csc_generation_ = 0;
+  BufferCSC buffer_csc_ = {};
 #ifdef UDFPS_ZPOS
   bool fod_pressed_ = false;
 #endif
@@ -178,6 +202,7 @@ class HWCLayer {
   DisplayError SetMetaData(const private_handle_t *pvt_handle, Layer *layer);
   uint32_t RoundToStandardFPS(float fps);
   void ValidateAndSetCSC(const private_handle_t *handle);
+  void ReleaseMetaDataMapping();
   void SetDirtyRegions(hwc_region_t surface_damage);
 };
 
@@ -40,6 +40,7 @@
 #include <utils/debug.h>
 #include <QService.h>
 #include <utils/utils.h>
+#include <utils/worker_pool.h>
 #include <algorithm>
 #include <utility>
 #include <bitset>
@@ -52,6 +53,9 @@
 #include "hwc_buffer_allocator.h"
 #include "hwc_session.h"
 #include "hwc_debugger.h"
+#include "hwc_frame_dumper.h"
+#include "hwc_command_recorder.h"
+#include "hwc_frame_timing.h"
 #include "ipc_impl.h"
 
 #define __CLASS__ "HWCSession"
@@ -76,6 +80,9 @@ std::mutex HWCSession::command_seq_mutex_;
 static const int kSolidFillDelay = 100 * 1000;
 static const uint32_t kBrightnessScaleMax = 100;
 static const uint32_t kSvBlScaleMax = 65535;
+static const size_t kLockSitesDumped = 10;
+// Longest dumpsys waits for a display lock before it skips that display's layer dump.
+static const uint32_t kDumpLockTimeoutMs = 5;
 Locker HWCSession::vm_release_locker_[HWCCallbacks::kNumDisplays];
 std::bitset<HWCCallbacks::kNumDisplays> HWCSession::clients_waiting_for_vm_release_;
 std::set<hwc2_display_t> HWCSession::active_displays_;
@@ -155,7 +162,24 @@ void HWCUEvent::Register(HWCUEventListener *uevent_listener) {
   uevent_listener_ = uevent_listener;
 }
 
-HWCSession::HWCSession() : cwb_(this) {}
+HWCSession::HWCSession() : cwb_(this) {
+  // The lockers are static, but nothing takes them before the session exists.
+  int value = 0;
+  HWCDebugHandler::Get()->GetProperty(ENABLE_LOCK_PI_PROP, &value);
+  if (value) {
+    for (int id = 0; id < HWCCallbacks::kNumDisplays; id++) {
+      locker_[id].EnablePriorityInheritance();
+      hdr_locker_[id].EnablePriorityInheritance();
+      vm_release_locker_[id].EnablePriorityInheritance();
+    }
+    display_config_locker_.EnablePriorityInheritance();
+    DLOGI("Priority inheritance enabled on display locks");
+  }
+
+  value = 0;
+  HWCDebugHandler::Get()->GetProperty(ENABLE_LOCK_STATS_PROP, &value);
+  LockSite::EnableStats(value != 0);
+}
 
 HWCSession *HWCSession::GetInstance() {
   // executed only once for the very first call.
@@ -263,6 +287,10 @@ void HWCSession::PostInit() {
 }
 
 int HWCSession::Deinit() {
+  // Let deferred hotplug and power reset work finish before the displays it touches go away.
+  WorkerPool::GetInstance()->Drain(kLaneHotplug);
+  WorkerPool::GetInstance()->Drain(kLaneDisplayReset);
+
   // Destroy all connected displays
   DestroyDisplay(&map_info_primary_);
 
@@ -531,12 +559,32 @@ void HWCSession::Dump(uint32_t *out_size, char *out_buffer) {
   } else {
     std::ostringstream os;
     for (int id = 0; id < HWCCallbacks::kNumRealDisplays; id++) {
-      SCOPE_LOCK(locker_[id]);
-      if (hwc_display_[id]) {
+      HWCDisplayTelemetry telemetry;
+      display_telemetry_[id].Read(&telemetry);
+      if (telemetry.valid) {
+        DumpTelemetry(id, telemetry, &os);
+        HWCFrameTimingRing::Get(UINT64(id))->Dump(&os);
+      }
+    }
+
+    // The telemetry above is read without locks, so it is there even when a display lock is held
+    // for long. The full layer dump follows for each display whose lock is free within a bound,
+    // dumpsys never waits out a long commit.
+    for (int id = 0; id < HWCCallbacks::kNumRealDisplays; id++) {
+      TIMED_SCOPE_LOCK(locker_[id], kDumpLockTimeoutMs);
+      if (!lock.IsLocked()) {
+        os << "\nDisplay " << id << " busy, layer dump skipped\n";
+      } else if (hwc_display_[id]) {
         hwc_display_[id]->Dump(&os);
       }
     }
     Fence::Dump(&os);
+    WorkerPool::GetInstance()->Dump(&os);
+    HWCFrameDumper::GetInstance()->Dump(&os);
+    HWCCommandRecorder::GetInstance()->Dump(&os);
+    if (LockSite::StatsEnabled()) {
+      LockSite::Dump(&os, kLockSitesDumped);
+    }
 
     std::string s = os.str();
     auto copied = s.copy(out_buffer, std::min(s.size(), max_dump_size), 0);
@@ -553,6 +601,12 @@ uint32_t HWCSession::GetMaxVirtualDisplayCount() {
 }
 
 int32_t HWCSession::GetActiveConfig(hwc2_display_t display, hwc2_config_t *out_config) {
+  HWCDisplayConfigSnapshot snapshot;
+  if (out_config && ReadConfigSnapshot(display, &snapshot)) {
+    *out_config = snapshot.active_config;
+    return HWC2_ERROR_NONE;
+  }
+
   return CallDisplayFunction(display, &HWCDisplay::GetActiveConfig, out_config);
 }
 
@@ -578,6 +632,13 @@ int32_t HWCSession::GetColorModes(hwc2_display_t display, uint32_t *out_num_mode
   if (out_num_modes == nullptr) {
     return HWC2_ERROR_BAD_PARAMETER;
   }
+
+  HWCDisplayConfigSnapshot snapshot;
+  if (ReadConfigSnapshot(display, &snapshot)) {
+    snapshot.GetColorModes(out_num_modes, out_modes);
+    return HWC2_ERROR_NONE;
+  }
+
   return CallDisplayFunction(display, &HWCDisplay::GetColorModes, out_num_modes, out_modes);
 }
 
@@ -594,6 +655,14 @@ int32_t HWCSession::GetRenderIntents(hwc2_display_t display, int32_t /*ColorMode
     DLOGE("Invalid ColorMode: %d", mode);
     return HWC2_ERROR_BAD_PARAMETER;
   }
+
+  // Unsupported modes take the locked path, display types report them differently.
+  HWCDisplayConfigSnapshot snapshot;
+  if (ReadConfigSnapshot(display, &snapshot) &&
+      snapshot.GetRenderIntents(mode, out_num_intents, out_intents)) {
+    return HWC2_ERROR_NONE;
+  }
+
   return CallDisplayFunction(display, &HWCDisplay::GetRenderIntents, mode, out_num_intents,
                              out_intents);
 }
@@ -675,12 +744,26 @@ int32_t HWCSession::GetDisplayAttribute(hwc2_display_t display, hwc2_config_t co
   if (out_value == nullptr) {
     return HWC2_ERROR_BAD_PARAMETER;
   }
+
+  // Unknown configs and attributes take the locked path for the error handling.
+  HWCDisplayConfigSnapshot snapshot;
+  if (ReadConfigSnapshot(display, &snapshot) &&
+      snapshot.GetDisplayAttribute(config, attribute, out_value)) {
+    return HWC2_ERROR_NONE;
+  }
+
   return CallDisplayFunction(display, &HWCDisplay::GetDisplayAttribute, config, attribute,
                              out_value);
 }
 
 int32_t HWCSession::GetDisplayConfigs(hwc2_display_t display, uint32_t *out_num_configs,
                                       hwc2_config_t *out_configs) {
+  HWCDisplayConfigSnapshot snapshot;
+  if (out_num_configs && ReadConfigSnapshot(display, &snapshot)) {
+    snapshot.GetDisplayConfigs(out_num_configs, out_configs);
+    return HWC2_ERROR_NONE;
+  }
+
   return CallDisplayFunction(display, &HWCDisplay::GetDisplayConfigs, out_num_configs,
                              out_configs);
 }
@@ -705,6 +788,14 @@ int32_t HWCSession::GetHdrCapabilities(hwc2_display_t display, uint32_t* out_num
                                        int32_t* out_types, float* out_max_luminance,
                                        float* out_max_average_luminance,
                                        float* out_min_luminance) {
+  HWCDisplayConfigSnapshot snapshot;
+  if (out_num_types && out_max_luminance && out_max_average_luminance && out_min_luminance &&
+      ReadConfigSnapshot(display, &snapshot)) {
+    snapshot.GetHdrCapabilities(out_num_types, out_types, out_max_luminance,
+                                out_max_average_luminance, out_min_luminance);
+    return HWC2_ERROR_NONE;
+  }
+
   return CallDisplayFunction(display, &HWCDisplay::GetHdrCapabilities, out_num_types, out_types,
                              out_max_luminance, out_max_average_luminance, out_min_luminance);
 }
@@ -729,6 +820,11 @@ void HWCSession::PerformQsyncCallback(hwc2_display_t display, bool qsync_enabled
     }
   }
 
+  DisplayConfig::DisplayStatus status;
+  status.qsync_enabled = qsync_enabled;
+  status.qsync_refresh_rate = qsync_refresh_rate;
+  PublishDisplayStatus(display, DisplayConfig::kStatusQsync, status);
+
   // HIDL callback
   std::shared_ptr<DisplayConfig::ConfigCallback> callback = qsync_callback_.lock();
   if (!callback) {
@@ -857,8 +953,50 @@ int32_t HWCSession::PresentDisplay(hwc2_display_t display, shared_ptr<Fence> *ou
   return INT32(status);
 }
 
+void HWCSession::DumpTelemetry(hwc2_display_t display, const HWCDisplayTelemetry &telemetry,
+                               std::ostringstream *os) {
+  int64_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+  uint32_t fps = telemetry.avg_frame_interval_ns ?
+                 UINT32(1000000000LL / telemetry.avg_frame_interval_ns) : 0;
+
+  *os << "\n------------HWC----------------\n";
+  *os << "HWC2 display_id: " << display << " sdm_id: " << telemetry.sdm_id;
+  *os << " type: " << telemetry.type << " power mode: " << telemetry.power_mode;
+  *os << " active config: " << telemetry.active_config;
+  *os << " refresh rate: " << telemetry.refresh_rate << std::endl;
+  *os << "frames: " << telemetry.frame_count << " fps: " << fps;
+  *os << " last commit: " << (now - telemetry.last_commit_ns) / 1000000 << " ms ago" << std::endl;
+  *os << "layers: " << telemetry.num_layers << " device: " << telemetry.num_device_layers;
+  *os << " client: " << telemetry.num_client_layers;
+  *os << " solid fill: " << telemetry.num_solid_fill_layers;
+  *os << " cursor: " << telemetry.num_cursor_layers;
+  *os << " secure: " << telemetry.num_secure_layers;
+  *os << " client target: " << telemetry.client_target_used;
+  *os << " (" << telemetry.client_composed_frames << " frames)" << std::endl;
+  *os << "prepare: " << telemetry.prepare_us << " us (max " << telemetry.max_prepare_us << ")";
+  *os << " commit: " << telemetry.commit_us << " us (max " << telemetry.max_commit_us << ")";
+  *os << std::endl;
+}
+
 void HWCSession::PostCommitLocked(hwc2_display_t display, shared_ptr<Fence> &retire_fence) {
   PerformIdleStatusCallback(display);
+  cwb_.StreamPresentDone(display);
+  display_telemetry_[display].Write(hwc_display_[display]->GetTelemetry());
+
+  // Pending configs are applied and refresh rates switched as part of commits.
+  hwc2_config_t active_config = 0;
+  hwc_display_[display]->GetActiveConfig(&active_config);
+  if (!config_snapshot_built_[display] || active_config != config_snapshot_active_[display]) {
+    UpdateConfigSnapshot(display);
+  }
+
+  // Republished only when one of the values changed.
+  DisplayConfig::DisplayStatus status;
+  hwc_display_[display]->GetActiveDisplayConfig(&status.active_config);
+  status.refresh_rate = hwc_display_[display]->GetTelemetry().refresh_rate;
+  status.idle = hwc_display_[display]->IsDisplayIdle();
+  PublishDisplayStatus(display, DisplayConfig::kStatusActiveConfig |
+                       DisplayConfig::kStatusRefreshRate | DisplayConfig::kStatusIdle, status);
 
   if (clients_waiting_for_commit_[display].any()) {
     retire_fence_[display] = retire_fence;
@@ -867,6 +1005,52 @@ void HWCSession::PostCommitLocked(hwc2_display_t display, shared_ptr<Fence> &ret
   }
 }
 
+void HWCSession::UpdateConfigSnapshot(hwc2_display_t display) {
+  HWCDisplayConfigSnapshot snapshot;
+  hwc_display_[display]->GetConfigSnapshot(&snapshot);
+  config_snapshot_[display].Write(snapshot);
+  config_snapshot_built_[display] = true;
+  hwc_display_[display]->GetActiveConfig(&config_snapshot_active_[display]);
+}
+
+void HWCSession::InvalidateConfigSnapshot(hwc2_display_t display) {
+  config_snapshot_[display].Write(HWCDisplayConfigSnapshot());
+  config_snapshot_built_[display] = false;
+}
+
+bool HWCSession::ReadConfigSnapshot(hwc2_display_t display, HWCDisplayConfigSnapshot *snapshot) {
+  if (display >= HWCCallbacks::kNumDisplays) {
+    return false;
+  }
+
+  config_snapshot_[display].Read(snapshot);
+  return snapshot->valid;
+}
+
+void HWCSession::PublishDisplayStatus(hwc2_display_t display, uint32_t fields,
+                                      const DisplayConfig::DisplayStatus &status) {
+  // Status page slots follow the DisplayConfig display types, other displays are not published.
+  int disp_id = -1;
+  if (display == map_info_primary_.client_id) {
+    disp_id = qdutils::DISPLAY_PRIMARY;
+  } else if (map_info_pluggable_.size() && display == map_info_pluggable_[0].client_id) {
+    disp_id = qdutils::DISPLAY_EXTERNAL;
+  } else if (map_info_virtual_.size() && display == map_info_virtual_[0].client_id) {
+    disp_id = qdutils::DISPLAY_VIRTUAL;
+  } else if (map_info_builtin_.size() && display == map_info_builtin_[0].client_id) {
+    disp_id = qdutils::DISPLAY_BUILTIN_2;
+  } else {
+    return;
+  }
+
+  int error = DisplayConfig::PublishDisplayStatus(GetDisplayConfigDisplayType(disp_id), fields,
+                                                  status);
+  if (error) {
+    DLOGV_IF(kTagClient, "Failed to publish status of display %" PRIu64 ", error = %d", display,
+             error);
+  }
+}
+
 void HWCSession::PostCommitUnlocked(hwc2_display_t display, const shared_ptr<Fence> &retire_fence,
                                     HWC2::Error status) {
   HandlePendingPowerMode(display, retire_fence);
@@ -988,7 +1172,7 @@ void HWCSession::RegisterCallback(int32_t descriptor, hwc2_callback_data_t callb
 }
 
 int32_t HWCSession::SetActiveConfig(hwc2_display_t display, hwc2_config_t config) {
-  return CallDisplayFunction(display, &HWCDisplay::SetActiveConfig, config);
+  return CallDisplayConfigFunction(display, &HWCDisplay::SetActiveConfig, config);
 }
 
 int32_t HWCSession::SetClientTarget(hwc2_display_t display, buffer_handle_t target,
@@ -1829,6 +2013,16 @@ android::status_t HWCSession::notifyCallback(uint32_t command, const android::Pa
     }
     break;
 
+    case qService::IQService::GET_FRAME_TIMING_STATS: {
+      if (!input_parcel || !output_parcel) {
+        DLOGE("QService command = %d: input_parcel and output_parcel needed.", command);
+        break;
+      }
+      int disp_id = input_parcel->readInt32();
+      status = GetFrameTimingStats(disp_id, output_parcel);
+    }
+    break;
+
     default:
       DLOGW("QService command = %d is not supported.", command);
       break;
@@ -3106,6 +3300,8 @@ void HWCSession::DestroyPluggableDisplay(DisplayMapInfo *map_info) {
     display_ready_.reset(UINT32(client_id));
     pending_power_mode_[client_id] = false;
     hwc_display = nullptr;
+    display_telemetry_[client_id].Write(HWCDisplayTelemetry());
+    InvalidateConfigSnapshot(client_id);
     map_info->Reset();
   }
 }
@@ -3139,6 +3335,8 @@ void HWCSession::DestroyNonPluggableDisplay(DisplayMapInfo *map_info) {
     pending_power_mode_[client_id] = false;
     hwc_display = nullptr;
     display_ready_.reset(UINT32(client_id));
+    display_telemetry_[client_id].Write(HWCDisplayTelemetry());
+    InvalidateConfigSnapshot(client_id);
     map_info->Reset();
 }
 
@@ -3206,8 +3404,9 @@ void HWCSession::PerformDisplayPowerReset() {
 
 void HWCSession::DisplayPowerReset() {
   // Do Power Reset in a different thread to avoid blocking of SDM event thread
-  // when disconnecting display.
-  std::thread(&HWCSession::PerformDisplayPowerReset, this).detach();
+  // when disconnecting display. Requests arriving while one is pending are folded into it.
+  WorkerPool::GetInstance()->Post(kLaneDisplayReset, [this]() { PerformDisplayPowerReset(); },
+                                  kCoalescePowerReset);
 }
 
 void HWCSession::VmReleaseDone(hwc2_display_t display) {
@@ -3411,7 +3610,8 @@ void HWCSession::HandlePendingHotplug(hwc2_display_t disp_id,
       int32_t err = pluggable_handler_lock_.TryLock();
       if (!err) {
         // Do hotplug handling in a different thread to avoid blocking PresentDisplay.
-        std::thread(&HWCSession::HandlePluggableDisplays, this, true).detach();
+        WorkerPool::GetInstance()->Post(kLaneHotplug, [this]() { HandlePluggableDisplays(true); },
+                                        kCoalesceHotplug);
         pluggable_handler_lock_.Unlock();
       } else {
         // EBUSY means another thread is already handling hotplug. Skip deferred hotplug handling.
@@ -3606,7 +3806,15 @@ int32_t HWCSession::SetDisplayBrightness(hwc2_display_t display, float brightnes
     return HWC2_ERROR_BAD_PARAMETER;
   }
 
-  return INT32(hwc_display_[display]->SetPanelBrightness(brightness));
+  int32_t error = INT32(hwc_display_[display]->SetPanelBrightness(brightness));
+  if (error == HWC2_ERROR_NONE) {
+    // Same level scale as DisplayConfig GetPanelBrightness.
+    DisplayConfig::DisplayStatus status;
+    status.brightness_level = (brightness < 0.0f) ? 0 : UINT32(254.0f * brightness + 1);
+    PublishDisplayStatus(display, DisplayConfig::kStatusBrightness, status);
+  }
+
+  return error;
 }
 
 android::status_t HWCSession::SetQSyncMode(const android::Parcel *input_parcel) {
@@ -3823,8 +4031,8 @@ int32_t HWCSession::SetActiveConfigWithConstraints(
     return HWC2_ERROR_BAD_PARAMETER;
   }
 
-  return CallDisplayFunction(display, &HWCDisplay::SetActiveConfigWithConstraints, config,
-                             vsync_period_change_constraints, out_timeline);
+  return CallDisplayConfigFunction(display, &HWCDisplay::SetActiveConfigWithConstraints, config,
+                                   vsync_period_change_constraints, out_timeline);
 }
 
 int HWCSession::WaitForCommitDoneAsync(hwc2_display_t display, int client_id) {
@@ -4146,7 +4354,8 @@ android::status_t HWCSession::TUITransitionUnPrepare(int disp_id) {
 
   if (pending_hotplug_event_ == kHotPlugEvent) {
     // Do hotplug handling in a different thread to avoid blocking TUI thread.
-    std::thread(&HWCSession::HandlePluggableDisplays, this, true).detach();
+    WorkerPool::GetInstance()->Post(kLaneHotplug, [this]() { HandlePluggableDisplays(true); },
+                                    kCoalesceHotplug);
   }
   // Reset tui session state variable.
   tui_start_success_ = false;
@@ -4191,6 +4400,27 @@ int HWCSession::GetDispTypeFromPhysicalId(uint64_t physical_disp_id, DispType *d
   return -ENODEV;
 }
 
+android::status_t HWCSession::GetFrameTimingStats(int disp_id, android::Parcel *output_parcel) {
+  int target_display = GetDisplayIndex(disp_id);
+  if (target_display == -1) {
+    return -EINVAL;
+  }
+
+  // Read from the lock free ring, no need to hold the display lock.
+  FrameTimingPercentiles percentiles;
+  HWCFrameTimingRing::Get(UINT64(target_display))->GetPercentiles(&percentiles);
+
+  output_parcel->writeInt32(kMetricMax);
+  for (int metric = 0; metric < kMetricMax; metric++) {
+    output_parcel->writeInt32(INT32(percentiles.samples[metric]));
+    output_parcel->writeInt32(INT32(percentiles.p50[metric]));
+    output_parcel->writeInt32(INT32(percentiles.p95[metric]));
+    output_parcel->writeInt32(INT32(percentiles.p99[metric]));
+  }
+
+  return 0;
+}
+
 android::status_t HWCSession::GetDisplayPortId(uint32_t disp_id, int *port_id) {
   hwc2_display_t target_display = GetDisplayIndex(disp_id);
   if (target_display == -1) {
@@ -36,9 +36,12 @@
 #include <core/core_interface.h>
 #include <core/ipc_interface.h>
 #include <utils/locker.h>
+#include <utils/seqlock.h>
 #include <utils/constants.h>
 #include <qd_utils.h>
 #include <display_config.h>
+#include <display_config_cwb_stream.h>
+#include <display_config_status.h>
 #include <vector>
 #include <queue>
 #include <utility>
@@ -47,6 +50,7 @@
 #include <unordered_map>
 #include <string>
 #include <memory>
+#include <thread>
 #include <core/display_interface.h>
 
 #include "hwc_callbacks.h"
@@ -61,6 +65,7 @@
 #include "hwc_display_event_handler.h"
 #include "hwc_buffer_sync_handler.h"
 #include "hwc_display_virtual_factory.h"
+#include "cpu_cwb_post_process.h"
 
 using ::android::hardware::Return;
 using ::android::hardware::hidl_string;
@@ -164,6 +169,25 @@ class HWCSession : hwc2_device_t, HWCUEventListener, public qClient::BnQClient,
     return INT32(status);
   }
 
+  // Like CallDisplayFunction, for calls that may change the active config. The config snapshot
+  // is republished before the display lock is released.
+  template <typename... Args>
+  int32_t CallDisplayConfigFunction(hwc2_display_t display,
+                                    HWC2::Error (HWCDisplay::*member)(Args...), Args... args) {
+    if (display >= HWCCallbacks::kNumDisplays) {
+      return HWC2_ERROR_BAD_DISPLAY;
+    }
+
+    SCOPE_LOCK(locker_[display]);
+    auto status = HWC2::Error::BadDisplay;
+    if (hwc_display_[display]) {
+      auto hwc_display = hwc_display_[display];
+      status = (hwc_display->*member)(std::forward<Args>(args)...);
+      UpdateConfigSnapshot(display);
+    }
+    return INT32(status);
+  }
+
   template <typename... Args>
   int32_t CallLayerFunction(hwc2_display_t display, hwc2_layer_t layer,
                             HWC2::Error (HWCLayer::*member)(Args...), Args... args) {
@@ -347,7 +371,7 @@ class HWCSession : hwc2_device_t, HWCUEventListener, public qClient::BnQClient,
   static std::set<hwc2_display_t> active_displays_;
 
  private:
-  class CWB {
+  class CWB : public DisplayConfig::CwbStreamHandler {
    public:
     explicit CWB(HWCSession *hwc_session) : hwc_session_(hwc_session) { }
     void PresentDisplayDone(hwc2_display_t disp_id);
@@ -357,7 +381,58 @@ class HWCSession : hwc2_device_t, HWCUEventListener, public qClient::BnQClient,
                        hwc2_display_t display_type);
     bool IsCwbActiveOnDisplay(hwc2_display_t disp_type);
 
+    int StartCwbStream(const DisplayConfig::CwbStreamConfig &config,
+                       const std::vector<const native_handle_t *> &buffers,
+                       DisplayConfig::CwbStreamPage *page, uint32_t *stream_id) override;
+    int StopCwbStream(uint32_t stream_id) override;
+    // Called with locker_[disp_id] held after every commit of the display.
+    void StreamPresentDone(hwc2_display_t disp_id);
+
    private:
+    // Streaming session: the output buffers are set up once and filled round-robin, one per
+    // present of the display. Only one stream or queued request can use the writeback at a time.
+    struct StreamFence {
+      shared_ptr<Fence> fence = nullptr;
+      uint32_t frame = 0;
+      int32_t status = 0;
+    };
+
+    struct Stream {
+      ~Stream() {
+        for (auto buffer : buffers) {
+          native_handle_close(buffer);
+          native_handle_delete(const_cast<native_handle_t *>(buffer));
+        }
+        if (post_process) {
+          post_process->Deinit();
+        }
+        for (auto &intermediate : intermediates) {
+          allocator->FreeBuffer(&intermediate);
+        }
+      }
+
+      uint32_t id = 0;
+      hwc2_display_t display_type = HWC_DISPLAY_PRIMARY;
+      CwbConfig cwb_config = {};
+      std::vector<const native_handle_t *> buffers;
+      DisplayConfig::CwbStreamPage *page = nullptr;
+      uint32_t armed = 0;                  // buffers handed to the display so far
+      bool pending = false;                // the last armed buffer waits for a present
+      std::atomic<uint32_t> completed {0};
+      std::queue<StreamFence> fences;
+      std::mutex fence_lock;
+      std::condition_variable fence_cv;
+      bool exit = false;
+      std::thread fence_thread;
+      // Streams with a non native format have the display write intermediates[i], which the
+      // fence thread then crops, downscales and converts into buffers[i].
+      HWCBufferAllocator *allocator = nullptr;
+      std::vector<BufferInfo> intermediates;
+      std::unique_ptr<CPUCwbPostProcess> post_process;
+      GLRect roi = {};
+      uint32_t downscale = 1;
+    };
+
     struct QueueNode {
       QueueNode(std::weak_ptr<DisplayConfig::ConfigCallback> cb, const CwbConfig &cwb_conf,
                 const hidl_handle &buf, hwc2_display_t disp_type)
@@ -383,6 +458,10 @@ class HWCSession : hwc2_device_t, HWCUEventListener, public qClient::BnQClient,
     static void AsyncTask(CWB *cwb);
     static void AsyncFenceWaits(CWB *cwb);
     void NotifyCWBStatus(int status, shared_ptr<QueueNode> cwb_node);
+    int InitStreamPostProcess(const DisplayConfig::CwbStreamConfig &config, Stream *stream);
+    void ArmStream(Stream *stream, HWCDisplay *hwc_display);
+    void QueueStreamFence(Stream *stream, const StreamFence &stream_fence);
+    void StreamFenceWaits(Stream *stream);
 
     std::queue<shared_ptr<QueueNode>> queue_;
     std::queue<pair<shared_ptr<Fence>, shared_ptr<QueueNode>>> fence_wait_queue_;
@@ -394,6 +473,9 @@ class HWCSession : hwc2_device_t, HWCUEventListener, public qClient::BnQClient,
     std::mutex mutex_;
     std::condition_variable cv_;
     HWCSession *hwc_session_ = nullptr;
+    std::mutex stream_lock_;
+    std::unique_ptr<Stream> stream_;
+    uint32_t next_stream_id_ = 1;
   };
 
   class DisplayConfigImpl: public DisplayConfig::ConfigInterface {
@@ -482,6 +564,9 @@ class HWCSession : hwc2_device_t, HWCUEventListener, public qClient::BnQClient,
   static const int kVmReleaseRetry = 3;
   static const int kDenomNstoMs = 1000000;
   static const int kNumDrawCycles = 3;
+  // WorkerPool coalescing keys, equal keys pending on a lane are run once.
+  static const uint64_t kCoalesceHotplug = 1;
+  static const uint64_t kCoalescePowerReset = 2;
 
   uint32_t throttling_refresh_rate_ = 60;
   std::mutex hotplug_mutex_;
@@ -575,6 +660,7 @@ class HWCSession : hwc2_device_t, HWCUEventListener, public qClient::BnQClient,
   android::status_t setColorSamplingEnabled(const android::Parcel *input_parcel);
   android::status_t HandleTUITransition(int disp_id, int event);
   android::status_t GetDisplayPortId(uint32_t display, int *port_id);
+  android::status_t GetFrameTimingStats(int disp_id, android::Parcel *output_parcel);
 
   // Internal methods
   void HandleSecureSession();
@@ -596,6 +682,14 @@ class HWCSession : hwc2_device_t, HWCUEventListener, public qClient::BnQClient,
   void PostCommitUnlocked(hwc2_display_t display, const shared_ptr<Fence> &retire_fence,
                           HWC2::Error status);
   void PostCommitLocked(hwc2_display_t display, shared_ptr<Fence> &retire_fence);
+  // Called with locker_[display] held.
+  void UpdateConfigSnapshot(hwc2_display_t display);
+  void InvalidateConfigSnapshot(hwc2_display_t display);
+  bool ReadConfigSnapshot(hwc2_display_t display, HWCDisplayConfigSnapshot *snapshot);
+  void PublishDisplayStatus(hwc2_display_t display, uint32_t fields,
+                            const DisplayConfig::DisplayStatus &status);
+  void DumpTelemetry(hwc2_display_t display, const HWCDisplayTelemetry &telemetry,
+                     std::ostringstream *os);
   int WaitForCommitDone(hwc2_display_t display, int client_id);
   int WaitForCommitDoneAsync(hwc2_display_t display, int client_id);
   void NotifyDisplayAttributes(hwc2_display_t display, hwc2_config_t config);
@@ -659,6 +753,13 @@ class HWCSession : hwc2_device_t, HWCUEventListener, public qClient::BnQClient,
   bool tui_start_success_ = false;
   std::map <hwc2_display_t, std::future<int>> commit_done_future_;
   std::future<int> wfd_refresh_future_;
+  // Written under locker_[display] after each commit, read by Dump without any lock.
+  SeqLock<HWCDisplayTelemetry> display_telemetry_[HWCCallbacks::kNumDisplays];
+  // Written under locker_[display] when the active config may have changed, read by the config
+  // getters without any lock. The active config it was built for is checked after each commit.
+  SeqLock<HWCDisplayConfigSnapshot> config_snapshot_[HWCCallbacks::kNumDisplays];
+  bool config_snapshot_built_[HWCCallbacks::kNumDisplays] = {};
+  hwc2_config_t config_snapshot_active_[HWCCallbacks::kNumDisplays] = {};
 };
 }  // namespace sdm
 
@@ -41,6 +41,7 @@
 #include <vector>
 #include <string>
 #include <QtiGralloc.h>
+#include <utils/Timers.h>
 
 #include "hwc_buffer_sync_handler.h"
 #include "hwc_session.h"
@@ -57,6 +58,8 @@ void HWCSession::StartServices() {
   } else {
     DLOGI("IDisplayConfig service registration completed.");
   }
+
+  DisplayConfig::SetCwbStreamHandler(&cwb_);
 }
 
 int MapDisplayType(DispType dpy) {
@@ -266,6 +269,7 @@ int HWCSession::SetActiveConfigIndex(int disp_id, uint32_t config) {
   int error = -EINVAL;
   if (hwc_display_[disp_idx]) {
     error = hwc_display_[disp_idx]->SetActiveDisplayConfig(config);
+    UpdateConfigSnapshot(disp_idx);
     if (!error) {
       callbacks_.Refresh(0);
     }
@@ -1022,6 +1026,16 @@ int32_t HWCSession::CWB::PostBuffer(std::weak_ptr<DisplayConfig::ConfigCallback>
                                     hwc2_display_t display_type) {
   SCOPE_LOCK(queue_lock_);
 
+  {
+    std::lock_guard<std::mutex> lock(stream_lock_);
+    if (stream_) {
+      DLOGW("CWB is streaming on display %" PRIu64 ".", stream_->display_type);
+      native_handle_close(buffer);
+      native_handle_delete(const_cast<native_handle_t *>(buffer));
+      return -1;
+    }
+  }
+
   // Ensure that async task runs only until all queued CWB requests have been fulfilled.
   // If cwb queue is empty, async task has not either started or async task has finished
   // processing previously queued cwb requests. Start new async task on such a case as
@@ -1222,9 +1236,302 @@ void HWCSession::CWB::PresentDisplayDone(hwc2_display_t disp_id) {
 
 bool HWCSession::CWB::IsCwbActiveOnDisplay(hwc2_display_t disp_type) {
   SCOPE_LOCK(queue_lock_);
+  {
+    std::lock_guard<std::mutex> lock(stream_lock_);
+    if (stream_ && stream_->display_type == disp_type) {
+      return true;
+    }
+  }
   return (queue_.size() && queue_.front()->display_type == disp_type) ? true : false;
 }
 
+int HWCSession::CWB::StartCwbStream(const DisplayConfig::CwbStreamConfig &config,
+                                    const std::vector<const native_handle_t *> &buffers,
+                                    DisplayConfig::CwbStreamPage *page, uint32_t *stream_id) {
+  hwc2_display_t disp_type = HWC_DISPLAY_PRIMARY;
+  int dpy_index = -1;
+  switch (config.dpy) {
+    case DispType::kPrimary:
+      dpy_index = hwc_session_->GetDisplayIndex(qdutils::DISPLAY_PRIMARY);
+      break;
+    case DispType::kExternal:
+      dpy_index = hwc_session_->GetDisplayIndex(qdutils::DISPLAY_EXTERNAL);
+      disp_type = HWC_DISPLAY_EXTERNAL;
+      break;
+    case DispType::kBuiltIn2:
+      dpy_index = hwc_session_->GetDisplayIndex(qdutils::DISPLAY_BUILTIN_2);
+      disp_type = HWC_DISPLAY_BUILTIN_2;
+      break;
+    default:
+      DLOGE("CWB is supported on primary and external displays only at present.");
+      return -EINVAL;
+  }
+
+  if (dpy_index == -1) {
+    DLOGW("Unable to retrieve display index for display:%d", INT(config.dpy));
+    return -ENODEV;
+  }
+
+  // Same restriction as for single buffer requests.
+  int virtual_index = hwc_session_->GetDisplayIndex(qdutils::DISPLAY_VIRTUAL);
+  if ((virtual_index != -1) && hwc_session_->hwc_display_[virtual_index]) {
+    DLOGW("Output buffer dump is not supported with Virtual display!");
+    return -ENOTSUP;
+  }
+
+  std::unique_ptr<Stream> stream(new Stream());
+  stream->display_type = disp_type;
+  stream->page = page;
+  stream->cwb_config.tap_point = static_cast<CwbTapPoint>(config.post_processed);
+  LayerRect &roi = stream->cwb_config.cwb_roi;
+  roi.left = FLOAT(config.rect.left);
+  roi.top = FLOAT(config.rect.top);
+  roi.right = FLOAT(config.rect.right);
+  roi.bottom = FLOAT(config.rect.bottom);
+  for (auto buffer : buffers) {
+    // The service only lends the buffers for this call.
+    stream->buffers.push_back(native_handle_clone(buffer));
+  }
+
+  if (config.format != DisplayConfig::kCwbStreamNative) {
+    int status = InitStreamPostProcess(config, stream.get());
+    if (status) {
+      return status;
+    }
+  }
+
+  Stream *started = stream.get();
+  CwbTapPoint tap_point = stream->cwb_config.tap_point;
+  {
+    SCOPE_LOCK(queue_lock_);
+    std::lock_guard<std::mutex> lock(stream_lock_);
+    if (queue_.size() || stream_) {
+      DLOGW("CWB is in use, cannot start a stream.");
+      return -EBUSY;
+    }
+    stream->id = next_stream_id_++;
+    *stream_id = stream->id;
+    stream->fence_thread = std::thread(&HWCSession::CWB::StreamFenceWaits, this, started);
+    stream_ = std::move(stream);
+  }
+
+  // Set up the first buffer and trigger a present so that the client gets the current frame.
+  {
+    SEQUENCE_WAIT_SCOPE_LOCK(hwc_session_->locker_[disp_type]);
+    std::lock_guard<std::mutex> lock(stream_lock_);
+    if (stream_.get() == started && hwc_session_->hwc_display_[disp_type] && !started->armed) {
+      ArmStream(started, hwc_session_->hwc_display_[disp_type]);
+    }
+  }
+  hwc_session_->callbacks_.Refresh(disp_type);
+
+  DLOGI("Started CWB stream %u on display %" PRIu64 " with %zu buffers, tappoint %d, format %u, "
+        "downscale %u", *stream_id, disp_type, buffers.size(), tap_point, config.format,
+        config.downscale);
+
+  return 0;
+}
+
+int HWCSession::CWB::InitStreamPostProcess(const DisplayConfig::CwbStreamConfig &config,
+                                           Stream *stream) {
+  // The display writes the full frame, the region is cropped on the CPU. That keeps the crop
+  // exact where the writeback ROI would be aligned or fall back to the full frame.
+  stream->roi = {FLOAT(config.rect.left), FLOAT(config.rect.top), FLOAT(config.rect.right),
+                 FLOAT(config.rect.bottom)};
+  stream->cwb_config.cwb_roi = {};
+  stream->downscale = config.downscale;
+
+  uint32_t width = 0, height = 0;
+  {
+    SEQUENCE_WAIT_SCOPE_LOCK(hwc_session_->locker_[stream->display_type]);
+    HWCDisplay *hwc_display = hwc_session_->hwc_display_[stream->display_type];
+    CwbConfig cwb_config = stream->cwb_config;
+    if (!hwc_display || hwc_display->GetCwbBufferResolution(&cwb_config, &width, &height)) {
+      DLOGW("Failed to get the CWB resolution of display %" PRIu64, stream->display_type);
+      return -ENODEV;
+    }
+  }
+
+  GLRect area = {};
+  uint32_t out_width = 0, out_height = 0;
+  if (!CPUCwbPostProcess::GetOutputArea(stream->roi, width, height, stream->downscale, &area,
+                                        &out_width, &out_height)) {
+    DLOGW("Invalid CWB stream region for a %ux%u frame", width, height);
+    return -EINVAL;
+  }
+
+  bool yuv = (config.format == DisplayConfig::kCwbStreamNV12);
+  for (auto buffer : stream->buffers) {
+    if (!CPUCwbPostProcess::IsValidOutput(buffer, yuv, out_width, out_height)) {
+      DLOGW("CWB stream buffers must be linear %s of at least %ux%u", yuv ? "NV12" : "RGBA8888",
+            out_width, out_height);
+      return -EINVAL;
+    }
+  }
+
+  // One intermediate per client buffer, it is free whenever the client buffer is.
+  stream->allocator = &hwc_session_->buffer_allocator_;
+  for (size_t i = 0; i < stream->buffers.size(); i++) {
+    BufferInfo buffer_info = {};
+    buffer_info.buffer_config.width = width;
+    buffer_info.buffer_config.height = height;
+    buffer_info.buffer_config.format = kFormatRGBA8888;
+    buffer_info.buffer_config.buffer_count = 1;
+    // Read back on the CPU, the dma-buf syncs of CPUCommon keep the cache coherent.
+    buffer_info.buffer_config.cache = true;
+    if (stream->allocator->AllocateBuffer(&buffer_info) != 0) {
+      DLOGE("Failed to allocate CWB stream buffer %zu", i);
+      return -ENOMEM;
+    }
+    stream->intermediates.push_back(buffer_info);
+  }
+
+  uint32_t num_buffers = UINT32(stream->buffers.size());
+  stream->post_process.reset(new CPUCwbPostProcess(2 * num_buffers, ColorConvertCSC()));
+  stream->post_process->Init();
+
+  return 0;
+}
+
+int HWCSession::CWB::StopCwbStream(uint32_t stream_id) {
+  hwc2_display_t disp_type = HWC_DISPLAY_PRIMARY;
+  {
+    std::lock_guard<std::mutex> lock(stream_lock_);
+    if (!stream_ || stream_->id != stream_id) {
+      return -EINVAL;
+    }
+    disp_type = stream_->display_type;
+  }
+
+  std::unique_ptr<Stream> stream = nullptr;
+  {
+    SEQUENCE_WAIT_SCOPE_LOCK(hwc_session_->locker_[disp_type]);
+    std::lock_guard<std::mutex> lock(stream_lock_);
+    if (!stream_ || stream_->id != stream_id) {
+      return -EINVAL;
+    }
+
+    // Take back a buffer still set on the display, the writeback may be in flight.
+    if (stream_->pending && hwc_session_->hwc_display_[disp_type]) {
+      StreamFence stream_fence;
+      stream_fence.frame = stream_->armed - 1;
+      if (hwc_session_->hwc_display_[disp_type]->GetReadbackBufferFence(&stream_fence.fence) !=
+          HWC2::Error::None) {
+        stream_fence.status = -1;
+      }
+      QueueStreamFence(stream_.get(), stream_fence);
+    }
+    stream_->pending = false;
+    stream = std::move(stream_);
+  }
+
+  // The fence thread completes what is queued before it exits, only then the buffers and the
+  // page can go.
+  {
+    std::lock_guard<std::mutex> lock(stream->fence_lock);
+    stream->exit = true;
+  }
+  stream->fence_cv.notify_one();
+  stream->fence_thread.join();
+
+  DLOGI("Stopped CWB stream %u after %u buffers, %u presents dropped", stream_id,
+        stream->completed.load(), stream->page->dropped.load());
+
+  return 0;
+}
+
+void HWCSession::CWB::StreamPresentDone(hwc2_display_t disp_id) {
+  std::lock_guard<std::mutex> lock(stream_lock_);
+  if (!stream_ || stream_->display_type != disp_id) {
+    return;
+  }
+
+  HWCDisplay *hwc_display = hwc_session_->hwc_display_[disp_id];
+  if (stream_->pending) {
+    StreamFence stream_fence;
+    stream_fence.frame = stream_->armed - 1;
+    if (hwc_display->GetReadbackBufferFence(&stream_fence.fence) != HWC2::Error::None) {
+      stream_fence.status = -1;
+    }
+    stream_->pending = false;
+    QueueStreamFence(stream_.get(), stream_fence);
+  }
+
+  ArmStream(stream_.get(), hwc_display);
+}
+
+void HWCSession::CWB::ArmStream(Stream *stream, HWCDisplay *hwc_display) {
+  // Buffers are reused in order, only once the client released them. The released count lives
+  // in memory the client writes, never trust it beyond what has been completed.
+  uint32_t num_buffers = UINT32(stream->buffers.size());
+  uint32_t completed = stream->completed.load(std::memory_order_acquire);
+  uint32_t released = stream->page->released.load(std::memory_order_acquire);
+  if (released > completed) {
+    released = completed;
+  }
+
+  if ((stream->armed - released) >= num_buffers) {
+    stream->page->dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  uint32_t index = stream->armed % num_buffers;
+  const native_handle_t *buffer = stream->buffers[index];
+  if (stream->post_process) {
+    buffer = static_cast<const native_handle_t *>(stream->intermediates[index].private_data);
+  }
+  HWC2::Error error = hwc_display->SetReadbackBuffer(buffer, nullptr, stream->cwb_config,
+                                                     kCWBClientExternal);
+  if (error != HWC2::Error::None) {
+    // e.g. the display is off or another client uses CWB, retried on the next present.
+    DLOGV_IF(kTagClient, "Failed to set stream buffer %u, error = %d", stream->armed, error);
+    return;
+  }
+
+  stream->armed++;
+  stream->pending = true;
+}
+
+void HWCSession::CWB::QueueStreamFence(Stream *stream, const StreamFence &stream_fence) {
+  {
+    std::lock_guard<std::mutex> lock(stream->fence_lock);
+    stream->fences.push(stream_fence);
+  }
+  stream->fence_cv.notify_one();
+}
+
+void HWCSession::CWB::StreamFenceWaits(Stream *stream) {
+  while (true) {
+    StreamFence stream_fence;
+    {
+      std::unique_lock<std::mutex> lock(stream->fence_lock);
+      stream->fence_cv.wait(lock, [stream] { return stream->exit || stream->fences.size(); });
+      if (!stream->fences.size()) {
+        break;
+      }
+      stream_fence = stream->fences.front();
+      stream->fences.pop();
+    }
+
+    int status = stream_fence.status;
+    if (!status) {
+      status = Fence::Wait(stream_fence.fence);
+    }
+    int64_t timestamp = systemTime(SYSTEM_TIME_MONOTONIC);
+
+    if (!status && stream->post_process) {
+      uint32_t index = stream_fence.frame % UINT32(stream->buffers.size());
+      const native_handle_t *intermediate =
+          static_cast<const native_handle_t *>(stream->intermediates[index].private_data);
+      status = stream->post_process->Process(intermediate, stream->buffers[index], stream->roi,
+                                             stream->downscale);
+    }
+
+    DisplayConfig::PublishCwbStreamFrame(stream->page, stream_fence.frame, status, timestamp);
+    stream->completed.store(stream_fence.frame + 1, std::memory_order_release);
+  }
+}
+
 int HWCSession::DisplayConfigImpl::SetQsyncMode(uint32_t disp_id, DisplayConfig::QsyncMode mode) {
   if (disp_id < 0 || disp_id >= HWCCallbacks::kNumDisplays) {
     DLOGE("Not valid display");
@@ -0,0 +1,438 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <string.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+#include <algorithm>
+#include <array>
+
+#include "hwc_test_pattern.h"
+
+#define __CLASS__ "HWCTestPattern"
+
+namespace sdm {
+
+using std::array;
+
+HWCTestPattern::HWCTestPattern(LayerBufferFormat format, uint32_t width, uint32_t height,
+                               uint32_t aligned_width, uint32_t panel_bpp)
+  : format_(format), width_(width), height_(height), aligned_width_(aligned_width),
+    panel_bpp_(panel_bpp) {}
+
+int HWCTestPattern::Generate(uint32_t pattern_type, uint8_t *buffer, Crc *crc) {
+  switch (pattern_type) {
+    case kPatternColorRamp:
+      GenerateColorRamp(buffer, crc);
+      break;
+    case kPatternBWVertical:
+      GenerateBWVertical(buffer, crc);
+      break;
+    case kPatternColorSquare:
+      GenerateColorSquare(buffer, crc);
+      break;
+    default:
+      DLOGW("Invalid Pattern type %d", pattern_type);
+      return -EINVAL;
+  }
+
+  return 0;
+}
+
+// Each bit of the next DP CTS CRC16 is the parity of (crc ^ color) under one of these masks, so a
+// step is a linear map that is applied through byte tables. kCrcStepMasks[i] gives bit i.
+static const uint16_t kCrcStepMasks[16] = {
+  0xBFFF, 0x7FFE, 0x4003, 0x8006, 0x000C, 0x0018, 0x0030, 0x0060,
+  0x00C0, 0x0180, 0x0300, 0x0600, 0x0C00, 0x1800, 0x3000, 0xDFFF,
+};
+
+// images[j] is the map of bit j, a linear map is the XOR of the images of the bits set.
+static void InitCrcMap(const uint16_t images[16], uint16_t lo[256], uint16_t hi[256]) {
+  for (uint32_t value = 0; value < 256; value++) {
+    lo[value] = 0;
+    hi[value] = 0;
+    for (uint32_t bit = 0; bit < 8; bit++) {
+      if (value & (1 << bit)) {
+        lo[value] ^= images[bit];
+        hi[value] ^= images[bit + 8];
+      }
+    }
+  }
+}
+
+const HWCTestPattern::CrcMap &HWCTestPattern::GetCrcStepMap() {
+  static const CrcMap *s_step_map = [] {
+    uint16_t images[16] = {};
+    for (uint32_t bit = 0; bit < 16; bit++) {
+      for (uint32_t i = 0; i < 16; i++) {
+        images[bit] |= UINT16(((kCrcStepMasks[i] >> bit) & 1) << i);
+      }
+    }
+    CrcMap *map = new CrcMap();
+    InitCrcMap(images, map->lo, map->hi);
+    return map;
+  }();
+
+  return *s_step_map;
+}
+
+void HWCTestPattern::CalcCRC(uint32_t panel_bpp, uint32_t color_val, uint16_t *crc_data) {
+  uint16_t color = 0;
+
+  switch (panel_bpp) {
+    case kDisplayBpp18:
+      color = UINT16((color_val & 0xFC) << 8);
+      break;
+    case kDisplayBpp24:
+      color = UINT16(color_val << 8);
+      break;
+    case kDisplayBpp30:
+      color = UINT16(color_val << 6);
+      break;
+    default:
+      return;
+  }
+
+  *crc_data = GetCrcStepMap().Apply(*crc_data ^ color);
+}
+
+void HWCTestPattern::CalcCRC(uint32_t color_val, uint16_t *crc_data) const {
+  CalcCRC(panel_bpp_, color_val, crc_data);
+}
+
+// The CRC after a row is the CRC before it taken width_ steps with zero color, XORed with
+// the CRC of the row alone. row_map is the first part, so a row that repeats the one above is
+// folded into the CRC without walking its pixels again.
+void HWCTestPattern::GetRowCrcMap(CrcMap *row_map) const {
+  const CrcMap &step_map = GetCrcStepMap();
+  uint16_t images[16] = {};
+
+  for (uint32_t bit = 0; bit < 16; bit++) {
+    uint16_t value = UINT16(1 << bit);
+    for (uint32_t i = 0; i < width_; i++) {
+      value = step_map.Apply(value);
+    }
+    images[bit] = value;
+  }
+
+  InitCrcMap(images, row_map->lo, row_map->hi);
+}
+
+int HWCTestPattern::GetStride(LayerBufferFormat format, uint32_t width, uint32_t *stride) {
+  switch (format) {
+  case kFormatRGBA8888:
+  case kFormatRGBA1010102:
+    *stride = width * 4;
+    break;
+  case kFormatRGB888:
+    *stride = width * 3;
+    break;
+  default:
+    DLOGW("Unsupported format type %d", format);
+    return -EINVAL;
+  }
+
+  return 0;
+}
+
+void HWCTestPattern::PixelCopy(uint32_t red, uint32_t green, uint32_t blue, uint32_t alpha,
+                               uint8_t **buffer) const {
+  switch (format_) {
+    case kFormatRGBA8888:
+      *(*buffer)++ = UINT8(red & 0xFF);
+      *(*buffer)++ = UINT8(green & 0xFF);
+      *(*buffer)++ = UINT8(blue & 0xFF);
+      *(*buffer)++ = UINT8(alpha & 0xFF);
+      break;
+    case kFormatRGB888:
+      *(*buffer)++ = UINT8(red & 0xFF);
+      *(*buffer)++ = UINT8(green & 0xFF);
+      *(*buffer)++ = UINT8(blue & 0xFF);
+      break;
+    case kFormatRGBA1010102:
+      // Lower 8 bits of red
+      *(*buffer)++ = UINT8(red & 0xFF);
+
+      // Upper 2 bits of Red + Lower 6 bits of green
+      *(*buffer)++ = UINT8(((green & 0x3F) << 2) | ((red >> 0x8) & 0x3));
+
+      // Upper 4 bits of green + Lower 4 bits of blue
+      *(*buffer)++ = UINT8(((blue & 0xF) << 4) | ((green >> 6) & 0xF));
+
+      // Upper 6 bits of blue + Lower 2 bits of alpha
+      *(*buffer)++ = UINT8(((alpha & 0x3) << 6) | ((blue >> 4) & 0x3F));
+      break;
+    default:
+      DLOGW("format not supported format = %d", format_);
+      break;
+  }
+}
+
+// Writes count copies of a pixel. The first is packed by PixelCopy, the rest are copied in
+// doubling chunks.
+void HWCTestPattern::PixelFill(uint32_t red, uint32_t green, uint32_t blue, uint32_t alpha,
+                               uint32_t count, uint8_t **buffer) const {
+  if (!count) {
+    return;
+  }
+
+  uint8_t *start = *buffer;
+  PixelCopy(red, green, blue, alpha, buffer);
+
+  size_t total = static_cast<size_t>(*buffer - start) * count;
+  size_t filled = static_cast<size_t>(*buffer - start);
+  while (filled < total) {
+    size_t chunk = std::min(filled, total - filled);
+    memcpy(start + filled, start, chunk);
+    filled += chunk;
+  }
+  *buffer = start + total;
+}
+
+void HWCTestPattern::GenerateColorRamp(uint8_t *buffer, Crc *crc) const {
+  uint32_t width = width_;
+  uint32_t height = height_;
+  uint32_t buffer_stride = 0;
+
+  uint32_t color_ramp = 0;
+  uint32_t start_color_val = 0;
+  uint32_t step_size = 1;
+  uint32_t ramp_width = 0;
+  uint32_t ramp_height = 0;
+  uint32_t shift_by = 0;
+
+  uint16_t crc_red = 0;
+  uint16_t crc_green = 0;
+  uint16_t crc_blue = 0;
+
+  switch (panel_bpp_) {
+    case kDisplayBpp18:
+      ramp_height = 64;
+      ramp_width = 64;
+      shift_by = 2;
+      break;
+    case kDisplayBpp24:
+      ramp_height = 64;
+      ramp_width = 256;
+      break;
+    case kDisplayBpp30:
+      ramp_height = 32;
+      ramp_width = 256;
+      start_color_val = 0x180;
+      break;
+    default:
+      return;
+  }
+
+  GetStride(format_, aligned_width_, &buffer_stride);
+
+  CrcMap row_map;
+  GetRowCrcMap(&row_map);
+
+  // Rows only change at the ramp boundaries, the others repeat the row above.
+  uint8_t *prev_row = nullptr;
+  size_t row_size = 0;
+  uint16_t row_crc_red = 0;
+  uint16_t row_crc_green = 0;
+  uint16_t row_crc_blue = 0;
+
+  for (uint32_t loop_height = 0; loop_height < height; loop_height++) {
+    uint8_t *row = buffer + (loop_height * buffer_stride);
+
+    if (prev_row) {
+      memcpy(row, prev_row, row_size);
+    } else {
+      uint32_t color_value = start_color_val;
+      uint8_t *temp = row;
+      row_crc_red = 0;
+      row_crc_green = 0;
+      row_crc_blue = 0;
+
+      for (uint32_t loop_width = 0; loop_width < width; loop_width++) {
+        uint32_t red = (color_ramp == kColorRedRamp || color_ramp == kColorWhiteRamp) ?
+                       color_value : 0;
+        uint32_t green = (color_ramp == kColorGreenRamp || color_ramp == kColorWhiteRamp) ?
+                         color_value : 0;
+        uint32_t blue = (color_ramp == kColorBlueRamp || color_ramp == kColorWhiteRamp) ?
+                        color_value : 0;
+
+        PixelCopy(red, green, blue, 0, &temp);
+        CalcCRC(red, &row_crc_red);
+        CalcCRC(green, &row_crc_green);
+        CalcCRC(blue, &row_crc_blue);
+
+        color_value = (start_color_val + (((loop_width + 1) % ramp_width) * step_size)) << shift_by;
+      }
+      row_size = static_cast<size_t>(temp - row);
+    }
+    prev_row = row;
+
+    crc_red = row_map.Apply(crc_red) ^ row_crc_red;
+    crc_green = row_map.Apply(crc_green) ^ row_crc_green;
+    crc_blue = row_map.Apply(crc_blue) ^ row_crc_blue;
+
+    if (((loop_height + 1) % ramp_height) != 0) {
+      continue;
+    }
+
+    prev_row = nullptr;
+    if (panel_bpp_ == kDisplayBpp30) {
+      if (start_color_val == 0x180) {
+        start_color_val = 0;
+        step_size = 4;
+      } else {
+        start_color_val = 0x180;
+        step_size = 1;
+        color_ramp = (color_ramp + 1) % 4;
+      }
+      continue;
+    }
+
+    color_ramp = (color_ramp + 1) % 4;
+  }
+
+  crc->red = crc_red;
+  crc->green = crc_green;
+  crc->blue = crc_blue;
+}
+
+void HWCTestPattern::GenerateBWVertical(uint8_t *buffer, Crc *crc) const {
+  uint32_t width = width_;
+  uint32_t height = height_;
+  uint32_t buffer_stride = 0;
+  uint32_t bits_per_component = panel_bpp_ / 3;
+  uint32_t max_color_val = (1 << bits_per_component) - 1;
+
+  uint16_t crc_red = 0;
+  uint16_t crc_green = 0;
+  uint16_t crc_blue = 0;
+
+  if (panel_bpp_ == kDisplayBpp18) {
+    max_color_val <<= 2;
+  }
+
+  GetStride(format_, aligned_width_, &buffer_stride);
+
+  // All rows are the same, so only the first one is generated.
+  uint8_t *temp = buffer;
+  uint16_t row_crc = 0;
+  for (uint32_t loop_width = 0; loop_width < width; loop_width++) {
+    uint32_t color_value = ((loop_width % 2) == kColorWhite) ? max_color_val : 0;
+    PixelCopy(color_value, color_value, color_value, 0, &temp);
+    CalcCRC(color_value, &row_crc);
+  }
+
+  size_t row_size = static_cast<size_t>(temp - buffer);
+  for (uint32_t loop_height = 1; loop_height < height; loop_height++) {
+    memcpy(buffer + (loop_height * buffer_stride), buffer, row_size);
+  }
+
+  CrcMap row_map;
+  GetRowCrcMap(&row_map);
+  for (uint32_t loop_height = 0; loop_height < height; loop_height++) {
+    crc_red = row_map.Apply(crc_red) ^ row_crc;
+  }
+  crc_green = crc_red;
+  crc_blue = crc_red;
+
+  crc->red = crc_red;
+  crc->green = crc_green;
+  crc->blue = crc_blue;
+}
+
+void HWCTestPattern::GenerateColorSquare(uint8_t *buffer, Crc *crc) const {
+  uint32_t width = width_;
+  uint32_t height = height_;
+  uint32_t buffer_stride = 0;
+  uint32_t max_color_val = 0;
+  uint32_t min_color_val = 0;
+
+  uint16_t crc_red = 0;
+  uint16_t crc_green = 0;
+  uint16_t crc_blue = 0;
+
+  switch (panel_bpp_) {
+    case kDisplayBpp18:
+      max_color_val = 63 << 2;  // CEA Dynamic range for 18bpp 0 - 63
+      min_color_val = 0;
+      break;
+    case kDisplayBpp24:
+      max_color_val = 235;  // CEA Dynamic range for 24bpp 16 - 235
+      min_color_val = 16;
+      break;
+    case kDisplayBpp30:
+      max_color_val = 940;  // CEA Dynamic range for 30bpp 64 - 940
+      min_color_val = 64;
+      break;
+    default:
+      return;
+  }
+
+  array<array<uint32_t, 3>, 8> colors = {{
+    {{max_color_val, max_color_val, max_color_val}},  // White Color
+    {{max_color_val, max_color_val, min_color_val}},  // Yellow Color
+    {{min_color_val, max_color_val, max_color_val}},  // Cyan Color
+    {{min_color_val, max_color_val, min_color_val}},  // Green Color
+    {{max_color_val, min_color_val, max_color_val}},  // Megenta Color
+    {{max_color_val, min_color_val, min_color_val}},  // Red Color
+    {{min_color_val, min_color_val, max_color_val}},  // Blue Color
+    {{min_color_val, min_color_val, min_color_val}},  // Black Color
+  }};
+
+  GetStride(format_, aligned_width_, &buffer_stride);
+
+  CrcMap row_map;
+  GetRowCrcMap(&row_map);
+
+  // Squares are 64x64, rows within a band of squares repeat the row above.
+  uint8_t *prev_row = nullptr;
+  size_t row_size = 0;
+  uint16_t row_crc_red = 0;
+  uint16_t row_crc_green = 0;
+  uint16_t row_crc_blue = 0;
+
+  for (uint32_t loop_height = 0; loop_height < height; loop_height++) {
+    uint8_t *row = buffer + (loop_height * buffer_stride);
+
+    if (prev_row) {
+      memcpy(row, prev_row, row_size);
+    } else {
+      uint32_t color = 0;
+      uint8_t *temp = row;
+      row_crc_red = 0;
+      row_crc_green = 0;
+      row_crc_blue = 0;
+
+      for (uint32_t loop_width = 0; loop_width < width; loop_width += 64) {
+        uint32_t count = std::min(64U, width - loop_width);
+        PixelFill(colors[color][0], colors[color][1], colors[color][2], 0, count, &temp);
+        for (uint32_t i = 0; i < count; i++) {
+          CalcCRC(colors[color][0], &row_crc_red);
+          CalcCRC(colors[color][1], &row_crc_green);
+          CalcCRC(colors[color][2], &row_crc_blue);
+        }
+
+        color = (color + 1) % colors.size();
+      }
+      row_size = static_cast<size_t>(temp - row);
+    }
+    prev_row = row;
+
+    crc_red = row_map.Apply(crc_red) ^ row_crc_red;
+    crc_green = row_map.Apply(crc_green) ^ row_crc_green;
+    crc_blue = row_map.Apply(crc_blue) ^ row_crc_blue;
+
+    if (((loop_height + 1) % 64) == 0) {
+      std::reverse(colors.begin(), (colors.end() - 1));
+      prev_row = nullptr;
+    }
+  }
+
+  crc->red = crc_red;
+  crc->green = crc_green;
+  crc->blue = crc_blue;
+}
+
+}  // namespace sdm
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HWC_TEST_PATTERN_H__
+#define __HWC_TEST_PATTERN_H__
+
+#include <core/layer_buffer.h>
+#include <stdint.h>
+
+namespace sdm {
+
+// DP compliance test patterns, along with the DP CTS CRC16 of each color component that the sink
+// is expected to report for them.
+class HWCTestPattern {
+ public:
+  enum ColorPatternType {
+    kPatternNone = 0,
+    kPatternColorRamp,
+    kPatternBWVertical,
+    kPatternColorSquare,
+  };
+
+  enum DisplayBpp {
+    kDisplayBpp18 = 18,
+    kDisplayBpp24 = 24,
+    kDisplayBpp30 = 30,
+  };
+
+  struct Crc {
+    uint16_t red = 0;
+    uint16_t green = 0;
+    uint16_t blue = 0;
+  };
+
+  // Patterns of width x height pixels for a panel of panel_bpp, in buffers of format whose rows
+  // are aligned_width pixels apart. format is RGBA8888, RGB888 or RGBA1010102.
+  HWCTestPattern(LayerBufferFormat format, uint32_t width, uint32_t height,
+                 uint32_t aligned_width, uint32_t panel_bpp);
+
+  int Generate(uint32_t pattern_type, uint8_t *buffer, Crc *crc);
+  static int GetStride(LayerBufferFormat format, uint32_t width, uint32_t *stride);
+  // Takes crc_data one step with the next value of a color component.
+  static void CalcCRC(uint32_t panel_bpp, uint32_t color_value, uint16_t *crc_data);
+
+ private:
+  enum ColorRamp {
+    kColorRedRamp = 0,
+    kColorGreenRamp = 1,
+    kColorBlueRamp = 2,
+    kColorWhiteRamp = 3,
+  };
+
+  enum Colors {
+    kColorBlack = 0,
+    kColorWhite = 1,
+  };
+
+  // Linear map on a CRC16 word, applied a byte at a time.
+  struct CrcMap {
+    uint16_t lo[256] = {};
+    uint16_t hi[256] = {};
+    uint16_t Apply(uint16_t value) const { return lo[value & 0xFF] ^ hi[value >> 8]; }
+  };
+
+  static const CrcMap &GetCrcStepMap();
+  void CalcCRC(uint32_t color_value, uint16_t *crc_data) const;
+  void GetRowCrcMap(CrcMap *row_map) const;
+  void PixelCopy(uint32_t red, uint32_t green, uint32_t blue, uint32_t alpha,
+                 uint8_t **buffer) const;
+  void PixelFill(uint32_t red, uint32_t green, uint32_t blue, uint32_t alpha, uint32_t count,
+                 uint8_t **buffer) const;
+  void GenerateColorRamp(uint8_t *buffer, Crc *crc) const;
+  void GenerateBWVertical(uint8_t *buffer, Crc *crc) const;
+  void GenerateColorSquare(uint8_t *buffer, Crc *crc) const;
+
+  LayerBufferFormat format_ = kFormatInvalid;
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+  uint32_t aligned_width_ = 0;
+  uint32_t panel_bpp_ = 0;
+};
+
+}  // namespace sdm
+
+#endif  // __HWC_TEST_PATTERN_H__
@@ -66,6 +66,7 @@
 #include <inttypes.h>
 #include <log/log.h>
 #include <utils/sys.h>
+#include <utils/worker_pool.h>
 #include <cstring>
 
 #include "ipc_impl.h"
@@ -419,7 +420,10 @@ int IPCImpl::ProcessOps(IPCOps op, const GenericPayload &in, GenericPayload *out
     }
     *cb_hnd = client_id_;
     if (server_ready_) {
-      std::thread (IPCImpl::SpawnOnServerReady, client_id_).detach();
+      int client_id = client_id_;
+      WorkerPool::GetInstance()->Post(kLaneVmIPC, [client_id]() {
+        IPCImpl::SpawnOnServerReady(client_id);
+      });
     }
     client_id_++;
   } break;
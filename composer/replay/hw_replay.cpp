@@ -0,0 +1,682 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <drm_mode.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <utils/debug.h>
+#include <utils/utils.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "hw_replay.h"
+
+#define __CLASS__ "HWReplay"
+
+extern "C" int GetDRMManager(int fd, sde_drm::DRMManagerInterface **intf);
+
+using sde_drm::DRMConnectorInfo;
+using sde_drm::DRMConnectorsInfo;
+using sde_drm::DRMDisplayType;
+using sde_drm::DRMOps;
+using sde_drm::DRMPanelMode;
+using sde_drm::DRMPlaneType;
+using sde_drm::DRMPlanesInfo;
+using sde_drm::DRMRect;
+
+namespace sdm {
+
+// The mixer width of the targets the replay models, wider modes are split over two mixers.
+static const uint32_t kMaxMixerWidth = 2560;
+static const uint32_t kBlendingStages = 11;
+static const float kDefaultDpi = 320.0f;
+
+DisplayError HWInterface::Create(int32_t display_id, DisplayType type,
+                                 HWInfoInterface *hw_info_intf,
+                                 BufferAllocator *buffer_allocator, HWInterface **intf) {
+  if (type != kBuiltIn && type != kPluggable) {
+    DLOGE("Display type %d is not replayed", type);
+    return kErrorNotSupported;
+  }
+
+  HWDeviceReplay *hw = new HWDeviceReplay(display_id, type);
+  DisplayError error = hw->Init();
+  if (error != kErrorNone) {
+    delete hw;
+    return error;
+  }
+  *intf = hw;
+
+  return kErrorNone;
+}
+
+DisplayError HWInterface::Destroy(HWInterface *intf) {
+  if (intf) {
+    intf->Deinit();
+    delete intf;
+  }
+
+  return kErrorNone;
+}
+
+DisplayError HWInfoInterface::Create(HWInfoInterface **intf) {
+  HWInfoReplay *hw_info = new HWInfoReplay();
+  DisplayError error = hw_info->Init();
+  if (error != kErrorNone) {
+    delete hw_info;
+    return error;
+  }
+  *intf = hw_info;
+
+  return kErrorNone;
+}
+
+DisplayError HWInfoInterface::Destroy(HWInfoInterface *intf) {
+  delete intf;
+  return kErrorNone;
+}
+
+DisplayError HWEventsInterface::Create(int display_id, DisplayType display_type,
+                                       HWEventHandler *event_handler,
+                                       const std::vector<HWEvent> &event_list,
+                                       const HWInterface *hw_intf, HWEventsInterface **intf) {
+  HWEventsInterface *hw_events = new HWEventsReplay();
+  hw_events->Init(display_id, display_type, event_handler, event_list, hw_intf);
+  *intf = hw_events;
+
+  return kErrorNone;
+}
+
+DisplayError HWEventsInterface::Destroy(HWEventsInterface *intf) {
+  if (intf) {
+    intf->Deinit();
+    delete intf;
+  }
+
+  return kErrorNone;
+}
+
+DisplayError HWInfoReplay::Init() {
+  if (GetDRMManager(0, &drm_mgr_intf_)) {
+    DLOGE("No DRM manager, is the fake DRM backend installed?");
+    return kErrorCriticalResource;
+  }
+
+  return kErrorNone;
+}
+
+DisplayType HWInfoReplay::GetDisplayType(uint32_t connector_type) {
+  switch (connector_type) {
+    case DRM_MODE_CONNECTOR_DSI:
+      return kBuiltIn;
+    case DRM_MODE_CONNECTOR_TV:
+    case DRM_MODE_CONNECTOR_HDMIA:
+    case DRM_MODE_CONNECTOR_HDMIB:
+    case DRM_MODE_CONNECTOR_DisplayPort:
+    case DRM_MODE_CONNECTOR_VGA:
+      return kPluggable;
+    case DRM_MODE_CONNECTOR_VIRTUAL:
+      return kVirtual;
+    default:
+      return kDisplayTypeMax;
+  }
+}
+
+DisplayError HWInfoReplay::GetHWResourceInfo(HWResourceInfo *hw_resource) {
+  *hw_resource = {};
+  hw_resource->hw_version = 0x90000000;
+  hw_resource->num_blending_stages = kBlendingStages;
+  hw_resource->max_mixer_width = kMaxMixerWidth;
+  hw_resource->max_scale_up = 1;
+  hw_resource->max_scale_down = 1;
+  hw_resource->has_ubwc = true;
+  hw_resource->is_src_split = true;
+  hw_resource->max_bandwidth_low = 9600000000;
+  hw_resource->max_bandwidth_high = 9600000000;
+  hw_resource->max_sde_clk = 460000000;
+
+  DRMPlanesInfo planes;
+  drm_mgr_intf_->GetPlanesInfo(&planes);
+  for (auto &plane : planes) {
+    const sde_drm::DRMPlaneTypeInfo &info = plane.second;
+    HWPipeCaps pipe_caps;
+    pipe_caps.id = plane.first;
+    pipe_caps.master_pipe_id = info.master_plane_id;
+    pipe_caps.max_rects = 1;
+    pipe_caps.pipe_idx = info.pipe_idx;
+    switch (info.type) {
+      case DRMPlaneType::VIG:
+        pipe_caps.type = kPipeTypeVIG;
+        hw_resource->num_vig_pipe++;
+        hw_resource->max_scale_up = std::max(hw_resource->max_scale_up, info.max_upscale);
+        hw_resource->max_scale_down = std::max(hw_resource->max_scale_down, info.max_downscale);
+        break;
+      case DRMPlaneType::DMA:
+        pipe_caps.type = kPipeTypeDMA;
+        hw_resource->num_dma_pipe++;
+        hw_resource->max_pipe_width_dma = info.max_linewidth;
+        break;
+      case DRMPlaneType::CURSOR:
+        pipe_caps.type = kPipeTypeCursor;
+        hw_resource->num_cursor_pipe++;
+        hw_resource->max_cursor_size = info.max_linewidth;
+        break;
+      default:
+        continue;
+    }
+    hw_resource->max_pipe_width = std::max(hw_resource->max_pipe_width, info.max_linewidth);
+    hw_resource->max_pipe_bw = std::max(hw_resource->max_pipe_bw, info.max_pipe_bandwidth);
+    hw_resource->hw_pipes.push_back(pipe_caps);
+  }
+  hw_resource->max_scaler_pipe_width = hw_resource->max_pipe_width;
+
+  DLOGI("%u VIG, %u DMA and %u cursor pipes", hw_resource->num_vig_pipe,
+        hw_resource->num_dma_pipe, hw_resource->num_cursor_pipe);
+
+  return kErrorNone;
+}
+
+DisplayError HWInfoReplay::GetFirstDisplayInterfaceType(HWDisplayInterfaceInfo *hw_disp_info) {
+  HWDisplaysInfo hw_displays_info = {};
+  DisplayError error = GetDisplaysStatus(&hw_displays_info);
+  if (error != kErrorNone) {
+    return error;
+  }
+
+  for (auto &iter : hw_displays_info) {
+    if (iter.second.is_primary) {
+      hw_disp_info->type = iter.second.display_type;
+      hw_disp_info->is_connected = iter.second.is_connected;
+      break;
+    }
+  }
+
+  return kErrorNone;
+}
+
+DisplayError HWInfoReplay::GetDisplaysStatus(HWDisplaysInfo *hw_displays_info) {
+  hw_displays_info->clear();
+  DRMConnectorsInfo conns_info = {};
+  if (drm_mgr_intf_->GetConnectorsInfo(&conns_info)) {
+    return kErrorUndefined;
+  }
+
+  for (auto &iter : conns_info) {
+    HWDisplayInfo hw_info = {};
+    hw_info.display_id = INT32(iter.first);
+    hw_info.display_type = GetDisplayType(iter.second.type);
+    hw_info.is_connected = iter.second.is_connected;
+    hw_info.is_primary = iter.second.is_primary;
+    hw_info.is_wb_ubwc_supported = iter.second.is_wb_ubwc_supported;
+    (*hw_displays_info)[hw_info.display_id] = hw_info;
+  }
+
+  return kErrorNone;
+}
+
+DisplayError HWInfoReplay::GetMaxDisplaysSupported(DisplayType type, int32_t *max_displays) {
+  DRMConnectorsInfo conns_info = {};
+  if (drm_mgr_intf_->GetConnectorsInfo(&conns_info)) {
+    return kErrorUndefined;
+  }
+
+  *max_displays = 0;
+  for (auto &iter : conns_info) {
+    DisplayType display_type = GetDisplayType(iter.second.type);
+    if (display_type != kDisplayTypeMax && (type == kDisplayTypeMax || type == display_type)) {
+      (*max_displays)++;
+    }
+  }
+
+  return kErrorNone;
+}
+
+DisplayError HWInfoReplay::GetRequiredDemuraFetchResourceCount(
+    std::map<uint32_t, uint8_t> *required_demura_fetch_cnt) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWInfoReplay::GetDemuraPanelIds(std::vector<uint64_t> *panel_ids) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWInfoReplay::GetPanelBootParamString(std::string *panel_boot_param_string) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::Init() {
+  if (GetDRMManager(0, &drm_mgr_intf_)) {
+    return kErrorCriticalResource;
+  }
+
+  int ret = (display_id_ >= 0) ? drm_mgr_intf_->RegisterDisplay(display_id_, &token_) :
+            drm_mgr_intf_->RegisterDisplay(type_ == kBuiltIn ? DRMDisplayType::PERIPHERAL :
+                                           DRMDisplayType::TV, &token_);
+  if (ret) {
+    DLOGE("Failed to register display %d-%d, error %d", display_id_, type_, ret);
+    return kErrorResources;
+  }
+  display_id_ = INT32(token_.conn_id);
+
+  drm_mgr_intf_->GetConnectorInfo(token_.conn_id, &connector_info_);
+  if (connector_info_.modes.empty() || drm_mgr_intf_->CreateAtomicReq(token_, &drm_atomic_intf_)) {
+    DLOGE("Display %d has no modes or no atomic request", display_id_);
+    drm_mgr_intf_->UnregisterDisplay(&token_);
+    return kErrorResources;
+  }
+
+  uint32_t min_fps = UINT32_MAX;
+  uint32_t max_fps = 0;
+  for (auto &mode_info : connector_info_.modes) {
+    const drmModeModeInfo &mode = mode_info.mode;
+    HWDisplayAttributes attributes;
+    attributes.x_pixels = mode.hdisplay;
+    attributes.y_pixels = mode.vdisplay;
+    attributes.fps = std::max(mode.vrefresh, 1u);
+    attributes.vsync_period_ns = UINT32(1000000000L / attributes.fps);
+    attributes.h_total = std::max(UINT32(mode.htotal), attributes.x_pixels);
+    attributes.v_total = std::max(UINT32(mode.vtotal), attributes.y_pixels);
+    attributes.clock_khz = mode.clock;
+    attributes.x_dpi = connector_info_.mmWidth ?
+                       FLOAT(mode.hdisplay) * 25.4f / FLOAT(connector_info_.mmWidth) : kDefaultDpi;
+    attributes.y_dpi = connector_info_.mmHeight ?
+                       FLOAT(mode.vdisplay) * 25.4f / FLOAT(connector_info_.mmHeight) : kDefaultDpi;
+    attributes.is_device_split = (attributes.x_pixels > kMaxMixerWidth);
+    attributes.topology = attributes.is_device_split ? kDualLM : kSingleLM;
+    attributes.topology_num_split = attributes.is_device_split ? 2 : 1;
+    attributes.smart_panel = (connector_info_.panel_mode == DRMPanelMode::COMMAND);
+    display_attributes_.push_back(attributes);
+    min_fps = std::min(min_fps, attributes.fps);
+    max_fps = std::max(max_fps, attributes.fps);
+  }
+
+  hw_panel_info_.mode = (connector_info_.panel_mode == DRMPanelMode::COMMAND) ? kModeCommand :
+                        kModeVideo;
+  hw_panel_info_.is_primary_panel = connector_info_.is_primary;
+  hw_panel_info_.is_pluggable = (type_ == kPluggable);
+  hw_panel_info_.min_fps = min_fps;
+  hw_panel_info_.max_fps = max_fps;
+  hw_panel_info_.dynamic_fps = connector_info_.dynamic_fps;
+  hw_panel_info_.qsync_support = connector_info_.qsync_support;
+  snprintf(hw_panel_info_.panel_name, sizeof(hw_panel_info_.panel_name), "%s",
+           connector_info_.panel_name.c_str());
+  SetDisplayAttributes(0);
+
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::Deinit() {
+  if (drm_atomic_intf_) {
+    drm_mgr_intf_->DestroyAtomicReq(drm_atomic_intf_);
+    drm_atomic_intf_ = nullptr;
+    drm_mgr_intf_->UnregisterDisplay(&token_);
+  }
+
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::GetDisplayId(int32_t *display_id) {
+  *display_id = display_id_;
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::GetActiveConfig(uint32_t *active_config) {
+  *active_config = current_mode_index_;
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::GetConfigIndexForFps(uint32_t refresh_rate, uint32_t *config) {
+  const HWDisplayAttributes &current = display_attributes_[current_mode_index_];
+  for (uint32_t i = 0; i < display_attributes_.size(); i++) {
+    const HWDisplayAttributes &attributes = display_attributes_[i];
+    if (attributes.fps == refresh_rate && attributes.x_pixels == current.x_pixels &&
+        attributes.y_pixels == current.y_pixels) {
+      *config = i;
+      return kErrorNone;
+    }
+  }
+
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::GetDefaultConfig(uint32_t *default_config) {
+  *default_config = 0;
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::GetNumDisplayAttributes(uint32_t *count) {
+  *count = UINT32(display_attributes_.size());
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::GetDisplayAttributes(uint32_t index,
+                                                  HWDisplayAttributes *display_attributes) {
+  if (index >= display_attributes_.size()) {
+    return kErrorParameters;
+  }
+
+  *display_attributes = display_attributes_[index];
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::GetHWPanelInfo(HWPanelInfo *panel_info) {
+  *panel_info = hw_panel_info_;
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::SetDisplayAttributes(uint32_t index) {
+  if (index >= display_attributes_.size()) {
+    return kErrorParameters;
+  }
+
+  current_mode_index_ = index;
+  const HWDisplayAttributes &attributes = display_attributes_[index];
+  mixer_attributes_.width = attributes.x_pixels;
+  mixer_attributes_.height = attributes.y_pixels;
+  mixer_attributes_.split_type = attributes.is_device_split ? kDualSplit : kNoSplit;
+  mixer_attributes_.split_left = attributes.is_device_split ? attributes.x_pixels / 2 :
+                                 attributes.x_pixels;
+  hw_panel_info_.split_info.left_split = mixer_attributes_.split_left;
+  hw_panel_info_.split_info.right_split = attributes.x_pixels - mixer_attributes_.split_left;
+
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::SetDisplayAttributes(const HWDisplayAttributes &display_attributes) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::GetConfigIndex(char *mode, uint32_t *index) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::SetActive(bool active, SyncPoints *sync_points) {
+  sde_drm::DRMModeInfo &mode_info = connector_info_.modes[current_mode_index_];
+  drm_atomic_intf_->Perform(DRMOps::CRTC_SET_MODE, token_.crtc_id, &mode_info.mode);
+  drm_atomic_intf_->Perform(DRMOps::CRTC_SET_ACTIVE, token_.crtc_id, active ? 1 : 0);
+  drm_atomic_intf_->Perform(DRMOps::CONNECTOR_SET_CRTC, token_.conn_id,
+                            active ? token_.crtc_id : 0);
+  int ret = drm_atomic_intf_->Commit(true /* synchronous */, false /* retain_planes */);
+  if (ret) {
+    DLOGE("Power %s commit failed with %d on display %d", active ? "on" : "off", ret,
+          display_id_);
+    return kErrorHardware;
+  }
+
+  if (sync_points) {
+    sync_points->retire_fence = nullptr;
+  }
+
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::PowerOn(const HWQosData &qos_data, SyncPoints *sync_points) {
+  return SetActive(true, sync_points);
+}
+
+DisplayError HWDeviceReplay::PowerOff(bool teardown, SyncPoints *sync_points) {
+  return SetActive(false, sync_points);
+}
+
+DisplayError HWDeviceReplay::Doze(const HWQosData &qos_data, SyncPoints *sync_points) {
+  return SetActive(true, sync_points);
+}
+
+DisplayError HWDeviceReplay::DozeSuspend(const HWQosData &qos_data, SyncPoints *sync_points) {
+  return SetActive(true, sync_points);
+}
+
+DisplayError HWDeviceReplay::Standby(SyncPoints *sync_points) {
+  return kErrorNotSupported;
+}
+
+uint32_t HWDeviceReplay::GetFbId(const LayerBuffer &buffer) {
+  auto it = fb_ids_.find(buffer.handle_id);
+  if (it != fb_ids_.end()) {
+    return it->second;
+  }
+
+  uint32_t fb_id = next_fb_id_++;
+  fb_ids_[buffer.handle_id] = fb_id;
+  return fb_id;
+}
+
+void HWDeviceReplay::SetupAtomic(HWLayersInfo *hw_layers_info) {
+  for (uint32_t i = 0; i < hw_layers_info->hw_layers.size(); i++) {
+    Layer &layer = hw_layers_info->hw_layers.at(i);
+    HWLayerConfig &layer_config = hw_layers_info->config[i];
+    for (HWPipeInfo *pipe_info : {&layer_config.left_pipe, &layer_config.right_pipe}) {
+      if (!pipe_info->valid) {
+        continue;
+      }
+
+      uint32_t pipe_id = pipe_info->pipe_id;
+      const LayerRect &src = pipe_info->src_roi;
+      const LayerRect &dst = pipe_info->dst_roi;
+      DRMRect src_rect = {UINT32(src.left), UINT32(src.top), UINT32(src.right),
+                          UINT32(src.bottom)};
+      DRMRect dst_rect = {UINT32(dst.left), UINT32(dst.top), UINT32(dst.right),
+                          UINT32(dst.bottom)};
+      drm_atomic_intf_->Perform(DRMOps::PLANE_SET_SRC_RECT, pipe_id, src_rect);
+      drm_atomic_intf_->Perform(DRMOps::PLANE_SET_DST_RECT, pipe_id, dst_rect);
+      drm_atomic_intf_->Perform(DRMOps::PLANE_SET_ZORDER, pipe_id, pipe_info->z_order);
+      drm_atomic_intf_->Perform(DRMOps::PLANE_SET_ALPHA, pipe_id, UINT32(layer.plane_alpha));
+      drm_atomic_intf_->Perform(DRMOps::PLANE_SET_FB_ID, pipe_id, GetFbId(layer.input_buffer));
+      drm_atomic_intf_->Perform(DRMOps::PLANE_SET_CRTC, pipe_id, token_.crtc_id);
+    }
+  }
+}
+
+DisplayError HWDeviceReplay::Validate(HWLayersInfo *hw_layers_info) {
+  SetupAtomic(hw_layers_info);
+  int ret = drm_atomic_intf_->Validate();
+  if (ret) {
+    DLOGE("Validate failed with %d on display %d", ret, display_id_);
+    return kErrorHardware;
+  }
+
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::Commit(HWLayersInfo *hw_layers_info) {
+  SetupAtomic(hw_layers_info);
+  int64_t release_fence_fd = -1;
+  int64_t retire_fence_fd = -1;
+  drm_atomic_intf_->Perform(DRMOps::CRTC_GET_RELEASE_FENCE, token_.crtc_id, &release_fence_fd);
+  drm_atomic_intf_->Perform(DRMOps::CONNECTOR_GET_RETIRE_FENCE, token_.conn_id, &retire_fence_fd);
+
+  int ret = drm_atomic_intf_->Commit(false /* synchronous */, false /* retain_planes */);
+  shared_ptr<Fence> release_fence = Fence::Create(INT(release_fence_fd), "release");
+  shared_ptr<Fence> retire_fence = Fence::Create(INT(retire_fence_fd), "retire");
+  if (ret) {
+    DLOGE("Commit failed with %d on display %d", ret, display_id_);
+    return kErrorHardware;
+  }
+
+  hw_layers_info->retire_fence = retire_fence;
+  hw_layers_info->sync_handle = release_fence;
+  for (auto &layer : hw_layers_info->hw_layers) {
+    layer.input_buffer.release_fence = release_fence;
+  }
+  hw_layers_info->updates_mask = 0;
+
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::Flush(HWLayersInfo *hw_layers_info) {
+  // Nothing staged, the commit unsets all planes of the CRTC.
+  if (drm_atomic_intf_->Commit(true /* synchronous */, false /* retain_planes */)) {
+    return kErrorHardware;
+  }
+
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::GetPPFeaturesVersion(PPFeatureVersion *vers) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::SetPPFeatures(PPFeaturesConfig *feature_list) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::SetVSyncState(bool enable) {
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::SetDisplayMode(const HWDisplayMode hw_display_mode) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::SetRefreshRate(uint32_t refresh_rate) {
+  uint32_t config = 0;
+  if (GetConfigIndexForFps(refresh_rate, &config) != kErrorNone) {
+    return kErrorNotSupported;
+  }
+
+  return SetDisplayAttributes(config);
+}
+
+DisplayError HWDeviceReplay::SetPanelBrightness(int level) {
+  brightness_ = level;
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::GetHWScanInfo(HWScanInfo *scan_info) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::GetVideoFormat(uint32_t config_index, uint32_t *video_format) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::GetMaxCEAFormat(uint32_t *max_cea_format) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::SetCursorPosition(HWLayersInfo *hw_layers_info, int x, int y) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::OnMinHdcpEncryptionLevelChange(uint32_t min_enc_level) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::GetPanelBrightness(int *level) {
+  *level = brightness_;
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::SetAutoRefresh(bool enable) {
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::SetScaleLutConfig(HWScaleLutInfo *lut_info) {
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::UnsetScaleLutConfig() {
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::SetMixerAttributes(const HWMixerAttributes &mixer_attributes) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::GetMixerAttributes(HWMixerAttributes *mixer_attributes) {
+  *mixer_attributes = mixer_attributes_;
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::DumpDebugData() {
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::SetDppsFeature(void *payload, size_t size) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::GetDppsFeatureInfo(void *payload, size_t size) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::HandleSecureEvent(SecureEvent secure_event,
+                                               const HWQosData &qos_data) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::ControlIdlePowerCollapse(bool enable, bool synchronous) {
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::SetDisplayDppsAdROI(void *payload) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::SetDynamicDSIClock(uint64_t bit_clk_rate) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::GetDynamicDSIClock(uint64_t *bit_clk_rate) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::GetDisplayIdentificationData(uint8_t *out_port,
+                                                          uint32_t *out_data_size,
+                                                          uint8_t *out_data) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::SetFrameTrigger(FrameTriggerMode mode) {
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::SetBLScale(uint32_t level) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::GetPanelBlMaxLvl(uint32_t *max_bl) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::SetPPConfig(void *payload, size_t size) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::GetPanelBrightnessBasePath(std::string *base_path) const {
+  // No sysfs node behind it, DPPS fails to load on the host before using it.
+  *base_path = "/sys/class/backlight/panel0-backlight/";
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::SetBlendSpace(const PrimariesTransfer &blend_space) {
+  return kErrorNone;
+}
+
+DisplayError HWDeviceReplay::EnableSelfRefresh() {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::GetFeatureSupportStatus(const HWFeature feature, uint32_t *status) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::SetAlternateDisplayConfig(uint32_t *alt_config) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::GetQsyncFps(uint32_t *qsync_fps) {
+  return kErrorNotSupported;
+}
+
+DisplayError HWDeviceReplay::CancelDeferredPowerMode() {
+  return kErrorNone;
+}
+
+}  // namespace sdm
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HW_REPLAY_H__
+#define __HW_REPLAY_H__
+
+#include <drm_interface.h>
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "hw_events_interface.h"
+#include "hw_info_interface.h"
+#include "hw_interface.h"
+
+namespace sdm {
+
+// Stand-ins for the DRM implementations of the hw interfaces. hwc_replay links them in place of
+// hw_interface.cpp, hw_info_interface.cpp and hw_events_interface.cpp, so the core runs
+// unchanged on top of them. They describe the target and program frames through the sde-drm
+// DRMManager, which the replay tool runs on DRMFakeBackend: the hardware description comes from
+// the fake's topology and every Validate and Commit becomes an atomic request the fake checks.
+// Nothing is rendered and no fence is ever pending.
+class HWInfoReplay : public HWInfoInterface {
+ public:
+  DisplayError Init() override;
+  DisplayError GetHWResourceInfo(HWResourceInfo *hw_resource) override;
+  DisplayError GetFirstDisplayInterfaceType(HWDisplayInterfaceInfo *hw_disp_info) override;
+  DisplayError GetDisplaysStatus(HWDisplaysInfo *hw_displays_info) override;
+  DisplayError GetMaxDisplaysSupported(DisplayType type, int32_t *max_displays) override;
+  DisplayError GetRequiredDemuraFetchResourceCount(
+      std::map<uint32_t, uint8_t> *required_demura_fetch_cnt) override;
+  DisplayError GetDemuraPanelIds(std::vector<uint64_t> *panel_ids) override;
+  DisplayError GetPanelBootParamString(std::string *panel_boot_param_string) override;
+
+  static DisplayType GetDisplayType(uint32_t connector_type);
+
+ private:
+  sde_drm::DRMManagerInterface *drm_mgr_intf_ = nullptr;
+};
+
+class HWDeviceReplay : public HWInterface {
+ public:
+  HWDeviceReplay(int32_t display_id, DisplayType type) : display_id_(display_id), type_(type) {}
+
+  DisplayError Init() override;
+  DisplayError Deinit() override;
+  DisplayError GetDisplayId(int32_t *display_id) override;
+  DisplayError GetActiveConfig(uint32_t *active_config) override;
+  DisplayError GetConfigIndexForFps(uint32_t refresh_rate, uint32_t *config) override;
+  DisplayError GetDefaultConfig(uint32_t *default_config) override;
+  DisplayError GetNumDisplayAttributes(uint32_t *count) override;
+  DisplayError GetDisplayAttributes(uint32_t index,
+                                    HWDisplayAttributes *display_attributes) override;
+  DisplayError GetHWPanelInfo(HWPanelInfo *panel_info) override;
+  DisplayError SetDisplayAttributes(uint32_t index) override;
+  DisplayError SetDisplayAttributes(const HWDisplayAttributes &display_attributes) override;
+  DisplayError GetConfigIndex(char *mode, uint32_t *index) override;
+  DisplayError PowerOn(const HWQosData &qos_data, SyncPoints *sync_points) override;
+  DisplayError PowerOff(bool teardown, SyncPoints *sync_points) override;
+  DisplayError Doze(const HWQosData &qos_data, SyncPoints *sync_points) override;
+  DisplayError DozeSuspend(const HWQosData &qos_data, SyncPoints *sync_points) override;
+  DisplayError Standby(SyncPoints *sync_points) override;
+  DisplayError Validate(HWLayersInfo *hw_layers_info) override;
+  DisplayError Commit(HWLayersInfo *hw_layers_info) override;
+  DisplayError Flush(HWLayersInfo *hw_layers_info) override;
+  DisplayError GetPPFeaturesVersion(PPFeatureVersion *vers) override;
+  DisplayError SetPPFeatures(PPFeaturesConfig *feature_list) override;
+  DisplayError SetVSyncState(bool enable) override;
+  void SetIdleTimeoutMs(uint32_t timeout_ms) override {}
+  DisplayError SetDisplayMode(const HWDisplayMode hw_display_mode) override;
+  DisplayError SetRefreshRate(uint32_t refresh_rate) override;
+  DisplayError SetPanelBrightness(int level) override;
+  DisplayError GetHWScanInfo(HWScanInfo *scan_info) override;
+  DisplayError GetVideoFormat(uint32_t config_index, uint32_t *video_format) override;
+  DisplayError GetMaxCEAFormat(uint32_t *max_cea_format) override;
+  DisplayError SetCursorPosition(HWLayersInfo *hw_layers_info, int x, int y) override;
+  DisplayError OnMinHdcpEncryptionLevelChange(uint32_t min_enc_level) override;
+  DisplayError GetPanelBrightness(int *level) override;
+  DisplayError SetAutoRefresh(bool enable) override;
+  DisplayError SetScaleLutConfig(HWScaleLutInfo *lut_info) override;
+  DisplayError UnsetScaleLutConfig() override;
+  DisplayError SetMixerAttributes(const HWMixerAttributes &mixer_attributes) override;
+  DisplayError GetMixerAttributes(HWMixerAttributes *mixer_attributes) override;
+  DisplayError DumpDebugData() override;
+  DisplayError SetDppsFeature(void *payload, size_t size) override;
+  DisplayError GetDppsFeatureInfo(void *payload, size_t size) override;
+  DisplayError HandleSecureEvent(SecureEvent secure_event, const HWQosData &qos_data) override;
+  DisplayError ControlIdlePowerCollapse(bool enable, bool synchronous) override;
+  DisplayError SetDisplayDppsAdROI(void *payload) override;
+  DisplayError SetDynamicDSIClock(uint64_t bit_clk_rate) override;
+  DisplayError GetDynamicDSIClock(uint64_t *bit_clk_rate) override;
+  DisplayError GetDisplayIdentificationData(uint8_t *out_port, uint32_t *out_data_size,
+                                            uint8_t *out_data) override;
+  DisplayError SetFrameTrigger(FrameTriggerMode mode) override;
+  DisplayError SetBLScale(uint32_t level) override;
+  DisplayError GetPanelBlMaxLvl(uint32_t *max_bl) override;
+  DisplayError SetPPConfig(void *payload, size_t size) override;
+  DisplayError GetPanelBrightnessBasePath(std::string *base_path) const override;
+  DisplayError SetBlendSpace(const PrimariesTransfer &blend_space) override;
+  DisplayError EnableSelfRefresh() override;
+  PanelFeaturePropertyIntf *GetPanelFeaturePropertyIntf() override { return nullptr; }
+  DisplayError GetFeatureSupportStatus(const HWFeature feature, uint32_t *status) override;
+  void FlushConcurrentWriteback() override {}
+  DisplayError SetAlternateDisplayConfig(uint32_t *alt_config) override;
+  DisplayError GetQsyncFps(uint32_t *qsync_fps) override;
+  DisplayError CancelDeferredPowerMode() override;
+
+ private:
+  void SetupAtomic(HWLayersInfo *hw_layers_info);
+  DisplayError SetActive(bool active, SyncPoints *sync_points);
+  uint32_t GetFbId(const LayerBuffer &buffer);
+
+  int32_t display_id_ = -1;
+  DisplayType type_ = kDisplayTypeMax;
+  sde_drm::DRMManagerInterface *drm_mgr_intf_ = nullptr;
+  sde_drm::DRMAtomicReqInterface *drm_atomic_intf_ = nullptr;
+  sde_drm::DRMDisplayToken token_ = {};
+  sde_drm::DRMConnectorInfo connector_info_ = {};
+  std::vector<HWDisplayAttributes> display_attributes_;
+  HWMixerAttributes mixer_attributes_ = {};
+  HWPanelInfo hw_panel_info_ = {};
+  uint32_t current_mode_index_ = 0;
+  int brightness_ = 0;
+  // Buffers get stable framebuffer ids, the fake accepts any non zero FB_ID.
+  std::map<uint64_t, uint32_t> fb_ids_;
+  uint32_t next_fb_id_ = 1;
+};
+
+// No event thread, replay drives frames back to back and nothing raises events.
+class HWEventsReplay : public HWEventsInterface {
+ public:
+  DisplayError Init(int display_id, DisplayType display_type, HWEventHandler *event_handler,
+                    const std::vector<HWEvent> &event_list,
+                    const HWInterface *hw_intf) override {
+    return kErrorNone;
+  }
+  DisplayError Deinit() override { return kErrorNone; }
+  DisplayError SetEventState(HWEvent event, bool enable, void *aux = nullptr) override {
+    return kErrorNone;
+  }
+};
+
+}  // namespace sdm
+
+#endif  // __HW_REPLAY_H__
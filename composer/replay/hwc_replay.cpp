@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * hwc_replay - replays a composer command capture (see hwc_command_recorder.h) through the SDM
+ * core without a device. The core runs on the stand-in hw interfaces of hw_replay.h, which
+ * commit through the sde-drm DRMManager on DRMFakeBackend, so strategy selection, resource
+ * assignment and atomic request building all run as on target. It reports what each stage cost
+ * the replaying thread per frame, in CPU time and heap allocations.
+ *
+ *   hwc_replay [--topology <json>] [--loops <n>] [--verbose] <capture>
+ */
+
+#include <core/core_interface.h>
+#include <core/display_interface.h>
+#include <drm_fake_backend.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <utils/constants.h>
+
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../hwc_capture_format.h"
+#include "replay_display.h"
+#include "replay_handlers.h"
+#include "replay_stats.h"
+
+extern "C" int DestroyDRMManager();
+
+using sde_drm::DRMBackend;
+using sde_drm::DRMFakeBackend;
+
+namespace sdm {
+
+// A command mode 1080x2400 panel on 2 VIG and 4 DMA pipes, used when no --topology is given.
+static std::string MakeDefaultTopology() {
+  std::ostringstream json;
+  json << R"({
+  "crtcs": [
+    { "properties": { "ACTIVE": 0, "MODE_ID": { "type": "blob" }, "output_fence": 0,
+                      "capabilities": "max_blendstages=11\nqseed_type=qseed3\n" } } ],
+  "encoders": [ { "type": 2, "possible_crtcs": 1 } ],
+  "connectors": [
+    { "type": 16, "encoder": 0,
+      "modes": [ { "name": "1080x2400", "clock": 340000, "hdisplay": 1080, "vdisplay": 2400,
+                   "htotal": 1200, "vtotal": 2500, "vrefresh": 120 },
+                 { "name": "1080x2400", "clock": 170000, "hdisplay": 1080, "vdisplay": 2400,
+                   "htotal": 1200, "vtotal": 2500, "vrefresh": 60 } ],
+      "properties": { "CRTC_ID": 0, "RETIRE_FENCE": 0,
+                      "capabilities": ")"
+                      "display type=primary\npanel name=replay panel\npanel mode=command\n"
+                      R"(" } } ],
+  "planes": [)";
+  for (int i = 0; i < 6; i++) {
+    bool vig = (i < 2);
+    json << (i ? "," : "") << R"(
+    { "possible_crtcs": 1, "formats": [ "AR24", "XR24", "RG16")" << (vig ? R"(, "NV12")" : "");
+    json << R"( ],
+      "properties": { "CRTC_ID": 0, "FB_ID": 0, "SRC_X": 0, "SRC_Y": 0, "SRC_W": 0, "SRC_H": 0,
+                      "CRTC_X": 0, "CRTC_Y": 0, "CRTC_W": 0, "CRTC_H": 0, "alpha": 0,
+                      "excl_rect_v1": 0, "zpos": { "min": 0, "max": 255 },
+                      "type": { "type": "enum", "enums": [ "Overlay", "Primary", "Cursor" ] },)";
+    if (vig) {
+      json << R"( "csc_v1": { "type": "blob" }, "scaler_v2": { "type": "blob" },)";
+    }
+    json << R"(
+                      "capabilities": "max_linewidth=)" << (vig ? 4096 : 2560);
+    json << (vig ? R"(\nmax_upscale=20\nmax_downscale=4)" : "");
+    json << R"(\npipe_idx=)" << i << R"(\n" } })";
+  }
+  json << R"(
+  ]
+})";
+  return json.str();
+}
+
+// Displays never raise events during replay, see HWEventsReplay.
+class ReplayEventHandler : public DisplayEventHandler {
+ public:
+  DisplayError VSync(const DisplayEventVSync &vsync) override { return kErrorNone; }
+  DisplayError Refresh() override { return kErrorNone; }
+  DisplayError CECMessage(char *message) override { return kErrorNone; }
+  DisplayError HistogramEvent(int source_fd, uint32_t blob_id) override { return kErrorNone; }
+  DisplayError HandleEvent(DisplayEvent event) override { return kErrorNone; }
+  void MMRMEvent(bool restricted) override {}
+};
+
+static int Usage(const char *name) {
+  fprintf(stderr, "usage: %s [--topology <json>] [--loops <n>] [--verbose] <capture>\n", name);
+  return EXIT_FAILURE;
+}
+
+static int Replay(int argc, char **argv) {
+  std::string topology_path;
+  std::string capture_path;
+  int loops = 1;
+  bool verbose = false;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--topology") && i + 1 < argc) {
+      topology_path = argv[++i];
+    } else if (!strcmp(argv[i], "--loops") && i + 1 < argc) {
+      loops = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--verbose")) {
+      verbose = true;
+    } else if (argv[i][0] != '-' && capture_path.empty()) {
+      capture_path = argv[i];
+    } else {
+      return Usage(argv[0]);
+    }
+  }
+  if (capture_path.empty() || loops < 1) {
+    return Usage(argv[0]);
+  }
+
+  std::vector<CapturedFrame> frames;
+  int ret = ReadCapture(capture_path, &frames);
+  if (ret) {
+    fprintf(stderr, "Failed to read %s: %s\n", capture_path.c_str(), strerror(-ret));
+    return EXIT_FAILURE;
+  }
+
+  DRMFakeBackend backend;
+  ret = topology_path.empty() ? backend.LoadTopology(MakeDefaultTopology()) :
+        backend.LoadTopologyFile(topology_path);
+  if (ret) {
+    fprintf(stderr, "Failed to load the topology: %s\n", strerror(-ret));
+    return EXIT_FAILURE;
+  }
+  DRMBackend::Set(&backend);
+  ReplayDebugHandler debug_handler(verbose);
+  DebugHandler::Set(&debug_handler);
+
+  ReplayBufferAllocator buffer_allocator;
+  ReplaySyncHandler buffer_sync_handler;
+  ReplaySocketHandler socket_handler;
+  CoreInterface *core_intf = nullptr;
+  DisplayError error = CoreInterface::CreateCore(&buffer_allocator, &buffer_sync_handler,
+                                                 &socket_handler, nullptr, &core_intf);
+  if (error != kErrorNone) {
+    fprintf(stderr, "Failed to create the core, error %d\n", error);
+    DebugHandler::Set(nullptr);
+    DRMBackend::Set(nullptr);
+    return EXIT_FAILURE;
+  }
+
+  // Composer display ids are handed out in this order too, primary first.
+  HWDisplaysInfo hw_displays_info = {};
+  core_intf->GetDisplaysStatus(&hw_displays_info);
+  std::vector<int32_t> display_ids;
+  for (auto &iter : hw_displays_info) {
+    const HWDisplayInfo &info = iter.second;
+    if (!info.is_connected || (info.display_type != kBuiltIn &&
+                               info.display_type != kPluggable)) {
+      continue;
+    }
+    display_ids.insert(info.is_primary ? display_ids.begin() : display_ids.end(),
+                       info.display_id);
+  }
+
+  ReplayEventHandler event_handler;
+  ReplayComposer composer;
+  std::vector<DisplayInterface *> displays;
+  for (int32_t display_id : display_ids) {
+    DisplayInterface *display_intf = nullptr;
+    if (core_intf->CreateDisplay(display_id, &event_handler, &display_intf) != kErrorNone) {
+      fprintf(stderr, "Failed to create display %d\n", display_id);
+      continue;
+    }
+    shared_ptr<Fence> release_fence = nullptr;
+    display_intf->SetDisplayState(kStateOn, false /* teardown */, &release_fence);
+    composer.AddDisplay(displays.size(), display_intf);
+    displays.push_back(display_intf);
+  }
+
+  if (displays.empty()) {
+    fprintf(stderr, "No display to replay on\n");
+  } else {
+    for (int loop = 0; loop < loops; loop++) {
+      for (auto &frame : frames) {
+        composer.Execute(frame);
+      }
+    }
+  }
+
+  std::ostringstream os;
+  os << capture_path << ": " << frames.size() << " calls x " << loops << " loops on ";
+  os << displays.size() << " displays\n";
+  composer.Dump(&os);
+  DRMFakeBackend::Stats stats;
+  backend.GetStats(&stats);
+  os << "drm: " << stats.commits << " commits, " << stats.test_commits << " test only, ";
+  os << stats.rejected << " rejected, " << stats.properties_set << " properties set, ";
+  os << stats.blobs << " blobs\n";
+  std::cout << os.str();
+
+  for (DisplayInterface *display_intf : displays) {
+    shared_ptr<Fence> release_fence = nullptr;
+    display_intf->SetDisplayState(kStateOff, true /* teardown */, &release_fence);
+    core_intf->DestroyDisplay(display_intf);
+  }
+  CoreInterface::DestroyCore();
+  DestroyDRMManager();
+  DebugHandler::Set(nullptr);
+  DRMBackend::Set(nullptr);
+
+  return displays.empty() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+}  // namespace sdm
+
+int main(int argc, char **argv) {
+  return sdm::Replay(argc, argv);
+}
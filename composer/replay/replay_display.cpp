@@ -0,0 +1,413 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <string.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "replay_display.h"
+#include "replay_handlers.h"
+
+#define __CLASS__ "ReplayDisplay"
+
+namespace sdm {
+
+// IComposerClient::Command headers carry the opcode in the upper and the length in the lower half.
+static const uint32_t kOpcodeShift = 16;
+static const uint32_t kLengthMask = 0xffff;
+
+// Transform bits of IComposerClient::Transform.
+static const uint32_t kTransformFlipH = 0x1;
+static const uint32_t kTransformFlipV = 0x2;
+static const uint32_t kTransformRot90 = 0x4;
+
+ReplayDisplay::ReplayDisplay(uint64_t id, DisplayInterface *display_intf)
+  : id_(id), display_intf_(display_intf) {
+  DisplayConfigVariableInfo fb_config = {};
+  display_intf_->GetFrameBufferConfig(&fb_config);
+  client_target_.composition = kCompositionGPUTarget;
+  client_target_.src_rect = {0, 0, FLOAT(fb_config.x_pixels), FLOAT(fb_config.y_pixels)};
+  client_target_.dst_rect = client_target_.src_rect;
+  LayerBuffer *buffer = &client_target_.input_buffer;
+  buffer->width = ALIGN(fb_config.x_pixels, 16u);
+  buffer->height = fb_config.y_pixels;
+  buffer->unaligned_width = fb_config.x_pixels;
+  buffer->unaligned_height = fb_config.y_pixels;
+  buffer->format = kFormatRGBA8888Ubwc;
+}
+
+void ReplayDisplay::CreateLayer(uint64_t layer_id) {
+  ReplayLayer &replay_layer = layers_[layer_id];
+  replay_layer.layer.layer_id = layer_id;
+  geometry_changed_ = true;
+}
+
+void ReplayDisplay::DestroyLayer(uint64_t layer_id) {
+  if (layers_.erase(layer_id)) {
+    display_intf_->DestroyLayer();
+    geometry_changed_ = true;
+  }
+}
+
+ReplayDisplay::ReplayLayer *ReplayDisplay::GetLayer(uint64_t layer_id) {
+  auto it = layers_.find(layer_id);
+  if (it == layers_.end()) {
+    CreateLayer(layer_id);
+    it = layers_.find(layer_id);
+  }
+
+  return &it->second;
+}
+
+void ReplayDisplay::SetLayerBuffer(ReplayLayer *layer, uint32_t slot,
+                                   const CaptureHandle *handle) {
+  if (handle) {
+    layer->slots[slot] = *handle;
+  } else {
+    auto it = layer->slots.find(slot);
+    if (it == layer->slots.end()) {
+      return;
+    }
+    handle = &it->second;
+  }
+
+  LayerBuffer *buffer = &layer->layer.input_buffer;
+  uint32_t width = buffer->width, height = buffer->height;
+  LayerBufferFormat format = buffer->format;
+  ReplayBufferAllocator::DescribeBuffer(*handle, buffer);
+  if (width != buffer->width || height != buffer->height || format != buffer->format) {
+    layer->layer.geometry_changes |= kBufferGeometry;
+    geometry_changed_ = true;
+  }
+  layer->layer.flags.updating = true;
+}
+
+void ReplayDisplay::SetClientTarget(uint32_t slot, const CaptureHandle *handle) {
+  if (handle) {
+    client_target_slots_[slot] = *handle;
+  } else {
+    auto it = client_target_slots_.find(slot);
+    if (it == client_target_slots_.end()) {
+      return;
+    }
+    handle = &it->second;
+  }
+
+  ReplayBufferAllocator::DescribeBuffer(*handle, &client_target_.input_buffer);
+  client_target_.flags.updating = true;
+  has_client_target_ = true;
+}
+
+void ReplayDisplay::BuildLayerStack() {
+  layer_stack_ = LayerStack();
+  layer_stack_.flags.layer_id_support = true;
+  layer_stack_.flags.geometry_changed = geometry_changed_;
+
+  std::vector<ReplayLayer *> sorted;
+  sorted.reserve(layers_.size());
+  for (auto &iter : layers_) {
+    sorted.push_back(&iter.second);
+  }
+  std::stable_sort(sorted.begin(), sorted.end(), [](ReplayLayer *a, ReplayLayer *b) {
+    return a->z_order < b->z_order;
+  });
+
+  for (ReplayLayer *replay_layer : sorted) {
+    Layer *layer = &replay_layer->layer;
+    bool updating = layer->flags.updating;
+    layer->flags = {};
+    layer->flags.updating = updating;
+    layer->composition = kCompositionGPU;
+    if (replay_layer->composition == kClient || !has_client_target_) {
+      layer->flags.skip = true;
+    } else if (replay_layer->composition == kSolidColor) {
+      layer->flags.solid_fill = true;
+    } else if (replay_layer->composition == kCursor && replay_layer == sorted.back()) {
+      layer->flags.cursor = true;
+      layer_stack_.flags.cursor_present = true;
+    }
+    if (layer->flags.skip) {
+      layer_stack_.flags.skip_present = true;
+    }
+
+    // SDM requires these details even for solid fill.
+    if (layer->flags.solid_fill) {
+      LayerBuffer *buffer = &layer->input_buffer;
+      buffer->width = UINT32(layer->dst_rect.right - layer->dst_rect.left);
+      buffer->height = UINT32(layer->dst_rect.bottom - layer->dst_rect.top);
+      buffer->unaligned_width = buffer->width;
+      buffer->unaligned_height = buffer->height;
+      layer->src_rect = {0, 0, FLOAT(buffer->width), FLOAT(buffer->height)};
+    }
+    layer_stack_.layers.push_back(layer);
+  }
+
+  client_target_.flags.skip = false;
+  layer_stack_.layers.push_back(&client_target_);
+}
+
+void ReplayDisplay::PostCommit() {
+  for (auto &iter : layers_) {
+    iter.second.layer.flags.updating = false;
+    iter.second.layer.geometry_changes = kNone;
+    iter.second.layer.input_buffer.release_fence = nullptr;
+  }
+  client_target_.flags.updating = false;
+  client_target_.input_buffer.release_fence = nullptr;
+  geometry_changed_ = false;
+  validated_ = false;
+}
+
+DisplayError ReplayDisplay::Validate(ReplayStageStats *prepare) {
+  ReplayStage stage(prepare);
+  BuildLayerStack();
+  DisplayError error = display_intf_->Prepare(&layer_stack_);
+  validated_ = (error == kErrorNone || error == kErrorNeedsCommit);
+
+  return error;
+}
+
+DisplayError ReplayDisplay::Present(ReplayStageStats *prepare, ReplayStageStats *commit) {
+  if (!validated_) {
+    DisplayError error = Validate(prepare);
+    if (!validated_) {
+      return error;
+    }
+  }
+
+  ReplayStage stage(commit);
+  DisplayError error = display_intf_->Commit(&layer_stack_);
+  PostCommit();
+
+  return error;
+}
+
+void ReplayComposer::AddDisplay(uint64_t id, DisplayInterface *display_intf) {
+  displays_[id].reset(new ReplayDisplay(id, display_intf));
+}
+
+const CaptureHandle *ReplayComposer::GetHandle(const std::vector<CaptureHandle> &handles,
+                                               int32_t index) {
+  // The display then uses the buffer it holds in the slot.
+  if (index == kHandleCached) {
+    return nullptr;
+  }
+
+  if (index < 0 || size_t(index) >= handles.size() ||
+      handles[size_t(index)].type != kCaptureHandleBuffer) {
+    return nullptr;
+  }
+
+  return &handles[size_t(index)];
+}
+
+LayerRect ReplayComposer::GetRect(const uint32_t *args, bool is_float) {
+  float values[4];
+  for (int i = 0; i < 4; i++) {
+    if (is_float) {
+      memcpy(&values[i], &args[i], sizeof(float));
+    } else {
+      values[i] = FLOAT(INT32(args[i]));
+    }
+  }
+
+  return LayerRect(values[0], values[1], values[2], values[3]);
+}
+
+void ReplayComposer::Execute(const CapturedFrame &frame) {
+  for (auto &event : frame.layer_events) {
+    auto it = displays_.find(event.display);
+    if (it == displays_.end()) {
+      continue;
+    }
+    if (event.type == kCaptureLayerCreate) {
+      it->second->CreateLayer(event.layer);
+    } else {
+      it->second->DestroyLayer(event.layer);
+    }
+  }
+
+  if (frame.words.empty()) {
+    return;
+  }
+
+  // Decode time is the whole call less what the core spent in it.
+  ReplayStageStats call;
+  uint64_t nested_cpu_ns = prepare_.cpu_ns + commit_.cpu_ns;
+  uint64_t nested_wall_ns = prepare_.wall_ns + commit_.wall_ns;
+  uint64_t nested_allocations = prepare_.allocations + commit_.allocations;
+  uint64_t nested_bytes = prepare_.allocated_bytes + commit_.allocated_bytes;
+  {
+    ReplayStage stage(&call);
+    const uint32_t *words = frame.words.data();
+    size_t num_words = frame.words.size();
+    size_t pos = 0;
+    // Like the composer's reader, every call starts without a selected display or layer.
+    display_ = nullptr;
+    layer_ = nullptr;
+    while (pos < num_words) {
+      uint32_t header = words[pos++];
+      uint32_t opcode = header >> kOpcodeShift;
+      uint32_t length = header & kLengthMask;
+      if (pos + length > num_words) {
+        DLOGW("Frame %" PRIu64 " ends inside command 0x%x", frame.header.frame, opcode);
+        errors_++;
+        break;
+      }
+      ExecuteCommand(opcode, &words[pos], length, frame.handles);
+      commands_++;
+      pos += length;
+    }
+  }
+  frames_++;
+
+  uint64_t cpu_ns = call.cpu_ns - (prepare_.cpu_ns + commit_.cpu_ns - nested_cpu_ns);
+  decode_.calls++;
+  decode_.cpu_ns += cpu_ns;
+  decode_.max_cpu_ns = std::max(decode_.max_cpu_ns, cpu_ns);
+  decode_.wall_ns += call.wall_ns - (prepare_.wall_ns + commit_.wall_ns - nested_wall_ns);
+  decode_.allocations += call.allocations -
+                         (prepare_.allocations + commit_.allocations - nested_allocations);
+  decode_.allocated_bytes += call.allocated_bytes -
+                             (prepare_.allocated_bytes + commit_.allocated_bytes - nested_bytes);
+}
+
+void ReplayComposer::ExecuteCommand(uint32_t opcode, const uint32_t *args, uint32_t length,
+                                    const std::vector<CaptureHandle> &handles) {
+  if (opcode == kSelectDisplay) {
+    auto it = (length >= 2) ? displays_.find(UINT64(args[0]) | (UINT64(args[1]) << 32)) :
+              displays_.end();
+    display_ = (it != displays_.end()) ? it->second.get() : nullptr;
+    layer_ = nullptr;
+    return;
+  }
+
+  if (!display_) {
+    ignored_commands_++;
+    return;
+  }
+
+  DisplayError error = kErrorNone;
+  switch (opcode) {
+    case kSelectLayer:
+      layer_ = (length >= 2) ? display_->GetLayer(UINT64(args[0]) | (UINT64(args[1]) << 32)) :
+               nullptr;
+      break;
+    case kSetClientTarget:
+      if (length >= 4 && INT32(args[1]) != kHandleEmpty) {
+        display_->SetClientTarget(args[0], GetHandle(handles, INT32(args[1])));
+      }
+      break;
+    case kValidateDisplay:
+      error = display_->Validate(&prepare_);
+      break;
+    case kAcceptDisplayChanges:
+      break;
+    case kPresentDisplay:
+    case kPresentOrValidateDisplay:
+      error = display_->Present(&prepare_, &commit_);
+      break;
+    case kSetLayerBuffer:
+      if (layer_ && length >= 3 && INT32(args[1]) != kHandleEmpty) {
+        display_->SetLayerBuffer(layer_, args[0], GetHandle(handles, INT32(args[1])));
+      }
+      break;
+    default:
+      ExecuteLayerCommand(opcode, args, length);
+      break;
+  }
+
+  if (error != kErrorNone && error != kErrorNeedsCommit) {
+    errors_++;
+  }
+}
+
+void ReplayComposer::ExecuteLayerCommand(uint32_t opcode, const uint32_t *args,
+                                         uint32_t length) {
+  if (!layer_ || !length) {
+    ignored_commands_++;
+    return;
+  }
+
+  Layer *layer = &layer_->layer;
+  uint32_t geometry_change = kNone;
+  switch (opcode) {
+    case kSetLayerBlendMode:
+      // IComposerClient::BlendMode, NONE is 1.
+      layer->blending = (args[0] == 1) ? kBlendingOpaque :
+                        (args[0] == 3) ? kBlendingCoverage : kBlendingPremultiplied;
+      geometry_change = kBlendMode;
+      break;
+    case kSetLayerCompositionType:
+      if (layer_->composition != INT32(args[0])) {
+        layer_->composition = INT32(args[0]);
+        display_->SetGeometryChanged();
+      }
+      break;
+    case kSetLayerDisplayFrame:
+      if (length >= 4) {
+        layer->dst_rect = GetRect(args, false);
+        geometry_change = kDisplayFrame;
+      }
+      break;
+    case kSetLayerPlaneAlpha: {
+      float alpha = 1.0f;
+      memcpy(&alpha, args, sizeof(alpha));
+      layer->plane_alpha = UINT8(std::min(std::max(alpha, 0.0f), 1.0f) * 255.0f + 0.5f);
+      geometry_change = kPlaneAlpha;
+      break;
+    }
+    case kSetLayerSourceCrop:
+      if (length >= 4) {
+        layer->src_rect = GetRect(args, true);
+        geometry_change = kSourceCrop;
+      }
+      break;
+    case kSetLayerTransform:
+      layer->transform.flip_horizontal = (args[0] & kTransformFlipH);
+      layer->transform.flip_vertical = (args[0] & kTransformFlipV);
+      layer->transform.rotation = (args[0] & kTransformRot90) ? 90.0f : 0.0f;
+      geometry_change = kTransform;
+      break;
+    case kSetLayerVisibleRegion:
+      layer->visible_regions.clear();
+      for (uint32_t i = 0; i + 4 <= length; i += 4) {
+        layer->visible_regions.push_back(GetRect(&args[i], false));
+      }
+      break;
+    case kSetLayerZOrder:
+      if (layer_->z_order != args[0]) {
+        layer_->z_order = args[0];
+        geometry_change = kZOrder;
+      }
+      break;
+    default:
+      // Damage, dataspace, color and metadata do not affect the strategy the replay profiles.
+      ignored_commands_++;
+      return;
+  }
+
+  if (geometry_change != kNone) {
+    layer->geometry_changes |= geometry_change;
+    display_->SetGeometryChanged();
+  }
+}
+
+void ReplayComposer::Dump(std::ostringstream *os) {
+  *os << "frames " << frames_ << ", commands " << commands_ << ", ignored " << ignored_commands_;
+  *os << ", errors " << errors_ << "\n";
+  for (auto &iter : displays_) {
+    *os << "display " << iter.first << ": " << iter.second->GetLayerCount() << " layers\n";
+  }
+  decode_.Dump("decode", frames_, os);
+  prepare_.Dump("prepare", frames_, os);
+  commit_.Dump("commit", frames_, os);
+}
+
+}  // namespace sdm
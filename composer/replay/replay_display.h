@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __REPLAY_DISPLAY_H__
+#define __REPLAY_DISPLAY_H__
+
+#include <core/display_interface.h>
+#include <core/layer_stack.h>
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include "../hwc_capture_format.h"
+#include "replay_stats.h"
+
+namespace sdm {
+
+// The composer state of one display as far as the command stream sets it: the layers with their
+// buffer slots and geometry, and the client target. Frames are built into a LayerStack the way
+// HWCDisplay::BuildLayerStack does, minus the gralloc metadata, color and HDR handling, which the
+// capture does not carry.
+class ReplayDisplay {
+ public:
+  // Composition types of IComposerClient.
+  enum Composition : int32_t {
+    kClient = 1,
+    kDevice = 2,
+    kSolidColor = 3,
+    kCursor = 4,
+    kSideband = 5,
+  };
+
+  struct ReplayLayer {
+    Layer layer;
+    uint32_t z_order = 0;
+    int32_t composition = kDevice;
+    std::map<uint32_t, CaptureHandle> slots;  // buffer cache of the client, by slot
+  };
+
+  ReplayDisplay(uint64_t id, DisplayInterface *display_intf);
+
+  void CreateLayer(uint64_t layer_id);
+  void DestroyLayer(uint64_t layer_id);
+  // Layers created before the capture started show up in commands only, they are created then.
+  ReplayLayer *GetLayer(uint64_t layer_id);
+  void SetLayerBuffer(ReplayLayer *layer, uint32_t slot, const CaptureHandle *handle);
+  void SetClientTarget(uint32_t slot, const CaptureHandle *handle);
+  void SetGeometryChanged() { geometry_changed_ = true; }
+
+  DisplayError Validate(ReplayStageStats *prepare);
+  DisplayError Present(ReplayStageStats *prepare, ReplayStageStats *commit);
+
+  uint64_t GetId() const { return id_; }
+  size_t GetLayerCount() const { return layers_.size(); }
+
+ private:
+  void BuildLayerStack();
+  void PostCommit();
+
+  uint64_t id_ = 0;
+  DisplayInterface *display_intf_ = nullptr;
+  std::map<uint64_t, ReplayLayer> layers_;
+  LayerStack layer_stack_;
+  Layer client_target_;
+  std::map<uint32_t, CaptureHandle> client_target_slots_;
+  bool has_client_target_ = false;
+  bool geometry_changed_ = true;
+  bool validated_ = false;
+};
+
+// Decodes captured executeCommands buffers and drives the displays with them.
+class ReplayComposer {
+ public:
+  // Commands for capture display |id| go to |display_intf|.
+  void AddDisplay(uint64_t id, DisplayInterface *display_intf);
+  void Execute(const CapturedFrame &frame);
+  void Dump(std::ostringstream *os);
+
+ private:
+  // Opcodes of IComposerClient::Command, the upper half of a command header.
+  enum Command : uint32_t {
+    kSelectDisplay = 0x000,
+    kSelectLayer = 0x001,
+    kSetClientTarget = 0x201,
+    kValidateDisplay = 0x203,
+    kAcceptDisplayChanges = 0x204,
+    kPresentDisplay = 0x205,
+    kPresentOrValidateDisplay = 0x206,
+    kSetLayerBuffer = 0x301,
+    kSetLayerBlendMode = 0x400,
+    kSetLayerCompositionType = 0x402,
+    kSetLayerDisplayFrame = 0x404,
+    kSetLayerPlaneAlpha = 0x405,
+    kSetLayerSourceCrop = 0x407,
+    kSetLayerTransform = 0x408,
+    kSetLayerVisibleRegion = 0x409,
+    kSetLayerZOrder = 0x40a,
+  };
+
+  // Handle indices in place of an entry of the handle array.
+  static const int32_t kHandleEmpty = -1;
+  static const int32_t kHandleCached = -2;
+
+  void ExecuteCommand(uint32_t opcode, const uint32_t *args, uint32_t length,
+                      const std::vector<CaptureHandle> &handles);
+  void ExecuteLayerCommand(uint32_t opcode, const uint32_t *args, uint32_t length);
+  static const CaptureHandle *GetHandle(const std::vector<CaptureHandle> &handles, int32_t index);
+  static LayerRect GetRect(const uint32_t *args, bool is_float);
+
+  std::map<uint64_t, std::unique_ptr<ReplayDisplay>> displays_;
+  ReplayDisplay *display_ = nullptr;
+  ReplayDisplay::ReplayLayer *layer_ = nullptr;
+  uint64_t frames_ = 0;
+  uint64_t commands_ = 0;
+  uint64_t ignored_commands_ = 0;
+  uint64_t errors_ = 0;
+  ReplayStageStats decode_;
+  ReplayStageStats prepare_;
+  ReplayStageStats commit_;
+};
+
+}  // namespace sdm
+
+#endif  // __REPLAY_DISPLAY_H__
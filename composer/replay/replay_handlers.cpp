@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+#include <utils/fence.h>
+
+#include <algorithm>
+
+#include "replay_handlers.h"
+
+#define __CLASS__ "ReplayHandlers"
+
+namespace sdm {
+
+// android_pixel_format_t and the QTI extensions, the host has no graphics headers.
+enum HalPixelFormat : uint32_t {
+  kHalRGBA8888 = 0x1,
+  kHalRGBX8888 = 0x2,
+  kHalRGB888 = 0x3,
+  kHalRGB565 = 0x4,
+  kHalBGRA8888 = 0x5,
+  kHalYCrCb420SP = 0x11,
+  kHalRGBA1010102 = 0x2B,
+  kHalNV12Encodeable = 0x102,
+  kHalYCbCr420SPVenus = 0x7FA30C04,
+  kHalYCbCr420SPVenusUbwc = 0x7FA30C06,
+};
+
+// GRALLOC_USAGE_PRIVATE_ALLOC_UBWC, the usage bit gralloc turns into PRIV_FLAGS_UBWC_ALIGNED.
+static const uint64_t kUsageUbwc = 1ULL << 28;
+
+LayerBufferFormat ReplayBufferAllocator::GetSDMFormat(uint32_t hal_format, uint64_t usage) {
+  bool ubwc = (usage & kUsageUbwc);
+  switch (hal_format) {
+    case kHalRGBA8888:
+      return ubwc ? kFormatRGBA8888Ubwc : kFormatRGBA8888;
+    case kHalRGBX8888:
+      return ubwc ? kFormatRGBX8888Ubwc : kFormatRGBX8888;
+    case kHalRGB888:
+      return kFormatRGB888;
+    case kHalRGB565:
+      return kFormatRGB565;
+    case kHalBGRA8888:
+      return kFormatBGRA8888;
+    case kHalYCrCb420SP:
+      return kFormatYCrCb420SemiPlanar;
+    case kHalRGBA1010102:
+      return ubwc ? kFormatRGBA1010102Ubwc : kFormatRGBA1010102;
+    case kHalNV12Encodeable:
+    case kHalYCbCr420SPVenus:
+      return ubwc ? kFormatYCbCr420SPVenusUbwc : kFormatYCbCr420SemiPlanarVenus;
+    case kHalYCbCr420SPVenusUbwc:
+      return kFormatYCbCr420SPVenusUbwc;
+    default:
+      // Close enough for strategy purposes, the replay never reads the pixels.
+      return ubwc ? kFormatRGBA8888Ubwc : kFormatRGBA8888;
+  }
+}
+
+void ReplayBufferAllocator::DescribeBuffer(const CaptureHandle &handle, LayerBuffer *buffer) {
+  buffer->format = GetSDMFormat(handle.format, handle.usage);
+  buffer->unaligned_width = handle.width;
+  buffer->unaligned_height = handle.height;
+  buffer->width = ALIGN(handle.width, 16u);
+  buffer->height = handle.height;
+  buffer->size = UINT32(handle.size);
+  buffer->handle_id = handle.id;
+  buffer->buffer_id = handle.id;
+  buffer->usage = handle.usage;
+  buffer->planes[0].stride = buffer->width * 4;
+}
+
+int ReplayBufferAllocator::AllocateBuffer(BufferInfo *buffer_info) {
+  AllocatedBufferInfo *alloc_info = &buffer_info->alloc_buffer_info;
+  int ret = GetAllocatedBufferInfo(buffer_info->buffer_config, alloc_info);
+  if (ret) {
+    return ret;
+  }
+
+  buffer_info->private_data = calloc(1, alloc_info->size);
+  if (!buffer_info->private_data) {
+    return -ENOMEM;
+  }
+  alloc_info->id = ++allocations_;
+
+  return 0;
+}
+
+int ReplayBufferAllocator::FreeBuffer(BufferInfo *buffer_info) {
+  free(buffer_info->private_data);
+  buffer_info->private_data = nullptr;
+  buffer_info->alloc_buffer_info = {};
+
+  return 0;
+}
+
+uint32_t ReplayBufferAllocator::GetBufferSize(BufferInfo *buffer_info) {
+  AllocatedBufferInfo alloc_info;
+  if (GetAllocatedBufferInfo(buffer_info->buffer_config, &alloc_info)) {
+    return 0;
+  }
+
+  return alloc_info.size;
+}
+
+int ReplayBufferAllocator::GetAllocatedBufferInfo(const BufferConfig &buffer_config,
+                                                  AllocatedBufferInfo *allocated_buffer_info) {
+  if (!buffer_config.width || !buffer_config.height) {
+    return -EINVAL;
+  }
+
+  uint32_t count = std::max(buffer_config.buffer_count, 1u);
+  allocated_buffer_info->aligned_width = ALIGN(buffer_config.width, 16u);
+  allocated_buffer_info->aligned_height = ALIGN(buffer_config.height, 16u);
+  allocated_buffer_info->stride = allocated_buffer_info->aligned_width * 4;
+  allocated_buffer_info->format = buffer_config.format;
+  allocated_buffer_info->size = allocated_buffer_info->stride *
+                                allocated_buffer_info->aligned_height * count;
+  allocated_buffer_info->fd = -1;
+
+  return 0;
+}
+
+ReplaySyncHandler::ReplaySyncHandler() {
+  Fence::Set(this);
+}
+
+int ReplaySyncHandler::SyncWait(int fd, int timeout) {
+  // Assume invalid fd as signaled.
+  if (fd < 0) {
+    return 0;
+  }
+
+  struct pollfd pfd = {fd, POLLIN, 0};
+  int ret = 0;
+  do {
+    ret = poll(&pfd, 1, timeout);
+  } while (ret < 0 && errno == EINTR);
+
+  if (ret == 0) {
+    return -ETIME;
+  }
+
+  return (ret < 0) ? -errno : 0;
+}
+
+int ReplaySyncHandler::SyncMerge(int fd1, int fd2, int *merged_fd) {
+  // Every replay fence is signaled before it is handed out, either one stands for both.
+  *merged_fd = dup((fd1 >= 0) ? fd1 : fd2);
+
+  return 0;
+}
+
+void ReplaySyncHandler::GetSyncInfo(int fd, std::ostringstream *os) {
+  *os << "replay fence " << fd;
+}
+
+int ReplaySyncHandler::GetSignalTime(int fd, int64_t *signal_time_ns) {
+  if (fd < 0) {
+    return -EINVAL;
+  }
+
+  struct timespec ts = {};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  *signal_time_ns = (static_cast<int64_t>(ts.tv_sec) * 1000000000LL) + ts.tv_nsec;
+
+  return 0;
+}
+
+static void Log(const char *prefix, const char *format, va_list list) {
+  fprintf(stderr, "%s", prefix);
+  vfprintf(stderr, format, list);
+  fprintf(stderr, "\n");
+}
+
+void ReplayDebugHandler::Error(const char *format, ...) {
+  va_list list;
+  va_start(list, format);
+  Log("E ", format, list);
+  va_end(list);
+}
+
+void ReplayDebugHandler::Warning(const char *format, ...) {
+  va_list list;
+  va_start(list, format);
+  Log("W ", format, list);
+  va_end(list);
+}
+
+void ReplayDebugHandler::Info(const char *format, ...) {
+  if (!verbose_) {
+    return;
+  }
+
+  va_list list;
+  va_start(list, format);
+  Log("I ", format, list);
+  va_end(list);
+}
+
+void ReplayDebugHandler::Debug(const char *format, ...) {
+  if (!verbose_) {
+    return;
+  }
+
+  va_list list;
+  va_start(list, format);
+  Log("D ", format, list);
+  va_end(list);
+}
+
+void ReplayDebugHandler::Verbose(const char *format, ...) {
+  if (!verbose_) {
+    return;
+  }
+
+  va_list list;
+  va_start(list, format);
+  Log("V ", format, list);
+  va_end(list);
+}
+
+}  // namespace sdm
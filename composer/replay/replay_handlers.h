@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __REPLAY_HANDLERS_H__
+#define __REPLAY_HANDLERS_H__
+
+#include <core/buffer_allocator.h>
+#include <core/buffer_sync_handler.h>
+#include <core/layer_buffer.h>
+#include <core/socket_handler.h>
+#include <stdint.h>
+#include <utils/debug.h>
+
+#include <sstream>
+
+#include "../hwc_capture_format.h"
+
+namespace sdm {
+
+// Gralloc stand-in. Buffers SDM allocates for itself are plain memory, captured client buffers
+// are described from their CaptureHandle and never backed by memory since nothing reads them.
+class ReplayBufferAllocator : public BufferAllocator {
+ public:
+  int AllocateBuffer(BufferInfo *buffer_info) override;
+  int FreeBuffer(BufferInfo *buffer_info) override;
+  uint32_t GetBufferSize(BufferInfo *buffer_info) override;
+  int GetAllocatedBufferInfo(const BufferConfig &buffer_config,
+                             AllocatedBufferInfo *allocated_buffer_info) override;
+
+  // Fills the geometry and format of a layer buffer from a captured gralloc handle.
+  static void DescribeBuffer(const CaptureHandle &handle, LayerBuffer *buffer);
+  static LayerBufferFormat GetSDMFormat(uint32_t hal_format, uint64_t usage);
+
+  uint64_t allocations_ = 0;
+};
+
+// Fences come from the fake DRM backend and from the replay itself; all are eventfds, readable
+// once signaled.
+class ReplaySyncHandler : public BufferSyncHandler {
+ public:
+  ReplaySyncHandler();
+  int SyncWait(int fd, int timeout) override;
+  int SyncMerge(int fd1, int fd2, int *merged_fd) override;
+  void GetSyncInfo(int fd, std::ostringstream *os) override;
+  int GetSignalTime(int fd, int64_t *signal_time_ns) override;
+};
+
+class ReplaySocketHandler : public SocketHandler {
+ public:
+  int GetSocketFd(SocketType socket_type) override { return -1; }
+};
+
+// Logs to stderr; errors and warnings always, the rest with --verbose. Properties read as unset.
+class ReplayDebugHandler : public DebugHandler {
+ public:
+  explicit ReplayDebugHandler(bool verbose) : verbose_(verbose) {}
+  void Error(const char *format, ...) override __attribute__((format(printf, 2, 3)));
+  void Warning(const char *format, ...) override __attribute__((format(printf, 2, 3)));
+  void Info(const char *format, ...) override __attribute__((format(printf, 2, 3)));
+  void Debug(const char *format, ...) override __attribute__((format(printf, 2, 3)));
+  void Verbose(const char *format, ...) override __attribute__((format(printf, 2, 3)));
+  void BeginTrace(const char *class_name, const char *function_name,
+                  const char *custom_string) override {}
+  void EndTrace() override {}
+  int GetProperty(const char *property_name, int *value) override { return -ENOTSUP; }
+  int GetProperty(const char *property_name, char *value) override { return -ENOTSUP; }
+
+ private:
+  bool verbose_ = false;
+};
+
+}  // namespace sdm
+
+#endif  // __REPLAY_HANDLERS_H__
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <stdlib.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+#include "replay_stats.h"
+
+static std::atomic<uint64_t> g_allocations {0};
+static std::atomic<uint64_t> g_allocated_bytes {0};
+
+// Counts every C++ heap allocation of the process; array and nothrow forms end up here as well.
+void *operator new(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  void *ptr = malloc(size ? size : 1);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+
+  return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+  free(ptr);
+}
+
+namespace sdm {
+
+static int64_t GetTime(clockid_t clock) {
+  struct timespec ts = {};
+  clock_gettime(clock, &ts);
+  return (static_cast<int64_t>(ts.tv_sec) * 1000000000LL) + ts.tv_nsec;
+}
+
+void GetAllocationCount(uint64_t *allocations, uint64_t *bytes) {
+  *allocations = g_allocations.load(std::memory_order_relaxed);
+  *bytes = g_allocated_bytes.load(std::memory_order_relaxed);
+}
+
+ReplayStage::ReplayStage(ReplayStageStats *stats) : stats_(stats) {
+  GetAllocationCount(&allocations_start_, &bytes_start_);
+  wall_start_ns_ = GetTime(CLOCK_MONOTONIC);
+  cpu_start_ns_ = GetTime(CLOCK_THREAD_CPUTIME_ID);
+}
+
+ReplayStage::~ReplayStage() {
+  uint64_t cpu_ns = static_cast<uint64_t>(GetTime(CLOCK_THREAD_CPUTIME_ID) - cpu_start_ns_);
+  stats_->wall_ns += static_cast<uint64_t>(GetTime(CLOCK_MONOTONIC) - wall_start_ns_);
+  stats_->cpu_ns += cpu_ns;
+  stats_->max_cpu_ns = std::max(stats_->max_cpu_ns, cpu_ns);
+  stats_->calls++;
+
+  uint64_t allocations = 0, bytes = 0;
+  GetAllocationCount(&allocations, &bytes);
+  stats_->allocations += allocations - allocations_start_;
+  stats_->allocated_bytes += bytes - bytes_start_;
+}
+
+void ReplayStageStats::Dump(const char *name, uint64_t frames, std::ostringstream *os) const {
+  frames = std::max(frames, uint64_t(1));
+  *os << name << ": calls " << calls;
+  *os << ", cpu " << (cpu_ns / 1000) << " us (" << (cpu_ns / frames / 1000) << " us/frame, max ";
+  *os << (max_cpu_ns / 1000) << " us)";
+  *os << ", wall " << (wall_ns / 1000) << " us";
+  *os << ", allocations " << allocations << " (" << (allocations / frames) << "/frame, ";
+  *os << (allocated_bytes / frames) << " bytes/frame)\n";
+}
+
+}  // namespace sdm
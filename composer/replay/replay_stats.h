@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __REPLAY_STATS_H__
+#define __REPLAY_STATS_H__
+
+#include <stdint.h>
+
+#include <sstream>
+
+namespace sdm {
+
+// Cost of one replay stage summed over all frames. CPU time is that of the replaying thread, the
+// allocation counts come from the replacement operator new in replay_stats.cpp and cover every
+// thread.
+struct ReplayStageStats {
+  uint64_t calls = 0;
+  uint64_t wall_ns = 0;
+  uint64_t cpu_ns = 0;
+  uint64_t max_cpu_ns = 0;
+  uint64_t allocations = 0;
+  uint64_t allocated_bytes = 0;
+
+  void Dump(const char *name, uint64_t frames, std::ostringstream *os) const;
+};
+
+// Charges the scope it lives in to a stage.
+class ReplayStage {
+ public:
+  explicit ReplayStage(ReplayStageStats *stats);
+  ~ReplayStage();
+
+ private:
+  ReplayStageStats *stats_ = nullptr;
+  int64_t wall_start_ns_ = 0;
+  int64_t cpu_start_ns_ = 0;
+  uint64_t allocations_start_ = 0;
+  uint64_t bytes_start_ = 0;
+};
+
+void GetAllocationCount(uint64_t *allocations, uint64_t *bytes);
+
+}  // namespace sdm
+
+#endif  // __REPLAY_STATS_H__
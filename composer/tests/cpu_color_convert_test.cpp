@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <QtiGrallocPriv.h>
+#include <gralloc_priv.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utils/constants.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "cpu_color_convert_impl.h"
+#include "gr_utils.h"
+using namespace testing;
+using sdm::ColorConvertCSC;
+using sdm::CPUColorConvertImpl;
+using sdm::Fence;
+using sdm::GLRect;
+using std::shared_ptr;
+
+namespace {
+
+using RGBToYUVCoeffs = CPUColorConvertImpl::RGBToYUVCoeffs;
+using YUVToRGBCoeffs = CPUColorConvertImpl::YUVToRGBCoeffs;
+
+// Buffer ids the mapping cache of the engines has not seen.
+uint64_t next_id = 1ull << 40;
+
+// A linear buffer in a memfd, with the handle and layout BufferManager::AllocateBuffer gives it.
+class TestBuffer {
+ public:
+  TestBuffer(int format, uint32_t width, uint32_t height) {
+    unsigned int size = 0;
+    unsigned int aligned_width = 0;
+    unsigned int aligned_height = 0;
+    gralloc::BufferInfo info(static_cast<int>(width), static_cast<int>(height), format);
+    if (gralloc::GetBufferSizeAndDimensions(info, &size, &aligned_width, &aligned_height)) {
+      return;
+    }
+
+    int fd = memfd_create("cpu_color_convert_test", 0);
+    if (fd < 0 || ftruncate(fd, static_cast<off_t>(size))) {
+      close(fd);
+      return;
+    }
+
+    hnd_ = static_cast<private_handle_t *>(calloc(1, sizeof(private_handle_t)));
+    hnd_->fd = fd;
+    hnd_->fd_metadata = -1;
+    hnd_->magic = qtigralloc::private_handle_t::kMagic;
+    hnd_->width = static_cast<int>(aligned_width);
+    hnd_->height = static_cast<int>(aligned_height);
+    hnd_->unaligned_width = static_cast<int>(width);
+    hnd_->unaligned_height = static_cast<int>(height);
+    hnd_->format = format;
+    hnd_->layer_count = 1;
+    hnd_->id = next_id++;
+    hnd_->size = size;
+    hnd_->version = static_cast<int>(sizeof(native_handle));
+    hnd_->numInts = qtigralloc::private_handle_t::NumInts();
+    hnd_->numFds = qtigralloc::private_handle_t::kNumFds;
+
+    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr != MAP_FAILED && !gralloc::GetBufferLayout(hnd_, stride_, offset_, &num_planes_)) {
+      base_ = static_cast<uint8_t *>(addr);
+    }
+  }
+
+  ~TestBuffer() {
+    if (base_) {
+      munmap(base_, hnd_->size);
+    }
+    if (hnd_) {
+      close(hnd_->fd);
+      free(hnd_);
+    }
+  }
+
+  bool IsValid() const { return base_ != nullptr; }
+  const native_handle_t *GetHandle() const { return hnd_; }
+  uint8_t *GetRow(uint32_t plane, uint32_t row) const {
+    return base_ + offset_[plane] + row * stride_[plane];
+  }
+
+  // Fills the whole buffer, padding included, with random bytes.
+  void Randomize(std::mt19937 *random) const {
+    for (uint32_t i = 0; i < hnd_->size; i++) {
+      base_[i] = static_cast<uint8_t>((*random)());
+    }
+  }
+
+ private:
+  private_handle_t *hnd_ = nullptr;
+  uint8_t *base_ = nullptr;
+  uint32_t stride_[4] = {};
+  uint32_t offset_[4] = {};
+  uint32_t num_planes_ = 0;
+};
+
+struct RGBFormat {
+  int format;
+  uint32_t bits;
+};
+
+struct YUVFormat {
+  int format;
+  uint32_t bits;
+  bool swap_uv;
+};
+
+const ColorConvertCSC kCSCs[] = {
+  {ColorPrimaries_BT601_6_525, Range_Limited},
+  {ColorPrimaries_BT709_5, Range_Full},
+  {ColorPrimaries_BT2020, Range_Limited},
+  {ColorPrimaries_BT2020, Range_Full},
+};
+
+const RGBFormat kRGBFormats[] = {
+  {HAL_PIXEL_FORMAT_RGBA_8888, 8},
+  {HAL_PIXEL_FORMAT_RGBA_1010102, 10},
+};
+
+const YUVFormat kYUVFormats[] = {
+  {HAL_PIXEL_FORMAT_YCbCr_420_SP, 8, false},
+  {HAL_PIXEL_FORMAT_YCrCb_420_SP, 8, true},
+  {HAL_PIXEL_FORMAT_YCbCr_420_P010, 10, false},
+};
+
+// Odd sizes leave a partial chroma block on the right and bottom edges.
+const uint32_t kSizes[][2] = {{1, 1}, {64, 32}, {97, 51}, {320, 241}};
+
+int32_t Clamp(int32_t value, int32_t max) {
+  return std::min(std::max(value, 0), max);
+}
+
+int32_t GetRGBComponent(const TestBuffer &buffer, uint32_t bits, uint32_t x, uint32_t y,
+                        uint32_t component) {
+  uint32_t pixel = 0;
+  memcpy(&pixel, buffer.GetRow(0, y) + 4 * x, sizeof(pixel));
+  return int32_t((pixel >> (bits * component)) & ((1 << bits) - 1));
+}
+
+int32_t GetYUVSample(const TestBuffer &buffer, uint32_t bits, uint32_t plane, uint32_t x,
+                     uint32_t y) {
+  if (bits == 8) {
+    return buffer.GetRow(plane, y)[x];
+  }
+  uint16_t sample = 0;
+  memcpy(&sample, buffer.GetRow(plane, y) + 2 * x, sizeof(sample));
+  return sample >> 6;
+}
+
+void PutYUVSample(const TestBuffer &buffer, uint32_t bits, uint32_t plane, uint32_t x, uint32_t y,
+                  int32_t value) {
+  if (bits == 8) {
+    buffer.GetRow(plane, y)[x] = static_cast<uint8_t>(value);
+    return;
+  }
+  uint16_t sample = static_cast<uint16_t>(value << 6);
+  memcpy(buffer.GetRow(plane, y) + 2 * x, &sample, sizeof(sample));
+}
+
+// The fixed point conversion of CPUColorConvertImpl done a pixel and a chroma block at a time,
+// without the row kernels. Edge pixels repeat into the partial chroma blocks.
+void ConvertToYUV(const RGBToYUVCoeffs &coeffs, const TestBuffer &src, uint32_t rgb_bits,
+                  const TestBuffer &dst, const YUVFormat &yuv, uint32_t width, uint32_t height) {
+  auto rgb = [&](uint32_t x, uint32_t y, uint32_t component) {
+    return GetRGBComponent(src, rgb_bits, std::min(x, width - 1), std::min(y, height - 1),
+                           component);
+  };
+  const int32_t shift = CPUColorConvertImpl::kCoeffShift;
+
+  for (uint32_t y = 0; y < height; y++) {
+    for (uint32_t x = 0; x < width; x++) {
+      int32_t luma = coeffs.y[0] * rgb(x, y, 0) + coeffs.y[1] * rgb(x, y, 1) +
+                     coeffs.y[2] * rgb(x, y, 2) + (coeffs.y_offset << shift) + (1 << (shift - 1));
+      PutYUVSample(dst, yuv.bits, 0, x, y, Clamp(luma >> shift, coeffs.y_max));
+    }
+  }
+
+  // Chroma is taken from the sum of the four pixels, two more bits to shift out.
+  for (uint32_t y = 0; y < (height + 1) / 2; y++) {
+    for (uint32_t x = 0; x < (width + 1) / 2; x++) {
+      int32_t sum[3] = {};
+      for (uint32_t component = 0; component < 3; component++) {
+        sum[component] = rgb(2 * x, 2 * y, component) + rgb(2 * x + 1, 2 * y, component) +
+                         rgb(2 * x, 2 * y + 1, component) + rgb(2 * x + 1, 2 * y + 1, component);
+      }
+      int32_t offset = (coeffs.c_offset << (shift + 2)) + (1 << (shift + 1));
+      int32_t u = coeffs.u[0] * sum[0] + coeffs.u[1] * sum[1] + coeffs.u[2] * sum[2] + offset;
+      int32_t v = coeffs.v[0] * sum[0] + coeffs.v[1] * sum[1] + coeffs.v[2] * sum[2] + offset;
+      PutYUVSample(dst, yuv.bits, 1, 2 * x + (yuv.swap_uv ? 1 : 0), y,
+                   Clamp(u >> (shift + 2), coeffs.y_max));
+      PutYUVSample(dst, yuv.bits, 1, 2 * x + (yuv.swap_uv ? 0 : 1), y,
+                   Clamp(v >> (shift + 2), coeffs.y_max));
+    }
+  }
+}
+
+void ConvertToRGB(const YUVToRGBCoeffs &coeffs, const TestBuffer &src, const YUVFormat &yuv,
+                  const TestBuffer &dst, uint32_t rgb_bits, uint32_t width, uint32_t height) {
+  const int32_t shift = CPUColorConvertImpl::kCoeffShift;
+  uint32_t alpha = (rgb_bits == 8) ? 0xFF000000 : 0xC0000000;
+
+  for (uint32_t y = 0; y < height; y++) {
+    for (uint32_t x = 0; x < width; x++) {
+      int32_t luma = coeffs.y * (GetYUVSample(src, yuv.bits, 0, x, y) - coeffs.y_offset) +
+                     (1 << (shift - 1));
+      uint32_t chroma_x = x & ~1U;
+      int32_t u = GetYUVSample(src, yuv.bits, 1, chroma_x + (yuv.swap_uv ? 1 : 0), y / 2) -
+                  coeffs.c_offset;
+      int32_t v = GetYUVSample(src, yuv.bits, 1, chroma_x + (yuv.swap_uv ? 0 : 1), y / 2) -
+                  coeffs.c_offset;
+      uint32_t red = UINT32(Clamp((luma + coeffs.r_v * v) >> shift, coeffs.rgb_max));
+      uint32_t green = UINT32(Clamp((luma - coeffs.g_u * u - coeffs.g_v * v) >> shift,
+                                    coeffs.rgb_max));
+      uint32_t blue = UINT32(Clamp((luma + coeffs.b_u * u) >> shift, coeffs.rgb_max));
+      uint32_t pixel = red | (green << rgb_bits) | (blue << (2 * rgb_bits)) | alpha;
+      memcpy(dst.GetRow(0, y) + 4 * x, &pixel, sizeof(pixel));
+    }
+  }
+}
+
+void ExpectSameRows(const TestBuffer &buffer, const TestBuffer &reference, uint32_t plane,
+                    uint32_t rows, uint32_t row_bytes) {
+  for (uint32_t row = 0; row < rows; row++) {
+    ASSERT_THAT(memcmp(buffer.GetRow(plane, row), reference.GetRow(plane, row), row_bytes), Eq(0))
+      << "plane " << plane << " row " << row;
+  }
+}
+
+// Stops the helper threads when a test returns, on failed assertions too.
+class TestColorConvert : public CPUColorConvertImpl {
+ public:
+  using CPUColorConvertImpl::CPUColorConvertImpl;
+  ~TestColorConvert() { Deinit(); }
+};
+
+GLRect GetRect(uint32_t width, uint32_t height) {
+  GLRect rect;
+  rect.right = static_cast<float>(width);
+  rect.bottom = static_cast<float>(height);
+  return rect;
+}
+
+int Blit(CPUColorConvertImpl *engine, const TestBuffer &src, const TestBuffer &dst,
+         const GLRect &dst_rect) {
+  shared_ptr<Fence> release_fence = nullptr;
+  return engine->Blit(src.GetHandle(), dst.GetHandle(), GLRect(), dst_rect, nullptr, nullptr,
+                      &release_fence);
+}
+
+}  // namespace
+
+// Every CSC, RGB and YUV format and size, converted to YUV and back to RGB, both directions
+// compared with the per pixel reference. 96 cases each.
+TEST(CPUColorConvertTestCases, BitExactWithScalarReference) {
+  std::mt19937 random(43);
+  uint32_t cases = 0;
+
+  for (const ColorConvertCSC &csc : kCSCs) {
+    TestColorConvert to_yuv(sdm::kTargetYUV, csc);
+    TestColorConvert to_rgb(sdm::kTargetRGBA, csc);
+    ASSERT_THAT(to_yuv.Init(), Eq(0));
+    ASSERT_THAT(to_rgb.Init(), Eq(0));
+
+    for (const RGBFormat &rgb : kRGBFormats) {
+      for (const YUVFormat &yuv : kYUVFormats) {
+        for (const auto &size : kSizes) {
+          uint32_t width = size[0];
+          uint32_t height = size[1];
+          SCOPED_TRACE(testing::Message() << "csc " << csc.primaries << "/" << csc.range
+                       << " rgb 0x" << std::hex << rgb.format << " yuv 0x" << yuv.format
+                       << std::dec << " " << width << "x" << height);
+          uint32_t yuv_row_bytes = width * (yuv.bits == 8 ? 1 : 2);
+          uint32_t chroma_rows = (height + 1) / 2;
+          GLRect rect = GetRect(width, height);
+
+          TestBuffer src(rgb.format, width, height);
+          TestBuffer yuv_out(yuv.format, width, height);
+          TestBuffer yuv_ref(yuv.format, width, height);
+          ASSERT_TRUE(src.IsValid() && yuv_out.IsValid() && yuv_ref.IsValid());
+          src.Randomize(&random);
+
+          ASSERT_THAT(Blit(&to_yuv, src, yuv_out, rect), Eq(0));
+          RGBToYUVCoeffs to_yuv_coeffs;
+          CPUColorConvertImpl::GetRGBToYUVCoeffs(csc, rgb.bits, yuv.bits, &to_yuv_coeffs);
+          ConvertToYUV(to_yuv_coeffs, src, rgb.bits, yuv_ref, yuv, width, height);
+          ExpectSameRows(yuv_out, yuv_ref, 0, height, yuv_row_bytes);
+          ExpectSameRows(yuv_out, yuv_ref, 1, chroma_rows, 2 * ((width + 1) / 2) *
+                         (yuv.bits == 8 ? 1 : 2));
+
+          TestBuffer rgb_out(rgb.format, width, height);
+          TestBuffer rgb_ref(rgb.format, width, height);
+          ASSERT_TRUE(rgb_out.IsValid() && rgb_ref.IsValid());
+          ASSERT_THAT(Blit(&to_rgb, yuv_out, rgb_out, rect), Eq(0));
+          YUVToRGBCoeffs to_rgb_coeffs;
+          CPUColorConvertImpl::GetYUVToRGBCoeffs(csc, yuv.bits, rgb.bits, &to_rgb_coeffs);
+          ConvertToRGB(to_rgb_coeffs, yuv_out, yuv, rgb_ref, rgb.bits, width, height);
+          ExpectSameRows(rgb_out, rgb_ref, 0, height, 4 * width);
+          cases += 2;
+        }
+      }
+    }
+  }
+
+  EXPECT_THAT(cases, Eq(192u));
+}
+
+// The fixed point BT.709 limited luma against its floating point definition.
+TEST(CPUColorConvertTestCases, LumaWithinOneLsbOfFloat) {
+  ColorConvertCSC csc = {ColorPrimaries_BT709_5, Range_Limited};
+  RGBToYUVCoeffs coeffs;
+  CPUColorConvertImpl::GetRGBToYUVCoeffs(csc, 8, 8, &coeffs);
+  const int32_t shift = CPUColorConvertImpl::kCoeffShift;
+
+  int32_t max_error = 0;
+  for (int32_t red = 0; red < 256; red += 3) {
+    for (int32_t green = 0; green < 256; green += 5) {
+      for (int32_t blue = 0; blue < 256; blue += 7) {
+        double luma = 16 + 219 * (0.2126 * red + 0.7152 * green + 0.0722 * blue) / 255;
+        int32_t fixed = Clamp((coeffs.y[0] * red + coeffs.y[1] * green + coeffs.y[2] * blue +
+                               (coeffs.y_offset << shift) + (1 << (shift - 1))) >> shift, 255);
+        max_error = std::max(max_error, abs(fixed - int32_t(lround(luma))));
+      }
+    }
+  }
+
+  EXPECT_THAT(max_error, Le(1));
+}
+
+TEST(CPUColorConvertTestCases, UnsupportedConversionFails) {
+  ColorConvertCSC csc;
+  TestColorConvert to_yuv(sdm::kTargetYUV, csc);
+  TestBuffer rgb(HAL_PIXEL_FORMAT_RGBA_8888, 64, 64);
+  TestBuffer other_rgb(HAL_PIXEL_FORMAT_RGBA_8888, 64, 64);
+  ASSERT_TRUE(rgb.IsValid() && other_rgb.IsValid());
+  EXPECT_THAT(Blit(&to_yuv, rgb, other_rgb, GetRect(64, 64)), Eq(-ENOTSUP));
+}
+
+// Megapixels per second of the destination at 1080p, on the calling thread alone and with the
+// default helper threads. A 720p WFD session at 60 fps needs 55 MP/s.
+TEST(CPUColorConvertTestCases, Throughput) {
+  const int kFrames = 20;
+  std::mt19937 random(43);
+  ColorConvertCSC csc;
+  TestBuffer rgb(HAL_PIXEL_FORMAT_RGBA_8888, 1920, 1080);
+  TestBuffer nv12(HAL_PIXEL_FORMAT_YCbCr_420_SP, 1920, 1080);
+  TestBuffer nv12_720p(HAL_PIXEL_FORMAT_YCbCr_420_SP, 1280, 720);
+  ASSERT_TRUE(rgb.IsValid() && nv12.IsValid() && nv12_720p.IsValid());
+  rgb.Randomize(&random);
+
+  for (bool threaded : {false, true}) {
+    TestColorConvert to_yuv(sdm::kTargetYUV, csc);
+    TestColorConvert to_rgb(sdm::kTargetRGBA, csc);
+    if (threaded) {
+      ASSERT_THAT(to_yuv.Init(), Eq(0));
+      ASSERT_THAT(to_rgb.Init(), Eq(0));
+    }
+
+    auto get_mp_per_second = [&](CPUColorConvertImpl *engine, const TestBuffer &src,
+                                 const TestBuffer &dst, uint32_t width, uint32_t height) {
+      GLRect rect = GetRect(width, height);
+      Blit(engine, src, dst, rect);
+      auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < kFrames; i++) {
+        Blit(engine, src, dst, rect);
+      }
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      return (double(width) * height * kFrames / 1e6) / elapsed.count();
+    };
+
+    double to_nv12 = get_mp_per_second(&to_yuv, rgb, nv12, 1920, 1080);
+    double to_nv12_720p = get_mp_per_second(&to_yuv, rgb, nv12_720p, 1280, 720);
+    double to_rgba = get_mp_per_second(&to_rgb, nv12, rgb, 1920, 1080);
+    const char *threads = threaded ? "helper threads" : "single thread";
+    printf("RGBA8888 to NV12 1080p, %s: %.1f MP/s\n", threads, to_nv12);
+    printf("RGBA8888 1080p to NV12 720p, %s: %.1f MP/s\n", threads, to_nv12_720p);
+    printf("NV12 to RGBA8888 1080p, %s: %.1f MP/s\n", threads, to_rgba);
+  }
+}
@@ -0,0 +1,372 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <QtiGrallocPriv.h>
+#include <gralloc_priv.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utils/constants.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "cpu_cwb_post_process.h"
+#include "gr_utils.h"
+using namespace testing;
+using sdm::ColorConvertCSC;
+using sdm::CPUColorConvertImpl;
+using sdm::CPUCwbPostProcess;
+using sdm::GLRect;
+
+namespace {
+
+using RGBToYUVCoeffs = CPUColorConvertImpl::RGBToYUVCoeffs;
+
+// Buffer ids the mapping cache of the engine has not seen.
+uint64_t next_id = 1ull << 40;
+
+// A linear buffer in a memfd, with the handle and layout BufferManager::AllocateBuffer gives it.
+class TestBuffer {
+ public:
+  TestBuffer(int format, uint32_t width, uint32_t height) {
+    unsigned int size = 0;
+    unsigned int aligned_width = 0;
+    unsigned int aligned_height = 0;
+    gralloc::BufferInfo info(static_cast<int>(width), static_cast<int>(height), format);
+    if (gralloc::GetBufferSizeAndDimensions(info, &size, &aligned_width, &aligned_height)) {
+      return;
+    }
+
+    int fd = memfd_create("cpu_cwb_post_process_test", 0);
+    if (fd < 0 || ftruncate(fd, static_cast<off_t>(size))) {
+      close(fd);
+      return;
+    }
+
+    hnd_ = static_cast<private_handle_t *>(calloc(1, sizeof(private_handle_t)));
+    hnd_->fd = fd;
+    hnd_->fd_metadata = -1;
+    hnd_->magic = qtigralloc::private_handle_t::kMagic;
+    hnd_->width = static_cast<int>(aligned_width);
+    hnd_->height = static_cast<int>(aligned_height);
+    hnd_->unaligned_width = static_cast<int>(width);
+    hnd_->unaligned_height = static_cast<int>(height);
+    hnd_->format = format;
+    hnd_->layer_count = 1;
+    hnd_->id = next_id++;
+    hnd_->size = size;
+    hnd_->version = static_cast<int>(sizeof(native_handle));
+    hnd_->numInts = qtigralloc::private_handle_t::NumInts();
+    hnd_->numFds = qtigralloc::private_handle_t::kNumFds;
+
+    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr != MAP_FAILED && !gralloc::GetBufferLayout(hnd_, stride_, offset_, &num_planes_)) {
+      base_ = static_cast<uint8_t *>(addr);
+    }
+  }
+
+  ~TestBuffer() {
+    if (base_) {
+      munmap(base_, hnd_->size);
+    }
+    if (hnd_) {
+      close(hnd_->fd);
+      free(hnd_);
+    }
+  }
+
+  bool IsValid() const { return base_ != nullptr; }
+  const native_handle_t *GetHandle() const { return hnd_; }
+  uint8_t *GetRow(uint32_t plane, uint32_t row) const {
+    return base_ + offset_[plane] + row * stride_[plane];
+  }
+
+  // Fills the whole buffer, padding included, with random bytes.
+  void Randomize(std::mt19937 *random) const {
+    for (uint32_t i = 0; i < hnd_->size; i++) {
+      base_[i] = static_cast<uint8_t>((*random)());
+    }
+  }
+
+ private:
+  private_handle_t *hnd_ = nullptr;
+  uint8_t *base_ = nullptr;
+  uint32_t stride_[4] = {};
+  uint32_t offset_[4] = {};
+  uint32_t num_planes_ = 0;
+};
+
+struct OutputFormat {
+  int format;
+  bool yuv;
+  bool swap_uv;
+};
+
+const OutputFormat kOutputFormats[] = {
+  {HAL_PIXEL_FORMAT_RGBA_8888, false, false},
+  {HAL_PIXEL_FORMAT_RGBX_8888, false, false},
+  {HAL_PIXEL_FORMAT_YCbCr_420_SP, true, false},
+  {HAL_PIXEL_FORMAT_YCrCb_420_SP, true, true},
+};
+
+const uint32_t kFactors[] = {1, 2, 4};
+
+GLRect GetRect(float left, float top, float right, float bottom) {
+  GLRect rect;
+  rect.left = left;
+  rect.top = top;
+  rect.right = right;
+  rect.bottom = bottom;
+  return rect;
+}
+
+const uint32_t kSrcWidth = 322;
+const uint32_t kSrcHeight = 243;
+
+// The whole frame, a fractional one, one sticking out of the frame and one leaving odd outputs
+// at every factor.
+const GLRect kROIs[] = {
+  GLRect(),
+  GetRect(13.5f, 7.2f, 301.0f, 200.0f),
+  GetRect(-10.0f, 100.0f, 5000.0f, 5000.0f),
+  GetRect(3.0f, 5.0f, 47.0f, 17.0f),
+};
+
+int32_t Clamp(int32_t value, int32_t max) {
+  return std::min(std::max(value, 0), max);
+}
+
+// Rounded average of each component over the factor x factor blocks of the area, a pixel at a
+// time.
+std::vector<uint32_t> Downscale(const TestBuffer &src, const GLRect &area, uint32_t factor,
+                                uint32_t width, uint32_t height) {
+  std::vector<uint32_t> pixels(width * height);
+  uint32_t left = UINT32(area.left);
+  uint32_t top = UINT32(area.top);
+  uint32_t samples = factor * factor;
+
+  for (uint32_t y = 0; y < height; y++) {
+    for (uint32_t x = 0; x < width; x++) {
+      uint32_t pixel = 0;
+      for (uint32_t component = 0; component < 4; component++) {
+        uint32_t sum = 0;
+        for (uint32_t j = 0; j < factor; j++) {
+          const uint8_t *row = src.GetRow(0, top + y * factor + j);
+          for (uint32_t i = 0; i < factor; i++) {
+            sum += row[4 * (left + x * factor + i) + component];
+          }
+        }
+        pixel |= ((sum + samples / 2) / samples) << (8 * component);
+      }
+      pixels[y * width + x] = pixel;
+    }
+  }
+
+  return pixels;
+}
+
+// The fixed point 8 bit conversion of CPUColorConvertImpl done a pixel and a chroma block at a
+// time. Edge pixels repeat into the partial chroma blocks.
+void ConvertToYUV(const RGBToYUVCoeffs &coeffs, const std::vector<uint32_t> &pixels,
+                  uint32_t width, uint32_t height, bool swap_uv, std::vector<uint8_t> *luma,
+                  std::vector<uint8_t> *chroma) {
+  auto rgb = [&](uint32_t x, uint32_t y, uint32_t component) {
+    uint32_t pixel = pixels[std::min(y, height - 1) * width + std::min(x, width - 1)];
+    return int32_t((pixel >> (8 * component)) & 0xFF);
+  };
+  const int32_t shift = CPUColorConvertImpl::kCoeffShift;
+  uint32_t chroma_width = (width + 1) / 2;
+
+  luma->resize(width * height);
+  for (uint32_t y = 0; y < height; y++) {
+    for (uint32_t x = 0; x < width; x++) {
+      int32_t value = coeffs.y[0] * rgb(x, y, 0) + coeffs.y[1] * rgb(x, y, 1) +
+                      coeffs.y[2] * rgb(x, y, 2) + (coeffs.y_offset << shift) + (1 << (shift - 1));
+      (*luma)[y * width + x] = UINT8(Clamp(value >> shift, coeffs.y_max));
+    }
+  }
+
+  chroma->resize(2 * chroma_width * ((height + 1) / 2));
+  for (uint32_t y = 0; y < (height + 1) / 2; y++) {
+    for (uint32_t x = 0; x < chroma_width; x++) {
+      int32_t sum[3] = {};
+      for (uint32_t component = 0; component < 3; component++) {
+        sum[component] = rgb(2 * x, 2 * y, component) + rgb(2 * x + 1, 2 * y, component) +
+                         rgb(2 * x, 2 * y + 1, component) + rgb(2 * x + 1, 2 * y + 1, component);
+      }
+      int32_t offset = (coeffs.c_offset << (shift + 2)) + (1 << (shift + 1));
+      int32_t u = coeffs.u[0] * sum[0] + coeffs.u[1] * sum[1] + coeffs.u[2] * sum[2] + offset;
+      int32_t v = coeffs.v[0] * sum[0] + coeffs.v[1] * sum[1] + coeffs.v[2] * sum[2] + offset;
+      uint8_t *out = chroma->data() + 2 * (y * chroma_width + x);
+      out[swap_uv ? 1 : 0] = UINT8(Clamp(u >> (shift + 2), coeffs.y_max));
+      out[swap_uv ? 0 : 1] = UINT8(Clamp(v >> (shift + 2), coeffs.y_max));
+    }
+  }
+}
+
+// Stops the helper threads when a test returns, on failed assertions too.
+class TestCwbPostProcess : public CPUCwbPostProcess {
+ public:
+  using CPUCwbPostProcess::CPUCwbPostProcess;
+  ~TestCwbPostProcess() { Deinit(); }
+};
+
+}  // namespace
+
+// Every output format, factor and roi against the per pixel reference. 48 cases.
+TEST(CPUCwbPostProcessTestCases, MatchesReference) {
+  std::mt19937 random(48);
+  ColorConvertCSC csc;
+  TestCwbPostProcess engine(2, csc);
+  ASSERT_THAT(engine.Init(), Eq(0));
+  RGBToYUVCoeffs coeffs;
+  CPUColorConvertImpl::GetRGBToYUVCoeffs(csc, 8, 8, &coeffs);
+
+  TestBuffer src(HAL_PIXEL_FORMAT_RGBA_8888, kSrcWidth, kSrcHeight);
+  ASSERT_TRUE(src.IsValid());
+  src.Randomize(&random);
+  uint32_t cases = 0;
+
+  for (const OutputFormat &output : kOutputFormats) {
+    for (uint32_t factor : kFactors) {
+      for (const GLRect &roi : kROIs) {
+        SCOPED_TRACE(testing::Message() << "format 0x" << std::hex << output.format << std::dec
+                     << " factor " << factor << " roi " << roi.left << "," << roi.top << ","
+                     << roi.right << "," << roi.bottom);
+        GLRect area;
+        uint32_t width = 0, height = 0;
+        ASSERT_TRUE(CPUCwbPostProcess::GetOutputArea(roi, kSrcWidth, kSrcHeight, factor, &area,
+                                                      &width, &height));
+
+        // The destination keeps its full frame size, as the CWB client buffers do.
+        TestBuffer dst(output.format, kSrcWidth, kSrcHeight);
+        ASSERT_TRUE(dst.IsValid());
+        dst.Randomize(&random);
+        ASSERT_THAT(engine.Process(src.GetHandle(), dst.GetHandle(), roi, factor), Eq(0));
+
+        std::vector<uint32_t> pixels = Downscale(src, area, factor, width, height);
+        if (!output.yuv) {
+          for (uint32_t y = 0; y < height; y++) {
+            ASSERT_THAT(memcmp(dst.GetRow(0, y), &pixels[y * width], 4 * width), Eq(0))
+              << "row " << y;
+          }
+        } else {
+          std::vector<uint8_t> luma, chroma;
+          ConvertToYUV(coeffs, pixels, width, height, output.swap_uv, &luma, &chroma);
+          for (uint32_t y = 0; y < height; y++) {
+            ASSERT_THAT(memcmp(dst.GetRow(0, y), &luma[y * width], width), Eq(0))
+              << "luma row " << y;
+          }
+          uint32_t chroma_bytes = 2 * ((width + 1) / 2);
+          for (uint32_t y = 0; y < (height + 1) / 2; y++) {
+            ASSERT_THAT(memcmp(dst.GetRow(1, y), &chroma[y * chroma_bytes], chroma_bytes), Eq(0))
+              << "chroma row " << y;
+          }
+        }
+        cases++;
+      }
+    }
+  }
+
+  EXPECT_THAT(cases, Eq(48u));
+}
+
+TEST(CPUCwbPostProcessTestCases, GetOutputArea) {
+  GLRect area;
+  uint32_t width = 0, height = 0;
+
+  ASSERT_TRUE(CPUCwbPostProcess::GetOutputArea(GLRect(), 1080, 2400, 4, &area, &width, &height));
+  EXPECT_THAT(width, Eq(270u));
+  EXPECT_THAT(height, Eq(600u));
+
+  // Fractional edges grow outwards, the remainder is trimmed from the right and bottom.
+  ASSERT_TRUE(CPUCwbPostProcess::GetOutputArea(GetRect(10.5f, 20.2f, 111.0f, 90.7f), 1080, 2400,
+                                                4, &area, &width, &height));
+  EXPECT_THAT(area.left, Eq(10.0f));
+  EXPECT_THAT(area.top, Eq(20.0f));
+  EXPECT_THAT(area.right, Eq(110.0f));
+  EXPECT_THAT(area.bottom, Eq(88.0f));
+  EXPECT_THAT(width, Eq(25u));
+  EXPECT_THAT(height, Eq(17u));
+
+  ASSERT_TRUE(CPUCwbPostProcess::GetOutputArea(GetRect(-5.0f, 2390.0f, 2000.0f, 2500.0f), 1080,
+                                                2400, 2, &area, &width, &height));
+  EXPECT_THAT(area.left, Eq(0.0f));
+  EXPECT_THAT(area.bottom, Eq(2400.0f));
+  EXPECT_THAT(width, Eq(540u));
+  EXPECT_THAT(height, Eq(5u));
+
+  // Smaller than a block, outside the frame or with an unsupported factor.
+  EXPECT_FALSE(CPUCwbPostProcess::GetOutputArea(GetRect(0.0f, 0.0f, 3.0f, 100.0f), 1080, 2400, 4,
+                                                 &area, &width, &height));
+  EXPECT_FALSE(CPUCwbPostProcess::GetOutputArea(GetRect(1200.0f, 0.0f, 1300.0f, 100.0f), 1080,
+                                                 2400, 1, &area, &width, &height));
+  EXPECT_FALSE(CPUCwbPostProcess::GetOutputArea(GLRect(), 1080, 2400, 3, &area, &width,
+                                                 &height));
+}
+
+TEST(CPUCwbPostProcessTestCases, UnsupportedInputFails) {
+  ColorConvertCSC csc;
+  TestCwbPostProcess engine(2, csc);
+  TestBuffer rgba(HAL_PIXEL_FORMAT_RGBA_8888, 64, 64);
+  TestBuffer rgba_small(HAL_PIXEL_FORMAT_RGBA_8888, 16, 16);
+  TestBuffer nv12(HAL_PIXEL_FORMAT_YCbCr_420_SP, 64, 64);
+  TestBuffer rgb10(HAL_PIXEL_FORMAT_RGBA_1010102, 64, 64);
+  ASSERT_TRUE(rgba.IsValid() && rgba_small.IsValid() && nv12.IsValid() && rgb10.IsValid());
+
+  EXPECT_THAT(engine.Process(nv12.GetHandle(), rgba.GetHandle(), GLRect(), 1), Eq(-ENOTSUP));
+  EXPECT_THAT(engine.Process(rgba.GetHandle(), rgb10.GetHandle(), GLRect(), 1), Eq(-ENOTSUP));
+  EXPECT_THAT(engine.Process(rgba.GetHandle(), nv12.GetHandle(), GLRect(), 3), Eq(-EINVAL));
+  EXPECT_THAT(engine.Process(rgba.GetHandle(), rgba_small.GetHandle(), GLRect(), 2),
+              Eq(-EINVAL));
+  EXPECT_THAT(engine.Process(rgba.GetHandle(), rgba_small.GetHandle(), GLRect(), 4), Eq(0));
+}
+
+// Milliseconds per 1080x2400 frame for each output format and factor, best of a few runs. A 30 fps
+// client has 33 ms.
+TEST(CPUCwbPostProcessTestCases, Benchmark) {
+  const int kRuns = 5;
+  const int kFrames = 4;
+  std::mt19937 random(48);
+  ColorConvertCSC csc;
+  TestCwbPostProcess engine(2, csc);
+  ASSERT_THAT(engine.Init(), Eq(0));
+
+  TestBuffer src(HAL_PIXEL_FORMAT_RGBA_8888, 1080, 2400);
+  TestBuffer rgba(HAL_PIXEL_FORMAT_RGBA_8888, 1080, 2400);
+  TestBuffer nv12(HAL_PIXEL_FORMAT_YCbCr_420_SP, 1080, 2400);
+  ASSERT_TRUE(src.IsValid() && rgba.IsValid() && nv12.IsValid());
+  src.Randomize(&random);
+
+  const struct {
+    const char *name;
+    const TestBuffer *dst;
+  } outputs[] = {{"RGBA8888", &rgba}, {"NV12", &nv12}};
+
+  for (const auto &output : outputs) {
+    for (uint32_t factor : kFactors) {
+      double best = 1e9;
+      ASSERT_THAT(engine.Process(src.GetHandle(), output.dst->GetHandle(), GLRect(), factor),
+                  Eq(0));
+      for (int run = 0; run < kRuns; run++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kFrames; i++) {
+          engine.Process(src.GetHandle(), output.dst->GetHandle(), GLRect(), factor);
+        }
+        std::chrono::duration<double, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count() / kFrames);
+      }
+      printf("1080x2400 to %s, factor %u: %.2f ms\n", output.name, factor, best);
+    }
+  }
+}
@@ -0,0 +1,337 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <QtiGrallocPriv.h>
+#include <gralloc_priv.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "cpu_layer_stitch_impl.h"
+#include "gr_utils.h"
+using namespace testing;
+using sdm::CPULayerStitchImpl;
+using sdm::Fence;
+using sdm::GLRect;
+using sdm::StitchParams;
+using std::shared_ptr;
+
+namespace {
+
+// Buffer ids the mapping cache of the engine has not seen.
+uint64_t next_id = 1ull << 40;
+
+// An RGBA8888 buffer in a memfd, with the handle and layout BufferManager::AllocateBuffer gives
+// it.
+class TestBuffer {
+ public:
+  TestBuffer(uint32_t width, uint32_t height) : width_(width), height_(height) {
+    unsigned int size = 0;
+    unsigned int aligned_width = 0;
+    unsigned int aligned_height = 0;
+    gralloc::BufferInfo info(static_cast<int>(width), static_cast<int>(height),
+                             HAL_PIXEL_FORMAT_RGBA_8888);
+    if (gralloc::GetBufferSizeAndDimensions(info, &size, &aligned_width, &aligned_height)) {
+      return;
+    }
+
+    int fd = memfd_create("cpu_layer_stitch_test", 0);
+    if (fd < 0 || ftruncate(fd, static_cast<off_t>(size))) {
+      close(fd);
+      return;
+    }
+
+    hnd_ = static_cast<private_handle_t *>(calloc(1, sizeof(private_handle_t)));
+    hnd_->fd = fd;
+    hnd_->fd_metadata = -1;
+    hnd_->magic = qtigralloc::private_handle_t::kMagic;
+    hnd_->width = static_cast<int>(aligned_width);
+    hnd_->height = static_cast<int>(aligned_height);
+    hnd_->unaligned_width = static_cast<int>(width);
+    hnd_->unaligned_height = static_cast<int>(height);
+    hnd_->format = HAL_PIXEL_FORMAT_RGBA_8888;
+    hnd_->layer_count = 1;
+    hnd_->id = next_id++;
+    hnd_->size = size;
+    hnd_->version = static_cast<int>(sizeof(native_handle));
+    hnd_->numInts = qtigralloc::private_handle_t::NumInts();
+    hnd_->numFds = qtigralloc::private_handle_t::kNumFds;
+
+    uint32_t offset[4] = {};
+    uint32_t num_planes = 0;
+    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr != MAP_FAILED && !gralloc::GetBufferLayout(hnd_, stride_, offset, &num_planes)) {
+      base_ = static_cast<uint8_t *>(addr);
+    }
+  }
+
+  ~TestBuffer() {
+    if (base_) {
+      munmap(base_, hnd_->size);
+    }
+    if (hnd_) {
+      close(hnd_->fd);
+      free(hnd_);
+    }
+  }
+
+  bool IsValid() const { return base_ != nullptr; }
+  const native_handle_t *GetHandle() const { return hnd_; }
+  uint32_t GetWidth() const { return width_; }
+  uint32_t GetHeight() const { return height_; }
+  uint32_t GetSize() const { return hnd_->size; }
+  uint8_t *GetBase() const { return base_; }
+  uint8_t *GetPixel(int32_t x, int32_t y) const { return base_ + y * stride_[0] + x * 4; }
+
+  void Randomize(std::mt19937 *random) const {
+    for (uint32_t i = 0; i < hnd_->size; i++) {
+      base_[i] = static_cast<uint8_t>((*random)());
+    }
+  }
+
+ private:
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+  private_handle_t *hnd_ = nullptr;
+  uint8_t *base_ = nullptr;
+  uint32_t stride_[4] = {};
+};
+
+const TestBuffer *FindBuffer(const std::vector<std::unique_ptr<TestBuffer>> &buffers,
+                             const native_handle_t *hnd) {
+  for (auto &buffer : buffers) {
+    if (buffer->GetHandle() == hnd) {
+      return buffer.get();
+    }
+  }
+  return nullptr;
+}
+
+// What GLLayerStitchImpl renders for each StitchParams, a pixel at a time: ClearWithTransparency
+// clears the scissor rect, then the whole source is drawn into dst_rect, clipped to the scissor
+// rect if it has an area. Each target pixel samples the source at its center.
+void RenderReference(const std::vector<StitchParams> &stitch_params,
+                     const std::vector<std::unique_ptr<TestBuffer>> &srcs,
+                     const std::vector<std::unique_ptr<TestBuffer>> &dsts,
+                     const std::vector<std::unique_ptr<TestBuffer>> &references) {
+  for (const StitchParams &params : stitch_params) {
+    size_t index = 0;
+    while (dsts[index]->GetHandle() != params.dst_hnd) {
+      index++;
+    }
+    const TestBuffer &dst = *references[index];
+    const TestBuffer &src = *FindBuffer(srcs, params.src_hnd);
+    int32_t width = int32_t(dst.GetWidth());
+    int32_t height = int32_t(dst.GetHeight());
+
+    const GLRect &scissor = params.scissor_rect;
+    int32_t clip_left = 0;
+    int32_t clip_top = 0;
+    int32_t clip_right = width;
+    int32_t clip_bottom = height;
+    if ((scissor.right - scissor.left) && (scissor.bottom - scissor.top)) {
+      clip_left = std::max(0, int32_t(scissor.left));
+      clip_top = std::max(0, int32_t(scissor.top));
+      clip_right = std::min(width, int32_t(scissor.right));
+      clip_bottom = std::min(height, int32_t(scissor.bottom));
+      for (int32_t y = clip_top; y < clip_bottom; y++) {
+        for (int32_t x = clip_left; x < clip_right; x++) {
+          memset(dst.GetPixel(x, y), 0, 4);
+        }
+      }
+    }
+
+    int32_t left = int32_t(params.dst_rect.left);
+    int32_t top = int32_t(params.dst_rect.top);
+    int32_t right = int32_t(params.dst_rect.right);
+    int32_t bottom = int32_t(params.dst_rect.bottom);
+    for (int32_t y = std::max(top, clip_top); y < std::min(bottom, clip_bottom); y++) {
+      for (int32_t x = std::max(left, clip_left); x < std::min(right, clip_right); x++) {
+        int32_t src_x = int32_t(floor((x - left + 0.5) * src.GetWidth() / (right - left)));
+        int32_t src_y = int32_t(floor((y - top + 0.5) * src.GetHeight() / (bottom - top)));
+        memcpy(dst.GetPixel(x, y), src.GetPixel(src_x, src_y), 4);
+      }
+    }
+  }
+}
+
+// A random position in [-30, size + 30), on a half pixel one time out of three.
+float GetRandomEdge(std::mt19937 *random, uint32_t size) {
+  float edge = float(int32_t((*random)() % (size + 60)) - 30);
+  return ((*random)() % 3) ? edge : edge + 0.5f;
+}
+
+// Stops the helper threads when a test returns, on failed assertions too.
+class TestLayerStitch : public CPULayerStitchImpl {
+ public:
+  ~TestLayerStitch() { Deinit(); }
+};
+
+double GetBlitMs(CPULayerStitchImpl *stitch, const std::vector<StitchParams> &stitch_params,
+                 int runs) {
+  shared_ptr<Fence> release_fence = nullptr;
+  stitch->Blit(stitch_params, &release_fence);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < runs; i++) {
+    stitch->Blit(stitch_params, &release_fence);
+  }
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / runs;
+}
+
+}  // namespace
+
+// 400 random stitches against the reference renderer. Half are the stacked, unscaled slices
+// HWCDisplayBuiltIn stitches, half place sources anywhere, scaled or not, with scissor rects
+// that are random, empty or off the target. Every seventh case stitches into two targets.
+TEST(CPULayerStitchTestCases, MatchesGLReference) {
+  std::mt19937 random(44);
+  TestLayerStitch stitch;
+  ASSERT_THAT(stitch.Init(), Eq(0));
+
+  for (int iteration = 0; iteration < 400; iteration++) {
+    SCOPED_TRACE(testing::Message() << "case " << iteration);
+    std::vector<std::unique_ptr<TestBuffer>> dsts;
+    std::vector<std::unique_ptr<TestBuffer>> references;
+    size_t num_dsts = (iteration % 7) ? 1 : 2;
+    for (size_t i = 0; i < num_dsts; i++) {
+      uint32_t width = 16 + random() % 200;
+      uint32_t height = 16 + random() % 200;
+      dsts.emplace_back(new TestBuffer(width, height));
+      references.emplace_back(new TestBuffer(width, height));
+      ASSERT_TRUE(dsts.back()->IsValid() && references.back()->IsValid());
+      dsts.back()->Randomize(&random);
+      memcpy(references.back()->GetBase(), dsts.back()->GetBase(), dsts.back()->GetSize());
+    }
+
+    std::vector<std::unique_ptr<TestBuffer>> srcs;
+    size_t num_srcs = 1 + random() % 4;
+    for (size_t i = 0; i < num_srcs; i++) {
+      srcs.emplace_back(new TestBuffer(1 + random() % 150, 1 + random() % 150));
+      ASSERT_TRUE(srcs.back()->IsValid());
+      srcs.back()->Randomize(&random);
+    }
+
+    std::vector<StitchParams> stitch_params;
+    size_t num_layers = 1 + random() % 6;
+    bool slices = iteration % 2;
+    float slice_top = 0;
+    for (size_t i = 0; i < num_layers; i++) {
+      const TestBuffer &src = *srcs[random() % num_srcs];
+      const TestBuffer &dst = *dsts[(i * num_dsts) / num_layers];
+      float src_width = float(src.GetWidth());
+      float src_height = float(src.GetHeight());
+      StitchParams params;
+      params.src_hnd = src.GetHandle();
+      params.dst_hnd = dst.GetHandle();
+      if (slices) {
+        params.dst_rect = {0, slice_top, src_width, slice_top + src_height};
+        params.scissor_rect = {0, slice_top, float(dst.GetWidth()),
+                               slice_top + src_height + float(random() % 5)};
+        slice_top += src_height;
+      } else {
+        float left = GetRandomEdge(&random, dst.GetWidth());
+        float top = GetRandomEdge(&random, dst.GetHeight());
+        bool scaled = random() % 2;
+        float width = scaled ? float(1 + random() % 250) : src_width;
+        float height = scaled ? float(1 + random() % 250) : src_height;
+        params.dst_rect = {left, top, left + width, top + height};
+        if (random() % 3) {
+          float scissor_left = GetRandomEdge(&random, dst.GetWidth());
+          float scissor_top = GetRandomEdge(&random, dst.GetHeight());
+          params.scissor_rect = {scissor_left, scissor_top, scissor_left + random() % 200,
+                                 scissor_top + random() % 200};
+        }
+      }
+      stitch_params.push_back(params);
+    }
+
+    shared_ptr<Fence> release_fence = nullptr;
+    ASSERT_THAT(stitch.Blit(stitch_params, &release_fence), Eq(0));
+    RenderReference(stitch_params, srcs, dsts, references);
+    for (size_t i = 0; i < num_dsts; i++) {
+      ASSERT_THAT(memcmp(dsts[i]->GetBase(), references[i]->GetBase(), dsts[i]->GetSize()), Eq(0))
+        << "target " << i;
+    }
+  }
+}
+
+// Stacked slices of one unscaled source read contiguous memory and become a single copy, their
+// clears are all covered by it.
+TEST(CPULayerStitchTestCases, PlannerMergesStackedSlices) {
+  std::vector<CPULayerStitchImpl::StitchLayer> layers;
+  for (int32_t i = 0; i < 4; i++) {
+    CPULayerStitchImpl::StitchLayer layer;
+    layer.src_width = 1080;
+    layer.src_height = 2400;
+    layer.dst_rect = {0, 0, 1080, 2400};
+    layer.scissor_rect = {0, float(i * 600), 1080, float(i * 600 + 600)};
+    layers.push_back(layer);
+  }
+
+  std::vector<CPULayerStitchImpl::StitchOp> ops;
+  CPULayerStitchImpl::PlanStitch(layers, 1080, 3600, &ops);
+  ASSERT_THAT(ops.size(), Eq(1u));
+  EXPECT_THAT(ops[0].type, Eq(CPULayerStitchImpl::kOpCopy));
+  EXPECT_THAT(ops[0].rect.top, Eq(0));
+  EXPECT_THAT(ops[0].rect.right, Eq(1080));
+  EXPECT_THAT(ops[0].rect.bottom, Eq(2400));
+}
+
+TEST(CPULayerStitchTestCases, PlannerClipsToTarget) {
+  CPULayerStitchImpl::StitchLayer layer;
+  layer.src_width = 100;
+  layer.src_height = 100;
+  layer.dst_rect = {-50, -50, 50, 50};
+
+  std::vector<CPULayerStitchImpl::StitchOp> ops;
+  CPULayerStitchImpl::PlanStitch({layer}, 40, 40, &ops);
+  ASSERT_THAT(ops.size(), Eq(1u));
+  EXPECT_THAT(ops[0].type, Eq(CPULayerStitchImpl::kOpCopy));
+  EXPECT_THAT(ops[0].src_x, Eq(50));
+  EXPECT_THAT(ops[0].src_y, Eq(50));
+  EXPECT_THAT(ops[0].rect.right, Eq(40));
+  EXPECT_THAT(ops[0].rect.bottom, Eq(40));
+}
+
+// Time to stitch four 1080x600 slices into a 1080x2400 target, as copies and scaled to half the
+// width. A 60 fps stitch has 16 ms.
+TEST(CPULayerStitchTestCases, Benchmark) {
+  TestBuffer dst(1080, 2400);
+  ASSERT_TRUE(dst.IsValid());
+  std::vector<std::unique_ptr<TestBuffer>> srcs;
+  std::vector<StitchParams> stitch_params;
+  for (int32_t i = 0; i < 4; i++) {
+    srcs.emplace_back(new TestBuffer(1080, 600));
+    ASSERT_TRUE(srcs.back()->IsValid());
+    StitchParams params;
+    params.src_hnd = srcs.back()->GetHandle();
+    params.dst_hnd = dst.GetHandle();
+    params.dst_rect = {0, float(i * 600), 1080, float(i * 600 + 600)};
+    params.scissor_rect = params.dst_rect;
+    stitch_params.push_back(params);
+  }
+
+  TestLayerStitch stitch;
+  ASSERT_THAT(stitch.Init(), Eq(0));
+  double copy_ms = GetBlitMs(&stitch, stitch_params, 100);
+  for (StitchParams &params : stitch_params) {
+    params.dst_rect.right = 540;
+  }
+  double scale_ms = GetBlitMs(&stitch, stitch_params, 50);
+
+  printf("4 x 1080x600 stitch: %.3f ms, scaled to 540x600: %.3f ms\n", copy_ms, scale_ms);
+}
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include <utils/locker.h>
+#include <utils/seqlock.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "hwc_display_config_snapshot.h"
+using namespace testing;
+using sdm::HWCDisplayConfigSnapshot;
+using sdm::LockSite;
+using sdm::Locker;
+using sdm::SeqLock;
+
+namespace {
+
+const uint32_t kNumConfigs = 4;
+
+int32_t GetVsyncPeriod(uint32_t index) {
+  return INT32_C(1000000000) / int32_t(30 * (index + 1));
+}
+
+// A panel with 30, 60, 90 and 120 Hz configs in two groups, two color modes and HDR10.
+HWCDisplayConfigSnapshot MakeSnapshot(hwc2_config_t active_config) {
+  HWCDisplayConfigSnapshot snapshot;
+  snapshot.valid = true;
+  snapshot.active_config = active_config;
+  snapshot.num_configs = kNumConfigs;
+  for (uint32_t i = 0; i < kNumConfigs; i++) {
+    HWCDisplayConfigSnapshot::Config &config = snapshot.configs[i];
+    config.id = 10 + i;
+    config.vsync_period = GetVsyncPeriod(i);
+    config.width = 1080;
+    config.height = 2400;
+    config.dpi_x = 400000;
+    config.dpi_y = 401000;
+    config.config_group = int32_t(i / 2);
+  }
+  snapshot.num_color_modes = 2;
+  snapshot.color_modes[0].mode = ColorMode::NATIVE;
+  snapshot.color_modes[0].num_intents = 1;
+  snapshot.color_modes[0].intents[0] = RenderIntent::COLORIMETRIC;
+  snapshot.color_modes[1].mode = ColorMode::DISPLAY_P3;
+  snapshot.color_modes[1].num_intents = 2;
+  snapshot.color_modes[1].intents[0] = RenderIntent::COLORIMETRIC;
+  snapshot.color_modes[1].intents[1] = RenderIntent::ENHANCE;
+  snapshot.num_hdr_types = 1;
+  snapshot.hdr_types[0] = 2;
+  snapshot.max_luminance = 1000.0f;
+  snapshot.max_average_luminance = 500.0f;
+  snapshot.min_luminance = 0.01f;
+  return snapshot;
+}
+
+uint64_t GetTimeNs() {
+  struct timespec ts = {};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return uint64_t(ts.tv_sec) * 1000000000ULL + uint64_t(ts.tv_nsec);
+}
+
+uint64_t GetPercentile(std::vector<uint64_t> *samples, uint32_t percentile) {
+  if (samples->empty()) {
+    return 0;
+  }
+  size_t index = std::min(samples->size() - 1, samples->size() * percentile / 100);
+  std::nth_element(samples->begin(), samples->begin() + index, samples->end());
+  return (*samples)[index];
+}
+
+// The per display state HWCSession keeps: the display lock, held through validate and present,
+// and the config snapshot it publishes under that lock.
+struct SessionDisplay {
+  Locker locker;
+  SeqLock<HWCDisplayConfigSnapshot> config_snapshot;
+  HWCDisplayConfigSnapshot config;  // what the display answers with under the lock
+};
+
+}  // namespace
+
+TEST(HWCDisplayConfigSnapshotTestCases, DisplayConfigs) {
+  HWCDisplayConfigSnapshot snapshot = MakeSnapshot(10);
+  uint32_t num_configs = 0;
+  snapshot.GetDisplayConfigs(&num_configs, nullptr);
+  EXPECT_THAT(num_configs, Eq(kNumConfigs));
+
+  hwc2_config_t configs[kNumConfigs] = {};
+  num_configs = 2;
+  snapshot.GetDisplayConfigs(&num_configs, configs);
+  EXPECT_THAT(num_configs, Eq(2u));
+  EXPECT_THAT(configs[0], Eq(10u));
+  EXPECT_THAT(configs[1], Eq(11u));
+  EXPECT_THAT(configs[2], Eq(0u));
+}
+
+TEST(HWCDisplayConfigSnapshotTestCases, DisplayAttribute) {
+  HWCDisplayConfigSnapshot snapshot = MakeSnapshot(10);
+  int32_t value = 0;
+  EXPECT_TRUE(snapshot.GetDisplayAttribute(13, HwcAttribute::VSYNC_PERIOD, &value));
+  EXPECT_THAT(value, Eq(GetVsyncPeriod(3)));
+  EXPECT_TRUE(snapshot.GetDisplayAttribute(13, HwcAttribute::CONFIG_GROUP, &value));
+  EXPECT_THAT(value, Eq(1));
+  EXPECT_TRUE(snapshot.GetDisplayAttribute(11, HwcAttribute::DPI_Y, &value));
+  EXPECT_THAT(value, Eq(401000));
+
+  // Left to the display, which reports the error.
+  value = -1;
+  EXPECT_FALSE(snapshot.GetDisplayAttribute(9, HwcAttribute::WIDTH, &value));
+  EXPECT_FALSE(snapshot.GetDisplayAttribute(10, HwcAttribute::INVALID, &value));
+  EXPECT_THAT(value, Eq(-1));
+}
+
+TEST(HWCDisplayConfigSnapshotTestCases, ColorModesAndIntents) {
+  HWCDisplayConfigSnapshot snapshot = MakeSnapshot(10);
+  uint32_t num_modes = 0;
+  snapshot.GetColorModes(&num_modes, nullptr);
+  ASSERT_THAT(num_modes, Eq(2u));
+  ColorMode modes[2] = {};
+  snapshot.GetColorModes(&num_modes, modes);
+  EXPECT_THAT(modes[1], Eq(ColorMode::DISPLAY_P3));
+
+  uint32_t num_intents = 0;
+  EXPECT_TRUE(snapshot.GetRenderIntents(ColorMode::DISPLAY_P3, &num_intents, nullptr));
+  EXPECT_THAT(num_intents, Eq(2u));
+  RenderIntent intents[2] = {};
+  num_intents = 1;
+  EXPECT_TRUE(snapshot.GetRenderIntents(ColorMode::DISPLAY_P3, &num_intents, intents));
+  EXPECT_THAT(num_intents, Eq(1u));
+  EXPECT_THAT(intents[0], Eq(RenderIntent::COLORIMETRIC));
+  EXPECT_FALSE(snapshot.GetRenderIntents(ColorMode::SRGB, &num_intents, nullptr));
+}
+
+TEST(HWCDisplayConfigSnapshotTestCases, HdrCapabilities) {
+  HWCDisplayConfigSnapshot snapshot = MakeSnapshot(10);
+  uint32_t num_types = 0;
+  float max_luminance = 0.0f;
+  float max_average_luminance = 0.0f;
+  float min_luminance = 0.0f;
+  snapshot.GetHdrCapabilities(&num_types, nullptr, &max_luminance, &max_average_luminance,
+                              &min_luminance);
+  EXPECT_THAT(num_types, Eq(1u));
+  EXPECT_THAT(max_luminance, Eq(0.0f));
+
+  int32_t types[1] = {};
+  snapshot.GetHdrCapabilities(&num_types, types, &max_luminance, &max_average_luminance,
+                              &min_luminance);
+  EXPECT_THAT(types[0], Eq(2));
+  EXPECT_THAT(max_luminance, Eq(1000.0f));
+  EXPECT_THAT(max_average_luminance, Eq(500.0f));
+  EXPECT_THAT(min_luminance, Eq(0.01f));
+}
+
+// Getters run against a composer thread that holds the display lock through long frames and
+// switches the active config every few frames. Snapshot getters must neither wait for the frame
+// nor see a config from one publish and attributes from another; getters on the locked path wait
+// for the frame to end.
+TEST(HWCDisplayConfigSnapshotTestCases, GetterLatencyUnderPresent) {
+  const auto kFrame = std::chrono::milliseconds(8);
+  const int kFrames = 40;
+  const int kReaders = 2;
+
+  SessionDisplay display;
+  display.locker.EnablePriorityInheritance();
+  display.config = MakeSnapshot(10);
+  display.config_snapshot.Write(display.config);
+
+  std::atomic<bool> done {false};
+  std::thread composer([&] {
+    for (int frame = 0; frame < kFrames; frame++) {
+      SCOPE_LOCK(display.locker);
+      std::this_thread::sleep_for(kFrame);
+      if (frame % 4 == 3) {
+        display.config.active_config = 10 + (display.config.active_config - 9) % kNumConfigs;
+        display.config_snapshot.Write(display.config);
+      }
+    }
+    done = true;
+  });
+
+  std::vector<std::vector<uint64_t>> snapshot_ns(kReaders);
+  std::vector<std::vector<uint64_t>> locked_ns(kReaders);
+  std::atomic<uint64_t> inconsistent {0};
+  std::vector<std::thread> readers;
+  for (int r = 0; r < kReaders; r++) {
+    readers.emplace_back([&, r] {
+      while (!done) {
+        // As HWCSession::GetActiveConfig followed by GetDisplayAttribute.
+        uint64_t start_ns = GetTimeNs();
+        HWCDisplayConfigSnapshot snapshot;
+        display.config_snapshot.Read(&snapshot);
+        int32_t vsync_period = 0;
+        bool found = snapshot.valid &&
+                     snapshot.GetDisplayAttribute(snapshot.active_config,
+                                                  HwcAttribute::VSYNC_PERIOD, &vsync_period);
+        snapshot_ns[r].push_back(GetTimeNs() - start_ns);
+        if (!found || vsync_period != GetVsyncPeriod(snapshot.active_config - 10)) {
+          inconsistent++;
+        }
+
+        // The same getters on the locked path, at a lower rate to leave the lock to the frames.
+        if (snapshot_ns[r].size() % 64 == 0) {
+          start_ns = GetTimeNs();
+          {
+            SCOPE_LOCK(display.locker);
+            display.config.GetDisplayAttribute(display.config.active_config,
+                                               HwcAttribute::VSYNC_PERIOD, &vsync_period);
+          }
+          locked_ns[r].push_back(GetTimeNs() - start_ns);
+        }
+      }
+    });
+  }
+
+  composer.join();
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  std::vector<uint64_t> snapshot_all;
+  std::vector<uint64_t> locked_all;
+  for (int r = 0; r < kReaders; r++) {
+    snapshot_all.insert(snapshot_all.end(), snapshot_ns[r].begin(), snapshot_ns[r].end());
+    locked_all.insert(locked_all.end(), locked_ns[r].begin(), locked_ns[r].end());
+  }
+  ASSERT_THAT(snapshot_all.size(), Gt(1000u));
+  ASSERT_THAT(locked_all.size(), Gt(0u));
+
+  uint64_t snapshot_p50 = GetPercentile(&snapshot_all, 50);
+  uint64_t snapshot_p99 = GetPercentile(&snapshot_all, 99);
+  uint64_t locked_p50 = GetPercentile(&locked_all, 50);
+  uint64_t locked_p99 = GetPercentile(&locked_all, 99);
+  printf("snapshot getters: %zu calls, p50 %llu ns, p99 %llu ns\n", snapshot_all.size(),
+         (unsigned long long)snapshot_p50, (unsigned long long)snapshot_p99);
+  printf("locked getters: %zu calls, p50 %llu ns, p99 %llu ns\n", locked_all.size(),
+         (unsigned long long)locked_p50, (unsigned long long)locked_p99);
+
+  EXPECT_THAT(inconsistent.load(), Eq(0u));
+  uint64_t frame_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(kFrame).count();
+  EXPECT_THAT(snapshot_p99, Lt(frame_ns / 8));
+  EXPECT_THAT(locked_p50, Gt(snapshot_p99));
+}
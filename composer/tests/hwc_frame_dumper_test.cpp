@@ -0,0 +1,383 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <cutils/native_handle.h>
+#include <errno.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <utils/fence.h>
+#include <utils/worker_pool.h>
+#include <zlib.h>
+
+#include <condition_variable>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "hwc_frame_dumper.h"
+using namespace testing;
+using sdm::Fence;
+using sdm::FrameDumpBufferOps;
+using sdm::HWCFrameDumper;
+using sdm::WorkerPool;
+using std::shared_ptr;
+
+namespace {
+
+std::string ReadFile(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+std::string ReadGzFile(const std::string &path) {
+  std::string contents;
+  gzFile gz = gzopen(path.c_str(), "rb");
+  if (!gz) {
+    return contents;
+  }
+  char chunk[4096];
+  int read = 0;
+  while ((read = gzread(gz, chunk, sizeof(chunk))) > 0) {
+    contents.append(chunk, size_t(read));
+  }
+  gzclose(gz);
+  return contents;
+}
+
+// Keeps the frame dump lane busy until released, so queued copies stay staged.
+class LaneBlocker {
+ public:
+  LaneBlocker() {
+    std::shared_future<void> released = release_.get_future().share();
+    WorkerPool::GetInstance()->Post(sdm::kLaneFrameDump, [released]() { released.wait(); });
+  }
+  ~LaneBlocker() { Release(); }
+  void Release() {
+    if (!released_) {
+      release_.set_value();
+      released_ = true;
+    }
+  }
+
+ private:
+  std::promise<void> release_;
+  bool released_ = false;
+};
+
+// Fences are eventfds that signal when the test says so. A wait that times out fails.
+class TestSyncHandler : public sdm::BufferSyncHandler {
+ public:
+  shared_ptr<Fence> CreateFence(int *fd) {
+    *fd = eventfd(0, 0);
+    // The number may belong to an earlier, closed fence.
+    std::lock_guard<std::mutex> lock(mutex_);
+    signaled_.erase(*fd);
+    return Fence::Create(*fd, "frame_dumper_test");
+  }
+  void Signal(int fd) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    signaled_.insert(fd);
+    cv_.notify_all();
+  }
+  std::vector<std::thread::id> GetWaiters() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return waiters_;
+  }
+
+  int SyncWait(int fd, int timeout) override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (fd < 0) {
+      return 0;
+    }
+    waiters_.push_back(std::this_thread::get_id());
+    bool signaled = cv_.wait_for(lock, std::chrono::milliseconds(timeout),
+                                 [this, fd] { return signaled_.count(fd) != 0; });
+    return signaled ? 0 : -ETIME;
+  }
+  int SyncMerge(int fd1, int fd2, int *merged_fd) override { return -EINVAL; }
+  void GetSyncInfo(int fd, std::ostringstream *os) override {}
+  int GetSignalTime(int fd, int64_t *signal_time_ns) override { return -EINVAL; }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::set<int> signaled_;
+  std::vector<std::thread::id> waiters_;
+};
+
+// A single buffer whose pixels live in contents. Retained handles are counted and checked on
+// every use, mapping records the calling thread.
+class TestBufferOps : public FrameDumpBufferOps {
+ public:
+  explicit TestBufferOps(const std::string *contents) : contents_(contents) {
+    handle_ = native_handle_create(0, 0);
+  }
+  ~TestBufferOps() { native_handle_delete(handle_); }
+
+  const native_handle_t *GetHandle() const { return handle_; }
+  size_t GetRetained() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return retained_.size();
+  }
+  std::vector<std::thread::id> GetMappers() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return mappers_;
+  }
+
+  const native_handle_t *RetainBuffer(const native_handle_t *handle) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (handle != handle_) {
+      return nullptr;
+    }
+    native_handle_t *retained = native_handle_create(0, 0);
+    retained_.insert(retained);
+    return retained;
+  }
+  void ReleaseBuffer(const native_handle_t *handle) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    EXPECT_THAT(retained_.erase(handle), Eq(1u));
+    native_handle_delete(const_cast<native_handle_t *>(handle));
+  }
+  int MapBuffer(const native_handle_t *handle, shared_ptr<Fence> acquire_fence,
+                void **base_ptr) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    EXPECT_THAT(retained_.count(handle), Eq(1u));
+    mappers_.push_back(std::this_thread::get_id());
+    *base_ptr = const_cast<char *>(contents_->data());
+    return 0;
+  }
+  int UnmapBuffer(const native_handle_t *handle, int *release_fence) override {
+    *release_fence = -1;
+    return 0;
+  }
+
+ private:
+  const std::string *contents_;
+  native_handle_t *handle_ = nullptr;
+  std::mutex mutex_;
+  std::set<const native_handle_t *> retained_;
+  std::vector<std::thread::id> mappers_;
+};
+
+TestSyncHandler sync_handler;
+
+class HWCFrameDumperTestCases : public Test {
+ protected:
+  void SetUp() override {
+    Fence::Set(&sync_handler);
+    dumper_->SetConfig(HWCFrameDumper::kDropNewest, false, 4, 1024 * 1024);
+  }
+  void TearDown() override {
+    WorkerPool::GetInstance()->Drain(sdm::kLaneFrameDump);
+    // The dumper is process wide, a zero limit drops the spare buffers this test left.
+    dumper_->SetConfig(HWCFrameDumper::kDropNewest, false, 4, 0);
+    for (auto &path : paths_) {
+      unlink(path.c_str());
+      unlink((path + ".gz").c_str());
+    }
+  }
+
+  std::string Path(int index) {
+    std::string path = TempDir() + "frame_dump_" +
+                       UnitTest::GetInstance()->current_test_info()->name() + "_" +
+                       std::to_string(index) + ".raw";
+    paths_.push_back(path);
+    return path;
+  }
+
+  std::string DumpStats() {
+    std::ostringstream os;
+    dumper_->Dump(&os);
+    return os.str();
+  }
+
+  HWCFrameDumper *dumper_ = HWCFrameDumper::GetInstance();
+  std::vector<std::string> paths_;
+};
+
+}  // namespace
+
+TEST_F(HWCFrameDumperTestCases, WritesACopyOfTheBuffer) {
+  std::string frame(64 * 1024, 'a');
+  const std::string path = Path(0);
+  {
+    LaneBlocker blocker;
+    EXPECT_THAT(dumper_->QueueCopy(path, frame.data(), frame.size()), Eq(0));
+    // The buffer may be reused right away, the dump keeps the contents at queue time.
+    frame.assign(frame.size(), 'b');
+  }
+  WorkerPool::GetInstance()->Drain(sdm::kLaneFrameDump);
+  EXPECT_THAT(ReadFile(path), Eq(std::string(frame.size(), 'a')));
+
+  EXPECT_THAT(dumper_->QueueCopy(path, nullptr, 16), Eq(-EINVAL));
+  EXPECT_THAT(dumper_->QueueCopy(path, frame.data(), 0), Eq(-EINVAL));
+}
+
+TEST_F(HWCFrameDumperTestCases, DropNewestKeepsStagedFrames) {
+  const std::string frame(1024, 'x');
+  {
+    LaneBlocker blocker;
+    for (int i = 0; i < 4; i++) {
+      EXPECT_THAT(dumper_->QueueCopy(Path(i), frame.data(), frame.size()), Eq(0));
+    }
+    EXPECT_THAT(dumper_->QueueCopy(Path(4), frame.data(), frame.size()), Eq(-ENOBUFS));
+  }
+  WorkerPool::GetInstance()->Drain(sdm::kLaneFrameDump);
+  for (int i = 0; i < 4; i++) {
+    EXPECT_THAT(access(paths_[i].c_str(), F_OK), Eq(0)) << paths_[i];
+  }
+  EXPECT_THAT(access(paths_[4].c_str(), F_OK), Ne(0));
+}
+
+TEST_F(HWCFrameDumperTestCases, DropOldestMakesRoom) {
+  dumper_->SetConfig(HWCFrameDumper::kDropOldest, false, 2, 1024 * 1024);
+  const std::string frame(1024, 'x');
+  {
+    LaneBlocker blocker;
+    for (int i = 0; i < 3; i++) {
+      EXPECT_THAT(dumper_->QueueCopy(Path(i), frame.data(), frame.size()), Eq(0));
+    }
+  }
+  WorkerPool::GetInstance()->Drain(sdm::kLaneFrameDump);
+  EXPECT_THAT(access(paths_[0].c_str(), F_OK), Ne(0));
+  EXPECT_THAT(access(paths_[1].c_str(), F_OK), Eq(0));
+  EXPECT_THAT(access(paths_[2].c_str(), F_OK), Eq(0));
+}
+
+TEST_F(HWCFrameDumperTestCases, StagedBytesAreBounded) {
+  dumper_->SetConfig(HWCFrameDumper::kDropOldest, false, 8, 1000);
+  const std::string frame(600, 'x');
+  const std::string too_big(2000, 'x');
+  {
+    LaneBlocker blocker;
+    EXPECT_THAT(dumper_->QueueCopy(Path(0), too_big.data(), too_big.size()), Eq(-ENOBUFS));
+    EXPECT_THAT(dumper_->QueueCopy(Path(1), frame.data(), frame.size()), Eq(0));
+    EXPECT_THAT(DumpStats(), HasSubstr("600 bytes staged"));
+    // Only one 600 byte frame fits, the second one replaces the first.
+    EXPECT_THAT(dumper_->QueueCopy(Path(2), frame.data(), frame.size()), Eq(0));
+    EXPECT_THAT(DumpStats(), HasSubstr("pending 1 (600 bytes staged"));
+  }
+  WorkerPool::GetInstance()->Drain(sdm::kLaneFrameDump);
+  EXPECT_THAT(access(paths_[1].c_str(), F_OK), Ne(0));
+  EXPECT_THAT(ReadFile(paths_[2]), Eq(frame));
+}
+
+TEST_F(HWCFrameDumperTestCases, WrittenBuffersAreReused) {
+  const std::string frame(256 * 1024, 'x');
+  for (int i = 0; i < 3; i++) {
+    EXPECT_THAT(dumper_->QueueCopy(Path(i), frame.data(), frame.size()), Eq(0));
+    WorkerPool::GetInstance()->Drain(sdm::kLaneFrameDump);
+    // Every frame of the same size goes through the same staging buffer.
+    EXPECT_THAT(DumpStats(), HasSubstr("1 spare buffers of 262144 bytes"));
+  }
+
+  // A smaller limit leaves no room for spares next to the staged frame.
+  dumper_->SetConfig(HWCFrameDumper::kDropNewest, false, 4, 300 * 1024);
+  const std::string larger(frame.size() + 1, 'y');
+  {
+    LaneBlocker blocker;
+    EXPECT_THAT(dumper_->QueueCopy(Path(3), larger.data(), larger.size()), Eq(0));
+    EXPECT_THAT(DumpStats(), HasSubstr("0 spare buffers"));
+  }
+  WorkerPool::GetInstance()->Drain(sdm::kLaneFrameDump);
+  EXPECT_THAT(ReadFile(paths_[3]), Eq(larger));
+}
+
+TEST_F(HWCFrameDumperTestCases, CompressedDumps) {
+  dumper_->SetConfig(HWCFrameDumper::kDropNewest, true, 4, 1024 * 1024);
+  std::string frame(128 * 1024, 'c');
+  frame[1000] = 'd';
+  const std::string path = Path(0);
+  EXPECT_THAT(dumper_->QueueCopy(path, frame.data(), frame.size()), Eq(0));
+  WorkerPool::GetInstance()->Drain(sdm::kLaneFrameDump);
+  EXPECT_THAT(access(path.c_str(), F_OK), Ne(0));
+  EXPECT_THAT(ReadGzFile(path + ".gz"), Eq(frame));
+}
+
+TEST_F(HWCFrameDumperTestCases, QueuedBufferIsReadOnTheWriter) {
+  std::string contents(64 * 1024, 'a');
+  TestBufferOps ops(&contents);
+  int fd = -1;
+  shared_ptr<Fence> fence = sync_handler.CreateFence(&fd);
+  const std::string path = Path(0);
+  EXPECT_THAT(dumper_->QueueBuffer(path, ops.GetHandle(), contents.size(), fence, &ops), Eq(0));
+
+  // Until the fence signals the producer may still be writing, nothing is read yet.
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_THAT(ops.GetMappers(), IsEmpty());
+  EXPECT_THAT(ops.GetRetained(), Eq(1u));
+  contents.assign(contents.size(), 'b');
+  sync_handler.Signal(fd);
+  WorkerPool::GetInstance()->Drain(sdm::kLaneFrameDump);
+
+  EXPECT_THAT(ReadFile(path), Eq(contents));
+  EXPECT_THAT(ops.GetRetained(), Eq(0u));
+  EXPECT_THAT(ops.GetMappers(), ElementsAre(Ne(std::this_thread::get_id())));
+  EXPECT_THAT(sync_handler.GetWaiters(), Not(Contains(std::this_thread::get_id())));
+}
+
+TEST_F(HWCFrameDumperTestCases, QueueBufferRejectsBadInput) {
+  std::string contents(1024, 'a');
+  TestBufferOps ops(&contents);
+  const std::string path = Path(0);
+  EXPECT_THAT(dumper_->QueueBuffer(path, nullptr, contents.size(), nullptr, &ops), Eq(-EINVAL));
+  EXPECT_THAT(dumper_->QueueBuffer(path, ops.GetHandle(), 0, nullptr, &ops), Eq(-EINVAL));
+  EXPECT_THAT(dumper_->QueueBuffer(path, ops.GetHandle(), contents.size(), nullptr, nullptr),
+              Eq(-EINVAL));
+
+  // A handle that cannot be retained is not queued.
+  native_handle_t *other = native_handle_create(0, 0);
+  EXPECT_THAT(dumper_->QueueBuffer(path, other, contents.size(), nullptr, &ops), Eq(-ENOMEM));
+  native_handle_delete(other);
+  EXPECT_THAT(DumpStats(), HasSubstr("pending 0"));
+}
+
+TEST_F(HWCFrameDumperTestCases, DroppedBuffersAreReleased) {
+  dumper_->SetConfig(HWCFrameDumper::kDropOldest, false, 2, 1024 * 1024);
+  std::string contents(1024, 'x');
+  TestBufferOps ops(&contents);
+  {
+    LaneBlocker blocker;
+    for (int i = 0; i < 3; i++) {
+      EXPECT_THAT(dumper_->QueueBuffer(Path(i), ops.GetHandle(), contents.size(), nullptr, &ops),
+                  Eq(0));
+    }
+    EXPECT_THAT(ops.GetRetained(), Eq(2u));
+
+    // Dropping the incoming buffer does not retain it at all.
+    dumper_->SetConfig(HWCFrameDumper::kDropNewest, false, 2, 1024 * 1024);
+    EXPECT_THAT(dumper_->QueueBuffer(Path(3), ops.GetHandle(), contents.size(), nullptr, &ops),
+                Eq(-ENOBUFS));
+    EXPECT_THAT(ops.GetRetained(), Eq(2u));
+  }
+  WorkerPool::GetInstance()->Drain(sdm::kLaneFrameDump);
+  EXPECT_THAT(ops.GetRetained(), Eq(0u));
+  EXPECT_THAT(access(paths_[0].c_str(), F_OK), Ne(0));
+  EXPECT_THAT(ReadFile(paths_[1]), Eq(contents));
+  EXPECT_THAT(ReadFile(paths_[2]), Eq(contents));
+  EXPECT_THAT(access(paths_[3].c_str(), F_OK), Ne(0));
+}
+
+TEST_F(HWCFrameDumperTestCases, UnsignaledFenceWritesNothing) {
+  std::string contents(1024, 'x');
+  TestBufferOps ops(&contents);
+  int fd = -1;
+  shared_ptr<Fence> fence = sync_handler.CreateFence(&fd);
+  const std::string path = Path(0);
+  EXPECT_THAT(dumper_->QueueBuffer(path, ops.GetHandle(), contents.size(), fence, &ops), Eq(0));
+  WorkerPool::GetInstance()->Drain(sdm::kLaneFrameDump);
+
+  EXPECT_THAT(access(path.c_str(), F_OK), Ne(0));
+  EXPECT_THAT(ops.GetMappers(), IsEmpty());
+  EXPECT_THAT(ops.GetRetained(), Eq(0u));
+}
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <sys/eventfd.h>
+#include <utils/constants.h>
+#include <utils/fence.h>
+#include <utils/worker_pool.h>
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "hwc_frame_timing.h"
+using namespace testing;
+using sdm::Fence;
+using sdm::FrameTimingPercentiles;
+using sdm::FrameTimingRecord;
+using sdm::HWCFrameTimingRing;
+using sdm::WorkerPool;
+using std::shared_ptr;
+
+namespace {
+
+const int64_t kMsNs = 1000000;
+const int64_t kPeriodNs = 16666666;
+
+// Fences are eventfds with a signal time the test sets. Lookups record the calling thread.
+class TimingSyncHandler : public sdm::BufferSyncHandler {
+ public:
+  shared_ptr<Fence> CreateFence(int *fd) {
+    *fd = eventfd(0, 0);
+    // The number may belong to an earlier, closed fence.
+    std::lock_guard<std::mutex> lock(mutex_);
+    signal_ns_.erase(*fd);
+    return Fence::Create(*fd, "frame_timing_test");
+  }
+  void Signal(int fd, int64_t signal_ns) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    signal_ns_[fd] = signal_ns;
+  }
+  std::vector<std::thread::id> GetLookups() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lookups_;
+  }
+  void ClearLookups() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lookups_.clear();
+  }
+
+  int SyncWait(int fd, int timeout) override { return 0; }
+  int SyncMerge(int fd1, int fd2, int *merged_fd) override { return -EINVAL; }
+  void GetSyncInfo(int fd, std::ostringstream *os) override {}
+  int GetSignalTime(int fd, int64_t *signal_time_ns) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lookups_.push_back(std::this_thread::get_id());
+    auto it = signal_ns_.find(fd);
+    if (it == signal_ns_.end()) {
+      return -EAGAIN;
+    }
+    *signal_time_ns = it->second;
+    return 0;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::map<int, int64_t> signal_ns_;
+  std::vector<std::thread::id> lookups_;
+};
+
+TimingSyncHandler sync_handler;
+
+// Validate of frame starts frame ms in and takes frame us.
+FrameTimingRecord MakeRecord(uint64_t frame) {
+  FrameTimingRecord record;
+  record.validate_start_ns = int64_t(frame) * kMsNs;
+  record.validate_end_ns = record.validate_start_ns + int64_t(frame) * 1000;
+  record.strategy_us = UINT32(frame);
+  record.hw_commit_us = UINT32(frame) * 2;
+  record.vsync_period_ns = kPeriodNs;
+  return record;
+}
+
+class HWCFrameTimingTestCases : public Test {
+ protected:
+  void SetUp() override {
+    Fence::Set(&sync_handler);
+    sync_handler.ClearLookups();
+    ring_ = std::make_unique<HWCFrameTimingRing>();
+  }
+  void TearDown() override {
+    // Lookups posted by Push hold the ring.
+    WorkerPool::GetInstance()->Drain(sdm::kLaneFrameDump);
+    ring_.reset();
+  }
+
+  FrameTimingPercentiles GetPercentiles() {
+    FrameTimingPercentiles percentiles;
+    ring_->GetPercentiles(&percentiles);
+    return percentiles;
+  }
+
+  std::unique_ptr<HWCFrameTimingRing> ring_;
+};
+
+}  // namespace
+
+TEST_F(HWCFrameTimingTestCases, PercentilesOfKnownValues) {
+  for (uint64_t frame = 1; frame <= 100; frame++) {
+    EXPECT_THAT(ring_->Push(MakeRecord(frame), nullptr), Eq(frame));
+  }
+
+  FrameTimingPercentiles percentiles = GetPercentiles();
+  EXPECT_THAT(percentiles.samples[sdm::kMetricStrategy], Eq(100u));
+  EXPECT_THAT(percentiles.p50[sdm::kMetricStrategy], Eq(50u));
+  EXPECT_THAT(percentiles.p95[sdm::kMetricStrategy], Eq(95u));
+  EXPECT_THAT(percentiles.p99[sdm::kMetricStrategy], Eq(99u));
+  EXPECT_THAT(percentiles.p50[sdm::kMetricHwCommit], Eq(100u));
+  EXPECT_THAT(percentiles.samples[sdm::kMetricValidate], Eq(100u));
+  EXPECT_THAT(percentiles.p99[sdm::kMetricValidate], Eq(99u));
+  // No retire fences, nothing known about retire.
+  EXPECT_THAT(percentiles.samples[sdm::kMetricRetireLatency], Eq(0u));
+  EXPECT_THAT(percentiles.samples[sdm::kMetricVsyncDeviation], Eq(0u));
+}
+
+TEST_F(HWCFrameTimingTestCases, WraparoundKeepsLatestFrames) {
+  const uint64_t kFrames = HWCFrameTimingRing::kCapacity + 10;
+  for (uint64_t frame = 1; frame <= kFrames; frame++) {
+    ring_->Push(MakeRecord(frame), nullptr);
+  }
+
+  // Frame 10 shares its slot with the last frame and has left the ring.
+  ring_->SetRetireSignal(10, MakeRecord(kFrames).validate_start_ns + 3 * kMsNs);
+  FrameTimingPercentiles percentiles = GetPercentiles();
+  EXPECT_THAT(percentiles.samples[sdm::kMetricRetireLatency], Eq(0u));
+
+  ring_->SetRetireSignal(kFrames, MakeRecord(kFrames).validate_start_ns + 5 * kMsNs);
+  ring_->SetRetireSignal(kFrames - 1, MakeRecord(kFrames - 1).validate_start_ns + 4 * kMsNs);
+  percentiles = GetPercentiles();
+  EXPECT_THAT(percentiles.samples[sdm::kMetricStrategy], Eq(HWCFrameTimingRing::kCapacity));
+  // Frames 11 to 138 are left, index 63 of them is the median.
+  EXPECT_THAT(percentiles.p50[sdm::kMetricStrategy], Eq(74u));
+  EXPECT_THAT(percentiles.p99[sdm::kMetricStrategy], Eq(136u));
+  EXPECT_THAT(percentiles.samples[sdm::kMetricRetireLatency], Eq(2u));
+  EXPECT_THAT(percentiles.p50[sdm::kMetricRetireLatency], Eq(4000u));
+  // The two retires are 2 ms apart, 2 ms off the vsync grid.
+  EXPECT_THAT(percentiles.samples[sdm::kMetricVsyncDeviation], Eq(1u));
+  EXPECT_THAT(percentiles.p50[sdm::kMetricVsyncDeviation], Eq(2000u));
+}
+
+TEST_F(HWCFrameTimingTestCases, EveryRetireIsResolvedOffTheComposer) {
+  // Frame n retires a vsync after validate, up to 200 us off the vsync grid.
+  auto retire_ns = [](uint64_t frame) {
+    return int64_t(frame + 1) * kPeriodNs + int64_t(frame % 3) * 100000;
+  };
+  const uint64_t kFrames = 2 * HWCFrameTimingRing::kResolveInterval;
+  std::vector<int> fds;
+  for (uint64_t frame = 1; frame <= kFrames; frame++) {
+    FrameTimingRecord record = MakeRecord(frame);
+    record.validate_start_ns = int64_t(frame) * kPeriodNs;
+    record.validate_end_ns = record.validate_start_ns + kMsNs;
+    int fd = -1;
+    ring_->Push(record, sync_handler.CreateFence(&fd));
+    fds.push_back(fd);
+    // The previous frame retires once this one is committed.
+    if (frame > 1) {
+      sync_handler.Signal(fds[frame - 2], retire_ns(frame - 1));
+    }
+  }
+  WorkerPool::GetInstance()->Drain(sdm::kLaneFrameDump);
+
+  std::vector<std::thread::id> lookups = sync_handler.GetLookups();
+  EXPECT_THAT(lookups, Not(IsEmpty()));
+  EXPECT_THAT(lookups, Each(Ne(std::this_thread::get_id())));
+
+  // The last frame has not retired yet.
+  FrameTimingPercentiles percentiles = GetPercentiles();
+  EXPECT_THAT(percentiles.samples[sdm::kMetricRetireLatency], Eq(kFrames - 1));
+  EXPECT_THAT(percentiles.p50[sdm::kMetricRetireLatency], Eq(16766u));
+  EXPECT_THAT(percentiles.samples[sdm::kMetricVsyncDeviation], Eq(kFrames - 2));
+  EXPECT_THAT(percentiles.p50[sdm::kMetricVsyncDeviation], Eq(100u));
+  EXPECT_THAT(percentiles.p99[sdm::kMetricVsyncDeviation], Eq(200u));
+
+  sync_handler.Signal(fds.back(), retire_ns(kFrames));
+  percentiles = GetPercentiles();
+  EXPECT_THAT(percentiles.samples[sdm::kMetricRetireLatency], Eq(kFrames));
+  EXPECT_THAT(percentiles.samples[sdm::kMetricVsyncDeviation], Eq(kFrames - 1));
+}
+
+// Push runs on the composer thread every frame. Reported, not asserted, it depends on the device.
+TEST_F(HWCFrameTimingTestCases, PushOverhead) {
+  const int kFrames = 100000;
+  int fd = -1;
+  shared_ptr<Fence> fence = sync_handler.CreateFence(&fd);
+  sync_handler.Signal(fd, kPeriodNs);
+  FrameTimingRecord record = MakeRecord(1);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kFrames; i++) {
+    ring_->Push(record, fence);
+  }
+  auto end = std::chrono::steady_clock::now();
+  double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+
+  EXPECT_THAT(GetPercentiles().samples[sdm::kMetricStrategy], Eq(HWCFrameTimingRing::kCapacity));
+  printf("Push: %.0f ns per frame\n", ns / kFrames);
+}
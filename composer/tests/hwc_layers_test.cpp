@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "hwc_layers.h"
+using namespace testing;
+
+namespace {
+
+// The translations as they were before the tables, logging aside.
+bool SwitchColorPrimary(int32_t dataspace, ColorPrimaries *color_primary) {
+  switch (dataspace & HAL_DATASPACE_STANDARD_MASK) {
+    case HAL_DATASPACE_STANDARD_BT709:
+      *color_primary = ColorPrimaries_BT709_5;
+      break;
+    case HAL_DATASPACE_STANDARD_BT601_525:
+    case HAL_DATASPACE_STANDARD_BT601_525_UNADJUSTED:
+      *color_primary = ColorPrimaries_BT601_6_525;
+      break;
+    case HAL_DATASPACE_STANDARD_BT601_625:
+    case HAL_DATASPACE_STANDARD_BT601_625_UNADJUSTED:
+      *color_primary = ColorPrimaries_BT601_6_625;
+      break;
+    case HAL_DATASPACE_STANDARD_DCI_P3:
+      *color_primary = ColorPrimaries_DCIP3;
+      break;
+    case HAL_DATASPACE_STANDARD_BT2020:
+      *color_primary = ColorPrimaries_BT2020;
+      break;
+    default:
+      return false;
+  }
+  return true;
+}
+
+bool SwitchTransfer(int32_t dataspace, GammaTransfer *gamma_transfer) {
+  switch (dataspace & HAL_DATASPACE_TRANSFER_MASK) {
+    case HAL_DATASPACE_TRANSFER_SRGB:
+      *gamma_transfer = Transfer_sRGB;
+      break;
+    case HAL_DATASPACE_TRANSFER_SMPTE_170M:
+      *gamma_transfer = Transfer_SMPTE_170M;
+      break;
+    case HAL_DATASPACE_TRANSFER_ST2084:
+      *gamma_transfer = Transfer_SMPTE_ST2084;
+      break;
+    case HAL_DATASPACE_TRANSFER_HLG:
+      *gamma_transfer = Transfer_HLG;
+      break;
+    case HAL_DATASPACE_TRANSFER_LINEAR:
+      *gamma_transfer = Transfer_Linear;
+      break;
+    case HAL_DATASPACE_TRANSFER_GAMMA2_2:
+      *gamma_transfer = Transfer_Gamma2_2;
+      break;
+    case HAL_DATASPACE_TRANSFER_GAMMA2_8:
+      *gamma_transfer = Transfer_Gamma2_8;
+      break;
+    default:
+      return false;
+  }
+  return true;
+}
+
+bool SwitchRange(int32_t dataspace, ColorRange *color_range) {
+  switch (dataspace & HAL_DATASPACE_RANGE_MASK) {
+    case HAL_DATASPACE_RANGE_FULL:
+      *color_range = Range_Full;
+      break;
+    case HAL_DATASPACE_RANGE_LIMITED:
+      *color_range = Range_Limited;
+      break;
+    case HAL_DATASPACE_RANGE_EXTENDED:
+      *color_range = Range_Extended;
+      return false;
+    default:
+      return false;
+  }
+  return true;
+}
+
+// Kept out of line like GetSDMColorSpace, for the benchmark to compare like with like.
+__attribute__((noinline))
+bool SwitchSDMColorSpace(int32_t dataspace, ColorMetaData *color_metadata) {
+  return SwitchColorPrimary(dataspace, &color_metadata->colorPrimaries) &&
+         SwitchTransfer(dataspace, &color_metadata->transfer) &&
+         SwitchRange(dataspace, &color_metadata->range);
+}
+
+// Something the translations never produce, to tell whether they wrote the output.
+const int32_t kUntouched = 0x5A5A;
+
+ColorMetaData getUntouchedMetaData() {
+  ColorMetaData color_metadata = {};
+  color_metadata.colorPrimaries = static_cast<ColorPrimaries>(kUntouched);
+  color_metadata.transfer = static_cast<GammaTransfer>(kUntouched);
+  color_metadata.range = static_cast<ColorRange>(kUntouched);
+  return color_metadata;
+}
+
+// Dataspaces clients set, each field taking the values the translations know.
+std::vector<int32_t> getKnownDataspaces() {
+  const int32_t standards[] = {
+    HAL_DATASPACE_STANDARD_BT709, HAL_DATASPACE_STANDARD_BT601_625,
+    HAL_DATASPACE_STANDARD_BT601_525, HAL_DATASPACE_STANDARD_BT2020,
+    HAL_DATASPACE_STANDARD_DCI_P3,
+  };
+  const int32_t transfers[] = {
+    HAL_DATASPACE_TRANSFER_SRGB, HAL_DATASPACE_TRANSFER_SMPTE_170M,
+    HAL_DATASPACE_TRANSFER_ST2084, HAL_DATASPACE_TRANSFER_HLG, HAL_DATASPACE_TRANSFER_LINEAR,
+  };
+  const int32_t ranges[] = {HAL_DATASPACE_RANGE_FULL, HAL_DATASPACE_RANGE_LIMITED};
+
+  std::vector<int32_t> dataspaces;
+  for (int32_t standard : standards) {
+    for (int32_t transfer : transfers) {
+      for (int32_t range : ranges) {
+        dataspaces.push_back(standard | transfer | range);
+      }
+    }
+  }
+  return dataspaces;
+}
+
+}  // namespace
+
+TEST(HWCLayersTestCases, StandardMatchesSwitch) {
+  const uint32_t count = (HAL_DATASPACE_STANDARD_MASK >> HAL_DATASPACE_STANDARD_SHIFT) + 1;
+  for (uint32_t i = 0; i < count; i++) {
+    int32_t dataspace = static_cast<int32_t>(i << HAL_DATASPACE_STANDARD_SHIFT) |
+                        HAL_DATASPACE_TRANSFER_SRGB | HAL_DATASPACE_RANGE_FULL;
+    ColorPrimaries expected = static_cast<ColorPrimaries>(kUntouched);
+    ColorPrimaries primaries = static_cast<ColorPrimaries>(kUntouched);
+    bool expected_supported = SwitchColorPrimary(dataspace, &expected);
+    EXPECT_THAT(sdm::GetColorPrimary(dataspace, &primaries), Eq(expected_supported))
+        << "standard " << i;
+    EXPECT_THAT(primaries, Eq(expected)) << "standard " << i;
+  }
+}
+
+TEST(HWCLayersTestCases, TransferMatchesSwitch) {
+  const uint32_t count = (HAL_DATASPACE_TRANSFER_MASK >> HAL_DATASPACE_TRANSFER_SHIFT) + 1;
+  for (uint32_t i = 0; i < count; i++) {
+    int32_t dataspace = static_cast<int32_t>(i << HAL_DATASPACE_TRANSFER_SHIFT) |
+                        HAL_DATASPACE_STANDARD_BT709 | HAL_DATASPACE_RANGE_FULL;
+    GammaTransfer expected = static_cast<GammaTransfer>(kUntouched);
+    GammaTransfer transfer = static_cast<GammaTransfer>(kUntouched);
+    bool expected_supported = SwitchTransfer(dataspace, &expected);
+    EXPECT_THAT(sdm::GetTransfer(dataspace, &transfer), Eq(expected_supported))
+        << "transfer " << i;
+    EXPECT_THAT(transfer, Eq(expected)) << "transfer " << i;
+  }
+}
+
+TEST(HWCLayersTestCases, RangeMatchesSwitch) {
+  const uint32_t count = (HAL_DATASPACE_RANGE_MASK >> HAL_DATASPACE_RANGE_SHIFT) + 1;
+  for (uint32_t i = 0; i < count; i++) {
+    int32_t dataspace = static_cast<int32_t>(i << HAL_DATASPACE_RANGE_SHIFT) |
+                        HAL_DATASPACE_STANDARD_BT709 | HAL_DATASPACE_TRANSFER_SRGB;
+    ColorRange expected = static_cast<ColorRange>(kUntouched);
+    ColorRange range = static_cast<ColorRange>(kUntouched);
+    bool expected_supported = SwitchRange(dataspace, &expected);
+    EXPECT_THAT(sdm::GetRange(dataspace, &range), Eq(expected_supported)) << "range " << i;
+    EXPECT_THAT(range, Eq(expected)) << "range " << i;
+  }
+
+  // Extended range is written out, but not supported.
+  ColorRange range = static_cast<ColorRange>(kUntouched);
+  EXPECT_THAT(sdm::GetRange(HAL_DATASPACE_RANGE_EXTENDED, &range), Eq(false));
+  EXPECT_THAT(range, Eq(Range_Extended));
+}
+
+// Every combination of the three fields, legacy dataspaces included once translated.
+TEST(HWCLayersTestCases, ColorSpaceMatchesSwitch) {
+  const uint32_t standards = (HAL_DATASPACE_STANDARD_MASK >> HAL_DATASPACE_STANDARD_SHIFT) + 1;
+  const uint32_t transfers = (HAL_DATASPACE_TRANSFER_MASK >> HAL_DATASPACE_TRANSFER_SHIFT) + 1;
+  const uint32_t ranges = (HAL_DATASPACE_RANGE_MASK >> HAL_DATASPACE_RANGE_SHIFT) + 1;
+  std::vector<int32_t> dataspaces;
+  for (uint32_t s = 0; s < standards; s++) {
+    for (uint32_t t = 0; t < transfers; t++) {
+      for (uint32_t r = 0; r < ranges; r++) {
+        dataspaces.push_back(static_cast<int32_t>((s << HAL_DATASPACE_STANDARD_SHIFT) |
+                                                  (t << HAL_DATASPACE_TRANSFER_SHIFT) |
+                                                  (r << HAL_DATASPACE_RANGE_SHIFT)));
+      }
+    }
+  }
+  const int32_t legacy[] = {
+    HAL_DATASPACE_UNKNOWN, HAL_DATASPACE_SRGB, HAL_DATASPACE_JFIF, HAL_DATASPACE_SRGB_LINEAR,
+    HAL_DATASPACE_BT601_625, HAL_DATASPACE_BT601_525, HAL_DATASPACE_BT709,
+  };
+  for (int32_t dataspace : legacy) {
+    dataspaces.push_back(sdm::TranslateFromLegacyDataspace(dataspace));
+  }
+
+  uint32_t supported = 0;
+  for (int32_t dataspace : dataspaces) {
+    ColorMetaData expected = getUntouchedMetaData();
+    ColorMetaData color_metadata = getUntouchedMetaData();
+    bool expected_valid = SwitchSDMColorSpace(dataspace, &expected);
+    ASSERT_THAT(sdm::GetSDMColorSpace(dataspace, &color_metadata), Eq(expected_valid))
+        << "dataspace 0x" << std::hex << dataspace;
+    EXPECT_THAT(color_metadata.colorPrimaries, Eq(expected.colorPrimaries));
+    EXPECT_THAT(color_metadata.transfer, Eq(expected.transfer));
+    EXPECT_THAT(color_metadata.range, Eq(expected.range));
+    supported += expected_valid;
+  }
+  // 7 standards, 7 transfers and 2 ranges are supported, and all legacy dataspaces.
+  EXPECT_THAT(supported, Eq(7U * 7 * 2 + 7));
+}
+
+TEST(HWCLayersTestCases, Benchmark) {
+  // The dataspaces of a 32 layer stack, over 2000 frames. Best of 5 runs, the rest being noise.
+  const int kLayers = 32;
+  const int kFrames = 2000;
+  const int kRuns = 5;
+  std::vector<int32_t> known = getKnownDataspaces();
+  std::mt19937 random(47);
+  std::vector<int32_t> dataspaces;
+  for (int i = 0; i < kLayers; i++) {
+    dataspaces.push_back(known[random() % known.size()]);
+  }
+
+  auto measure = [&](bool (*translate)(const int32_t &, ColorMetaData *)) {
+    // Color metadata carries the HDR payloads as well, clearing it would cost more than the
+    // translation.
+    ColorMetaData color_metadata = {};
+    uint32_t checksum = 0;
+    double best_ns = 0;
+    for (int run = 0; run < kRuns; run++) {
+      auto start = std::chrono::steady_clock::now();
+      for (int frame = 0; frame < kFrames; frame++) {
+        for (int32_t dataspace : dataspaces) {
+          checksum += translate(dataspace, &color_metadata);
+          checksum += color_metadata.colorPrimaries + color_metadata.transfer +
+                      color_metadata.range;
+        }
+      }
+      std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+      double ns = elapsed.count() / (kFrames * kLayers);
+      best_ns = run ? std::min(best_ns, ns) : ns;
+    }
+    EXPECT_THAT(checksum, Ne(0U));
+    return best_ns;
+  };
+
+  double switch_ns = measure([](const int32_t &dataspace, ColorMetaData *color_metadata) {
+    return SwitchSDMColorSpace(dataspace, color_metadata);
+  });
+  double table_ns = measure(sdm::GetSDMColorSpace);
+  printf("Dataspace translation: switch %.1f ns, table %.1f ns\n", switch_ns, table_ns);
+  EXPECT_THAT(table_ns, Lt(switch_ns * 1.5));
+}
@@ -0,0 +1,538 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <stdio.h>
+#include <utils/constants.h>
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "hwc_test_pattern.h"
+using namespace testing;
+using sdm::HWCTestPattern;
+using sdm::LayerBufferFormat;
+using sdm::kFormatRGB565;
+using sdm::kFormatRGB888;
+using sdm::kFormatRGBA1010102;
+using sdm::kFormatRGBA8888;
+
+namespace {
+
+using Crc = HWCTestPattern::Crc;
+
+const HWCTestPattern::ColorPatternType kPatterns[] = {
+  HWCTestPattern::kPatternColorRamp,
+  HWCTestPattern::kPatternBWVertical,
+  HWCTestPattern::kPatternColorSquare,
+};
+
+const uint32_t kBpps[] = {
+  HWCTestPattern::kDisplayBpp18,
+  HWCTestPattern::kDisplayBpp24,
+  HWCTestPattern::kDisplayBpp30,
+};
+
+// The patterns as HWCDisplayPluggableTest generated them before HWCTestPattern: every pixel is
+// packed on its own and takes the CRCs a step through the bitset equations of the DP CTS CRC16.
+class BitsetPattern {
+ public:
+  BitsetPattern(LayerBufferFormat format, uint32_t width, uint32_t height, uint32_t aligned_width,
+                uint32_t panel_bpp)
+    : format_(format), width_(width), height_(height), aligned_width_(aligned_width),
+      panel_bpp_(panel_bpp) {}
+
+  void Generate(uint32_t pattern_type, uint8_t *buffer, Crc *crc) {
+    switch (pattern_type) {
+      case HWCTestPattern::kPatternColorRamp:
+        GenerateColorRamp(buffer, crc);
+        break;
+      case HWCTestPattern::kPatternBWVertical:
+        GenerateBWVertical(buffer, crc);
+        break;
+      case HWCTestPattern::kPatternColorSquare:
+        GenerateColorSquare(buffer, crc);
+        break;
+    }
+  }
+
+  void CalcCRC(uint32_t color_val, std::bitset<16> *crc_data);
+
+ private:
+  enum { kDisplayBpp18 = 18, kDisplayBpp24 = 24, kDisplayBpp30 = 30 };
+  enum { kColorRedRamp, kColorGreenRamp, kColorBlueRamp, kColorWhiteRamp };
+  enum { kColorBlack, kColorWhite };
+
+  void PixelCopy(uint32_t red, uint32_t green, uint32_t blue, uint32_t alpha, uint8_t **buffer);
+  void GenerateColorRamp(uint8_t *buffer, Crc *crc);
+  void GenerateBWVertical(uint8_t *buffer, Crc *crc);
+  void GenerateColorSquare(uint8_t *buffer, Crc *crc);
+
+  LayerBufferFormat format_;
+  uint32_t width_;
+  uint32_t height_;
+  uint32_t aligned_width_;
+  uint32_t panel_bpp_;
+};
+
+void BitsetPattern::CalcCRC(uint32_t color_val, std::bitset<16> *crc_data) {
+  std::bitset<16> color = {};
+  std::bitset<16> temp_crc = {};
+
+  switch (panel_bpp_) {
+    case kDisplayBpp18:
+      color = (color_val & 0xFC) << 8;
+      break;
+    case kDisplayBpp24:
+      color = color_val << 8;
+      break;
+    case kDisplayBpp30:
+      color = color_val << 6;
+      break;
+    default:
+      return;
+  }
+
+  temp_crc[15] = (*crc_data)[0] ^ (*crc_data)[1] ^ (*crc_data)[2] ^ (*crc_data)[3] ^
+                 (*crc_data)[4] ^ (*crc_data)[5] ^ (*crc_data)[6] ^ (*crc_data)[7] ^
+                 (*crc_data)[8] ^ (*crc_data)[9] ^ (*crc_data)[10] ^ (*crc_data)[11] ^
+                 (*crc_data)[12] ^ (*crc_data)[14] ^ (*crc_data)[15] ^ color[0] ^ color[1] ^
+                 color[2] ^ color[3] ^ color[4] ^ color[5] ^ color[6] ^ color[7] ^ color[8] ^
+                 color[9] ^ color[10] ^ color[11] ^ color[12] ^ color[14] ^ color[15];
+
+  temp_crc[14] = (*crc_data)[12] ^ (*crc_data)[13] ^ color[12] ^ color[13];
+  temp_crc[13] = (*crc_data)[11] ^ (*crc_data)[12] ^ color[11] ^ color[12];
+  temp_crc[12] = (*crc_data)[10] ^ (*crc_data)[11] ^ color[10] ^ color[11];
+  temp_crc[11] = (*crc_data)[9] ^ (*crc_data)[10] ^ color[9] ^ color[10];
+  temp_crc[10] = (*crc_data)[8] ^ (*crc_data)[9] ^ color[8] ^ color[9];
+  temp_crc[9] = (*crc_data)[7] ^ (*crc_data)[8] ^ color[7] ^ color[8];
+  temp_crc[8] = (*crc_data)[6] ^ (*crc_data)[7] ^ color[6] ^ color[7];
+  temp_crc[7] = (*crc_data)[5] ^ (*crc_data)[6] ^ color[5] ^ color[6];
+  temp_crc[6] = (*crc_data)[4] ^ (*crc_data)[5] ^ color[4] ^ color[5];
+  temp_crc[5] = (*crc_data)[3] ^ (*crc_data)[4] ^ color[3] ^ color[4];
+  temp_crc[4] = (*crc_data)[2] ^ (*crc_data)[3] ^ color[2] ^ color[3];
+  temp_crc[3] = (*crc_data)[1] ^ (*crc_data)[2] ^ (*crc_data)[15] ^ color[1] ^ color[2] ^ color[15];
+  temp_crc[2] = (*crc_data)[0] ^ (*crc_data)[1] ^ (*crc_data)[14] ^ color[0] ^ color[1] ^ color[14];
+
+  temp_crc[1] = (*crc_data)[1] ^ (*crc_data)[2] ^ (*crc_data)[3] ^ (*crc_data)[4] ^ (*crc_data)[5] ^
+                (*crc_data)[6] ^ (*crc_data)[7] ^ (*crc_data)[8] ^ (*crc_data)[9] ^
+                (*crc_data)[10] ^ (*crc_data)[11] ^ (*crc_data)[12] ^ (*crc_data)[13] ^
+                (*crc_data)[14] ^ color[1] ^ color[2] ^ color[3] ^ color[4] ^ color[5] ^ color[6] ^
+                color[7] ^ color[8] ^ color[9] ^ color[10] ^ color[11] ^ color[12] ^ color[13] ^
+                color[14];
+
+  temp_crc[0] = (*crc_data)[0] ^ (*crc_data)[1] ^ (*crc_data)[2] ^ (*crc_data)[3] ^ (*crc_data)[4] ^
+                (*crc_data)[5] ^ (*crc_data)[6] ^ (*crc_data)[7] ^ (*crc_data)[8] ^ (*crc_data)[9] ^
+                (*crc_data)[10] ^ (*crc_data)[11] ^ (*crc_data)[12] ^ (*crc_data)[13] ^
+                (*crc_data)[15] ^ color[0] ^ color[1] ^ color[2] ^ color[3] ^ color[4] ^ color[5] ^
+                color[6] ^ color[7] ^ color[8] ^ color[9] ^ color[10] ^ color[11] ^ color[12] ^
+                color[13] ^ color[15];
+
+  (*crc_data) = temp_crc;
+}
+
+void BitsetPattern::PixelCopy(uint32_t red, uint32_t green, uint32_t blue, uint32_t alpha,
+                              uint8_t **buffer) {
+  switch (format_) {
+    case kFormatRGBA8888:
+      *(*buffer)++ = UINT8(red & 0xFF);
+      *(*buffer)++ = UINT8(green & 0xFF);
+      *(*buffer)++ = UINT8(blue & 0xFF);
+      *(*buffer)++ = UINT8(alpha & 0xFF);
+      break;
+    case kFormatRGB888:
+      *(*buffer)++ = UINT8(red & 0xFF);
+      *(*buffer)++ = UINT8(green & 0xFF);
+      *(*buffer)++ = UINT8(blue & 0xFF);
+      break;
+    case kFormatRGBA1010102:
+      // Lower 8 bits of red
+      *(*buffer)++ = UINT8(red & 0xFF);
+
+      // Upper 2 bits of Red + Lower 6 bits of green
+      *(*buffer)++ = UINT8(((green & 0x3F) << 2) | ((red >> 0x8) & 0x3));
+
+      // Upper 4 bits of green + Lower 4 bits of blue
+      *(*buffer)++ = UINT8(((blue & 0xF) << 4) | ((green >> 6) & 0xF));
+
+      // Upper 6 bits of blue + Lower 2 bits of alpha
+      *(*buffer)++ = UINT8(((alpha & 0x3) << 6) | ((blue >> 4) & 0x3F));
+      break;
+    default:
+      break;
+  }
+}
+
+void BitsetPattern::GenerateColorRamp(uint8_t *buffer, Crc *crc) {
+  uint32_t width = width_;
+  uint32_t height = height_;
+  LayerBufferFormat format = format_;
+  uint32_t aligned_width = aligned_width_;
+  uint32_t buffer_stride = 0;
+
+  uint32_t color_ramp = 0;
+  uint32_t start_color_val = 0;
+  uint32_t step_size = 1;
+  uint32_t ramp_width = 0;
+  uint32_t ramp_height = 0;
+  uint32_t shift_by = 0;
+
+  std::bitset<16> crc_red = {};
+  std::bitset<16> crc_green = {};
+  std::bitset<16> crc_blue = {};
+
+  switch (panel_bpp_) {
+    case kDisplayBpp18:
+      ramp_height = 64;
+      ramp_width = 64;
+      shift_by = 2;
+      break;
+    case kDisplayBpp24:
+      ramp_height = 64;
+      ramp_width = 256;
+      break;
+    case kDisplayBpp30:
+      ramp_height = 32;
+      ramp_width = 256;
+      start_color_val = 0x180;
+      break;
+    default:
+      return;
+  }
+
+  HWCTestPattern::GetStride(format, aligned_width, &buffer_stride);
+
+  for (uint32_t loop_height = 0; loop_height < height; loop_height++) {
+    uint32_t color_value = start_color_val;
+    uint8_t *temp = buffer + (loop_height * buffer_stride);
+
+    for (uint32_t loop_width = 0; loop_width < width; loop_width++) {
+      if (color_ramp == kColorRedRamp) {
+        PixelCopy(color_value, 0, 0, 0, &temp);
+        CalcCRC(color_value, &crc_red);
+        CalcCRC(0, &crc_green);
+        CalcCRC(0, &crc_blue);
+      }
+      if (color_ramp == kColorGreenRamp) {
+        PixelCopy(0, color_value, 0, 0, &temp);
+        CalcCRC(0, &crc_red);
+        CalcCRC(color_value, &crc_green);
+        CalcCRC(0, &crc_blue);
+      }
+      if (color_ramp == kColorBlueRamp) {
+        PixelCopy(0, 0, color_value, 0, &temp);
+        CalcCRC(0, &crc_red);
+        CalcCRC(0, &crc_green);
+        CalcCRC(color_value, &crc_blue);
+      }
+      if (color_ramp == kColorWhiteRamp) {
+        PixelCopy(color_value, color_value, color_value, 0, &temp);
+        CalcCRC(color_value, &crc_red);
+        CalcCRC(color_value, &crc_green);
+        CalcCRC(color_value, &crc_blue);
+      }
+
+      color_value = (start_color_val + (((loop_width + 1) % ramp_width) * step_size)) << shift_by;
+    }
+
+    if (panel_bpp_ == kDisplayBpp30 && ((loop_height + 1) % ramp_height) == 0) {
+      if (start_color_val == 0x180) {
+        start_color_val = 0;
+        step_size = 4;
+      } else {
+        start_color_val = 0x180;
+        step_size = 1;
+        color_ramp = (color_ramp + 1) % 4;
+      }
+      continue;
+    }
+
+    if (((loop_height + 1) % ramp_height) == 0) {
+      color_ramp = (color_ramp + 1) % 4;
+    }
+  }
+
+  crc->red = UINT16(crc_red.to_ulong());
+  crc->green = UINT16(crc_green.to_ulong());
+  crc->blue = UINT16(crc_blue.to_ulong());
+}
+
+void BitsetPattern::GenerateBWVertical(uint8_t *buffer, Crc *crc) {
+  uint32_t width = width_;
+  uint32_t height = height_;
+  LayerBufferFormat format = format_;
+  uint32_t aligned_width = aligned_width_;
+  uint32_t buffer_stride = 0;
+  uint32_t bits_per_component = panel_bpp_ / 3;
+  uint32_t max_color_val = (1 << bits_per_component) - 1;
+
+  std::bitset<16> crc_red = {};
+  std::bitset<16> crc_green = {};
+  std::bitset<16> crc_blue = {};
+
+  if (panel_bpp_ == kDisplayBpp18) {
+    max_color_val <<= 2;
+  }
+
+  HWCTestPattern::GetStride(format, aligned_width, &buffer_stride);
+
+  for (uint32_t loop_height = 0; loop_height < height; loop_height++) {
+    uint32_t color = 0;
+    uint8_t *temp = buffer + (loop_height * buffer_stride);
+
+    for (uint32_t loop_width = 0; loop_width < width; loop_width++) {
+      if (color == kColorBlack) {
+        PixelCopy(0, 0, 0, 0, &temp);
+        CalcCRC(0, &crc_red);
+        CalcCRC(0, &crc_green);
+        CalcCRC(0, &crc_blue);
+      }
+      if (color == kColorWhite) {
+        PixelCopy(max_color_val, max_color_val, max_color_val, 0, &temp);
+        CalcCRC(max_color_val, &crc_red);
+        CalcCRC(max_color_val, &crc_green);
+        CalcCRC(max_color_val, &crc_blue);
+      }
+
+      color = (color + 1) % 2;
+    }
+  }
+
+  crc->red = UINT16(crc_red.to_ulong());
+  crc->green = UINT16(crc_green.to_ulong());
+  crc->blue = UINT16(crc_blue.to_ulong());
+}
+
+void BitsetPattern::GenerateColorSquare(uint8_t *buffer, Crc *crc) {
+  uint32_t width = width_;
+  uint32_t height = height_;
+  LayerBufferFormat format = format_;
+  uint32_t aligned_width = aligned_width_;
+  uint32_t buffer_stride = 0;
+  uint32_t max_color_val = 0;
+  uint32_t min_color_val = 0;
+
+  std::bitset<16> crc_red = {};
+  std::bitset<16> crc_green = {};
+  std::bitset<16> crc_blue = {};
+
+  switch (panel_bpp_) {
+    case kDisplayBpp18:
+      max_color_val = 63 << 2;  // CEA Dynamic range for 18bpp 0 - 63
+      min_color_val = 0;
+      break;
+    case kDisplayBpp24:
+      max_color_val = 235;  // CEA Dynamic range for 24bpp 16 - 235
+      min_color_val = 16;
+      break;
+    case kDisplayBpp30:
+      max_color_val = 940;  // CEA Dynamic range for 30bpp 64 - 940
+      min_color_val = 64;
+      break;
+    default:
+      return;
+  }
+
+  std::array<std::array<uint32_t, 3>, 8> colors = {{
+    {{max_color_val, max_color_val, max_color_val}},  // White Color
+    {{max_color_val, max_color_val, min_color_val}},  // Yellow Color
+    {{min_color_val, max_color_val, max_color_val}},  // Cyan Color
+    {{min_color_val, max_color_val, min_color_val}},  // Green Color
+    {{max_color_val, min_color_val, max_color_val}},  // Megenta Color
+    {{max_color_val, min_color_val, min_color_val}},  // Red Color
+    {{min_color_val, min_color_val, max_color_val}},  // Blue Color
+    {{min_color_val, min_color_val, min_color_val}},  // Black Color
+  }};
+
+  HWCTestPattern::GetStride(format, aligned_width, &buffer_stride);
+
+  for (uint32_t loop_height = 0; loop_height < height; loop_height++) {
+    uint32_t color = 0;
+    uint8_t *temp = buffer + (loop_height * buffer_stride);
+
+    for (uint32_t loop_width = 0; loop_width < width; loop_width++) {
+      PixelCopy(colors[color][0], colors[color][1], colors[color][2], 0, &temp);
+      CalcCRC(colors[color][0], &crc_red);
+      CalcCRC(colors[color][1], &crc_green);
+      CalcCRC(colors[color][2], &crc_blue);
+
+      if (((loop_width + 1) % 64) == 0) {
+        color = (color + 1) % colors.size();
+      }
+    }
+
+    if (((loop_height + 1) % 64) == 0) {
+      std::reverse(colors.begin(), (colors.end() - 1));
+    }
+  }
+
+  crc->red = UINT16(crc_red.to_ulong());
+  crc->green = UINT16(crc_green.to_ulong());
+  crc->blue = UINT16(crc_blue.to_ulong());
+}
+
+LayerBufferFormat GetFormat(uint32_t panel_bpp) {
+  return (panel_bpp == HWCTestPattern::kDisplayBpp30) ? kFormatRGBA1010102 : kFormatRGB888;
+}
+
+std::vector<uint8_t> AllocBuffer(LayerBufferFormat format, uint32_t aligned_width,
+                                 uint32_t height) {
+  uint32_t stride = 0;
+  HWCTestPattern::GetStride(format, aligned_width, &stride);
+  return std::vector<uint8_t>(size_t(stride) * height, 0);
+}
+
+// Generates pattern_type with HWCTestPattern and the bitset reference and expects both to write
+// the same buffer and report the same CRCs.
+void ExpectMatchesReference(LayerBufferFormat format, uint32_t width, uint32_t height,
+                            uint32_t aligned_width, uint32_t panel_bpp, uint32_t pattern_type) {
+  SCOPED_TRACE(testing::Message() << "format " << format << " " << width << "x" << height
+               << " aligned " << aligned_width << " bpp " << panel_bpp << " pattern "
+               << pattern_type);
+  std::vector<uint8_t> buffer = AllocBuffer(format, aligned_width, height);
+  std::vector<uint8_t> reference_buffer = buffer;
+
+  HWCTestPattern pattern(format, width, height, aligned_width, panel_bpp);
+  Crc crc;
+  ASSERT_THAT(pattern.Generate(pattern_type, buffer.data(), &crc), Eq(0));
+  BitsetPattern reference(format, width, height, aligned_width, panel_bpp);
+  Crc reference_crc;
+  reference.Generate(pattern_type, reference_buffer.data(), &reference_crc);
+
+  EXPECT_THAT(crc.red, Eq(reference_crc.red));
+  EXPECT_THAT(crc.green, Eq(reference_crc.green));
+  EXPECT_THAT(crc.blue, Eq(reference_crc.blue));
+  EXPECT_TRUE(buffer == reference_buffer);
+}
+
+template <class Generate>
+double GetMs(Generate generate) {
+  auto start = std::chrono::steady_clock::now();
+  generate();
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+}  // namespace
+
+TEST(HWCTestPatternTestCases, CrcStepMatchesBitsetEquations) {
+  BitsetPattern reference(kFormatRGB888, 0, 0, 0, HWCTestPattern::kDisplayBpp24);
+  const uint32_t colors[] = {0x00, 0x01, 0x10, 0x80, 0xA5, 0xEB, 0xFF};
+  for (uint32_t state = 0; state <= 0xFFFF; state++) {
+    for (uint32_t color : colors) {
+      std::bitset<16> expected(state);
+      reference.CalcCRC(color, &expected);
+      uint16_t crc = UINT16(state);
+      HWCTestPattern::CalcCRC(HWCTestPattern::kDisplayBpp24, color, &crc);
+      ASSERT_THAT(crc, Eq(expected.to_ulong())) << "state " << state << " color " << color;
+    }
+  }
+}
+
+TEST(HWCTestPatternTestCases, CrcStepScalesColorToPanelBpp) {
+  for (uint32_t panel_bpp : kBpps) {
+    BitsetPattern reference(kFormatRGB888, 0, 0, 0, panel_bpp);
+    for (uint32_t color = 0; color < 1024; color++) {
+      std::bitset<16> expected(0x1D0F);
+      reference.CalcCRC(color, &expected);
+      uint16_t crc = 0x1D0F;
+      HWCTestPattern::CalcCRC(panel_bpp, color, &crc);
+      ASSERT_THAT(crc, Eq(expected.to_ulong())) << "bpp " << panel_bpp << " color " << color;
+    }
+  }
+}
+
+TEST(HWCTestPatternTestCases, PatternsMatchReference) {
+  struct Size {
+    uint32_t width;
+    uint32_t height;
+    uint32_t aligned_width;
+  };
+  // Sizes that end inside a ramp or a square, and rows with padding after them.
+  const Size sizes[] = {{1, 1, 1}, {64, 64, 64}, {100, 70, 128}, {333, 130, 384},
+                        {640, 480, 640}};
+  for (uint32_t panel_bpp : kBpps) {
+    for (uint32_t pattern_type : kPatterns) {
+      for (const Size &size : sizes) {
+        ExpectMatchesReference(GetFormat(panel_bpp), size.width, size.height, size.aligned_width,
+                               panel_bpp, pattern_type);
+      }
+      ExpectMatchesReference(kFormatRGBA8888, 333, 130, 384, panel_bpp, pattern_type);
+    }
+  }
+}
+
+TEST(HWCTestPatternTestCases, UnsupportedInputs) {
+  HWCTestPattern pattern(kFormatRGB888, 64, 64, 64, HWCTestPattern::kDisplayBpp24);
+  std::vector<uint8_t> buffer = AllocBuffer(kFormatRGB888, 64, 64);
+  Crc crc;
+  EXPECT_THAT(pattern.Generate(HWCTestPattern::kPatternNone, buffer.data(), &crc), Eq(-EINVAL));
+
+  uint32_t stride = 0;
+  EXPECT_THAT(HWCTestPattern::GetStride(kFormatRGB565, 64, &stride), Eq(-EINVAL));
+  EXPECT_THAT(HWCTestPattern::GetStride(kFormatRGB888, 64, &stride), Eq(0));
+  EXPECT_THAT(stride, Eq(192u));
+}
+
+// CRCs of the 1920x1080 patterns as the bitset implementation reported them.
+TEST(HWCTestPatternTestCases, GoldenCrc1080p) {
+  struct Golden {
+    uint32_t panel_bpp;
+    uint32_t pattern_type;
+    Crc crc;
+  };
+  const Golden goldens[] = {
+    {HWCTestPattern::kDisplayBpp18, HWCTestPattern::kPatternColorRamp, {0x2C43, 0xE7CA, 0x3E7C}},
+    {HWCTestPattern::kDisplayBpp18, HWCTestPattern::kPatternBWVertical, {0x0F4E, 0x0F4E, 0x0F4E}},
+    {HWCTestPattern::kDisplayBpp18, HWCTestPattern::kPatternColorSquare, {0x8E88, 0x904E, 0x6056}},
+    {HWCTestPattern::kDisplayBpp24, HWCTestPattern::kPatternColorRamp, {0x1F83, 0xFCEB, 0x47CF}},
+    {HWCTestPattern::kDisplayBpp24, HWCTestPattern::kPatternBWVertical, {0x5B2C, 0x5B2C, 0x5B2C}},
+    {HWCTestPattern::kDisplayBpp24, HWCTestPattern::kPatternColorSquare, {0xE098, 0x886F, 0xA475}},
+    {HWCTestPattern::kDisplayBpp30, HWCTestPattern::kPatternColorRamp, {0x3E9E, 0x47CF, 0x2C7C}},
+    {HWCTestPattern::kDisplayBpp30, HWCTestPattern::kPatternBWVertical, {0x8E36, 0x8E36, 0x8E36}},
+    {HWCTestPattern::kDisplayBpp30, HWCTestPattern::kPatternColorSquare, {0xE098, 0x886F, 0xA475}},
+  };
+
+  for (const Golden &golden : goldens) {
+    LayerBufferFormat format = GetFormat(golden.panel_bpp);
+    std::vector<uint8_t> buffer = AllocBuffer(format, 1920, 1080);
+    HWCTestPattern pattern(format, 1920, 1080, 1920, golden.panel_bpp);
+    Crc crc;
+    ASSERT_THAT(pattern.Generate(golden.pattern_type, buffer.data(), &crc), Eq(0));
+    SCOPED_TRACE(testing::Message() << "bpp " << golden.panel_bpp << " pattern "
+                 << golden.pattern_type);
+    EXPECT_THAT(crc.red, Eq(golden.crc.red));
+    EXPECT_THAT(crc.green, Eq(golden.crc.green));
+    EXPECT_THAT(crc.blue, Eq(golden.crc.blue));
+  }
+}
+
+// Time to generate the 1080p patterns against the bitset reference, and at 4K.
+TEST(HWCTestPatternTestCases, Benchmark) {
+  const uint32_t panel_bpp = HWCTestPattern::kDisplayBpp30;
+  LayerBufferFormat format = GetFormat(panel_bpp);
+  std::vector<uint8_t> buffer = AllocBuffer(format, 3840, 2160);
+  Crc crc;
+
+  for (uint32_t pattern_type : kPatterns) {
+    HWCTestPattern pattern(format, 1920, 1080, 1920, panel_bpp);
+    BitsetPattern reference(format, 1920, 1080, 1920, panel_bpp);
+    double pattern_ms = GetMs([&] { pattern.Generate(pattern_type, buffer.data(), &crc); });
+    double reference_ms = GetMs([&] { reference.Generate(pattern_type, buffer.data(), &crc); });
+
+    HWCTestPattern pattern_4k(format, 3840, 2160, 3840, panel_bpp);
+    double pattern_4k_ms = GetMs([&] {
+      pattern_4k.Generate(pattern_type, buffer.data(), &crc);
+    });
+
+    printf("pattern %u: 1080p %.2f ms, bitset %.2f ms (%.0fx), 4K %.2f ms\n", pattern_type,
+           pattern_ms, reference_ms, reference_ms / pattern_ms, pattern_4k_ms);
+    EXPECT_THAT(reference_ms, Gt(10 * pattern_ms));
+  }
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __DISPLAY_CONFIG_BATCH_H__
+#define __DISPLAY_CONFIG_BATCH_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <config/client_interface.h>
+#include <vector>
+
+namespace DisplayConfig {
+
+// Queues DisplayConfig calls and sends them to the service in a single perform() call. Calls run
+// in the order they were queued, a failing call does not stop the ones after it. Outputs and
+// per call errors are written when Execute() returns, the pointers must stay valid until then.
+//
+//   ClientBatch batch(intf);
+//   batch.GetActiveConfig(DisplayType::kPrimary, &config, &config_error);
+//   batch.GetPanelBrightness(&level, &level_error);
+//   int error = batch.Execute();
+class ClientBatch {
+ public:
+  // intf must be created through ClientInterface::Create.
+  explicit ClientBatch(ClientInterface *intf) : intf_(intf) {}
+
+  void IsDisplayConnected(DisplayType dpy, bool *connected, int *error = nullptr);
+  void GetConfigCount(DisplayType dpy, uint32_t *count, int *error = nullptr);
+  void GetActiveConfig(DisplayType dpy, uint32_t *config, int *error = nullptr);
+  void SetActiveConfig(DisplayType dpy, uint32_t config, int *error = nullptr);
+  void GetDisplayAttributes(uint32_t config_index, DisplayType dpy, Attributes *attributes,
+                            int *error = nullptr);
+  void SetPanelBrightness(uint32_t level, int *error = nullptr);
+  void GetPanelBrightness(uint32_t *level, int *error = nullptr);
+  void IsHDRSupported(uint32_t disp_id, bool *supported, int *error = nullptr);
+  void IsBuiltInDisplay(uint32_t disp_id, bool *is_builtin, int *error = nullptr);
+  void SetIdleTimeout(uint32_t value, int *error = nullptr);
+
+  // Returns an error only if the batch could not be sent or its reply was malformed, in which
+  // case every queued call reports that error. The queue is cleared either way.
+  int Execute();
+  void Clear();
+  size_t Size() const { return entries_.size(); }
+
+ private:
+  struct Entry {
+    uint32_t op_code = 0;
+    void *output = nullptr;
+    size_t output_size = 0;
+    int *error = nullptr;
+  };
+
+  void Add(uint32_t op_code, const void *input, size_t input_size, void *output,
+           size_t output_size, int *error);
+  void Complete(const Entry &entry, int error, const uint8_t *output, size_t output_size);
+
+  ClientInterface *intf_ = nullptr;
+  std::vector<uint8_t> request_;
+  std::vector<Entry> entries_;
+};
+
+}  // namespace DisplayConfig
+
+#endif  // __DISPLAY_CONFIG_BATCH_H__
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __DISPLAY_CONFIG_CWB_STREAM_H__
+#define __DISPLAY_CONFIG_CWB_STREAM_H__
+
+#include <stdint.h>
+#include <cutils/native_handle.h>
+#include <config/client_interface.h>
+#include <atomic>
+#include <vector>
+
+namespace DisplayConfig {
+
+// Continuous concurrent writeback. The client registers a ring of output buffers once and the
+// composer fills them round-robin on every present of the display, without a request per frame.
+// Buffer k of the stream (counting from 0) is always written to ring index k % num_buffers.
+// Completion is published through a shared page that both sides map; a buffer is only reused
+// after the client released it, presents that find no free buffer are counted as dropped.
+
+static const uint32_t kMaxCwbStreamBuffers = 8;
+static const uint32_t kCwbStreamPageMagic = 0x53425743;  // "CWBS"
+static const uint32_t kCwbStreamPageVersion = 1;
+
+// Layout of the stream buffers. With kCwbStreamNative the buffers take the writeback output as
+// is: full frame, with the captured region in place. The other formats have the composer crop
+// the region, downscale it and convert it on the CPU before the buffer is completed, the result
+// is at the top left of the buffer, which must be linear and at least as large.
+enum CwbStreamFormat : uint32_t {
+  kCwbStreamNative = 0,
+  kCwbStreamRGBA8888 = 1,       // RGBA8888 or RGBX8888 buffers
+  kCwbStreamNV12 = 2,           // NV12 or NV21 buffers, BT.601 limited range
+};
+
+static const uint32_t kMaxCwbStreamDownscale = 4;
+
+struct CwbStreamConfig {
+  DisplayType dpy = DisplayType::kPrimary;
+  Rect rect = {};                 // region to capture, empty for the whole display
+  uint32_t post_processed = 0;    // tap point, as in SetCWBOutputBuffer
+  uint32_t num_buffers = 0;
+  CwbStreamFormat format = kCwbStreamNative;
+  uint32_t downscale = 1;         // 1, 2 or 4, in both directions. Needs a non native format
+};
+
+struct CwbStreamSlot {
+  std::atomic<uint32_t> frame;          // index of the buffer in the stream
+  std::atomic<int32_t> status;          // 0, or the error the writeback failed with
+  std::atomic<int64_t> timestamp_ns;    // CLOCK_MONOTONIC time the writeback completed
+};
+
+struct CwbStreamPage {
+  uint32_t magic = kCwbStreamPageMagic;
+  uint32_t version = kCwbStreamPageVersion;
+  uint32_t size = sizeof(CwbStreamPage);
+  uint32_t num_buffers = 0;
+  std::atomic<uint32_t> filled {0};     // buffers completed by the composer, a futex word
+  std::atomic<uint32_t> released {0};   // buffers handed back by the client
+  std::atomic<uint32_t> dropped {0};    // presents not captured for lack of a free buffer
+  std::atomic<uint32_t> stopped {0};
+  CwbStreamSlot slots[kMaxCwbStreamBuffers] = {};
+};
+
+// Service side. The composer installs a handler that drives the writeback. StartCwbStream gets
+// buffers that are only valid for the duration of the call and a page that stays mapped until
+// StopCwbStream returns, after which neither may be touched.
+class CwbStreamHandler {
+ public:
+  virtual ~CwbStreamHandler() {}
+  virtual int StartCwbStream(const CwbStreamConfig &config,
+                             const std::vector<const native_handle_t *> &buffers,
+                             CwbStreamPage *page, uint32_t *stream_id) = 0;
+  virtual int StopCwbStream(uint32_t stream_id) = 0;
+};
+
+void SetCwbStreamHandler(CwbStreamHandler *handler);
+// Completes buffer frame of the stream and wakes up the client. Buffers must be completed in
+// stream order.
+void PublishCwbStreamFrame(CwbStreamPage *page, uint32_t frame, int32_t status,
+                           int64_t timestamp_ns);
+
+struct CwbStreamFrame {
+  uint32_t index = 0;       // into the buffers passed to Start
+  uint32_t frame = 0;
+  int32_t status = 0;
+  int64_t timestamp_ns = 0;
+};
+
+// Client side.
+class CwbStreamClient {
+ public:
+  ~CwbStreamClient() { Stop(); }
+
+  // intf must be created through ClientInterface::Create.
+  int Start(ClientInterface *intf, const CwbStreamConfig &config,
+            const std::vector<const native_handle_t *> &buffers);
+  void Stop();
+  // Waits up to timeout_ms, or forever if negative, for the next completed buffer. The buffer
+  // belongs to the client until it is released. Returns -ETIMEDOUT or -EPIPE once stopped.
+  int Acquire(int timeout_ms, CwbStreamFrame *frame);
+  // Hands the oldest acquired buffer back to the composer.
+  int Release();
+  uint32_t GetDroppedFrames() const;
+
+ private:
+  ClientInterface *intf_ = nullptr;
+  CwbStreamPage *page_ = nullptr;
+  uint32_t stream_id_ = 0;
+  uint32_t acquired_ = 0;
+};
+
+}  // namespace DisplayConfig
+
+#endif  // __DISPLAY_CONFIG_CWB_STREAM_H__
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __DISPLAY_CONFIG_STATUS_H__
+#define __DISPLAY_CONFIG_STATUS_H__
+
+#include <stdint.h>
+#include <config/client_interface.h>
+#include <utils/seqlock.h>
+
+namespace DisplayConfig {
+
+// Frequently polled display state published by the composer in a shared memory page. Clients map
+// the page once through DisplayStatusReader and read it without an IPC round trip.
+enum DisplayStatusField {
+  kStatusActiveConfig = 1 << 0,
+  kStatusRefreshRate = 1 << 1,
+  kStatusBrightness = 1 << 2,
+  kStatusQsync = 1 << 3,
+  kStatusIdle = 1 << 4,
+};
+
+struct DisplayStatus {
+  uint32_t fields = 0;            // DisplayStatusField mask of the values published so far
+  uint32_t active_config = 0;     // as returned by GetActiveConfig
+  uint32_t refresh_rate = 0;
+  uint32_t brightness_level = 0;  // as returned by GetPanelBrightness, 0 is off
+  uint32_t qsync_refresh_rate = 0;
+  uint8_t qsync_enabled = 0;
+  uint8_t idle = 0;
+};
+
+static const uint32_t kStatusPageMagic = 0x53434644;  // "DFCS"
+static const uint32_t kStatusPageVersion = 1;
+// One slot each for kPrimary, kExternal, kVirtual and kBuiltIn2.
+static const uint32_t kMaxStatusDisplays = 4;
+
+struct DisplayStatusPage {
+  uint32_t magic = kStatusPageMagic;
+  uint32_t version = kStatusPageVersion;
+  uint32_t size = sizeof(DisplayStatusPage);
+  uint32_t reserved = 0;
+  sdm::SeqLock<DisplayStatus> displays[kMaxStatusDisplays];
+};
+
+// Service side, called by the composer whenever one of the values may have changed. Only the
+// fields set in the mask are taken from status, values that did not change are not republished.
+int PublishDisplayStatus(DisplayType dpy, uint32_t fields, const DisplayStatus &status);
+
+// Client side read-only mapping of the status page.
+class DisplayStatusReader {
+ public:
+  ~DisplayStatusReader() { DeInit(); }
+
+  // intf must be created through ClientInterface::Create.
+  int Init(ClientInterface *intf);
+  void DeInit();
+  // Returns -ENODATA until the composer published a value for the display. sequence, when given,
+  // changes on every update of the display.
+  int Read(DisplayType dpy, DisplayStatus *status, uint32_t *sequence = nullptr) const;
+
+ private:
+  const DisplayStatusPage *page_ = nullptr;
+  size_t size_ = 0;
+};
+
+}  // namespace DisplayConfig
+
+#endif  // __DISPLAY_CONFIG_STATUS_H__
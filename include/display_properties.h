@@ -202,6 +202,26 @@
 #define ENABLE_ROTATOR_CONCURRENCY           DISPLAY_PROP("enable_rotator_concurrency")
 #define FORCE_GPU_COMPOSITION                DISPLAY_PROP("force_gpu_composition")
 #define OVERRIDE_DOZE_MODE_PROP              DISPLAY_PROP("override_doze_mode")
+#define DISABLE_HW_INFO_SNAPSHOT_PROP        DISPLAY_PROP("disable_hw_info_snapshot")
+// Frame dump overflow policy, 0: drop newest frame, 1: drop oldest staged frame
+#define FRAME_DUMP_POLICY_PROP               DISPLAY_PROP("frame_dump_policy")
+#define FRAME_DUMP_COMPRESS_PROP             DISPLAY_PROP("frame_dump_compress")
+#define FRAME_DUMP_MAX_FRAMES_PROP           DISPLAY_PROP("frame_dump_max_frames")
+#define FRAME_DUMP_MAX_STAGED_MB_PROP        DISPLAY_PROP("frame_dump_max_staged_mb")
+// Number of client command buffers to record to the dump directory, read on client connect
+#define COMMAND_CAPTURE_FRAMES_PROP          DISPLAY_PROP("command_capture_frames")
+// Priority inheritance on the composer display locks, a blocked real time thread boosts the owner
+#define ENABLE_LOCK_PI_PROP                  DISPLAY_PROP("enable_lock_pi")
+// Per SCOPE_LOCK site wait and hold time accounting, the hottest sites are listed in dumpsys
+#define ENABLE_LOCK_STATS_PROP               DISPLAY_PROP("enable_lock_stats")
+// Hold commits past the client elapse time, until just before the first vsync they can make
+#define VSYNC_ALIGNED_COMMIT_PROP            DISPLAY_PROP("vsync_aligned_commit")
+// Helper threads of the CPU color convert and stitch engines, in addition to the calling thread
+#define CPU_BLIT_THREADS_PROP                DISPLAY_PROP("cpu_blit_threads")
+// GPU virtual displays of up to this many pixels convert on the CPU instead of GLES
+#define CPU_COLOR_CONVERT_MAX_PIXELS_PROP    DISPLAY_PROP("cpu_color_convert_max_pixels")
+// Stitch layers on the CPU instead of GLES, needs linear stitch sources
+#define CPU_LAYER_STITCH_PROP                DISPLAY_PROP("cpu_layer_stitch")
 
 // Add all other.properties above
 // End of property
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <unistd.h>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "content_analyzer.h"
+#include "histogram_log.h"
+
+namespace {
+
+constexpr nsecs_t ns_per_second = 1000000000;
+
+struct Options {
+  nsecs_t window = 0;  // 0 for a single window over the whole range
+  nsecs_t begin = 0;
+  nsecs_t end = INT64_MAX;
+  uint32_t analyzer_frames = histogram::ContentAnalyzerConfig().window_size;
+};
+
+struct Window {
+  histogram::LogAggregate aggregate;
+  uint64_t scene_cuts = 0;
+  uint64_t static_frames = 0;
+  uint64_t dark_frames = 0;
+};
+
+struct Run {
+  std::string name;
+  std::unique_ptr<histogram::LogReader> reader;
+  std::vector<Window> windows;
+  Window total;
+};
+
+void show_usage(char *progname) {
+  std::cout << "Usage: ./" + std::string(progname) + " {options} LOG [LOG]\n"
+            << "Summarize a log written by color_sampling_tool -s, or compare two logs.\n\n"
+            << "\tOptions:\n"
+            << "\t-h      display this help message\n"
+            << "\t-w NUM  report windows of NUM seconds instead of the whole log\n"
+            << "\t-b NUM  skip the first NUM seconds of the log\n"
+            << "\t-e NUM  stop NUM seconds into the log\n"
+            << "\t-c NUM  content analysis over the last NUM frames, default "
+            << Options().analyzer_frames << "\n";
+}
+
+void add(Window &window, drm_msm_hist const &frame, nsecs_t timestamp,
+         histogram::ContentStats const &stats) {
+  window.aggregate.add(frame, timestamp);
+  window.scene_cuts += stats.scene_cut ? 1 : 0;
+  window.static_frames += stats.static_content ? 1 : 0;
+  window.dark_frames += stats.dark ? 1 : 0;
+}
+
+// Aggregates the frames of the selected range into windows by their time since the log start.
+void read_run(Run &run, Options const &options) {
+  histogram::ContentAnalyzerConfig config;
+  config.window_size = options.analyzer_frames;
+  histogram::ContentAnalyzer analyzer(config);
+
+  nsecs_t const start = run.reader->header().start_time;
+  drm_msm_hist frame;
+  nsecs_t timestamp = 0;
+  while (run.reader->next(frame, timestamp)) {
+    nsecs_t const offset = timestamp - start;
+    if (offset < options.begin)
+      continue;
+    if (offset >= options.end)
+      break;
+
+    auto const stats = analyzer.insert(frame, timestamp);
+    size_t const index =
+        options.window ? static_cast<size_t>((offset - options.begin) / options.window) : 0;
+    if (index >= run.windows.size())
+      run.windows.resize(index + 1);
+    add(run.windows[index], frame, timestamp, stats);
+    add(run.total, frame, timestamp, stats);
+  }
+}
+
+double seconds(nsecs_t ns) {
+  return static_cast<double>(ns) / ns_per_second;
+}
+
+std::string window_label(nsecs_t start) {
+  std::ostringstream ss;
+  ss << std::fixed << std::setprecision(1) << seconds(start);
+  return ss.str();
+}
+
+double fps(Window const &window) {
+  auto const &aggregate = window.aggregate;
+  if (aggregate.frames < 2 || aggregate.last <= aggregate.first)
+    return 0.0;
+  return (aggregate.frames - 1) / seconds(aggregate.last - aggregate.first);
+}
+
+void print_header(Run const &run) {
+  auto const &header = run.reader->header();
+  auto const &total = run.total.aggregate;
+  std::cout << run.name << ": " << total.frames << " frames over "
+            << seconds(total.last - total.first) << " s, log started at realtime "
+            << seconds(header.start_realtime) << " s";
+  if (run.reader->truncated())
+    std::cout << ", damaged after the last frame read";
+  std::cout << '\n';
+}
+
+void print_summary(Run const &run, Options const &options) {
+  std::cout << "start\tframes\tfps\tmean\tp10\tp50\tp90\tcuts\tstatic\tdark\n";
+  auto print = [](std::string const &label, Window const &window) {
+    auto const &aggregate = window.aggregate;
+    std::cout << label << '\t' << aggregate.frames << '\t' << fps(window) << '\t'
+              << aggregate.mean_luma() << '\t' << aggregate.percentile_bin(10) << '\t'
+              << aggregate.percentile_bin(50) << '\t' << aggregate.percentile_bin(90) << '\t'
+              << window.scene_cuts << '\t' << window.static_frames << '\t' << window.dark_frames
+              << '\n';
+  };
+
+  if (options.window) {
+    for (auto i = 0u; i < run.windows.size(); i++) {
+      if (run.windows[i].aggregate.frames)
+        print(window_label(options.begin + i * options.window), run.windows[i]);
+    }
+  }
+  print("all", run.total);
+}
+
+void print_comparison(Run const &a, Run const &b, Options const &options) {
+  std::cout << "start\tframes a\tframes b\tmean a\tmean b\tp50 a\tp50 b\tdistance\n";
+  auto print = [](std::string const &label, Window const &x, Window const &y) {
+    std::cout << label << '\t' << x.aggregate.frames << '\t' << y.aggregate.frames << '\t'
+              << x.aggregate.mean_luma() << '\t' << y.aggregate.mean_luma() << '\t'
+              << x.aggregate.percentile_bin(50) << '\t' << y.aggregate.percentile_bin(50) << '\t'
+              << histogram::LogAggregate::distance_permille(x.aggregate, y.aggregate) << '\n';
+  };
+
+  if (options.window) {
+    Window const empty;
+    size_t const count = std::max(a.windows.size(), b.windows.size());
+    for (auto i = 0u; i < count; i++) {
+      Window const &x = (i < a.windows.size()) ? a.windows[i] : empty;
+      Window const &y = (i < b.windows.size()) ? b.windows[i] : empty;
+      if (x.aggregate.frames || y.aggregate.frames)
+        print(window_label(options.begin + i * options.window), x, y);
+    }
+  }
+  print("all", a.total, b.total);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  int c;
+  while ((c = getopt(argc, argv, "w:b:e:c:h")) != -1) {
+    switch (c) {
+      case 'w':
+        options.window = static_cast<nsecs_t>(strtod(optarg, NULL) * ns_per_second);
+        break;
+      case 'b':
+        options.begin = static_cast<nsecs_t>(strtod(optarg, NULL) * ns_per_second);
+        break;
+      case 'e':
+        options.end = static_cast<nsecs_t>(strtod(optarg, NULL) * ns_per_second);
+        break;
+      case 'c':
+        options.analyzer_frames = static_cast<uint32_t>(strtoul(optarg, NULL, 10));
+        break;
+      default:
+      case 'h':
+        show_usage(argv[0]);
+        return EXIT_SUCCESS;
+    }
+  }
+
+  int const logs = argc - optind;
+  if (logs < 1 || logs > 2 || options.window < 0 || options.begin < 0 ||
+      options.end <= options.begin) {
+    show_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<Run> runs(logs);
+  for (auto i = 0; i < logs; i++) {
+    runs[i].name = argv[optind + i];
+    runs[i].reader = histogram::LogReader::open(runs[i].name);
+    if (!runs[i].reader) {
+      std::cerr << "Error, could not read log: " << runs[i].name << "\n";
+      return EXIT_FAILURE;
+    }
+    read_run(runs[i], options);
+  }
+
+  std::cout << std::fixed << std::setprecision(3);
+  for (auto const &run : runs)
+    print_header(run);
+  if (logs == 1) {
+    print_summary(runs[0], options);
+  } else {
+    print_comparison(runs[0], runs[1], options);
+  }
+
+  return EXIT_SUCCESS;
+}
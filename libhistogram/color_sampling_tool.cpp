@@ -22,6 +22,7 @@
 #include <thread>
 
 #include "histogram_collector.h"
+#include "histogram_log.h"
 
 void sigint_handler(int) {}
 
@@ -31,6 +32,7 @@ void show_usage(char *progname) {
             << "\tOptions:\n"
             << "\t-h      display this help message\n"
             << "\t-o      write output to specified filename\n"
+            << "\t-s FILE stream every frame to the binary log FILE, see color_sampling_analyzer\n"
             << "\t-t NUM  Collect results over NUM seconds, and then exit\n"
             << "\t-m NUM  Only store the last NUM frames of statistics\n";
 }
@@ -44,12 +46,16 @@ int main(int argc, char **argv) {
 
   int c;
   char *output_filename = NULL;
+  char *stream_filename = NULL;
   int timeout = -1;
-  while ((c = getopt(argc, argv, "o:t:h")) != -1) {
+  while ((c = getopt(argc, argv, "o:s:t:h")) != -1) {
     switch (c) {
       case 'o':
         output_filename = optarg;
         break;
+      case 's':
+        stream_filename = optarg;
+        break;
       case 't':
         timeout = strtol(optarg, NULL, 10);
         break;
@@ -60,7 +66,21 @@ int main(int argc, char **argv) {
     }
   }
 
+  std::unique_ptr<histogram::LogWriter> log;
+  if (stream_filename) {
+    log = histogram::LogWriter::create(stream_filename, systemTime(SYSTEM_TIME_MONOTONIC));
+    if (!log) {
+      std::cerr << "Error, could not create log: " << stream_filename << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
   histogram::HistogramCollector histogram;
+  if (log) {
+    histogram.set_frame_listener([&log](drm_msm_hist const &frame, nsecs_t timestamp) {
+      log->append(frame, timestamp);
+    });
+  }
   histogram.start();
 
   bool cancelled_during_wait = false;
@@ -79,6 +99,12 @@ int main(int argc, char **argv) {
 
   histogram.stop();
 
+  if (log) {
+    log->close();
+    std::cout << "Streamed " << log->frames() << " frames, " << log->bytes() << " bytes to "
+              << stream_filename << '\n';
+  }
+
   if (cancelled_during_wait) {
     std::cout << "Timed histogram collection cancelled via signal\n";
     return EXIT_SUCCESS;
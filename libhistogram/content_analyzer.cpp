@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <math.h>
+#include <algorithm>
+
+#include "content_analyzer.h"
+
+histogram::ContentAnalyzer::ContentAnalyzer(histogram::ContentAnalyzerConfig const &config)
+    : config(config), window_total(0), window_weighted(0) {
+  window_bins.fill(0);
+}
+
+void histogram::ContentAnalyzer::update_window_stats(Bins const &bins, uint64_t total,
+                                                     uint64_t weighted,
+                                                     histogram::ContentStats &stats) const {
+  stats.window_frames = static_cast<uint32_t>(window.size());
+  stats.mean_luma = 0.0f;
+  stats.p10_bin = 0;
+  stats.p50_bin = 0;
+  stats.p90_bin = 0;
+  stats.dark = false;
+  if (total == 0)
+    return;
+
+  stats.mean_luma = static_cast<float>(static_cast<double>(weighted) /
+                                       (static_cast<double>(total) * (HIST_V_SIZE - 1)));
+
+  // Smallest bin at which the cumulative count reaches the percentile, all three in one walk.
+  uint64_t const p10 = (total * 10 + 99) / 100;
+  uint64_t const p50 = (total * 50 + 99) / 100;
+  uint64_t const p90 = (total * 90 + 99) / 100;
+  uint64_t cumulative = 0;
+  bool p10_found = false, p50_found = false;
+  for (auto i = 0u; i < HIST_V_SIZE; i++) {
+    cumulative += bins[i];
+    if (!p10_found && cumulative >= p10) {
+      stats.p10_bin = i;
+      p10_found = true;
+    }
+    if (!p50_found && cumulative >= p50) {
+      stats.p50_bin = i;
+      p50_found = true;
+    }
+    if (cumulative >= p90) {
+      stats.p90_bin = i;
+      break;
+    }
+  }
+  stats.dark = stats.p90_bin < config.dark_bin;
+}
+
+uint32_t histogram::ContentAnalyzer::frame_delta_permille(Frame const &a, Frame const &b) {
+  uint64_t total_a = 0, total_b = 0;
+  for (auto i = 0u; i < HIST_V_SIZE; i++) {
+    total_a += a[i];
+    total_b += b[i];
+  }
+  if (total_a == 0 || total_b == 0)
+    return (total_a == total_b) ? 0 : 1000;
+
+  double const scale_a = 1.0 / static_cast<double>(total_a);
+  double const scale_b = 1.0 / static_cast<double>(total_b);
+  double distance = 0.0;
+  for (auto i = 0u; i < HIST_V_SIZE; i++)
+    distance += fabs(a[i] * scale_a - b[i] * scale_b);
+
+  // The largest distance of two normalized histograms is 2.
+  return std::min(static_cast<uint32_t>(distance * 500.0 + 0.5), 1000u);
+}
+
+histogram::ContentStats histogram::ContentAnalyzer::insert(drm_msm_hist const &frame,
+                                                           nsecs_t timestamp) {
+  std::unique_lock<decltype(mutex)> lk(mutex);
+  Frame bins;
+  std::copy(std::begin(frame.data), std::end(frame.data), bins.begin());
+
+  current.frame_count++;
+  current.timestamp = timestamp;
+
+  bool const has_previous = !window.empty();
+  current.frame_delta_permille = has_previous ? frame_delta_permille(window.back(), bins) : 0;
+  if (has_previous && current.frame_delta_permille <= config.static_delta_permille) {
+    current.static_frames++;
+  } else {
+    current.static_frames = 0;
+  }
+  current.static_content = current.static_frames >= config.static_min_frames;
+  current.scene_cut =
+      has_previous && current.frame_delta_permille >= config.scene_cut_delta_permille;
+  if (current.scene_cut) {
+    current.scene_cuts++;
+    current.last_scene_cut = timestamp;
+  }
+
+  for (auto i = 0u; i < HIST_V_SIZE; i++) {
+    window_bins[i] += bins[i];
+    window_total += bins[i];
+    window_weighted += static_cast<uint64_t>(i) * bins[i];
+  }
+  window.push_back(bins);
+
+  auto const window_size = std::max(config.window_size, 1u);
+  while (window.size() > window_size) {
+    Frame const &oldest = window.front();
+    for (auto i = 0u; i < HIST_V_SIZE; i++) {
+      window_bins[i] -= oldest[i];
+      window_total -= oldest[i];
+      window_weighted -= static_cast<uint64_t>(i) * oldest[i];
+    }
+    window.pop_front();
+  }
+
+  update_window_stats(window_bins, window_total, window_weighted, current);
+  return current;
+}
+
+histogram::ContentStats histogram::ContentAnalyzer::stats() const {
+  std::unique_lock<decltype(mutex)> lk(mutex);
+  return current;
+}
+
+void histogram::ContentAnalyzer::reset() {
+  std::unique_lock<decltype(mutex)> lk(mutex);
+  window.clear();
+  window_bins.fill(0);
+  window_total = 0;
+  window_weighted = 0;
+  current = {};
+}
+
+histogram::ContentStats histogram::ContentAnalyzer::recompute() const {
+  std::unique_lock<decltype(mutex)> lk(mutex);
+  Bins bins;
+  bins.fill(0);
+  uint64_t total = 0, weighted = 0;
+  for (auto const &frame : window) {
+    for (auto i = 0u; i < HIST_V_SIZE; i++) {
+      bins[i] += frame[i];
+      total += frame[i];
+      weighted += static_cast<uint64_t>(i) * frame[i];
+    }
+  }
+
+  histogram::ContentStats stats = current;
+  update_window_stats(bins, total, weighted, stats);
+  return stats;
+}
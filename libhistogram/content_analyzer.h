@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#pragma once
+#include <display/drm/msm_drm_pp.h>
+#include <utils/Timers.h>
+#include <array>
+#include <deque>
+#include <mutex>
+
+namespace histogram {
+
+struct ContentAnalyzerConfig {
+  uint32_t window_size = 30;                  // frames the rolling statistics cover
+  uint32_t dark_bin = HIST_V_SIZE / 4;        // dark if 90% of the pixels are below this bin
+  uint32_t static_delta_permille = 5;         // largest frame delta of a static frame
+  uint32_t static_min_frames = 10;            // static frames in a row for static content
+  uint32_t scene_cut_delta_permille = 300;    // smallest frame delta of a scene cut
+};
+
+// Frame to frame changes are the L1 distance of the normalized histograms, in permille of the
+// largest possible distance.
+struct ContentStats {
+  uint64_t frame_count = 0;                   // frames analyzed since the last reset
+  nsecs_t timestamp = 0;                      // arrival of the latest frame
+  // Over the rolling window. Luma is the V component, bins run from 0 to HIST_V_SIZE - 1.
+  uint32_t window_frames = 0;
+  float mean_luma = 0.0f;                     // 0.0 to 1.0
+  uint32_t p10_bin = 0;
+  uint32_t p50_bin = 0;
+  uint32_t p90_bin = 0;
+  bool dark = false;
+  // Latest frame against the previous one.
+  uint32_t frame_delta_permille = 0;
+  uint32_t static_frames = 0;                 // consecutive frames below the static threshold
+  bool static_content = false;
+  bool scene_cut = false;
+  uint64_t scene_cuts = 0;
+  nsecs_t last_scene_cut = 0;
+};
+
+// Derives content statistics from the frames of the color sampling ring. The rolling window is
+// kept as running sums, so a frame costs O(bins) whatever the window size.
+class ContentAnalyzer {
+ public:
+  explicit ContentAnalyzer(ContentAnalyzerConfig const &config = ContentAnalyzerConfig());
+
+  ContentStats insert(drm_msm_hist const &frame, nsecs_t timestamp);
+  ContentStats stats() const;
+  void reset();
+  // The current statistics with the window part recomputed from the frames in the window, which
+  // costs O(window size * bins). Reference for the running sums.
+  ContentStats recompute() const;
+
+ private:
+  ContentAnalyzer(ContentAnalyzer const &) = delete;
+  ContentAnalyzer &operator=(ContentAnalyzer const &) = delete;
+
+  using Frame = std::array<uint32_t, HIST_V_SIZE>;
+  using Bins = std::array<uint64_t, HIST_V_SIZE>;
+
+  void update_window_stats(Bins const &bins, uint64_t total, uint64_t weighted,
+                           ContentStats &stats) const;
+  static uint32_t frame_delta_permille(Frame const &a, Frame const &b);
+
+  std::mutex mutable mutex;
+  ContentAnalyzerConfig const config;
+  std::deque<Frame> window;
+  Bins window_bins;
+  uint64_t window_total;
+  uint64_t window_weighted;
+  ContentStats current;
+};
+
+}  // namespace histogram
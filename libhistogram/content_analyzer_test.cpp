@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "content_analyzer.h"
+using namespace testing;
+
+namespace {
+
+drm_msm_hist fillFrame(uint32_t first_bin, uint32_t last_bin, uint32_t count) {
+  drm_msm_hist frame {};
+  for (auto i = first_bin; i <= last_bin; i++) {
+    frame.data[i] = count;
+  }
+  return frame;
+}
+
+void expectSameStats(histogram::ContentStats const &a, histogram::ContentStats const &b) {
+  EXPECT_THAT(a.frame_count, Eq(b.frame_count));
+  EXPECT_THAT(a.timestamp, Eq(b.timestamp));
+  EXPECT_THAT(a.window_frames, Eq(b.window_frames));
+  EXPECT_THAT(a.mean_luma, Eq(b.mean_luma));
+  EXPECT_THAT(a.p10_bin, Eq(b.p10_bin));
+  EXPECT_THAT(a.p50_bin, Eq(b.p50_bin));
+  EXPECT_THAT(a.p90_bin, Eq(b.p90_bin));
+  EXPECT_THAT(a.dark, Eq(b.dark));
+  EXPECT_THAT(a.frame_delta_permille, Eq(b.frame_delta_permille));
+  EXPECT_THAT(a.static_frames, Eq(b.static_frames));
+  EXPECT_THAT(a.static_content, Eq(b.static_content));
+  EXPECT_THAT(a.scene_cut, Eq(b.scene_cut));
+  EXPECT_THAT(a.scene_cuts, Eq(b.scene_cuts));
+  EXPECT_THAT(a.last_scene_cut, Eq(b.last_scene_cut));
+}
+
+drm_msm_hist randomFrame(std::mt19937 &rng) {
+  // Mostly small changes around a drifting level, with the occasional cut.
+  static uint32_t level = HIST_V_SIZE / 2;
+  if (rng() % 20 == 0) {
+    level = rng() % HIST_V_SIZE;
+  }
+  drm_msm_hist frame {};
+  for (auto i = 0u; i < HIST_V_SIZE; i++) {
+    uint32_t distance = (i > level) ? (i - level) : (level - i);
+    frame.data[i] = (distance < 32) ? (1000 + rng() % 50) : (rng() % 5);
+  }
+  return frame;
+}
+
+}  // namespace
+
+TEST(ContentAnalyzerTestCases, NoFrames) {
+  histogram::ContentAnalyzer analyzer;
+  auto stats = analyzer.stats();
+  EXPECT_THAT(stats.frame_count, Eq(0u));
+  EXPECT_THAT(stats.window_frames, Eq(0u));
+  EXPECT_THAT(stats.mean_luma, Eq(0.0f));
+  EXPECT_FALSE(stats.dark);
+  EXPECT_FALSE(stats.static_content);
+  EXPECT_FALSE(stats.scene_cut);
+}
+
+TEST(ContentAnalyzerTestCases, UniformFrame) {
+  histogram::ContentAnalyzer analyzer;
+  auto stats = analyzer.insert(fillFrame(0, HIST_V_SIZE - 1, 1), 10);
+
+  EXPECT_THAT(stats.frame_count, Eq(1u));
+  EXPECT_THAT(stats.timestamp, Eq(10));
+  EXPECT_THAT(stats.window_frames, Eq(1u));
+  EXPECT_THAT(stats.mean_luma, FloatEq(0.5f));
+  EXPECT_THAT(stats.p10_bin, Eq((HIST_V_SIZE * 10 + 99) / 100 - 1));
+  EXPECT_THAT(stats.p50_bin, Eq(HIST_V_SIZE / 2 - 1));
+  EXPECT_THAT(stats.p90_bin, Eq((HIST_V_SIZE * 90 + 99) / 100 - 1));
+  EXPECT_FALSE(stats.dark);
+  EXPECT_FALSE(stats.scene_cut);
+}
+
+TEST(ContentAnalyzerTestCases, DarkScene) {
+  histogram::ContentAnalyzer analyzer;
+  auto stats = analyzer.insert(fillFrame(0, 10, 100), 0);
+  EXPECT_TRUE(stats.dark);
+  EXPECT_THAT(stats.p90_bin, Le(10u));
+
+  // A bright frame in the window lifts the 90th percentile.
+  stats = analyzer.insert(fillFrame(HIST_V_SIZE - 10, HIST_V_SIZE - 1, 100), 1);
+  EXPECT_FALSE(stats.dark);
+}
+
+TEST(ContentAnalyzerTestCases, StaticContent) {
+  histogram::ContentAnalyzerConfig config;
+  config.static_min_frames = 3;
+  histogram::ContentAnalyzer analyzer(config);
+  auto const frame = fillFrame(20, 200, 7);
+
+  auto stats = analyzer.insert(frame, 0);
+  EXPECT_THAT(stats.static_frames, Eq(0u));
+  for (auto i = 1u; i < config.static_min_frames; i++) {
+    stats = analyzer.insert(frame, i);
+    EXPECT_THAT(stats.frame_delta_permille, Eq(0u));
+    EXPECT_FALSE(stats.static_content);
+  }
+  stats = analyzer.insert(frame, config.static_min_frames);
+  EXPECT_THAT(stats.static_frames, Eq(config.static_min_frames));
+  EXPECT_TRUE(stats.static_content);
+
+  stats = analyzer.insert(fillFrame(100, 250, 7), config.static_min_frames + 1);
+  EXPECT_THAT(stats.static_frames, Eq(0u));
+  EXPECT_FALSE(stats.static_content);
+}
+
+TEST(ContentAnalyzerTestCases, SceneCut) {
+  histogram::ContentAnalyzer analyzer;
+  analyzer.insert(fillFrame(0, 50, 10), 100);
+  auto stats = analyzer.insert(fillFrame(200, 250, 10), 200);
+  EXPECT_TRUE(stats.scene_cut);
+  EXPECT_THAT(stats.frame_delta_permille, Eq(1000u));
+  EXPECT_THAT(stats.scene_cuts, Eq(1u));
+  EXPECT_THAT(stats.last_scene_cut, Eq(200));
+
+  stats = analyzer.insert(fillFrame(200, 250, 10), 300);
+  EXPECT_FALSE(stats.scene_cut);
+  EXPECT_THAT(stats.scene_cuts, Eq(1u));
+  EXPECT_THAT(stats.last_scene_cut, Eq(200));
+}
+
+TEST(ContentAnalyzerTestCases, WindowEviction) {
+  histogram::ContentAnalyzerConfig config;
+  config.window_size = 2;
+  histogram::ContentAnalyzer analyzer(config);
+  analyzer.insert(fillFrame(0, 0, 100), 0);
+  analyzer.insert(fillFrame(HIST_V_SIZE - 1, HIST_V_SIZE - 1, 100), 1);
+  auto stats = analyzer.insert(fillFrame(HIST_V_SIZE - 1, HIST_V_SIZE - 1, 100), 2);
+
+  EXPECT_THAT(stats.frame_count, Eq(3u));
+  EXPECT_THAT(stats.window_frames, Eq(2u));
+  EXPECT_THAT(stats.mean_luma, FloatEq(1.0f));
+  EXPECT_THAT(stats.p10_bin, Eq(HIST_V_SIZE - 1));
+}
+
+TEST(ContentAnalyzerTestCases, Reset) {
+  histogram::ContentAnalyzer analyzer;
+  analyzer.insert(fillFrame(0, 10, 1), 0);
+  analyzer.reset();
+  expectSameStats(analyzer.stats(), histogram::ContentStats());
+}
+
+TEST(ContentAnalyzerTestCases, IncrementalMatchesRecompute) {
+  std::mt19937 rng(42);
+  histogram::ContentAnalyzer analyzer;
+  for (auto i = 0; i < 500; i++) {
+    auto const stats = analyzer.insert(randomFrame(rng), i);
+    expectSameStats(stats, analyzer.recompute());
+  }
+  EXPECT_THAT(analyzer.stats().scene_cuts, Gt(0u));
+}
+
+// Incremental update against recomputing the window from scratch, with the window as large as
+// the collector ring.
+TEST(ContentAnalyzerTestCases, IncrementalFasterThanRecompute) {
+  histogram::ContentAnalyzerConfig config;
+  config.window_size = 300;
+  histogram::ContentAnalyzer analyzer(config);
+  std::mt19937 rng(7);
+  std::vector<drm_msm_hist> frames;
+  for (auto i = 0; i < 1000; i++) {
+    frames.push_back(randomFrame(rng));
+  }
+
+  std::chrono::nanoseconds incremental {0}, recompute {0};
+  for (auto i = 0u; i < frames.size(); i++) {
+    auto start = std::chrono::steady_clock::now();
+    auto const stats = analyzer.insert(frames[i], i);
+    auto middle = std::chrono::steady_clock::now();
+    auto const reference = analyzer.recompute();
+    auto end = std::chrono::steady_clock::now();
+    incremental += middle - start;
+    recompute += end - middle;
+    ASSERT_THAT(stats.p50_bin, Eq(reference.p50_bin));
+  }
+
+  std::cout << "per frame: incremental " << incremental.count() / frames.size()
+            << " ns, recompute " << recompute.count() / frames.size() << " ns" << std::endl;
+  EXPECT_THAT(incremental, Lt(recompute));
+}
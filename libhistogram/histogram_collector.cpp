@@ -37,6 +37,7 @@
 #include <xf86drm.h>
 #include <xf86drmMode.h>
 
+#include "content_analyzer.h"
 #include "histogram_collector.h"
 #include "ringbuffer.h"
 
@@ -44,7 +45,8 @@ constexpr static auto implementation_defined_max_frame_ringbuffer = 300;
 
 histogram::HistogramCollector::HistogramCollector()
     : histogram(histogram::Ringbuffer::create(implementation_defined_max_frame_ringbuffer,
-                                              std::make_unique<histogram::DefaultTimeKeeper>())) {}
+                                              std::make_unique<histogram::DefaultTimeKeeper>())),
+      analyzer(std::make_unique<histogram::ContentAnalyzer>()) {}
 
 histogram::HistogramCollector::~HistogramCollector() {
   stop();
@@ -86,9 +88,31 @@ std::string histogram::HistogramCollector::Dump() const {
        << (i + 1) / static_cast<float>(samples.size()) << "\t: " << samples[i] << '\n';
   }
 
+  auto const stats = analyzer->stats();
+  ss << "Content, last " << stats.window_frames << " of " << stats.frame_count << " frames:\n";
+  ss << "\tmean luma: " << stats.mean_luma << " percentiles 10/50/90: " << stats.p10_bin << "/"
+     << stats.p50_bin << "/" << stats.p90_bin << " dark: " << stats.dark << '\n';
+  ss << "\tframe delta: " << stats.frame_delta_permille
+     << " static frames: " << stats.static_frames << " static: " << stats.static_content
+     << " scene cuts: " << stats.scene_cuts << '\n';
+
   return ss.str();
 }
 
+void histogram::HistogramCollector::set_content_listener(ContentListener listener) {
+  std::unique_lock<decltype(mutex)> lk(mutex);
+  content_listener = listener;
+}
+
+void histogram::HistogramCollector::set_frame_listener(FrameListener listener) {
+  std::unique_lock<decltype(mutex)> lk(mutex);
+  frame_listener = listener;
+}
+
+histogram::ContentStats histogram::HistogramCollector::content_stats() const {
+  return analyzer->stats();
+}
+
 HWC2::Error histogram::HistogramCollector::collect(
     uint64_t max_frames, uint64_t timestamp,
     int32_t out_samples_size[NUM_HISTOGRAM_COLOR_COMPONENTS],
@@ -146,6 +170,7 @@ void histogram::HistogramCollector::start(uint64_t max_frames) {
   started = true;
   histogram =
       histogram::Ringbuffer::create(max_frames, std::make_unique<histogram::DefaultTimeKeeper>());
+  analyzer->reset();
   monitoring_thread = std::thread(&HistogramCollector::blob_processing_thread, this);
 }
 
@@ -190,6 +215,8 @@ void histogram::HistogramCollector::blob_processing_thread() {
     }
 
     auto work = blobwork;
+    auto listener = content_listener;
+    auto record = frame_listener;
     work_available = false;
     lk.unlock();
 
@@ -198,9 +225,17 @@ void histogram::HistogramCollector::blob_processing_thread() {
       lk.lock();
       continue;
     }
-    histogram->insert(*static_cast<struct drm_msm_hist *>(blob->data));
+    auto const &frame = *static_cast<struct drm_msm_hist *>(blob->data);
+    auto const timestamp = systemTime(SYSTEM_TIME_MONOTONIC);
+    histogram->insert(frame);
+    auto const stats = analyzer->insert(frame, timestamp);
+    if (record)
+      record(frame, timestamp);
     drmModeFreePropertyBlob(blob);
 
+    if (listener)
+      listener(stats);
+
     lk.lock();
   }
 }
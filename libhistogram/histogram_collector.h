@@ -17,7 +17,10 @@
 #ifndef HISTOGRAM_HISTOGRAM_COLLECTOR_H_
 #define HISTOGRAM_HISTOGRAM_COLLECTOR_H_
 #include <android-base/thread_annotations.h>
+#include <utils/Timers.h>
 #include <condition_variable>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -30,10 +33,14 @@
 // number of enums in hwc2_format_color_component_t;
 #define NUM_HISTOGRAM_COLOR_COMPONENTS 4
 
+struct drm_msm_hist;
+
 namespace histogram {
 typedef uint32_t BlobId;
 
 class Ringbuffer;
+class ContentAnalyzer;
+struct ContentStats;
 class HistogramCollector {
  public:
   HistogramCollector();
@@ -45,6 +52,15 @@ class HistogramCollector {
 
   void notify_histogram_event(int blob_source_fd, BlobId id);
 
+  // Called on the collector thread with the content statistics after every sampled frame.
+  using ContentListener = std::function<void(ContentStats const &)>;
+  void set_content_listener(ContentListener listener);
+  ContentStats content_stats() const;
+
+  // Called on the collector thread with every sampled frame and its arrival time.
+  using FrameListener = std::function<void(drm_msm_hist const &, nsecs_t)>;
+  void set_frame_listener(FrameListener listener);
+
   std::string Dump() const;
 
   HWC2::Error collect(uint64_t max_frames, uint64_t timestamp,
@@ -73,6 +89,9 @@ class HistogramCollector {
   std::thread monitoring_thread;
 
   std::unique_ptr<histogram::Ringbuffer> histogram;
+  std::unique_ptr<histogram::ContentAnalyzer> const analyzer;
+  ContentListener content_listener /* GUARDED_BY(mutex) */;
+  FrameListener frame_listener /* GUARDED_BY(mutex) */;
 };
 
 }  // namespace histogram
@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <log/log.h>
+#include <math.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+
+#include "histogram_log.h"
+
+namespace {
+
+constexpr char log_magic[8] = {'H', 'I', 'S', 'T', 'L', 'O', 'G', '\0'};
+constexpr uint32_t log_version = 1;
+constexpr size_t max_varint_size = 10;
+// Size prefix, timestamp and bins. A uint32 delta takes at most 5 bytes once zigzagged.
+constexpr size_t max_record_size = 2 * max_varint_size + HIST_V_SIZE * 5;
+
+size_t page_size() {
+  return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+size_t put_varint(uint8_t *out, uint64_t value) {
+  size_t size = 0;
+  while (value >= 0x80) {
+    out[size++] = static_cast<uint8_t>(value | 0x80);
+    value >>= 7;
+  }
+  out[size++] = static_cast<uint8_t>(value);
+  return size;
+}
+
+bool get_varint(uint8_t const *data, size_t end, size_t &position, uint64_t &value) {
+  value = 0;
+  for (auto shift = 0u; shift < 7 * max_varint_size; shift += 7) {
+    if (position >= end)
+      return false;
+    uint8_t const byte = data[position++];
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+uint64_t zigzag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+}  // namespace
+
+constexpr size_t histogram::LogWriter::default_chunk_size;
+
+histogram::LogWriter::LogWriter(int fd, size_t chunk_size)
+    : fd(fd),
+      chunk_size(chunk_size),
+      map(nullptr),
+      map_offset(0),
+      position(0),
+      file_size(0),
+      frame_count(0),
+      last_timestamp(0),
+      record(max_record_size) {
+  last_bins.fill(0);
+}
+
+histogram::LogWriter::~LogWriter() {
+  close();
+}
+
+std::unique_ptr<histogram::LogWriter> histogram::LogWriter::create(std::string const &path,
+                                                                   nsecs_t start_time,
+                                                                   size_t chunk_size) {
+  // A whole record has to fit a chunk behind any page boundary.
+  size_t const page = page_size();
+  chunk_size = std::max(chunk_size, max_record_size + page);
+  chunk_size = (chunk_size + page - 1) / page * page;
+
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    ALOGE("Could not create histogram log %s: %s", path.c_str(), strerror(errno));
+    return nullptr;
+  }
+
+  auto writer = std::unique_ptr<histogram::LogWriter>(new histogram::LogWriter(fd, chunk_size));
+  if (!writer->map_at(0))
+    return nullptr;
+
+  histogram::LogHeader header {};
+  memcpy(header.magic, log_magic, sizeof(header.magic));
+  header.version = log_version;
+  header.header_size = sizeof(header);
+  header.bins = HIST_V_SIZE;
+  header.start_time = start_time;
+  header.start_realtime =
+      systemTime(SYSTEM_TIME_REALTIME) - (systemTime(SYSTEM_TIME_MONOTONIC) - start_time);
+  memcpy(writer->map, &header, sizeof(header));
+  writer->position = sizeof(header);
+  writer->last_timestamp = start_time;
+
+  return writer;
+}
+
+bool histogram::LogWriter::map_at(uint64_t offset) {
+  unmap();
+  uint64_t const end = offset + chunk_size;
+  if (end > file_size) {
+    // Allocated rather than sparse, a full disk fails here instead of faulting a store.
+    int const error = posix_fallocate(fd, static_cast<off_t>(file_size),
+                                      static_cast<off_t>(end - file_size));
+    if (error) {
+      ALOGE("Could not extend histogram log: %s", strerror(error));
+      return false;
+    }
+    file_size = end;
+  }
+
+  void *addr =
+      mmap(nullptr, chunk_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, static_cast<off_t>(offset));
+  if (addr == MAP_FAILED) {
+    ALOGE("Could not map histogram log: %s", strerror(errno));
+    return false;
+  }
+  map = static_cast<uint8_t *>(addr);
+  map_offset = offset;
+  return true;
+}
+
+void histogram::LogWriter::unmap() {
+  if (map)
+    munmap(map, chunk_size);
+  map = nullptr;
+}
+
+bool histogram::LogWriter::append(drm_msm_hist const &frame, nsecs_t timestamp) {
+  std::unique_lock<decltype(mutex)> lk(mutex);
+  if (fd < 0)
+    return false;
+
+  timestamp = std::max(timestamp, last_timestamp);
+  size_t size = put_varint(record.data(), static_cast<uint64_t>(timestamp - last_timestamp));
+  for (auto i = 0u; i < HIST_V_SIZE; i++) {
+    int64_t const delta = static_cast<int64_t>(frame.data[i]) - last_bins[i];
+    size += put_varint(record.data() + size, zigzag(delta));
+  }
+
+  uint8_t prefix[max_varint_size];
+  size_t const prefix_size = put_varint(prefix, size);
+  if (!map || position + prefix_size + size > map_offset + chunk_size) {
+    if (!map_at(position / page_size() * page_size()))
+      return false;
+  }
+
+  uint8_t *out = map + (position - map_offset);
+  memcpy(out + prefix_size, record.data(), size);
+  // Until the size is in place the record reads as the end of the log.
+  std::atomic_signal_fence(std::memory_order_release);
+  memcpy(out, prefix, prefix_size);
+
+  position += prefix_size + size;
+  frame_count++;
+  last_timestamp = timestamp;
+  std::copy(std::begin(frame.data), std::end(frame.data), last_bins.begin());
+  return true;
+}
+
+bool histogram::LogWriter::close() {
+  std::unique_lock<decltype(mutex)> lk(mutex);
+  if (fd < 0)
+    return true;
+
+  unmap();
+  bool const trimmed = ftruncate(fd, static_cast<off_t>(position)) == 0;
+  if (!trimmed)
+    ALOGE("Could not trim histogram log: %s", strerror(errno));
+  ::close(fd);
+  fd = -1;
+  return trimmed;
+}
+
+uint64_t histogram::LogWriter::frames() const {
+  std::unique_lock<decltype(mutex)> lk(mutex);
+  return frame_count;
+}
+
+uint64_t histogram::LogWriter::bytes() const {
+  std::unique_lock<decltype(mutex)> lk(mutex);
+  return position;
+}
+
+histogram::LogReader::LogReader(uint8_t const *data, size_t size)
+    : data(data), size(size), position(0), damaged(false), frame_count(0), last_timestamp(0) {
+  rewind();
+}
+
+histogram::LogReader::~LogReader() {
+  munmap(const_cast<uint8_t *>(data), size);
+}
+
+std::unique_ptr<histogram::LogReader> histogram::LogReader::open(std::string const &path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    ALOGE("Could not open histogram log %s: %s", path.c_str(), strerror(errno));
+    return nullptr;
+  }
+
+  struct stat st {};
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(histogram::LogHeader)) {
+    ALOGE("Histogram log %s is too small", path.c_str());
+    ::close(fd);
+    return nullptr;
+  }
+
+  size_t const size = static_cast<size_t>(st.st_size);
+  void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    ALOGE("Could not map histogram log %s: %s", path.c_str(), strerror(errno));
+    return nullptr;
+  }
+
+  auto const *header = static_cast<histogram::LogHeader const *>(addr);
+  if (memcmp(header->magic, log_magic, sizeof(log_magic)) || header->version != log_version ||
+      header->bins != HIST_V_SIZE || header->header_size < sizeof(histogram::LogHeader) ||
+      header->header_size > size) {
+    ALOGE("%s is not a histogram log this reader understands", path.c_str());
+    munmap(addr, size);
+    return nullptr;
+  }
+
+  return std::unique_ptr<histogram::LogReader>(
+      new histogram::LogReader(static_cast<uint8_t const *>(addr), size));
+}
+
+histogram::LogHeader const &histogram::LogReader::header() const {
+  return *reinterpret_cast<histogram::LogHeader const *>(data);
+}
+
+bool histogram::LogReader::next(drm_msm_hist &frame, nsecs_t &timestamp) {
+  if (damaged || position >= size || data[position] == 0)
+    return false;
+
+  size_t p = position;
+  uint64_t length = 0;
+  if (!get_varint(data, size, p, length) || length > size - p) {
+    damaged = true;
+    return false;
+  }
+
+  size_t const end = p + length;
+  uint64_t delta = 0;
+  std::array<uint32_t, HIST_V_SIZE> bins;
+  bool valid = get_varint(data, end, p, delta) && delta <= INT64_MAX;
+  for (auto i = 0u; valid && i < HIST_V_SIZE; i++) {
+    uint64_t value = 0;
+    valid = get_varint(data, end, p, value);
+    int64_t const bin = last_bins[i] + unzigzag(value);
+    valid = valid && bin >= 0 && bin <= UINT32_MAX;
+    bins[i] = static_cast<uint32_t>(bin);
+  }
+  if (!valid || p != end) {
+    damaged = true;
+    return false;
+  }
+
+  position = end;
+  frame_count++;
+  last_timestamp += static_cast<nsecs_t>(delta);
+  last_bins = bins;
+
+  frame.flags = 0;
+  std::copy(bins.begin(), bins.end(), std::begin(frame.data));
+  timestamp = last_timestamp;
+  return true;
+}
+
+bool histogram::LogReader::truncated() const {
+  return damaged;
+}
+
+uint64_t histogram::LogReader::frames() const {
+  return frame_count;
+}
+
+void histogram::LogReader::rewind() {
+  position = header().header_size;
+  damaged = false;
+  frame_count = 0;
+  last_timestamp = header().start_time;
+  last_bins.fill(0);
+}
+
+void histogram::LogAggregate::add(drm_msm_hist const &frame, nsecs_t timestamp) {
+  if (frames == 0)
+    first = timestamp;
+  last = timestamp;
+  frames++;
+  for (auto i = 0u; i < HIST_V_SIZE; i++)
+    bins[i] += frame.data[i];
+}
+
+float histogram::LogAggregate::mean_luma() const {
+  uint64_t total = 0, weighted = 0;
+  for (auto i = 0u; i < HIST_V_SIZE; i++) {
+    total += bins[i];
+    weighted += static_cast<uint64_t>(i) * bins[i];
+  }
+  if (total == 0)
+    return 0.0f;
+  return static_cast<float>(static_cast<double>(weighted) /
+                            (static_cast<double>(total) * (HIST_V_SIZE - 1)));
+}
+
+uint32_t histogram::LogAggregate::percentile_bin(uint32_t percent) const {
+  uint64_t total = 0;
+  for (auto const bin : bins)
+    total += bin;
+  if (total == 0)
+    return 0;
+
+  uint64_t const target = (total * std::min(percent, 100u) + 99) / 100;
+  uint64_t cumulative = 0;
+  for (auto i = 0u; i < HIST_V_SIZE; i++) {
+    cumulative += bins[i];
+    if (cumulative >= target)
+      return i;
+  }
+  return HIST_V_SIZE - 1;
+}
+
+uint32_t histogram::LogAggregate::distance_permille(histogram::LogAggregate const &a,
+                                                    histogram::LogAggregate const &b) {
+  uint64_t total_a = 0, total_b = 0;
+  for (auto i = 0u; i < HIST_V_SIZE; i++) {
+    total_a += a.bins[i];
+    total_b += b.bins[i];
+  }
+  if (total_a == 0 || total_b == 0)
+    return (total_a == total_b) ? 0 : 1000;
+
+  double const scale_a = 1.0 / static_cast<double>(total_a);
+  double const scale_b = 1.0 / static_cast<double>(total_b);
+  double distance = 0.0;
+  for (auto i = 0u; i < HIST_V_SIZE; i++)
+    distance += fabs(a.bins[i] * scale_a - b.bins[i] * scale_b);
+
+  // The largest distance of two normalized histograms is 2.
+  return std::min(static_cast<uint32_t>(distance * 500.0 + 0.5), 1000u);
+}
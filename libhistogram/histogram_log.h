@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#pragma once
+#include <display/drm/msm_drm_pp.h>
+#include <utils/Timers.h>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace histogram {
+
+// Binary log of color sampling frames, native byte order. The header is followed by records:
+//   varint  payload size, a 0 in its place ends the log
+//   varint  ns since the previous frame, or since start_time for the first one
+//   varint  bins, as zigzag deltas to the previous frame, the first frame to an empty one
+// Consecutive frames are alike, so most deltas fit a byte or two. A record is committed by
+// writing its size last.
+struct LogHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;
+  uint32_t bins;
+  uint32_t reserved;
+  nsecs_t start_time;       // SYSTEM_TIME_MONOTONIC, the timebase of the frames
+  nsecs_t start_realtime;   // SYSTEM_TIME_REALTIME at start_time, to line up separate runs
+};
+
+// Appends frames to a log through a shared mapping that is extended one chunk at a time, so a
+// frame costs an encode and a copy and no system call. Records are complete in the page cache
+// once append() returns, a killed process leaves a readable log behind.
+class LogWriter {
+ public:
+  static constexpr size_t default_chunk_size = 4 << 20;
+
+  static std::unique_ptr<LogWriter> create(std::string const &path, nsecs_t start_time,
+                                           size_t chunk_size = default_chunk_size);
+  ~LogWriter();
+
+  bool append(drm_msm_hist const &frame, nsecs_t timestamp);
+  // Trims the file to the records, later appends fail.
+  bool close();
+  uint64_t frames() const;
+  uint64_t bytes() const;
+
+ private:
+  LogWriter(int fd, size_t chunk_size);
+  LogWriter(LogWriter const &) = delete;
+  LogWriter &operator=(LogWriter const &) = delete;
+
+  bool map_at(uint64_t offset);
+  void unmap();
+
+  std::mutex mutable mutex;
+  int fd;
+  size_t const chunk_size;
+  uint8_t *map;
+  uint64_t map_offset;
+  uint64_t position;
+  uint64_t file_size;
+  uint64_t frame_count;
+  nsecs_t last_timestamp;
+  std::array<uint32_t, HIST_V_SIZE> last_bins;
+  std::vector<uint8_t> record;
+};
+
+// Reads a log sequentially from a read only mapping.
+class LogReader {
+ public:
+  static std::unique_ptr<LogReader> open(std::string const &path);
+  ~LogReader();
+
+  LogHeader const &header() const;
+  // The next frame, false at the end of the log or at the first damaged record.
+  bool next(drm_msm_hist &frame, nsecs_t &timestamp);
+  // Whether reading stopped at a damaged or incomplete record rather than at the end.
+  bool truncated() const;
+  // Frames read since the start of the log.
+  uint64_t frames() const;
+  void rewind();
+
+ private:
+  LogReader(uint8_t const *data, size_t size);
+  LogReader(LogReader const &) = delete;
+  LogReader &operator=(LogReader const &) = delete;
+
+  uint8_t const *const data;
+  size_t const size;
+  size_t position;
+  bool damaged;
+  uint64_t frame_count;
+  nsecs_t last_timestamp;
+  std::array<uint32_t, HIST_V_SIZE> last_bins;
+};
+
+// Sum of the frames of a span of a log.
+struct LogAggregate {
+  uint64_t frames = 0;
+  nsecs_t first = 0;
+  nsecs_t last = 0;
+  std::array<uint64_t, HIST_V_SIZE> bins {};
+
+  void add(drm_msm_hist const &frame, nsecs_t timestamp);
+  float mean_luma() const;
+  // Smallest bin at which the cumulative count reaches percent of the pixels.
+  uint32_t percentile_bin(uint32_t percent) const;
+  // L1 distance of the normalized histograms, in permille of the largest possible distance.
+  static uint32_t distance_permille(LogAggregate const &a, LogAggregate const &b);
+};
+
+}  // namespace histogram
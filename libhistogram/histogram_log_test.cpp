@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "histogram_log.h"
+using namespace testing;
+
+namespace {
+
+std::string logPath(char const *name) {
+  return TempDir() + name + ".histlog";
+}
+
+off_t fileSize(std::string const &path) {
+  struct stat st {};
+  stat(path.c_str(), &st);
+  return st.st_size;
+}
+
+// Frames drifting slowly like real content, with their timestamps at ~60Hz.
+std::vector<std::pair<drm_msm_hist, nsecs_t>> makeFrames(size_t count, nsecs_t start) {
+  std::mt19937 rng(3);
+  std::vector<std::pair<drm_msm_hist, nsecs_t>> frames(count);
+  drm_msm_hist frame {};
+  for (auto i = 0u; i < HIST_V_SIZE; i++)
+    frame.data[i] = 8000 + rng() % 4000;
+  nsecs_t timestamp = start;
+  for (auto &entry : frames) {
+    for (auto i = 0u; i < HIST_V_SIZE; i++)
+      frame.data[i] += rng() % 9 - 4;
+    if (rng() % 100 == 0)
+      frame.data[rng() % HIST_V_SIZE] = rng();
+    timestamp += 16666666 + rng() % 1000;
+    entry = {frame, timestamp};
+  }
+  return frames;
+}
+
+void expectFrame(drm_msm_hist const &actual, drm_msm_hist const &expected) {
+  EXPECT_THAT(actual.data, ElementsAreArray(expected.data));
+}
+
+drm_msm_hist fillFrame(uint32_t first_bin, uint32_t last_bin, uint32_t count) {
+  drm_msm_hist frame {};
+  for (auto i = first_bin; i <= last_bin; i++)
+    frame.data[i] = count;
+  return frame;
+}
+
+}  // namespace
+
+TEST(HistogramLogTestCases, RoundTrip) {
+  auto const path = logPath("round_trip");
+  auto const frames = makeFrames(2000, 1000);
+
+  // The smallest chunk, to cross many chunk boundaries.
+  auto writer = histogram::LogWriter::create(path, 1000, 1);
+  ASSERT_THAT(writer, NotNull());
+  for (auto const &entry : frames)
+    ASSERT_TRUE(writer->append(entry.first, entry.second));
+  EXPECT_THAT(writer->frames(), Eq(frames.size()));
+  EXPECT_TRUE(writer->close());
+  EXPECT_THAT(fileSize(path), Eq(static_cast<off_t>(writer->bytes())));
+  EXPECT_FALSE(writer->append(frames[0].first, 0));
+
+  auto reader = histogram::LogReader::open(path);
+  ASSERT_THAT(reader, NotNull());
+  EXPECT_THAT(reader->header().start_time, Eq(1000));
+  EXPECT_THAT(reader->header().bins, Eq(static_cast<uint32_t>(HIST_V_SIZE)));
+
+  drm_msm_hist frame;
+  nsecs_t timestamp = 0;
+  for (auto const &entry : frames) {
+    ASSERT_TRUE(reader->next(frame, timestamp));
+    EXPECT_THAT(timestamp, Eq(entry.second));
+    expectFrame(frame, entry.first);
+  }
+  EXPECT_FALSE(reader->next(frame, timestamp));
+  EXPECT_FALSE(reader->truncated());
+  EXPECT_THAT(reader->frames(), Eq(frames.size()));
+
+  reader->rewind();
+  ASSERT_TRUE(reader->next(frame, timestamp));
+  EXPECT_THAT(timestamp, Eq(frames[0].second));
+  expectFrame(frame, frames[0].first);
+  unlink(path.c_str());
+}
+
+TEST(HistogramLogTestCases, DeltaEncodingIsCompact) {
+  auto const path = logPath("compact");
+  auto const frames = makeFrames(1000, 0);
+  auto writer = histogram::LogWriter::create(path, 0);
+  ASSERT_THAT(writer, NotNull());
+  for (auto const &entry : frames)
+    writer->append(entry.first, entry.second);
+  writer->close();
+
+  // Raw frames are 4 bytes a bin, the deltas above mostly fit one.
+  EXPECT_THAT(writer->bytes(), Lt(frames.size() * sizeof(drm_msm_hist::data) / 3));
+  unlink(path.c_str());
+}
+
+TEST(HistogramLogTestCases, OpenLogIsReadable) {
+  auto const path = logPath("open");
+  auto const frames = makeFrames(10, 0);
+  auto writer = histogram::LogWriter::create(path, 0);
+  ASSERT_THAT(writer, NotNull());
+  for (auto const &entry : frames)
+    writer->append(entry.first, entry.second);
+
+  // Without close() the file still holds the preallocated rest of the chunk.
+  EXPECT_THAT(fileSize(path), Gt(static_cast<off_t>(writer->bytes())));
+  auto reader = histogram::LogReader::open(path);
+  ASSERT_THAT(reader, NotNull());
+  drm_msm_hist frame;
+  nsecs_t timestamp = 0;
+  while (reader->next(frame, timestamp)) {}
+  EXPECT_THAT(reader->frames(), Eq(frames.size()));
+  EXPECT_FALSE(reader->truncated());
+  unlink(path.c_str());
+}
+
+TEST(HistogramLogTestCases, DamagedLogStopsAtLastGoodFrame) {
+  auto const path = logPath("damaged");
+  auto const frames = makeFrames(10, 0);
+  auto writer = histogram::LogWriter::create(path, 0);
+  ASSERT_THAT(writer, NotNull());
+  for (auto const &entry : frames)
+    writer->append(entry.first, entry.second);
+  writer->close();
+  ASSERT_THAT(truncate(path.c_str(), fileSize(path) - 10), Eq(0));
+
+  auto reader = histogram::LogReader::open(path);
+  ASSERT_THAT(reader, NotNull());
+  drm_msm_hist frame;
+  nsecs_t timestamp = 0;
+  while (reader->next(frame, timestamp)) {}
+  EXPECT_THAT(reader->frames(), Eq(frames.size() - 1));
+  EXPECT_TRUE(reader->truncated());
+  EXPECT_THAT(timestamp, Eq(frames[frames.size() - 2].second));
+  unlink(path.c_str());
+}
+
+TEST(HistogramLogTestCases, RejectsOtherFiles) {
+  auto const path = logPath("other");
+  EXPECT_THAT(histogram::LogReader::open(path), IsNull());
+
+  std::ofstream file(path);
+  file << std::string(256, 'x');
+  file.close();
+  EXPECT_THAT(histogram::LogReader::open(path), IsNull());
+  unlink(path.c_str());
+}
+
+TEST(HistogramLogTestCases, TimestampsDoNotGoBack) {
+  auto const path = logPath("timestamps");
+  auto writer = histogram::LogWriter::create(path, 100);
+  ASSERT_THAT(writer, NotNull());
+  auto const frame = fillFrame(0, 10, 1);
+  writer->append(frame, 50);
+  writer->append(frame, 300);
+  writer->append(frame, 200);
+  writer->close();
+
+  auto reader = histogram::LogReader::open(path);
+  ASSERT_THAT(reader, NotNull());
+  drm_msm_hist read;
+  nsecs_t timestamp = 0;
+  std::vector<nsecs_t> timestamps;
+  while (reader->next(read, timestamp))
+    timestamps.push_back(timestamp);
+  EXPECT_THAT(timestamps, ElementsAre(100, 300, 300));
+  unlink(path.c_str());
+}
+
+TEST(HistogramLogTestCases, Aggregate) {
+  histogram::LogAggregate dark, bright, empty;
+  dark.add(fillFrame(0, 0, 10), 5);
+  dark.add(fillFrame(0, 0, 10), 10);
+  bright.add(fillFrame(HIST_V_SIZE - 1, HIST_V_SIZE - 1, 10), 5);
+
+  EXPECT_THAT(dark.frames, Eq(2u));
+  EXPECT_THAT(dark.first, Eq(5));
+  EXPECT_THAT(dark.last, Eq(10));
+  EXPECT_THAT(dark.mean_luma(), FloatEq(0.0f));
+  EXPECT_THAT(bright.mean_luma(), FloatEq(1.0f));
+  EXPECT_THAT(dark.percentile_bin(90), Eq(0u));
+  EXPECT_THAT(bright.percentile_bin(10), Eq(HIST_V_SIZE - 1u));
+  EXPECT_THAT(histogram::LogAggregate::distance_permille(dark, dark), Eq(0u));
+  EXPECT_THAT(histogram::LogAggregate::distance_permille(dark, bright), Eq(1000u));
+  EXPECT_THAT(histogram::LogAggregate::distance_permille(empty, empty), Eq(0u));
+
+  histogram::LogAggregate uniform;
+  uniform.add(fillFrame(0, HIST_V_SIZE - 1, 1), 0);
+  EXPECT_THAT(uniform.percentile_bin(50), Eq(HIST_V_SIZE / 2 - 1u));
+  EXPECT_THAT(histogram::LogAggregate::distance_permille(uniform, dark), Eq(996u));
+}
@@ -28,6 +28,7 @@
  */
 
 #include "qdMetaData.h"
+#include "qdMetaDataBatch.h"
 
 #include <QtiGrallocPriv.h>
 #include <errno.h>
@@ -39,7 +40,11 @@
 #include <string.h>
 #include <sys/mman.h>
 
+#include <atomic>
 #include <cinttypes>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 
 static int colorMetaDataToColorSpace(ColorMetaData in, ColorSpace_t *out) {
   if (in.colorPrimaries == ColorPrimaries_BT601_6_525 ||
@@ -236,6 +241,22 @@ unsigned long getMetaDataSizeWithReservedRegion(uint64_t reserved_size) {
   return static_cast<unsigned long>(ROUND_UP_PAGESIZE(sizeof(MetaData_t) + reserved_size));
 }
 
+static std::atomic<uint64_t> gMmapCount(0);
+static std::atomic<uint64_t> gMunmapCount(0);
+
+static void *mapMetaDataRegion(int fd, unsigned long size) {
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base != reinterpret_cast<void *>(MAP_FAILED)) {
+      gMmapCount++;
+    }
+    return base;
+}
+
+static void unmapMetaDataRegion(void *base, unsigned long size) {
+    munmap(base, size);
+    gMunmapCount++;
+}
+
 static int validateAndMap(private_handle_t* handle) {
     if (private_handle_t::validate(handle)) {
         ALOGE("%s: Private handle is invalid - handle:%p", __func__, handle);
@@ -248,8 +269,7 @@ static int validateAndMap(private_handle_t* handle) {
 
     if (!handle->base_metadata) {
         auto size = getMetaDataSize();
-        void *base = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED,
-                handle->fd_metadata, 0);
+        void *base = mapMetaDataRegion(handle->fd_metadata, size);
         if (base == reinterpret_cast<void*>(MAP_FAILED)) {
             ALOGE("%s: metadata mmap failed - handle:%p fd: %d err: %s",
                 __func__, handle, handle->fd_metadata, strerror(errno));
@@ -259,11 +279,10 @@ static int validateAndMap(private_handle_t* handle) {
         auto metadata = reinterpret_cast<MetaData_t *>(handle->base_metadata);
         if (metadata->reservedSize) {
           auto reserved_size = metadata->reservedSize;
-          munmap(reinterpret_cast<void *>(handle->base_metadata), getMetaDataSize());
+          unmapMetaDataRegion(reinterpret_cast<void *>(handle->base_metadata), getMetaDataSize());
           handle->base_metadata = 0;
           size = getMetaDataSizeWithReservedRegion(reserved_size);
-          void *new_base =
-              mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, handle->fd_metadata, 0);
+          void *new_base = mapMetaDataRegion(handle->fd_metadata, size);
           if (new_base == reinterpret_cast<void *>(MAP_FAILED)) {
             ALOGE("%s: metadata mmap failed - handle:%p fd: %d err: %s", __func__, handle,
                   handle->fd_metadata, strerror(errno));
@@ -280,7 +299,7 @@ static void unmapAndReset(private_handle_t *handle) {
       // If reservedSize is 0, the return value will be the same as getMetaDataSize
       auto metadata = reinterpret_cast<MetaData_t *>(handle->base_metadata);
       auto size = getMetaDataSizeWithReservedRegion(metadata->reservedSize);
-      munmap(reinterpret_cast<void *>(handle->base_metadata), size);
+      unmapMetaDataRegion(reinterpret_cast<void *>(handle->base_metadata), size);
       handle->base_metadata = 0;
     }
 }
@@ -640,3 +659,144 @@ int getMetaDataAndUnmap(struct private_handle_t *handle,
     unmapAndReset(handle);
     return ret;
 }
+
+int getMetaDataBatchVa(MetaData_t *data, struct MetaDataFetchEntry *entries, uint32_t count) {
+    if (data == nullptr || (entries == nullptr && count))
+        return -EINVAL;
+
+    for (uint32_t i = 0; i < count; i++) {
+      entries[i].status = getMetaDataVa(data, entries[i].paramType, entries[i].param);
+    }
+    return 0;
+}
+
+int setMetaDataBatchVa(MetaData_t *data, struct MetaDataSetEntry *entries, uint32_t count) {
+    if (data == nullptr || (entries == nullptr && count))
+        return -EINVAL;
+
+    for (uint32_t i = 0; i < count; i++) {
+      entries[i].status = setMetaDataVa(data, entries[i].paramType, entries[i].param);
+    }
+    return 0;
+}
+
+int getMetaDataBatch(struct private_handle_t *handle, struct MetaDataFetchEntry *entries,
+                     uint32_t count) {
+    auto err = validateAndMap(handle);
+    if (err != 0) {
+      for (uint32_t i = 0; entries && i < count; i++) {
+        entries[i].status = err;
+      }
+      return err;
+    }
+    return getMetaDataBatchVa(reinterpret_cast<MetaData_t *>(handle->base_metadata), entries,
+                              count);
+}
+
+int setMetaDataBatch(struct private_handle_t *handle, struct MetaDataSetEntry *entries,
+                     uint32_t count) {
+    auto err = validateAndMap(handle);
+    if (err != 0) {
+      for (uint32_t i = 0; entries && i < count; i++) {
+        entries[i].status = err;
+      }
+      return err;
+    }
+    return setMetaDataBatchVa(reinterpret_cast<MetaData_t *>(handle->base_metadata), entries,
+                              count);
+}
+
+// Mappings whose refcount dropped to zero are parked on an idle list and only
+// unmapped once more than kMaxIdleMappings of them accumulate.
+static const size_t kMaxIdleMappings = 64;
+
+struct MetaDataMapping {
+  void *base = nullptr;
+  unsigned long size = 0;
+  uint32_t refs = 0;
+  std::list<uint64_t>::iterator idle_pos;
+};
+
+static std::mutex gMappingLock;
+static std::unordered_map<uint64_t, MetaDataMapping> gMappings;
+static std::list<uint64_t> gIdleMappings;
+static uint64_t gCacheHits = 0;
+
+MetaData_t *acquireMetaDataMapping(struct private_handle_t *handle) {
+    if (private_handle_t::validate(handle)) {
+      ALOGE("%s: Private handle is invalid - handle:%p", __func__, handle);
+      return nullptr;
+    }
+    if (handle->fd_metadata < 0) {
+      return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(gMappingLock);
+    auto it = gMappings.find(handle->id);
+    if (it != gMappings.end()) {
+      if (it->second.refs++ == 0) {
+        gIdleMappings.erase(it->second.idle_pos);
+      }
+      gCacheHits++;
+      return reinterpret_cast<MetaData_t *>(it->second.base);
+    }
+
+    auto size = getMetaDataSize();
+    void *base = mapMetaDataRegion(handle->fd_metadata, size);
+    if (base == reinterpret_cast<void *>(MAP_FAILED)) {
+      ALOGE("%s: metadata mmap failed - handle:%p fd: %d err: %s", __func__, handle,
+            handle->fd_metadata, strerror(errno));
+      return nullptr;
+    }
+    auto reserved_size = reinterpret_cast<MetaData_t *>(base)->reservedSize;
+    if (reserved_size) {
+      unmapMetaDataRegion(base, size);
+      size = getMetaDataSizeWithReservedRegion(reserved_size);
+      base = mapMetaDataRegion(handle->fd_metadata, size);
+      if (base == reinterpret_cast<void *>(MAP_FAILED)) {
+        ALOGE("%s: metadata mmap failed - handle:%p fd: %d err: %s", __func__, handle,
+              handle->fd_metadata, strerror(errno));
+        return nullptr;
+      }
+    }
+
+    MetaDataMapping &mapping = gMappings[handle->id];
+    mapping.base = base;
+    mapping.size = size;
+    mapping.refs = 1;
+    mapping.idle_pos = gIdleMappings.end();
+    return reinterpret_cast<MetaData_t *>(base);
+}
+
+void releaseMetaDataMapping(uint64_t buffer_id) {
+    std::lock_guard<std::mutex> lock(gMappingLock);
+    auto it = gMappings.find(buffer_id);
+    if (it == gMappings.end() || it->second.refs == 0) {
+      ALOGE("%s: No active metadata mapping for buffer id %" PRIu64, __func__, buffer_id);
+      return;
+    }
+    if (--it->second.refs) {
+      return;
+    }
+    it->second.idle_pos = gIdleMappings.insert(gIdleMappings.end(), buffer_id);
+
+    while (gIdleMappings.size() > kMaxIdleMappings) {
+      auto victim = gMappings.find(gIdleMappings.front());
+      gIdleMappings.pop_front();
+      if (victim != gMappings.end()) {
+        unmapMetaDataRegion(victim->second.base, victim->second.size);
+        gMappings.erase(victim);
+      }
+    }
+}
+
+void getMetaDataMapStats(struct MetaDataMapStats *stats) {
+    if (stats == nullptr)
+        return;
+
+    std::lock_guard<std::mutex> lock(gMappingLock);
+    stats->mmap_count = gMmapCount;
+    stats->munmap_count = gMunmapCount;
+    stats->cache_hits = gCacheHits;
+    stats->cache_size = gMappings.size();
+}
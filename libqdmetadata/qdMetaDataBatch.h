@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef _QDMETADATA_BATCH_H
+#define _QDMETADATA_BATCH_H
+
+#include <stdint.h>
+#include <qdMetaData.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct private_handle_t;
+
+// One entry of a batched metadata read. status holds what getMetaData would
+// have returned for this paramType.
+struct MetaDataFetchEntry {
+  enum DispFetchParamType paramType;
+  void *param;
+  int status;
+};
+
+// One entry of a batched metadata write. status holds what setMetaData would
+// have returned for this paramType.
+struct MetaDataSetEntry {
+  enum DispParamType paramType;
+  void *param;
+  int status;
+};
+
+struct MetaDataMapStats {
+  uint64_t mmap_count;    // metadata regions mapped, by any accessor
+  uint64_t munmap_count;  // metadata regions unmapped, by any accessor
+  uint64_t cache_hits;    // acquireMetaDataMapping calls served from the cache
+  uint64_t cache_size;    // mappings currently held by the cache
+};
+
+// Maps the metadata region of handle at most once and services all entries.
+// Returns 0 when the region could be mapped; per entry results are in status.
+int getMetaDataBatch(struct private_handle_t *handle, struct MetaDataFetchEntry *entries,
+                     uint32_t count);
+int setMetaDataBatch(struct private_handle_t *handle, struct MetaDataSetEntry *entries,
+                     uint32_t count);
+
+// Same as above on an already mapped region, e.g. one from acquireMetaDataMapping.
+int getMetaDataBatchVa(MetaData_t *data, struct MetaDataFetchEntry *entries, uint32_t count);
+int setMetaDataBatchVa(MetaData_t *data, struct MetaDataSetEntry *entries, uint32_t count);
+
+// Returns a mapping of the metadata region of handle which stays valid until the
+// matching releaseMetaDataMapping(handle->id). Mappings are shared per buffer id
+// and refcounted. Released mappings are kept for a while so that buffers cycling
+// through a BufferQueue do not get remapped every frame.
+MetaData_t *acquireMetaDataMapping(struct private_handle_t *handle);
+void releaseMetaDataMapping(uint64_t buffer_id);
+
+void getMetaDataMapStats(struct MetaDataMapStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // _QDMETADATA_BATCH_H
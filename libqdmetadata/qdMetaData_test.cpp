@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <QtiGrallocPriv.h>
+#include <gralloc_priv.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "qdMetaData.h"
+#include "qdMetaDataBatch.h"
+using namespace testing;
+
+namespace {
+
+// Buffer ids above anything the tests could collide with across cases.
+uint64_t next_id = 1ull << 40;
+
+// A handle with only a metadata region, set up the way BufferManager::AllocateBuffer does.
+private_handle_t *createHandle() {
+  int meta_fd = memfd_create("qdmetadata_test", 0);
+  if (meta_fd < 0 || ftruncate(meta_fd, static_cast<off_t>(getMetaDataSize()))) {
+    return nullptr;
+  }
+  auto hnd = static_cast<private_handle_t *>(calloc(1, sizeof(private_handle_t)));
+  hnd->fd = -1;
+  hnd->fd_metadata = meta_fd;
+  hnd->magic = qtigralloc::private_handle_t::kMagic;
+  hnd->layer_count = 1;
+  hnd->id = next_id++;
+  hnd->version = static_cast<int>(sizeof(native_handle));
+  hnd->numInts = qtigralloc::private_handle_t::NumInts();
+  hnd->numFds = qtigralloc::private_handle_t::kNumFds;
+  return hnd;
+}
+
+void destroyHandle(private_handle_t *hnd) {
+  if (hnd->base_metadata) {
+    munmap(reinterpret_cast<void *>(hnd->base_metadata), getMetaDataSize());
+  }
+  close(hnd->fd_metadata);
+  free(hnd);
+}
+
+MetaDataMapStats mapStats() {
+  MetaDataMapStats stats {};
+  getMetaDataMapStats(&stats);
+  return stats;
+}
+
+// What HWCLayer reads from every layer buffer each frame.
+struct FrameMetaData {
+  float fps = 0;
+  int32_t interlaced = 0;
+  uint32_t linear_format = 0;
+  uint32_t single_buffer = 0;
+  ColorMetaData color = {};
+  uint64_t vt_timestamp = 0;
+};
+
+constexpr uint32_t kFrameParams = 6;
+
+void fillEntries(FrameMetaData *out, MetaDataFetchEntry (&entries)[kFrameParams]) {
+  entries[0] = {GET_REFRESH_RATE, &out->fps, -EINVAL};
+  entries[1] = {GET_PP_PARAM_INTERLACED, &out->interlaced, -EINVAL};
+  entries[2] = {GET_LINEAR_FORMAT, &out->linear_format, -EINVAL};
+  entries[3] = {GET_SINGLE_BUFFER_MODE, &out->single_buffer, -EINVAL};
+  entries[4] = {GET_COLOR_METADATA, &out->color, -EINVAL};
+  entries[5] = {GET_VT_TIMESTAMP, &out->vt_timestamp, -EINVAL};
+}
+
+void writeFrameMetaData(private_handle_t *hnd) {
+  float fps = 60.0f;
+  int32_t interlaced = 0;
+  uint32_t linear_format = 1;
+  uint32_t single_buffer = 0;
+  ColorMetaData color = {};
+  color.colorPrimaries = ColorPrimaries_BT709_5;
+  color.range = Range_Limited;
+  uint64_t vt_timestamp = 1234;
+  MetaDataSetEntry entries[] = {
+    {UPDATE_REFRESH_RATE, &fps, -EINVAL},
+    {PP_PARAM_INTERLACED, &interlaced, -EINVAL},
+    {LINEAR_FORMAT, &linear_format, -EINVAL},
+    {SET_SINGLE_BUFFER_MODE, &single_buffer, -EINVAL},
+    {COLOR_METADATA, &color, -EINVAL},
+    {SET_VT_TIMESTAMP, &vt_timestamp, -EINVAL},
+  };
+  setMetaDataBatch(hnd, entries, kFrameParams);
+  munmap(reinterpret_cast<void *>(hnd->base_metadata), getMetaDataSize());
+  hnd->base_metadata = 0;
+}
+
+}  // namespace
+
+TEST(QdMetaDataTestCases, BatchMatchesPerParamAccess) {
+  auto hnd = createHandle();
+  ASSERT_THAT(hnd, NotNull());
+  writeFrameMetaData(hnd);
+
+  FrameMetaData batched;
+  MetaDataFetchEntry entries[kFrameParams];
+  fillEntries(&batched, entries);
+  ASSERT_THAT(getMetaDataBatch(hnd, entries, kFrameParams), Eq(0));
+  for (auto &entry : entries) {
+    EXPECT_THAT(entry.status, Eq(0));
+  }
+
+  FrameMetaData single;
+  EXPECT_THAT(getMetaData(hnd, GET_REFRESH_RATE, &single.fps), Eq(0));
+  EXPECT_THAT(getMetaData(hnd, GET_LINEAR_FORMAT, &single.linear_format), Eq(0));
+  EXPECT_THAT(getMetaData(hnd, GET_COLOR_METADATA, &single.color), Eq(0));
+  EXPECT_THAT(getMetaData(hnd, GET_VT_TIMESTAMP, &single.vt_timestamp), Eq(0));
+  EXPECT_THAT(batched.fps, FloatEq(60.0f));
+  EXPECT_THAT(batched.fps, FloatEq(single.fps));
+  EXPECT_THAT(batched.linear_format, Eq(single.linear_format));
+  EXPECT_THAT(batched.color.colorPrimaries, Eq(single.color.colorPrimaries));
+  EXPECT_THAT(batched.vt_timestamp, Eq(1234u));
+  destroyHandle(hnd);
+}
+
+TEST(QdMetaDataTestCases, BatchReportsPerEntryStatus) {
+  auto hnd = createHandle();
+  ASSERT_THAT(hnd, NotNull());
+  float fps = 0;
+  MetaDataFetchEntry entries[] = {
+    {GET_REFRESH_RATE, &fps, 0},
+    {GET_VT_TIMESTAMP, nullptr, 0},
+  };
+  EXPECT_THAT(getMetaDataBatch(hnd, entries, 2), Eq(0));
+  EXPECT_THAT(entries[1].status, Eq(-EINVAL));
+
+  // An invalid handle fails every entry.
+  hnd->magic = 0;
+  entries[0].status = 0;
+  EXPECT_THAT(getMetaDataBatch(hnd, entries, 2), Ne(0));
+  EXPECT_THAT(entries[0].status, Ne(0));
+  hnd->magic = qtigralloc::private_handle_t::kMagic;
+  destroyHandle(hnd);
+}
+
+TEST(QdMetaDataTestCases, BatchMapsOnce) {
+  auto hnd = createHandle();
+  ASSERT_THAT(hnd, NotNull());
+  FrameMetaData out;
+  MetaDataFetchEntry entries[kFrameParams];
+  fillEntries(&out, entries);
+
+  auto before = mapStats();
+  getMetaDataBatch(hnd, entries, kFrameParams);
+  auto after = mapStats();
+  EXPECT_THAT(after.mmap_count - before.mmap_count, Eq(1u));
+  destroyHandle(hnd);
+}
+
+TEST(QdMetaDataTestCases, MappingIsSharedAndCached) {
+  auto hnd = createHandle();
+  ASSERT_THAT(hnd, NotNull());
+
+  auto before = mapStats();
+  MetaData_t *first = acquireMetaDataMapping(hnd);
+  MetaData_t *second = acquireMetaDataMapping(hnd);
+  ASSERT_THAT(first, NotNull());
+  EXPECT_THAT(second, Eq(first));
+  releaseMetaDataMapping(hnd->id);
+  releaseMetaDataMapping(hnd->id);
+
+  // Released mappings stay cached for the next frame.
+  EXPECT_THAT(acquireMetaDataMapping(hnd), Eq(first));
+  releaseMetaDataMapping(hnd->id);
+  auto after = mapStats();
+  EXPECT_THAT(after.mmap_count - before.mmap_count, Eq(1u));
+  EXPECT_THAT(after.munmap_count - before.munmap_count, Eq(0u));
+  EXPECT_THAT(after.cache_hits - before.cache_hits, Eq(2u));
+  EXPECT_THAT(after.cache_size, Eq(before.cache_size + 1));
+  destroyHandle(hnd);
+}
+
+TEST(QdMetaDataTestCases, AcquireRejectsInvalidHandle) {
+  auto hnd = createHandle();
+  ASSERT_THAT(hnd, NotNull());
+  hnd->numFds = 0;
+  EXPECT_THAT(acquireMetaDataMapping(hnd), IsNull());
+  hnd->numFds = qtigralloc::private_handle_t::kNumFds;
+  auto meta_fd = hnd->fd_metadata;
+  hnd->fd_metadata = -1;
+  EXPECT_THAT(acquireMetaDataMapping(hnd), IsNull());
+  hnd->fd_metadata = meta_fd;
+  destroyHandle(hnd);
+}
+
+TEST(QdMetaDataTestCases, IdleMappingsAreBounded) {
+  // More buffers than the idle list keeps, all released.
+  constexpr size_t kBuffers = 200;
+  std::vector<private_handle_t *> handles;
+  auto before = mapStats();
+  for (size_t i = 0; i < kBuffers; i++) {
+    auto hnd = createHandle();
+    ASSERT_THAT(hnd, NotNull());
+    ASSERT_THAT(acquireMetaDataMapping(hnd), NotNull());
+    handles.push_back(hnd);
+  }
+  for (auto hnd : handles) {
+    releaseMetaDataMapping(hnd->id);
+  }
+  auto after = mapStats();
+  EXPECT_THAT(after.mmap_count - before.mmap_count, Eq(kBuffers));
+  EXPECT_THAT(after.munmap_count - before.munmap_count, Ge(kBuffers - 64));
+  EXPECT_THAT(after.cache_size, Le(64u));
+
+  // The most recently released buffers are still served from the cache.
+  auto hits = after.cache_hits;
+  EXPECT_THAT(acquireMetaDataMapping(handles.back()), NotNull());
+  releaseMetaDataMapping(handles.back()->id);
+  EXPECT_THAT(mapStats().cache_hits, Eq(hits + 1));
+  for (auto hnd : handles) {
+    destroyHandle(hnd);
+  }
+}
+
+// Per frame metadata reads of a BufferQueue cycling through its buffers: per param map and unmap,
+// a batch on an unmapped handle, and a batch on a cached mapping.
+TEST(QdMetaDataTestCases, MappingChurnBenchmark) {
+  constexpr size_t kQueueDepth = 3;
+  constexpr size_t kFrames = 3000;
+  std::vector<private_handle_t *> queue;
+  for (size_t i = 0; i < kQueueDepth; i++) {
+    auto hnd = createHandle();
+    ASSERT_THAT(hnd, NotNull());
+    writeFrameMetaData(hnd);
+    queue.push_back(hnd);
+  }
+
+  FrameMetaData out;
+  MetaDataFetchEntry entries[kFrameParams];
+  fillEntries(&out, entries);
+  auto run = [&](char const *name, std::function<void(private_handle_t *)> read_frame) {
+    auto before = mapStats();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < kFrames; frame++) {
+      read_frame(queue[frame % kQueueDepth]);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    auto mmaps = mapStats().mmap_count - before.mmap_count;
+    std::cout << name << ": " << static_cast<double>(mmaps) / kFrames << " mmaps/frame, "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / kFrames
+              << " ns/frame" << std::endl;
+    return mmaps;
+  };
+
+  auto per_param = run("per param", [&](private_handle_t *hnd) {
+    for (auto &entry : entries) {
+      getMetaDataAndUnmap(hnd, entry.paramType, entry.param);
+    }
+  });
+  auto batch = run("batch", [&](private_handle_t *hnd) {
+    getMetaDataBatch(hnd, entries, kFrameParams);
+    munmap(reinterpret_cast<void *>(hnd->base_metadata), getMetaDataSize());
+    hnd->base_metadata = 0;
+  });
+  auto cached = run("cached batch", [&](private_handle_t *hnd) {
+    MetaData_t *data = acquireMetaDataMapping(hnd);
+    getMetaDataBatchVa(data, entries, kFrameParams);
+    releaseMetaDataMapping(hnd->id);
+  });
+
+  EXPECT_THAT(per_param, Eq(kFrames * kFrameParams));
+  EXPECT_THAT(batch, Eq(kFrames));
+  EXPECT_THAT(cached, Eq(kQueueDepth));
+  EXPECT_THAT(out.vt_timestamp, Eq(1234u));
+  for (auto hnd : queue) {
+    destroyHandle(hnd);
+  }
+}
@@ -30,6 +30,7 @@
 #include <drm_logger.h>
 
 #include "drm_atomic_req.h"
+#include "drm_backend.h"
 #include "drm_connector.h"
 #include "drm_crtc.h"
 #include "drm_manager.h"
@@ -44,14 +45,14 @@ DRMAtomicReq::DRMAtomicReq(int fd, DRMManager *drm_mgr) : drm_mgr_(drm_mgr), fd_
 
 DRMAtomicReq::~DRMAtomicReq() {
   if (drm_atomic_req_) {
-    drmModeAtomicFree(drm_atomic_req_);
+    DRMBackend::Get()->AtomicFree(drm_atomic_req_);
     drm_atomic_req_ = nullptr;
   }
 }
 
 int DRMAtomicReq::Init(const DRMDisplayToken &tok) {
   token_ = tok;
-  drm_atomic_req_ = drmModeAtomicAlloc();
+  drm_atomic_req_ = DRMBackend::Get()->AtomicAlloc();
   if (!drm_atomic_req_) {
     return -ENOMEM;
   }
@@ -167,15 +168,16 @@ int DRMAtomicReq::Validate() {
   // because we just want to validate, not actually mark planes as removed
   drm_mgr_->GetPlaneMgr()->UnsetUnusedResources(token_.crtc_id, false/*is_commit*/,
                                                 drm_atomic_req_);
-  int ret = drmModeAtomicCommit(fd_, drm_atomic_req_,
-                                DRM_MODE_ATOMIC_ALLOW_MODESET | DRM_MODE_ATOMIC_TEST_ONLY, nullptr);
+  int ret = DRMBackend::Get()->AtomicCommit(fd_, drm_atomic_req_,
+                                            DRM_MODE_ATOMIC_ALLOW_MODESET | DRM_MODE_ATOMIC_TEST_ONLY,
+                                            nullptr);
   if (ret) {
     DRM_LOGE("drmModeAtomicCommit failed with error %d (%s).", errno, strerror(errno));
   }
 
   drm_mgr_->GetPlaneMgr()->PostValidate(token_.crtc_id, !ret);
   drm_mgr_->GetCrtcMgr()->PostValidate(token_.crtc_id, !ret);
-  drmModeAtomicSetCursor(drm_atomic_req_, 0);
+  DRMBackend::Get()->AtomicSetCursor(drm_atomic_req_, 0);
 
   return ret;
 }
@@ -196,14 +198,14 @@ int DRMAtomicReq::Commit(bool synchronous, bool retain_planes) {
     flags |= DRM_MODE_ATOMIC_NONBLOCK;
   }
 
-  int ret = drmModeAtomicCommit(fd_, drm_atomic_req_, flags, nullptr);
+  int ret = DRMBackend::Get()->AtomicCommit(fd_, drm_atomic_req_, flags, nullptr);
   if (ret) {
     DRM_LOGE("drmModeAtomicCommit failed with error %d (%s). crtc=%u", errno, strerror(errno), token_.crtc_id);
   }
 
   drm_mgr_->GetPlaneMgr()->PostCommit(token_.crtc_id, !ret);
   drm_mgr_->GetCrtcMgr()->PostCommit(token_.crtc_id, !ret);
-  drmModeAtomicSetCursor(drm_atomic_req_, 0);
+  DRMBackend::Get()->AtomicSetCursor(drm_atomic_req_, 0);
 
   return ret;
 }
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "drm_fake_backend.h"
+#include "drm_manager.h"
+using namespace testing;
+using sde_drm::DRMAtomicReqInterface;
+using sde_drm::DRMBackend;
+using sde_drm::DRMDisplayToken;
+using sde_drm::DRMDisplayType;
+using sde_drm::DRMFakeBackend;
+using sde_drm::DRMManagerInterface;
+using sde_drm::DRMOps;
+using sde_drm::DRMPlanesInfo;
+using sde_drm::DRMRect;
+
+extern "C" int GetDRMManager(int fd, DRMManagerInterface **intf);
+extern "C" int DestroyDRMManager();
+
+namespace {
+
+// A command mode panel on one CRTC with a VIG and a DMA plane, carrying every property a plane
+// commit and a plane unset touch.
+const char kTopology[] = R"({
+  "crtcs": [
+    { "properties": { "ACTIVE": 0, "MODE_ID": { "type": "blob" }, "output_fence": 0,
+                      "capabilities": "max_blendstages=11\nqseed_type=qseed3\n" } } ],
+  "encoders": [ { "type": 2, "possible_crtcs": 1 } ],
+  "connectors": [
+    { "type": 16, "encoder": 0,
+      "modes": [ { "name": "1080x2400", "clock": 340000, "hdisplay": 1080, "vdisplay": 2400,
+                   "htotal": 1200, "vtotal": 2500, "vrefresh": 120 } ],
+      "properties": { "CRTC_ID": 0, "RETIRE_FENCE": 0,
+                      "capabilities": "display type=primary\npanel name=fake\npanel mode=command\n"
+      } } ],
+  "planes": [
+    { "possible_crtcs": 1, "formats": [ "AR24", "NV12" ],
+      "properties": { "CRTC_ID": 0, "FB_ID": 0, "SRC_X": 0, "SRC_Y": 0, "SRC_W": 0, "SRC_H": 0,
+                      "CRTC_X": 0, "CRTC_Y": 0, "CRTC_W": 0, "CRTC_H": 0, "alpha": 0,
+                      "excl_rect_v1": 0, "zpos": { "min": 0, "max": 255 },
+                      "csc_v1": { "type": "blob" }, "scaler_v2": { "type": "blob" },
+                      "capabilities": "max_linewidth=4096\npipe_idx=0\n" } },
+    { "possible_crtcs": 1, "formats": [ "AR24" ],
+      "properties": { "CRTC_ID": 0, "FB_ID": 0, "SRC_X": 0, "SRC_Y": 0, "SRC_W": 0, "SRC_H": 0,
+                      "CRTC_X": 0, "CRTC_Y": 0, "CRTC_W": 0, "CRTC_H": 0, "alpha": 0,
+                      "excl_rect_v1": 0, "zpos": { "min": 0, "max": 255 },
+                      "capabilities": "max_linewidth=2560\npipe_idx=1\n" } }
+  ]
+})";
+
+class DRMAtomicReqTestCases : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Goes through a file like a topology dumped from a device would.
+    std::string path = TempDir() + "drm_topology_XXXXXX";
+    int fd = mkstemp(&path[0]);
+    ASSERT_THAT(fd, Ge(0));
+    close(fd);
+    std::ofstream(path) << kTopology;
+    int ret = fake_.LoadTopologyFile(path);
+    unlink(path.c_str());
+    ASSERT_THAT(ret, Eq(0));
+
+    DRMBackend::Set(&fake_);
+    ASSERT_THAT(GetDRMManager(0, &manager_), Eq(0));
+    manager_->GetPlanesInfo(&planes_);
+    ASSERT_THAT(planes_.size(), Eq(2u));
+    ASSERT_THAT(manager_->RegisterDisplay(DRMDisplayType::PERIPHERAL, &token_), Eq(0));
+    ASSERT_THAT(manager_->GetConnectorInfo(token_.conn_id, &connector_), Eq(0));
+    ASSERT_THAT(connector_.modes.size(), Eq(1u));
+    ASSERT_THAT(manager_->CreateAtomicReq(token_, &atomic_), Eq(0));
+  }
+
+  void TearDown() override {
+    if (atomic_) {
+      manager_->DestroyAtomicReq(atomic_);
+    }
+    if (manager_) {
+      manager_->UnregisterDisplay(&token_);
+      DestroyDRMManager();
+    }
+    DRMBackend::Set(nullptr);
+  }
+
+  // Stages a mode set and a full screen layer on the first plane.
+  void StageFrame(uint32_t fb_id) {
+    atomic_->Perform(DRMOps::CRTC_SET_MODE, token_.crtc_id, &connector_.modes[0].mode);
+    atomic_->Perform(DRMOps::CRTC_SET_ACTIVE, token_.crtc_id, 1);
+    atomic_->Perform(DRMOps::CONNECTOR_SET_CRTC, token_.conn_id, token_.crtc_id);
+
+    uint32_t plane_id = planes_[0].first;
+    DRMRect rect = {0, 0, 1080, 2400};
+    atomic_->Perform(DRMOps::PLANE_SET_SRC_RECT, plane_id, rect);
+    atomic_->Perform(DRMOps::PLANE_SET_DST_RECT, plane_id, rect);
+    atomic_->Perform(DRMOps::PLANE_SET_ZORDER, plane_id, 1);
+    atomic_->Perform(DRMOps::PLANE_SET_ALPHA, plane_id, 0xff);
+    atomic_->Perform(DRMOps::PLANE_SET_FB_ID, plane_id, fb_id);
+    atomic_->Perform(DRMOps::PLANE_SET_CRTC, plane_id, token_.crtc_id);
+  }
+
+  uint64_t GetValue(uint32_t object_id, const std::string &name) {
+    uint64_t value = UINT64_MAX;
+    EXPECT_THAT(fake_.GetPropertyValue(object_id, name, &value), Eq(0));
+    return value;
+  }
+
+  DRMFakeBackend fake_;
+  DRMManagerInterface *manager_ = nullptr;
+  DRMPlanesInfo planes_;
+  DRMDisplayToken token_ = {};
+  sde_drm::DRMConnectorInfo connector_ = {};
+  DRMAtomicReqInterface *atomic_ = nullptr;
+};
+
+}  // namespace
+
+TEST_F(DRMAtomicReqTestCases, InitFindsTopology) {
+  EXPECT_THAT(planes_[0].second.type, Eq(sde_drm::DRMPlaneType::VIG));
+  EXPECT_THAT(planes_[1].second.type, Eq(sde_drm::DRMPlaneType::DMA));
+  EXPECT_THAT(planes_[0].second.max_linewidth, Eq(4096u));
+  EXPECT_THAT(connector_.panel_name, Eq("fake"));
+  EXPECT_THAT(connector_.modes[0].mode.vrefresh, Eq(120u));
+}
+
+TEST_F(DRMAtomicReqTestCases, ValidateIsTestOnly) {
+  StageFrame(42);
+  ASSERT_THAT(atomic_->Validate(), Eq(0));
+
+  DRMFakeBackend::Stats stats;
+  fake_.GetStats(&stats);
+  EXPECT_THAT(stats.test_commits, Eq(1u));
+  EXPECT_THAT(stats.commits, Eq(0u));
+  EXPECT_THAT(stats.rejected, Eq(0u));
+  // Nothing may be applied by a TEST_ONLY commit.
+  EXPECT_THAT(GetValue(planes_[0].first, "FB_ID"), Eq(0u));
+  EXPECT_THAT(GetValue(token_.crtc_id, "ACTIVE"), Eq(0u));
+}
+
+TEST_F(DRMAtomicReqTestCases, CommitAppliesAndSignalsFences) {
+  StageFrame(42);
+  int64_t release_fence = -1;
+  int64_t retire_fence = -1;
+  atomic_->Perform(DRMOps::CRTC_GET_RELEASE_FENCE, token_.crtc_id, &release_fence);
+  atomic_->Perform(DRMOps::CONNECTOR_GET_RETIRE_FENCE, token_.conn_id, &retire_fence);
+  ASSERT_THAT(atomic_->Commit(false /* synchronous */, false /* retain_planes */), Eq(0));
+
+  DRMFakeBackend::Stats stats;
+  fake_.GetStats(&stats);
+  EXPECT_THAT(stats.commits, Eq(1u));
+  EXPECT_THAT(stats.rejected, Eq(0u));
+  EXPECT_THAT(stats.properties_set, Gt(0u));
+
+  uint32_t plane_id = planes_[0].first;
+  EXPECT_THAT(GetValue(plane_id, "FB_ID"), Eq(42u));
+  EXPECT_THAT(GetValue(plane_id, "CRTC_ID"), Eq(token_.crtc_id));
+  EXPECT_THAT(GetValue(plane_id, "SRC_W"), Eq(1080u << 16));
+  EXPECT_THAT(GetValue(plane_id, "CRTC_H"), Eq(2400u));
+  EXPECT_THAT(GetValue(token_.crtc_id, "ACTIVE"), Eq(1u));
+  EXPECT_THAT(GetValue(token_.conn_id, "CRTC_ID"), Eq(token_.crtc_id));
+  // The unused plane was never staged.
+  EXPECT_THAT(GetValue(planes_[1].first, "FB_ID"), Eq(0u));
+
+  ASSERT_THAT(release_fence, Ge(0));
+  ASSERT_THAT(retire_fence, Ge(0));
+  close(static_cast<int>(release_fence));
+  close(static_cast<int>(retire_fence));
+}
+
+TEST_F(DRMAtomicReqTestCases, NextCommitReplacesPlane) {
+  StageFrame(42);
+  ASSERT_THAT(atomic_->Commit(true /* synchronous */, false /* retain_planes */), Eq(0));
+  StageFrame(43);
+  ASSERT_THAT(atomic_->Commit(true /* synchronous */, false /* retain_planes */), Eq(0));
+  EXPECT_THAT(GetValue(planes_[0].first, "FB_ID"), Eq(43u));
+
+  // A commit without staged planes unsets the ones of the previous frame.
+  ASSERT_THAT(atomic_->Commit(true /* synchronous */, false /* retain_planes */), Eq(0));
+  EXPECT_THAT(GetValue(planes_[0].first, "FB_ID"), Eq(0u));
+  EXPECT_THAT(GetValue(planes_[0].first, "CRTC_ID"), Eq(0u));
+}
+
+TEST_F(DRMAtomicReqTestCases, CommitErrorIsReturned) {
+  StageFrame(42);
+  fake_.SetCommitError(-EBUSY);
+  EXPECT_THAT(atomic_->Validate(), Ne(0));
+  EXPECT_THAT(atomic_->Commit(true /* synchronous */, false /* retain_planes */), Ne(0));
+  EXPECT_THAT(GetValue(planes_[0].first, "FB_ID"), Eq(0u));
+
+  fake_.SetCommitError(0);
+  StageFrame(42);
+  EXPECT_THAT(atomic_->Commit(true /* synchronous */, false /* retain_planes */), Eq(0));
+
+  DRMFakeBackend::Stats stats;
+  fake_.GetStats(&stats);
+  EXPECT_THAT(stats.rejected, Eq(2u));
+  EXPECT_THAT(GetValue(planes_[0].first, "FB_ID"), Eq(42u));
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <atomic>
+
+#include "drm_backend.h"
+
+namespace sde_drm {
+
+class DRMLibBackend : public DRMBackend {
+ public:
+  int SetClientCap(int fd, uint64_t capability, uint64_t value) override {
+    return drmSetClientCap(fd, capability, value);
+  }
+  int Ioctl(int fd, unsigned long request, void *arg) override {
+    return drmIoctl(fd, request, arg);
+  }
+
+  drmModeResPtr GetResources(int fd) override { return drmModeGetResources(fd); }
+  drmModePlaneResPtr GetPlaneResources(int fd) override { return drmModeGetPlaneResources(fd); }
+  drmModePlanePtr GetPlane(int fd, uint32_t plane_id) override {
+    return drmModeGetPlane(fd, plane_id);
+  }
+  drmModeCrtcPtr GetCrtc(int fd, uint32_t crtc_id) override { return drmModeGetCrtc(fd, crtc_id); }
+  drmModeEncoderPtr GetEncoder(int fd, uint32_t encoder_id) override {
+    return drmModeGetEncoder(fd, encoder_id);
+  }
+  drmModeConnectorPtr GetConnector(int fd, uint32_t connector_id) override {
+    return drmModeGetConnector(fd, connector_id);
+  }
+
+  drmModeObjectPropertiesPtr GetObjectProperties(int fd, uint32_t object_id,
+                                                 uint32_t object_type) override {
+    return drmModeObjectGetProperties(fd, object_id, object_type);
+  }
+  drmModePropertyPtr GetProperty(int fd, uint32_t property_id) override {
+    return drmModeGetProperty(fd, property_id);
+  }
+  drmModePropertyBlobPtr GetPropertyBlob(int fd, uint32_t blob_id) override {
+    return drmModeGetPropertyBlob(fd, blob_id);
+  }
+  int CreatePropertyBlob(int fd, const void *data, size_t size, uint32_t *blob_id) override {
+    return drmModeCreatePropertyBlob(fd, data, size, blob_id);
+  }
+  int DestroyPropertyBlob(int fd, uint32_t blob_id) override {
+    return drmModeDestroyPropertyBlob(fd, blob_id);
+  }
+
+  drmModeAtomicReqPtr AtomicAlloc() override { return drmModeAtomicAlloc(); }
+  void AtomicFree(drmModeAtomicReqPtr req) override { drmModeAtomicFree(req); }
+  int AtomicAddProperty(drmModeAtomicReqPtr req, uint32_t object_id, uint32_t property_id,
+                        uint64_t value) override {
+    return drmModeAtomicAddProperty(req, object_id, property_id, value);
+  }
+  void AtomicSetCursor(drmModeAtomicReqPtr req, int cursor) override {
+    drmModeAtomicSetCursor(req, cursor);
+  }
+  int AtomicCommit(int fd, drmModeAtomicReqPtr req, uint32_t flags, void *user_data) override {
+    return drmModeAtomicCommit(fd, req, flags, user_data);
+  }
+};
+
+static DRMLibBackend s_lib_backend;
+static std::atomic<DRMBackend *> s_backend {&s_lib_backend};
+
+DRMBackend *DRMBackend::Get() {
+  return s_backend.load(std::memory_order_acquire);
+}
+
+void DRMBackend::Set(DRMBackend *backend) {
+  s_backend.store(backend ? backend : &s_lib_backend, std::memory_order_release);
+}
+
+}  // namespace sde_drm
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __DRM_BACKEND_H__
+#define __DRM_BACKEND_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+
+namespace sde_drm {
+
+// Every call sde-drm makes into the DRM device goes through DRMBackend, the default one forwards
+// to libdrm. A different backend, e.g. an in-memory fake, can be installed with Set() before the
+// DRMManager is created so that sde-drm runs without a KMS device.
+//
+// Objects returned by the Get* calls must be compatible with the libdrm drmModeFree* functions,
+// which release them with free(). Atomic requests are only handed to the backend that allocated
+// them.
+class DRMBackend {
+ public:
+  virtual ~DRMBackend() {}
+
+  static DRMBackend *Get();
+  // nullptr restores the libdrm backend.
+  static void Set(DRMBackend *backend);
+
+  virtual int SetClientCap(int fd, uint64_t capability, uint64_t value) = 0;
+  virtual int Ioctl(int fd, unsigned long request, void *arg) = 0;
+
+  virtual drmModeResPtr GetResources(int fd) = 0;
+  virtual drmModePlaneResPtr GetPlaneResources(int fd) = 0;
+  virtual drmModePlanePtr GetPlane(int fd, uint32_t plane_id) = 0;
+  virtual drmModeCrtcPtr GetCrtc(int fd, uint32_t crtc_id) = 0;
+  virtual drmModeEncoderPtr GetEncoder(int fd, uint32_t encoder_id) = 0;
+  virtual drmModeConnectorPtr GetConnector(int fd, uint32_t connector_id) = 0;
+
+  virtual drmModeObjectPropertiesPtr GetObjectProperties(int fd, uint32_t object_id,
+                                                         uint32_t object_type) = 0;
+  virtual drmModePropertyPtr GetProperty(int fd, uint32_t property_id) = 0;
+  virtual drmModePropertyBlobPtr GetPropertyBlob(int fd, uint32_t blob_id) = 0;
+  virtual int CreatePropertyBlob(int fd, const void *data, size_t size, uint32_t *blob_id) = 0;
+  virtual int DestroyPropertyBlob(int fd, uint32_t blob_id) = 0;
+
+  virtual drmModeAtomicReqPtr AtomicAlloc() = 0;
+  virtual void AtomicFree(drmModeAtomicReqPtr req) = 0;
+  virtual int AtomicAddProperty(drmModeAtomicReqPtr req, uint32_t object_id, uint32_t property_id,
+                                uint64_t value) = 0;
+  virtual void AtomicSetCursor(drmModeAtomicReqPtr req, int cursor) = 0;
+  virtual int AtomicCommit(int fd, drmModeAtomicReqPtr req, uint32_t flags, void *user_data) = 0;
+};
+
+}  // namespace sde_drm
+
+#endif  // __DRM_BACKEND_H__
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+#include <drm_logger.h>
+#include <errno.h>
+#include <string.h>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "drm_backend.h"
+#include "drm_blob_cache.h"
+
+#define __CLASS__ "DRMBlobCache"
+
+using std::lock_guard;
+using std::mutex;
+
+namespace sde_drm {
+
+DRMBlobCache *DRMBlobCache::GetInstance() {
+  static DRMBlobCache s_instance;
+  return &s_instance;
+}
+
+DRMBlobCache::DRMBlobCache() {
+}
+
+void DRMBlobCache::SetMaxIdleBytes(size_t max_idle_bytes) {
+  lock_guard<mutex> lock(lock_);
+  max_idle_bytes_ = max_idle_bytes;
+  Trim(max_idle_bytes_);
+}
+
+DRMBlobCache::EntryKey DRMBlobCache::GetKey(int fd, uint32_t blob_id) {
+  return (static_cast<uint64_t>(static_cast<uint32_t>(fd)) << 32) | blob_id;
+}
+
+uint64_t DRMBlobCache::Hash(int fd, const uint8_t *data, size_t size) {
+  // FNV-1a, seeded with fd and size so that equal hashes are rare outside of equal payloads.
+  uint64_t hash = 14695981039346656037ULL;
+  hash = (hash ^ static_cast<uint32_t>(fd)) * 1099511628211ULL;
+  hash = (hash ^ size) * 1099511628211ULL;
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ data[i]) * 1099511628211ULL;
+  }
+
+  return hash;
+}
+
+int DRMBlobCache::Acquire(int fd, const void *data, size_t size, uint32_t *blob_id) {
+  if (!data || !blob_id) {
+    return -EINVAL;
+  }
+
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  uint64_t hash = Hash(fd, bytes, size);
+
+  lock_guard<mutex> lock(lock_);
+  auto range = by_hash_.equal_range(hash);
+  for (auto it = range.first; it != range.second; it++) {
+    Entry &entry = entries_.at(it->second);
+    if (entry.fd != fd || entry.data.size() != size ||
+        (size && memcmp(entry.data.data(), bytes, size))) {
+      continue;
+    }
+
+    if (!entry.refs) {
+      idle_.erase(entry.idle_pos);
+      stats_.idle_bytes -= size;
+    }
+    entry.refs++;
+    stats_.reused++;
+    *blob_id = entry.blob_id;
+    return 0;
+  }
+
+  uint32_t id = 0;
+  int ret = DRMBackend::Get()->CreatePropertyBlob(fd, data, size, &id);
+  if (ret || !id) {
+    DRM_LOGE("failed to create property blob ret %d, blob_id = %d", ret, id);
+    return ret ? ret : -EINVAL;
+  }
+
+  EntryKey key = GetKey(fd, id);
+  Entry &entry = entries_[key];
+  entry.fd = fd;
+  entry.blob_id = id;
+  entry.hash = hash;
+  entry.data.assign(bytes, bytes + size);
+  entry.refs = 1;
+  by_hash_.emplace(hash, key);
+  stats_.created++;
+  *blob_id = id;
+
+  return 0;
+}
+
+void DRMBlobCache::Release(int fd, uint32_t blob_id) {
+  lock_guard<mutex> lock(lock_);
+  auto it = entries_.find(GetKey(fd, blob_id));
+  if (it == entries_.end() || !it->second.refs) {
+    DRM_LOGE("Release of unknown blob %u", blob_id);
+    return;
+  }
+
+  Entry &entry = it->second;
+  if (--entry.refs) {
+    return;
+  }
+
+  idle_.push_front(it->first);
+  entry.idle_pos = idle_.begin();
+  stats_.idle_bytes += entry.data.size();
+  Trim(max_idle_bytes_);
+}
+
+void DRMBlobCache::Purge(int fd) {
+  lock_guard<mutex> lock(lock_);
+  for (auto pos = idle_.begin(); pos != idle_.end();) {
+    auto it = entries_.find(*pos);
+    pos++;
+    if (it->second.fd == fd) {
+      Erase(it);
+    }
+  }
+}
+
+void DRMBlobCache::Trim(size_t max_idle_bytes) {
+  while (stats_.idle_bytes > max_idle_bytes && !idle_.empty()) {
+    Erase(entries_.find(idle_.back()));
+    stats_.evicted++;
+  }
+}
+
+// Only called on idle entries, blobs still referenced by a property are never destroyed here.
+void DRMBlobCache::Erase(std::unordered_map<EntryKey, Entry>::iterator it) {
+  Entry &entry = it->second;
+  int ret = DRMBackend::Get()->DestroyPropertyBlob(entry.fd, entry.blob_id);
+  if (ret) {
+    DRM_LOGE("failed to destroy property blob %u, ret = %d", entry.blob_id, ret);
+  }
+
+  auto range = by_hash_.equal_range(entry.hash);
+  for (auto hash_it = range.first; hash_it != range.second; hash_it++) {
+    if (hash_it->second == it->first) {
+      by_hash_.erase(hash_it);
+      break;
+    }
+  }
+
+  idle_.erase(entry.idle_pos);
+  stats_.idle_bytes -= entry.data.size();
+  stats_.destroyed++;
+  entries_.erase(it);
+}
+
+void DRMBlobCache::GetStats(Stats *stats) {
+  lock_guard<mutex> lock(lock_);
+  *stats = stats_;
+  stats->entries = entries_.size();
+}
+
+void DRMBlobCache::Dump() {
+  Stats stats;
+  GetStats(&stats);
+  DRM_LOGI("PP blobs: %zu held, %zu idle bytes, created %llu, reused %llu, evicted %llu",
+           stats.entries, stats.idle_bytes, static_cast<unsigned long long>(stats.created),
+           static_cast<unsigned long long>(stats.reused),
+           static_cast<unsigned long long>(stats.evicted));
+}
+
+}  // namespace sde_drm
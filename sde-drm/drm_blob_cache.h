@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __DRM_BLOB_CACHE_H__
+#define __DRM_BLOB_CACHE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Upper bound in bytes of payload held by blobs that are no longer referenced by any property.
+#ifndef SDE_DRM_BLOB_CACHE_BYTES
+#define SDE_DRM_BLOB_CACHE_BYTES (1024 * 1024)
+#endif
+
+namespace sde_drm {
+
+// Property blobs are immutable, so one blob can back any number of properties with the same
+// payload. DRMBlobCache hands out blob ids by payload content and refcounts them, recently
+// released blobs are kept around in LRU order until SDE_DRM_BLOB_CACHE_BYTES is exceeded.
+// Blobs are created and destroyed through DRMBackend::Get().
+class DRMBlobCache {
+ public:
+  struct Stats {
+    uint64_t created = 0;    // blobs created in the driver
+    uint64_t reused = 0;     // creations avoided by handing out an existing blob
+    uint64_t destroyed = 0;  // blobs destroyed, including evictions
+    uint64_t evicted = 0;    // idle blobs dropped to stay within the memory cap
+    size_t entries = 0;      // blobs currently held
+    size_t idle_bytes = 0;   // payload bytes of blobs with no reference
+  };
+
+  static DRMBlobCache *GetInstance();
+  void SetMaxIdleBytes(size_t max_idle_bytes);
+
+  // Returns a blob holding data in blob_id, every successful call needs a matching Release().
+  // Empty payloads are passed on to the driver like any other, which decides whether to reject
+  // them.
+  int Acquire(int fd, const void *data, size_t size, uint32_t *blob_id);
+  void Release(int fd, uint32_t blob_id);
+  // Destroys all idle blobs of fd, used before the fd goes away.
+  void Purge(int fd);
+  void GetStats(Stats *stats);
+  void Dump();
+
+ private:
+  typedef uint64_t EntryKey;  // fd in the upper, blob id in the lower half
+
+  struct Entry {
+    int fd = -1;
+    uint32_t blob_id = 0;
+    uint64_t hash = 0;
+    std::vector<uint8_t> data;
+    uint32_t refs = 0;
+    std::list<EntryKey>::iterator idle_pos;
+  };
+
+  DRMBlobCache();
+  static EntryKey GetKey(int fd, uint32_t blob_id);
+  static uint64_t Hash(int fd, const uint8_t *data, size_t size);
+  void Trim(size_t max_idle_bytes);
+  void Erase(std::unordered_map<EntryKey, Entry>::iterator it);
+
+  std::mutex lock_;
+  size_t max_idle_bytes_ = SDE_DRM_BLOB_CACHE_BYTES;
+  std::unordered_map<EntryKey, Entry> entries_;
+  std::unordered_multimap<uint64_t, EntryKey> by_hash_;
+  std::list<EntryKey> idle_;  // most recently released first
+  Stats stats_;
+};
+
+}  // namespace sde_drm
+
+#endif  // __DRM_BLOB_CACHE_H__
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "drm_blob_cache.h"
+#include "drm_fake_backend.h"
+using namespace testing;
+using sde_drm::DRMBackend;
+using sde_drm::DRMBlobCache;
+using sde_drm::DRMFakeBackend;
+
+namespace {
+
+// Counts the blob calls reaching the driver.
+class CountingBackend : public DRMFakeBackend {
+ public:
+  int CreatePropertyBlob(int fd, const void *data, size_t size, uint32_t *blob_id) override {
+    creates++;
+    return DRMFakeBackend::CreatePropertyBlob(fd, data, size, blob_id);
+  }
+  int DestroyPropertyBlob(int fd, uint32_t blob_id) override {
+    destroys++;
+    return DRMFakeBackend::DestroyPropertyBlob(fd, blob_id);
+  }
+
+  int creates = 0;
+  int destroys = 0;
+};
+
+// Installs a fresh backend and, since the cache is process wide, gives every test its own fd
+// and drops its idle blobs afterwards.
+class DRMBlobCacheTestCases : public Test {
+ protected:
+  void SetUp() override {
+    DRMBackend::Set(&backend_);
+    cache_->SetMaxIdleBytes(SDE_DRM_BLOB_CACHE_BYTES);
+    fd_ = next_fd_++;
+  }
+  void TearDown() override {
+    cache_->Purge(fd_);
+    cache_->Purge(fd_ + 1000);
+    cache_->SetMaxIdleBytes(SDE_DRM_BLOB_CACHE_BYTES);
+    DRMBackend::Set(nullptr);
+  }
+
+  size_t BlobsInDriver() {
+    DRMFakeBackend::Stats stats;
+    backend_.GetStats(&stats);
+    return stats.blobs;
+  }
+
+  uint32_t Acquire(const std::string &payload, int fd = -1) {
+    uint32_t blob_id = 0;
+    EXPECT_THAT(cache_->Acquire(fd < 0 ? fd_ : fd, payload.data(), payload.size(), &blob_id),
+                Eq(0));
+    return blob_id;
+  }
+
+  static int next_fd_;
+  CountingBackend backend_;
+  DRMBlobCache *cache_ = DRMBlobCache::GetInstance();
+  int fd_ = 0;
+};
+
+int DRMBlobCacheTestCases::next_fd_ = 100;
+
+}  // namespace
+
+TEST_F(DRMBlobCacheTestCases, SharesBlobsByContent) {
+  uint32_t a = Acquire("gamut table a");
+  EXPECT_THAT(Acquire("gamut table a"), Eq(a));
+  uint32_t b = Acquire("gamut table b");
+  EXPECT_THAT(b, Ne(a));
+  // Blobs belong to an fd, another fd gets its own.
+  uint32_t other_fd = Acquire("gamut table a", fd_ + 1000);
+  EXPECT_THAT(other_fd, Ne(a));
+  EXPECT_THAT(backend_.creates, Eq(3));
+  EXPECT_THAT(BlobsInDriver(), Eq(3u));
+
+  // Still referenced once, so the blob stays.
+  cache_->Release(fd_, a);
+  EXPECT_THAT(Acquire("gamut table a"), Eq(a));
+  EXPECT_THAT(backend_.creates, Eq(3));
+
+  for (uint32_t blob_id : {a, a, b}) {
+    cache_->Release(fd_, blob_id);
+  }
+  cache_->Release(fd_ + 1000, other_fd);
+  EXPECT_THAT(backend_.destroys, Eq(0));
+}
+
+TEST_F(DRMBlobCacheTestCases, IdleBlobsAreReusedThenEvictedInLRUOrder) {
+  const std::string payloads[] = {"payload 0", "payload 1", "payload 2", "payload 3"};
+  cache_->SetMaxIdleBytes(3 * payloads[0].size());
+
+  uint32_t ids[4];
+  for (int i = 0; i < 4; i++) {
+    ids[i] = Acquire(payloads[i]);
+  }
+  for (int i = 0; i < 4; i++) {
+    cache_->Release(fd_, ids[i]);
+  }
+  // Only three fit, the least recently released went.
+  EXPECT_THAT(backend_.destroys, Eq(1));
+  EXPECT_THAT(BlobsInDriver(), Eq(3u));
+
+  EXPECT_THAT(Acquire(payloads[3]), Eq(ids[3]));
+  EXPECT_THAT(Acquire(payloads[1]), Eq(ids[1]));
+  EXPECT_THAT(backend_.creates, Eq(4));
+  uint32_t recreated = Acquire(payloads[0]);
+  EXPECT_THAT(backend_.creates, Eq(5));
+
+  for (uint32_t blob_id : {ids[3], ids[1], recreated}) {
+    cache_->Release(fd_, blob_id);
+  }
+}
+
+TEST_F(DRMBlobCacheTestCases, ReferencedBlobsAreNeverEvicted) {
+  cache_->SetMaxIdleBytes(0);
+  uint32_t held = Acquire("held");
+  uint32_t dropped = Acquire("dropped");
+  cache_->Release(fd_, dropped);
+  EXPECT_THAT(backend_.destroys, Eq(1));
+
+  cache_->SetMaxIdleBytes(0);
+  EXPECT_THAT(Acquire("held"), Eq(held));
+  EXPECT_THAT(backend_.destroys, Eq(1));
+  cache_->Release(fd_, held);
+  cache_->Release(fd_, held);
+  EXPECT_THAT(backend_.destroys, Eq(2));
+  EXPECT_THAT(BlobsInDriver(), Eq(0u));
+}
+
+TEST_F(DRMBlobCacheTestCases, PurgeDropsIdleBlobsOfOneFd) {
+  uint32_t held = Acquire("held");
+  cache_->Release(fd_, Acquire("idle"));
+  cache_->Release(fd_ + 1000, Acquire("idle", fd_ + 1000));
+  EXPECT_THAT(BlobsInDriver(), Eq(3u));
+
+  cache_->Purge(fd_);
+  EXPECT_THAT(BlobsInDriver(), Eq(2u));
+  cache_->Purge(fd_ + 1000);
+  EXPECT_THAT(BlobsInDriver(), Eq(1u));
+  cache_->Release(fd_, held);
+}
+
+TEST_F(DRMBlobCacheTestCases, EmptyPayloadsReachTheDriver) {
+  uint32_t blob_id = 0;
+  const char payload[] = "x";
+  // The driver, like the fake backend, rejects empty blobs. The cache passes its error on.
+  EXPECT_THAT(cache_->Acquire(fd_, payload, 0, &blob_id), Eq(-EINVAL));
+  EXPECT_THAT(backend_.creates, Eq(1));
+  EXPECT_THAT(cache_->Acquire(fd_, nullptr, 4, &blob_id), Eq(-EINVAL));
+  EXPECT_THAT(backend_.creates, Eq(1));
+
+  DRMBlobCache::Stats before, after;
+  cache_->GetStats(&before);
+  cache_->Release(fd_, 12345);
+  cache_->GetStats(&after);
+  EXPECT_THAT(after.destroyed, Eq(before.destroyed));
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "drm_connector.h"
+#include "drm_utils.h"
+
+// Feeds arbitrary bytes to the blob line reader and the mode_properties parser. The first byte
+// picks how many modes the connector has, the rest is the blob.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  if (!size) {
+    return 0;
+  }
+
+  size_t modes = data[0] % 16;
+  data++;
+  size--;
+
+  sde_drm::DRMBlobLineReader reader(data, size);
+  sde_drm::DRMBlobToken line = {};
+  sde_drm::DRMBlobToken word = {};
+  int64_t value = 0;
+  while (reader.Next(&line)) {
+    while (sde_drm::DRMBlobLineReader::NextWord(&line, &word)) {
+      word.ToInt(&value);
+    }
+  }
+
+  sde_drm::DRMConnectorInfo info = {};
+  info.modes.resize(modes);
+  sde_drm::DRMConnector::ParseModeProperties(data, size, &info);
+
+  return 0;
+}
@@ -79,6 +79,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <inttypes.h>
 
 #include "drm_utils.h"
+#include "drm_backend.h"
 #include "drm_property.h"
 #include "drm_connector.h"
 
@@ -126,7 +127,11 @@ static uint8_t DRM_MODE_COLORIMETRY_BT2020_YCC         = 10;
 static uint8_t DRM_MODE_COLORIMETRY_DCI_P3_RGB_D65     = 11;
 static uint8_t DRM_MODE_COLORIMETRY_DCI_P3_RGB_THEATER = 12;
 
+// Connectors may be parsed concurrently, see DRMConnectorManager::Init
+static mutex s_populate_lock;
+
 static void PopulatePowerModes(drmModePropertyRes *prop) {
+  lock_guard<mutex> lock(s_populate_lock);
   for (auto i = 0; i < prop->count_enums; i++) {
     string enum_name(prop->enums[i].name);
     if (enum_name == "ON") {
@@ -142,6 +147,7 @@ static void PopulatePowerModes(drmModePropertyRes *prop) {
 }
 
 static void PopulateSecureModes(drmModePropertyRes *prop) {
+  lock_guard<mutex> lock(s_populate_lock);
   for (auto i = 0; i < prop->count_enums; i++) {
     string enum_name(prop->enums[i].name);
     if (enum_name == "non_sec") {
@@ -153,6 +159,7 @@ static void PopulateSecureModes(drmModePropertyRes *prop) {
 }
 
 static void PopulateSupportedColorspaces(drmModePropertyRes *prop) {
+  lock_guard<mutex> lock(s_populate_lock);
   for (auto i = 0; i < prop->count_enums; i++) {
     string enum_name(prop->enums[i].name);
     if (enum_name == "Default") {
@@ -185,23 +192,24 @@ static void PopulateSupportedColorspaces(drmModePropertyRes *prop) {
   }
 }
 
-static DRMTopology GetTopologyEnum(const string &topology) {
-  if (topology == "sde_singlepipe") return DRMTopology::SINGLE_LM;
-  if (topology == "sde_singlepipe_dsc") return DRMTopology::SINGLE_LM_DSC;
-  if (topology == "sde_dualpipe") return DRMTopology::DUAL_LM;
-  if (topology == "sde_dualpipe_dsc") return DRMTopology::DUAL_LM_DSC;
-  if (topology == "sde_dualpipemerge") return DRMTopology::DUAL_LM_MERGE;
-  if (topology == "sde_dualpipemerge_dsc") return DRMTopology::DUAL_LM_MERGE_DSC;
-  if (topology == "sde_dualpipe_dscmerge") return DRMTopology::DUAL_LM_DSCMERGE;
-  if (topology == "sde_quadpipemerge") return DRMTopology::QUAD_LM_MERGE;
-  if (topology == "sde_quadpipe_dscmerge") return DRMTopology::QUAD_LM_DSCMERGE;
-  if (topology == "sde_quadpipe_3dmerge_dsc") return DRMTopology::QUAD_LM_MERGE_DSC;
-  if (topology == "sde_quadpipe_dsc4hsmerge") return DRMTopology::QUAD_LM_DSC4HSMERGE;
-  if (topology == "sde_ppsplit") return DRMTopology::PPSPLIT;
+static DRMTopology GetTopologyEnum(const DRMBlobToken &topology) {
+  if (topology.Equals("sde_singlepipe")) return DRMTopology::SINGLE_LM;
+  if (topology.Equals("sde_singlepipe_dsc")) return DRMTopology::SINGLE_LM_DSC;
+  if (topology.Equals("sde_dualpipe")) return DRMTopology::DUAL_LM;
+  if (topology.Equals("sde_dualpipe_dsc")) return DRMTopology::DUAL_LM_DSC;
+  if (topology.Equals("sde_dualpipemerge")) return DRMTopology::DUAL_LM_MERGE;
+  if (topology.Equals("sde_dualpipemerge_dsc")) return DRMTopology::DUAL_LM_MERGE_DSC;
+  if (topology.Equals("sde_dualpipe_dscmerge")) return DRMTopology::DUAL_LM_DSCMERGE;
+  if (topology.Equals("sde_quadpipemerge")) return DRMTopology::QUAD_LM_MERGE;
+  if (topology.Equals("sde_quadpipe_dscmerge")) return DRMTopology::QUAD_LM_DSCMERGE;
+  if (topology.Equals("sde_quadpipe_3dmerge_dsc")) return DRMTopology::QUAD_LM_MERGE_DSC;
+  if (topology.Equals("sde_quadpipe_dsc4hsmerge")) return DRMTopology::QUAD_LM_DSC4HSMERGE;
+  if (topology.Equals("sde_ppsplit")) return DRMTopology::PPSPLIT;
   return DRMTopology::UNKNOWN;
 }
 
 static void PopulateQsyncModes(drmModePropertyRes *prop) {
+  lock_guard<mutex> lock(s_populate_lock);
   for (auto i = 0; i < prop->count_enums; i++) {
     string enum_name(prop->enums[i].name);
     if (enum_name == "none") {
@@ -215,6 +223,7 @@ static void PopulateQsyncModes(drmModePropertyRes *prop) {
 }
 
 static void PopulateFrameTriggerModes(drmModePropertyRes *prop) {
+  lock_guard<mutex> lock(s_populate_lock);
   for (auto i = 0; i < prop->count_enums; i++) {
     string enum_name(prop->enums[i].name);
     if (enum_name == "default") {
@@ -280,39 +289,54 @@ static int32_t GetColorspace(DRMColorspace drm_colorspace) {
 
 void DRMConnectorManager::Init(drmModeRes *resource) {
   lock_guard<mutex> lock(lock_);
-  for (int i = 0; i < resource->count_connectors; i++) {
+  // Parse connectors concurrently and merge them afterwards in enumeration order.
+  vector<unique_ptr<DRMConnector>> connectors(resource->count_connectors);
+  ParallelFor(connectors.size(), GetInitThreads(), [&](size_t i) {
     unique_ptr<DRMConnector> conn(new DRMConnector(fd_));
-    drmModeConnector *libdrm_conn = drmModeGetConnector(fd_, resource->connectors[i]);
+    drmModeConnector *libdrm_conn = DRMBackend::Get()->GetConnector(fd_, resource->connectors[i]);
     if (libdrm_conn) {
       conn->InitAndParse(libdrm_conn);
-      connector_pool_[resource->connectors[i]] = std::move(conn);
+      connectors[i] = std::move(conn);
     } else {
       DRM_LOGE("Critical error: drmModeGetConnector() failed for connector %u.",
                resource->connectors[i]);
     }
+  });
+
+  for (size_t i = 0; i < connectors.size(); i++) {
+    if (connectors[i]) {
+      connector_pool_[resource->connectors[i]] = std::move(connectors[i]);
+    }
   }
 }
 
-static inline vector<uint64_t> GetBitClkRates(const string &bitclk_rates) {
-  stringstream line(bitclk_rates);
-  string bitclk_rate {};
+static inline vector<uint64_t> GetBitClkRates(DRMBlobToken bitclk_rates) {
+  DRMBlobToken bitclk_rate {};
   vector<uint64_t> dyn_bitclk_list {};
+  int64_t value = 0;
 
-  DRM_LOGI("Setting dynamic bitclk list: %s", bitclk_rates.c_str());
-  while (line >> bitclk_rate) {
-    dyn_bitclk_list.push_back(std::stoi(bitclk_rate));
+  DRM_LOGI("Setting dynamic bitclk list: %.*s", static_cast<int>(bitclk_rates.length),
+           bitclk_rates.data);
+  while (DRMBlobLineReader::NextWord(&bitclk_rates, &bitclk_rate)) {
+    if (!bitclk_rate.ToInt(&value)) {
+      break;
+    }
+    dyn_bitclk_list.push_back(static_cast<uint64_t>(value));
   }
   return dyn_bitclk_list;
 }
 
-static inline vector<uint32_t> GetFpValues(const string &fp_list) {
-  stringstream line(fp_list);
-  string fp {};
+static inline vector<uint32_t> GetFpValues(DRMBlobToken fp_list) {
+  DRMBlobToken fp {};
   vector<uint32_t> dyn_fp_list {};
+  int64_t value = 0;
 
-  DRM_LOGI("Setting dynamic fp list: %s", fp_list.c_str());
-  while (line >> fp) {
-    dyn_fp_list.emplace_back(std::stoi(fp));
+  DRM_LOGI("Setting dynamic fp list: %.*s", static_cast<int>(fp_list.length), fp_list.data);
+  while (DRMBlobLineReader::NextWord(&fp_list, &fp)) {
+    if (!fp.ToInt(&value)) {
+      break;
+    }
+    dyn_fp_list.emplace_back(static_cast<uint32_t>(value));
   }
 
   return dyn_fp_list;
@@ -320,7 +344,7 @@ static inline vector<uint32_t> GetFpValues(const string &fp_list) {
 
 void DRMConnectorManager::Update() {
   lock_guard<mutex> lock(lock_);
-  drmModeRes *resource = drmModeGetResources(fd_);
+  drmModeRes *resource = DRMBackend::Get()->GetResources(fd_);
 
   if (NULL == resource) {
     DRM_LOGE("drmModeGetResources() failed. Connector status not updated.");
@@ -334,6 +358,7 @@ void DRMConnectorManager::Update() {
   }
 
   // Delete connectors in connector pool.
+  bool removed = false;
   for (auto conn = connector_pool_.cbegin(); conn != connector_pool_.cend();) {
     auto drmconn = drm_connectors.find(conn->first);
     if (drmconn == drm_connectors.end()) {
@@ -341,6 +366,7 @@ void DRMConnectorManager::Update() {
       if (conn->second->GetStatus() == DRMStatus::FREE) {
         DRM_LOGD("Removing connector id %u from pool.", conn->first);
         conn = connector_pool_.erase(conn);
+        removed = true;
       } else {
         // Physically removed DRM Connectors (displays) first go to disconnected state. When its
         // reserved resources are freed up, they are removed from the driver's connector list. Do
@@ -355,11 +381,19 @@ void DRMConnectorManager::Update() {
     }
   }
 
+  // A changed connector list means a hotplug event, force the remaining connectors to parse
+  // their info again.
+  if (!drm_connectors.empty() || removed) {
+    for (auto &conn : connector_pool_) {
+      conn.second->InvalidateInfo();
+    }
+  }
+
   // Add new connectors in connector pool.
   for (auto &drmconn : drm_connectors) {
     DRM_LOGD("Adding connector id %u to pool.", drmconn.first);
     unique_ptr<DRMConnector> conn(new DRMConnector(fd_));
-    drmModeConnector *libdrm_conn = drmModeGetConnector(fd_, drmconn.first);
+    drmModeConnector *libdrm_conn = DRMBackend::Get()->GetConnector(fd_, drmconn.first);
     if (libdrm_conn) {
       conn->InitAndParse(libdrm_conn);
       conn->SetSkipConnectorReload(true);
@@ -576,14 +610,15 @@ DRMConnector::~DRMConnector() {
 
 void DRMConnector::ParseProperties() {
   drmModeObjectProperties *props =
-      drmModeObjectGetProperties(fd_, drm_connector_->connector_id, DRM_MODE_OBJECT_CONNECTOR);
+      DRMBackend::Get()->GetObjectProperties(fd_, drm_connector_->connector_id,
+                                             DRM_MODE_OBJECT_CONNECTOR);
   if (!props || !props->props || !props->prop_values) {
     drmModeFreeObjectProperties(props);
     return;
   }
 
   for (uint32_t j = 0; j < props->count_props; j++) {
-    drmModePropertyRes *info = drmModeGetProperty(fd_, props->props[j]);
+    drmModePropertyRes *info = DRMBackend::Get()->GetProperty(fd_, props->props[j]);
     if (!info) {
       continue;
     }
@@ -617,7 +652,7 @@ void DRMConnector::ParseProperties() {
 }
 
 void DRMConnector::ParseCapabilities(uint64_t blob_id, DRMConnectorInfo *info) {
-  drmModePropertyBlobRes *blob = drmModeGetPropertyBlob(fd_, blob_id);
+  drmModePropertyBlobRes *blob = DRMBackend::Get()->GetPropertyBlob(fd_, blob_id);
   if (!blob) {
     return;
   }
@@ -695,7 +730,7 @@ void DRMConnector::ParseCapabilities(uint64_t blob_id, DRMConnectorInfo *info) {
 }
 
 void DRMConnector::ParseCapabilities(uint64_t blob_id, drm_panel_hdr_properties *hdr_info) {
-  drmModePropertyBlobRes *blob = drmModeGetPropertyBlob(fd_, blob_id);
+  drmModePropertyBlobRes *blob = DRMBackend::Get()->GetPropertyBlob(fd_, blob_id);
   if (!blob) {
     return;
   }
@@ -714,62 +749,73 @@ void DRMConnector::ParseCapabilities(uint64_t blob_id, drm_panel_hdr_properties
 }
 
 void DRMConnector::ParseModeProperties(uint64_t blob_id, DRMConnectorInfo *info) {
-  drmModePropertyBlobRes *blob = drmModeGetPropertyBlob(fd_, blob_id);
+  drmModePropertyBlobRes *blob = DRMBackend::Get()->GetPropertyBlob(fd_, blob_id);
   if (!blob) {
     return;
   }
 
-  if (!info->modes.size()) {
-    return;
-  }
-
-  if (!blob->data) {
+  if (!info->modes.size() || !blob->data) {
+    drmModeFreePropertyBlob(blob);
     return;
   }
 
   DRM_LOGI("Obtain modes for conn %d", info->type_id);
+  ParseModeProperties(blob->data, blob->length, info);
+  drmModeFreePropertyBlob(blob);
+}
 
-  char *fmt_str = new char[blob->length + 1];
-  memcpy (fmt_str, blob->data, blob->length);
-  fmt_str[blob->length] = '\0';
-  stringstream stream(fmt_str);
-  DRM_LOGI("stream str %s len %zu blob str %s len %d", stream.str().c_str(), stream.str().length(),
-           static_cast<const char *>(blob->data), blob->length);
+void DRMConnector::ParseModeProperties(const void *data, size_t length, DRMConnectorInfo *info) {
+  if (!info->modes.size() || !data) {
+    return;
+  }
 
-  string line = {};
-  const string mode_name = "mode_name=";
-  const string topology = "topology=";
-  const string pu_num_roi = "partial_update_num_roi=";
-  const string pu_xstart = "partial_update_xstart=";
-  const string pu_ystart = "partial_update_ystart=";
-  const string pu_walign = "partial_update_walign=";
-  const string pu_halign = "partial_update_halign=";
-  const string pu_wmin = "partial_update_wmin=";
-  const string pu_hmin = "partial_update_hmin=";
-  const string pu_roimerge = "partial_update_roimerge=";
-  const string bit_clk_rate = "bit_clk_rate=";
-  const string mdp_transfer_time_us = "mdp_transfer_time_us=";
-  const string allowed_mode_switch = "allowed_mode_switch=";
-  const string panel_mode_caps = "panel_mode_capabilities=";
-  const string has_cwb_crop = "has_cwb_crop=";
-  const string has_dedicated_cwb_support = "has_dedicated_cwb_support=";
-  const string dyn_bitclk_list = "dyn_bitclk_list=";
-  const string dyn_fp_list = "dyn_fp_list=";
-  const string dyn_fp_type = "dyn_fp_type=";
+  // Keys are matched anywhere in the line and in this order, as the stringstream based parser
+  // did. Note "submode_idx=" also matches "preferred_submode_idx=" lines.
+  static constexpr DRMBlobToken mode_name = BlobKey("mode_name=");
+  static constexpr DRMBlobToken topology = BlobKey("topology=");
+  static constexpr DRMBlobToken pu_num_roi = BlobKey("partial_update_num_roi=");
+  static constexpr DRMBlobToken pu_xstart = BlobKey("partial_update_xstart=");
+  static constexpr DRMBlobToken pu_ystart = BlobKey("partial_update_ystart=");
+  static constexpr DRMBlobToken pu_walign = BlobKey("partial_update_walign=");
+  static constexpr DRMBlobToken pu_halign = BlobKey("partial_update_halign=");
+  static constexpr DRMBlobToken pu_wmin = BlobKey("partial_update_wmin=");
+  static constexpr DRMBlobToken pu_hmin = BlobKey("partial_update_hmin=");
+  static constexpr DRMBlobToken pu_roimerge = BlobKey("partial_update_roimerge=");
+  static constexpr DRMBlobToken bit_clk_rate = BlobKey("bit_clk_rate=");
+  static constexpr DRMBlobToken mdp_transfer_time_us = BlobKey("mdp_transfer_time_us=");
+  static constexpr DRMBlobToken allowed_mode_switch = BlobKey("allowed_mode_switch=");
+  static constexpr DRMBlobToken panel_mode_caps = BlobKey("panel_mode_capabilities=");
+  static constexpr DRMBlobToken has_cwb_crop = BlobKey("has_cwb_crop=");
+  static constexpr DRMBlobToken has_dedicated_cwb_support = BlobKey("has_dedicated_cwb_support=");
+  static constexpr DRMBlobToken dyn_bitclk_list = BlobKey("dyn_bitclk_list=");
+  static constexpr DRMBlobToken dyn_fp_list = BlobKey("dyn_fp_list=");
+  static constexpr DRMBlobToken dyn_fp_type = BlobKey("dyn_fp_type=");
   // TODO(user): Add support for dyn_pclk_list
-  const string submode_string = "submode_idx=";
-  const string compression_mode = "dsc_mode=";
-  const string preferred_submode_string = "preferred_submode_idx=";
-  const string qsync_min_fps = "qsync_min_fps=";
+  static constexpr DRMBlobToken submode_string = BlobKey("submode_idx=");
+  static constexpr DRMBlobToken compression_mode = BlobKey("dsc_mode=");
+  static constexpr DRMBlobToken preferred_submode_string = BlobKey("preferred_submode_idx=");
+  static constexpr DRMBlobToken qsync_min_fps = BlobKey("qsync_min_fps=");
 
   DRMModeInfo *mode_item = &info->modes.at(0);
   DRMSubModeInfo *submode_item = NULL;
   unsigned int index = 0;
   unsigned int submode_index = 0;
+  auto current_submode = [&]() {
+    if (!submode_item) {
+      DRMSubModeInfo submode = {};
+      mode_item->sub_modes.push_back(submode);
+      submode_item = &mode_item->sub_modes.at(submode_index++);
+      submode_index = 0;
+    }
+    return submode_item;
+  };
 
-  while (std::getline(stream, line)) {
-    if (line.find(mode_name) != string::npos) {
-      string name(line, mode_name.length());
+  DRMBlobLineReader reader(data, length);
+  DRMBlobToken line = {};
+  int64_t value = 0;
+
+  while (reader.Next(&line)) {
+    if (line.Contains(mode_name)) {
       if (index >= info->modes.size()) {
         break;
       }
@@ -777,89 +823,99 @@ void DRMConnector::ParseModeProperties(uint64_t blob_id, DRMConnectorInfo *info)
       mode_item = &info->modes.at(index++);
       submode_item = NULL;
       submode_index = 0;
-    } else if (line.find(submode_string) != string::npos) {
-      string submode_idx(line, submode_string.length());
+    } else if (line.Contains(submode_string)) {
       DRMSubModeInfo submode = {};
       mode_item->sub_modes.push_back(submode);
       submode_item = &mode_item->sub_modes.at(submode_index++);
-    } else if (line.find(preferred_submode_string) != string::npos) {
-      mode_item->curr_submode_index =
-                 std::stoi(string(line, preferred_submode_string.length()));
-    } else if (line.find(topology) != string::npos) {
-      if (!submode_item) {
-        DRMSubModeInfo submode = {};
-        mode_item->sub_modes.push_back(submode);
-        submode_item = &mode_item->sub_modes.at(submode_index++);
-        submode_index = 0;
+    } else if (line.Contains(preferred_submode_string)) {
+      if (line.Suffix(preferred_submode_string.length).ToInt(&value)) {
+        mode_item->curr_submode_index = static_cast<uint32_t>(value);
+      }
+    } else if (line.Contains(topology)) {
+      current_submode()->topology = GetTopologyEnum(line.Suffix(topology.length));
+    } else if (line.Contains(pu_num_roi)) {
+      if (line.Suffix(pu_num_roi.length).ToInt(&value)) {
+        mode_item->num_roi = static_cast<int>(value);
+      }
+    } else if (line.Contains(pu_xstart)) {
+      if (line.Suffix(pu_xstart.length).ToInt(&value)) {
+        mode_item->xstart = static_cast<int>(value);
       }
-      submode_item->topology = GetTopologyEnum(string(line, topology.length()));
-    } else if (line.find(pu_num_roi) != string::npos) {
-      mode_item->num_roi = std::stoi(string(line, pu_num_roi.length()));
-    } else if (line.find(pu_xstart) != string::npos) {
-      mode_item->xstart = std::stoi(string(line, pu_xstart.length()));
-    } else if (line.find(pu_ystart) != string::npos) {
-      mode_item->ystart = std::stoi(string(line, pu_ystart.length()));
-    } else if (line.find(pu_walign) != string::npos) {
-      mode_item->walign = std::stoi(string(line, pu_walign.length()));
-    } else if (line.find(pu_halign) != string::npos) {
-      mode_item->halign = std::stoi(string(line, pu_halign.length()));
-    } else if (line.find(pu_wmin) != string::npos) {
-      mode_item->wmin = std::stoi(string(line, pu_wmin.length()));
-    } else if (line.find(pu_hmin) != string::npos) {
-      mode_item->hmin = std::stoi(string(line, pu_hmin.length()));
-    } else if (line.find(pu_roimerge) != string::npos) {
-      mode_item->roi_merge = std::stoi(string(line, pu_roimerge.length()));
-    } else if (line.find(bit_clk_rate) != string::npos) {
-      mode_item->default_bit_clk_rate = std::stoi(string(line, bit_clk_rate.length()));
-      mode_item->curr_bit_clk_rate = std::stoi(string(line, bit_clk_rate.length()));
-    } else if (line.find(mdp_transfer_time_us) != string::npos) {
-      mode_item->transfer_time_us = std::stoi(string(line, mdp_transfer_time_us.length()));
-    } else if (line.find(allowed_mode_switch) != string::npos) {
-      mode_item->allowed_mode_switch = std::stol(string(line, allowed_mode_switch.length()));
-    } else if (line.find(panel_mode_caps) != string::npos) {
-      if (!submode_item) {
-        DRMSubModeInfo submode = {};
-        mode_item->sub_modes.push_back(submode);
-        submode_item = &mode_item->sub_modes.at(submode_index++);
-        submode_index = 0;
+    } else if (line.Contains(pu_ystart)) {
+      if (line.Suffix(pu_ystart.length).ToInt(&value)) {
+        mode_item->ystart = static_cast<int>(value);
       }
-      submode_item->panel_mode_caps = std::stoi(string(line, panel_mode_caps.length()));
-    } else if (line.find(has_cwb_crop) != string::npos) {
-      mode_item->has_cwb_crop = std::stoi(string(line, has_cwb_crop.length()));
-    } else if (line.find(has_dedicated_cwb_support) != string::npos) {
-      mode_item->has_dedicated_cwb = std::stoi(string(line, has_dedicated_cwb_support.length()));
-    } else if (line.find(dyn_bitclk_list) != string::npos) {
-      if (!submode_item) {
-        DRMSubModeInfo submode = {};
-        mode_item->sub_modes.push_back(submode);
-        submode_item = &mode_item->sub_modes.at(submode_index++);
-        submode_index = 0;
+    } else if (line.Contains(pu_walign)) {
+      if (line.Suffix(pu_walign.length).ToInt(&value)) {
+        mode_item->walign = static_cast<int>(value);
       }
-      submode_item->dyn_bitclk_list = GetBitClkRates(string(line, dyn_bitclk_list.length()));
-    } else if (line.find(dyn_fp_type) != string::npos) {
-      string type(line, dyn_fp_type.length());
-      if (type == "vfp") {
+    } else if (line.Contains(pu_halign)) {
+      if (line.Suffix(pu_halign.length).ToInt(&value)) {
+        mode_item->halign = static_cast<int>(value);
+      }
+    } else if (line.Contains(pu_wmin)) {
+      if (line.Suffix(pu_wmin.length).ToInt(&value)) {
+        mode_item->wmin = static_cast<int>(value);
+      }
+    } else if (line.Contains(pu_hmin)) {
+      if (line.Suffix(pu_hmin.length).ToInt(&value)) {
+        mode_item->hmin = static_cast<int>(value);
+      }
+    } else if (line.Contains(pu_roimerge)) {
+      if (line.Suffix(pu_roimerge.length).ToInt(&value)) {
+        mode_item->roi_merge = (value != 0);
+      }
+    } else if (line.Contains(bit_clk_rate)) {
+      if (line.Suffix(bit_clk_rate.length).ToInt(&value)) {
+        mode_item->default_bit_clk_rate = static_cast<uint64_t>(value);
+        mode_item->curr_bit_clk_rate = static_cast<uint64_t>(value);
+      }
+    } else if (line.Contains(mdp_transfer_time_us)) {
+      if (line.Suffix(mdp_transfer_time_us.length).ToInt(&value)) {
+        mode_item->transfer_time_us = static_cast<uint32_t>(value);
+      }
+    } else if (line.Contains(allowed_mode_switch)) {
+      if (line.Suffix(allowed_mode_switch.length).ToInt(&value)) {
+        mode_item->allowed_mode_switch = static_cast<uint64_t>(value);
+      }
+    } else if (line.Contains(panel_mode_caps)) {
+      DRMSubModeInfo *submode = current_submode();
+      if (line.Suffix(panel_mode_caps.length).ToInt(&value)) {
+        submode->panel_mode_caps = static_cast<uint32_t>(value);
+      }
+    } else if (line.Contains(has_cwb_crop)) {
+      if (line.Suffix(has_cwb_crop.length).ToInt(&value)) {
+        mode_item->has_cwb_crop = static_cast<uint32_t>(value);
+      }
+    } else if (line.Contains(has_dedicated_cwb_support)) {
+      if (line.Suffix(has_dedicated_cwb_support.length).ToInt(&value)) {
+        mode_item->has_dedicated_cwb = static_cast<uint32_t>(value);
+      }
+    } else if (line.Contains(dyn_bitclk_list)) {
+      current_submode()->dyn_bitclk_list = GetBitClkRates(line.Suffix(dyn_bitclk_list.length));
+    } else if (line.Contains(dyn_fp_type)) {
+      DRMBlobToken type = line.Suffix(dyn_fp_type.length);
+      if (type.Equals("vfp")) {
         mode_item->fp_type = DynamicFrontPorchType::VERTICAL;
-      } else if (type == "hfp") {
+      } else if (type.Equals("hfp")) {
         mode_item->fp_type = DynamicFrontPorchType::HORIZONTAL;
-      } else if (type == "none") {
+      } else if (type.Equals("none")) {
         mode_item->fp_type = DynamicFrontPorchType::UNKNOWN;
-      } else if (!type.empty()) {
+      } else if (type.length) {
         mode_item->fp_type = DynamicFrontPorchType::UNKNOWN;
-        DRM_LOGE("Invalid dyn porch type: %s", type.c_str());
+        DRM_LOGE("Invalid dyn porch type: %.*s", static_cast<int>(type.length), type.data);
+      }
+    } else if (line.Contains(dyn_fp_list)) {
+      mode_item->dyn_fp_list = GetFpValues(line.Suffix(dyn_fp_list.length));
+    } else if (line.Contains(compression_mode)) {
+      DRMSubModeInfo *submode = current_submode();
+      if (line.Suffix(compression_mode.length).ToInt(&value)) {
+        submode->panel_compression_mode = static_cast<uint32_t>(value);
       }
-    } else if (line.find(dyn_fp_list) != string::npos) {
-      mode_item->dyn_fp_list = GetFpValues(string(line, dyn_fp_list.length()));
-    } else if (line.find(compression_mode) != string::npos) {
-      if (!submode_item) {
-        DRMSubModeInfo submode = {};
-        mode_item->sub_modes.push_back(submode);
-        submode_item = &mode_item->sub_modes.at(submode_index++);
-        submode_index = 0;
+    } else if (line.Contains(qsync_min_fps)) {
+      if (line.Suffix(qsync_min_fps.length).ToInt(&value)) {
+        mode_item->qsync_min_fps = static_cast<uint32_t>(value);
       }
-      submode_item->panel_compression_mode = std::stoi(string(line, compression_mode.length()));
-    } else if (line.find(qsync_min_fps) != string::npos) {
-      mode_item->qsync_min_fps = std::stoi(string(line, qsync_min_fps.length()));
     }
   }
 
@@ -870,13 +926,10 @@ void DRMConnector::ParseModeProperties(uint64_t blob_id, DRMConnectorInfo *info)
       mode_item->sub_modes.push_back(submode);
     }
   }
-
-  drmModeFreePropertyBlob(blob);
-  delete[] fmt_str;
 }
 
 void DRMConnector::ParseCapabilities(uint64_t blob_id, drm_msm_ext_hdr_properties *hdr_info) {
-  drmModePropertyBlobRes *blob = drmModeGetPropertyBlob(fd_, blob_id);
+  drmModePropertyBlobRes *blob = DRMBackend::Get()->GetPropertyBlob(fd_, blob_id);
   if (!blob) {
     return;
   }
@@ -902,7 +955,7 @@ void DRMConnector::ParseCapabilities(uint64_t blob_id, drm_msm_ext_hdr_propertie
 }
 
 void DRMConnector::ParseCapabilities(uint64_t blob_id, std::vector<uint8_t> *edid) {
-  drmModePropertyBlobRes *blob = drmModeGetPropertyBlob(fd_, blob_id);
+  drmModePropertyBlobRes *blob = DRMBackend::Get()->GetPropertyBlob(fd_, blob_id);
   if (!blob) {
     return;
   }
@@ -915,7 +968,7 @@ void DRMConnector::ParseCapabilities(uint64_t blob_id, std::vector<uint8_t> *edi
 }
 
 void DRMConnector::ParseCapabilities(uint64_t blob_id, uint64_t *panel_id) {
-  drmModePropertyBlobRes *blob = drmModeGetPropertyBlob(fd_, blob_id);
+  drmModePropertyBlobRes *blob = DRMBackend::Get()->GetPropertyBlob(fd_, blob_id);
   if (!blob) {
     return;
   }
@@ -944,7 +997,7 @@ int DRMConnector::GetInfo(DRMConnectorInfo *info) {
   if (!skip_connector_reload_ && (IsTVConnector(drm_connector_->connector_type)
       || (DRM_MODE_CONNECTOR_VIRTUAL == drm_connector_->connector_type))) {
     // Reload since for some connectors like Virtual and DP, modes may change.
-    drmModeConnectorPtr drm_connector = drmModeGetConnector(fd_, conn_id);
+    drmModeConnectorPtr drm_connector = DRMBackend::Get()->GetConnector(fd_, conn_id);
     if (!drm_connector) {
       // Connector resource not found. This could happen if a connector is removed before a commit
       // was done on it. Mark the connector as disconnected for graceful teardown. Update 'info'
@@ -953,6 +1006,7 @@ int DRMConnector::GetInfo(DRMConnectorInfo *info) {
       info->modes.clear();
       info->type = drm_connector_->connector_type;
       info->type_id = drm_connector_->connector_type_id;
+      info_cache_valid_ = false;
       DLOGW("Connector %u not found. Possibly removed.", conn_id);
       return 0;
     }
@@ -961,20 +1015,16 @@ int DRMConnector::GetInfo(DRMConnectorInfo *info) {
   }
 
   SetSkipConnectorReload(false);  // Reset skip_connector_reload_ setting.
-  info->modes.clear();
   if (!drm_connector_->count_modes) {
     DRM_LOGW("Zero modes on connector %u.", conn_id);
   }
 
-  for (auto i = 0; i < drm_connector_->count_modes; i++) {
-    DRMModeInfo modes_item {};
-    if (!drm_connector_->modes) {
-      DLOGW("Connector %u not found.", conn_id);
-      return 0;
-    }
-    modes_item.mode = drm_connector_->modes[i];
-    info->modes.push_back(modes_item);
+  if (drm_connector_->count_modes && !drm_connector_->modes) {
+    DLOGW("Connector %u not found.", conn_id);
+    info->modes.clear();
+    return 0;
   }
+
   info->mmWidth = drm_connector_->mmWidth;
   info->mmHeight = drm_connector_->mmHeight;
   info->type = drm_connector_->connector_type;
@@ -982,76 +1032,141 @@ int DRMConnector::GetInfo(DRMConnectorInfo *info) {
   info->is_connected = IsConnected();
 
   drmModeObjectProperties *props =
-      drmModeObjectGetProperties(fd_, drm_connector_->connector_id, DRM_MODE_OBJECT_CONNECTOR);
+      DRMBackend::Get()->GetObjectProperties(fd_, drm_connector_->connector_id,
+                                             DRM_MODE_OBJECT_CONNECTOR);
   if (!props || !props->props || !props->prop_values) {
     drmModeFreeObjectProperties(props);
+    PopulateModes(info);
+    info_cache_valid_ = false;
     return -ENODEV;
   }
 
-  uint32_t index = UINT32_MAX;
+  // Property blobs are immutable in the kernel, changed contents always come with a new blob id.
+  // Parsed info is therefore reused as long as the blob ids and the mode list are unchanged and no
+  // hotplug update has invalidated the connector since.
+  uint64_t blob_ids[kBlobMax] = {};
+  blob_ids[kBlobHdr] = GetPropertyValue(props, DRMProperty::HDR_PROPERTIES);
+  blob_ids[kBlobCaps] = GetPropertyValue(props, DRMProperty::CAPABILITIES);
+  blob_ids[kBlobModes] = GetPropertyValue(props, DRMProperty::MODE_PROPERTIES);
+  blob_ids[kBlobExtHdr] = GetPropertyValue(props, DRMProperty::EXT_HDR_PROPERTIES);
+  blob_ids[kBlobEdid] = GetPropertyValue(props, DRMProperty::EDID);
+  blob_ids[kBlobPanelId] = GetPropertyValue(props, DRMProperty::DEMURA_PANEL_ID);
+
+  if (IsInfoCacheValid(blob_ids)) {
+    info->modes = cached_info_.modes;
+    info->panel_hdr_prop = cached_info_.panel_hdr_prop;
+    info->ext_hdr_prop = cached_info_.ext_hdr_prop;
+    info->edid = cached_info_.edid;
+    info->panel_id = cached_info_.panel_id;
+    CopyCapabilities(cached_info_, info);
+    info_cache_hits_++;
+  } else {
+    PopulateModes(info);
+
+    if (blob_ids[kBlobHdr]) {
+      ParseCapabilities(blob_ids[kBlobHdr], &info->panel_hdr_prop);
+    }
+    if (blob_ids[kBlobCaps]) {
+      ParseCapabilities(blob_ids[kBlobCaps], info);
+    }
+    if (blob_ids[kBlobModes]) {
+      ParseModeProperties(blob_ids[kBlobModes], info);
+    }
+    if (blob_ids[kBlobExtHdr]) {
+      ParseCapabilities(blob_ids[kBlobExtHdr], &info->ext_hdr_prop);
+    }
+    if (prop_mgr_.IsPropertyAvailable(DRMProperty::EDID)) {
+      ParseCapabilities(blob_ids[kBlobEdid], &info->edid);
+    }
+    if (prop_mgr_.IsPropertyAvailable(DRMProperty::DEMURA_PANEL_ID)) {
+      ParseCapabilities(blob_ids[kBlobPanelId], &info->panel_id);
+    }
 
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::HDR_PROPERTIES)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::HDR_PROPERTIES)));
-    if (index < props->count_props)
-      ParseCapabilities(props->prop_values[index], &info->panel_hdr_prop);
+    cached_info_ = *info;
+    std::copy(blob_ids, blob_ids + kBlobMax, cached_blob_ids_);
+    cached_generation_ = generation_;
+    info_cache_valid_ = true;
+    info_cache_misses_++;
   }
 
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::CAPABILITIES)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::CAPABILITIES)));
-    if (index < props->count_props)
-      ParseCapabilities(props->prop_values[index], info);
+  if (prop_mgr_.IsPropertyAvailable(DRMProperty::TOPOLOGY_CONTROL)) {
+    info->topology_control = static_cast<uint32_t>(
+        GetPropertyValue(props, DRMProperty::TOPOLOGY_CONTROL));
   }
 
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::MODE_PROPERTIES)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::MODE_PROPERTIES)));
-    if (index < props->count_props)
-      ParseModeProperties(props->prop_values[index], info);
+  if (prop_mgr_.IsPropertyAvailable(DRMProperty::SUPPORTED_COLORSPACES)) {
+    info->supported_colorspaces = static_cast<uint32_t>(
+        GetPropertyValue(props, DRMProperty::SUPPORTED_COLORSPACES));
+  }
+
+  drmModeFreeObjectProperties(props);
+
+  return 0;
+}
+
+void DRMConnector::PopulateModes(DRMConnectorInfo *info) {
+  info->modes.clear();
+  info->modes.reserve(static_cast<size_t>(drm_connector_->count_modes));
+  for (auto i = 0; i < drm_connector_->count_modes; i++) {
+    DRMModeInfo modes_item {};
+    modes_item.mode = drm_connector_->modes[i];
+    info->modes.push_back(modes_item);
   }
+}
 
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::EXT_HDR_PROPERTIES)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::EXT_HDR_PROPERTIES)));
-    if (index < props->count_props)
-      ParseCapabilities(props->prop_values[index], &info->ext_hdr_prop);
+// Fields owned by the CAPABILITIES blob, see ParseCapabilities(uint64_t, DRMConnectorInfo *)
+void DRMConnector::CopyCapabilities(const DRMConnectorInfo &src, DRMConnectorInfo *dst) {
+  dst->formats_supported = src.formats_supported;
+  dst->max_linewidth = src.max_linewidth;
+  dst->is_primary = src.is_primary;
+  dst->panel_name = src.panel_name;
+  dst->panel_mode = src.panel_mode;
+  dst->dynamic_fps = src.dynamic_fps;
+  dst->panel_orientation = src.panel_orientation;
+  dst->qsync_support = src.qsync_support;
+  dst->qsync_fps = src.qsync_fps;
+  dst->is_wb_ubwc_supported = src.is_wb_ubwc_supported;
+  dst->dyn_bitclk_support = src.dyn_bitclk_support;
+  dst->has_cwb_dither = src.has_cwb_dither;
+  dst->max_os_brightness = src.max_os_brightness;
+  dst->max_panel_backlight = src.max_panel_backlight;
+}
+
+uint64_t DRMConnector::GetPropertyValue(drmModeObjectProperties *props, DRMProperty prop) {
+  if (!prop_mgr_.IsPropertyAvailable(prop)) {
+    return 0;
   }
 
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::TOPOLOGY_CONTROL)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::TOPOLOGY_CONTROL)));
-    info->topology_control = props->prop_values[index];
+  uint32_t prop_id = prop_mgr_.GetPropertyId(prop);
+  for (uint32_t i = 0; i < props->count_props; i++) {
+    if (props->props[i] == prop_id) {
+      return props->prop_values[i];
+    }
   }
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::EDID)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::EDID)));
-    ParseCapabilities(props->prop_values[index], &info->edid);
+
+  return 0;
+}
+
+bool DRMConnector::IsInfoCacheValid(const uint64_t *blob_ids) {
+  if (!info_cache_valid_ || cached_generation_ != generation_) {
+    return false;
   }
 
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::SUPPORTED_COLORSPACES)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::SUPPORTED_COLORSPACES)));
-    info->supported_colorspaces = props->prop_values[index];
+  if (!std::equal(blob_ids, blob_ids + kBlobMax, cached_blob_ids_)) {
+    return false;
   }
 
-  if (prop_mgr_.IsPropertyAvailable(DRMProperty::DEMURA_PANEL_ID)) {
-    index = std::distance(props->props,
-                          std::find(props->props, props->props + props->count_props,
-                                    prop_mgr_.GetPropertyId(DRMProperty::DEMURA_PANEL_ID)));
-    ParseCapabilities(props->prop_values[index], &info->panel_id);
+  if (cached_info_.modes.size() != static_cast<size_t>(drm_connector_->count_modes)) {
+    return false;
   }
 
-  drmModeFreeObjectProperties(props);
+  for (auto i = 0; i < drm_connector_->count_modes; i++) {
+    if (memcmp(&cached_info_.modes[i].mode, &drm_connector_->modes[i], sizeof(drmModeModeInfo))) {
+      return false;
+    }
+  }
 
-  return 0;
+  return true;
 }
 
 void DRMConnector::InitAndParse(drmModeConnector *conn) {
@@ -1067,7 +1182,8 @@ void DRMConnector::Perform(DRMOps code, drmModeAtomicReq *req, va_list args) {
   switch (code) {
     case DRMOps::CONNECTOR_SET_CRTC: {
       uint32_t crtc = va_arg(args, uint32_t);
-      drmModeAtomicAddProperty(req, obj_id, prop_mgr_.GetPropertyId(DRMProperty::CRTC_ID), crtc);
+      DRMBackend::Get()->AtomicAddProperty(req, obj_id,
+                                           prop_mgr_.GetPropertyId(DRMProperty::CRTC_ID), crtc);
       DRM_LOGD("Connector %d: Setting CRTC %d", obj_id, crtc);
     } break;
 
@@ -1075,7 +1191,7 @@ void DRMConnector::Perform(DRMOps code, drmModeAtomicReq *req, va_list args) {
       int64_t *fence = va_arg(args, int64_t *);
       *fence = -1;
       uint32_t prop_id = prop_mgr_.GetPropertyId(DRMProperty::RETIRE_FENCE);
-      drmModeAtomicAddProperty(req, obj_id, prop_id, reinterpret_cast<uint64_t>(fence));
+      DRMBackend::Get()->AtomicAddProperty(req, obj_id, prop_id, reinterpret_cast<uint64_t>(fence));
     } break;
 
     case DRMOps::CONNECTOR_SET_RETIRE_FENCE_OFFSET: {
@@ -1084,26 +1200,27 @@ void DRMConnector::Perform(DRMOps code, drmModeAtomicReq *req, va_list args) {
       }
       uint32_t offset = va_arg(args, uint32_t);
       uint32_t prop_id = prop_mgr_.GetPropertyId(DRMProperty::RETIRE_FENCE_OFFSET);
-      drmModeAtomicAddProperty(req, obj_id, prop_id, offset);
+      DRMBackend::Get()->AtomicAddProperty(req, obj_id, prop_id, offset);
     } break;
 
     case DRMOps::CONNECTOR_SET_OUTPUT_RECT: {
       DRMRect rect = va_arg(args, DRMRect);
-      drmModeAtomicAddProperty(req, obj_id,
-                               prop_mgr_.GetPropertyId(DRMProperty::DST_X), rect.left);
-      drmModeAtomicAddProperty(req, obj_id,
-                               prop_mgr_.GetPropertyId(DRMProperty::DST_Y), rect.top);
-      drmModeAtomicAddProperty(req, obj_id, prop_mgr_.GetPropertyId(DRMProperty::DST_W),
-                               rect.right - rect.left);
-      drmModeAtomicAddProperty(req, obj_id, prop_mgr_.GetPropertyId(DRMProperty::DST_H),
-                               rect.bottom - rect.top);
+      DRMBackend::Get()->AtomicAddProperty(req, obj_id,
+                                           prop_mgr_.GetPropertyId(DRMProperty::DST_X), rect.left);
+      DRMBackend::Get()->AtomicAddProperty(req, obj_id,
+                                           prop_mgr_.GetPropertyId(DRMProperty::DST_Y), rect.top);
+      DRMBackend::Get()->AtomicAddProperty(req, obj_id, prop_mgr_.GetPropertyId(DRMProperty::DST_W),
+                                           rect.right - rect.left);
+      DRMBackend::Get()->AtomicAddProperty(req, obj_id, prop_mgr_.GetPropertyId(DRMProperty::DST_H),
+                                           rect.bottom - rect.top);
       DRM_LOGD("Connector %d: Setting dst [x,y,w,h][%d,%d,%d,%d]", obj_id, rect.left,
                   rect.top, (rect.right - rect.left), (rect.bottom - rect.top));
     } break;
 
     case DRMOps::CONNECTOR_SET_OUTPUT_FB_ID: {
       uint32_t fb_id = va_arg(args, uint32_t);
-      drmModeAtomicAddProperty(req, obj_id, prop_mgr_.GetPropertyId(DRMProperty::FB_ID), fb_id);
+      DRMBackend::Get()->AtomicAddProperty(req, obj_id,
+                                           prop_mgr_.GetPropertyId(DRMProperty::FB_ID), fb_id);
       DRM_LOGD("Connector %d: Setting fb_id %d", obj_id, fb_id);
     } break;
 
@@ -1127,7 +1244,8 @@ void DRMConnector::Perform(DRMOps code, drmModeAtomicReq *req, va_list args) {
           DRM_LOGE("Invalid power mode %d to set on connector %d", drm_power_mode, obj_id);
           break;
       }
-      drmModeAtomicAddProperty(req, obj_id, prop_mgr_.GetPropertyId(DRMProperty::LP), power_mode);
+      DRMBackend::Get()->AtomicAddProperty(req, obj_id, prop_mgr_.GetPropertyId(DRMProperty::LP),
+                                           power_mode);
       DRM_LOGD("Connector %d: Setting power_mode %d", obj_id, power_mode);
     } break;
 
@@ -1139,17 +1257,17 @@ void DRMConnector::Perform(DRMOps code, drmModeAtomicReq *req, va_list args) {
 
     case DRMOps::CONNECTOR_SET_AUTOREFRESH: {
       uint32_t enable = va_arg(args, uint32_t);
-      drmModeAtomicAddProperty(req, obj_id, prop_mgr_.GetPropertyId(DRMProperty::AUTOREFRESH),
-                               enable);
+      DRMBackend::Get()->AtomicAddProperty(req, obj_id,
+                                           prop_mgr_.GetPropertyId(DRMProperty::AUTOREFRESH),
+                                           enable);
       DRM_LOGD("Connector %d: Setting autorefresh %d", obj_id, enable);
     } break;
 
     case DRMOps::CONNECTOR_SET_FB_SECURE_MODE: {
       int secure_mode = va_arg(args, int);
       uint32_t fb_secure_mode = (secure_mode == (int)DRMSecureMode::SECURE) ? SECURE : NON_SECURE;
-      drmModeAtomicAddProperty(req, obj_id,
-                               prop_mgr_.GetPropertyId(DRMProperty::FB_TRANSLATION_MODE),
-                               fb_secure_mode);
+      uint32_t prop_id = prop_mgr_.GetPropertyId(DRMProperty::FB_TRANSLATION_MODE);
+      DRMBackend::Get()->AtomicAddProperty(req, obj_id, prop_id, fb_secure_mode);
       DRM_LOGD("Connector %d: Setting FB secure mode %d", obj_id, fb_secure_mode);
     } break;
 
@@ -1161,8 +1279,9 @@ void DRMConnector::Perform(DRMOps code, drmModeAtomicReq *req, va_list args) {
 
     case DRMOps::CONNECTOR_SET_HDR_METADATA: {
       drm_msm_ext_hdr_metadata *hdr_metadata = va_arg(args, drm_msm_ext_hdr_metadata *);
-      drmModeAtomicAddProperty(req, obj_id, prop_mgr_.GetPropertyId(DRMProperty::HDR_METADATA),
-                               reinterpret_cast<uint64_t>(hdr_metadata));
+      DRMBackend::Get()->AtomicAddProperty(req, obj_id,
+                                           prop_mgr_.GetPropertyId(DRMProperty::HDR_METADATA),
+                                           reinterpret_cast<uint64_t>(hdr_metadata));
     } break;
 
     case DRMOps::CONNECTOR_SET_QSYNC_MODE: {
@@ -1171,15 +1290,17 @@ void DRMConnector::Perform(DRMOps code, drmModeAtomicReq *req, va_list args) {
       }
       int drm_qsync_mode = va_arg(args, int);
       uint32_t qsync_mode = static_cast<uint32_t>(drm_qsync_mode);
-      drmModeAtomicAddProperty(req, obj_id, prop_mgr_.GetPropertyId(DRMProperty::QSYNC_MODE),
-                               qsync_mode);
+      DRMBackend::Get()->AtomicAddProperty(req, obj_id,
+                                           prop_mgr_.GetPropertyId(DRMProperty::QSYNC_MODE),
+                                           qsync_mode);
       DRM_LOGD("Connector %d: Setting Qsync mode %d", obj_id, qsync_mode);
     } break;
 
     case DRMOps::CONNECTOR_SET_TOPOLOGY_CONTROL: {
       uint32_t topology_control = va_arg(args, uint32_t);
-      drmModeAtomicAddProperty(req, obj_id, prop_mgr_.GetPropertyId(DRMProperty::TOPOLOGY_CONTROL),
-                               topology_control);
+      DRMBackend::Get()->AtomicAddProperty(req, obj_id,
+                                           prop_mgr_.GetPropertyId(DRMProperty::TOPOLOGY_CONTROL),
+                                           topology_control);
     } break;
 
     case DRMOps::CONNECTOR_SET_FRAME_TRIGGER: {
@@ -1206,7 +1327,7 @@ void DRMConnector::Perform(DRMOps code, drmModeAtomicReq *req, va_list args) {
       }
       if (frame_trigger_mode >= 0) {
         uint32_t prop_id = prop_mgr_.GetPropertyId(DRMProperty::FRAME_TRIGGER);
-        int ret = drmModeAtomicAddProperty(req, obj_id, prop_id, frame_trigger_mode);
+        int ret = DRMBackend::Get()->AtomicAddProperty(req, obj_id, prop_id, frame_trigger_mode);
         if (ret < 0) {
           DRM_LOGE("AtomicAddProperty failed obj_id 0x%x, prop_id %d mode %d ret %d",
                    obj_id, prop_id, frame_trigger_mode, ret);
@@ -1225,7 +1346,7 @@ void DRMConnector::Perform(DRMOps code, drmModeAtomicReq *req, va_list args) {
       colorspace = GetColorspace(drm_colorspace);
       if (colorspace >= 0) {
         uint32_t prop_id = prop_mgr_.GetPropertyId(DRMProperty::COLORSPACE);
-        int ret = drmModeAtomicAddProperty(req, obj_id, prop_id, colorspace);
+        int ret = DRMBackend::Get()->AtomicAddProperty(req, obj_id, prop_id, colorspace);
         if (ret < 0) {
           DRM_LOGE("AtomicAddProperty failed obj_id 0x%x, prop_id %d mode %d ret %d",
                    obj_id, prop_id, colorspace, ret);
@@ -1242,8 +1363,9 @@ void DRMConnector::Perform(DRMOps code, drmModeAtomicReq *req, va_list args) {
         return;
       }
       uint32_t drm_panel_mode = va_arg(args, uint32_t);
-      drmModeAtomicAddProperty(req, obj_id, prop_mgr_.GetPropertyId(DRMProperty::PANEL_MODE),
-                               drm_panel_mode);
+      DRMBackend::Get()->AtomicAddProperty(req, obj_id,
+                                           prop_mgr_.GetPropertyId(DRMProperty::PANEL_MODE),
+                                           drm_panel_mode);
       DRM_LOGD("Connector %d: Setting Panel mode 0x%x", obj_id, drm_panel_mode);
     } break;
 
@@ -1253,7 +1375,7 @@ void DRMConnector::Perform(DRMOps code, drmModeAtomicReq *req, va_list args) {
       }
       uint64_t drm_bit_clk_rate = va_arg(args, uint64_t);
       uint32_t prop_id = prop_mgr_.GetPropertyId(DRMProperty::DYN_BIT_CLK);
-      int ret = drmModeAtomicAddProperty(req, obj_id, prop_id, drm_bit_clk_rate);
+      int ret = DRMBackend::Get()->AtomicAddProperty(req, obj_id, prop_id, drm_bit_clk_rate);
       if (ret < 0) {
         DRM_LOGE("AtomicAddProperty failed obj_id 0x%x, prop_id %d, bit_clk_rate %" PRIu64
                  " ret %d", obj_id, prop_id, drm_bit_clk_rate, ret);
@@ -1268,7 +1390,7 @@ void DRMConnector::Perform(DRMOps code, drmModeAtomicReq *req, va_list args) {
       }
       uint64_t drm_compression_mode = va_arg(args, uint32_t);
       uint32_t prop_id = prop_mgr_.GetPropertyId(DRMProperty::DSC_MODE);
-      int ret = drmModeAtomicAddProperty(req, obj_id, prop_id, drm_compression_mode);
+      int ret = DRMBackend::Get()->AtomicAddProperty(req, obj_id, prop_id, drm_compression_mode);
       if (ret < 0) {
         DRM_LOGE("AtomicAddProperty failed obj_id 0x%x, prop_id %d, compression_mode %d ret %d",
                  obj_id, prop_id, drm_compression_mode, ret);
@@ -1290,7 +1412,8 @@ void DRMConnector::SetROI(drmModeAtomicReq *req, uint32_t obj_id, uint32_t num_r
     return;
   }
   if (!num_roi || !conn_rois) {
-    drmModeAtomicAddProperty(req, obj_id, prop_mgr_.GetPropertyId(DRMProperty::ROI_V1), 0);
+    DRMBackend::Get()->AtomicAddProperty(req, obj_id,
+                                         prop_mgr_.GetPropertyId(DRMProperty::ROI_V1), 0);
     DRM_LOGD("Connector ROI is set to NULL to indicate full frame update");
     return;
   }
@@ -1306,8 +1429,8 @@ void DRMConnector::SetROI(drmModeAtomicReq *req, uint32_t obj_id, uint32_t num_r
     DRM_LOGD("Conn %d, ROI[l,t,b,r][%d %d %d %d]", obj_id,
              roi_v1_.roi[i].x1,roi_v1_.roi[i].y1,roi_v1_.roi[i].x2,roi_v1_.roi[i].y2);
   }
-  drmModeAtomicAddProperty(req, obj_id, prop_mgr_.GetPropertyId(DRMProperty::ROI_V1),
-                           reinterpret_cast<uint64_t>(&roi_v1_));
+  DRMBackend::Get()->AtomicAddProperty(req, obj_id, prop_mgr_.GetPropertyId(DRMProperty::ROI_V1),
+                                       reinterpret_cast<uint64_t>(&roi_v1_));
 #endif
 }
 
@@ -1344,6 +1467,8 @@ void DRMConnector::Dump() {
         drm_connector_->modes[i].vdisplay, drm_connector_->modes[i].vsync_start,
         drm_connector_->modes[i].vsync_end, drm_connector_->modes[i].vtotal);
   }
+  DRM_LOGE("Info cache: generation %u hits %" PRIu64 " misses %" PRIu64 "\n", generation_,
+           info_cache_hits_, info_cache_misses_);
 }
 
 }  // namespace sde_drm
@@ -62,7 +62,10 @@ class DRMConnector {
   int IsConnected() { return (DRM_MODE_CONNECTED == drm_connector_->connection); }
   int GetPossibleEncoders(std::set<uint32_t> *possible_encoders);
   void SetSkipConnectorReload(bool skip_reload) { skip_connector_reload_ = skip_reload; };
+  void InvalidateInfo() { generation_++; }
   void Dump();
+  // Parses a mode_properties blob into info->modes, which must already hold the connector modes.
+  static void ParseModeProperties(const void *data, size_t length, DRMConnectorInfo *info);
 
  private:
   void ParseProperties();
@@ -74,6 +77,13 @@ class DRMConnector {
   void ParseCapabilities(uint64_t blob_id, uint64_t *panel_id);
   void SetROI(drmModeAtomicReq *req, uint32_t obj_id, uint32_t num_roi,
               DRMRect *conn_rois);
+  void PopulateModes(DRMConnectorInfo *info);
+  void CopyCapabilities(const DRMConnectorInfo &src, DRMConnectorInfo *dst);
+  uint64_t GetPropertyValue(drmModeObjectProperties *props, DRMProperty prop);
+  bool IsInfoCacheValid(const uint64_t *blob_ids);
+
+  // Blob properties whose ids key the parsed connector info cache
+  enum InfoBlob { kBlobHdr, kBlobCaps, kBlobModes, kBlobExtHdr, kBlobEdid, kBlobPanelId, kBlobMax };
 
   int fd_ = -1;
   drmModeConnector *drm_connector_ = {};
@@ -81,6 +91,13 @@ class DRMConnector {
   bool skip_connector_reload_ = false; //  Usually set to true for new TV/pluggable displays.
   DRMStatus status_ = DRMStatus::FREE;
   std::unique_ptr<DRMPPManager> pp_mgr_{};
+  DRMConnectorInfo cached_info_ {};
+  uint64_t cached_blob_ids_[kBlobMax] = {};
+  uint32_t generation_ = 0;  // Bumped on hotplug updates
+  uint32_t cached_generation_ = 0;
+  bool info_cache_valid_ = false;
+  uint64_t info_cache_hits_ = 0;
+  uint64_t info_cache_misses_ = 0;
 #ifdef SDE_MAX_ROI_V1
   sde_drm_roi_v1 roi_v1_ {};
 #endif
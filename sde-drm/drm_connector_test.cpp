@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "drm_connector.h"
+using namespace testing;
+using sde_drm::DRMConnector;
+using sde_drm::DRMConnectorInfo;
+using sde_drm::DRMModeInfo;
+using sde_drm::DRMSubModeInfo;
+using sde_drm::DRMTopology;
+
+namespace {
+
+// The stringstream based parser ParseModeProperties replaced, kept as the reference for the
+// parsed result and the benchmark. Only fed well formed blobs, it throws on malformed numbers.
+DRMTopology ReferenceTopology(const std::string &topology) {
+  if (topology == "sde_singlepipe") return DRMTopology::SINGLE_LM;
+  if (topology == "sde_singlepipe_dsc") return DRMTopology::SINGLE_LM_DSC;
+  if (topology == "sde_dualpipe") return DRMTopology::DUAL_LM;
+  if (topology == "sde_dualpipe_dsc") return DRMTopology::DUAL_LM_DSC;
+  if (topology == "sde_dualpipemerge") return DRMTopology::DUAL_LM_MERGE;
+  if (topology == "sde_dualpipemerge_dsc") return DRMTopology::DUAL_LM_MERGE_DSC;
+  if (topology == "sde_dualpipe_dscmerge") return DRMTopology::DUAL_LM_DSCMERGE;
+  if (topology == "sde_quadpipemerge") return DRMTopology::QUAD_LM_MERGE;
+  if (topology == "sde_quadpipe_dscmerge") return DRMTopology::QUAD_LM_DSCMERGE;
+  if (topology == "sde_quadpipe_3dmerge_dsc") return DRMTopology::QUAD_LM_MERGE_DSC;
+  if (topology == "sde_quadpipe_dsc4hsmerge") return DRMTopology::QUAD_LM_DSC4HSMERGE;
+  if (topology == "sde_ppsplit") return DRMTopology::PPSPLIT;
+  return DRMTopology::UNKNOWN;
+}
+
+template <class T>
+std::vector<T> ReferenceList(const std::string &list) {
+  std::stringstream line(list);
+  std::string value {};
+  std::vector<T> values {};
+  while (line >> value) {
+    values.push_back(static_cast<T>(std::stoi(value)));
+  }
+  return values;
+}
+
+void ReferenceParse(const void *data, size_t length, DRMConnectorInfo *info) {
+  using std::string;
+  if (!info->modes.size() || !data) {
+    return;
+  }
+
+  char *fmt_str = new char[length + 1];
+  memcpy(fmt_str, data, length);
+  fmt_str[length] = '\0';
+  std::stringstream stream(fmt_str);
+
+  DRMModeInfo *mode_item = &info->modes.at(0);
+  DRMSubModeInfo *submode_item = NULL;
+  unsigned int index = 0;
+  unsigned int submode_index = 0;
+  auto current_submode = [&]() {
+    if (!submode_item) {
+      DRMSubModeInfo submode = {};
+      mode_item->sub_modes.push_back(submode);
+      submode_item = &mode_item->sub_modes.at(submode_index++);
+      submode_index = 0;
+    }
+    return submode_item;
+  };
+  auto value = [](const string &line, const string &key) {
+    return std::stoi(string(line, key.length()));
+  };
+
+  string line = {};
+  while (std::getline(stream, line)) {
+    auto has = [&line](const string &key) { return line.find(key) != string::npos; };
+    if (has("mode_name=")) {
+      if (index >= info->modes.size()) {
+        break;
+      }
+      mode_item = &info->modes.at(index++);
+      submode_item = NULL;
+      submode_index = 0;
+    } else if (has("submode_idx=")) {
+      DRMSubModeInfo submode = {};
+      mode_item->sub_modes.push_back(submode);
+      submode_item = &mode_item->sub_modes.at(submode_index++);
+    } else if (has("preferred_submode_idx=")) {
+      mode_item->curr_submode_index = value(line, "preferred_submode_idx=");
+    } else if (has("topology=")) {
+      current_submode()->topology = ReferenceTopology(string(line, strlen("topology=")));
+    } else if (has("partial_update_num_roi=")) {
+      mode_item->num_roi = value(line, "partial_update_num_roi=");
+    } else if (has("partial_update_xstart=")) {
+      mode_item->xstart = value(line, "partial_update_xstart=");
+    } else if (has("partial_update_ystart=")) {
+      mode_item->ystart = value(line, "partial_update_ystart=");
+    } else if (has("partial_update_walign=")) {
+      mode_item->walign = value(line, "partial_update_walign=");
+    } else if (has("partial_update_halign=")) {
+      mode_item->halign = value(line, "partial_update_halign=");
+    } else if (has("partial_update_wmin=")) {
+      mode_item->wmin = value(line, "partial_update_wmin=");
+    } else if (has("partial_update_hmin=")) {
+      mode_item->hmin = value(line, "partial_update_hmin=");
+    } else if (has("partial_update_roimerge=")) {
+      mode_item->roi_merge = value(line, "partial_update_roimerge=");
+    } else if (has("bit_clk_rate=")) {
+      mode_item->default_bit_clk_rate = value(line, "bit_clk_rate=");
+      mode_item->curr_bit_clk_rate = value(line, "bit_clk_rate=");
+    } else if (has("mdp_transfer_time_us=")) {
+      mode_item->transfer_time_us = value(line, "mdp_transfer_time_us=");
+    } else if (has("allowed_mode_switch=")) {
+      mode_item->allowed_mode_switch =
+          std::stol(string(line, strlen("allowed_mode_switch=")));
+    } else if (has("panel_mode_capabilities=")) {
+      current_submode()->panel_mode_caps = value(line, "panel_mode_capabilities=");
+    } else if (has("has_cwb_crop=")) {
+      mode_item->has_cwb_crop = value(line, "has_cwb_crop=");
+    } else if (has("has_dedicated_cwb_support=")) {
+      mode_item->has_dedicated_cwb = value(line, "has_dedicated_cwb_support=");
+    } else if (has("dyn_bitclk_list=")) {
+      current_submode()->dyn_bitclk_list =
+          ReferenceList<uint64_t>(string(line, strlen("dyn_bitclk_list=")));
+    } else if (has("dyn_fp_type=")) {
+      string type(line, strlen("dyn_fp_type="));
+      if (type == "vfp") {
+        mode_item->fp_type = sde_drm::DynamicFrontPorchType::VERTICAL;
+      } else if (type == "hfp") {
+        mode_item->fp_type = sde_drm::DynamicFrontPorchType::HORIZONTAL;
+      } else if (!type.empty()) {
+        // Also covers "none".
+        mode_item->fp_type = sde_drm::DynamicFrontPorchType::UNKNOWN;
+      }
+    } else if (has("dyn_fp_list=")) {
+      mode_item->dyn_fp_list = ReferenceList<uint32_t>(string(line, strlen("dyn_fp_list=")));
+    } else if (has("dsc_mode=")) {
+      current_submode()->panel_compression_mode = value(line, "dsc_mode=");
+    } else if (has("qsync_min_fps=")) {
+      mode_item->qsync_min_fps = value(line, "qsync_min_fps=");
+    }
+  }
+
+  for (auto &mode : info->modes) {
+    if (!mode.sub_modes.size()) {
+      mode.sub_modes.push_back(DRMSubModeInfo {});
+    }
+  }
+  delete[] fmt_str;
+}
+
+const char *kTopologies[] = {"sde_singlepipe", "sde_singlepipe_dsc", "sde_dualpipe",
+                             "sde_dualpipe_dsc", "sde_dualpipemerge", "sde_dualpipe_dscmerge",
+                             "sde_quadpipemerge", "sde_quadpipe_dscmerge", "sde_ppsplit",
+                             "unknown_topology"};
+
+// A mode_properties blob as the driver writes it for a command mode panel, with submodes on
+// every other mode.
+std::string MakeModeBlob(size_t modes, std::mt19937 *rng) {
+  std::stringstream blob;
+  auto random = [rng](uint32_t limit) { return (*rng)() % limit; };
+  for (size_t i = 0; i < modes; i++) {
+    blob << "mode_name=1080x2400x" << (60 + 30 * (i % 3)) << "\n";
+    blob << "dsi_dfps_type=immediate_clk\n";
+    blob << "bit_clk_rate=" << 1100000000 + random(100000000) << "\n";
+    blob << "mdp_transfer_time_us=" << 8000 + random(4000) << "\n";
+    blob << "allowed_mode_switch=" << random(1 << 30) << "\n";
+    blob << "dyn_fp_type=" << ((i % 2) ? "vfp" : "hfp") << "\n";
+    blob << "dyn_fp_list=" << random(100) << " " << random(100) << " " << random(100) << "\n";
+    blob << "qsync_min_fps=" << 30 + random(30) << "\n";
+    blob << "has_cwb_crop=" << random(2) << "\n";
+    blob << "has_dedicated_cwb_support=" << random(2) << "\n";
+    blob << "partial_update_num_roi=" << random(3) << "\n";
+    blob << "partial_update_xstart=" << random(16) << "\n";
+    blob << "partial_update_ystart=" << random(16) << "\n";
+    blob << "partial_update_walign=" << random(16) << "\n";
+    blob << "partial_update_halign=" << random(16) << "\n";
+    blob << "partial_update_wmin=" << random(128) << "\n";
+    blob << "partial_update_hmin=" << random(128) << "\n";
+    blob << "partial_update_roimerge=" << random(2) << "\n";
+    size_t submodes = (i % 2) ? 2 : 0;
+    if (submodes) {
+      blob << "preferred_submode_idx=" << random(2) << "\n";
+    }
+    for (size_t s = 0; s < std::max(submodes, static_cast<size_t>(1)); s++) {
+      if (submodes) {
+        blob << "submode_idx=" << s << "\n";
+      }
+      blob << "topology=" << kTopologies[random(10)] << "\n";
+      blob << "dsc_mode=" << random(4) << "\n";
+      blob << "panel_mode_capabilities=" << 1 + random(3) << "\n";
+      blob << "dyn_bitclk_list=" << 1100000000 + random(1000) << " " << 1150000000 + random(1000)
+           << "\n";
+    }
+  }
+  return blob.str();
+}
+
+DRMConnectorInfo MakeInfo(size_t modes) {
+  DRMConnectorInfo info {};
+  info.modes.resize(modes);
+  return info;
+}
+
+void ExpectSameModes(const DRMConnectorInfo &a, const DRMConnectorInfo &b) {
+  ASSERT_THAT(a.modes.size(), Eq(b.modes.size()));
+  for (size_t i = 0; i < a.modes.size(); i++) {
+    const DRMModeInfo &x = a.modes[i];
+    const DRMModeInfo &y = b.modes[i];
+    EXPECT_THAT(x.num_roi, Eq(y.num_roi));
+    EXPECT_THAT(x.xstart, Eq(y.xstart));
+    EXPECT_THAT(x.ystart, Eq(y.ystart));
+    EXPECT_THAT(x.walign, Eq(y.walign));
+    EXPECT_THAT(x.halign, Eq(y.halign));
+    EXPECT_THAT(x.wmin, Eq(y.wmin));
+    EXPECT_THAT(x.hmin, Eq(y.hmin));
+    EXPECT_THAT(x.roi_merge, Eq(y.roi_merge));
+    EXPECT_THAT(x.default_bit_clk_rate, Eq(y.default_bit_clk_rate));
+    EXPECT_THAT(x.curr_bit_clk_rate, Eq(y.curr_bit_clk_rate));
+    EXPECT_THAT(x.transfer_time_us, Eq(y.transfer_time_us));
+    EXPECT_THAT(x.allowed_mode_switch, Eq(y.allowed_mode_switch));
+    EXPECT_THAT(x.has_cwb_crop, Eq(y.has_cwb_crop));
+    EXPECT_THAT(x.has_dedicated_cwb, Eq(y.has_dedicated_cwb));
+    EXPECT_THAT(x.curr_submode_index, Eq(y.curr_submode_index));
+    EXPECT_THAT(x.fp_type, Eq(y.fp_type));
+    EXPECT_THAT(x.dyn_fp_list, ContainerEq(y.dyn_fp_list));
+    EXPECT_THAT(x.qsync_min_fps, Eq(y.qsync_min_fps));
+    ASSERT_THAT(x.sub_modes.size(), Eq(y.sub_modes.size()));
+    for (size_t s = 0; s < x.sub_modes.size(); s++) {
+      EXPECT_THAT(x.sub_modes[s].panel_mode_caps, Eq(y.sub_modes[s].panel_mode_caps));
+      EXPECT_THAT(x.sub_modes[s].panel_compression_mode,
+                  Eq(y.sub_modes[s].panel_compression_mode));
+      EXPECT_THAT(x.sub_modes[s].topology, Eq(y.sub_modes[s].topology));
+      EXPECT_THAT(x.sub_modes[s].dyn_bitclk_list, ContainerEq(y.sub_modes[s].dyn_bitclk_list));
+    }
+  }
+}
+
+}  // namespace
+
+TEST(DRMConnectorTestCases, ParseModeProperties) {
+  const std::string blob =
+      "mode_name=1080x2400x120\n"
+      "bit_clk_rate=1100000000\n"
+      "mdp_transfer_time_us=8300\n"
+      "allowed_mode_switch=12884901888\n"
+      "dyn_fp_type=vfp\n"
+      "dyn_fp_list=2400 2420 2440\n"
+      "partial_update_num_roi=2\n"
+      "partial_update_roimerge=1\n"
+      "qsync_min_fps=48\n"
+      "submode_idx=0\n"
+      "topology=sde_dualpipe_dscmerge\n"
+      "dsc_mode=1\n"
+      "panel_mode_capabilities=2\n"
+      "submode_idx=1\n"
+      "topology=sde_singlepipe\n"
+      "dyn_bitclk_list=1100000000 1150000000\n"
+      "mode_name=1080x2400x60\n"
+      "topology=sde_quadpipemerge\n";
+  DRMConnectorInfo info = MakeInfo(2);
+  DRMConnector::ParseModeProperties(blob.data(), blob.size(), &info);
+
+  const DRMModeInfo &first = info.modes[0];
+  EXPECT_THAT(first.default_bit_clk_rate, Eq(1100000000u));
+  EXPECT_THAT(first.curr_bit_clk_rate, Eq(1100000000u));
+  EXPECT_THAT(first.transfer_time_us, Eq(8300u));
+  EXPECT_THAT(first.allowed_mode_switch, Eq(12884901888u));
+  EXPECT_THAT(first.fp_type, Eq(sde_drm::DynamicFrontPorchType::VERTICAL));
+  EXPECT_THAT(first.dyn_fp_list, ElementsAre(2400u, 2420u, 2440u));
+  EXPECT_THAT(first.num_roi, Eq(2));
+  EXPECT_TRUE(first.roi_merge);
+  EXPECT_THAT(first.qsync_min_fps, Eq(48u));
+  ASSERT_THAT(first.sub_modes.size(), Eq(2u));
+  EXPECT_THAT(first.sub_modes[0].topology, Eq(DRMTopology::DUAL_LM_DSCMERGE));
+  EXPECT_THAT(first.sub_modes[0].panel_compression_mode, Eq(1u));
+  EXPECT_THAT(first.sub_modes[0].panel_mode_caps, Eq(2u));
+  EXPECT_THAT(first.sub_modes[1].topology, Eq(DRMTopology::SINGLE_LM));
+  EXPECT_THAT(first.sub_modes[1].dyn_bitclk_list, ElementsAre(1100000000u, 1150000000u));
+
+  ASSERT_THAT(info.modes[1].sub_modes.size(), Eq(1u));
+  EXPECT_THAT(info.modes[1].sub_modes[0].topology, Eq(DRMTopology::QUAD_LM_MERGE));
+}
+
+TEST(DRMConnectorTestCases, ParseModePropertiesEdgeCases) {
+  // Every mode gets at least one submode, even without a blob entry for it.
+  DRMConnectorInfo info = MakeInfo(3);
+  const std::string one_mode = "mode_name=a\ntopology=sde_dualpipe\n";
+  DRMConnector::ParseModeProperties(one_mode.data(), one_mode.size(), &info);
+  for (auto &mode : info.modes) {
+    EXPECT_THAT(mode.sub_modes.size(), Eq(1u));
+  }
+
+  // Entries for more modes than the connector has are ignored.
+  info = MakeInfo(1);
+  const std::string extra_modes = "mode_name=a\nqsync_min_fps=30\nmode_name=b\nqsync_min_fps=60\n";
+  DRMConnector::ParseModeProperties(extra_modes.data(), extra_modes.size(), &info);
+  EXPECT_THAT(info.modes[0].qsync_min_fps, Eq(30u));
+
+  // The blob ends at its first NUL like the C string it used to be copied into.
+  info = MakeInfo(1);
+  const char with_nul[] = "mode_name=a\nqsync_min_fps=30\0qsync_min_fps=60\n";
+  DRMConnector::ParseModeProperties(with_nul, sizeof(with_nul), &info);
+  EXPECT_THAT(info.modes[0].qsync_min_fps, Eq(30u));
+
+  // Malformed numbers leave the field alone instead of throwing.
+  info = MakeInfo(1);
+  const std::string malformed = "mode_name=a\nqsync_min_fps=fast\nbit_clk_rate=\n"
+                                "dyn_fp_list=1 x 3\nmdp_transfer_time_us=99999999999999999999\n";
+  DRMConnector::ParseModeProperties(malformed.data(), malformed.size(), &info);
+  EXPECT_THAT(info.modes[0].qsync_min_fps, Eq(0u));
+  EXPECT_THAT(info.modes[0].default_bit_clk_rate, Eq(0u));
+  EXPECT_THAT(info.modes[0].transfer_time_us, Eq(0u));
+  EXPECT_THAT(info.modes[0].dyn_fp_list, ElementsAre(1u));
+
+  // "submode_idx=" is matched first, so preferred_submode_idx lines open a submode as they
+  // always did.
+  info = MakeInfo(1);
+  const std::string preferred = "mode_name=a\npreferred_submode_idx=1\ntopology=sde_dualpipe\n";
+  DRMConnector::ParseModeProperties(preferred.data(), preferred.size(), &info);
+  EXPECT_THAT(info.modes[0].curr_submode_index, Eq(0u));
+  ASSERT_THAT(info.modes[0].sub_modes.size(), Eq(1u));
+  EXPECT_THAT(info.modes[0].sub_modes[0].topology, Eq(DRMTopology::DUAL_LM));
+
+  // Nothing to fill in.
+  info = MakeInfo(0);
+  DRMConnector::ParseModeProperties(one_mode.data(), one_mode.size(), &info);
+  EXPECT_THAT(info.modes, IsEmpty());
+  info = MakeInfo(1);
+  DRMConnector::ParseModeProperties(nullptr, 10, &info);
+  EXPECT_THAT(info.modes[0].sub_modes, IsEmpty());
+}
+
+TEST(DRMConnectorTestCases, ParseModePropertiesMatchesReference) {
+  std::mt19937 rng(27);
+  for (size_t modes = 1; modes <= 24; modes++) {
+    const std::string blob = MakeModeBlob(modes, &rng);
+    // Also parse with fewer and more modes on the connector than in the blob.
+    for (size_t connector_modes : {modes, modes / 2 + 1, modes + 2}) {
+      DRMConnectorInfo parsed = MakeInfo(connector_modes);
+      DRMConnectorInfo reference = MakeInfo(connector_modes);
+      DRMConnector::ParseModeProperties(blob.data(), blob.size(), &parsed);
+      ReferenceParse(blob.data(), blob.size(), &reference);
+      ExpectSameModes(parsed, reference);
+    }
+  }
+}
+
+// Parsing the mode_properties blob of a 16 mode panel, as GetInfo did on every connector query
+// before the info cache.
+TEST(DRMConnectorTestCases, ParseModePropertiesBenchmark) {
+  constexpr size_t kModes = 16;
+  constexpr int kIterations = 2000;
+  std::mt19937 rng(16);
+  const std::string blob = MakeModeBlob(kModes, &rng);
+
+  auto run = [&](void (*parse)(const void *, size_t, DRMConnectorInfo *)) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; i++) {
+      DRMConnectorInfo info = MakeInfo(kModes);
+      parse(blob.data(), blob.size(), &info);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / kIterations;
+  };
+
+  auto reference_ns = run(ReferenceParse);
+  auto blob_ns = run(DRMConnector::ParseModeProperties);
+  std::cout << blob.size() << " byte blob: stringstream " << reference_ns << " ns, in place "
+            << blob_ns << " ns" << std::endl;
+  EXPECT_THAT(blob_ns, Lt(reference_ns));
+}
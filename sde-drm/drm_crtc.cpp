@@ -79,6 +79,8 @@
 #include <utility>
 
 #include "drm_utils.h"
+#include "drm_backend.h"
+#include "drm_blob_cache.h"
 #include "drm_crtc.h"
 #include "drm_property.h"
 
@@ -206,7 +208,7 @@ static void PopulateVMRequestStates(drmModePropertyRes *prop) {
 void DRMCrtcManager::Init(drmModeRes *resource) {
   for (int i = 0; i < resource->count_crtcs; i++) {
     unique_ptr<DRMCrtc> crtc(new DRMCrtc(fd_, i));
-    drmModeCrtc *libdrm_crtc = drmModeGetCrtc(fd_, resource->crtcs[i]);
+    drmModeCrtc *libdrm_crtc = DRMBackend::Get()->GetCrtc(fd_, resource->crtcs[i]);
     if (libdrm_crtc) {
       crtc->InitAndParse(libdrm_crtc);
       crtc_pool_[resource->crtcs[i]] = std::move(crtc);
@@ -224,6 +226,7 @@ void DRMCrtcManager::DumpAll() {
   for (auto &crtc : crtc_pool_) {
     crtc.second->Dump();
   }
+  DRMBlobCache::GetInstance()->Dump();
 }
 
 void DRMCrtcManager::Perform(DRMOps code, uint32_t obj_id, drmModeAtomicReq *req,
@@ -254,30 +257,30 @@ void DRMCrtcManager::SetScalerLUT(const DRMScalerLUTInfo &lut_info) {
   }
 
   if (lut_info.dir_lut_size) {
-    drmModeCreatePropertyBlob(fd_, reinterpret_cast<void *>(lut_info.dir_lut),
-                              lut_info.dir_lut_size, &dir_lut_blob_id_);
+    DRMBackend::Get()->CreatePropertyBlob(fd_, reinterpret_cast<void *>(lut_info.dir_lut),
+                                          lut_info.dir_lut_size, &dir_lut_blob_id_);
   }
   if (lut_info.cir_lut_size) {
-    drmModeCreatePropertyBlob(fd_, reinterpret_cast<void *>(lut_info.cir_lut),
-                              lut_info.cir_lut_size, &cir_lut_blob_id_);
+    DRMBackend::Get()->CreatePropertyBlob(fd_, reinterpret_cast<void *>(lut_info.cir_lut),
+                                          lut_info.cir_lut_size, &cir_lut_blob_id_);
   }
   if (lut_info.sep_lut_size) {
-    drmModeCreatePropertyBlob(fd_, reinterpret_cast<void *>(lut_info.sep_lut),
-                              lut_info.sep_lut_size, &sep_lut_blob_id_);
+    DRMBackend::Get()->CreatePropertyBlob(fd_, reinterpret_cast<void *>(lut_info.sep_lut),
+                                          lut_info.sep_lut_size, &sep_lut_blob_id_);
   }
 }
 
 void DRMCrtcManager::UnsetScalerLUT() {
   if (dir_lut_blob_id_) {
-    drmModeDestroyPropertyBlob(fd_, dir_lut_blob_id_);
+    DRMBackend::Get()->DestroyPropertyBlob(fd_, dir_lut_blob_id_);
     dir_lut_blob_id_ = 0;
   }
   if (cir_lut_blob_id_) {
-    drmModeDestroyPropertyBlob(fd_, cir_lut_blob_id_);
+    DRMBackend::Get()->DestroyPropertyBlob(fd_, cir_lut_blob_id_);
     cir_lut_blob_id_ = 0;
   }
   if (sep_lut_blob_id_) {
-    drmModeDestroyPropertyBlob(fd_, sep_lut_blob_id_);
+    DRMBackend::Get()->DestroyPropertyBlob(fd_, sep_lut_blob_id_);
     sep_lut_blob_id_ = 0;
   }
 }
@@ -361,14 +364,14 @@ DRMCrtc::~DRMCrtc() {
 
 void DRMCrtc::ParseProperties() {
   drmModeObjectProperties *props =
-    drmModeObjectGetProperties(fd_, drm_crtc_->crtc_id, DRM_MODE_OBJECT_CRTC);
+    DRMBackend::Get()->GetObjectProperties(fd_, drm_crtc_->crtc_id, DRM_MODE_OBJECT_CRTC);
   if (!props || !props->props || !props->prop_values) {
     drmModeFreeObjectProperties(props);
     return;
   }
 
   for (uint32_t j = 0; j < props->count_props; j++) {
-    drmModePropertyRes *info = drmModeGetProperty(fd_, props->props[j]);
+    drmModePropertyRes *info = DRMBackend::Get()->GetProperty(fd_, props->props[j]);
     if (!info) {
       continue;
     }
@@ -417,7 +420,7 @@ void DRMCrtc::ParseProperties() {
 }
 
 void DRMCrtc::ParseCapabilities(uint64_t blob_id) {
-  drmModePropertyBlobRes *blob = drmModeGetPropertyBlob(fd_, blob_id);
+  drmModePropertyBlobRes *blob = DRMBackend::Get()->GetPropertyBlob(fd_, blob_id);
   if (!blob) {
     return;
   }
@@ -662,7 +665,7 @@ void DRMCrtc::Lock() {
 
 void DRMCrtc::Unlock() {
   if (mode_blob_id_) {
-    drmModeDestroyPropertyBlob(fd_, mode_blob_id_);
+    DRMBackend::Get()->DestroyPropertyBlob(fd_, mode_blob_id_);
     mode_blob_id_ = 0;
   }
 
@@ -673,7 +676,7 @@ void DRMCrtc::Unlock() {
 
 void DRMCrtc::SetModeBlobID(uint64_t blob_id) {
   if (mode_blob_id_) {
-    drmModeDestroyPropertyBlob(fd_, mode_blob_id_);
+    DRMBackend::Get()->DestroyPropertyBlob(fd_, mode_blob_id_);
   }
 
   mode_blob_id_ = blob_id;
@@ -696,7 +699,8 @@ void DRMCrtc::Perform(DRMOps code, drmModeAtomicReq *req, va_list args) {
       uint32_t blob_id = 0;
 
       if (mode) {
-        if (drmModeCreatePropertyBlob(fd_, (const void *)mode, sizeof(drmModeModeInfo), &blob_id)) {
+        if (DRMBackend::Get()->CreatePropertyBlob(fd_, (const void *)mode, sizeof(drmModeModeInfo),
+                                                  &blob_id)) {
           DRM_LOGE("drmModeCreatePropertyBlob failed for CRTC_SET_MODE, crtc %d", obj_id);
           return;
         }
@@ -765,8 +769,9 @@ void DRMCrtc::Perform(DRMOps code, drmModeAtomicReq *req, va_list args) {
 
     case DRMOps::CRTC_SET_ROT_PREFILL_BW: {
       uint64_t rot_bw = va_arg(args, uint64_t);
-      drmModeAtomicAddProperty(req, obj_id,
-                               prop_mgr_.GetPropertyId(DRMProperty::ROT_PREFILL_BW), rot_bw);
+      DRMBackend::Get()->AtomicAddProperty(req, obj_id,
+                                           prop_mgr_.GetPropertyId(DRMProperty::ROT_PREFILL_BW),
+                                           rot_bw);
     }; break;
 
     case DRMOps::CRTC_SET_ROT_CLK: {
@@ -33,6 +33,7 @@
 
 #include "libdrm_macros.h"
 #include "drm/drm_fourcc.h"
+#include "drm_backend.h"
 #include "drm_dpps_mgr_imp.h"
 
 #define __CLASS__ "DRMDppsManagerImp"
@@ -71,7 +72,7 @@ int DRMDppsManagerImp::GetDrmResources(drmModeRes* res) {
   }
 
   for (auto i = 0; i < res->count_connectors; i++) {
-    conn = drmModeGetConnector(drm_fd_, res->connectors[i]);
+    conn = DRMBackend::Get()->GetConnector(drm_fd_, res->connectors[i]);
     if (conn && conn->connector_type == DRM_MODE_CONNECTOR_DSI &&
         conn->count_modes && conn->connection == DRM_MODE_CONNECTED) {
       DRM_LOGI("Found connector %d", conn->connector_id);
@@ -88,7 +89,7 @@ int DRMDppsManagerImp::GetDrmResources(drmModeRes* res) {
   }
 
   for (auto i = 0; i < conn->count_encoders; i++) {
-    enc = drmModeGetEncoder(drm_fd_, conn->encoders[i]);
+    enc = DRMBackend::Get()->GetEncoder(drm_fd_, conn->encoders[i]);
     if (enc && enc->encoder_type == DRM_MODE_ENCODER_DSI) {
       DRM_LOGI("Found encoder %d", enc->encoder_id);
       enc_id = enc->encoder_id;
@@ -108,7 +109,7 @@ int DRMDppsManagerImp::GetDrmResources(drmModeRes* res) {
 
   for (auto i = 0; i < res->count_crtcs; i++) {
     if (enc->possible_crtcs & (1 << i)) {
-      crtc = drmModeGetCrtc(drm_fd_, res->crtcs[i]);
+      crtc = DRMBackend::Get()->GetCrtc(drm_fd_, res->crtcs[i]);
       if (crtc) {
         DRM_LOGI("Found crtc %d", crtc->crtc_id);
         crtc_id_ = crtc->crtc_id;
@@ -138,14 +139,14 @@ int DRMDppsManagerImp::InitCrtcProps() {
   }
 
   drmModeObjectProperties *props =
-    drmModeObjectGetProperties(drm_fd_, crtc_id_, DRM_MODE_OBJECT_CRTC);
+    DRMBackend::Get()->GetObjectProperties(drm_fd_, crtc_id_, DRM_MODE_OBJECT_CRTC);
   if (!props || !props->props || !props->prop_values) {
     drmModeFreeObjectProperties(props);
     return -EINVAL;
   }
 
   for (uint32_t j = 0; j < props->count_props; j++) {
-    drmModePropertyRes *info = drmModeGetProperty(drm_fd_, props->props[j]);
+    drmModePropertyRes *info = DRMBackend::Get()->GetProperty(drm_fd_, props->props[j]);
     if (!info) {
       continue;
     }
@@ -174,14 +175,14 @@ int DRMDppsManagerImp::InitConnProps()
   }
 
   drmModeObjectProperties *props =
-      drmModeObjectGetProperties(drm_fd_, conn_id_, DRM_MODE_OBJECT_CONNECTOR);
+      DRMBackend::Get()->GetObjectProperties(drm_fd_, conn_id_, DRM_MODE_OBJECT_CONNECTOR);
   if (!props || !props->props || !props->prop_values) {
     drmModeFreeObjectProperties(props);
     return -EINVAL;
   }
 
   for (uint32_t j = 0; j < props->count_props; j++) {
-    drmModePropertyRes *info = drmModeGetProperty(drm_fd_, props->props[j]);
+    drmModePropertyRes *info = DRMBackend::Get()->GetProperty(drm_fd_, props->props[j]);
     if (!info) {
       continue;
     }
@@ -357,7 +358,7 @@ void DRMDppsManagerImp::CommitDppsFeatures(drmModeAtomicReq *req, const DRMDispl
   if (!dpps_dirty_prop_.empty()) {
     for (auto it = dpps_dirty_prop_.begin(); it != dpps_dirty_prop_.end();) {
       if (it->obj_id == tok.crtc_id || it->obj_id == tok.conn_id) {
-        ret = drmModeAtomicAddProperty(req, it->obj_id, it->prop_id, it->value);
+        ret = DRMBackend::Get()->AtomicAddProperty(req, it->obj_id, it->prop_id, it->value);
         if (ret < 0)
           DRM_LOGE("AtomicAddProperty failed obj_id 0x%x, prop_id %d ret %d ", it->obj_id,
                    it->prop_id, ret);
@@ -385,9 +386,9 @@ void DRMDppsManagerImp::CommitDppsFeatures(drmModeAtomicReq *req, const DRMDispl
         event_req.object_type = info.object_type;
         event_req.event = info.event_type;
         if (info.enable)
-          ret = drmIoctl(info.drm_fd, DRM_IOCTL_MSM_REGISTER_EVENT, &event_req);
+          ret = DRMBackend::Get()->Ioctl(info.drm_fd, DRM_IOCTL_MSM_REGISTER_EVENT, &event_req);
         else
-          ret = drmIoctl(info.drm_fd, DRM_IOCTL_MSM_DEREGISTER_EVENT, &event_req);
+          ret = DRMBackend::Get()->Ioctl(info.drm_fd, DRM_IOCTL_MSM_DEREGISTER_EVENT, &event_req);
         if (ret) {
           ret = -errno;
           if (ret == -EALREADY) {
@@ -503,7 +504,7 @@ int DRMDppsManagerImp::InitLtmBuffers(struct DRMDppsFeatureInfo *info) {
   for (i = 0; i < buffers->num_of_buffers && !ret; i++) {
     std::memset(&prime_req, 0, sizeof(drm_prime_handle));
     prime_req.fd = buffers->ion_buffer_fd[i];
-    ret = drmIoctl(drm_fd_, DRM_IOCTL_PRIME_FD_TO_HANDLE, &prime_req);
+    ret = DRMBackend::Get()->Ioctl(drm_fd_, DRM_IOCTL_PRIME_FD_TO_HANDLE, &prime_req);
     if (ret) {
       ret = -errno;
       DRM_LOGE("failed get prime handle: %d", ret);
@@ -512,7 +513,7 @@ int DRMDppsManagerImp::InitLtmBuffers(struct DRMDppsFeatureInfo *info) {
     ltm_buffers.ion_buffer_fd[i] = buffers->ion_buffer_fd[i];
 
     fb_obj.handles[0] = prime_req.handle;
-    ret = drmIoctl(drm_fd_, DRM_IOCTL_MODE_ADDFB2, &fb_obj);
+    ret = DRMBackend::Get()->Ioctl(drm_fd_, DRM_IOCTL_MODE_ADDFB2, &fb_obj);
     if (ret) {
       ret = -errno;
       DRM_LOGE("return value from addFB2: %d", ret);
@@ -527,7 +528,7 @@ int DRMDppsManagerImp::InitLtmBuffers(struct DRMDppsFeatureInfo *info) {
      */
     std::memset(&gem_close, 0, sizeof(gem_close));
     gem_close.handle = prime_req.handle;
-    ret = drmIoctl(drm_fd_, DRM_IOCTL_GEM_CLOSE, &gem_close);
+    ret = DRMBackend::Get()->Ioctl(drm_fd_, DRM_IOCTL_GEM_CLOSE, &gem_close);
     if(ret) {
       ret = -errno;
       DRM_LOGE("return value from GEM_CLOSE: %d\n", ret);
@@ -578,7 +579,7 @@ int DRMDppsManagerImp::DeInitLtmBuffers() {
 
       if (ltm_buffers.drm_fb_id[i] >= 0) {
 #ifdef DRM_IOCTL_MSM_RMFB2
-        ret = drmIoctl(drm_fd_, DRM_IOCTL_MSM_RMFB2, &ltm_buffers.drm_fb_id[i]);
+        ret = DRMBackend::Get()->Ioctl(drm_fd_, DRM_IOCTL_MSM_RMFB2, &ltm_buffers.drm_fb_id[i]);
         if (ret) {
           ret = errno;
           DRM_LOGE("RMFB2 failed for fb_id %d with error %d", ltm_buffers.drm_fb_id[i], ret);
@@ -41,6 +41,7 @@
 #include <vector>
 #include <iterator>
 
+#include "drm_backend.h"
 #include "drm_encoder.h"
 #include "drm_utils.h"
 
@@ -60,7 +61,7 @@ DRMEncoderManager::~DRMEncoderManager() {}
 void DRMEncoderManager::Init(drmModeRes *resource) {
   for (int i = 0; i < resource->count_encoders; i++) {
     unique_ptr<DRMEncoder> encoder(new DRMEncoder(fd_));
-    drmModeEncoder *libdrm_encoder = drmModeGetEncoder(fd_, resource->encoders[i]);
+    drmModeEncoder *libdrm_encoder = DRMBackend::Get()->GetEncoder(fd_, resource->encoders[i]);
     if (!libdrm_encoder) {
       DRM_LOGE("Critical error: drmModeGetEncoder() failed for encoder %d.", resource->encoders[i]);
       continue;
@@ -0,0 +1,650 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <drm/drm_fourcc.h>
+#include <drm_logger.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <json/json.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "drm_fake_backend.h"
+
+#define __CLASS__ "DRMFakeBackend"
+
+namespace sde_drm {
+
+// libdrm releases everything it returns with free(), so copies handed out must come from malloc.
+template <class T>
+static T *AllocArray(size_t count) {
+  return count ? reinterpret_cast<T *>(calloc(count, sizeof(T))) : nullptr;
+}
+
+template <class T>
+static T *CopyArray(const std::vector<T> &values) {
+  T *copy = AllocArray<T>(values.size());
+  if (copy) {
+    memcpy(copy, values.data(), values.size() * sizeof(T));
+  }
+  return copy;
+}
+
+static void ParseMode(const Json::Value &json, drmModeModeInfo *mode) {
+  *mode = {};
+  mode->clock = json.get("clock", 0).asUInt();
+  mode->hdisplay = static_cast<uint16_t>(json.get("hdisplay", 0).asUInt());
+  mode->hsync_start = static_cast<uint16_t>(json.get("hsync_start", mode->hdisplay).asUInt());
+  mode->hsync_end = static_cast<uint16_t>(json.get("hsync_end", mode->hsync_start).asUInt());
+  mode->htotal = static_cast<uint16_t>(json.get("htotal", mode->hsync_end).asUInt());
+  mode->hskew = static_cast<uint16_t>(json.get("hskew", 0).asUInt());
+  mode->vdisplay = static_cast<uint16_t>(json.get("vdisplay", 0).asUInt());
+  mode->vsync_start = static_cast<uint16_t>(json.get("vsync_start", mode->vdisplay).asUInt());
+  mode->vsync_end = static_cast<uint16_t>(json.get("vsync_end", mode->vsync_start).asUInt());
+  mode->vtotal = static_cast<uint16_t>(json.get("vtotal", mode->vsync_end).asUInt());
+  mode->vscan = static_cast<uint16_t>(json.get("vscan", 0).asUInt());
+  mode->vrefresh = json.get("vrefresh", 60).asUInt();
+  mode->flags = json.get("flags", 0).asUInt();
+  mode->type = json.get("type", DRM_MODE_TYPE_DRIVER).asUInt();
+  snprintf(mode->name, sizeof(mode->name), "%s", json.get("name", "").asCString());
+}
+
+static uint32_t ParseFormat(const Json::Value &json) {
+  if (json.isString() && json.asString().size() == 4) {
+    const char *code = json.asCString();
+    return fourcc_code(code[0], code[1], code[2], code[3]);
+  }
+
+  return json.asUInt();
+}
+
+int DRMFakeBackend::LoadTopologyFile(const std::string &path) {
+  std::ifstream file(path);
+  if (!file) {
+    DRM_LOGE("Failed to open topology %s", path.c_str());
+    return -ENOENT;
+  }
+
+  std::stringstream json;
+  json << file.rdbuf();
+  return LoadTopology(json.str());
+}
+
+int DRMFakeBackend::LoadTopology(const std::string &json) {
+  Json::Value root;
+  std::string errors;
+  Json::CharReaderBuilder builder;
+  std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+  if (!reader->parse(json.data(), json.data() + json.size(), &root, &errors)) {
+    DRM_LOGE("Invalid topology: %s", errors.c_str());
+    return -EINVAL;
+  }
+
+  auto attach_properties = [this](uint32_t object_id, const Json::Value &properties) {
+    for (auto &name : properties.getMemberNames()) {
+      const Json::Value &value = properties[name];
+      Property property;
+      property.name = name;
+      uint64_t initial = 0;
+      std::string blob;
+      bool is_blob = false;
+
+      if (value.isString()) {
+        is_blob = true;
+        blob = value.asString();
+        property.flags |= DRM_MODE_PROP_IMMUTABLE;
+      } else if (value.isObject()) {
+        std::string type = value.get("type", "range").asString();
+        if (type == "enum") {
+          property.flags = DRM_MODE_PROP_ENUM;
+          const Json::Value &enums = value["enums"];
+          for (Json::ArrayIndex i = 0; i < enums.size(); i++) {
+            property.enums.push_back({i, enums[i].asString()});
+          }
+        } else if (type == "blob") {
+          is_blob = true;
+          blob = value.get("data", "").asString();
+        } else {
+          property.values = {value.get("min", 0).asUInt64(),
+                             value.get("max", Json::Value::maxUInt64).asUInt64()};
+        }
+        if (value.get("immutable", false).asBool()) {
+          property.flags |= DRM_MODE_PROP_IMMUTABLE;
+        }
+        initial = value.get("value", 0).asUInt64();
+      } else {
+        initial = value.asUInt64();
+      }
+
+      if (is_blob) {
+        property.flags = DRM_MODE_PROP_BLOB | (property.flags & DRM_MODE_PROP_IMMUTABLE);
+        initial = blob.empty() ? 0 : AddBlob(blob.data(), blob.size());
+      } else if (property.values.empty() && !(property.flags & DRM_MODE_PROP_ENUM)) {
+        property.values = {0, std::numeric_limits<uint64_t>::max()};
+      }
+
+      AttachProperty(object_id, AddProperty(property), initial);
+    }
+  };
+
+  std::vector<uint32_t> encoder_ids;
+  for (auto &crtc : root["crtcs"]) {
+    attach_properties(AddCrtc(), crtc["properties"]);
+  }
+  for (auto &encoder : root["encoders"]) {
+    uint32_t encoder_id = AddEncoder(encoder.get("type", DRM_MODE_ENCODER_DSI).asUInt(),
+                                     encoder.get("possible_crtcs", 1).asUInt());
+    attach_properties(encoder_id, encoder["properties"]);
+    encoder_ids.push_back(encoder_id);
+  }
+  for (auto &connector : root["connectors"]) {
+    std::vector<drmModeModeInfo> modes;
+    for (auto &json_mode : connector["modes"]) {
+      drmModeModeInfo mode;
+      ParseMode(json_mode, &mode);
+      modes.push_back(mode);
+    }
+    Json::ArrayIndex encoder = connector.get("encoder", 0).asUInt();
+    uint32_t encoder_id = (encoder < encoder_ids.size()) ? encoder_ids[encoder] : 0;
+    uint32_t connector_id = AddConnector(connector.get("type", DRM_MODE_CONNECTOR_DSI).asUInt(),
+                                         encoder_id, modes);
+    SetConnected(connector_id, connector.get("connected", true).asBool());
+    attach_properties(connector_id, connector["properties"]);
+  }
+  for (auto &plane : root["planes"]) {
+    std::vector<uint32_t> formats;
+    for (auto &format : plane["formats"]) {
+      formats.push_back(ParseFormat(format));
+    }
+    attach_properties(AddPlane(plane.get("possible_crtcs", 1).asUInt(), formats),
+                      plane["properties"]);
+  }
+
+  return 0;
+}
+
+uint32_t DRMFakeBackend::AddObject(uint32_t type) {
+  uint32_t id = next_id_++;
+  objects_[id].type = type;
+  return id;
+}
+
+DRMFakeBackend::Object *DRMFakeBackend::FindObject(uint32_t object_id, uint32_t type) {
+  auto it = objects_.find(object_id);
+  if (it == objects_.end() || (type != kAnyObject && it->second.type != type)) {
+    return nullptr;
+  }
+
+  return &it->second;
+}
+
+uint32_t DRMFakeBackend::AddProperty(const Property &property) {
+  std::lock_guard<std::mutex> lock(lock_);
+  auto it = property_ids_.find(property.name);
+  if (it != property_ids_.end()) {
+    return it->second;
+  }
+
+  uint32_t id = next_id_++;
+  properties_[id] = property;
+  property_ids_[property.name] = id;
+  return id;
+}
+
+uint32_t DRMFakeBackend::AddCrtc() {
+  std::lock_guard<std::mutex> lock(lock_);
+  return AddObject(DRM_MODE_OBJECT_CRTC);
+}
+
+uint32_t DRMFakeBackend::AddEncoder(uint32_t encoder_type, uint32_t possible_crtcs) {
+  std::lock_guard<std::mutex> lock(lock_);
+  uint32_t id = AddObject(DRM_MODE_OBJECT_ENCODER);
+  objects_[id].subtype = encoder_type;
+  objects_[id].possible_crtcs = possible_crtcs;
+  return id;
+}
+
+uint32_t DRMFakeBackend::AddConnector(uint32_t connector_type, uint32_t encoder_id,
+                                      const std::vector<drmModeModeInfo> &modes) {
+  std::lock_guard<std::mutex> lock(lock_);
+  uint32_t type_id = 1;
+  for (auto &object : objects_) {
+    const Object &other = object.second;
+    if (other.type == DRM_MODE_OBJECT_CONNECTOR && other.subtype == connector_type) {
+      type_id++;
+    }
+  }
+
+  uint32_t id = AddObject(DRM_MODE_OBJECT_CONNECTOR);
+  Object &connector = objects_[id];
+  connector.subtype = connector_type;
+  connector.subtype_id = type_id;
+  connector.encoder_id = encoder_id;
+  connector.modes = modes;
+  return id;
+}
+
+uint32_t DRMFakeBackend::AddPlane(uint32_t possible_crtcs, const std::vector<uint32_t> &formats) {
+  std::lock_guard<std::mutex> lock(lock_);
+  uint32_t id = AddObject(DRM_MODE_OBJECT_PLANE);
+  objects_[id].possible_crtcs = possible_crtcs;
+  objects_[id].formats = formats;
+  return id;
+}
+
+int DRMFakeBackend::AttachProperty(uint32_t object_id, uint32_t property_id, uint64_t value) {
+  std::lock_guard<std::mutex> lock(lock_);
+  Object *object = FindObject(object_id, kAnyObject);
+  if (!object || !properties_.count(property_id)) {
+    return -ENOENT;
+  }
+
+  for (auto &property : object->properties) {
+    if (property.first == property_id) {
+      property.second = value;
+      return 0;
+    }
+  }
+  object->properties.push_back({property_id, value});
+  return 0;
+}
+
+uint32_t DRMFakeBackend::AddBlob(const void *data, size_t size) {
+  uint32_t blob_id = 0;
+  CreatePropertyBlob(-1, data, size, &blob_id);
+  return blob_id;
+}
+
+int DRMFakeBackend::SetConnected(uint32_t connector_id, bool connected) {
+  std::lock_guard<std::mutex> lock(lock_);
+  Object *connector = FindObject(connector_id, DRM_MODE_OBJECT_CONNECTOR);
+  if (!connector) {
+    return -ENOENT;
+  }
+
+  connector->connected = connected;
+  return 0;
+}
+
+void DRMFakeBackend::SetCommitError(int error) {
+  std::lock_guard<std::mutex> lock(lock_);
+  commit_error_ = error;
+}
+
+int DRMFakeBackend::GetPropertyValue(uint32_t object_id, const std::string &name,
+                                     uint64_t *value) {
+  std::lock_guard<std::mutex> lock(lock_);
+  Object *object = FindObject(object_id, kAnyObject);
+  auto it = property_ids_.find(name);
+  if (!object || it == property_ids_.end()) {
+    return -ENOENT;
+  }
+
+  for (auto &property : object->properties) {
+    if (property.first == it->second) {
+      *value = property.second;
+      return 0;
+    }
+  }
+  return -ENOENT;
+}
+
+void DRMFakeBackend::GetStats(Stats *stats) {
+  std::lock_guard<std::mutex> lock(lock_);
+  *stats = stats_;
+  stats->blobs = blobs_.size();
+}
+
+int DRMFakeBackend::SetClientCap(int, uint64_t capability, uint64_t) {
+  return (capability == DRM_CLIENT_CAP_UNIVERSAL_PLANES || capability == DRM_CLIENT_CAP_ATOMIC) ?
+         0 : -EINVAL;
+}
+
+int DRMFakeBackend::Ioctl(int, unsigned long request, void *arg) {
+  std::lock_guard<std::mutex> lock(lock_);
+  // Buffer import and framebuffer creation hand out ids, everything else, e.g. MSM event
+  // registration, succeeds without any effect.
+  if (request == DRM_IOCTL_PRIME_FD_TO_HANDLE) {
+    reinterpret_cast<struct drm_prime_handle *>(arg)->handle = next_handle_++;
+  } else if (request == DRM_IOCTL_MODE_ADDFB2) {
+    reinterpret_cast<struct drm_mode_fb_cmd2 *>(arg)->fb_id = next_id_++;
+  }
+
+  return 0;
+}
+
+drmModeResPtr DRMFakeBackend::GetResources(int) {
+  std::lock_guard<std::mutex> lock(lock_);
+  std::vector<uint32_t> crtcs, connectors, encoders;
+  for (auto &object : objects_) {
+    switch (object.second.type) {
+      case DRM_MODE_OBJECT_CRTC: crtcs.push_back(object.first); break;
+      case DRM_MODE_OBJECT_CONNECTOR: connectors.push_back(object.first); break;
+      case DRM_MODE_OBJECT_ENCODER: encoders.push_back(object.first); break;
+      default: break;
+    }
+  }
+
+  drmModeResPtr resources = AllocArray<drmModeRes>(1);
+  resources->count_crtcs = static_cast<int>(crtcs.size());
+  resources->crtcs = CopyArray(crtcs);
+  resources->count_connectors = static_cast<int>(connectors.size());
+  resources->connectors = CopyArray(connectors);
+  resources->count_encoders = static_cast<int>(encoders.size());
+  resources->encoders = CopyArray(encoders);
+  resources->max_width = 16384;
+  resources->max_height = 16384;
+  return resources;
+}
+
+drmModePlaneResPtr DRMFakeBackend::GetPlaneResources(int) {
+  std::lock_guard<std::mutex> lock(lock_);
+  std::vector<uint32_t> planes;
+  for (auto &object : objects_) {
+    if (object.second.type == DRM_MODE_OBJECT_PLANE) {
+      planes.push_back(object.first);
+    }
+  }
+
+  drmModePlaneResPtr resources = AllocArray<drmModePlaneRes>(1);
+  resources->count_planes = static_cast<uint32_t>(planes.size());
+  resources->planes = CopyArray(planes);
+  return resources;
+}
+
+drmModePlanePtr DRMFakeBackend::GetPlane(int, uint32_t plane_id) {
+  std::lock_guard<std::mutex> lock(lock_);
+  Object *object = FindObject(plane_id, DRM_MODE_OBJECT_PLANE);
+  if (!object) {
+    return nullptr;
+  }
+
+  drmModePlanePtr plane = AllocArray<drmModePlane>(1);
+  plane->plane_id = plane_id;
+  plane->possible_crtcs = object->possible_crtcs;
+  plane->count_formats = static_cast<uint32_t>(object->formats.size());
+  plane->formats = CopyArray(object->formats);
+  return plane;
+}
+
+drmModeCrtcPtr DRMFakeBackend::GetCrtc(int, uint32_t crtc_id) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (!FindObject(crtc_id, DRM_MODE_OBJECT_CRTC)) {
+    return nullptr;
+  }
+
+  drmModeCrtcPtr crtc = AllocArray<drmModeCrtc>(1);
+  crtc->crtc_id = crtc_id;
+  return crtc;
+}
+
+drmModeEncoderPtr DRMFakeBackend::GetEncoder(int, uint32_t encoder_id) {
+  std::lock_guard<std::mutex> lock(lock_);
+  Object *object = FindObject(encoder_id, DRM_MODE_OBJECT_ENCODER);
+  if (!object) {
+    return nullptr;
+  }
+
+  drmModeEncoderPtr encoder = AllocArray<drmModeEncoder>(1);
+  encoder->encoder_id = encoder_id;
+  encoder->encoder_type = object->subtype;
+  encoder->possible_crtcs = object->possible_crtcs;
+  return encoder;
+}
+
+drmModeConnectorPtr DRMFakeBackend::GetConnector(int, uint32_t connector_id) {
+  std::lock_guard<std::mutex> lock(lock_);
+  Object *object = FindObject(connector_id, DRM_MODE_OBJECT_CONNECTOR);
+  if (!object) {
+    return nullptr;
+  }
+
+  std::vector<uint32_t> props;
+  std::vector<uint64_t> prop_values;
+  for (auto &property : object->properties) {
+    props.push_back(property.first);
+    prop_values.push_back(property.second);
+  }
+
+  drmModeConnectorPtr connector = AllocArray<drmModeConnector>(1);
+  connector->connector_id = connector_id;
+  connector->encoder_id = object->encoder_id;
+  connector->connector_type = object->subtype;
+  connector->connector_type_id = object->subtype_id;
+  connector->connection = object->connected ? DRM_MODE_CONNECTED : DRM_MODE_DISCONNECTED;
+  connector->subpixel = DRM_MODE_SUBPIXEL_UNKNOWN;
+  if (object->connected) {
+    connector->count_modes = static_cast<int>(object->modes.size());
+    connector->modes = CopyArray(object->modes);
+  }
+  connector->count_props = static_cast<int>(props.size());
+  connector->props = CopyArray(props);
+  connector->prop_values = CopyArray(prop_values);
+  if (object->encoder_id) {
+    connector->count_encoders = 1;
+    connector->encoders = CopyArray(std::vector<uint32_t>{object->encoder_id});
+  }
+  return connector;
+}
+
+drmModeObjectPropertiesPtr DRMFakeBackend::GetObjectProperties(int, uint32_t object_id,
+                                                               uint32_t object_type) {
+  std::lock_guard<std::mutex> lock(lock_);
+  Object *object = FindObject(object_id, object_type);
+  if (!object) {
+    return nullptr;
+  }
+
+  std::vector<uint32_t> props;
+  std::vector<uint64_t> prop_values;
+  for (auto &property : object->properties) {
+    props.push_back(property.first);
+    prop_values.push_back(property.second);
+  }
+
+  drmModeObjectPropertiesPtr properties = AllocArray<drmModeObjectProperties>(1);
+  properties->count_props = static_cast<uint32_t>(props.size());
+  properties->props = CopyArray(props);
+  properties->prop_values = CopyArray(prop_values);
+  return properties;
+}
+
+drmModePropertyPtr DRMFakeBackend::GetProperty(int, uint32_t property_id) {
+  std::lock_guard<std::mutex> lock(lock_);
+  auto it = properties_.find(property_id);
+  if (it == properties_.end()) {
+    return nullptr;
+  }
+
+  const Property &property = it->second;
+  drmModePropertyPtr info = AllocArray<drmModePropertyRes>(1);
+  info->prop_id = property_id;
+  info->flags = property.flags;
+  snprintf(info->name, sizeof(info->name), "%s", property.name.c_str());
+  if (property.flags & DRM_MODE_PROP_ENUM) {
+    std::vector<uint64_t> values;
+    info->count_enums = static_cast<int>(property.enums.size());
+    info->enums = AllocArray<struct drm_mode_property_enum>(property.enums.size());
+    for (size_t i = 0; i < property.enums.size(); i++) {
+      info->enums[i].value = property.enums[i].first;
+      snprintf(info->enums[i].name, sizeof(info->enums[i].name), "%s",
+               property.enums[i].second.c_str());
+      values.push_back(property.enums[i].first);
+    }
+    info->count_values = static_cast<int>(values.size());
+    info->values = CopyArray(values);
+  } else {
+    info->count_values = static_cast<int>(property.values.size());
+    info->values = CopyArray(property.values);
+  }
+  return info;
+}
+
+drmModePropertyBlobPtr DRMFakeBackend::GetPropertyBlob(int, uint32_t blob_id) {
+  std::lock_guard<std::mutex> lock(lock_);
+  auto it = blobs_.find(blob_id);
+  if (it == blobs_.end()) {
+    return nullptr;
+  }
+
+  drmModePropertyBlobPtr blob = AllocArray<drmModePropertyBlobRes>(1);
+  blob->id = blob_id;
+  blob->length = static_cast<uint32_t>(it->second.size());
+  blob->data = CopyArray(it->second);
+  return blob;
+}
+
+int DRMFakeBackend::CreatePropertyBlob(int, const void *data, size_t size, uint32_t *blob_id) {
+  if (!data || !size || !blob_id) {
+    return -EINVAL;
+  }
+
+  std::lock_guard<std::mutex> lock(lock_);
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+  *blob_id = next_id_++;
+  blobs_[*blob_id].assign(bytes, bytes + size);
+  stats_.blobs_created++;
+  return 0;
+}
+
+int DRMFakeBackend::DestroyPropertyBlob(int, uint32_t blob_id) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (!blobs_.erase(blob_id)) {
+    return -ENOENT;
+  }
+
+  stats_.blobs_destroyed++;
+  return 0;
+}
+
+drmModeAtomicReqPtr DRMFakeBackend::AtomicAlloc() {
+  return reinterpret_cast<drmModeAtomicReqPtr>(new AtomicReq());
+}
+
+void DRMFakeBackend::AtomicFree(drmModeAtomicReqPtr req) {
+  delete reinterpret_cast<AtomicReq *>(req);
+}
+
+int DRMFakeBackend::AtomicAddProperty(drmModeAtomicReqPtr req, uint32_t object_id,
+                                      uint32_t property_id, uint64_t value) {
+  if (!req) {
+    return -EINVAL;
+  }
+
+  AtomicReq *atomic_req = reinterpret_cast<AtomicReq *>(req);
+  atomic_req->items.push_back({object_id, property_id, value});
+  return static_cast<int>(atomic_req->items.size());
+}
+
+void DRMFakeBackend::AtomicSetCursor(drmModeAtomicReqPtr req, int cursor) {
+  AtomicReq *atomic_req = reinterpret_cast<AtomicReq *>(req);
+  if (atomic_req && cursor >= 0 && size_t(cursor) < atomic_req->items.size()) {
+    atomic_req->items.resize(size_t(cursor));
+  }
+}
+
+// Same checks the driver does before looking at the values. Called with lock_ held.
+int DRMFakeBackend::Validate(const AtomicItem &item) {
+  Object *object = FindObject(item.object_id, kAnyObject);
+  if (!object) {
+    DRM_LOGE("Unknown object %u", item.object_id);
+    return -ENOENT;
+  }
+
+  auto it = properties_.find(item.property_id);
+  bool attached = false;
+  for (auto &property : object->properties) {
+    attached |= (property.first == item.property_id);
+  }
+  if (it == properties_.end() || !attached) {
+    DRM_LOGE("Object %u has no property %u", item.object_id, item.property_id);
+    return -EINVAL;
+  }
+
+  const Property &property = it->second;
+  if (property.flags & DRM_MODE_PROP_IMMUTABLE) {
+    DRM_LOGE("Property %s of object %u is immutable", property.name.c_str(), item.object_id);
+    return -EINVAL;
+  }
+  bool blob_exists = blobs_.count(static_cast<uint32_t>(item.value));
+  if ((property.flags & DRM_MODE_PROP_BLOB) && item.value && !blob_exists) {
+    DRM_LOGE("Property %s set to unknown blob %" PRIu64, property.name.c_str(), item.value);
+    return -EINVAL;
+  }
+  if ((property.flags & DRM_MODE_PROP_RANGE) && property.values.size() == 2 &&
+      (item.value < property.values[0] || item.value > property.values[1])) {
+    DRM_LOGE("Property %s value %" PRIu64 " out of range", property.name.c_str(), item.value);
+    return -EINVAL;
+  }
+  if (property.flags & DRM_MODE_PROP_ENUM) {
+    bool valid = false;
+    for (auto &entry : property.enums) {
+      valid |= (entry.first == item.value);
+    }
+    if (!valid) {
+      DRM_LOGE("Property %s invalid enum %" PRIu64, property.name.c_str(), item.value);
+      return -EINVAL;
+    }
+  }
+
+  return 0;
+}
+
+// An eventfd with a non-zero count polls readable, which is all sync_wait() looks for.
+int DRMFakeBackend::CreateOutFence() {
+  return eventfd(1, EFD_CLOEXEC);
+}
+
+int DRMFakeBackend::AtomicCommit(int, drmModeAtomicReqPtr req, uint32_t flags, void *) {
+  AtomicReq *atomic_req = reinterpret_cast<AtomicReq *>(req);
+  if (!atomic_req) {
+    return -EINVAL;
+  }
+
+  std::lock_guard<std::mutex> lock(lock_);
+  bool test_only = (flags & DRM_MODE_ATOMIC_TEST_ONLY);
+  test_only ? stats_.test_commits++ : stats_.commits++;
+
+  if (commit_error_) {
+    stats_.rejected++;
+    return commit_error_;
+  }
+
+  for (auto &item : atomic_req->items) {
+    int ret = Validate(item);
+    if (ret) {
+      stats_.rejected++;
+      return ret;
+    }
+  }
+
+  if (test_only) {
+    return 0;
+  }
+
+  for (auto &item : atomic_req->items) {
+    const std::string &name = properties_[item.property_id].name;
+    if ((name == "output_fence" || name == "RETIRE_FENCE") && item.value) {
+      *reinterpret_cast<int64_t *>(item.value) = CreateOutFence();
+    }
+    for (auto &property : objects_[item.object_id].properties) {
+      if (property.first == item.property_id) {
+        property.second = item.value;
+      }
+    }
+    stats_.properties_set++;
+  }
+
+  return 0;
+}
+
+}  // namespace sde_drm
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __DRM_FAKE_BACKEND_H__
+#define __DRM_FAKE_BACKEND_H__
+
+#include <stdint.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "drm_backend.h"
+
+namespace sde_drm {
+
+// In-memory model of a KMS device: CRTCs, encoders, connectors and planes with their properties,
+// property blobs and atomic commits. TEST_ONLY commits validate the request, real commits also
+// update property values and hand out already signaled out-fences. Intended for running
+// sde-drm in host tests and benchmarks, install it with DRMBackend::Set() before creating the
+// DRMManager and pass any fd, it is not used.
+//
+// The topology is either built with the Add* calls or loaded from JSON:
+//   {
+//     "crtcs":      [ { "properties": { ... } } ],
+//     "encoders":   [ { "type": 2, "possible_crtcs": 1, "properties": { ... } } ],
+//     "connectors": [ { "type": 14, "encoder": 0, "connected": true,
+//                       "modes": [ { "name": "1080x2400", "clock": 165000, "hdisplay": 1080,
+//                                    "vdisplay": 2400, "vrefresh": 60, ... } ],
+//                       "properties": { ... } } ],
+//     "planes":     [ { "possible_crtcs": 1, "formats": [ "AR24", "NV12" ],
+//                       "properties": { ... } } ]
+//   }
+// encoder refers to an index in encoders. A property is "name": value, where a number makes a
+// range property holding any 64 bit value, a string makes a blob property whose blob holds the
+// string, e.g. capabilities, and an object gives the property explicitly:
+//   { "type": "range", "min": 0, "max": 255, "value": 0 }
+//   { "type": "enum", "enums": [ "a", "b" ], "value": 1 }
+//   { "type": "blob", "data": "...", "immutable": true }
+// Properties with the same name share one property object, as they do in the driver.
+class DRMFakeBackend : public DRMBackend {
+ public:
+  struct Property {
+    std::string name;
+    uint32_t flags = DRM_MODE_PROP_RANGE;
+    std::vector<uint64_t> values;  // min and max of ranges
+    std::vector<std::pair<uint64_t, std::string>> enums;
+  };
+
+  struct Stats {
+    uint64_t test_commits = 0;
+    uint64_t commits = 0;
+    uint64_t rejected = 0;        // commits failed validation or injected errors
+    uint64_t properties_set = 0;  // property updates across all commits
+    uint64_t blobs_created = 0;
+    uint64_t blobs_destroyed = 0;
+    size_t blobs = 0;
+  };
+
+  DRMFakeBackend() {}
+
+  int LoadTopology(const std::string &json);
+  int LoadTopologyFile(const std::string &path);
+
+  // Returns the property id, an existing property of the same name is reused.
+  uint32_t AddProperty(const Property &property);
+  uint32_t AddCrtc();
+  uint32_t AddEncoder(uint32_t encoder_type, uint32_t possible_crtcs);
+  uint32_t AddConnector(uint32_t connector_type, uint32_t encoder_id,
+                        const std::vector<drmModeModeInfo> &modes);
+  uint32_t AddPlane(uint32_t possible_crtcs, const std::vector<uint32_t> &formats);
+  int AttachProperty(uint32_t object_id, uint32_t property_id, uint64_t value);
+  uint32_t AddBlob(const void *data, size_t size);
+
+  // Hotplug, the change is seen on the next GetConnector.
+  int SetConnected(uint32_t connector_id, bool connected);
+  // Fails the following commits with error, 0 to stop.
+  void SetCommitError(int error);
+  int GetPropertyValue(uint32_t object_id, const std::string &name, uint64_t *value);
+  void GetStats(Stats *stats);
+
+  int SetClientCap(int fd, uint64_t capability, uint64_t value) override;
+  int Ioctl(int fd, unsigned long request, void *arg) override;
+
+  drmModeResPtr GetResources(int fd) override;
+  drmModePlaneResPtr GetPlaneResources(int fd) override;
+  drmModePlanePtr GetPlane(int fd, uint32_t plane_id) override;
+  drmModeCrtcPtr GetCrtc(int fd, uint32_t crtc_id) override;
+  drmModeEncoderPtr GetEncoder(int fd, uint32_t encoder_id) override;
+  drmModeConnectorPtr GetConnector(int fd, uint32_t connector_id) override;
+
+  drmModeObjectPropertiesPtr GetObjectProperties(int fd, uint32_t object_id,
+                                                 uint32_t object_type) override;
+  drmModePropertyPtr GetProperty(int fd, uint32_t property_id) override;
+  drmModePropertyBlobPtr GetPropertyBlob(int fd, uint32_t blob_id) override;
+  int CreatePropertyBlob(int fd, const void *data, size_t size, uint32_t *blob_id) override;
+  int DestroyPropertyBlob(int fd, uint32_t blob_id) override;
+
+  drmModeAtomicReqPtr AtomicAlloc() override;
+  void AtomicFree(drmModeAtomicReqPtr req) override;
+  int AtomicAddProperty(drmModeAtomicReqPtr req, uint32_t object_id, uint32_t property_id,
+                        uint64_t value) override;
+  void AtomicSetCursor(drmModeAtomicReqPtr req, int cursor) override;
+  int AtomicCommit(int fd, drmModeAtomicReqPtr req, uint32_t flags, void *user_data) override;
+
+ private:
+  struct Object {
+    uint32_t type = 0;
+    std::vector<std::pair<uint32_t, uint64_t>> properties;  // property id, value
+    // Type specific state
+    uint32_t subtype = 0;            // encoder or connector type
+    uint32_t subtype_id = 0;         // connector type instance
+    uint32_t encoder_id = 0;
+    uint32_t possible_crtcs = 0;
+    bool connected = true;
+    std::vector<drmModeModeInfo> modes;
+    std::vector<uint32_t> formats;
+  };
+
+  struct AtomicItem {
+    uint32_t object_id;
+    uint32_t property_id;
+    uint64_t value;
+  };
+
+  struct AtomicReq {
+    std::vector<AtomicItem> items;
+  };
+
+  uint32_t AddObject(uint32_t type);
+  Object *FindObject(uint32_t object_id, uint32_t type);
+  int Validate(const AtomicItem &item);
+  int CreateOutFence();
+
+  static const uint32_t kAnyObject = 0;
+
+  std::mutex lock_;
+  uint32_t next_id_ = 1;
+  std::map<uint32_t, Object> objects_;
+  std::map<uint32_t, Property> properties_;
+  std::map<std::string, uint32_t> property_ids_;
+  std::map<uint32_t, std::vector<uint8_t>> blobs_;
+  uint32_t next_handle_ = 1;
+  int commit_error_ = 0;
+  Stats stats_;
+};
+
+}  // namespace sde_drm
+
+#endif  // __DRM_FAKE_BACKEND_H__
@@ -30,7 +30,10 @@
 #include <drm_logger.h>
 
 #include <string.h>
+#include <chrono>
 #include "drm_atomic_req.h"
+#include "drm_backend.h"
+#include "drm_blob_cache.h"
 #include "drm_connector.h"
 #include "drm_crtc.h"
 #include "drm_encoder.h"
@@ -92,12 +95,13 @@ void DRMManager::Destroy() {
 }
 
 int DRMManager::Init(int drm_fd) {
+  auto init_start = std::chrono::steady_clock::now();
   fd_ = drm_fd;
 
-  drmSetClientCap(fd_, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1);
-  drmSetClientCap(fd_, DRM_CLIENT_CAP_ATOMIC, 1);
+  DRMBackend::Get()->SetClientCap(fd_, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1);
+  DRMBackend::Get()->SetClientCap(fd_, DRM_CLIENT_CAP_ATOMIC, 1);
 
-  drmModeRes *resource = drmModeGetResources(fd_);
+  drmModeRes *resource = DRMBackend::Get()->GetResources(fd_);
   if (resource == NULL) {
     DRM_LOGE("drmModeGetResources failed");
     return DRM_ERR_INVALID;
@@ -144,6 +148,11 @@ int DRMManager::Init(int drm_fd) {
 
   drmModeFreeResources(resource);
 
+  auto init_time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - init_start).count();
+  DRM_LOGI("DRM resources parsed in %lld us using up to %u threads",
+           static_cast<long long>(init_time_us), GetInitThreads());
+
   return 0;
 }
 
@@ -349,6 +358,7 @@ DRMManager::~DRMManager() {
   if (panel_feature_mgr_intf_) {
     panel_feature_mgr_intf_->Deinit();
   }
+  DRMBlobCache::GetInstance()->Purge(fd_);
 }
 
 int DRMManager::CreateAtomicReq(const DRMDisplayToken &token, DRMAtomicReqInterface **intf) {
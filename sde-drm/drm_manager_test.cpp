@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <sstream>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "drm_fake_backend.h"
+#include "drm_manager.h"
+#include "drm_utils.h"
+using namespace testing;
+using sde_drm::DRMBackend;
+using sde_drm::DRMConnectorInfo;
+using sde_drm::DRMConnectorsInfo;
+using sde_drm::DRMFakeBackend;
+using sde_drm::DRMManagerInterface;
+using sde_drm::DRMPlanesInfo;
+using sde_drm::DRMPlaneTypeInfo;
+
+extern "C" int GetDRMManager(int fd, DRMManagerInterface **intf);
+extern "C" int DestroyDRMManager();
+
+namespace {
+
+// A two display target: a DSI panel with submodes, a DP connector and a writeback, on three
+// CRTCs, with VIG, DMA and cursor planes like the driver exposes them.
+std::string MakeTopology(int planes) {
+  std::stringstream json;
+  json << R"({
+    "crtcs": [)";
+  for (int i = 0; i < 3; i++) {
+    json << (i ? "," : "") << R"(
+      { "properties": { "ACTIVE": 0, "MODE_ID": { "type": "blob" }, "output_fence": 0,
+                        "capabilities": "max_blendstages=11\nqseed_type=qseed3\n" } })";
+  }
+  json << R"(],
+    "encoders": [ { "type": 2, "possible_crtcs": 7 }, { "type": 7, "possible_crtcs": 7 },
+                  { "type": 5, "possible_crtcs": 7 } ],
+    "connectors": [
+      { "type": 16, "encoder": 0,
+        "modes": [ { "name": "1080x2400", "clock": 340000, "hdisplay": 1080, "vdisplay": 2400,
+                     "vrefresh": 120 },
+                   { "name": "1080x2400", "clock": 170000, "hdisplay": 1080, "vdisplay": 2400,
+                     "vrefresh": 60 } ],
+        "properties": { "CRTC_ID": 0, "RETIRE_FENCE": 0,
+                        "LP": { "type": "enum", "enums": [ "on", "lp1", "lp2", "off" ] },
+                        "capabilities": ")"
+                        "display type=primary\npanel name=fake cmd panel\npanel mode=command\n"
+                        "qsync support=true\ndyn bitclk support=true\n" R"(",
+                        "mode_properties": ")"
+                        "mode_name=1080x2400x120\nbit_clk_rate=1100000000\n"
+                        "submode_idx=0\ntopology=sde_dualpipe_dscmerge\ndsc_mode=1\n"
+                        "dyn_bitclk_list=1100000000 1150000000\n"
+                        "submode_idx=1\ntopology=sde_dualpipemerge\n"
+                        "mode_name=1080x2400x60\nbit_clk_rate=900000000\n"
+                        "topology=sde_singlepipe_dsc\nqsync_min_fps=30\n" R"(" } },
+      { "type": 10, "encoder": 1,
+        "modes": [ { "name": "3840x2160", "clock": 594000, "hdisplay": 3840, "vdisplay": 2160,
+                     "vrefresh": 60 } ],
+        "properties": { "CRTC_ID": 0, "RETIRE_FENCE": 0,
+                        "capabilities": "display type=secondary\npanel name=dp\n" } },
+      { "type": 18, "encoder": 2,
+        "modes": [ { "name": "1080x2400", "hdisplay": 1080, "vdisplay": 2400, "vrefresh": 60 } ],
+        "properties": { "CRTC_ID": 0, "RETIRE_FENCE": 0, "FB_ID": 0,
+                        "capabilities": "maxlinewidth=4096\nwb_ubwc\n" } }
+    ],
+    "planes": [)";
+  for (int i = 0; i < planes; i++) {
+    bool vig = i % 4 == 0;
+    bool cursor = i == planes - 1;
+    json << (i ? "," : "") << R"(
+      { "possible_crtcs": 7, "formats": [ "AR24", "XR24", "RG16")";
+    json << (vig ? R"(, "NV12" ],)" : " ],");
+    json << R"( "properties": { "CRTC_ID": 0, "FB_ID": 0, "zpos": { "min": 0, "max": 255 },
+          "type": { "type": "enum", "enums": [ "Overlay", "Primary", "Cursor" ], "value": )"
+         << (cursor ? 2 : 0) << " },";
+    if (vig) {
+      json << R"( "csc_v1": { "type": "blob" }, "scaler_v2": { "type": "blob" },)";
+    }
+    json << R"( "capabilities": "pixel_formats=AB24 AR24 RA24 NV12/5/1\nmax_linewidth=)"
+         << (2048 + 256 * (i % 3)) << R"(\nmax_upscale=20\nmax_downscale=4\nmax_per_pipe_bw=)"
+         << 4500000000ull + i << R"(\npipe_idx=)" << i << R"(\n" } })";
+  }
+  json << R"(
+    ]
+  })";
+  return json.str();
+}
+
+class FakeDRMManager {
+ public:
+  explicit FakeDRMManager(const std::string &topology) {
+    EXPECT_THAT(fake_.LoadTopology(topology), Eq(0));
+    DRMBackend::Set(&fake_);
+    EXPECT_THAT(GetDRMManager(0, &manager_), Eq(0));
+  }
+  ~FakeDRMManager() {
+    DestroyDRMManager();
+    DRMBackend::Set(nullptr);
+  }
+  DRMManagerInterface *operator->() { return manager_; }
+  DRMFakeBackend *fake() { return &fake_; }
+
+ private:
+  DRMFakeBackend fake_;
+  DRMManagerInterface *manager_ = nullptr;
+};
+
+void ExpectSamePlane(const DRMPlaneTypeInfo &a, const DRMPlaneTypeInfo &b) {
+  EXPECT_THAT(a.type, Eq(b.type));
+  EXPECT_THAT(a.master_plane_id, Eq(b.master_plane_id));
+  EXPECT_THAT(a.formats_supported, ContainerEq(b.formats_supported));
+  EXPECT_THAT(a.max_linewidth, Eq(b.max_linewidth));
+  EXPECT_THAT(a.max_upscale, Eq(b.max_upscale));
+  EXPECT_THAT(a.max_downscale, Eq(b.max_downscale));
+  EXPECT_THAT(a.max_pipe_bandwidth, Eq(b.max_pipe_bandwidth));
+  EXPECT_THAT(a.pipe_idx, Eq(b.pipe_idx));
+  EXPECT_THAT(a.has_excl_rect, Eq(b.has_excl_rect));
+  EXPECT_THAT(a.multirect_prop_present, Eq(b.multirect_prop_present));
+  EXPECT_THAT(a.tonemap_lut_version_map, ContainerEq(b.tonemap_lut_version_map));
+}
+
+void ExpectSameConnector(const DRMConnectorInfo &a, const DRMConnectorInfo &b) {
+  EXPECT_THAT(a.type, Eq(b.type));
+  EXPECT_THAT(a.type_id, Eq(b.type_id));
+  EXPECT_THAT(a.panel_name, Eq(b.panel_name));
+  EXPECT_THAT(a.panel_mode, Eq(b.panel_mode));
+  EXPECT_THAT(a.is_primary, Eq(b.is_primary));
+  EXPECT_THAT(a.is_connected, Eq(b.is_connected));
+  EXPECT_THAT(a.qsync_support, Eq(b.qsync_support));
+  EXPECT_THAT(a.dyn_bitclk_support, Eq(b.dyn_bitclk_support));
+  EXPECT_THAT(a.max_linewidth, Eq(b.max_linewidth));
+  EXPECT_THAT(a.is_wb_ubwc_supported, Eq(b.is_wb_ubwc_supported));
+  ASSERT_THAT(a.modes.size(), Eq(b.modes.size()));
+  for (size_t i = 0; i < a.modes.size(); i++) {
+    EXPECT_THAT(a.modes[i].mode.clock, Eq(b.modes[i].mode.clock));
+    EXPECT_THAT(a.modes[i].mode.vrefresh, Eq(b.modes[i].mode.vrefresh));
+    EXPECT_THAT(a.modes[i].default_bit_clk_rate, Eq(b.modes[i].default_bit_clk_rate));
+    EXPECT_THAT(a.modes[i].qsync_min_fps, Eq(b.modes[i].qsync_min_fps));
+    ASSERT_THAT(a.modes[i].sub_modes.size(), Eq(b.modes[i].sub_modes.size()));
+    for (size_t s = 0; s < a.modes[i].sub_modes.size(); s++) {
+      EXPECT_THAT(a.modes[i].sub_modes[s].topology, Eq(b.modes[i].sub_modes[s].topology));
+      EXPECT_THAT(a.modes[i].sub_modes[s].dyn_bitclk_list,
+                  ContainerEq(b.modes[i].sub_modes[s].dyn_bitclk_list));
+    }
+  }
+}
+
+struct InitResult {
+  DRMPlanesInfo planes;
+  DRMConnectorsInfo connectors;
+};
+
+InitResult InitWithThreads(const std::string &topology, uint32_t threads) {
+  uint32_t previous = sde_drm::GetInitThreads();
+  sde_drm::SetInitThreads(threads);
+  InitResult result;
+  {
+    FakeDRMManager manager(topology);
+    manager->GetPlanesInfo(&result.planes);
+    EXPECT_THAT(manager->GetConnectorsInfo(&result.connectors), Eq(0));
+  }
+  sde_drm::SetInitThreads(previous);
+  return result;
+}
+
+}  // namespace
+
+TEST(DRMManagerTestCases, ParallelInitMatchesSerial) {
+  const std::string topology = MakeTopology(16);
+  InitResult serial = InitWithThreads(topology, 1);
+  ASSERT_THAT(serial.planes.size(), Eq(16u));
+  ASSERT_THAT(serial.connectors.size(), Eq(3u));
+  EXPECT_THAT(serial.planes[0].second.type, Eq(sde_drm::DRMPlaneType::VIG));
+  EXPECT_THAT(serial.planes[1].second.type, Eq(sde_drm::DRMPlaneType::DMA));
+  EXPECT_THAT(serial.planes[15].second.type, Eq(sde_drm::DRMPlaneType::CURSOR));
+  EXPECT_THAT(serial.planes[2].second.max_linewidth, Eq(2560u));
+  const DRMConnectorInfo &panel = serial.connectors.begin()->second;
+  EXPECT_THAT(panel.panel_name, Eq("fake cmd panel"));
+  ASSERT_THAT(panel.modes.size(), Eq(2u));
+  EXPECT_THAT(panel.modes[0].sub_modes.size(), Eq(2u));
+
+  // Repeat to give the parallel parse a chance to interleave differently.
+  for (int run = 0; run < 10; run++) {
+    InitResult parallel = InitWithThreads(topology, 4);
+    ASSERT_THAT(parallel.planes.size(), Eq(serial.planes.size()));
+    for (size_t i = 0; i < serial.planes.size(); i++) {
+      // Plane ids and their order are the priority order, they must not change.
+      EXPECT_THAT(parallel.planes[i].first, Eq(serial.planes[i].first));
+      ExpectSamePlane(parallel.planes[i].second, serial.planes[i].second);
+    }
+    ASSERT_THAT(parallel.connectors.size(), Eq(serial.connectors.size()));
+    for (auto &connector : serial.connectors) {
+      ASSERT_THAT(parallel.connectors.count(connector.first), Eq(1u));
+      ExpectSameConnector(parallel.connectors[connector.first], connector.second);
+    }
+  }
+}
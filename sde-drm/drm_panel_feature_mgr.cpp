@@ -73,6 +73,7 @@
 #include <regex>
 #include <inttypes.h>
 
+#include "drm_backend.h"
 #include "drm_panel_feature_mgr.h"
 
 #define __CLASS__ "DRMPanelFeatureMgr"
@@ -108,7 +109,7 @@ void DRMPanelFeatureMgr::Init(int fd, drmModeRes* res) {
   dev_fd_ = fd;
 
   for (int i = 0; i < res->count_crtcs; i++) {
-    drmModeCrtc *crtc = drmModeGetCrtc(dev_fd_, res->crtcs[i]);
+    drmModeCrtc *crtc = DRMBackend::Get()->GetCrtc(dev_fd_, res->crtcs[i]);
     if (crtc) {
       int err = InitObjectProps(crtc->crtc_id, DRM_MODE_OBJECT_CRTC);
       if (err) {
@@ -119,7 +120,7 @@ void DRMPanelFeatureMgr::Init(int fd, drmModeRes* res) {
   }
 
   for (int i = 0; i < res->count_connectors; i++) {
-    drmModeConnector *conn = drmModeGetConnector(dev_fd_, res->connectors[i]);
+    drmModeConnector *conn = DRMBackend::Get()->GetConnector(dev_fd_, res->connectors[i]);
     if (conn) {
       int err = InitObjectProps(conn->connector_id, DRM_MODE_OBJECT_CONNECTOR);
       if (err) {
@@ -178,7 +179,7 @@ void DRMPanelFeatureMgr::Deinit() {
   for (int i = kDRMPanelFeatureDsppIndex; i < kDRMPanelFeatureMax; i++) {
     DRMPanelFeatureID prop_id = static_cast<DRMPanelFeatureID>(i);
     if (drm_prop_blob_ids_map_[prop_id]) {
-      ret = drmModeDestroyPropertyBlob(dev_fd_, drm_prop_blob_ids_map_[prop_id]);
+      ret = DRMBackend::Get()->DestroyPropertyBlob(dev_fd_, drm_prop_blob_ids_map_[prop_id]);
       if (ret) {
         DRM_LOGE("failed to destroy blob for feature %d, ret = %d", prop_id, ret);
         return;
@@ -196,7 +197,7 @@ int DRMPanelFeatureMgr::InitObjectProps(int obj_id, int obj_type) {
   }
 
   drmModeObjectProperties *props =
-          drmModeObjectGetProperties(dev_fd_, obj_id, obj_type);
+          DRMBackend::Get()->GetObjectProperties(dev_fd_, obj_id, obj_type);
   if (!props || !props->props || !props->prop_values) {
     DRM_LOGE("Failed to get props for obj_id:%d obj_type:%d", obj_id, obj_type);
     drmModeFreeObjectProperties(props);
@@ -204,7 +205,7 @@ int DRMPanelFeatureMgr::InitObjectProps(int obj_id, int obj_type) {
   }
 
   for (uint32_t j = 0; j < props->count_props; j++) {
-    drmModePropertyRes *info = drmModeGetProperty(dev_fd_, props->props[j]);
+    drmModePropertyRes *info = DRMBackend::Get()->GetProperty(dev_fd_, props->props[j]);
     if (!info) {
       continue;
     }
@@ -226,7 +227,7 @@ int DRMPanelFeatureMgr::InitObjectProps(int obj_id, int obj_type) {
 }
 
 void DRMPanelFeatureMgr::ParsePanelId(uint32_t blob_id, DRMPanelFeatureInfo *info) {
-  drmModePropertyBlobRes *blob = drmModeGetPropertyBlob(dev_fd_, blob_id);
+  drmModePropertyBlobRes *blob = DRMBackend::Get()->GetPropertyBlob(dev_fd_, blob_id);
   if (!blob) {
     return;
   }
@@ -287,7 +288,7 @@ void DRMPanelFeatureMgr::ParseDemuraResources(drmModePropertyRes *prop, uint64_t
 
 void DRMPanelFeatureMgr::ParseDsppCapabilities(uint32_t blob_id, std::vector<int> *values,
                                                uint32_t *size, const std::string str) {
-  drmModePropertyBlobRes *blob = drmModeGetPropertyBlob(dev_fd_, blob_id);
+  drmModePropertyBlobRes *blob = DRMBackend::Get()->GetPropertyBlob(dev_fd_, blob_id);
   if (!blob) {
     DRM_LOGW("Unable to find blob for id %d", blob_id);
     return;
@@ -322,7 +323,7 @@ void DRMPanelFeatureMgr::ParseDsppCapabilities(uint32_t blob_id, std::vector<int
 
 void DRMPanelFeatureMgr::ParseCapabilities(uint32_t blob_id, char* value, uint32_t max_len,
                                            const std::string str) {
-  drmModePropertyBlobRes *blob = drmModeGetPropertyBlob(dev_fd_, blob_id);
+  drmModePropertyBlobRes *blob = DRMBackend::Get()->GetPropertyBlob(dev_fd_, blob_id);
   if (!blob) {
     DRM_LOGW("Unable to find blob for id %d", blob_id);
     return;
@@ -382,7 +383,7 @@ void DRMPanelFeatureMgr::GetPanelFeatureInfo(DRMPanelFeatureInfo *info) {
   }
 
   drmModeObjectProperties *props =
-          drmModeObjectGetProperties(dev_fd_, info->obj_id, info->obj_type);
+          DRMBackend::Get()->GetObjectProperties(dev_fd_, info->obj_id, info->obj_type);
   if (!props || !props->props || !props->prop_values) {
     drmModeFreeObjectProperties(props);
     DRM_LOGE("Failed to Get properties for obj: %d type:%d", info->obj_id, info->obj_type);
@@ -390,7 +391,7 @@ void DRMPanelFeatureMgr::GetPanelFeatureInfo(DRMPanelFeatureInfo *info) {
   }
 
   for (uint32_t j = 0; j < props->count_props; j++) {
-    drmModePropertyRes *property = drmModeGetProperty(dev_fd_, props->props[j]);
+    drmModePropertyRes *property = DRMBackend::Get()->GetProperty(dev_fd_, props->props[j]);
     if (!property) {
       continue;
     }
@@ -421,7 +422,8 @@ void DRMPanelFeatureMgr::GetPanelFeatureInfo(DRMPanelFeatureInfo *info) {
       ParseDsppCapabilities(props->prop_values[j],
               reinterpret_cast<std::vector<int> *>(info->prop_ptr), &(info->prop_size), "rc");
     } else if (drm_prop_type_map_[info->prop_id] == DRMPropType::kPropBlob) {
-      drmModePropertyBlobRes *blob = drmModeGetPropertyBlob(dev_fd_, props->prop_values[j]);
+      drmModePropertyBlobRes *blob = DRMBackend::Get()->GetPropertyBlob(dev_fd_,
+                                                                        props->prop_values[j]);
       if (!blob || !blob->data || !blob->length) {
         return;
       }
@@ -567,7 +569,7 @@ void DRMPanelFeatureMgr::ApplyDirtyFeature(drmModeAtomicReq *req, const DRMDispl
     uint32_t blob_id = 0;
     if (!info.prop_ptr) {
       // Reset the feature.
-      ret = drmModeAtomicAddProperty(req, info.obj_id, prop_id, 0);
+      ret = DRMBackend::Get()->AtomicAddProperty(req, info.obj_id, prop_id, 0);
       if (ret < 0) {
         DRM_LOGE("failed to add property ret:%d, obj_id:%d prop_id:%u value:%" PRIu64,
                   ret, info.obj_id, prop_id, value);
@@ -576,7 +578,7 @@ void DRMPanelFeatureMgr::ApplyDirtyFeature(drmModeAtomicReq *req, const DRMDispl
       return;
     }
 
-    ret = drmModeCreatePropertyBlob(dev_fd_, reinterpret_cast<void *> (info.prop_ptr),
+    ret = DRMBackend::Get()->CreatePropertyBlob(dev_fd_, reinterpret_cast<void *> (info.prop_ptr),
             info.prop_size, &blob_id);
     if (ret || blob_id == 0) {
       DRM_LOGE("failed to create blob ret %d, id = %d prop_ptr:%" PRIu64 " prop_sz:%d",
@@ -585,7 +587,7 @@ void DRMPanelFeatureMgr::ApplyDirtyFeature(drmModeAtomicReq *req, const DRMDispl
     }
 
     if (drm_prop_blob_ids_map_[info.prop_id]) {
-      ret = drmModeDestroyPropertyBlob(dev_fd_, drm_prop_blob_ids_map_[info.prop_id]);
+      ret = DRMBackend::Get()->DestroyPropertyBlob(dev_fd_, drm_prop_blob_ids_map_[info.prop_id]);
       if (ret) {
         DRM_LOGE("failed to destroy blob for feature %d, ret = %d", info.prop_id, ret);
         return;
@@ -600,7 +602,7 @@ void DRMPanelFeatureMgr::ApplyDirtyFeature(drmModeAtomicReq *req, const DRMDispl
     DRM_LOGE("Unsupported property type id = %d size:%d", info.prop_id, info.prop_size);
   }
 
-  ret = drmModeAtomicAddProperty(req, info.obj_id, prop_id, value);
+  ret = DRMBackend::Get()->AtomicAddProperty(req, info.obj_id, prop_id, value);
   if (ret < 0) {
     DRM_LOGE("failed to add property ret:%d, obj_id:%d prop_id:%x value:%" PRIu64,
               ret, info.obj_id, prop_id, value);
@@ -84,6 +84,7 @@
 #include <algorithm>
 
 #include "drm_utils.h"
+#include "drm_backend.h"
 #include "drm_plane.h"
 #include "drm_property.h"
 
@@ -191,7 +192,11 @@ static void SetRect(DRMRect &source, drm_clip_rect *target) {
   target->y2 = uint16_t(source.bottom);
 }
 
+// Planes may be parsed concurrently, see DRMPlaneManager::Init
+static mutex s_populate_lock;
+
 static void PopulateReflect(drmModePropertyRes *prop) {
+  lock_guard<mutex> lock(s_populate_lock);
   if (REFLECT_X) {
     return;
   }
@@ -215,6 +220,7 @@ static void PopulateReflect(drmModePropertyRes *prop) {
 }
 
 static void PopulateSecureModes(drmModePropertyRes *prop) {
+  lock_guard<mutex> lock(s_populate_lock);
   static bool secure_modes_populated = false;
   if (!secure_modes_populated) {
     for (auto i = 0; i < prop->count_enums; i++) {
@@ -257,6 +263,7 @@ static QSEEDStepVersion PopulateQseedStepVersion(uint32_t hw_ver) {
 }
 
 static void PopulateMultiRectModes(drmModePropertyRes *prop) {
+  lock_guard<mutex> lock(s_populate_lock);
   static bool multirect_modes_populated = false;
   if (!multirect_modes_populated) {
     for (auto i = 0; i < prop->count_enums; i++) {
@@ -274,6 +281,7 @@ static void PopulateMultiRectModes(drmModePropertyRes *prop) {
 }
 
 static void PopulateBlendType(drmModePropertyRes *prop) {
+  lock_guard<mutex> lock(s_populate_lock);
   static bool blend_type_populated = false;
   if (!blend_type_populated) {
     for (auto i = 0; i < prop->count_enums; i++) {
@@ -335,21 +343,30 @@ static bool GetDRMonemapLutTypeFromPPFeatureID(DRMPPFeatureID id, DRMTonemapLutT
 DRMPlaneManager::DRMPlaneManager(int fd) : fd_(fd) {}
 
 void DRMPlaneManager::Init() {
-  drmModePlaneRes *resource = drmModeGetPlaneResources(fd_);
+  drmModePlaneRes *resource = DRMBackend::Get()->GetPlaneResources(fd_);
   if (!resource) {
     return;
   }
 
-  for (uint32_t i = 0; i < resource->count_planes; i++) {
+  // Property parsing issues several ioctls per plane, spread it across a few threads and merge
+  // the parsed planes afterwards in enumeration order.
+  vector<unique_ptr<DRMPlane>> planes(resource->count_planes);
+  ParallelFor(resource->count_planes, GetInitThreads(), [&](size_t i) {
     // The enumeration order itself is the priority from high to low
-    unique_ptr<DRMPlane> plane(new DRMPlane(fd_, i));
-    drmModePlane *libdrm_plane = drmModeGetPlane(fd_, resource->planes[i]);
+    unique_ptr<DRMPlane> plane(new DRMPlane(fd_, static_cast<uint32_t>(i)));
+    drmModePlane *libdrm_plane = DRMBackend::Get()->GetPlane(fd_, resource->planes[i]);
     if (libdrm_plane) {
       plane->InitAndParse(libdrm_plane);
-      plane_pool_[resource->planes[i]] = std::move(plane);
+      planes[i] = std::move(plane);
     } else {
       DRM_LOGE("Critical error: drmModeGetPlane() failed for plane %d.", resource->planes[i]);
     }
+  });
+
+  for (uint32_t i = 0; i < resource->count_planes; i++) {
+    if (planes[i]) {
+      plane_pool_[resource->planes[i]] = std::move(planes[i]);
+    }
   }
 
   drmModeFreePlaneResources(resource);
@@ -437,30 +454,30 @@ void DRMPlaneManager::PostCommit(uint32_t crtc_id, bool success) {
 
 void DRMPlaneManager::SetScalerLUT(const DRMScalerLUTInfo &lut_info) {
   if (lut_info.dir_lut_size) {
-    drmModeCreatePropertyBlob(fd_, reinterpret_cast<void *>(lut_info.dir_lut),
-                              lut_info.dir_lut_size, &dir_lut_blob_id_);
+    DRMBackend::Get()->CreatePropertyBlob(fd_, reinterpret_cast<void *>(lut_info.dir_lut),
+                                          lut_info.dir_lut_size, &dir_lut_blob_id_);
   }
   if (lut_info.cir_lut_size) {
-    drmModeCreatePropertyBlob(fd_, reinterpret_cast<void *>(lut_info.cir_lut),
-                              lut_info.cir_lut_size, &cir_lut_blob_id_);
+    DRMBackend::Get()->CreatePropertyBlob(fd_, reinterpret_cast<void *>(lut_info.cir_lut),
+                                          lut_info.cir_lut_size, &cir_lut_blob_id_);
   }
   if (lut_info.sep_lut_size) {
-    drmModeCreatePropertyBlob(fd_, reinterpret_cast<void *>(lut_info.sep_lut),
-                              lut_info.sep_lut_size, &sep_lut_blob_id_);
+    DRMBackend::Get()->CreatePropertyBlob(fd_, reinterpret_cast<void *>(lut_info.sep_lut),
+                                          lut_info.sep_lut_size, &sep_lut_blob_id_);
   }
 }
 
 void DRMPlaneManager::UnsetScalerLUT() {
   if (dir_lut_blob_id_) {
-    drmModeDestroyPropertyBlob(fd_, dir_lut_blob_id_);
+    DRMBackend::Get()->DestroyPropertyBlob(fd_, dir_lut_blob_id_);
     dir_lut_blob_id_ = 0;
   }
   if (cir_lut_blob_id_) {
-    drmModeDestroyPropertyBlob(fd_, cir_lut_blob_id_);
+    DRMBackend::Get()->DestroyPropertyBlob(fd_, cir_lut_blob_id_);
     cir_lut_blob_id_ = 0;
   }
   if (sep_lut_blob_id_) {
-    drmModeDestroyPropertyBlob(fd_, sep_lut_blob_id_);
+    DRMBackend::Get()->DestroyPropertyBlob(fd_, sep_lut_blob_id_);
     sep_lut_blob_id_ = 0;
   }
 }
@@ -546,7 +563,7 @@ void DRMPlane::GetTypeInfo(const PropertyMap &prop_map) {
   DRMPlaneTypeInfo *info = &plane_type_info_;
   // Ideally we should check if this property type is a blob and then proceed.
   std::tie(blob_id, prop) = prop_map.at(DRMProperty::CAPABILITIES);
-  drmModePropertyBlobRes *blob = drmModeGetPropertyBlob(fd_, blob_id);
+  drmModePropertyBlobRes *blob = DRMBackend::Get()->GetPropertyBlob(fd_, blob_id);
   if (!blob) {
     return;
   }
@@ -665,14 +682,14 @@ void DRMPlane::ParseProperties() {
   bool scaler = false;
   bool cursor = false;
   drmModeObjectProperties *props =
-      drmModeObjectGetProperties(fd_, drm_plane_->plane_id, DRM_MODE_OBJECT_PLANE);
+      DRMBackend::Get()->GetObjectProperties(fd_, drm_plane_->plane_id, DRM_MODE_OBJECT_PLANE);
   if (!props || !props->props || !props->prop_values) {
     drmModeFreeObjectProperties(props);
     return;
   }
 
   for (uint32_t j = 0; j < props->count_props; j++) {
-    drmModePropertyRes *info = drmModeGetProperty(fd_, props->props[j]);
+    drmModePropertyRes *info = DRMBackend::Get()->GetProperty(fd_, props->props[j]);
     if (!info) {
       continue;
     }
@@ -1056,7 +1073,7 @@ void DRMPlane::Perform(DRMOps code, drmModeAtomicReq *req, va_list args) {
     case DRMOps::PLANE_SET_ROT_FB_ID: {
       uint32_t fb_id = va_arg(args, uint32_t);
       prop_id = prop_mgr_.GetPropertyId(DRMProperty::ROT_FB_ID);
-      drmModeAtomicAddProperty(req, obj_id, prop_id, fb_id);
+      DRMBackend::Get()->AtomicAddProperty(req, obj_id, prop_id, fb_id);
       DRM_LOGV("Plane %d: Setting rot_fb_id %d", obj_id, fb_id);
     } break;
 
@@ -76,6 +76,8 @@
 #include <map>
 #include <string>
 
+#include "drm_backend.h"
+#include "drm_blob_cache.h"
 #include "drm_pp_manager.h"
 #include "drm_property.h"
 
@@ -87,13 +89,11 @@ DRMPPManager::DRMPPManager(int fd) : fd_(fd) {
 
 DRMPPManager::~DRMPPManager() {
 #ifdef PP_DRM_ENABLE
-  DRMPPPropInfo prop_info = {};
-
-  /* free previously created blob to avoid memory leak */
+  /* drop references to blobs still held by features to avoid memory leak */
   for (int i = 0; i < kPPFeaturesMax; i++) {
-    prop_info = pp_prop_map_[i];
+    DRMPPPropInfo &prop_info = pp_prop_map_[i];
     if (prop_info.blob_id > 0) {
-      drmModeDestroyPropertyBlob(fd_, prop_info.blob_id);
+      DRMBlobCache::GetInstance()->Release(fd_, prop_info.blob_id);
       prop_info.blob_id = 0;
     }
   }
@@ -313,7 +313,7 @@ int DRMPPManager::SetPPRangeProperty(drmModeAtomicReq *req, uint32_t obj_id,
     return ret;
   }
   value = *((uint64_t *)feature.payload);
-  ret = drmModeAtomicAddProperty(req, obj_id, prop_info->prop_id, value);
+  ret = DRMBackend::Get()->AtomicAddProperty(req, obj_id, prop_info->prop_id, value);
   if (ret < 0) {
     DRM_LOGE("failed to add property ret %d id %d value %llu", ret, prop_info->prop_id, value);
   } else {
@@ -329,32 +329,27 @@ int DRMPPManager::SetPPBlobProperty(drmModeAtomicReq *req, uint32_t obj_id,
   int ret = DRM_ERR_INVALID;
 #ifdef PP_DRM_ENABLE
   uint32_t blob_id = 0;
+  DRMBlobCache *blob_cache = DRMBlobCache::GetInstance();
 
-  /* free previously created blob for this feature if exist */
-  if (prop_info->blob_id > 0) {
-    ret = drmModeDestroyPropertyBlob(fd_, prop_info->blob_id);
+  /* identical payloads share one blob, acquire before releasing the previous blob of this
+   * feature so that re-applying the same payload does not recreate it */
+  if (feature.payload) {
+    ret = blob_cache->Acquire(fd_, feature.payload, feature.payload_size, &blob_id);
     if (ret) {
-      DRM_LOGE("failed to destroy property blob for feature %d, ret = %d", feature.id, ret);
-      return ret;
-    } else {
-      prop_info->blob_id = 0;
+      DRM_LOGE("failed to get property blob for feature %d, ret = %d", feature.id, ret);
+      return DRM_ERR_INVALID;
     }
   }
 
-  if (!feature.payload) {
-    // feature disable case
-    drmModeAtomicAddProperty(req, obj_id, prop_info->prop_id, 0);
-    return 0;
-  }
-
-  ret = drmModeCreatePropertyBlob(fd_, feature.payload, feature.payload_size, &blob_id);
-  if (ret || blob_id == 0) {
-    DRM_LOGE("failed to create property blob ret %d, blob_id = %d", ret, blob_id);
-    return DRM_ERR_INVALID;
+  if (prop_info->blob_id > 0) {
+    blob_cache->Release(fd_, prop_info->blob_id);
+    prop_info->blob_id = 0;
   }
 
+  // blob_id 0 disables the feature
   prop_info->blob_id = blob_id;
-  drmModeAtomicAddProperty(req, obj_id, prop_info->prop_id, blob_id);
+  DRMBackend::Get()->AtomicAddProperty(req, obj_id, prop_info->prop_id, blob_id);
+  ret = 0;
 
 #endif
   return ret;
@@ -377,9 +372,9 @@ void DRMPPManager::SetPPEvent(uint32_t obj_id, DRMPPFeatureInfo &feature) {
   event_req.object_type = object_type_;
   event_req.event = feature.event_type;
   if (enable)
-    ret = drmIoctl(feature.drm_fd, DRM_IOCTL_MSM_REGISTER_EVENT, &event_req);
+    ret = DRMBackend::Get()->Ioctl(feature.drm_fd, DRM_IOCTL_MSM_REGISTER_EVENT, &event_req);
   else
-    ret = drmIoctl(feature.drm_fd, DRM_IOCTL_MSM_DEREGISTER_EVENT, &event_req);
+    ret = DRMBackend::Get()->Ioctl(feature.drm_fd, DRM_IOCTL_MSM_DEREGISTER_EVENT, &event_req);
   if (ret) {
     ret = -errno;
     if (ret == -EALREADY) {
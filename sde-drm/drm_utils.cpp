@@ -29,14 +29,21 @@
 
 #include <drm/drm_fourcc.h>
 #include <drm_utils.h>
+#include <ctype.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
 #include <regex>
 #include <sstream>
 #include <sstream>
 #include <string>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#include "drm_backend.h"
+
 using std::string;
 using std::stringstream;
 using std::regex;
@@ -88,6 +95,138 @@ void ParseFormats(const string &line, vector<pair<uint32_t, uint64_t>> *formats)
   }
 }
 
+bool DRMBlobToken::Equals(const char *str) const {
+  size_t len = strlen(str);
+  return (len == length) && !memcmp(data, str, len);
+}
+
+bool DRMBlobToken::Contains(const DRMBlobToken &key) const {
+  if (key.length > length) {
+    return false;
+  }
+  for (size_t i = 0; i + key.length <= length; i++) {
+    if (!memcmp(data + i, key.data, key.length)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+DRMBlobToken DRMBlobToken::Suffix(size_t offset) const {
+  if (offset >= length) {
+    return DRMBlobToken{data + length, 0};
+  }
+  return DRMBlobToken{data + offset, length - offset};
+}
+
+bool DRMBlobToken::ToInt(int64_t *value) const {
+  size_t i = 0;
+  while (i < length && isspace(static_cast<unsigned char>(data[i]))) {
+    i++;
+  }
+
+  bool negative = false;
+  if (i < length && (data[i] == '-' || data[i] == '+')) {
+    negative = (data[i] == '-');
+    i++;
+  }
+
+  uint64_t result = 0;
+  size_t digits = 0;
+  for (; i < length && isdigit(static_cast<unsigned char>(data[i])); i++, digits++) {
+    uint64_t digit = static_cast<uint64_t>(data[i] - '0');
+    if (result > (static_cast<uint64_t>(INT64_MAX) - digit) / 10) {
+      return false;
+    }
+    result = result * 10 + digit;
+  }
+
+  if (!digits) {
+    return false;
+  }
+
+  *value = negative ? -static_cast<int64_t>(result) : static_cast<int64_t>(result);
+  return true;
+}
+
+DRMBlobLineReader::DRMBlobLineReader(const void *data, size_t length) {
+  if (!data) {
+    return;
+  }
+  cur_ = static_cast<const char *>(data);
+  const char *nul = static_cast<const char *>(memchr(cur_, '\0', length));
+  end_ = nul ? nul : cur_ + length;
+}
+
+bool DRMBlobLineReader::Next(DRMBlobToken *line) {
+  if (cur_ >= end_) {
+    return false;
+  }
+
+  const char *eol = static_cast<const char *>(memchr(cur_, '\n', static_cast<size_t>(end_ - cur_)));
+  if (!eol) {
+    eol = end_;
+  }
+  *line = DRMBlobToken{cur_, static_cast<size_t>(eol - cur_)};
+  cur_ = (eol < end_) ? eol + 1 : end_;
+  return true;
+}
+
+bool DRMBlobLineReader::NextWord(DRMBlobToken *line, DRMBlobToken *word) {
+  size_t i = 0;
+  while (i < line->length && isspace(static_cast<unsigned char>(line->data[i]))) {
+    i++;
+  }
+  size_t start = i;
+  while (i < line->length && !isspace(static_cast<unsigned char>(line->data[i]))) {
+    i++;
+  }
+  if (start == i) {
+    return false;
+  }
+
+  *word = DRMBlobToken{line->data + start, i - start};
+  *line = line->Suffix(i);
+  return true;
+}
+
+void ParallelFor(size_t count, uint32_t max_threads, const std::function<void(size_t)> &fn) {
+  size_t num_threads = std::min(count, static_cast<size_t>(max_threads));
+  if (num_threads <= 1) {
+    for (size_t i = 0; i < count; i++) {
+      fn(i);
+    }
+    return;
+  }
+
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (size_t i = next++; i < count; i = next++) {
+      fn(i);
+    }
+  };
+
+  vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (size_t i = 1; i < num_threads; i++) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+static std::atomic<uint32_t> s_init_threads(SDE_DRM_INIT_THREADS);
+
+uint32_t GetInitThreads() {
+  return s_init_threads;
+}
+
+void SetInitThreads(uint32_t threads) {
+  s_init_threads = std::max(threads, 1u);
+}
+
 void Tokenize(const std::string &str, std::vector<std::string> *tokens, char delim) {
   size_t pos = 0;
   std::string str_temp(str);
@@ -108,7 +247,7 @@ void AddProperty(drmModeAtomicReqPtr req, uint32_t object_id, uint32_t property_
   auto it = prop_val_map.find(property_id);
   if (it == prop_val_map.end() || it->second != value)
 #endif
-    drmModeAtomicAddProperty(req, object_id, property_id, value);
+    DRMBackend::Get()->AtomicAddProperty(req, object_id, property_id, value);
 #ifndef SDM_VIRTUAL_DRIVER
   if (cache)
     prop_val_map[property_id] = value;
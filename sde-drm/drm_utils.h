@@ -33,11 +33,17 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <xf86drmMode.h>
+#include <functional>
 #include <string>
 #include <utility>
 #include <vector>
 #include <unordered_map>
 
+// Upper bound of threads used to parse DRM objects during DRMManager::Init. 1 parses serially.
+#ifndef SDE_DRM_INIT_THREADS
+#define SDE_DRM_INIT_THREADS 4
+#endif
+
 namespace sde_drm {
 
 enum struct DRMStatus {
@@ -45,7 +51,49 @@ enum struct DRMStatus {
   FREE,
 };
 
+// Non-owning view over a run of characters in a property blob. Lets blob parsers walk the kernel
+// provided text without copying it into std::string / std::stringstream.
+struct DRMBlobToken {
+  const char *data;
+  size_t length;
+
+  bool Equals(const char *str) const;
+  // Mirrors std::string::find() != npos, i.e. key may occur anywhere in the token.
+  bool Contains(const DRMBlobToken &key) const;
+  DRMBlobToken Suffix(size_t offset) const;
+  // Mirrors std::stol(): skips leading blanks, accepts an optional sign and decimal digits and
+  // stops at the first non digit. Returns false instead of throwing when there are no digits.
+  bool ToInt(int64_t *value) const;
+};
+
+template <size_t N>
+constexpr DRMBlobToken BlobKey(const char (&str)[N]) {
+  return DRMBlobToken{str, N - 1};
+}
+
+// Splits a property blob into '\n' separated lines. Like the C string it is usually read as,
+// the blob ends at its first NUL byte.
+class DRMBlobLineReader {
+ public:
+  DRMBlobLineReader(const void *data, size_t length);
+  bool Next(DRMBlobToken *line);
+  // Splits a line into blank separated words.
+  static bool NextWord(DRMBlobToken *line, DRMBlobToken *word);
+
+ private:
+  const char *cur_ = nullptr;
+  const char *end_ = nullptr;
+};
+
 void ParseFormats(const std::string &line, std::vector<std::pair<uint32_t, uint64_t>> *formats);
+// Calls fn for every index in [0, count) using up to max_threads threads, the calling thread
+// included, and returns once all calls are done. fn must only touch per-index state or
+// synchronize itself; results should be merged by index afterwards to stay deterministic.
+void ParallelFor(size_t count, uint32_t max_threads, const std::function<void(size_t)> &fn);
+// Threads DRMManager::Init parses DRM objects with, SDE_DRM_INIT_THREADS unless overridden. The
+// override only applies to DRMManager instances created afterwards.
+uint32_t GetInitThreads();
+void SetInitThreads(uint32_t threads);
 void Tokenize(const std::string &str, std::vector<std::string> *tokens, char delim);
 void AddProperty(drmModeAtomicReqPtr req, uint32_t object_id, uint32_t property_id, uint64_t value,
                  bool cache, std::unordered_map<uint32_t, uint64_t> &prop_val_map);
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "drm_utils.h"
+using namespace testing;
+using sde_drm::DRMBlobLineReader;
+using sde_drm::DRMBlobToken;
+
+namespace {
+
+std::string str(const DRMBlobToken &token) {
+  return std::string(token.data, token.length);
+}
+
+std::vector<std::string> lines(const void *data, size_t length) {
+  std::vector<std::string> result;
+  DRMBlobLineReader reader(data, length);
+  DRMBlobToken line = {};
+  while (reader.Next(&line)) {
+    result.push_back(str(line));
+  }
+  return result;
+}
+
+std::vector<std::string> lines(const std::string &blob) {
+  return lines(blob.data(), blob.size());
+}
+
+std::vector<std::string> words(const std::string &text) {
+  std::vector<std::string> result;
+  DRMBlobToken line = {text.data(), text.size()};
+  DRMBlobToken word = {};
+  while (DRMBlobLineReader::NextWord(&line, &word)) {
+    result.push_back(str(word));
+  }
+  return result;
+}
+
+DRMBlobToken token(const std::string &text) {
+  return DRMBlobToken{text.data(), text.size()};
+}
+
+}  // namespace
+
+TEST(DRMBlobLineReaderTestCases, SplitsLines) {
+  EXPECT_THAT(lines("a=1\nb=2\nc=3"), ElementsAre("a=1", "b=2", "c=3"));
+  EXPECT_THAT(lines("a=1\nb=2\n"), ElementsAre("a=1", "b=2"));
+  EXPECT_THAT(lines("a\n\nb"), ElementsAre("a", "", "b"));
+  EXPECT_THAT(lines("\n"), ElementsAre(""));
+}
+
+TEST(DRMBlobLineReaderTestCases, EmptyBlob) {
+  EXPECT_THAT(lines(""), IsEmpty());
+  EXPECT_THAT(lines(nullptr, 16), IsEmpty());
+}
+
+TEST(DRMBlobLineReaderTestCases, StopsAtNul) {
+  const char blob[] = "a=1\nb=2\0c=3\n";
+  EXPECT_THAT(lines(blob, sizeof(blob)), ElementsAre("a=1", "b=2"));
+  EXPECT_THAT(lines(blob, 3), ElementsAre("a=1"));
+}
+
+TEST(DRMBlobLineReaderTestCases, SplitsWords) {
+  EXPECT_THAT(words("100 200  300"), ElementsAre("100", "200", "300"));
+  EXPECT_THAT(words("  \t100\t200 "), ElementsAre("100", "200"));
+  EXPECT_THAT(words("   "), IsEmpty());
+  EXPECT_THAT(words(""), IsEmpty());
+}
+
+TEST(DRMBlobTokenTestCases, Matching) {
+  std::string line = "partial_update_xstart=4";
+  EXPECT_TRUE(token(line).Contains(sde_drm::BlobKey("xstart=")));
+  EXPECT_TRUE(token(line).Contains(sde_drm::BlobKey("partial_update_xstart=4")));
+  EXPECT_FALSE(token(line).Contains(sde_drm::BlobKey("partial_update_xstart=40")));
+  EXPECT_FALSE(token(line).Contains(sde_drm::BlobKey("ystart=")));
+  EXPECT_TRUE(token("vfp").Equals("vfp"));
+  EXPECT_FALSE(token("vfp").Equals("vf"));
+  EXPECT_FALSE(token("vf").Equals("vfp"));
+  EXPECT_THAT(str(token(line).Suffix(22)), Eq("4"));
+  EXPECT_THAT(token(line).Suffix(100).length, Eq(0u));
+}
+
+TEST(DRMBlobTokenTestCases, ToIntMirrorsStol) {
+  int64_t value = 0;
+  EXPECT_TRUE(token("42").ToInt(&value));
+  EXPECT_THAT(value, Eq(42));
+  EXPECT_TRUE(token("  -17").ToInt(&value));
+  EXPECT_THAT(value, Eq(-17));
+  EXPECT_TRUE(token("+5").ToInt(&value));
+  EXPECT_THAT(value, Eq(5));
+  EXPECT_TRUE(token("1200000000 extra").ToInt(&value));
+  EXPECT_THAT(value, Eq(1200000000));
+  EXPECT_TRUE(token("9223372036854775807").ToInt(&value));
+  EXPECT_THAT(value, Eq(INT64_MAX));
+
+  value = 7;
+  EXPECT_FALSE(token("").ToInt(&value));
+  EXPECT_FALSE(token("abc").ToInt(&value));
+  EXPECT_FALSE(token("-").ToInt(&value));
+  EXPECT_FALSE(token("9223372036854775808").ToInt(&value));
+  EXPECT_THAT(value, Eq(7));
+}
@@ -37,6 +37,7 @@
 #ifndef __BUFFER_SYNC_HANDLER_H__
 #define __BUFFER_SYNC_HANDLER_H__
 
+#include <stdint.h>
 #include <sstream>
 
 namespace sdm {
@@ -88,6 +89,18 @@ class BufferSyncHandler {
  */
   virtual void GetSyncInfo(int fd, std::ostringstream *os) = 0;
 
+  /*! @brief Method to get the time at which a sync fd was signaled
+
+    @details This method returns the CLOCK_MONOTONIC time at which the last fence of the given
+    sync fd was signaled. It fails with -EAGAIN if the fd has not signaled yet.
+
+    @param[in] fd file descriptor
+    @param[out] signal_time_ns signal time in nanoseconds
+
+    @return \link int \endlink
+ */
+  virtual int GetSignalTime(int fd, int64_t *signal_time_ns) = 0;
+
  protected:
   virtual ~BufferSyncHandler() { }
 };
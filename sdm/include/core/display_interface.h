@@ -414,6 +414,26 @@ struct QsyncEventData {
   uint32_t qsync_refresh_rate = 0;
 };
 
+/*! @brief This structure defines the content statistics derived from the color sampling
+  histogram of a display. Luma bins run from 0 to 255.
+
+  @sa DisplayInterface::SetContentStats
+*/
+struct DisplayContentStats {
+  uint64_t frame_count = 0;            //!< Histogram frames analyzed since sampling was enabled
+  int64_t timestamp = 0;               //!< Arrival of the latest frame, monotonic ns
+  uint32_t window_frames = 0;          //!< Frames covered by the rolling statistics
+  float mean_luma = 0.0f;              //!< Rolling mean luma, 0.0 to 1.0
+  uint32_t p10_luma = 0;               //!< Rolling 10th percentile luma bin
+  uint32_t p50_luma = 0;               //!< Rolling median luma bin
+  uint32_t p90_luma = 0;               //!< Rolling 90th percentile luma bin
+  bool dark = false;                   //!< Rolling window is a dark scene
+  bool static_content = false;         //!< Latest frames are not changing
+  bool scene_cut = false;              //!< Latest frame is a scene cut
+  uint64_t scene_cuts = 0;             //!< Scene cuts since sampling was enabled
+  int64_t last_scene_cut = 0;          //!< Timestamp of the latest scene cut
+};
+
 /*! @brief Display device event handler implemented by the client.
 
   @details This class declares prototype for display device event handler methods which must be
@@ -1308,6 +1328,16 @@ class DisplayInterface {
   */
   virtual DisplayError PostHandleSecureEvent(SecureEvent secure_event) = 0;
 
+  /*! @brief Method to publish the content statistics of the color sampling histogram.
+
+    @details Called from the histogram collection thread for every analyzed frame.
+
+    @param[in] stats \link DisplayContentStats \endlink
+
+    @return \link DisplayError \endlink
+  */
+  virtual DisplayError SetContentStats(const DisplayContentStats &stats) = 0;
+
   virtual void Abort() = 0;
 
  protected:
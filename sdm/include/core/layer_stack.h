@@ -553,6 +553,16 @@ struct CwbConfig {
   void *dither_info = nullptr;                       //!< Pointer to the cwb dither setting.
 };
 
+/*! @brief This structure holds SDM processing times of a frame, for client side frame tracing.
+
+  @sa LayerStack
+*/
+struct LayerStackTimings {
+  uint32_t strategy_us = 0;     //!< Time spent selecting a composition strategy in Prepare().
+  uint32_t hw_commit_us = 0;    //!< Time spent committing the frame to hardware in Commit().
+  uint32_t fence_wait_us = 0;   //!< Time spent blocked on fences during Commit().
+};
+
 /*! @brief This structure defines a layer stack that contains layers which need to be composed and
   rendered onto the target.
 
@@ -608,6 +618,9 @@ struct LayerStack {
   LayerStackRequestFlags request_flags;  //!< request flags on this LayerStack by SDM.
 
   uint32_t force_refresh_rate = 0;
+
+  LayerStackTimings timings;           //!< o/p - SDM processing times of the frame, updated by SDM.
+                                       //!< Commit timings are not reported for async commits.
 };
 
 }  // namespace sdm
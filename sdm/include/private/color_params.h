@@ -601,6 +601,7 @@ class PPFeaturesConfig {
         feature_[feature_id] = NULL;
       }
       feature_[feature_id] = feature;
+      payload_tag_[feature_id] = 0;
     }
     return kErrorNone;
   }
@@ -636,6 +637,27 @@ class PPFeaturesConfig {
   inline void MarkSwAssetDirty() { sw_asset_dirty_ = true; }
   inline void ClearSwAssertDirty() { sw_asset_dirty_ = false; }
 
+  // A nonzero tag promises that the feature config is the same for every feature tagged with it,
+  // so the consumer may reuse what it packed for the tag before. Replacing the feature drops it.
+  inline void SetPayloadTag(uint32_t feature_id, uint64_t tag) {
+    if (feature_id < kMaxNumPPFeatures && feature_[feature_id]) {
+      payload_tag_[feature_id] = tag;
+    }
+  }
+  inline uint64_t GetPayloadTag(const PPFeatureInfo *feature) {
+    uint32_t id = feature->feature_id_;
+    return (id < kMaxNumPPFeatures && feature_[id] == feature) ? payload_tag_[id] : 0;
+  }
+
+  // Outcome of the last SetPPFeatures, one bit per PPGlobalColorFeatureID: features written to
+  // the hardware, and features left out since the hardware held their payloads already.
+  inline void SetCommitMasks(uint32_t dirty_mask, uint32_t clean_mask) {
+    dirty_mask_ = dirty_mask;
+    clean_mask_ = clean_mask;
+  }
+  inline uint32_t GetDirtyMask() { return dirty_mask_; }
+  inline uint32_t GetCleanMask() { return clean_mask_; }
+
  private:
   bool dirty_ = 0;
   bool disable_pu_ = false;
@@ -645,6 +667,9 @@ class PPFeaturesConfig {
   PPFrameCaptureData frame_capture_data;
   PPDETuningCfgData de_tuning_data_ = {};
   bool sw_asset_dirty_ = false;
+  uint64_t payload_tag_[kMaxNumPPFeatures] = {};
+  uint32_t dirty_mask_ = 0;
+  uint32_t clean_mask_ = 0;
 };
 
 }  // namespace sdm
@@ -88,6 +88,9 @@ class Fence {
   // Status check on null fence will return signaled.
   static Status GetStatus(const shared_ptr<Fence> &fence);
 
+  // CLOCK_MONOTONIC signal time of the fence, fails with -EAGAIN while the fence is pending.
+  static int GetSignalTime(const shared_ptr<Fence> &fence, int64_t *signal_time_ns);
+
   static string GetStr(const shared_ptr<Fence> &fence);
 
   // Write all fences info to the output stream.
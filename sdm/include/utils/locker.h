@@ -29,66 +29,156 @@
 #include <errno.h>
 #include <pthread.h>
 #include <sys/time.h>
+#include <atomic>
+#include <sstream>
 
-#define SCOPE_LOCK(locker) Locker::ScopeLock lock(locker)
-#define SEQUENCE_ENTRY_SCOPE_LOCK(locker) Locker::SequenceEntryScopeLock lock(locker)
-#define SEQUENCE_EXIT_SCOPE_LOCK(locker) Locker::SequenceExitScopeLock lock(locker)
-#define SEQUENCE_WAIT_SCOPE_LOCK(locker) Locker::SequenceWaitScopeLock lock(locker)
-#define SEQUENCE_CANCEL_SCOPE_LOCK(locker) Locker::SequenceCancelScopeLock lock(locker)
+// Every scoped lock macro expansion is a lock site with its own contention statistics.
+#define LOCK_SITE_DECLARE static LockSite lock_site(__FILE__, __func__, __LINE__)
+#define SCOPE_LOCK(locker) LOCK_SITE_DECLARE; \
+                           Locker::ScopeLock lock(locker, &lock_site)
+#define TIMED_SCOPE_LOCK(locker, ms) LOCK_SITE_DECLARE; \
+                                     Locker::TimedScopeLock lock(locker, ms, &lock_site)
+#define SEQUENCE_ENTRY_SCOPE_LOCK(locker) LOCK_SITE_DECLARE; \
+                                          Locker::SequenceEntryScopeLock lock(locker, &lock_site)
+#define SEQUENCE_EXIT_SCOPE_LOCK(locker) LOCK_SITE_DECLARE; \
+                                         Locker::SequenceExitScopeLock lock(locker, &lock_site)
+#define SEQUENCE_WAIT_SCOPE_LOCK(locker) LOCK_SITE_DECLARE; \
+                                         Locker::SequenceWaitScopeLock lock(locker, &lock_site)
+#define SEQUENCE_CANCEL_SCOPE_LOCK(locker) LOCK_SITE_DECLARE; \
+                                           Locker::SequenceCancelScopeLock lock(locker, &lock_site)
 
 namespace sdm {
 
+// Contention statistics of one scoped lock site, collected only while enabled. Sites register
+// themselves on first use and live for the life of the process.
+class LockSite {
+ public:
+  // A copy of the counters, each read once. Not a consistent cut, writers keep running.
+  struct Snapshot {
+    const LockSite *site = nullptr;
+    uint64_t acquisitions = 0;
+    uint64_t contended = 0;
+    uint64_t wait_ns = 0;
+    uint64_t max_wait_ns = 0;
+    uint64_t holds = 0;
+    uint64_t hold_ns = 0;
+    uint64_t max_hold_ns = 0;
+    const LockSite *last_blocker = nullptr;
+  };
+
+  LockSite(const char *file, const char *function, int line);
+
+  static void EnableStats(bool enable) { stats_enabled_.store(enable, std::memory_order_relaxed); }
+  static bool StatsEnabled() { return stats_enabled_.load(std::memory_order_relaxed); }
+  // Lists the count sites with the highest total wait time.
+  static void Dump(std::ostringstream *os, size_t count);
+  static void Reset();
+
+  // wait_ns is 0 when the lock was taken without contention.
+  void RecordAcquire(uint64_t wait_ns, const LockSite *blocker);
+  void RecordHold(uint64_t hold_ns);
+  void GetSnapshot(Snapshot *snapshot) const;
+  // file.cpp:line function, with the directories of __FILE__ stripped.
+  void GetName(std::ostringstream *os) const;
+
+ private:
+  static void UpdateMax(std::atomic<uint64_t> *max, uint64_t value);
+
+  static std::atomic<bool> stats_enabled_;
+  static std::atomic<LockSite *> head_;
+
+  const char *file_;
+  const char *function_;
+  int line_;
+  LockSite *next_ = nullptr;
+  std::atomic<uint64_t> acquisitions_ {0};
+  std::atomic<uint64_t> contended_ {0};
+  std::atomic<uint64_t> wait_ns_ {0};
+  std::atomic<uint64_t> max_wait_ns_ {0};
+  std::atomic<uint64_t> holds_ {0};  // acquisitions plus reacquisitions after condition waits
+  std::atomic<uint64_t> hold_ns_ {0};
+  std::atomic<uint64_t> max_hold_ns_ {0};
+  std::atomic<const LockSite *> last_blocker_ {nullptr};  // owner when this site last waited
+};
+
 class Locker {
  public:
   class ScopeLock {
    public:
-    explicit ScopeLock(Locker& locker) : locker_(locker) {
-      locker_.Lock();
+    explicit ScopeLock(Locker& locker, LockSite *site = nullptr) : locker_(locker) {
+      tracked_ = locker_.Lock(site);
     }
 
     ~ScopeLock() {
-      locker_.Unlock();
+      locker_.Unlock(tracked_);
     }
 
    private:
     Locker &locker_;
+    bool tracked_ = false;
+  };
+
+  // Gives up if the lock stays owned for ms, the scope then runs without it.
+  class TimedScopeLock {
+   public:
+    TimedScopeLock(Locker& locker, uint32_t ms, LockSite *site = nullptr) : locker_(locker) {
+      locked_ = (locker_.TimedLock(ms, site, &tracked_) == 0);
+    }
+
+    ~TimedScopeLock() {
+      if (locked_) {
+        locker_.Unlock(tracked_);
+      }
+    }
+
+    bool IsLocked() {
+      return locked_;
+    }
+
+   private:
+    Locker &locker_;
+    bool locked_ = false;
+    bool tracked_ = false;
   };
 
   class SequenceEntryScopeLock {
    public:
-    explicit SequenceEntryScopeLock(Locker& locker) : locker_(locker) {
-      locker_.Lock();
+    explicit SequenceEntryScopeLock(Locker& locker, LockSite *site = nullptr) : locker_(locker) {
+      tracked_ = locker_.Lock(site);
       locker_.sequence_wait_ = 1;
     }
 
     ~SequenceEntryScopeLock() {
-      locker_.Unlock();
+      locker_.Unlock(tracked_);
     }
 
    private:
     Locker &locker_;
+    bool tracked_ = false;
   };
 
   class SequenceExitScopeLock {
    public:
-    explicit SequenceExitScopeLock(Locker& locker) : locker_(locker) {
-      locker_.Lock();
+    explicit SequenceExitScopeLock(Locker& locker, LockSite *site = nullptr) : locker_(locker) {
+      tracked_ = locker_.Lock(site);
       locker_.sequence_wait_ = 0;
     }
 
     ~SequenceExitScopeLock() {
       locker_.Broadcast();
-      locker_.Unlock();
+      locker_.Unlock(tracked_);
     }
 
    private:
     Locker &locker_;
+    bool tracked_ = false;
   };
 
   class SequenceWaitScopeLock {
    public:
-    explicit SequenceWaitScopeLock(Locker& locker) : locker_(locker), error_(false) {
-      locker_.Lock();
+    explicit SequenceWaitScopeLock(Locker& locker, LockSite *site = nullptr)
+      : locker_(locker), error_(false) {
+      tracked_ = locker_.Lock(site);
 
       while (locker_.sequence_wait_ == 1) {
         locker_.Wait();
@@ -97,7 +187,7 @@ class Locker {
     }
 
     ~SequenceWaitScopeLock() {
-      locker_.Unlock();
+      locker_.Unlock(tracked_);
     }
 
     bool IsError() {
@@ -107,33 +197,28 @@ class Locker {
    private:
     Locker &locker_;
     bool error_;
+    bool tracked_ = false;
   };
 
   class SequenceCancelScopeLock {
    public:
-    explicit SequenceCancelScopeLock(Locker& locker) : locker_(locker) {
-      locker_.Lock();
+    explicit SequenceCancelScopeLock(Locker& locker, LockSite *site = nullptr) : locker_(locker) {
+      tracked_ = locker_.Lock(site);
       locker_.sequence_wait_ = -1;
     }
 
     ~SequenceCancelScopeLock() {
       locker_.Broadcast();
-      locker_.Unlock();
+      locker_.Unlock(tracked_);
     }
 
    private:
     Locker &locker_;
+    bool tracked_ = false;
   };
 
   Locker() : sequence_wait_(0) {
-#ifdef SDM_VIRTUAL_DRIVER
-    pthread_mutexattr_t attr;
-    pthread_mutexattr_init(&attr);
-    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
-    pthread_mutex_init(&mutex_, &attr);
-#else
-    pthread_mutex_init(&mutex_, 0);
-#endif
+    InitMutex(PTHREAD_PRIO_NONE);
     pthread_condattr_init(&cond_attr_);
     pthread_condattr_setclock(&cond_attr_, CLOCK_MONOTONIC);
     pthread_cond_init(&condition_, &cond_attr_);
@@ -145,12 +230,33 @@ class Locker {
     pthread_condattr_destroy(&cond_attr_);
   }
 
+  // Switches the mutex to priority inheritance, so that a real time thread blocked on the lock
+  // boosts the owner. Must be called before the locker is first used.
+  int EnablePriorityInheritance() {
+    pthread_mutex_destroy(&mutex_);
+    return InitMutex(PTHREAD_PRIO_INHERIT);
+  }
+
   void Lock() { pthread_mutex_lock(&mutex_); }
   int32_t TryLock() { return pthread_mutex_trylock(&mutex_); }
+  int TimedLock(uint32_t ms) {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_REALTIME, &ts)) {
+       return EINVAL;
+    }
+    uint64_t ns = (uint64_t)ts.tv_nsec + (ms * 1000000L);
+    ts.tv_sec   = ts.tv_sec + (time_t)(ns / 1000000000L);
+    ts.tv_nsec  = ns % 1000000000L;
+    return pthread_mutex_timedlock(&mutex_, &ts);
+  }
   void Unlock() { pthread_mutex_unlock(&mutex_); }
   void Signal() { pthread_cond_signal(&condition_); }
   void Broadcast() { pthread_cond_broadcast(&condition_); }
-  void Wait() { pthread_cond_wait(&condition_, &mutex_); }
+  void Wait() {
+    LockSite *site = SuspendHold();
+    pthread_cond_wait(&condition_, &mutex_);
+    ResumeHold(site);
+  }
   int WaitFinite(uint32_t ms) {
     struct timespec ts;
     if (clock_gettime(CLOCK_MONOTONIC, &ts)) {
@@ -159,10 +265,100 @@ class Locker {
     uint64_t ns = (uint64_t)ts.tv_nsec + (ms * 1000000L);
     ts.tv_sec   = ts.tv_sec + (time_t)(ns / 1000000000L);
     ts.tv_nsec  = ns % 1000000000L;
-    return pthread_cond_timedwait(&condition_, &mutex_, &ts);
+    LockSite *site = SuspendHold();
+    int ret = pthread_cond_timedwait(&condition_, &mutex_, &ts);
+    ResumeHold(site);
+    return ret;
   }
 
  private:
+  static int64_t GetTimeNs() {
+    struct timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t(ts.tv_sec) * 1000000000LL) + ts.tv_nsec;
+  }
+
+  int InitMutex(int protocol) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+#ifdef SDM_VIRTUAL_DRIVER
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+#endif
+    int ret = pthread_mutexattr_setprotocol(&attr, protocol);
+    pthread_mutex_init(&mutex_, &attr);
+    pthread_mutexattr_destroy(&attr);
+    return ret;
+  }
+
+  // Returns true if the acquisition is accounted to site and Unlock has to close it.
+  bool Lock(LockSite *site) {
+    if (!site || !LockSite::StatsEnabled()) {
+      Lock();
+      return false;
+    }
+
+    if (TryLock()) {
+      const LockSite *blocker = owner_site_.load(std::memory_order_relaxed);
+      int64_t wait_start_ns = GetTimeNs();
+      Lock();
+      site->RecordAcquire(uint64_t(GetTimeNs() - wait_start_ns), blocker);
+    } else {
+      site->RecordAcquire(0, nullptr);
+    }
+    ResumeHold(site);
+    return true;
+  }
+
+  // Lock(site) that returns ETIMEDOUT if the lock stays owned for ms. A timed out attempt is not
+  // recorded.
+  int TimedLock(uint32_t ms, LockSite *site, bool *tracked) {
+    *tracked = false;
+    int64_t wait_start_ns = 0;
+    const LockSite *blocker = nullptr;
+    if (TryLock()) {
+      blocker = owner_site_.load(std::memory_order_relaxed);
+      wait_start_ns = GetTimeNs();
+      int ret = TimedLock(ms);
+      if (ret) {
+        return ret;
+      }
+    }
+
+    if (site && LockSite::StatsEnabled()) {
+      site->RecordAcquire(wait_start_ns ? uint64_t(GetTimeNs() - wait_start_ns) : 0, blocker);
+      ResumeHold(site);
+      *tracked = true;
+    }
+    return 0;
+  }
+
+  void Unlock(bool tracked) {
+    if (tracked) {
+      SuspendHold();
+    }
+    Unlock();
+  }
+
+  // The mutex is released while waiting on the condition, which ends the current hold. Other
+  // sites may own the lock in between, so the hold is restarted for the waiting site after.
+  LockSite *SuspendHold() {
+    LockSite *site = hold_site_;
+    if (site) {
+      site->RecordHold(uint64_t(GetTimeNs() - hold_start_ns_));
+      owner_site_.store(nullptr, std::memory_order_relaxed);
+      hold_site_ = nullptr;
+    }
+    return site;
+  }
+
+  void ResumeHold(LockSite *site) {
+    if (site) {
+      owner_site_.store(site, std::memory_order_relaxed);
+      hold_site_ = site;
+      hold_start_ns_ = GetTimeNs();
+    }
+  }
+
   pthread_mutex_t mutex_;
   pthread_cond_t condition_;
   pthread_condattr_t cond_attr_;
@@ -171,6 +367,11 @@ class Locker {
                         // so that capturing a transitionary snapshot of context is prevented.
                         // If flag is set to -1, these routines will exit without doing any
                         // further processing.
+  // Accounting of the current owner, written with the mutex held. owner_site_ is also read by
+  // waiters to tag who they were blocked by.
+  std::atomic<const LockSite *> owner_site_ {nullptr};
+  LockSite *hold_site_ = nullptr;
+  int64_t hold_start_ns_ = 0;
 };
 
 }  // namespace sdm
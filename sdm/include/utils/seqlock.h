@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __SEQLOCK_H__
+#define __SEQLOCK_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+namespace sdm {
+
+// Single writer, multiple reader snapshot of a trivially copyable value. The writer never waits
+// for readers; a reader that races a write retries its copy. Payload words are stored as relaxed
+// atomics so concurrent copies are well defined, ordering comes from the sequence counter.
+template <class T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock needs a trivially copyable type");
+
+ public:
+  SeqLock() { Write(T()); }
+
+  // Callers must serialize writes.
+  void Write(const T &value) {
+    uint64_t words[kWords] = {};
+    memcpy(words, &value, sizeof(T));
+
+    uint32_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWords; i++) {
+      data_[i].store(words[i], std::memory_order_relaxed);
+    }
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  // Returns the sequence number of the copied value, it advances by two on every write.
+  uint32_t Read(T *value) const {
+    uint64_t words[kWords];
+    uint32_t begin = 0;
+    uint32_t end = 0;
+
+    do {
+      begin = seq_.load(std::memory_order_acquire);
+      if (begin & 1) {
+        continue;
+      }
+      for (size_t i = 0; i < kWords; i++) {
+        words[i] = data_[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      end = seq_.load(std::memory_order_relaxed);
+    } while ((begin & 1) || begin != end);
+
+    memcpy(value, words, sizeof(T));
+
+    return begin;
+  }
+
+ private:
+  static const size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  std::atomic<uint32_t> seq_ {0};
+  std::atomic<uint64_t> data_[kWords];
+};
+
+}  // namespace sdm
+
+#endif  // __SEQLOCK_H__
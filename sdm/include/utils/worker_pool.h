@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __WORKER_POOL_H__
+#define __WORKER_POOL_H__
+
+#include <stdint.h>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace sdm {
+
+// Each lane is served by one thread which is started on first use. Work on a lane runs in
+// posting order, work on different lanes runs concurrently.
+enum WorkerLane {
+  kLaneHotplug,       // Pluggable display connect/disconnect handling
+  kLaneDisplayReset,  // Display power reset requested by the driver
+  kLaneNotify,        // Client notifications, e.g. concurrency fps
+  kLaneVmIPC,         // VM server ready handshakes
+  kLaneFrameDump,     // Frame dump file writes and frame timing lookups, background priority
+  kLaneMax,
+};
+
+class WorkerPool {
+ public:
+  typedef std::function<void()> Task;
+  static const uint64_t kNoCoalesce = 0;
+
+  static WorkerPool *GetInstance();
+
+  // Queues task on lane. When coalesce_key is set and a task with the same key is still waiting
+  // on the lane, the new task is dropped as a duplicate. Returns -EBUSY if the lane is full.
+  int Post(WorkerLane lane, Task task, uint64_t coalesce_key = kNoCoalesce);
+  // Blocks until all work queued on lane before the call has completed. Callers must not hold
+  // locks the queued work may need. Returns immediately when called from the lane itself.
+  void Drain(WorkerLane lane);
+  void Dump(std::ostringstream *os);
+
+ private:
+  struct PendingTask {
+    Task task;
+    uint64_t coalesce_key = kNoCoalesce;
+    uint64_t seq = 0;
+    std::chrono::steady_clock::time_point posted;
+  };
+
+  struct LaneStats {
+    uint64_t posted = 0;
+    uint64_t coalesced = 0;
+    uint64_t rejected = 0;
+    uint64_t completed = 0;
+    size_t max_depth = 0;
+    uint64_t total_wait_us = 0;
+    uint64_t max_wait_us = 0;
+    uint64_t max_run_us = 0;
+  };
+
+  struct Lane {
+    const char *name = "";
+    int priority = 0;
+    size_t max_depth = 0;
+    std::thread worker;
+    std::deque<PendingTask> queue;
+    uint64_t next_seq = 1;
+    uint64_t done_seq = 0;
+    LaneStats stats;
+  };
+
+  WorkerPool();
+  void WorkerThread(WorkerLane lane);
+
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  Lane lanes_[kLaneMax];
+};
+
+}  // namespace sdm
+
+#endif  // __WORKER_POOL_H__
@@ -28,6 +28,7 @@
  */
 
 #include <dlfcn.h>
+#include <inttypes.h>
 #include <private/color_interface.h>
 #include <utils/constants.h>
 #include <utils/debug.h>
@@ -48,6 +49,7 @@ DestroyColorInterface ColorManagerProxy::destroy_intf_ = NULL;
 HWResourceInfo ColorManagerProxy::hw_res_info_;
 
 GetScPostBlendInterface ColorManagerProxy::create_stc_intf_ = NULL;
+std::atomic<uint64_t> ColorManagerProxy::next_payload_tag_ {1};
 
 bool NeedsToneMap(const std::vector<Layer> &layers) {
   for (auto &layer : layers) {
@@ -66,6 +68,7 @@ void PPFeaturesConfig::Reset() {
       delete feature_[i];
       feature_[i] = NULL;
     }
+    payload_tag_[i] = 0;
   }
   dirty_ = false;
   next_idx_ = 0;
@@ -271,6 +274,9 @@ DisplayError ColorManagerProxy::ColorSVCRequestRoute(const PPDisplayAPIPayload &
                                                      PPPendingParams *pending_action) {
   DisplayError ret = kErrorNone;
 
+  // Tuning requests can change what the modes render to.
+  InvalidateModePayloads();
+
   // On completion, dspp_features_ will be populated and mark dirty with all resolved dspp
   // feature list with paramaters being transformed into target requirement.
   ret = color_intf_->ColorSVCRequestRoute(in_payload, out_payload, &pp_features_, pending_action);
@@ -355,12 +361,30 @@ DisplayError ColorManagerProxy::Commit() {
     feature_intf_->SetParams(kFeatureSwitchMode, &is_dirty);
   }
   if (is_dirty) {
+    pp_features_.SetCommitMasks(0, 0);
     ret = hw_intf_->SetPPFeatures(&pp_features_);
+    pp_dirty_mask_ = pp_features_.GetDirtyMask();
+    pp_clean_mask_ = pp_features_.GetCleanMask();
+    pp_commit_count_++;
+    pp_written_count_ += UINT64(__builtin_popcount(pp_dirty_mask_));
+    pp_skipped_count_ += UINT64(__builtin_popcount(pp_clean_mask_));
   }
 
   return ret;
 }
 
+std::string ColorManagerProxy::Dump() {
+  Locker &locker(pp_features_.GetLocker());
+  SCOPE_LOCK(locker);
+
+  char dump[128] = {};
+  snprintf(dump, sizeof(dump), "\nPP features dirty: 0x%x clean: 0x%x commits: %" PRIu64
+           " written: %" PRIu64 " skipped: %" PRIu64, pp_dirty_mask_, pp_clean_mask_,
+           pp_commit_count_, pp_written_count_, pp_skipped_count_);
+
+  return std::string(dump);
+}
+
 void PPHWAttributes::Set(const HWResourceInfo &hw_res,
                          const HWPanelInfo &panel_info,
                          const DisplayConfigVariableInfo &attr,
@@ -461,6 +485,7 @@ DisplayError ColorManagerProxy::ColorMgrSetColorTransform(uint32_t length,
   in_data.prop = snapdragoncolor::kSetColorTransform;
   in_data.len = sizeof(color_transform);
   in_data.payload = reinterpret_cast<uint64_t>(&color_transform);
+  InvalidateModePayloads();
   int result = stc_intf_->SetProperty(in_data);
   if (result) {
     DLOGE("Failed to SetProperty prop = %d, error = %d", in_data.prop, result);
@@ -604,6 +629,7 @@ DisplayError ColorManagerProxy::NotifyDisplayCalibrationMode(bool in_calibration
   payload.len = sizeof(in_calibration);
   payload.prop = kNotifyDisplayCalibrationMode;
   payload.payload = reinterpret_cast<uint64_t>(&in_calibration);
+  InvalidateModePayloads();
   int ret = stc_intf_->SetProperty(payload);
   if (ret) {
     DLOGE("Failed to SetProperty, property = %d error = %d", payload.prop, ret);
@@ -660,6 +686,15 @@ DisplayError ColorManagerProxy::UpdateModeHwassets(int32_t mode_id,
   mode_params.color_mode = color_mode;
   mode_params.mode_id = mode_id;
 
+  // Without metadata or pending asset updates the output only depends on the mode, so the
+  // features get tagged for the driver to keep their packed payloads.
+  uint64_t payload_tag = 0;
+  if (needs_update_) {
+    InvalidateModePayloads();
+  } else if (!valid_meta_data) {
+    payload_tag = GetModePayloadTag(mode_id, color_mode);
+  }
+
   ScPayload in_data = {};
   ScPayload out_data = {};
   in_data.prop = kModeRenderInputParams;
@@ -675,15 +710,50 @@ DisplayError ColorManagerProxy::UpdateModeHwassets(int32_t mode_id,
     return kErrorUndefined;
   }
 
+  PPFeatureInfo *pending[kMaxNumPPFeatures] = {};
+  for (uint32_t i = 0; i < kMaxNumPPFeatures; i++) {
+    pending[i] = pp_features_.GetFeature(i);
+  }
+
   error = ConvertToPPFeatures(hw_params, &pp_features_);
   if (error != kErrorNone) {
     DLOGE("Failed to convert hw assets to PP features, error = %d", error);
     return kErrorUndefined;
   }
+
+  // Only the features added for this mode carry its tag.
+  for (uint32_t i = 0; payload_tag && i < kMaxNumPPFeatures; i++) {
+    PPFeatureInfo *feature = pp_features_.GetFeature(i);
+    if (feature && feature != pending[i]) {
+      pp_features_.SetPayloadTag(i, payload_tag);
+    }
+  }
   pp_features_.MarkAsDirty();
   return error;
 }
 
+uint64_t ColorManagerProxy::GetModePayloadTag(int32_t mode_id,
+                                              const snapdragoncolor::ColorMode &color_mode) {
+  ModePayloadKey key(mode_id, color_mode.gamut, color_mode.gamma, color_mode.intent,
+                     color_mode.intent_name);
+  auto it = mode_payload_tags_.find(key);
+  if (it != mode_payload_tags_.end()) {
+    return it->second;
+  }
+
+  // Tags are never reused, so payloads packed under an invalidated tag are simply not hit again.
+  uint64_t tag = next_payload_tag_++;
+  mode_payload_tags_[key] = tag;
+  DLOGV_IF(kTagQDCM, "Mode %d intent %d uses payload tag %" PRIu64, mode_id, color_mode.intent,
+           tag);
+
+  return tag;
+}
+
+void ColorManagerProxy::InvalidateModePayloads() {
+  mode_payload_tags_.clear();
+}
+
 void ColorManagerProxy::DumpColorMetaData(const ColorMetaData &color_metadata) {
   DLOGI_IF(kTagResources, "Primaries = %d, Range = %d, Transfer = %d, Matrix Coeffs = %d",
            color_metadata.colorPrimaries, color_metadata.range, color_metadata.transfer,
@@ -750,6 +820,7 @@ DisplayError ColorManagerProxy::ColorMgrSetLtmPccConfig(void* pcc_input, size_t
     in_data.payload = reinterpret_cast<uint64_t>(nullptr);
     in_data.len = 0;
   }
+  InvalidateModePayloads();
   int result = stc_intf_->SetProperty(in_data);
   if (result) {
     DLOGE("Failed to SetProperty prop = %d, error = %d", in_data.prop, result);
@@ -38,10 +38,12 @@
 #include <utils/sys.h>
 #include <utils/debug.h>
 #include <array>
+#include <atomic>
 #include <vector>
 #include <map>
 #include <string>
 #include <mutex>
+#include <tuple>
 
 #include "hw_interface.h"
 
@@ -157,6 +159,7 @@ class ColorManagerProxy {
   DisplayError NotifyDisplayCalibrationMode(bool in_calibration);
   DisplayError ColorMgrSetLtmPccConfig(void* pcc_input, size_t size);
   DisplayError ColorMgrSetSprIntf(std::shared_ptr<SPRIntf> spr_intf);
+  std::string Dump();
 
  protected:
   ColorManagerProxy() {}
@@ -174,11 +177,17 @@ class ColorManagerProxy {
   typedef DisplayError (ColorManagerProxy::*ConvertProc)(const HwConfigPayload &in_data,
                                         PPFeaturesConfig *out_data);
   typedef std::map<std::string, ConvertProc> ConvertTable;
+  // Mode id, blend space gamut and gamma, render intent and intent name.
+  typedef std::tuple<int32_t, int32_t, int32_t, int32_t, std::string> ModePayloadKey;
+
+  static std::atomic<uint64_t> next_payload_tag_;
 
   bool NeedAssetsUpdate();
   DisplayError UpdateModeHwassets(int32_t mode_id, snapdragoncolor::ColorMode color_mode,
                                   bool valid_meta_data, const ColorMetaData &meta_data);
   DisplayError ConvertToPPFeatures(const HwConfigOutputParams &params, PPFeaturesConfig *out_data);
+  uint64_t GetModePayloadTag(int32_t mode_id, const snapdragoncolor::ColorMode &color_mode);
+  void InvalidateModePayloads();
   void DumpColorMetaData(const ColorMetaData &color_metadata);
   bool HasNativeModeSupport();
   DisplayError ApplySwAssets();
@@ -198,6 +207,14 @@ class ColorManagerProxy {
   snapdragoncolor::ScPostBlendInterface *stc_intf_ = NULL;
   snapdragoncolor::ColorMode curr_mode_;
   bool needs_update_ = false;
+  // Tags under which the driver keeps the packed hw assets of each mode, see UpdateModeHwassets.
+  std::map<ModePayloadKey, uint64_t> mode_payload_tags_;
+  // Outcome of the last feature commit, see PPFeaturesConfig::SetCommitMasks.
+  uint32_t pp_dirty_mask_ = 0;
+  uint32_t pp_clean_mask_ = 0;
+  uint64_t pp_commit_count_ = 0;
+  uint64_t pp_written_count_ = 0;
+  uint64_t pp_skipped_count_ = 0;
 };
 
 class ColorFeatureCheckingImpl : public FeatureInterface {
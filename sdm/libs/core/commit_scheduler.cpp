@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <utils/debug.h>
+
+#include <algorithm>
+
+#include "commit_scheduler.h"
+
+#define __CLASS__ "CommitScheduler"
+
+namespace sdm {
+
+void VSyncModel::SetNominalPeriod(int64_t period_ns) {
+  if (period_ns == nominal_period_ns_) {
+    return;
+  }
+
+  nominal_period_ns_ = period_ns;
+  Reset();
+}
+
+void VSyncModel::Reset() {
+  period_ns_ = nominal_period_ns_;
+  anchor_ns_ = 0;
+  num_samples_ = 0;
+  next_sample_ = 0;
+}
+
+void VSyncModel::AddVSync(int64_t timestamp_ns) {
+  if (!period_ns_) {
+    return;
+  }
+
+  if (num_samples_) {
+    int64_t last = samples_[(next_sample_ + kMaxSamples - 1) % kMaxSamples];
+    // Duplicate or out of order event.
+    if (timestamp_ns - last < period_ns_ / 2) {
+      return;
+    }
+    // A timeline gone stale is not worth fitting against.
+    if (timestamp_ns - last > kMaxExtrapolationNs) {
+      Reset();
+    }
+  }
+
+  samples_[next_sample_] = timestamp_ns;
+  next_sample_ = (next_sample_ + 1) % kMaxSamples;
+  if (num_samples_ < kMaxSamples) {
+    num_samples_++;
+  }
+  Fit();
+}
+
+void VSyncModel::Fit() {
+  int64_t last = samples_[(next_sample_ + kMaxSamples - 1) % kMaxSamples];
+  anchor_ns_ = last;
+  if (num_samples_ < 3) {
+    return;
+  }
+
+  // Fit t = anchor + n * period, with n the vsync count relative to the latest sample.
+  double sum_n = 0.0, sum_t = 0.0, sum_nn = 0.0, sum_nt = 0.0;
+  for (uint32_t i = 0; i < num_samples_; i++) {
+    double t = static_cast<double>(samples_[i] - last);
+    double n = round(t / static_cast<double>(period_ns_));
+    sum_n += n;
+    sum_t += t;
+    sum_nn += n * n;
+    sum_nt += n * t;
+  }
+
+  double count = static_cast<double>(num_samples_);
+  double denominator = count * sum_nn - sum_n * sum_n;
+  if (denominator <= 0.0) {
+    return;
+  }
+  double period = (count * sum_nt - sum_n * sum_t) / denominator;
+  double offset = (sum_t - period * sum_n) / count;
+
+  // The panel switched rate behind our back, start over from the latest vsync.
+  if (llabs(static_cast<int64_t>(period) - nominal_period_ns_) > nominal_period_ns_ / 10) {
+    DLOGV_IF(kTagDisplay, "Fitted vsync period %lld ns is off nominal %lld ns",
+             static_cast<long long>(period), static_cast<long long>(nominal_period_ns_));
+    Reset();
+    samples_[0] = last;
+    anchor_ns_ = last;
+    num_samples_ = 1;
+    next_sample_ = 1;
+    return;
+  }
+
+  period_ns_ = static_cast<int64_t>(period);
+  anchor_ns_ = last + static_cast<int64_t>(offset);
+}
+
+bool VSyncModel::GetVSyncAfter(int64_t time_ns, int64_t *vsync_ns) const {
+  if (!num_samples_ || !period_ns_ || (time_ns - anchor_ns_) > kMaxExtrapolationNs) {
+    return false;
+  }
+
+  double periods = ceil(static_cast<double>(time_ns - anchor_ns_) /
+                        static_cast<double>(period_ns_));
+  *vsync_ns = anchor_ns_ + static_cast<int64_t>(periods) * period_ns_;
+
+  return true;
+}
+
+void CommitScheduler::SetNominalPeriod(int64_t period_ns) {
+  std::lock_guard<std::mutex> lock(lock_);
+  model_.SetNominalPeriod(period_ns);
+}
+
+void CommitScheduler::AddVSync(int64_t timestamp_ns) {
+  std::lock_guard<std::mutex> lock(lock_);
+  model_.AddVSync(timestamp_ns);
+}
+
+void CommitScheduler::RecordCommitDuration(int64_t duration_ns) {
+  std::lock_guard<std::mutex> lock(lock_);
+  durations_[next_duration_] = duration_ns;
+  next_duration_ = (next_duration_ + 1) % kDurationSamples;
+  if (num_durations_ < kDurationSamples) {
+    num_durations_++;
+  }
+}
+
+int64_t CommitScheduler::GetCommitDuration() {
+  // Until commits were measured assume a quarter of the frame.
+  if (!num_durations_) {
+    return model_.GetPeriod() / 4;
+  }
+
+  return *std::max_element(durations_, durations_ + num_durations_);
+}
+
+int64_t CommitScheduler::GetCommitTime(int64_t elapse_ns, int64_t now_ns) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (!model_.GetPeriod()) {
+    return 0;
+  }
+
+  // Without a timeline the commit starts at the elapse time.
+  int64_t margin = GetCommitDuration() + kGuardNs;
+  int64_t vsync = 0;
+  if (!model_.GetVSyncAfter(elapse_ns + margin, &vsync)) {
+    return 0;
+  }
+  int64_t commit_time = vsync - margin;
+
+  DLOGV_IF(kTagDisplay, "elapse %lld vsync %lld commit in %lld us",
+           static_cast<long long>(elapse_ns), static_cast<long long>(vsync),
+           static_cast<long long>((commit_time - now_ns) / 1000));
+
+  return (commit_time > now_ns) ? commit_time : 0;
+}
+
+}  // namespace sdm
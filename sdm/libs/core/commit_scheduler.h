@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __COMMIT_SCHEDULER_H__
+#define __COMMIT_SCHEDULER_H__
+
+#include <stdint.h>
+#include <mutex>
+
+namespace sdm {
+
+// Vsync timeline of a display, fitted to the hardware vsync timestamps. The period starts from the
+// nominal period of the active config and is refined by a least squares fit over recent vsyncs;
+// vsyncs missed by the event thread only leave a gap in the fit.
+class VSyncModel {
+ public:
+  static const uint32_t kMaxSamples = 32;
+  static const int64_t kMaxExtrapolationNs = 1000000000;  // older timelines are not trusted
+
+  // Restarts the fit when the nominal period changes, e.g. on a config switch.
+  void SetNominalPeriod(int64_t period_ns);
+  void AddVSync(int64_t timestamp_ns);
+  // Gives the first vsync at or after time_ns. Returns false until a vsync was seen or when the
+  // last one is too old to extrapolate from.
+  bool GetVSyncAfter(int64_t time_ns, int64_t *vsync_ns) const;
+  int64_t GetPeriod() const { return period_ns_; }
+  void Reset();
+
+ private:
+  void Fit();
+
+  int64_t nominal_period_ns_ = 0;
+  int64_t period_ns_ = 0;
+  int64_t anchor_ns_ = 0;  // fitted time of the latest vsync
+  int64_t samples_[kMaxSamples] = {};
+  uint32_t num_samples_ = 0;
+  uint32_t next_sample_ = 0;
+};
+
+// Turns the elapse time of a frame, the earliest time the client allows its commit at, into the
+// time its commit should start. The frame targets the first vsync a commit started at the elapse
+// time makes, and the commit is moved to the latest point which still makes that vsync: later
+// misses it, earlier only holds the buffers of the previous frame on screen for nothing.
+class CommitScheduler {
+ public:
+  static const int64_t kGuardNs = 1000000;  // margin on top of the worst recent commit duration
+  static const uint32_t kDurationSamples = 16;
+
+  void SetNominalPeriod(int64_t period_ns);
+  void AddVSync(int64_t timestamp_ns);
+  // Returns the time to start the commit at, never before elapse_ns, or 0 to commit at the
+  // elapse time when there is no usable vsync timeline or the commit is already due.
+  int64_t GetCommitTime(int64_t elapse_ns, int64_t now_ns);
+  // Time from the start of a commit until it was handed to the driver.
+  void RecordCommitDuration(int64_t duration_ns);
+
+ private:
+  int64_t GetCommitDuration();
+
+  std::mutex lock_;
+  VSyncModel model_;
+  int64_t durations_[kDurationSamples] = {};
+  uint32_t num_durations_ = 0;
+  uint32_t next_duration_ = 0;
+};
+
+}  // namespace sdm
+
+#endif  // __COMMIT_SCHEDULER_H__
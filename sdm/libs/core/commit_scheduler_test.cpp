@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "commit_scheduler.h"
+using namespace testing;
+using sdm::CommitScheduler;
+using sdm::VSyncModel;
+
+namespace {
+
+const int64_t kUs = 1000;
+const int64_t kMs = 1000 * kUs;
+const int64_t kNominalPeriod = 16666667;  // 60 Hz
+
+// A hardware vsync source that runs at its own rate, reports its timestamps with jitter and
+// loses some of the events on the way to the scheduler.
+class SyntheticVSync {
+ public:
+  SyntheticVSync(int64_t period, int64_t jitter, uint32_t missed_percent)
+    : period_(period), jitter_(-jitter, jitter), missed_percent_(missed_percent) {}
+
+  // Real time of vsync n, which is what a commit has to make.
+  int64_t GetVSync(int64_t n) const { return start_ + n * period_; }
+
+  // The first vsync a commit done at time_ns is latched on.
+  int64_t GetVSyncAfter(int64_t time_ns) const {
+    int64_t n = (time_ns - start_ + period_ - 1) / period_;
+    return GetVSync(n);
+  }
+
+  // Delivers the events of vsyncs up to time_ns the event thread did not miss.
+  void DeliverUntil(int64_t time_ns, CommitScheduler *scheduler) {
+    for (; GetVSync(next_) <= time_ns; next_++) {
+      if (uint32_t(random_() % 100) >= missed_percent_) {
+        scheduler->AddVSync(GetVSync(next_) + jitter_(random_));
+      }
+    }
+  }
+
+  std::mt19937 *GetRandom() { return &random_; }
+
+ private:
+  int64_t start_ = 1000 * kMs;
+  int64_t period_;
+  std::uniform_int_distribution<int64_t> jitter_;
+  uint32_t missed_percent_;
+  int64_t next_ = 0;
+  std::mt19937 random_ {39};
+};
+
+// As DisplayBase::CommitLayerParams with vsync aligned commits: the elapse time of the client
+// is the earliest commit time, the scheduler only moves the commit later.
+int64_t GetCommitStart(CommitScheduler *scheduler, int64_t elapse, int64_t now) {
+  int64_t commit_time = std::max(scheduler->GetCommitTime(elapse, now), elapse);
+  return std::max(commit_time, now);
+}
+
+}  // namespace
+
+TEST(CommitSchedulerTestCases, NoTimelineCommitsAtElapseTime) {
+  CommitScheduler scheduler;
+  EXPECT_THAT(scheduler.GetCommitTime(100 * kMs, 0), Eq(0));
+  scheduler.SetNominalPeriod(kNominalPeriod);
+  EXPECT_THAT(scheduler.GetCommitTime(100 * kMs, 0), Eq(0));
+}
+
+TEST(CommitSchedulerTestCases, CommitsBeforeFirstReachableVSync) {
+  CommitScheduler scheduler;
+  scheduler.SetNominalPeriod(kNominalPeriod);
+  for (int64_t n = 0; n < 8; n++) {
+    scheduler.AddVSync(1000 * kMs + n * kNominalPeriod);
+  }
+  scheduler.RecordCommitDuration(2 * kMs);
+  int64_t vsync_10 = 1000 * kMs + 10 * kNominalPeriod;
+  int64_t margin = 2 * kMs + CommitScheduler::kGuardNs;
+
+  // Room before vsync 10, the commit moves up to the margin before it.
+  EXPECT_THAT(scheduler.GetCommitTime(vsync_10 - 10 * kMs, 0), Eq(vsync_10 - margin));
+  // Too close to vsync 10, vsync 11 is the first one the frame makes.
+  EXPECT_THAT(scheduler.GetCommitTime(vsync_10 - 2 * kMs, 0),
+              Eq(vsync_10 + kNominalPeriod - margin));
+  // Already due.
+  EXPECT_THAT(scheduler.GetCommitTime(vsync_10 - 10 * kMs, vsync_10), Eq(0));
+}
+
+TEST(CommitSchedulerTestCases, ModelFitsOffNominalRate) {
+  const int64_t real_period = 16900000;  // 1.4% slower than nominal
+  SyntheticVSync source(real_period, 150 * kUs, 10);
+  VSyncModel model;
+  model.SetNominalPeriod(kNominalPeriod);
+  for (int64_t n = 0; n < 64; n++) {
+    model.AddVSync(source.GetVSync(n));
+  }
+
+  EXPECT_THAT(model.GetPeriod(), AllOf(Gt(real_period - 10 * kUs), Lt(real_period + 10 * kUs)));
+  // Half a second out, the nominal period would be 7 ms off.
+  int64_t vsync = 0;
+  ASSERT_TRUE(model.GetVSyncAfter(source.GetVSync(94) - 2 * kMs, &vsync));
+  EXPECT_THAT(vsync, AllOf(Gt(source.GetVSync(94) - 200 * kUs),
+                           Lt(source.GetVSync(94) + 200 * kUs)));
+}
+
+TEST(CommitSchedulerTestCases, StaleTimelineIsNotUsed) {
+  VSyncModel model;
+  model.SetNominalPeriod(kNominalPeriod);
+  model.AddVSync(1000 * kMs);
+  int64_t vsync = 0;
+  EXPECT_TRUE(model.GetVSyncAfter(1500 * kMs, &vsync));
+  EXPECT_FALSE(model.GetVSyncAfter(1000 * kMs + VSyncModel::kMaxExtrapolationNs + kMs, &vsync));
+}
+
+TEST(CommitSchedulerTestCases, ConfigSwitchRestartsFit) {
+  VSyncModel model;
+  model.SetNominalPeriod(kNominalPeriod);
+  for (int64_t n = 0; n < 8; n++) {
+    model.AddVSync(1000 * kMs + n * 16900000);
+  }
+  EXPECT_THAT(model.GetPeriod(), Ne(kNominalPeriod));
+
+  model.SetNominalPeriod(kNominalPeriod / 2);
+  EXPECT_THAT(model.GetPeriod(), Eq(kNominalPeriod / 2));
+  int64_t vsync = 0;
+  EXPECT_FALSE(model.GetVSyncAfter(1200 * kMs, &vsync));
+}
+
+// Frames run against a 59.2 Hz panel whose vsync events carry +-150 us of jitter, 10% of them
+// never reaching the scheduler. Each frame asks to be held until somewhere 4 to 12 ms ahead of a
+// vsync and takes 1 to 3 ms to commit. Compared to committing at the elapse time, scheduled
+// commits must land on the same vsync, and move later whenever the frame has room to.
+TEST(CommitSchedulerTestCases, SyntheticVSyncSimulation) {
+  const int64_t real_period = 16900000;
+  const int kFrames = 2000;
+  const int kWarmUpFrames = 40;
+  SyntheticVSync source(real_period, 150 * kUs, 10);
+  std::mt19937 *random = source.GetRandom();
+  std::uniform_int_distribution<int64_t> hold(4 * kMs, 12 * kMs);
+  std::uniform_int_distribution<int64_t> duration(1 * kMs, 3 * kMs);
+
+  CommitScheduler scheduler;
+  scheduler.SetNominalPeriod(kNominalPeriod);
+  int frames = 0;
+  int same_vsync = 0;
+  int frames_with_room = 0;
+  int delayed = 0;
+  int64_t total_delay = 0;
+  for (int64_t n = 0; n < kFrames; n++) {
+    // The client works a frame ahead: it wakes up past vsync n, targets vsync n + 2.
+    int64_t now = source.GetVSync(n) + 1 * kMs;
+    source.DeliverUntil(now, &scheduler);
+    int64_t elapse = source.GetVSync(n + 2) - hold(*random);
+    int64_t commit_duration = duration(*random);
+
+    int64_t start = GetCommitStart(&scheduler, elapse, now);
+    scheduler.RecordCommitDuration(commit_duration);
+    if (n < kWarmUpFrames) {
+      continue;
+    }
+
+    frames++;
+    EXPECT_THAT(start, Ge(elapse));
+    int64_t latched = source.GetVSyncAfter(start + commit_duration);
+    int64_t unscheduled = source.GetVSyncAfter(std::max(elapse, now) + commit_duration);
+    same_vsync += (latched == unscheduled);
+    if (unscheduled - elapse > 3 * kMs + CommitScheduler::kGuardNs + 500 * kUs) {
+      frames_with_room++;
+      delayed += (start > elapse);
+      total_delay += start - elapse;
+    }
+  }
+
+  printf("%d frames: %d on the unscheduled vsync, %d of %d with room delayed, avg %lld us\n",
+         frames, same_vsync, delayed, frames_with_room,
+         static_cast<long long>(frames_with_room ? total_delay / frames_with_room / kUs : 0));
+  EXPECT_THAT(same_vsync, Ge(frames * 99 / 100));
+  ASSERT_THAT(frames_with_room, Gt(frames / 2));
+  EXPECT_THAT(delayed, Ge(frames_with_room * 9 / 10));
+}
@@ -36,10 +36,10 @@
 #include <utils/debug.h>
 #include <utils/locker.h>
 #include <utils/utils.h>
+#include <utils/worker_pool.h>
 #include <sys/mman.h>
 #include <map>
 #include <vector>
-#include <thread>
 
 #include "color_manager.h"
 #include "core_impl.h"
@@ -644,6 +644,8 @@ void CoreIPCVmCallbackImpl::Deinit() {
     DLOGW("IPC interface is NULL");
     return;
   }
+  // Server ready handling may still be sending properties through this object.
+  WorkerPool::GetInstance()->Drain(kLaneVmIPC);
   GenericPayload in_unreg;
   int *cb_hnd_in = nullptr;
   int ret = in_unreg.CreatePayload<int>(cb_hnd_in);
@@ -665,7 +667,7 @@ void CoreIPCVmCallbackImpl::OnServerReady() {
     return;
   }
   server_ready_ = true;
-  std::thread(CoreIPCVmCallbackImpl::OnServerReadyThread, this).detach();
+  WorkerPool::GetInstance()->Post(kLaneVmIPC, [this]() { OnServerReadyThread(this); });
 }
 
 void CoreIPCVmCallbackImpl::OnServerReadyThread(CoreIPCVmCallbackImpl *obj) {
@@ -258,6 +258,10 @@ DisplayError DisplayBase::Init() {
   track_input_fences_ = (prop == 1);
   DLOGI("track_input_fences_:%d %d-%d", track_input_fences_, display_id_, display_type_);
 
+  prop = 0;
+  Debug::GetProperty(VSYNC_ALIGNED_COMMIT_PROP, &prop);
+  vsync_aligned_commit_ = (prop == 1);
+
   return kErrorNone;
 
 CleanupOnError:
@@ -906,6 +910,7 @@ DisplayError DisplayBase::Prepare(LayerStack *layer_stack) {
 
   CheckMMRMState();
 
+  uint64_t strategy_start = GetSystemTimeInNs();
   while (true) {
     error = comp_manager_->Prepare(display_comp_ctx_, &disp_layer_stack_);
     if (error != kErrorNone) {
@@ -929,6 +934,8 @@ DisplayError DisplayBase::Prepare(LayerStack *layer_stack) {
     }
   }
 
+  layer_stack->timings.strategy_us = UINT32((GetSystemTimeInNs() - strategy_start) / 1000);
+
   if (color_mgr_)
     color_mgr_->Validate(&disp_layer_stack_);
 
@@ -1489,9 +1496,15 @@ DisplayError DisplayBase::SetUpCommit(LayerStack *layer_stack) {
 DisplayError DisplayBase::PerformCommit(HWLayersInfo *hw_layers_info) {
   DTRACE_SCOPED();
   TrackInputFences();
+  uint64_t commit_start = GetSystemTimeInNs();
   DisplayError error = hw_intf_->Commit(hw_layers_info);
   if (error != kErrorNone) {
     DLOGE("COMMIT failed: %d ", error);
+  } else if (vsync_aligned_commit_) {
+    // The hold before the commit does not count towards its duration.
+    commit_start = std::max(commit_start, hw_layers_info->elapse_timestamp);
+    uint64_t duration = GetSystemTimeInNs() - commit_start;
+    commit_scheduler_.RecordCommitDuration(static_cast<int64_t>(duration));
   }
 
   return error;
@@ -1529,10 +1542,13 @@ DisplayError DisplayBase::CommitLocked(LayerStack *layer_stack) {
     return error;
   }
 
+  uint64_t commit_start = GetSystemTimeInNs();
   error = PerformHwCommit(&disp_layer_stack_.info);
   if (error != kErrorNone) {
     DLOGE("HwCommit failed %d", error);
   }
+  layer_stack->timings.hw_commit_us = UINT32((GetSystemTimeInNs() - commit_start) / 1000);
+  layer_stack->timings.fence_wait_us = UINT32(fence_wait_ns_.exchange(0) / 1000);
 
   return error;
 }
@@ -1555,7 +1571,7 @@ DisplayError DisplayBase::PerformHwCommit(HWLayersInfo *hw_layers_info) {
   // to be removed when issue is fixed.
   if (cwb_fence_wait_ && hw_layers_info->output_buffer &&
       (hw_layers_info->output_buffer->release_fence != nullptr)) {
-    if (Fence::Wait(hw_layers_info->output_buffer->release_fence) != kErrorNone) {
+    if (TimedFenceWait(hw_layers_info->output_buffer->release_fence) != kErrorNone) {
       DLOGW("sync_wait error errno = %d, desc = %s", errno, strerror(errno));
     }
   }
@@ -1572,6 +1588,14 @@ DisplayError DisplayBase::PerformHwCommit(HWLayersInfo *hw_layers_info) {
   return kErrorNone;
 }
 
+int DisplayBase::TimedFenceWait(const shared_ptr<Fence> &fence) {
+  uint64_t start = GetSystemTimeInNs();
+  int ret = Fence::Wait(fence);
+  fence_wait_ns_ += GetSystemTimeInNs() - start;
+
+  return ret;
+}
+
 void DisplayBase::CleanupOnError() {
   // Buffer Fd's are duped for async thread operation.
   for (auto &hw_layer : disp_layer_stack_.info.hw_layers) {
@@ -2108,6 +2132,9 @@ std::string DisplayBase::Dump() {
     }
     os << "\n";
   }
+  if (color_mgr_) {
+    os << color_mgr_->Dump();
+  }
 
   uint32_t num_hw_layers = UINT32(disp_layer_stack_.info.hw_layers.size());
 
@@ -3194,6 +3221,19 @@ void DisplayBase::CommitLayerParams(LayerStack *layer_stack) {
     disp_layer_stack_.info.elapse_timestamp = layer_stack->elapse_timestamp;
   }
 
+  if (vsync_aligned_commit_) {
+    commit_scheduler_.SetNominalPeriod(static_cast<int64_t>(display_attributes_.vsync_period_ns));
+    if (layer_stack->elapse_timestamp) {
+      // The elapse time of the client stays the earliest commit time, the scheduler only moves
+      // the commit later, up to the latest safe point before the first vsync it can make.
+      int64_t elapse_time = static_cast<int64_t>(layer_stack->elapse_timestamp);
+      int64_t now = static_cast<int64_t>(GetSystemTimeInNs());
+      int64_t commit_time = commit_scheduler_.GetCommitTime(elapse_time, now);
+      disp_layer_stack_.info.elapse_timestamp = std::max(UINT64(commit_time),
+                                                         layer_stack->elapse_timestamp);
+    }
+  }
+
   return;
 }
 
@@ -71,6 +71,7 @@
 #include <private/noise_plugin_dbg.h>
 
 #include <limits.h>
+#include <atomic>
 #include <map>
 #include <mutex>
 #include <thread>
@@ -83,6 +84,7 @@
 #include "comp_manager.h"
 #include "color_manager.h"
 #include "hw_events_interface.h"
+#include "commit_scheduler.h"
 
 #define GET_PANEL_FEATURE_FACTORY "GetPanelFeatureFactoryIntf"
 
@@ -199,6 +201,9 @@ class DisplayBase : public DisplayInterface {
   virtual DisplayError PostHandleSecureEvent(SecureEvent secure_event) {
     return kErrorNotSupported;
   }
+  virtual DisplayError SetContentStats(const DisplayContentStats &stats) {
+    return kErrorNotSupported;
+  }
   virtual DisplayError SetDisplayDppsAdROI(void *payload) {
     return kErrorNotSupported;
   }
@@ -333,6 +338,7 @@ class DisplayBase : public DisplayInterface {
   DisplayError GetPendingDisplayState(DisplayState *disp_state);
   void SetPendingPowerState(DisplayState state);
   DisplayError SetupPanelFeatureFactory();
+  int TimedFenceWait(const shared_ptr<Fence> &fence);
   void CommitThread();
   virtual void HandleAsyncCommit();
   void MMRMEvent(uint32_t clk);
@@ -425,6 +431,7 @@ class DisplayBase : public DisplayInterface {
   bool unified_draw_supported_ = true;  // By default supported, unless disabled by property.
   bool validated_ = false;  // display validation status based on sideband events driver events etc.
   shared_ptr<Fence> retire_fence_ = nullptr;
+  std::atomic<uint64_t> fence_wait_ns_ {0};  // fence wait time of the frame being committed
   DisplayDrawMethod draw_method_ = kDrawDefault;
   bool noise_disable_prop_ = false;
   NoiseLayerConfig noise_layer_info_ = {};
@@ -437,6 +444,9 @@ class DisplayBase : public DisplayInterface {
   uint32_t active_refresh_rate_ = 0;
   bool disable_cwb_idle_fallback_ = false;
   bool avoid_qync_mode_change_ = false;
+  // Both are fed by the VSync handlers of the derived displays.
+  bool vsync_aligned_commit_ = false;
+  CommitScheduler commit_scheduler_;
 
  private:
   // Max tolerable power-state-change wait-times in milliseconds.
@@ -65,6 +65,7 @@
 #include <utils/formats.h>
 #include <core/buffer_allocator.h>
 #include <core/core_interface.h>
+#include <inttypes.h>
 #include <sys/mman.h>
 #include <iomanip>
 #include <algorithm>
@@ -715,7 +716,7 @@ void DisplayBuiltIn::PreCommit(LayerStack *layer_stack) {
   if (vsync_enable_) {
     DTRACE_BEGIN("RegisterVsync");
     // wait for previous frame's retire fence to signal.
-    Fence::Wait(retire_fence_);
+    TimedFenceWait(retire_fence_);
 
     // Register for vsync and then commit the frame.
     hw_events_intf_->SetEventState(HWEvent::VSYNC, true);
@@ -749,7 +750,7 @@ DisplayError DisplayBuiltIn::PostCommit(HWLayersInfo *hw_layers_info) {
   {
     lock_guard<recursive_mutex> obj(brightness_lock_);
     if (pending_brightness_) {
-      Fence::Wait(retire_fence_);
+      TimedFenceWait(retire_fence_);
       SetPanelBrightness(cached_brightness_);
       pending_brightness_ = false;
     }
@@ -1084,6 +1085,10 @@ bool DisplayBuiltIn::CanLowerFps(bool idle_screen) {
 
 DisplayError DisplayBuiltIn::VSync(int64_t timestamp) {
   DTRACE_SCOPED();
+  if (vsync_aligned_commit_) {
+    commit_scheduler_.AddVSync(timestamp);
+  }
+
   bool qsync_enabled = enable_qsync_idle_ && (active_qsync_mode_ != kQSyncModeNone);
   // Client isn't aware of underlying qsync mode.
   // Disable vsync propagation as long as qsync is enabled.
@@ -1551,6 +1556,17 @@ std::string DisplayBuiltIn::Dump() {
      << current_color_mode_.gamma << " intent " << current_color_mode_.intent << " Dynamice_range"
      << (curr_dynamic_range == kSdrType ? " SDR" : " HDR");
 
+  {
+    std::lock_guard<std::mutex> stats_lock(content_stats_lock_);
+    if (content_stats_.frame_count) {
+      os << "\nContent: frames " << content_stats_.frame_count << " mean luma "
+         << content_stats_.mean_luma << " p10/p50/p90 " << content_stats_.p10_luma << "/"
+         << content_stats_.p50_luma << "/" << content_stats_.p90_luma << std::boolalpha
+         << " dark " << content_stats_.dark << " static " << content_stats_.static_content
+         << std::noboolalpha << " scene cuts " << content_stats_.scene_cuts;
+    }
+  }
+
   uint32_t num_hw_layers = UINT32(disp_layer_stack_.info.hw_layers.size());
 
   if (num_hw_layers == 0) {
@@ -2355,6 +2371,18 @@ DisplayError DisplayBuiltIn::SetAlternateDisplayConfig(uint32_t *alt_config) {
 }
 
 
+DisplayError DisplayBuiltIn::SetContentStats(const DisplayContentStats &stats) {
+  std::lock_guard<std::mutex> lock(content_stats_lock_);
+  if (stats.scene_cut) {
+    DLOGV_IF(kTagDisplay, "Display %d-%d scene cut at %" PRId64 ", mean luma %.3f", display_id_,
+             display_type_, stats.timestamp, stats.mean_luma);
+  }
+  content_stats_ = stats;
+
+  return kErrorNone;
+}
+
+
 // LCOV_EXCL_START
 DisplayError DisplayBuiltIn::PostHandleSecureEvent(SecureEvent secure_event) {
   ClientLock lock(disp_mutex_);
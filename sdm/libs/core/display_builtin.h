@@ -180,6 +180,7 @@ class DisplayBuiltIn : public DisplayBase, HWEventHandler, DppsPropIntf {
   DisplayError PrePrepare(LayerStack *layer_stack) override;
   DisplayError SetAlternateDisplayConfig(uint32_t *alt_config) override;
   DisplayError PostHandleSecureEvent(SecureEvent secure_event) override;
+  DisplayError SetContentStats(const DisplayContentStats &stats) override;
   void InitCWBBuffer();
   void AppendCWBLayer(LayerStack *layer_stack);
   uint32_t GetUpdatingAppLayersCount(LayerStack *layer_stack);
@@ -299,6 +300,9 @@ class DisplayBuiltIn : public DisplayBase, HWEventHandler, DppsPropIntf {
   Layer cwb_layer_ = {};
   bool lower_fps_ = false;
   bool cwb_buffer_inited_ = false;
+  // Written by the histogram thread, hence not under disp_mutex_.
+  std::mutex content_stats_lock_;
+  DisplayContentStats content_stats_ = {};
 };
 
 }  // namespace sdm
@@ -127,6 +127,7 @@ class DisplayNull : public DisplayInterface {
                                     const ColorMetaData &))
   MAKE_NO_OP(HandleSecureEvent(SecureEvent, bool *))
   MAKE_NO_OP(PostHandleSecureEvent(SecureEvent))
+  MAKE_NO_OP(SetContentStats(const DisplayContentStats &))
   MAKE_NO_OP(SetQSyncMode(QSyncMode))
   MAKE_NO_OP(ControlIdlePowerCollapse(bool, bool))
   MAKE_NO_OP(SetDisplayDppsAdROI(void *))
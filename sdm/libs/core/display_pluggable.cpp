@@ -299,6 +299,10 @@ void DisplayPluggable::Histogram(int /* histogram_fd */, uint32_t /* blob_id */)
 void DisplayPluggable::HandleBacklightEvent(float /* brightness_level */) {}
 
 DisplayError DisplayPluggable::VSync(int64_t timestamp) {
+  if (vsync_aligned_commit_) {
+    commit_scheduler_.AddVSync(timestamp);
+  }
+
   if (vsync_enable_) {
     DisplayEventVSync vsync;
     vsync.timestamp = timestamp;
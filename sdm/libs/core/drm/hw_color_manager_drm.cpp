@@ -29,11 +29,13 @@
 
 #define __CLASS__ "HWColorManagerDRM"
 
+#include <inttypes.h>
 #include <array>
 #include <map>
 #include <cstring>
 #include <vector>
 #include <new>
+#include <utility>
 
 #ifdef PP_DRM_ENABLE
 #include <display/drm/msm_drm_pp.h>
@@ -251,6 +253,148 @@ DisplayError HWColorManagerDrm::GetDrmFeature(PPFeatureInfo *in_data,
   return ret;
 }
 
+DisplayError HWColorManagerDrm::GetCachedDrmFeature(uint64_t tag, PPFeatureInfo *in_data,
+                                                    DRMPPFeatureInfo *out_data, bool *cached) {
+  *cached = false;
+  if (!tag || !in_data || !out_data) {
+    return GetDrmFeature(in_data, out_data);
+  }
+
+  auto key = std::make_pair(tag, static_cast<uint32_t>(out_data->id));
+  auto it = payload_cache_.find(key);
+  if (it != payload_cache_.end()) {
+    *out_data = it->second;
+    payload_tag_use_[tag] = ++use_count_;
+    *cached = true;
+    return kErrorNone;
+  }
+
+  DisplayError ret = GetDrmFeature(in_data, out_data);
+  if (ret != kErrorNone) {
+    return ret;
+  }
+
+  if (payload_tag_use_.find(tag) == payload_tag_use_.end() &&
+      payload_tag_use_.size() >= kMaxCachedPayloadTags) {
+    auto lru = payload_tag_use_.begin();
+    for (auto use = payload_tag_use_.begin(); use != payload_tag_use_.end(); use++) {
+      if (use->second < lru->second) {
+        lru = use;
+      }
+    }
+    EvictPayloadTag(lru->first);
+  }
+
+  payload_cache_[key] = *out_data;
+  payload_tag_use_[tag] = ++use_count_;
+  *cached = true;
+  DLOGV_IF(kTagQDCM, "Cached feature %d payload for tag %" PRIu64, key.second, tag);
+
+  return kErrorNone;
+}
+
+void HWColorManagerDrm::EvictPayloadTag(uint64_t tag) {
+  auto begin = payload_cache_.lower_bound(std::make_pair(tag, 0U));
+  auto end = payload_cache_.lower_bound(std::make_pair(tag + 1, 0U));
+  for (auto it = begin; it != end; it++) {
+    FreeDrmFeatureData(&it->second);
+  }
+  payload_cache_.erase(begin, end);
+  payload_tag_use_.erase(tag);
+}
+
+void HWColorManagerDrm::ClearPayloadCache() {
+  for (auto &entry : payload_cache_) {
+    FreeDrmFeatureData(&entry.second);
+  }
+  payload_cache_.clear();
+  payload_tag_use_.clear();
+}
+
+static_assert(kPPFeaturesMax <= 32, "staged_mask_ holds one bit per DRM feature");
+
+bool HWColorManagerDrm::MatchesSnapshot(const PayloadSnapshot &snapshot,
+                                        const DRMPPFeatureInfo &feature) {
+  if (!snapshot.valid || snapshot.type != feature.type || snapshot.version != feature.version ||
+      snapshot.has_payload != (feature.payload != nullptr)) {
+    return false;
+  }
+
+  if (!feature.payload) {
+    return true;
+  }
+
+  return snapshot.data.size() == feature.payload_size &&
+         !memcmp(snapshot.data.data(), feature.payload, feature.payload_size);
+}
+
+bool HWColorManagerDrm::IsPayloadCommitted(const DRMPPFeatureInfo &feature) const {
+  if (feature.is_event || feature.id >= kPPFeaturesMax) {
+    return false;
+  }
+
+  // A payload staged but not committed yet is what the request holds, compare against that.
+  if (staged_mask_ & (1U << feature.id)) {
+    return MatchesSnapshot(staged_[feature.id], feature);
+  }
+
+  return MatchesSnapshot(committed_[feature.id], feature);
+}
+
+void HWColorManagerDrm::StagePayload(const DRMPPFeatureInfo &feature) {
+  if (feature.is_event || feature.id >= kPPFeaturesMax) {
+    return;
+  }
+
+  PayloadSnapshot &snapshot = staged_[feature.id];
+  snapshot.valid = true;
+  snapshot.type = feature.type;
+  snapshot.version = feature.version;
+  snapshot.has_payload = (feature.payload != nullptr);
+  if (feature.payload) {
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(feature.payload);
+    snapshot.data.assign(data, data + feature.payload_size);
+  } else {
+    snapshot.data.clear();
+  }
+  staged_mask_ |= (1U << feature.id);
+}
+
+void HWColorManagerDrm::CommitStagedPayloads(bool applied) {
+  for (uint32_t id = 0; staged_mask_ && id < kPPFeaturesMax; id++) {
+    if (!(staged_mask_ & (1U << id))) {
+      continue;
+    }
+
+    if (applied) {
+      std::swap(committed_[id], staged_[id]);
+    } else {
+      // The hardware may or may not hold the previous payload, set it again next time.
+      committed_[id].valid = false;
+    }
+    staged_[id].valid = false;
+    staged_mask_ &= ~(1U << id);
+  }
+}
+
+void HWColorManagerDrm::ForgetPayload(DRMPPFeatureID id) {
+  if (id >= kPPFeaturesMax) {
+    return;
+  }
+
+  committed_[id].valid = false;
+  staged_[id].valid = false;
+  staged_mask_ &= ~(1U << id);
+}
+
+void HWColorManagerDrm::ResetCommittedPayloads() {
+  for (uint32_t id = 0; id < kPPFeaturesMax; id++) {
+    committed_[id].valid = false;
+    staged_[id].valid = false;
+  }
+  staged_mask_ = 0;
+}
+
 void HWColorManagerDrm::FreeDrmFeatureData(DRMPPFeatureInfo *feature) {
   if (feature && feature->payload) {
 #ifdef PP_DRM_ENABLE
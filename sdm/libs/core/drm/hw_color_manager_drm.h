@@ -32,6 +32,8 @@
 
 #include <drm_interface.h>
 #include <private/color_params.h>
+#include <map>
+#include <utility>
 #include <vector>
 
 using sde_drm::DRMPPFeatureID;
@@ -78,10 +80,50 @@ class HWColorManagerDrm {
   uint32_t GetFeatureVersion(const DRMPPFeatureInfo &feature);
   DisplayError ToDrmFeatureId(const PPBlock block, const uint32_t id,
                               std::vector<DRMPPFeatureID> *drm_id);
+  // GetDrmFeature that keeps the payload packed for a nonzero tag, see
+  // PPFeaturesConfig::SetPayloadTag, and hands it out again for the same tag and feature. When
+  // cached is set the payload belongs to the cache and must not be freed.
+  DisplayError GetCachedDrmFeature(uint64_t tag, PPFeatureInfo *in_data,
+                                   DRMPPFeatureInfo *out_data, bool *cached);
+  void ClearPayloadCache();
+  // Payloads handed to the atomic request are staged per DRM feature and become committed once
+  // the request reached the hardware. A feature whose payload is committed already can be left
+  // out of the request. Each atomic commit or validate consumes the request, so it has to be
+  // followed by CommitStagedPayloads() telling whether the properties were applied.
+  bool IsPayloadCommitted(const DRMPPFeatureInfo &feature) const;
+  void StagePayload(const DRMPPFeatureInfo &feature);
+  void CommitStagedPayloads(bool applied);
+  // For features set behind the back of the staging, and for when the hardware may lose state.
+  void ForgetPayload(DRMPPFeatureID id);
+  void ResetCommittedPayloads();
   HWColorManagerDrm() {}
-  ~HWColorManagerDrm() {}
+  ~HWColorManagerDrm() { ClearPayloadCache(); }
 
  private:
+  // Modes, or rather tags, whose payloads are kept. A mode holds a few hundred KB at most.
+  static const uint32_t kMaxCachedPayloadTags = 8;
+
+  // Copy of what a DRM feature was set to.
+  struct PayloadSnapshot {
+    bool valid = false;
+    uint32_t type = 0;
+    uint32_t version = 0;
+    bool has_payload = false;
+    std::vector<uint8_t> data;
+  };
+
+  void EvictPayloadTag(uint64_t tag);
+  static bool MatchesSnapshot(const PayloadSnapshot &snapshot, const DRMPPFeatureInfo &feature);
+
+  // Keyed by tag and DRM feature id.
+  std::map<std::pair<uint64_t, uint32_t>, DRMPPFeatureInfo> payload_cache_;
+  std::map<uint64_t, uint64_t> payload_tag_use_;
+  uint64_t use_count_ = 0;
+  // Snapshots are swapped rather than copied on commit, so their buffers get reused.
+  PayloadSnapshot committed_[kPPFeaturesMax];
+  PayloadSnapshot staged_[kPPFeaturesMax];
+  uint32_t staged_mask_ = 0;
+
   static DisplayError GetDrmPCC(const PPFeatureInfo &in_data, DRMPPFeatureInfo *out_data);
   static DisplayError GetDrmIGC(const PPFeatureInfo &in_data, DRMPPFeatureInfo *out_data);
   static DisplayError GetDrmPGC(const PPFeatureInfo &in_data, DRMPPFeatureInfo *out_data);
@@ -0,0 +1,368 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <vector>
+
+#include <display/drm/msm_drm_pp.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "hw_color_manager_drm.h"
+using namespace testing;
+using sdm::HWColorManagerDrm;
+using sdm::PPFeatureInfo;
+using sdm::SDEGamutCfg;
+using sdm::SDEGamutCfgWrapper;
+using sdm::SDEPccV4Cfg;
+
+// Payloads are packed with new and freed with delete inside libsdmcore. Deleting a watched
+// pointer is counted, so the tests can tell when the cache lets go of a payload.
+namespace {
+
+const int kMaxWatched = 64;
+std::atomic<void *> g_watched[kMaxWatched];
+std::atomic<int> g_watched_deletes {0};
+
+void Watch(void *ptr) {
+  for (auto &watched : g_watched) {
+    void *expected = nullptr;
+    if (watched.compare_exchange_strong(expected, ptr)) {
+      return;
+    }
+  }
+  ADD_FAILURE() << "Too many watched payloads";
+}
+
+void Unwatch(void *ptr) {
+  for (auto &watched : g_watched) {
+    void *expected = ptr;
+    if (ptr && watched.compare_exchange_strong(expected, nullptr)) {
+      g_watched_deletes++;
+      return;
+    }
+  }
+}
+
+}  // namespace
+
+void *operator new(size_t size) {
+  void *ptr = malloc(size ? size : 1);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return malloc(size ? size : 1);
+}
+
+void operator delete(void *ptr) noexcept {
+  Unwatch(ptr);
+  free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+  Unwatch(ptr);
+  free(ptr);
+}
+
+namespace {
+
+// A PCC or gamut configuration, as the color service sets it for a mode.
+class TestFeature : public PPFeatureInfo {
+ public:
+  static TestFeature Pcc(uint32_t seed) {
+    TestFeature feature;
+    feature.feature_version_ = sdm::PPFeatureVersion::kSDEPccV4;
+    feature.enable_flags_ = sdm::kOpsEnable;
+    feature.pcc_.red.r = seed;
+    feature.pcc_.green.g = seed + 1;
+    feature.pcc_.blue.b = seed + 2;
+    feature.BindConfig(true);
+    return feature;
+  }
+
+  static TestFeature Gamut(uint32_t seed) {
+    TestFeature feature;
+    feature.feature_version_ = sdm::PPFeatureVersion::kSDEGamutV4;
+    feature.enable_flags_ = sdm::kOpsEnable;
+    feature.gamut_.mode = SDEGamutCfgWrapper::GAMUT_FINE_MODE;
+    feature.gamut_.map_en = 0;
+    feature.tables_.resize(2 * SDEGamutCfg::kGamutTableNum,
+                           std::vector<uint32_t>(SDEGamutCfg::kGamutTableSize));
+    for (int i = 0; i < SDEGamutCfg::kGamutTableNum; i++) {
+      for (int j = 0; j < SDEGamutCfg::kGamutTableSize; j++) {
+        feature.tables_[2 * i][j] = seed + i + j;
+        feature.tables_[2 * i + 1][j] = seed * 3 + j;
+      }
+    }
+    feature.BindConfig(false);
+    return feature;
+  }
+
+  TestFeature() {}
+  TestFeature(const TestFeature &other) : PPFeatureInfo(other) { *this = other; }
+
+  TestFeature &operator=(const TestFeature &other) {
+    PPFeatureInfo::operator=(other);
+    pcc_ = other.pcc_;
+    gamut_ = other.gamut_;
+    tables_ = other.tables_;
+    BindConfig(other.config_ == &other.pcc_);
+    return *this;
+  }
+
+  void *GetConfigData(void) const { return config_; }
+
+ private:
+  // Points the configuration at the members of this copy.
+  void BindConfig(bool pcc) {
+    for (int i = 0; i < SDEGamutCfg::kGamutTableNum && !tables_.empty(); i++) {
+      gamut_.c0_data[i] = tables_[2 * i].data();
+      gamut_.c1_c2_data[i] = tables_[2 * i + 1].data();
+    }
+    config_ = pcc ? static_cast<void *>(&pcc_) : static_cast<void *>(&gamut_);
+  }
+
+  SDEPccV4Cfg pcc_;
+  SDEGamutCfg gamut_ = {};
+  std::vector<std::vector<uint32_t>> tables_;
+  void *config_ = nullptr;
+};
+
+DRMPPFeatureInfo getRequest(DRMPPFeatureID id) {
+  DRMPPFeatureInfo info = {};
+  info.id = id;
+  return info;
+}
+
+class HWColorManagerDrmTestCases : public ::testing::Test {
+ protected:
+  void SetUp() {
+    for (auto &watched : g_watched) {
+      watched = nullptr;
+    }
+    g_watched_deletes = 0;
+  }
+
+  // Gets the PCC payload of the mode tagged tag, which has to be packed from the configuration
+  // unless the cache holds it.
+  DRMPPFeatureInfo getPcc(uint64_t tag, bool *cached) {
+    TestFeature pcc = TestFeature::Pcc(static_cast<uint32_t>(tag) * 10);
+    DRMPPFeatureInfo info = getRequest(kFeaturePcc);
+    EXPECT_THAT(color_mgr_.GetCachedDrmFeature(tag, &pcc, &info, cached), Eq(sdm::kErrorNone));
+    return info;
+  }
+
+  HWColorManagerDrm color_mgr_;
+};
+
+}  // namespace
+
+TEST_F(HWColorManagerDrmTestCases, UntaggedPayloadsAreNotCached) {
+  bool cached = true;
+  DRMPPFeatureInfo first = getPcc(0, &cached);
+  EXPECT_THAT(cached, Eq(false));
+  ASSERT_THAT(first.payload, NotNull());
+  EXPECT_THAT(first.payload_size, Eq(sizeof(drm_msm_pcc)));
+  EXPECT_THAT(reinterpret_cast<drm_msm_pcc *>(first.payload)->r.r, Eq(0U));
+
+  DRMPPFeatureInfo second = getPcc(0, &cached);
+  EXPECT_THAT(cached, Eq(false));
+  EXPECT_THAT(second.payload, Ne(first.payload));
+
+  // Payloads that are not cached belong to the caller.
+  Watch(first.payload);
+  Watch(second.payload);
+  color_mgr_.FreeDrmFeatureData(&first);
+  color_mgr_.FreeDrmFeatureData(&second);
+  EXPECT_THAT(g_watched_deletes.load(), Eq(2));
+}
+
+TEST_F(HWColorManagerDrmTestCases, TaggedPayloadIsPackedOnce) {
+  bool cached = false;
+  DRMPPFeatureInfo first = getPcc(1, &cached);
+  EXPECT_THAT(cached, Eq(true));
+  ASSERT_THAT(first.payload, NotNull());
+
+  // A hit hands out the same payload and does not look at the configuration at all.
+  TestFeature changed = TestFeature::Pcc(77);
+  DRMPPFeatureInfo info = getRequest(kFeaturePcc);
+  cached = false;
+  ASSERT_THAT(color_mgr_.GetCachedDrmFeature(1, &changed, &info, &cached), Eq(sdm::kErrorNone));
+  EXPECT_THAT(cached, Eq(true));
+  EXPECT_THAT(info.payload, Eq(first.payload));
+  EXPECT_THAT(info.payload_size, Eq(first.payload_size));
+  EXPECT_THAT(info.version, Eq(first.version));
+  EXPECT_THAT(info.type, Eq(first.type));
+  drm_msm_pcc *pcc = reinterpret_cast<drm_msm_pcc *>(info.payload);
+  EXPECT_THAT(pcc->r.r, Eq(10U));
+  EXPECT_THAT(pcc->g.g, Eq(11U));
+  EXPECT_THAT(pcc->b.b, Eq(12U));
+
+  // Another tag, or another feature of the same tag, is a miss.
+  DRMPPFeatureInfo other = getPcc(2, &cached);
+  EXPECT_THAT(other.payload, Ne(first.payload));
+  EXPECT_THAT(reinterpret_cast<drm_msm_pcc *>(other.payload)->r.r, Eq(20U));
+
+  TestFeature gamut = TestFeature::Gamut(5);
+  DRMPPFeatureInfo gamut_info = getRequest(kFeatureGamut);
+  ASSERT_THAT(color_mgr_.GetCachedDrmFeature(1, &gamut, &gamut_info, &cached),
+              Eq(sdm::kErrorNone));
+  EXPECT_THAT(cached, Eq(true));
+  ASSERT_THAT(gamut_info.payload, NotNull());
+  drm_msm_3d_gamut *mdp_gamut = reinterpret_cast<drm_msm_3d_gamut *>(gamut_info.payload);
+  EXPECT_THAT(mdp_gamut->mode, Eq(uint32_t(GAMUT_3D_MODE_17)));
+  EXPECT_THAT(mdp_gamut->col[3][1228].c0, Eq(5U + 3 + 1228));
+  EXPECT_THAT(mdp_gamut->col[3][1228].c2_c1, Eq(15U + 1228));
+}
+
+TEST_F(HWColorManagerDrmTestCases, DisabledFeatureHasNoPayload) {
+  TestFeature pcc = TestFeature::Pcc(1);
+  pcc.enable_flags_ = sdm::kOpsDisable;
+  DRMPPFeatureInfo info = getRequest(kFeaturePcc);
+  bool cached = false;
+  ASSERT_THAT(color_mgr_.GetCachedDrmFeature(3, &pcc, &info, &cached), Eq(sdm::kErrorNone));
+  EXPECT_THAT(cached, Eq(true));
+  EXPECT_THAT(info.payload, IsNull());
+
+  info = getRequest(kFeaturePcc);
+  ASSERT_THAT(color_mgr_.GetCachedDrmFeature(3, &pcc, &info, &cached), Eq(sdm::kErrorNone));
+  EXPECT_THAT(info.payload, IsNull());
+  EXPECT_THAT(info.payload_size, Eq(sizeof(drm_msm_pcc)));
+}
+
+TEST_F(HWColorManagerDrmTestCases, FailedPackingIsNotCached) {
+  TestFeature pcc = TestFeature::Pcc(1);
+  pcc.enable_flags_ = 0;
+  DRMPPFeatureInfo info = getRequest(kFeaturePcc);
+  bool cached = true;
+  EXPECT_THAT(color_mgr_.GetCachedDrmFeature(4, &pcc, &info, &cached),
+              Eq(sdm::kErrorParameters));
+  EXPECT_THAT(cached, Eq(false));
+
+  DRMPPFeatureInfo packed = getPcc(4, &cached);
+  EXPECT_THAT(cached, Eq(true));
+  EXPECT_THAT(packed.payload, NotNull());
+}
+
+TEST_F(HWColorManagerDrmTestCases, EvictsLeastRecentlyUsedTag) {
+  const uint64_t kTags = 8;
+  std::vector<void *> payloads;
+  bool cached = false;
+  for (uint64_t tag = 1; tag <= kTags; tag++) {
+    payloads.push_back(getPcc(tag, &cached).payload);
+    Watch(payloads.back());
+  }
+
+  // Tag 1 is used again, which leaves tag 2 the least recently used one.
+  EXPECT_THAT(getPcc(1, &cached).payload, Eq(payloads[0]));
+  EXPECT_THAT(g_watched_deletes.load(), Eq(0));
+
+  DRMPPFeatureInfo ninth = getPcc(kTags + 1, &cached);
+  EXPECT_THAT(cached, Eq(true));
+  EXPECT_THAT(g_watched_deletes.load(), Eq(1));
+  for (uint64_t tag = 1; tag <= kTags; tag++) {
+    if (tag != 2) {
+      EXPECT_THAT(getPcc(tag, &cached).payload, Eq(payloads[tag - 1])) << "tag " << tag;
+    }
+  }
+  EXPECT_THAT(g_watched_deletes.load(), Eq(1));
+
+  // Tag 2 gets packed anew, which in turn evicts tag 9, used least recently now.
+  Watch(ninth.payload);
+  DRMPPFeatureInfo second = getPcc(2, &cached);
+  EXPECT_THAT(cached, Eq(true));
+  EXPECT_THAT(reinterpret_cast<drm_msm_pcc *>(second.payload)->r.r, Eq(20U));
+  EXPECT_THAT(g_watched_deletes.load(), Eq(2));
+  EXPECT_THAT(getPcc(2, &cached).payload, Eq(second.payload));
+}
+
+TEST_F(HWColorManagerDrmTestCases, EvictionFreesAllFeaturesOfTag) {
+  bool cached = false;
+  Watch(getPcc(1, &cached).payload);
+  TestFeature gamut = TestFeature::Gamut(1);
+  DRMPPFeatureInfo info = getRequest(kFeatureGamut);
+  ASSERT_THAT(color_mgr_.GetCachedDrmFeature(1, &gamut, &info, &cached), Eq(sdm::kErrorNone));
+  Watch(info.payload);
+
+  for (uint64_t tag = 2; tag <= 9; tag++) {
+    getPcc(tag, &cached);
+  }
+  EXPECT_THAT(g_watched_deletes.load(), Eq(2));
+}
+
+TEST_F(HWColorManagerDrmTestCases, ClearAndDestructionFreePayloads) {
+  bool cached = false;
+  for (uint64_t tag = 1; tag <= 3; tag++) {
+    Watch(getPcc(tag, &cached).payload);
+  }
+  color_mgr_.ClearPayloadCache();
+  EXPECT_THAT(g_watched_deletes.load(), Eq(3));
+
+  // The cache is empty afterwards, the next request packs again.
+  DRMPPFeatureInfo info = getPcc(1, &cached);
+  EXPECT_THAT(cached, Eq(true));
+  EXPECT_THAT(info.payload, NotNull());
+
+  g_watched_deletes = 0;
+  {
+    HWColorManagerDrm color_mgr;
+    for (uint64_t tag = 1; tag <= 4; tag++) {
+      TestFeature gamut = TestFeature::Gamut(static_cast<uint32_t>(tag));
+      DRMPPFeatureInfo gamut_info = getRequest(kFeatureGamut);
+      ASSERT_THAT(color_mgr.GetCachedDrmFeature(tag, &gamut, &gamut_info, &cached),
+                  Eq(sdm::kErrorNone));
+      Watch(gamut_info.payload);
+    }
+    EXPECT_THAT(g_watched_deletes.load(), Eq(0));
+  }
+  EXPECT_THAT(g_watched_deletes.load(), Eq(4));
+}
+
+// Switching back and forth between two modes, each setting a PCC and a fine gamut, the way
+// SetPPFeatures does it before and after the cache.
+TEST_F(HWColorManagerDrmTestCases, ModeSwitchBenchmark) {
+  const int kSwitches = 2000;
+  TestFeature pcc[2] = {TestFeature::Pcc(1), TestFeature::Pcc(2)};
+  TestFeature gamut[2] = {TestFeature::Gamut(1), TestFeature::Gamut(2)};
+  uint64_t checksum = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kSwitches; i++) {
+    DRMPPFeatureInfo pcc_info = getRequest(kFeaturePcc);
+    DRMPPFeatureInfo gamut_info = getRequest(kFeatureGamut);
+    color_mgr_.GetDrmFeature(&pcc[i % 2], &pcc_info);
+    color_mgr_.GetDrmFeature(&gamut[i % 2], &gamut_info);
+    checksum += reinterpret_cast<drm_msm_3d_gamut *>(gamut_info.payload)->col[0][i % 1229].c0;
+    color_mgr_.FreeDrmFeatureData(&pcc_info);
+    color_mgr_.FreeDrmFeatureData(&gamut_info);
+  }
+  auto packed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start).count() / kSwitches;
+
+  start = std::chrono::steady_clock::now();
+  bool cached = false;
+  for (int i = 0; i < kSwitches; i++) {
+    DRMPPFeatureInfo pcc_info = getRequest(kFeaturePcc);
+    DRMPPFeatureInfo gamut_info = getRequest(kFeatureGamut);
+    color_mgr_.GetCachedDrmFeature(1 + i % 2, &pcc[i % 2], &pcc_info, &cached);
+    color_mgr_.GetCachedDrmFeature(1 + i % 2, &gamut[i % 2], &gamut_info, &cached);
+    checksum -= reinterpret_cast<drm_msm_3d_gamut *>(gamut_info.payload)->col[0][i % 1229].c0;
+  }
+  auto cached_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start).count() / kSwitches;
+
+  printf("Mode switch: packed %lld ns, cached %lld ns\n", static_cast<long long>(packed_ns),
+         static_cast<long long>(cached_ns));
+  EXPECT_THAT(checksum, Eq(0U));
+  EXPECT_THAT(cached_ns * 5, Lt(packed_ns));
+}
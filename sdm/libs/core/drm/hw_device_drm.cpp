@@ -1249,6 +1249,10 @@ DisplayError HWDeviceDRM::PowerOff(bool teardown, SyncPoints *sync_points) {
   }
 
   int ret = NullCommit(false /* synchronous */, false /* retain_planes */);
+  if (hw_color_mgr_) {
+    // Do not rely on post-processing state surviving the power collapse.
+    hw_color_mgr_->ResetCommittedPayloads();
+  }
   shared_ptr<Fence> retire_fence = Fence::Create(INT(retire_fence_fd), "retire_power_off");
   if (ret) {
     DLOGE("Failed with error: %d, dynamic_fps=%d, seamless_mode_switch_=%d, vrefresh_=%d,"
@@ -1770,6 +1774,10 @@ DisplayError HWDeviceDRM::Validate(HWLayersInfo *hw_layers_info) {
   SetupAtomic(scoped_ref, hw_layers_info, true /* validate */, nullptr, nullptr);
 
   int ret = drm_atomic_intf_->Validate();
+  if (hw_color_mgr_) {
+    // A test only commit drops the request, post-processing included.
+    hw_color_mgr_->CommitStagedPayloads(false);
+  }
   if (ret) {
     DLOGE("failed with error %d for %s", ret, device_name_);
     DumpHWLayers(hw_layers_info);
@@ -1869,6 +1877,9 @@ DisplayError HWDeviceDRM::AtomicCommit(HWLayersInfo *hw_layers_info) {
   }
 
   int ret = drm_atomic_intf_->Commit(sync_commit, false /* retain_planes*/);
+  if (hw_color_mgr_) {
+    hw_color_mgr_->CommitStagedPayloads(!ret);
+  }
   shared_ptr<Fence> release_fence = Fence::Create(INT(release_fence_fd), "release");
   shared_ptr<Fence> retire_fence = Fence::Create(INT(retire_fence_fd), "retire");
   if (ret) {
@@ -2101,10 +2112,15 @@ DisplayError HWDeviceDRM::SetPPFeatures(PPFeaturesConfig *feature_list) {
   int ret = 0;
   DRMCrtcInfo crtc_info = {};
   PPFeatureInfo *feature = NULL;
+  uint32_t dirty_mask = 0;
+  uint32_t clean_mask = 0;
 
   if (!hw_color_mgr_)
     return kErrorNotSupported;
 
+  // Pack all features of the frame first, then emit them in one go. Features that would set the
+  // payload the hardware holds already are dropped from the batch.
+  pp_batch_.clear();
   while (true) {
     std::vector<DRMPPFeatureID> drm_id = {};
     DRMPPFeatureInfo kernel_params = {};
@@ -2128,6 +2144,8 @@ DisplayError HWDeviceDRM::SetPPFeatures(PPFeaturesConfig *feature_list) {
     if (kernel_params.version == std::numeric_limits<uint32_t>::max())
       crtc_feature = false;
 
+    // Features of a color mode seen before reuse the payloads packed back then.
+    uint64_t payload_tag = feature_list->GetPayloadTag(feature);
     DLOGV_IF(kTagDriverConfig, "feature_id = %d", feature->feature_id_);
     for (DRMPPFeatureID id : drm_id) {
       if (id >= kPPFeaturesMax) {
@@ -2135,19 +2153,45 @@ DisplayError HWDeviceDRM::SetPPFeatures(PPFeaturesConfig *feature_list) {
         continue;
       }
 
-      kernel_params.id = id;
-      ret = hw_color_mgr_->GetDrmFeature(feature, &kernel_params);
-      if (!ret && crtc_feature)
-        drm_atomic_intf_->Perform(DRMOps::CRTC_SET_POST_PROC,
-                                  token_.crtc_id, &kernel_params);
-      else if (!ret && !crtc_feature)
-        drm_atomic_intf_->Perform(DRMOps::CONNECTOR_SET_POST_PROC,
-                                  token_.conn_id, &kernel_params);
+      PPBatchEntry entry = {};
+      entry.params = kernel_params;
+      entry.params.id = id;
+      entry.crtc_feature = crtc_feature;
+      entry.feature_id = feature->feature_id_;
+      ret = hw_color_mgr_->GetCachedDrmFeature(payload_tag, feature, &entry.params,
+                                               &entry.cached);
+      if (!ret && !hw_color_mgr_->IsPayloadCommitted(entry.params)) {
+        pp_batch_.push_back(entry);
+        continue;
+      }
 
-      hw_color_mgr_->FreeDrmFeatureData(&kernel_params);
+      if (!ret) {
+        clean_mask |= (1U << entry.feature_id);
+        DLOGV_IF(kTagDriverConfig, "drm feature %d unchanged, skipped", id);
+      }
+      if (!entry.cached) {
+        hw_color_mgr_->FreeDrmFeatureData(&entry.params);
+      }
     }
   }
 
+  for (PPBatchEntry &entry : pp_batch_) {
+    if (entry.crtc_feature)
+      drm_atomic_intf_->Perform(DRMOps::CRTC_SET_POST_PROC, token_.crtc_id, &entry.params);
+    else
+      drm_atomic_intf_->Perform(DRMOps::CONNECTOR_SET_POST_PROC, token_.conn_id, &entry.params);
+
+    hw_color_mgr_->StagePayload(entry.params);
+    dirty_mask |= (1U << entry.feature_id);
+    if (!entry.cached) {
+      hw_color_mgr_->FreeDrmFeatureData(&entry.params);
+    }
+  }
+  pp_batch_.clear();
+
+  // A feature counts as clean only if none of its DRM features had to be written.
+  feature_list->SetCommitMasks(dirty_mask, clean_mask & ~dirty_mask);
+
   // Once all features were consumed, then destroy all feature instance from feature_list,
   feature_list->Reset();
 
@@ -2668,6 +2712,9 @@ DisplayError HWDeviceDRM::NullCommit(bool synchronous, bool retain_planes) {
   AddDimLayerIfNeeded();
   drm_atomic_intf_->Perform(DRMOps::NULL_COMMIT_PANEL_FEATURES, 0 /* argument is not used */);
   int ret = drm_atomic_intf_->Commit(synchronous , retain_planes);
+  if (hw_color_mgr_) {
+    hw_color_mgr_->CommitStagedPayloads(!ret);
+  }
   if (ret) {
     DLOGE("failed with error %d, crtc=%u", ret, token_.crtc_id);
     return kErrorHardware;
@@ -3191,6 +3238,11 @@ DisplayError HWDeviceDRM::SetPPConfig(void *payload, size_t size) {
 
   struct DRMPPFeatureInfo *info = reinterpret_cast<struct DRMPPFeatureInfo *> (payload);
 
+  // Set directly, so the staging of SetPPFeatures no longer knows what the hardware holds.
+  if (hw_color_mgr_ && !info->is_event) {
+    hw_color_mgr_->ForgetPayload(info->id);
+  }
+
   if (info->object_type == DRM_MODE_OBJECT_CONNECTOR && token_.conn_id) {
     drm_atomic_intf_->Perform(DRMOps::CONNECTOR_SET_POST_PROC, token_.conn_id, payload);
   } else if (info->object_type == DRM_MODE_OBJECT_CRTC && token_.crtc_id) {
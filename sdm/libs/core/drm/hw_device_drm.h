@@ -351,6 +351,7 @@ class HWDeviceDRM : public HWInterface {
   bool has_cwb_dither_ = false;     // virtual connector supports CWB Dither feature.
   static HWCwbConfig cwb_config_;
   static std::mutex cwb_state_lock_;  // cwb state lock. Set before accesing or updating cwb_config_
+  std::unique_ptr<HWColorManagerDrm> hw_color_mgr_ = {};
 
  private:
   void GetCWBCapabilities();
@@ -359,7 +360,14 @@ class HWDeviceDRM : public HWInterface {
   std::string interface_str_ = "DSI";
   bool resolution_switch_enabled_ = false;
   bool autorefresh_ = false;
-  std::unique_ptr<HWColorManagerDrm> hw_color_mgr_ = {};
+  // One packed post-processing feature waiting to be emitted by SetPPFeatures.
+  struct PPBatchEntry {
+    DRMPPFeatureInfo params = {};
+    bool crtc_feature = true;
+    bool cached = false;
+    uint32_t feature_id = 0;
+  };
+  std::vector<PPBatchEntry> pp_batch_ = {};
   bool seamless_mode_switch_ = false;
 };
 
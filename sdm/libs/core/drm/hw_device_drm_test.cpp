@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+
+#include <map>
+#include <vector>
+
+#include <display/drm/msm_drm_pp.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "hw_device_drm.h"
+using namespace testing;
+using sde_drm::DRMAtomicReqInterface;
+using sde_drm::DRMManagerInterface;
+using sde_drm::DRMOps;
+using sdm::HWColorManagerDrm;
+using sdm::HWDeviceDRM;
+using sdm::PPFeatureInfo;
+using sdm::PPFeaturesConfig;
+using sdm::SDEPccV4Cfg;
+
+namespace {
+
+const uint32_t kCrtcId = 100;
+const uint32_t kConnId = 200;
+
+// A post-processing property set through Perform(), with a copy of its payload.
+struct PostProc {
+  uint32_t obj_id = 0;
+  DRMPPFeatureID id = kPPFeaturesMax;
+  std::vector<uint8_t> payload;
+
+  template <class T>
+  const T *GetPayload() const {
+    return payload.size() == sizeof(T) ? reinterpret_cast<const T *>(payload.data()) : nullptr;
+  }
+};
+
+class FakeAtomicReq : public DRMAtomicReqInterface {
+ public:
+  int Perform(DRMOps opcode, uint32_t obj_id, ...) {
+    if (opcode != DRMOps::CRTC_SET_POST_PROC && opcode != DRMOps::CONNECTOR_SET_POST_PROC) {
+      return 0;
+    }
+
+    va_list args;
+    va_start(args, obj_id);
+    DRMPPFeatureInfo *info = va_arg(args, DRMPPFeatureInfo *);
+    va_end(args);
+    PostProc post_proc;
+    post_proc.obj_id = obj_id;
+    post_proc.id = info->id;
+    if (info->payload) {
+      const uint8_t *data = reinterpret_cast<const uint8_t *>(info->payload);
+      post_proc.payload.assign(data, data + info->payload_size);
+    }
+    post_procs.push_back(post_proc);
+    return 0;
+  }
+
+  int Commit(bool synchronous, bool retain_planes) {
+    commits++;
+    return commit_ret;
+  }
+
+  int Validate() {
+    validates++;
+    return 0;
+  }
+
+  std::vector<PostProc> post_procs;
+  int commit_ret = 0;
+  int commits = 0;
+  int validates = 0;
+};
+
+// Only the post-processing versions of the CRTC are asked for.
+class FakeDRMManager : public DRMManagerInterface {
+ public:
+  void GetPlanesInfo(sde_drm::DRMPlanesInfo *info) {}
+  int GetCrtcInfo(uint32_t crtc_id, sde_drm::DRMCrtcInfo *info) { return 0; }
+  int GetConnectorInfo(uint32_t conn_id, sde_drm::DRMConnectorInfo *info) { return 0; }
+  int GetConnectorsInfo(sde_drm::DRMConnectorsInfo *info) { return 0; }
+  int GetEncoderInfo(uint32_t encoder_id, sde_drm::DRMEncoderInfo *info) { return 0; }
+  int GetEncodersInfo(sde_drm::DRMEncodersInfo *info) { return 0; }
+  void GetCrtcPPInfo(uint32_t crtc_id, DRMPPFeatureInfo *info) {
+    info->version = 4;
+    info->object_type = DRM_MODE_OBJECT_CRTC;
+  }
+  int RegisterDisplay(sde_drm::DRMDisplayType disp_type, sde_drm::DRMDisplayToken *tok) {
+    return 0;
+  }
+  int RegisterDisplay(int32_t display_id, sde_drm::DRMDisplayToken *token) { return 0; }
+  void UnregisterDisplay(sde_drm::DRMDisplayToken *token) {}
+  int CreateAtomicReq(const sde_drm::DRMDisplayToken &token, DRMAtomicReqInterface **intf) {
+    return 0;
+  }
+  int DestroyAtomicReq(DRMAtomicReqInterface *intf) { return 0; }
+  int SetScalerLUT(const sde_drm::DRMScalerLUTInfo &lut_info) { return 0; }
+  int UnsetScalerLUT() { return 0; }
+  void GetDppsFeatureInfo(sde_drm::DRMDppsFeatureInfo *info) {}
+  void GetPanelFeature(sde_drm::DRMPanelFeatureInfo *info) {}
+  void SetPanelFeature(const sde_drm::DRMPanelFeatureInfo &info) {}
+  void MarkPanelFeatureForNullCommit(const sde_drm::DRMDisplayToken &token,
+                                     const sde_drm::DRMPanelFeatureID &id) {}
+  void MapPlaneToConnector(std::map<uint32_t, uint32_t> *plane_to_connector) {}
+  void GetRequiredDemuraFetchResourceCount(
+      std::map<uint32_t, uint8_t> *required_demura_fetch_cnt) {}
+  void GetInitialDemuraInfo(std::vector<uint32_t> *initial_demura_planes) {}
+};
+
+// A display past its first cycle, in default mode so that commits carry nothing but what the
+// test sets up.
+class TestDevice : public HWDeviceDRM {
+ public:
+  TestDevice(FakeDRMManager *drm_mgr, FakeAtomicReq *drm_atomic)
+    : HWDeviceDRM(nullptr, nullptr) {
+    drm_mgr_intf_ = drm_mgr;
+    drm_atomic_intf_ = drm_atomic;
+    token_.crtc_id = kCrtcId;
+    token_.conn_id = kConnId;
+    default_mode_ = true;
+    first_cycle_ = false;
+    connector_info_.modes.resize(1);
+    hw_color_mgr_.reset(new HWColorManagerDrm());
+  }
+
+  using HWDeviceDRM::NullCommit;
+  using HWDeviceDRM::PowerOff;
+  using HWDeviceDRM::SetPPConfig;
+  using HWDeviceDRM::SetPPFeatures;
+  using HWDeviceDRM::Validate;
+};
+
+class TestPcc : public PPFeatureInfo {
+ public:
+  explicit TestPcc(uint32_t red) {
+    feature_version_ = sdm::PPFeatureVersion::kSDEPccV4;
+    feature_id_ = sdm::kGlobalColorFeaturePcc;
+    enable_flags_ = sdm::kOpsEnable;
+    pcc_.red.c = red;
+  }
+
+  void *GetConfigData(void) const { return const_cast<SDEPccV4Cfg *>(&pcc_); }
+
+ private:
+  SDEPccV4Cfg pcc_;
+};
+
+class TestDither : public PPFeatureInfo {
+ public:
+  explicit TestDither(uint32_t depth) {
+    feature_version_ = sdm::PPFeatureVersion::kSDEDitherV17;
+    feature_id_ = sdm::kGlobalColorFeatureDither;
+    enable_flags_ = sdm::kOpsEnable;
+    dither_.g_y_depth = depth;
+    dither_.r_cr_depth = depth;
+    dither_.b_cb_depth = depth;
+    dither_.length = 0;
+  }
+
+  void *GetConfigData(void) const { return const_cast<sdm::SDEDitherCfg *>(&dither_); }
+
+ private:
+  sdm::SDEDitherCfg dither_ = {};
+};
+
+const uint32_t kPccBit = 1U << sdm::kGlobalColorFeaturePcc;
+const uint32_t kDitherBit = 1U << sdm::kGlobalColorFeatureDither;
+
+class HWDeviceDRMTestCases : public ::testing::Test {
+ protected:
+  HWDeviceDRMTestCases() : device_(&drm_mgr_, &drm_atomic_) {}
+
+  // Sets a PCC and a dither the way ColorManager does for a frame, and returns the DRM features
+  // that made it into the request.
+  std::vector<DRMPPFeatureID> setFeatures(uint32_t red, uint32_t depth, uint64_t tag = 0) {
+    config_.AddFeature(sdm::kGlobalColorFeaturePcc, new TestPcc(red));
+    config_.AddFeature(sdm::kGlobalColorFeatureDither, new TestDither(depth));
+    config_.SetPayloadTag(sdm::kGlobalColorFeaturePcc, tag);
+    config_.SetPayloadTag(sdm::kGlobalColorFeatureDither, tag);
+    drm_atomic_.post_procs.clear();
+    EXPECT_THAT(device_.SetPPFeatures(&config_), Eq(sdm::kErrorNone));
+
+    std::vector<DRMPPFeatureID> ids;
+    for (auto &post_proc : drm_atomic_.post_procs) {
+      EXPECT_THAT(post_proc.obj_id, Eq(kCrtcId));
+      EXPECT_THAT(post_proc.payload, Not(IsEmpty()));
+      ids.push_back(post_proc.id);
+    }
+    return ids;
+  }
+
+  FakeDRMManager drm_mgr_;
+  FakeAtomicReq drm_atomic_;
+  TestDevice device_;
+  PPFeaturesConfig config_;
+};
+
+}  // namespace
+
+TEST_F(HWDeviceDRMTestCases, CommittedPayloadsAreLeftOut) {
+  EXPECT_THAT(setFeatures(1, 6), ElementsAre(kFeaturePcc, kFeatureDither));
+  EXPECT_THAT(config_.GetDirtyMask(), Eq(kPccBit | kDitherBit));
+  EXPECT_THAT(config_.GetCleanMask(), Eq(0U));
+  EXPECT_THAT(device_.NullCommit(true, false), Eq(sdm::kErrorNone));
+
+  EXPECT_THAT(setFeatures(1, 6), IsEmpty());
+  EXPECT_THAT(config_.GetDirtyMask(), Eq(0U));
+  EXPECT_THAT(config_.GetCleanMask(), Eq(kPccBit | kDitherBit));
+
+  // Only what changed is set, with the new payload.
+  EXPECT_THAT(setFeatures(2, 6), ElementsAre(kFeaturePcc));
+  ASSERT_THAT(drm_atomic_.post_procs[0].GetPayload<drm_msm_pcc>(), NotNull());
+  EXPECT_THAT(drm_atomic_.post_procs[0].GetPayload<drm_msm_pcc>()->r.c, Eq(2U));
+  EXPECT_THAT(config_.GetDirtyMask(), Eq(kPccBit));
+  EXPECT_THAT(config_.GetCleanMask(), Eq(kDitherBit));
+  EXPECT_THAT(device_.NullCommit(true, false), Eq(sdm::kErrorNone));
+
+  // Going back to the previous payload is a change as well.
+  EXPECT_THAT(setFeatures(1, 6), ElementsAre(kFeaturePcc));
+  EXPECT_THAT(device_.NullCommit(true, false), Eq(sdm::kErrorNone));
+  EXPECT_THAT(setFeatures(1, 8), ElementsAre(kFeatureDither));
+}
+
+TEST_F(HWDeviceDRMTestCases, StagedPayloadsAreLeftOutUntilCommit) {
+  // Features set twice for one request are written once, and stay pending until the commit.
+  EXPECT_THAT(setFeatures(1, 6), ElementsAre(kFeaturePcc, kFeatureDither));
+  EXPECT_THAT(setFeatures(1, 6), IsEmpty());
+  EXPECT_THAT(setFeatures(2, 6), ElementsAre(kFeaturePcc));
+  EXPECT_THAT(device_.NullCommit(true, false), Eq(sdm::kErrorNone));
+  EXPECT_THAT(setFeatures(2, 6), IsEmpty());
+}
+
+TEST_F(HWDeviceDRMTestCases, FailedCommitSetsPayloadsAgain) {
+  EXPECT_THAT(setFeatures(1, 6), ElementsAre(kFeaturePcc, kFeatureDither));
+  EXPECT_THAT(device_.NullCommit(true, false), Eq(sdm::kErrorNone));
+
+  // The failed commit may or may not have reached the hardware, so even the payloads it held
+  // already are set again.
+  EXPECT_THAT(setFeatures(2, 6), ElementsAre(kFeaturePcc));
+  drm_atomic_.commit_ret = -EINVAL;
+  EXPECT_THAT(device_.NullCommit(true, false), Eq(sdm::kErrorHardware));
+  drm_atomic_.commit_ret = 0;
+
+  EXPECT_THAT(setFeatures(2, 6), ElementsAre(kFeaturePcc));
+  EXPECT_THAT(setFeatures(1, 6), ElementsAre(kFeaturePcc));
+  EXPECT_THAT(device_.NullCommit(true, false), Eq(sdm::kErrorNone));
+  EXPECT_THAT(setFeatures(1, 6), IsEmpty());
+}
+
+TEST_F(HWDeviceDRMTestCases, TestOnlyCommitSetsPayloadsAgain) {
+  sdm::HWLayersInfo hw_layers_info = {};
+  EXPECT_THAT(setFeatures(1, 6), ElementsAre(kFeaturePcc, kFeatureDither));
+  EXPECT_THAT(device_.Validate(&hw_layers_info), Eq(sdm::kErrorNone));
+  EXPECT_THAT(drm_atomic_.validates, Eq(1));
+
+  // Validation dropped the request, the next commit has to carry the features.
+  EXPECT_THAT(setFeatures(1, 6), ElementsAre(kFeaturePcc, kFeatureDither));
+  EXPECT_THAT(device_.NullCommit(true, false), Eq(sdm::kErrorNone));
+  EXPECT_THAT(setFeatures(1, 6), IsEmpty());
+
+  // Validating a request that carries nothing new leaves the committed payloads alone.
+  EXPECT_THAT(device_.Validate(&hw_layers_info), Eq(sdm::kErrorNone));
+  EXPECT_THAT(setFeatures(1, 6), IsEmpty());
+}
+
+TEST_F(HWDeviceDRMTestCases, SetPPConfigForgetsPayload) {
+  EXPECT_THAT(setFeatures(1, 6), ElementsAre(kFeaturePcc, kFeatureDither));
+  EXPECT_THAT(device_.NullCommit(true, false), Eq(sdm::kErrorNone));
+
+  DRMPPFeatureInfo info = {};
+  info.id = kFeaturePcc;
+  info.object_type = DRM_MODE_OBJECT_CRTC;
+  drm_atomic_.post_procs.clear();
+  EXPECT_THAT(device_.SetPPConfig(&info, sizeof(info)), Eq(sdm::kErrorNone));
+  EXPECT_THAT(drm_atomic_.post_procs.size(), Eq(1U));
+  EXPECT_THAT(device_.NullCommit(true, false), Eq(sdm::kErrorNone));
+
+  EXPECT_THAT(setFeatures(1, 6), ElementsAre(kFeaturePcc));
+
+  // Events do not touch the payloads.
+  EXPECT_THAT(device_.NullCommit(true, false), Eq(sdm::kErrorNone));
+  info.is_event = true;
+  EXPECT_THAT(device_.SetPPConfig(&info, sizeof(info)), Eq(sdm::kErrorNone));
+  EXPECT_THAT(setFeatures(1, 6), IsEmpty());
+}
+
+TEST_F(HWDeviceDRMTestCases, PowerOffResetsPayloads) {
+  EXPECT_THAT(setFeatures(1, 6), ElementsAre(kFeaturePcc, kFeatureDither));
+  EXPECT_THAT(device_.NullCommit(true, false), Eq(sdm::kErrorNone));
+  EXPECT_THAT(setFeatures(1, 6), IsEmpty());
+
+  sdm::SyncPoints sync_points = {};
+  int commits = drm_atomic_.commits;
+  EXPECT_THAT(device_.PowerOff(false, &sync_points), Eq(sdm::kErrorNone));
+  EXPECT_THAT(drm_atomic_.commits, Eq(commits + 1));
+
+  EXPECT_THAT(setFeatures(1, 6), ElementsAre(kFeaturePcc, kFeatureDither));
+}
+
+TEST_F(HWDeviceDRMTestCases, TaggedPayloadsAreReused) {
+  EXPECT_THAT(setFeatures(3, 6, 7), ElementsAre(kFeaturePcc, kFeatureDither));
+  EXPECT_THAT(device_.NullCommit(true, false), Eq(sdm::kErrorNone));
+  EXPECT_THAT(setFeatures(4, 8, 9), ElementsAre(kFeaturePcc, kFeatureDither));
+  EXPECT_THAT(device_.NullCommit(true, false), Eq(sdm::kErrorNone));
+
+  // Tag 7 hands out what was packed for it, whatever the configuration says now.
+  EXPECT_THAT(setFeatures(5, 10, 7), ElementsAre(kFeaturePcc, kFeatureDither));
+  ASSERT_THAT(drm_atomic_.post_procs[0].GetPayload<drm_msm_pcc>(), NotNull());
+  EXPECT_THAT(drm_atomic_.post_procs[0].GetPayload<drm_msm_pcc>()->r.c, Eq(3U));
+  ASSERT_THAT(drm_atomic_.post_procs[1].GetPayload<drm_msm_dither>(), NotNull());
+  EXPECT_THAT(drm_atomic_.post_procs[1].GetPayload<drm_msm_dither>()->c0_bitdepth, Eq(6U));
+  EXPECT_THAT(device_.NullCommit(true, false), Eq(sdm::kErrorNone));
+  EXPECT_THAT(setFeatures(3, 6, 7), IsEmpty());
+}
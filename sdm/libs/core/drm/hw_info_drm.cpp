@@ -75,11 +75,13 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/utsname.h>
 #include <utils/constants.h>
 #include <utils/debug.h>
 #include <utils/sys.h>
 
 #include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <map>
@@ -89,6 +91,7 @@
 #include <vector>
 
 #include "hw_info_drm.h"
+#include "hw_info_snapshot.h"
 
 #ifndef DRM_FORMAT_MOD_QCOM_COMPRESSED
 #define DRM_FORMAT_MOD_QCOM_COMPRESSED fourcc_mod_code(QCOM, 1)
@@ -231,44 +234,31 @@ DisplayError HWInfoDRM::GetHWResourceInfo(HWResourceInfo *hw_resource) {
     return kErrorNone;
   }
 
-  hw_resource->num_blending_stages = 1;
-  hw_resource->max_pipe_width = 5120;
-  hw_resource->max_cursor_size = 128;
-  hw_resource->max_scale_down = 1;
-  hw_resource->max_scale_up = 1;
-  hw_resource->has_decimation = false;
-  hw_resource->max_bandwidth_low = 9600000;
-  hw_resource->max_bandwidth_high = 9600000;
-  hw_resource->max_pipe_bw = 4500000;
-  hw_resource->max_sde_clk = 412500000;
-  hw_resource->clk_fudge_factor = FLOAT(105) / FLOAT(100);
-  hw_resource->macrotile_nv12_factor = 8;
-  hw_resource->macrotile_factor = 4;
-  hw_resource->linear_factor = 1;
-  hw_resource->scale_factor = 1;
-  hw_resource->extra_fudge_factor = 2;
-  hw_resource->amortizable_threshold = 25;
-  hw_resource->system_overhead_lines = 0;
-  hw_resource->hw_dest_scalar_info.count = 0;
-  hw_resource->hw_dest_scalar_info.max_scale_up = 0;
-  hw_resource->hw_dest_scalar_info.max_input_width = 0;
-  hw_resource->hw_dest_scalar_info.max_output_width = 0;
-  hw_resource->is_src_split = true;
-  hw_resource->has_qseed3 = false;
-  hw_resource->has_concurrent_writeback = false;
+  auto start = std::chrono::steady_clock::now();
+  int disable_snapshot = 0;
+  Debug::GetProperty(DISABLE_HW_INFO_SNAPSHOT_PROP, &disable_snapshot);
 
-  hw_resource->hw_version = SDEVERSION(4, 0, 1);
+  string snapshot_key;
+  bool from_snapshot = false;
+  if (!disable_snapshot) {
+    GetSnapshotKey(&snapshot_key);
+    from_snapshot = HWInfoSnapshot::Load(kSnapshotPath, snapshot_key, hw_resource);
+  }
 
-  // TODO(user): Deprecate
-  hw_resource->max_mixer_width = 2560;
-  hw_resource->writeback_index = 0;
-  hw_resource->has_ubwc = true;
-  hw_resource->separate_rotator = true;
-  hw_resource->has_non_scalar_rgb = false;
+  if (from_snapshot) {
+    // Splash handoff state differs between a cold boot and a composer restart, query it again.
+    UpdateSplashInfo(hw_resource);
+  } else {
+    ProbeHWResourceInfo(hw_resource);
+    if (!disable_snapshot && !HWInfoSnapshot::Store(kSnapshotPath, snapshot_key, *hw_resource)) {
+      DLOGW("Failed to store HW info snapshot %s", kSnapshotPath);
+    }
+  }
 
-  GetSystemInfo(hw_resource);
-  GetHWPlanesInfo(hw_resource);
-  GetWBInfo(hw_resource);
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+  DLOGI("HW resource info %s in %lld us", from_snapshot ? "loaded from snapshot" : "probed",
+        static_cast<long long>(elapsed.count()));
 
   // Disable destination scalar count to 0 if extension library is not present or disabled
   // through property
@@ -318,10 +308,6 @@ DisplayError HWInfoDRM::GetHWResourceInfo(HWResourceInfo *hw_resource) {
   DLOGI("\tFudge_factor = %d", hw_resource->extra_fudge_factor);
   DLOGI("\tib_fudge_factor = %f", hw_resource->ib_fudge_factor);
 
-  if (hw_resource->separate_rotator || hw_resource->num_dma_pipe) {
-    GetHWRotatorInfo(hw_resource);
-  }
-
   DLOGI("Has Support for multiple bw limits shown below");
   for (int index = 0; index < kBwModeMax; index++) {
     DLOGI("Mode-index=%d  total_bw_limit=%" PRIu64 " and pipe_bw_limit=%" PRIu64, index,
@@ -337,6 +323,115 @@ DisplayError HWInfoDRM::GetHWResourceInfo(HWResourceInfo *hw_resource) {
   return kErrorNone;
 }
 
+void HWInfoDRM::ProbeHWResourceInfo(HWResourceInfo *hw_resource) {
+  hw_resource->num_blending_stages = 1;
+  hw_resource->max_pipe_width = 5120;
+  hw_resource->max_cursor_size = 128;
+  hw_resource->max_scale_down = 1;
+  hw_resource->max_scale_up = 1;
+  hw_resource->has_decimation = false;
+  hw_resource->max_bandwidth_low = 9600000;
+  hw_resource->max_bandwidth_high = 9600000;
+  hw_resource->max_pipe_bw = 4500000;
+  hw_resource->max_sde_clk = 412500000;
+  hw_resource->clk_fudge_factor = FLOAT(105) / FLOAT(100);
+  hw_resource->macrotile_nv12_factor = 8;
+  hw_resource->macrotile_factor = 4;
+  hw_resource->linear_factor = 1;
+  hw_resource->scale_factor = 1;
+  hw_resource->extra_fudge_factor = 2;
+  hw_resource->amortizable_threshold = 25;
+  hw_resource->system_overhead_lines = 0;
+  hw_resource->hw_dest_scalar_info.count = 0;
+  hw_resource->hw_dest_scalar_info.max_scale_up = 0;
+  hw_resource->hw_dest_scalar_info.max_input_width = 0;
+  hw_resource->hw_dest_scalar_info.max_output_width = 0;
+  hw_resource->is_src_split = true;
+  hw_resource->has_qseed3 = false;
+  hw_resource->has_concurrent_writeback = false;
+
+  hw_resource->hw_version = SDEVERSION(4, 0, 1);
+
+  // TODO(user): Deprecate
+  hw_resource->max_mixer_width = 2560;
+  hw_resource->writeback_index = 0;
+  hw_resource->has_ubwc = true;
+  hw_resource->separate_rotator = true;
+  hw_resource->has_non_scalar_rgb = false;
+
+  GetSystemInfo(hw_resource);
+  GetHWPlanesInfo(hw_resource);
+  GetWBInfo(hw_resource);
+
+  if (hw_resource->separate_rotator || hw_resource->num_dma_pipe) {
+    GetHWRotatorInfo(hw_resource);
+  }
+}
+
+// Everything that feeds ProbeHWResourceInfo() besides static hardware caps must be part of the
+// key, a snapshot probed under a different kernel, panel, plane layout or debug config is stale.
+void HWInfoDRM::GetSnapshotKey(string *key) {
+  struct utsname kernel = {};
+  if (!uname(&kernel)) {
+    *key += string(kernel.release) + " " + kernel.version + " " + kernel.machine + ";";
+  }
+
+  DRMCrtcInfo crtc_info;
+  drm_mgr_intf_->GetCrtcInfo(0 /* system_info */, &crtc_info);
+  *key += "hw:" + to_string(crtc_info.hw_version) + ";";
+
+  DRMPlanesInfo planes;
+  drm_mgr_intf_->GetPlanesInfo(&planes);
+  *key += "planes:";
+  for (auto &plane : planes) {
+    *key += to_string(plane.first) + "/" + to_string(static_cast<int>(plane.second.type)) + "/" +
+            to_string(plane.second.master_plane_id) + "/" +
+            to_string(plane.second.formats_supported.size()) + ",";
+  }
+  *key += ";";
+
+  sde_drm::DRMConnectorsInfo conn_infos;
+  drm_mgr_intf_->GetConnectorsInfo(&conn_infos);
+  *key += "panels:";
+  for (auto &conn : conn_infos) {
+    *key += to_string(conn.first) + "/" + to_string(conn.second.type) + "/" +
+            to_string(conn.second.panel_id) + "/" + to_string(conn.second.formats_supported.size()) +
+            ",";
+  }
+  *key += ";";
+
+  uint32_t max_vig_pipes = 0;
+  uint32_t max_dma_pipes = 0;
+  int disable_src_tonemap = 0;
+  Debug::GetReducedConfig(&max_vig_pipes, &max_dma_pipes);
+  Debug::Get()->GetProperty(DISABLE_SRC_TONEMAP_PROP, &disable_src_tonemap);
+  *key += "config:" + to_string(max_vig_pipes) + "x" + to_string(max_dma_pipes) + "/" +
+          to_string(disable_src_tonemap);
+}
+
+void HWInfoDRM::UpdateSplashInfo(HWResourceInfo *hw_resource) {
+  hw_resource->plane_to_connector.clear();
+  hw_resource->initial_demura_planes.clear();
+  MapPlaneToConnector(hw_resource);
+  GetInitialDemuraInfo(hw_resource);
+  for (auto &pipe_caps : hw_resource->hw_pipes) {
+    PopulateSplashInfo(*hw_resource, &pipe_caps);
+  }
+}
+
+void HWInfoDRM::PopulateSplashInfo(const HWResourceInfo &hw_resource, HWPipeCaps *pipe_caps) {
+  pipe_caps->cont_splash_disp_id = -1;
+  pipe_caps->splash_type = kSplashNone;
+  auto it = hw_resource.plane_to_connector.find(pipe_caps->id);
+  if (it != hw_resource.plane_to_connector.end()) {
+    pipe_caps->cont_splash_disp_id = it->second;
+    auto it2 = std::find(hw_resource.initial_demura_planes.begin(),
+                         hw_resource.initial_demura_planes.end(), pipe_caps->id);
+    pipe_caps->splash_type = (it2 != hw_resource.initial_demura_planes.end()) ? kSplashDemura
+                                                                             : kSplashLayer;
+  }
+}
+
 void HWInfoDRM::GetSystemInfo(HWResourceInfo *hw_resource) {
   DRMCrtcInfo info;
   drm_mgr_intf_->GetCrtcInfo(0 /* system_info */, &info);
@@ -505,14 +600,7 @@ void HWInfoDRM::GetHWPlanesInfo(HWResourceInfo *hw_resource) {
         continue;  // Not adding any other pipe type
     }
     pipe_caps.id = pipe_obj.first;
-    auto it = hw_resource->plane_to_connector.find(pipe_caps.id);
-    if (it != hw_resource->plane_to_connector.end()) {
-      pipe_caps.cont_splash_disp_id = it->second;
-      auto it2 = std::find(hw_resource->initial_demura_planes.begin(),
-                           hw_resource->initial_demura_planes.end(), pipe_caps.id);
-      pipe_caps.splash_type = (it2 != hw_resource->initial_demura_planes.end()) ? kSplashDemura
-                                                                                : kSplashLayer;
-    }
+    PopulateSplashInfo(*hw_resource, &pipe_caps);
     pipe_caps.master_pipe_id = pipe_obj.second.master_plane_id;
     pipe_caps.block_sec_ui = pipe_obj.second.block_sec_ui;
     DLOGI("Adding %s Pipe : Id %d, master_pipe_id : Id %d block_sec_ui: %d",
@@ -94,6 +94,10 @@ class HWInfoDRM : public HWInfoInterface {
 
  private:
   void Deinit();
+  void ProbeHWResourceInfo(HWResourceInfo *hw_resource);
+  void GetSnapshotKey(std::string *key);
+  void UpdateSplashInfo(HWResourceInfo *hw_resource);
+  void PopulateSplashInfo(const HWResourceInfo &hw_resource, HWPipeCaps *pipe_caps);
   DisplayError GetHWRotatorInfo(HWResourceInfo *hw_resource);
   void GetSystemInfo(HWResourceInfo *hw_resource);
   void GetHWPlanesInfo(HWResourceInfo *hw_resource);
@@ -119,6 +123,7 @@ class HWInfoDRM : public HWInfoInterface {
 
   static const int kMaxStringLength = 1024;
   static const int kKiloUnit = 1000;
+  static constexpr const char *kSnapshotPath = "/data/vendor/display/hw_info.snapshot";
 
   static HWResourceInfo *hw_resource_;
 };
@@ -0,0 +1,588 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utils/debug.h>
+
+#include <initializer_list>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "hw_info_snapshot.h"
+
+#define __CLASS__ "HWInfoSnapshot"
+
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace sdm {
+
+namespace {
+
+class SnapshotWriter {
+ public:
+  explicit SnapshotWriter(vector<uint8_t> *out) : out_(out) {}
+
+  template <class T>
+  void Put(const T &value) {
+    static_assert(std::is_arithmetic<T>::value, "Put() takes arithmetic types only");
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+    out_->insert(out_->end(), bytes, bytes + sizeof(T));
+  }
+
+  template <class T>
+  void PutEnum(T value) {
+    Put(static_cast<uint32_t>(value));
+  }
+
+  void PutString(const string &value) {
+    Put(static_cast<uint32_t>(value.size()));
+    out_->insert(out_->end(), value.begin(), value.end());
+  }
+
+  template <class T>
+  void PutEnumVector(const vector<T> &values) {
+    Put(static_cast<uint32_t>(values.size()));
+    for (auto &value : values) {
+      PutEnum(value);
+    }
+  }
+
+  void PutPairVector(const vector<pair<uint32_t, uint32_t>> &values) {
+    Put(static_cast<uint32_t>(values.size()));
+    for (auto &value : values) {
+      Put(value.first);
+      Put(value.second);
+    }
+  }
+
+ private:
+  vector<uint8_t> *out_;
+};
+
+class SnapshotReader {
+ public:
+  SnapshotReader(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+
+  bool AtEnd() { return ok_ && (offset_ == size_); }
+
+  template <class T>
+  T Get() {
+    static_assert(std::is_arithmetic<T>::value, "Get() returns arithmetic types only");
+    T value = {};
+    if (Take(sizeof(T))) {
+      memcpy(&value, data_ + offset_ - sizeof(T), sizeof(T));
+    }
+    return value;
+  }
+
+  template <class T>
+  T GetEnum() {
+    return static_cast<T>(Get<uint32_t>());
+  }
+
+  string GetString() {
+    uint32_t size = Get<uint32_t>();
+    if (!Take(size)) {
+      return string();
+    }
+    return string(reinterpret_cast<const char *>(data_ + offset_ - size), size);
+  }
+
+  // Element counts are validated against the remaining bytes before anything is allocated, so a
+  // corrupt count can not make us reserve gigabytes.
+  uint32_t GetCount(size_t min_element_size) {
+    uint32_t count = Get<uint32_t>();
+    if (ok_ && (count > (size_ - offset_) / min_element_size)) {
+      ok_ = false;
+    }
+    return ok_ ? count : 0;
+  }
+
+  template <class T>
+  void GetEnumVector(vector<T> *values) {
+    uint32_t count = GetCount(sizeof(uint32_t));
+    values->clear();
+    values->reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+      values->push_back(GetEnum<T>());
+    }
+  }
+
+  void GetPairVector(vector<pair<uint32_t, uint32_t>> *values) {
+    uint32_t count = GetCount(2 * sizeof(uint32_t));
+    values->clear();
+    values->reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+      uint32_t first = Get<uint32_t>();
+      uint32_t second = Get<uint32_t>();
+      values->push_back(std::make_pair(first, second));
+    }
+  }
+
+ private:
+  bool Take(size_t size) {
+    if (!ok_ || size > (size_ - offset_)) {
+      ok_ = false;
+      return false;
+    }
+    offset_ += size;
+    return true;
+  }
+
+  const uint8_t *data_;
+  size_t size_;
+  size_t offset_ = 0;
+  bool ok_ = true;
+};
+
+void WritePipeCaps(const HWPipeCaps &caps, SnapshotWriter *writer) {
+  writer->PutEnum(caps.type);
+  writer->Put(caps.id);
+  writer->Put(caps.master_pipe_id);
+  writer->Put(caps.max_rects);
+  writer->Put(caps.inverse_pma);
+  writer->Put(caps.dgm_csc_version);
+  writer->Put(static_cast<uint32_t>(caps.tm_lut_version_map.size()));
+  for (auto &it : caps.tm_lut_version_map) {
+    writer->PutEnum(it.first);
+    writer->Put(it.second);
+  }
+  writer->Put(caps.block_sec_ui);
+  writer->Put(caps.cont_splash_disp_id);
+  writer->PutEnum(caps.splash_type);
+  writer->Put(caps.pipe_idx);
+  writer->Put(caps.demura_block_capability);
+}
+
+void ReadPipeCaps(SnapshotReader *reader, HWPipeCaps *caps) {
+  caps->type = reader->GetEnum<PipeType>();
+  caps->id = reader->Get<uint32_t>();
+  caps->master_pipe_id = reader->Get<uint32_t>();
+  caps->max_rects = reader->Get<uint32_t>();
+  caps->inverse_pma = reader->Get<bool>();
+  caps->dgm_csc_version = reader->Get<uint32_t>();
+  uint32_t lut_count = reader->GetCount(2 * sizeof(uint32_t));
+  for (uint32_t i = 0; i < lut_count; i++) {
+    HWToneMapLut lut = reader->GetEnum<HWToneMapLut>();
+    caps->tm_lut_version_map[lut] = reader->Get<uint32_t>();
+  }
+  caps->block_sec_ui = reader->Get<bool>();
+  caps->cont_splash_disp_id = reader->Get<int32_t>();
+  caps->splash_type = reader->GetEnum<SplashType>();
+  caps->pipe_idx = reader->Get<int32_t>();
+  caps->demura_block_capability = reader->Get<int32_t>();
+}
+
+void WriteResourceInfo(const HWResourceInfo &info, SnapshotWriter *writer) {
+  writer->Put(info.hw_version);
+  writer->Put(info.num_dma_pipe);
+  writer->Put(info.num_vig_pipe);
+  writer->Put(info.num_rgb_pipe);
+  writer->Put(info.num_cursor_pipe);
+  writer->Put(info.num_blending_stages);
+  writer->Put(info.num_solidfill_stages);
+  writer->Put(info.max_scale_up);
+  writer->Put(info.max_scale_down);
+  writer->Put(info.max_bandwidth_low);
+  writer->Put(info.max_bandwidth_high);
+  writer->Put(info.max_mixer_width);
+  writer->Put(info.max_pipe_width);
+  writer->Put(info.max_pipe_width_dma);
+  writer->Put(info.max_scaler_pipe_width);
+  writer->Put(info.max_rotation_pipe_width);
+  writer->Put(info.max_cursor_size);
+  writer->Put(info.max_pipe_bw);
+  writer->Put(info.max_pipe_bw_high);
+  writer->Put(info.max_sde_clk);
+  writer->Put(info.clk_fudge_factor);
+  writer->Put(info.macrotile_nv12_factor);
+  writer->Put(info.macrotile_factor);
+  writer->Put(info.linear_factor);
+  writer->Put(info.scale_factor);
+  writer->Put(info.extra_fudge_factor);
+  writer->Put(info.amortizable_threshold);
+  writer->Put(info.system_overhead_lines);
+  writer->Put(info.has_ubwc);
+  writer->Put(info.has_decimation);
+  writer->Put(info.has_non_scalar_rgb);
+  writer->Put(info.is_src_split);
+  writer->Put(info.separate_rotator);
+  writer->Put(info.has_qseed3);
+  writer->Put(info.has_concurrent_writeback);
+  writer->PutEnumVector(info.tap_points);
+  writer->Put(info.has_ppp);
+  writer->Put(info.has_excl_rect);
+  writer->Put(info.writeback_index);
+
+  writer->Put(info.dyn_bw_info.cur_mode);
+  for (int index = 0; index < kBwModeMax; index++) {
+    writer->Put(info.dyn_bw_info.total_bw_limit[index]);
+    writer->Put(info.dyn_bw_info.pipe_bw_limit[index]);
+  }
+
+  writer->Put(static_cast<uint32_t>(info.hw_pipes.size()));
+  for (auto &caps : info.hw_pipes) {
+    WritePipeCaps(caps, writer);
+  }
+
+  writer->Put(static_cast<uint32_t>(info.supported_formats_map.size()));
+  for (auto &it : info.supported_formats_map) {
+    writer->PutEnum(it.first);
+    writer->PutEnumVector(it.second);
+  }
+
+  writer->Put(info.hw_rot_info.num_rotator);
+  writer->Put(info.hw_rot_info.has_downscale);
+  writer->PutString(info.hw_rot_info.device_path);
+  writer->Put(info.hw_rot_info.min_downscale);
+  writer->Put(info.hw_rot_info.downscale_compression);
+  writer->Put(info.hw_rot_info.max_line_width);
+
+  writer->Put(info.hw_dest_scalar_info.count);
+  writer->Put(info.hw_dest_scalar_info.max_input_width);
+  writer->Put(info.hw_dest_scalar_info.max_output_width);
+  writer->Put(info.hw_dest_scalar_info.max_scale_up);
+  writer->Put(info.hw_dest_scalar_info.prefill_lines);
+
+  writer->Put(info.has_hdr);
+  writer->PutEnum(info.smart_dma_rev);
+  writer->Put(info.ib_fudge_factor);
+  writer->Put(info.undersized_prefill_lines);
+
+  for (const CompRatioMap *ratio_map : {&info.comp_ratio_rt_map, &info.comp_ratio_nrt_map}) {
+    writer->Put(static_cast<uint32_t>(ratio_map->size()));
+    for (auto &it : *ratio_map) {
+      writer->PutEnum(it.first);
+      writer->Put(it.second);
+    }
+  }
+
+  writer->Put(info.cache_size);
+  writer->PutEnum(info.pipe_qseed3_version);
+  writer->Put(info.min_prefill_lines);
+
+  writer->PutEnum(info.inline_rot_info.inrot_version);
+  writer->PutEnumVector(info.inline_rot_info.inrot_fmts_supported);
+  writer->Put(info.inline_rot_info.max_downscale_rt);
+  writer->Put(info.inline_rot_info.max_ds_without_pre_downscaler);
+
+  writer->Put(static_cast<uint32_t>(info.src_tone_map.to_ulong()));
+  writer->Put(info.secure_disp_blend_stage);
+  writer->Put(info.line_width_constraints_count);
+  writer->PutPairVector(info.line_width_limits);
+  writer->PutPairVector(info.line_width_constraints);
+  writer->Put(info.num_mnocports);
+  writer->Put(info.mnoc_bus_width);
+  writer->Put(info.use_baselayer_for_stage);
+  writer->Put(info.has_micro_idle);
+  writer->Put(info.ubwc_version);
+  writer->Put(info.rc_total_mem_size);
+
+  writer->Put(static_cast<uint32_t>(info.plane_to_connector.size()));
+  for (auto &it : info.plane_to_connector) {
+    writer->Put(it.first);
+    writer->Put(it.second);
+  }
+  writer->Put(static_cast<uint32_t>(info.initial_demura_planes.size()));
+  for (auto &plane : info.initial_demura_planes) {
+    writer->Put(plane);
+  }
+
+  writer->Put(info.demura_count);
+  writer->Put(info.dspp_count);
+  writer->Put(info.skip_inline_rot_threshold);
+  writer->Put(info.has_noise_layer);
+  writer->Put(info.dsc_block_count);
+  writer->PutEnum(info.ddr_version);
+}
+
+void ReadResourceInfo(SnapshotReader *reader, HWResourceInfo *info) {
+  info->hw_version = reader->Get<uint32_t>();
+  info->num_dma_pipe = reader->Get<uint32_t>();
+  info->num_vig_pipe = reader->Get<uint32_t>();
+  info->num_rgb_pipe = reader->Get<uint32_t>();
+  info->num_cursor_pipe = reader->Get<uint32_t>();
+  info->num_blending_stages = reader->Get<uint32_t>();
+  info->num_solidfill_stages = reader->Get<uint32_t>();
+  info->max_scale_up = reader->Get<uint32_t>();
+  info->max_scale_down = reader->Get<uint32_t>();
+  info->max_bandwidth_low = reader->Get<uint64_t>();
+  info->max_bandwidth_high = reader->Get<uint64_t>();
+  info->max_mixer_width = reader->Get<uint32_t>();
+  info->max_pipe_width = reader->Get<uint32_t>();
+  info->max_pipe_width_dma = reader->Get<uint32_t>();
+  info->max_scaler_pipe_width = reader->Get<uint32_t>();
+  info->max_rotation_pipe_width = reader->Get<uint32_t>();
+  info->max_cursor_size = reader->Get<uint32_t>();
+  info->max_pipe_bw = reader->Get<uint64_t>();
+  info->max_pipe_bw_high = reader->Get<uint64_t>();
+  info->max_sde_clk = reader->Get<uint32_t>();
+  info->clk_fudge_factor = reader->Get<float>();
+  info->macrotile_nv12_factor = reader->Get<uint32_t>();
+  info->macrotile_factor = reader->Get<uint32_t>();
+  info->linear_factor = reader->Get<uint32_t>();
+  info->scale_factor = reader->Get<uint32_t>();
+  info->extra_fudge_factor = reader->Get<uint32_t>();
+  info->amortizable_threshold = reader->Get<uint32_t>();
+  info->system_overhead_lines = reader->Get<uint32_t>();
+  info->has_ubwc = reader->Get<bool>();
+  info->has_decimation = reader->Get<bool>();
+  info->has_non_scalar_rgb = reader->Get<bool>();
+  info->is_src_split = reader->Get<bool>();
+  info->separate_rotator = reader->Get<bool>();
+  info->has_qseed3 = reader->Get<bool>();
+  info->has_concurrent_writeback = reader->Get<bool>();
+  reader->GetEnumVector(&info->tap_points);
+  info->has_ppp = reader->Get<bool>();
+  info->has_excl_rect = reader->Get<bool>();
+  info->writeback_index = reader->Get<uint32_t>();
+
+  info->dyn_bw_info.cur_mode = reader->Get<uint32_t>();
+  for (int index = 0; index < kBwModeMax; index++) {
+    info->dyn_bw_info.total_bw_limit[index] = reader->Get<uint64_t>();
+    info->dyn_bw_info.pipe_bw_limit[index] = reader->Get<uint64_t>();
+  }
+
+  uint32_t pipe_count = reader->GetCount(sizeof(uint32_t));
+  info->hw_pipes.clear();
+  info->hw_pipes.resize(pipe_count);
+  for (auto &caps : info->hw_pipes) {
+    ReadPipeCaps(reader, &caps);
+  }
+
+  uint32_t fmt_blocks = reader->GetCount(2 * sizeof(uint32_t));
+  info->supported_formats_map.clear();
+  for (uint32_t i = 0; i < fmt_blocks; i++) {
+    HWSubBlockType sub_blk_type = reader->GetEnum<HWSubBlockType>();
+    reader->GetEnumVector(&info->supported_formats_map[sub_blk_type]);
+  }
+
+  info->hw_rot_info.num_rotator = reader->Get<uint32_t>();
+  info->hw_rot_info.has_downscale = reader->Get<bool>();
+  info->hw_rot_info.device_path = reader->GetString();
+  info->hw_rot_info.min_downscale = reader->Get<float>();
+  info->hw_rot_info.downscale_compression = reader->Get<bool>();
+  info->hw_rot_info.max_line_width = reader->Get<uint32_t>();
+
+  info->hw_dest_scalar_info.count = reader->Get<uint32_t>();
+  info->hw_dest_scalar_info.max_input_width = reader->Get<uint32_t>();
+  info->hw_dest_scalar_info.max_output_width = reader->Get<uint32_t>();
+  info->hw_dest_scalar_info.max_scale_up = reader->Get<uint32_t>();
+  info->hw_dest_scalar_info.prefill_lines = reader->Get<uint32_t>();
+
+  info->has_hdr = reader->Get<bool>();
+  info->smart_dma_rev = reader->GetEnum<SmartDMARevision>();
+  info->ib_fudge_factor = reader->Get<float>();
+  info->undersized_prefill_lines = reader->Get<uint32_t>();
+
+  for (CompRatioMap *ratio_map : {&info->comp_ratio_rt_map, &info->comp_ratio_nrt_map}) {
+    uint32_t count = reader->GetCount(sizeof(uint32_t) + sizeof(float));
+    ratio_map->clear();
+    for (uint32_t i = 0; i < count; i++) {
+      LayerBufferFormat format = reader->GetEnum<LayerBufferFormat>();
+      (*ratio_map)[format] = reader->Get<float>();
+    }
+  }
+
+  info->cache_size = reader->Get<uint32_t>();
+  info->pipe_qseed3_version = reader->GetEnum<HWQseedStepVersion>();
+  info->min_prefill_lines = reader->Get<uint32_t>();
+
+  info->inline_rot_info.inrot_version = reader->GetEnum<InlineRotationVersion>();
+  reader->GetEnumVector(&info->inline_rot_info.inrot_fmts_supported);
+  info->inline_rot_info.max_downscale_rt = reader->Get<float>();
+  info->inline_rot_info.max_ds_without_pre_downscaler = reader->Get<float>();
+
+  info->src_tone_map = reader->Get<uint32_t>();
+  info->secure_disp_blend_stage = reader->Get<int>();
+  info->line_width_constraints_count = reader->Get<uint32_t>();
+  reader->GetPairVector(&info->line_width_limits);
+  reader->GetPairVector(&info->line_width_constraints);
+  info->num_mnocports = reader->Get<uint32_t>();
+  info->mnoc_bus_width = reader->Get<uint32_t>();
+  info->use_baselayer_for_stage = reader->Get<bool>();
+  info->has_micro_idle = reader->Get<bool>();
+  info->ubwc_version = reader->Get<uint32_t>();
+  info->rc_total_mem_size = reader->Get<uint32_t>();
+
+  uint32_t connector_count = reader->GetCount(2 * sizeof(uint32_t));
+  info->plane_to_connector.clear();
+  for (uint32_t i = 0; i < connector_count; i++) {
+    uint32_t plane_id = reader->Get<uint32_t>();
+    info->plane_to_connector[plane_id] = reader->Get<uint32_t>();
+  }
+  uint32_t demura_count = reader->GetCount(sizeof(uint32_t));
+  info->initial_demura_planes.clear();
+  for (uint32_t i = 0; i < demura_count; i++) {
+    info->initial_demura_planes.push_back(reader->Get<uint32_t>());
+  }
+
+  info->demura_count = reader->Get<uint32_t>();
+  info->dspp_count = reader->Get<uint32_t>();
+  info->skip_inline_rot_threshold = reader->Get<bool>();
+  info->has_noise_layer = reader->Get<bool>();
+  info->dsc_block_count = reader->Get<uint32_t>();
+  info->ddr_version = reader->GetEnum<DDRVersion>();
+}
+
+}  // namespace
+
+uint32_t HWInfoSnapshot::Checksum(const uint8_t *data, size_t size, uint32_t hash) {
+  for (size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+void HWInfoSnapshot::Serialize(const HWResourceInfo &hw_resource, const string &key,
+                               vector<uint8_t> *image) {
+  vector<uint8_t> payload;
+  SnapshotWriter writer(&payload);
+  WriteResourceInfo(hw_resource, &writer);
+
+  Header header = {};
+  header.magic = kMagic;
+  header.version = kVersion;
+  header.key_size = static_cast<uint32_t>(key.size());
+  header.payload_size = static_cast<uint32_t>(payload.size());
+  const uint8_t *key_data = reinterpret_cast<const uint8_t *>(key.data());
+  header.checksum = Checksum(payload.data(), payload.size(),
+                             Checksum(key_data, key.size(), 2166136261u));
+
+  image->clear();
+  image->reserve(sizeof(header) + key.size() + payload.size());
+  const uint8_t *header_data = reinterpret_cast<const uint8_t *>(&header);
+  image->insert(image->end(), header_data, header_data + sizeof(header));
+  image->insert(image->end(), key_data, key_data + key.size());
+  image->insert(image->end(), payload.begin(), payload.end());
+}
+
+bool HWInfoSnapshot::Deserialize(const uint8_t *image, size_t size, const string &key,
+                                 HWResourceInfo *hw_resource) {
+  Header header = {};
+  if (size < sizeof(header)) {
+    return false;
+  }
+
+  memcpy(&header, image, sizeof(header));
+  if (header.magic != kMagic || header.version != kVersion) {
+    DLOGI("Snapshot format %x/%u, expected %x/%u", header.magic, header.version, kMagic,
+          kVersion);
+    return false;
+  }
+
+  size_t expected_size = sizeof(header) + size_t(header.key_size) + size_t(header.payload_size);
+  if (size != expected_size) {
+    DLOGW("Snapshot size %zu, expected %zu", size, expected_size);
+    return false;
+  }
+
+  const uint8_t *key_data = image + sizeof(header);
+  if (header.key_size != key.size() || memcmp(key_data, key.data(), key.size())) {
+    DLOGI("Snapshot key mismatch, hardware or configuration changed");
+    return false;
+  }
+
+  const uint8_t *payload = key_data + header.key_size;
+  uint32_t checksum = Checksum(payload, header.payload_size,
+                               Checksum(key_data, header.key_size, 2166136261u));
+  if (checksum != header.checksum) {
+    DLOGW("Snapshot checksum mismatch");
+    return false;
+  }
+
+  // Decode into a scratch object so a truncated payload can not leave hw_resource half written.
+  HWResourceInfo info;
+  SnapshotReader reader(payload, header.payload_size);
+  ReadResourceInfo(&reader, &info);
+  if (!reader.AtEnd()) {
+    DLOGW("Malformed snapshot payload");
+    return false;
+  }
+
+  *hw_resource = std::move(info);
+
+  return true;
+}
+
+bool HWInfoSnapshot::Load(const string &path, const string &key, HWResourceInfo *hw_resource) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    if (errno != ENOENT) {
+      DLOGW("Failed to open %s, error = %d", path.c_str(), errno);
+    }
+    return false;
+  }
+
+  struct stat st = {};
+  if (fstat(fd, &st) || st.st_size <= 0) {
+    close(fd);
+    return false;
+  }
+
+  size_t size = static_cast<size_t>(st.st_size);
+  void *image = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (image == MAP_FAILED) {
+    DLOGW("Failed to map %s, error = %d", path.c_str(), errno);
+    return false;
+  }
+
+  bool loaded = Deserialize(static_cast<const uint8_t *>(image), size, key, hw_resource);
+  munmap(image, size);
+
+  return loaded;
+}
+
+bool HWInfoSnapshot::Store(const string &path, const string &key,
+                           const HWResourceInfo &hw_resource) {
+  vector<uint8_t> image;
+  Serialize(hw_resource, key, &image);
+
+  string tmp_path = path + ".tmp";
+  int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0660);
+  if (fd < 0) {
+    DLOGW("Failed to create %s, error = %d", tmp_path.c_str(), errno);
+    return false;
+  }
+
+  size_t written = 0;
+  while (written < image.size()) {
+    ssize_t ret = write(fd, image.data() + written, image.size() - written);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ret <= 0) {
+      DLOGW("Failed to write %s, error = %d", tmp_path.c_str(), errno);
+      close(fd);
+      unlink(tmp_path.c_str());
+      return false;
+    }
+    written += static_cast<size_t>(ret);
+  }
+
+  close(fd);
+  if (rename(tmp_path.c_str(), path.c_str())) {
+    DLOGW("Failed to rename %s, error = %d", tmp_path.c_str(), errno);
+    unlink(tmp_path.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+}  // namespace sdm
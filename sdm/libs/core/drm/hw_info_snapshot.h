@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __HW_INFO_SNAPSHOT_H__
+#define __HW_INFO_SNAPSHOT_H__
+
+#include <private/hw_info_types.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace sdm {
+
+// Versioned binary image of HWResourceInfo, used to skip re-probing DRM properties, sysfs and
+// V4L2 nodes when the composer is restarted on unchanged hardware. Every image carries a key
+// describing the hardware and configuration it was probed on; an image is only accepted if the
+// key matches byte for byte, so anything that can change the probed result must be in the key.
+class HWInfoSnapshot {
+ public:
+  static const uint32_t kMagic = 0x48495344;  // "DSIH"
+  static const uint32_t kVersion = 1;
+
+  // Bump kVersion whenever HWResourceInfo or the layout below changes.
+  static void Serialize(const HWResourceInfo &hw_resource, const std::string &key,
+                        std::vector<uint8_t> *image);
+  static bool Deserialize(const uint8_t *image, size_t size, const std::string &key,
+                          HWResourceInfo *hw_resource);
+
+  // Maps path and deserializes it. Returns false on a missing, stale or corrupt snapshot.
+  static bool Load(const std::string &path, const std::string &key, HWResourceInfo *hw_resource);
+  // Writes a new snapshot through a temporary file so readers never see a partial image.
+  static bool Store(const std::string &path, const std::string &key,
+                    const HWResourceInfo &hw_resource);
+
+ private:
+  struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t key_size;
+    uint32_t payload_size;
+    uint32_t checksum;  // FNV-1a over key and payload
+  };
+
+  static uint32_t Checksum(const uint8_t *data, size_t size, uint32_t hash);
+};
+
+}  // namespace sdm
+
+#endif  // __HW_INFO_SNAPSHOT_H__
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <unistd.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "hw_info_snapshot.h"
+using namespace testing;
+using sdm::HWInfoSnapshot;
+using sdm::HWPipeCaps;
+using sdm::HWResourceInfo;
+
+namespace {
+
+const std::string kKey = "5.15.94-android13|0x90000000|planes:12|panels:0x1234";
+
+std::string snapshotPath(const char *name) {
+  return TempDir() + name + ".snapshot";
+}
+
+// Non default values in every section of the image.
+HWResourceInfo makeInfo() {
+  HWResourceInfo info;
+  info.hw_version = 0x90000000;
+  info.num_dma_pipe = 4;
+  info.num_vig_pipe = 4;
+  info.num_cursor_pipe = 2;
+  info.num_blending_stages = 11;
+  info.max_scale_up = 20;
+  info.max_scale_down = 4;
+  info.max_bandwidth_low = 9600000000;
+  info.max_bandwidth_high = 12800000000;
+  info.max_mixer_width = 2560;
+  info.max_pipe_width = 4096;
+  info.max_pipe_bw = 4500000000;
+  info.max_sde_clk = 460000000;
+  info.clk_fudge_factor = 1.05f;
+  info.has_ubwc = true;
+  info.is_src_split = true;
+  info.has_qseed3 = true;
+  info.has_concurrent_writeback = true;
+  info.tap_points = {sdm::kLmTapPoint, sdm::kDemuraTapPoint};
+  info.writeback_index = 2;
+  info.dyn_bw_info.cur_mode = 1;
+  info.dyn_bw_info.total_bw_limit[1] = 7000000;
+  info.dyn_bw_info.pipe_bw_limit[1] = 3000000;
+
+  for (uint32_t i = 0; i < 12; i++) {
+    HWPipeCaps caps;
+    caps.type = i < 4 ? sdm::kPipeTypeVIG : sdm::kPipeTypeDMA;
+    caps.id = 100 + i;
+    caps.master_pipe_id = i % 2 ? 99 + i : 0;
+    caps.max_rects = 2;
+    caps.inverse_pma = i % 3 == 0;
+    caps.dgm_csc_version = i < 4 ? 0 : 1;
+    if (i >= 4) {
+      caps.tm_lut_version_map[sdm::kDma1dIgc] = 5;
+      caps.tm_lut_version_map[sdm::kDma1dGc] = 5;
+    }
+    caps.pipe_idx = static_cast<int32_t>(i);
+    caps.demura_block_capability = i == 11 ? 3 : -1;
+    info.hw_pipes.push_back(caps);
+  }
+
+  info.supported_formats_map[sdm::kHWVIGPipe] = {sdm::kFormatRGBA8888,
+                                                 sdm::kFormatYCbCr420SemiPlanarVenus};
+  info.supported_formats_map[sdm::kHWDMAPipe] = {sdm::kFormatRGBA8888, sdm::kFormatRGB565};
+  info.hw_rot_info.num_rotator = 1;
+  info.hw_rot_info.has_downscale = true;
+  info.hw_rot_info.device_path = "/dev/video3";
+  info.hw_dest_scalar_info.count = 2;
+  info.hw_dest_scalar_info.max_input_width = 2048;
+  info.has_hdr = true;
+  info.smart_dma_rev = sdm::SmartDMARevision::V2p5;
+  info.comp_ratio_rt_map[sdm::kFormatRGBA8888] = 1.5f;
+  info.comp_ratio_nrt_map[sdm::kFormatYCbCr420SemiPlanarVenus] = 1.25f;
+  info.inline_rot_info.inrot_version = sdm::kInlineRotationV2;
+  info.inline_rot_info.inrot_fmts_supported = {sdm::kFormatRGBA8888};
+  info.inline_rot_info.max_downscale_rt = 2.2f;
+  info.src_tone_map = 0x5;
+  info.line_width_constraints_count = 2;
+  info.line_width_limits = {{0, 2560}, {1, 4096}};
+  info.line_width_constraints = {{2, 5120}};
+  info.num_mnocports = 2;
+  info.ubwc_version = 4;
+  info.rc_total_mem_size = 4096;
+  info.plane_to_connector[110] = 31;
+  info.initial_demura_planes = {111};
+  info.demura_count = 2;
+  info.dspp_count = 4;
+  info.has_noise_layer = true;
+  info.dsc_block_count = 4;
+  info.ddr_version = sdm::kDDRVersion4;
+  return info;
+}
+
+std::vector<uint8_t> serialize(const HWResourceInfo &info, const std::string &key = kKey) {
+  std::vector<uint8_t> image;
+  HWInfoSnapshot::Serialize(info, key, &image);
+  return image;
+}
+
+bool deserialize(const std::vector<uint8_t> &image, size_t size, HWResourceInfo *info) {
+  return HWInfoSnapshot::Deserialize(image.data(), size, kKey, info);
+}
+
+}  // namespace
+
+TEST(HWInfoSnapshotTestCases, RoundTrip) {
+  const HWResourceInfo info = makeInfo();
+  const std::vector<uint8_t> image = serialize(info);
+
+  HWResourceInfo loaded;
+  ASSERT_TRUE(deserialize(image, image.size(), &loaded));
+  EXPECT_THAT(loaded.hw_version, Eq(info.hw_version));
+  EXPECT_THAT(loaded.max_bandwidth_high, Eq(info.max_bandwidth_high));
+  EXPECT_THAT(loaded.clk_fudge_factor, FloatEq(info.clk_fudge_factor));
+  EXPECT_THAT(loaded.tap_points, ElementsAre(sdm::kLmTapPoint, sdm::kDemuraTapPoint));
+  EXPECT_THAT(loaded.dyn_bw_info.pipe_bw_limit[1], Eq(3000000u));
+  ASSERT_THAT(loaded.hw_pipes.size(), Eq(12u));
+  EXPECT_THAT(loaded.hw_pipes[5].type, Eq(sdm::kPipeTypeDMA));
+  EXPECT_THAT(loaded.hw_pipes[5].master_pipe_id, Eq(104u));
+  EXPECT_THAT(loaded.hw_pipes[5].tm_lut_version_map,
+              ContainerEq(info.hw_pipes[5].tm_lut_version_map));
+  EXPECT_THAT(loaded.hw_pipes[11].demura_block_capability, Eq(3));
+  EXPECT_THAT(loaded.supported_formats_map, ContainerEq(info.supported_formats_map));
+  EXPECT_THAT(loaded.hw_rot_info.device_path, Eq("/dev/video3"));
+  EXPECT_THAT(loaded.smart_dma_rev, Eq(sdm::SmartDMARevision::V2p5));
+  EXPECT_THAT(loaded.comp_ratio_rt_map, ContainerEq(info.comp_ratio_rt_map));
+  EXPECT_THAT(loaded.comp_ratio_nrt_map, ContainerEq(info.comp_ratio_nrt_map));
+  EXPECT_THAT(loaded.inline_rot_info.inrot_fmts_supported, ElementsAre(sdm::kFormatRGBA8888));
+  EXPECT_THAT(loaded.src_tone_map.to_ulong(), Eq(0x5u));
+  EXPECT_THAT(loaded.line_width_limits, ContainerEq(info.line_width_limits));
+  EXPECT_THAT(loaded.line_width_constraints, ContainerEq(info.line_width_constraints));
+  EXPECT_THAT(loaded.plane_to_connector, ContainerEq(info.plane_to_connector));
+  EXPECT_THAT(loaded.initial_demura_planes, ElementsAre(111u));
+  EXPECT_THAT(loaded.ddr_version, Eq(sdm::kDDRVersion4));
+
+  // Every serialized field survives, so the loaded info serializes to the same image.
+  EXPECT_THAT(serialize(loaded), ContainerEq(image));
+}
+
+TEST(HWInfoSnapshotTestCases, DefaultInfoRoundTrip) {
+  const std::vector<uint8_t> image = serialize(HWResourceInfo());
+  HWResourceInfo loaded = makeInfo();
+  ASSERT_TRUE(deserialize(image, image.size(), &loaded));
+  EXPECT_THAT(loaded.hw_pipes, IsEmpty());
+  EXPECT_THAT(loaded.plane_to_connector, IsEmpty());
+  EXPECT_THAT(serialize(loaded), ContainerEq(image));
+}
+
+TEST(HWInfoSnapshotTestCases, RejectsOtherKeyOrVersion) {
+  const std::vector<uint8_t> image = serialize(makeInfo());
+  HWResourceInfo loaded;
+  EXPECT_FALSE(HWInfoSnapshot::Deserialize(image.data(), image.size(), kKey + "x", &loaded));
+  EXPECT_FALSE(HWInfoSnapshot::Deserialize(image.data(), image.size(), "", &loaded));
+
+  std::vector<uint8_t> other_version = image;
+  other_version[4]++;
+  EXPECT_FALSE(deserialize(other_version, other_version.size(), &loaded));
+}
+
+TEST(HWInfoSnapshotTestCases, RejectsDamagedImages) {
+  const HWResourceInfo info = makeInfo();
+  const std::vector<uint8_t> image = serialize(info);
+  HWResourceInfo loaded = info;
+  loaded.hw_version = 1;
+
+  for (size_t size = 0; size < image.size(); size++) {
+    ASSERT_FALSE(deserialize(image, size, &loaded)) << "truncated to " << size;
+  }
+  for (size_t i = 0; i < image.size(); i++) {
+    std::vector<uint8_t> damaged = image;
+    damaged[i] ^= 0x10;
+    ASSERT_FALSE(deserialize(damaged, damaged.size(), &loaded)) << "byte " << i;
+  }
+  std::vector<uint8_t> longer = image;
+  longer.push_back(0);
+  EXPECT_FALSE(deserialize(longer, longer.size(), &loaded));
+
+  // A rejected image leaves the output alone.
+  EXPECT_THAT(loaded.hw_version, Eq(1u));
+}
+
+TEST(HWInfoSnapshotTestCases, StoreAndLoad) {
+  const std::string path = snapshotPath("store");
+  unlink(path.c_str());
+  HWResourceInfo loaded;
+  EXPECT_FALSE(HWInfoSnapshot::Load(path, kKey, &loaded));
+
+  const HWResourceInfo info = makeInfo();
+  ASSERT_TRUE(HWInfoSnapshot::Store(path, kKey, info));
+  EXPECT_THAT(access((path + ".tmp").c_str(), F_OK), Ne(0));
+
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_TRUE(HWInfoSnapshot::Load(path, kKey, &loaded));
+  auto load_us = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start).count();
+  std::cout << "snapshot of " << serialize(info).size() << " bytes loaded in " << load_us
+            << " us" << std::endl;
+  EXPECT_THAT(serialize(loaded), ContainerEq(serialize(info)));
+  EXPECT_FALSE(HWInfoSnapshot::Load(path, kKey + "x", &loaded));
+
+  // Storing again replaces the image.
+  HWResourceInfo changed = info;
+  changed.num_vig_pipe = 2;
+  ASSERT_TRUE(HWInfoSnapshot::Store(path, kKey, changed));
+  ASSERT_TRUE(HWInfoSnapshot::Load(path, kKey, &loaded));
+  EXPECT_THAT(loaded.num_vig_pipe, Eq(2u));
+
+  std::ofstream(path, std::ios::trunc) << "not a snapshot";
+  EXPECT_FALSE(HWInfoSnapshot::Load(path, kKey, &loaded));
+  unlink(path.c_str());
+}
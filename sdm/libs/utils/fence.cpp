@@ -139,6 +139,16 @@ Fence::Status Fence::GetStatus(const shared_ptr<Fence> &fence) {
                                     Fence::Status::kPending : Fence::Status::kSignaled);
 }
 
+int Fence::GetSignalTime(const shared_ptr<Fence> &fence, int64_t *signal_time_ns) {
+  ASSERT_IF_NO_BUFFER_SYNC(g_buffer_sync_handler_);
+
+  if (!fence || !signal_time_ns) {
+    return -EINVAL;
+  }
+
+  return g_buffer_sync_handler_->GetSignalTime(Fence::Get(fence), signal_time_ns);
+}
+
 string Fence::GetStr(const shared_ptr<Fence> &fence) {
   return std::to_string(Fence::Get(fence));
 }
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <string.h>
+#include <utils/locker.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace sdm {
+
+std::atomic<bool> LockSite::stats_enabled_ {false};
+std::atomic<LockSite *> LockSite::head_ {nullptr};
+
+LockSite::LockSite(const char *file, const char *function, int line)
+  : file_(file), function_(function), line_(line) {
+  // Sites are never removed, so pushing to the head of the list needs no lock.
+  next_ = head_.load(std::memory_order_relaxed);
+  while (!head_.compare_exchange_weak(next_, this, std::memory_order_release,
+                                      std::memory_order_relaxed)) {
+  }
+}
+
+void LockSite::UpdateMax(std::atomic<uint64_t> *max, uint64_t value) {
+  uint64_t current = max->load(std::memory_order_relaxed);
+  while (value > current &&
+         !max->compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+void LockSite::RecordAcquire(uint64_t wait_ns, const LockSite *blocker) {
+  acquisitions_.fetch_add(1, std::memory_order_relaxed);
+  if (!wait_ns) {
+    return;
+  }
+
+  contended_.fetch_add(1, std::memory_order_relaxed);
+  wait_ns_.fetch_add(wait_ns, std::memory_order_relaxed);
+  UpdateMax(&max_wait_ns_, wait_ns);
+  if (blocker) {
+    last_blocker_.store(blocker, std::memory_order_relaxed);
+  }
+}
+
+void LockSite::RecordHold(uint64_t hold_ns) {
+  holds_.fetch_add(1, std::memory_order_relaxed);
+  hold_ns_.fetch_add(hold_ns, std::memory_order_relaxed);
+  UpdateMax(&max_hold_ns_, hold_ns);
+}
+
+void LockSite::Reset() {
+  for (LockSite *site = head_.load(std::memory_order_acquire); site; site = site->next_) {
+    site->acquisitions_.store(0, std::memory_order_relaxed);
+    site->contended_.store(0, std::memory_order_relaxed);
+    site->wait_ns_.store(0, std::memory_order_relaxed);
+    site->max_wait_ns_.store(0, std::memory_order_relaxed);
+    site->holds_.store(0, std::memory_order_relaxed);
+    site->hold_ns_.store(0, std::memory_order_relaxed);
+    site->max_hold_ns_.store(0, std::memory_order_relaxed);
+    site->last_blocker_.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+void LockSite::GetSnapshot(Snapshot *snapshot) const {
+  snapshot->site = this;
+  snapshot->acquisitions = acquisitions_.load(std::memory_order_relaxed);
+  snapshot->contended = contended_.load(std::memory_order_relaxed);
+  snapshot->wait_ns = wait_ns_.load(std::memory_order_relaxed);
+  snapshot->max_wait_ns = max_wait_ns_.load(std::memory_order_relaxed);
+  snapshot->holds = holds_.load(std::memory_order_relaxed);
+  snapshot->hold_ns = hold_ns_.load(std::memory_order_relaxed);
+  snapshot->max_hold_ns = max_hold_ns_.load(std::memory_order_relaxed);
+  snapshot->last_blocker = last_blocker_.load(std::memory_order_relaxed);
+}
+
+void LockSite::GetName(std::ostringstream *os) const {
+  const char *file = strrchr(file_, '/');
+  *os << (file ? file + 1 : file_) << ":" << line_ << " " << function_;
+}
+
+void LockSite::Dump(std::ostringstream *os, size_t count) {
+  // Sort a copy, the live counters may change under the comparisons.
+  std::vector<Snapshot> snapshots;
+  for (LockSite *site = head_.load(std::memory_order_acquire); site; site = site->next_) {
+    Snapshot snapshot;
+    site->GetSnapshot(&snapshot);
+    if (snapshot.holds) {
+      snapshots.push_back(snapshot);
+    }
+  }
+
+  auto by_wait = [](const Snapshot &a, const Snapshot &b) { return a.wait_ns > b.wait_ns; };
+  count = std::min(count, snapshots.size());
+  std::partial_sort(snapshots.begin(), snapshots.begin() + count, snapshots.end(), by_wait);
+
+  *os << "\n------------Lock Contention-----------";
+  *os << "\n" << snapshots.size() << " active sites, top " << count << " by wait time (us)";
+  for (size_t i = 0; i < count; i++) {
+    const Snapshot &snapshot = snapshots[i];
+    *os << "\n";
+    snapshot.site->GetName(os);
+    *os << " acquired " << snapshot.acquisitions;
+    *os << " contended " << snapshot.contended;
+    *os << " wait " << (snapshot.wait_ns / 1000);
+    *os << " max " << (snapshot.max_wait_ns / 1000);
+    *os << " hold avg " << (snapshot.hold_ns / snapshot.holds / 1000);
+    *os << " max " << (snapshot.max_hold_ns / 1000);
+    if (snapshot.last_blocker) {
+      *os << " blocked by ";
+      snapshot.last_blocker->GetName(os);
+    }
+  }
+  *os << "\n---------------------------------------\n";
+}
+
+}  // namespace sdm
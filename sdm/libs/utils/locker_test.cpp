@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <utils/locker.h>
+
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+using namespace testing;
+using sdm::Locker;
+using sdm::LockSite;
+
+namespace {
+
+const uint64_t kMsNs = 1000000;
+
+// Sites stay registered for the life of the process, so they are never freed.
+LockSite *NewSite(const char *file, const char *function, int line) {
+  return new LockSite(file, function, line);
+}
+
+LockSite::Snapshot GetSnapshot(const LockSite *site) {
+  LockSite::Snapshot snapshot;
+  site->GetSnapshot(&snapshot);
+  return snapshot;
+}
+
+class LockerTestCases : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    LockSite::Reset();
+    LockSite::EnableStats(true);
+  }
+
+  void TearDown() override {
+    LockSite::EnableStats(false);
+    LockSite::Reset();
+  }
+
+  // Takes the lock from another thread at site and holds it for hold_ms. Returns once the lock
+  // is owned.
+  std::thread HoldFromThread(Locker *locker, LockSite *site, int hold_ms) {
+    std::atomic<bool> locked {false};
+    std::thread holder([&locked, locker, site, hold_ms] {
+      Locker::ScopeLock lock(*locker, site);
+      locked = true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(hold_ms));
+    });
+    while (!locked) {
+      std::this_thread::yield();
+    }
+    return holder;
+  }
+
+  Locker locker_;
+};
+
+}  // namespace
+
+TEST_F(LockerTestCases, NothingRecordedWhileDisabled) {
+  LockSite *site = NewSite("locker_test.cpp", "Disabled", 1);
+  LockSite::EnableStats(false);
+  {
+    Locker::ScopeLock lock(locker_, site);
+  }
+  LockSite::Snapshot snapshot = GetSnapshot(site);
+  EXPECT_THAT(snapshot.acquisitions, Eq(0u));
+  EXPECT_THAT(snapshot.holds, Eq(0u));
+}
+
+TEST_F(LockerTestCases, UncontendedAcquisitions) {
+  LockSite *site = NewSite("locker_test.cpp", "Uncontended", 1);
+  for (int i = 0; i < 3; i++) {
+    Locker::ScopeLock lock(locker_, site);
+  }
+  LockSite::Snapshot snapshot = GetSnapshot(site);
+  EXPECT_THAT(snapshot.acquisitions, Eq(3u));
+  EXPECT_THAT(snapshot.contended, Eq(0u));
+  EXPECT_THAT(snapshot.wait_ns, Eq(0u));
+  EXPECT_THAT(snapshot.holds, Eq(3u));
+  EXPECT_THAT(snapshot.last_blocker, IsNull());
+}
+
+TEST_F(LockerTestCases, ContendedAcquisitionNamesBlocker) {
+  LockSite *holder_site = NewSite("locker_test.cpp", "Holder", 1);
+  LockSite *waiter_site = NewSite("locker_test.cpp", "Waiter", 2);
+  std::thread holder = HoldFromThread(&locker_, holder_site, 20);
+  {
+    Locker::ScopeLock lock(locker_, waiter_site);
+  }
+  holder.join();
+
+  LockSite::Snapshot waiter = GetSnapshot(waiter_site);
+  EXPECT_THAT(waiter.acquisitions, Eq(1u));
+  EXPECT_THAT(waiter.contended, Eq(1u));
+  EXPECT_THAT(waiter.wait_ns, Ge(10 * kMsNs));
+  EXPECT_THAT(waiter.max_wait_ns, Eq(waiter.wait_ns));
+  EXPECT_THAT(waiter.last_blocker, Eq(holder_site));
+  LockSite::Snapshot holder_snapshot = GetSnapshot(holder_site);
+  EXPECT_THAT(holder_snapshot.contended, Eq(0u));
+  EXPECT_THAT(holder_snapshot.max_hold_ns, Ge(20 * kMsNs));
+}
+
+TEST_F(LockerTestCases, ConditionWaitEndsHold) {
+  LockSite *site = NewSite("locker_test.cpp", "Waits", 1);
+  {
+    Locker::ScopeLock lock(locker_, site);
+    EXPECT_THAT(locker_.WaitFinite(30), Eq(ETIMEDOUT));
+  }
+  // Before and after the wait are two holds, the 30 ms in between count for neither.
+  LockSite::Snapshot snapshot = GetSnapshot(site);
+  EXPECT_THAT(snapshot.acquisitions, Eq(1u));
+  EXPECT_THAT(snapshot.holds, Eq(2u));
+  EXPECT_THAT(snapshot.hold_ns, Lt(30 * kMsNs));
+}
+
+TEST_F(LockerTestCases, ResetClearsCounters) {
+  LockSite *site = NewSite("locker_test.cpp", "Reset", 1);
+  site->RecordAcquire(5, site);
+  site->RecordHold(7);
+  LockSite::Reset();
+  LockSite::Snapshot snapshot = GetSnapshot(site);
+  EXPECT_THAT(snapshot.acquisitions, Eq(0u));
+  EXPECT_THAT(snapshot.wait_ns, Eq(0u));
+  EXPECT_THAT(snapshot.max_hold_ns, Eq(0u));
+  EXPECT_THAT(snapshot.last_blocker, IsNull());
+}
+
+TEST_F(LockerTestCases, DumpListsTopSitesByWait) {
+  LockSite *low = NewSite("/vendor/src/low.cpp", "Low", 10);
+  LockSite *high = NewSite("/vendor/src/high.cpp", "High", 20);
+  LockSite *mid = NewSite("mid.cpp", "Mid", 30);
+  LockSite *idle = NewSite("idle.cpp", "Idle", 40);
+  low->RecordAcquire(1000000, nullptr);
+  high->RecordAcquire(3000000, low);
+  mid->RecordAcquire(2000000, nullptr);
+  for (LockSite *site : {low, high, mid}) {
+    site->RecordHold(4000);
+  }
+
+  std::ostringstream os;
+  LockSite::Dump(&os, 2);
+  std::string dump = os.str();
+  EXPECT_THAT(dump, HasSubstr("3 active sites, top 2"));
+  EXPECT_THAT(dump, HasSubstr("high.cpp:20 High acquired 1 contended 1 wait 3000 max 3000 "
+                              "hold avg 4 max 4 blocked by low.cpp:10 Low"));
+  EXPECT_THAT(dump, HasSubstr("mid.cpp:30 Mid"));
+  EXPECT_THAT(dump.find("high.cpp"), Lt(dump.find("mid.cpp")));
+  EXPECT_THAT(dump, Not(HasSubstr("Low acquired")));
+  EXPECT_THAT(GetSnapshot(idle).holds, Eq(0u));
+  EXPECT_THAT(dump, Not(HasSubstr("Idle")));
+  EXPECT_THAT(dump, Not(HasSubstr("/vendor")));
+}
+
+TEST_F(LockerTestCases, ScopeLockSiteIsNamedByFile) {
+  SCOPE_LOCK(locker_);
+  std::ostringstream os;
+  lock_site.GetName(&os);
+  EXPECT_THAT(os.str(), StartsWith("locker_test.cpp:"));
+  EXPECT_THAT(os.str(), EndsWith(" TestBody"));
+}
+
+TEST_F(LockerTestCases, DumpWhileRecording) {
+  std::vector<LockSite *> sites;
+  for (int i = 0; i < 8; i++) {
+    sites.push_back(NewSite("locker_test.cpp", "Racing", i));
+    sites.back()->RecordHold(1);
+  }
+
+  std::atomic<bool> stop {false};
+  std::vector<std::thread> writers;
+  for (int t = 0; t < 4; t++) {
+    writers.emplace_back([&sites, &stop, t] {
+      for (uint64_t n = 1; !stop; n++) {
+        LockSite *site = sites[(n + t) % sites.size()];
+        site->RecordAcquire(n * (t + 1), nullptr);
+        site->RecordHold(n);
+      }
+    });
+  }
+  for (int i = 0; i < 200; i++) {
+    std::ostringstream os;
+    LockSite::Dump(&os, 5);
+    EXPECT_THAT(os.str(), HasSubstr("top 5"));
+  }
+  stop = true;
+  for (auto &writer : writers) {
+    writer.join();
+  }
+}
+
+TEST_F(LockerTestCases, PriorityInheritanceMutualExclusion) {
+  ASSERT_THAT(locker_.EnablePriorityInheritance(), Eq(0));
+
+  LockSite *site = NewSite("locker_test.cpp", "PI", 1);
+  const int kThreads = 4;
+  const int kIterations = 20000;
+  uint64_t counter = 0;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([this, site, &counter] {
+      for (int i = 0; i < kIterations; i++) {
+        Locker::ScopeLock lock(locker_, site);
+        counter++;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_THAT(counter, Eq(uint64_t(kThreads) * kIterations));
+  LockSite::Snapshot snapshot = GetSnapshot(site);
+  EXPECT_THAT(snapshot.acquisitions, Eq(uint64_t(kThreads) * kIterations));
+  EXPECT_THAT(snapshot.holds, Eq(snapshot.acquisitions));
+  EXPECT_THAT(snapshot.contended, Le(snapshot.acquisitions));
+}
+
+TEST_F(LockerTestCases, PriorityInheritanceSequence) {
+  ASSERT_THAT(locker_.EnablePriorityInheritance(), Eq(0));
+
+  // A sequence wait blocks on the condition with the PI mutex until the sequence exits.
+  {
+    SEQUENCE_ENTRY_SCOPE_LOCK(locker_);
+  }
+  std::atomic<bool> waited {false};
+  std::thread waiter([this, &waited] {
+    SEQUENCE_WAIT_SCOPE_LOCK(locker_);
+    EXPECT_FALSE(lock.IsError());
+    waited = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_FALSE(waited);
+  {
+    SEQUENCE_EXIT_SCOPE_LOCK(locker_);
+  }
+  waiter.join();
+  EXPECT_TRUE(waited);
+
+  // The timed wait gives the mutex back on timeout.
+  {
+    Locker::ScopeLock lock(locker_);
+    EXPECT_THAT(locker_.WaitFinite(5), Eq(ETIMEDOUT));
+    std::thread other([this] { EXPECT_THAT(locker_.TryLock(), Eq(EBUSY)); });
+    other.join();
+  }
+  EXPECT_THAT(locker_.TryLock(), Eq(0));
+  locker_.Unlock();
+}
+
+TEST_F(LockerTestCases, TimedScopeLockGivesUp) {
+  LockSite *holder_site = NewSite("locker_test.cpp", "Holder", 1);
+  LockSite *timed_site = NewSite("locker_test.cpp", "Timed", 2);
+  std::thread holder = HoldFromThread(&locker_, holder_site, 100);
+  {
+    Locker::TimedScopeLock lock(locker_, 5, timed_site);
+    EXPECT_FALSE(lock.IsLocked());
+  }
+  EXPECT_THAT(GetSnapshot(timed_site).acquisitions, Eq(0u));
+  EXPECT_THAT(locker_.TryLock(), Eq(EBUSY));
+  holder.join();
+
+  {
+    Locker::TimedScopeLock lock(locker_, 5, timed_site);
+    EXPECT_TRUE(lock.IsLocked());
+    std::thread other([this] { EXPECT_THAT(locker_.TryLock(), Eq(EBUSY)); });
+    other.join();
+  }
+  LockSite::Snapshot snapshot = GetSnapshot(timed_site);
+  EXPECT_THAT(snapshot.acquisitions, Eq(1u));
+  EXPECT_THAT(snapshot.holds, Eq(1u));
+  EXPECT_THAT(locker_.TryLock(), Eq(0));
+  locker_.Unlock();
+}
+
+// The dumpsys pattern against a composer thread committing frames under the display lock, with
+// every 8th commit stalled. A dump that starts during a stall returns before the stall ends.
+TEST_F(LockerTestCases, DumpNeverWaitsOutCommit) {
+  const int kStallMs = 100;
+  std::atomic<bool> stop {false};
+  std::atomic<uint64_t> frames {0};
+  std::atomic<uint64_t> stalled_frame {0};
+  uint64_t layers[2] = {};  // written under the lock, a dump under the lock sees them equal
+  std::thread committer([this, kStallMs, &stop, &frames, &stalled_frame, &layers] {
+    for (uint64_t frame = 1; !stop; frame++) {
+      {
+        SCOPE_LOCK(locker_);
+        layers[0] = frame;
+        if (frame % 8 == 0) {
+          stalled_frame = frame;
+          std::this_thread::sleep_for(std::chrono::milliseconds(kStallMs));
+          stalled_frame = 0;
+        } else {
+          std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+        layers[1] = frame;
+        frames = frame;
+      }
+      // Waiting for the next vsync.
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+
+  int dumped = 0;
+  int skipped = 0;
+  int during_stall = 0;
+  while (during_stall < 5 || dumped < 5) {
+    uint64_t stall = stalled_frame;
+    {
+      TIMED_SCOPE_LOCK(locker_, 5);
+      if (lock.IsLocked()) {
+        EXPECT_THAT(layers[0], Eq(layers[1]));
+        dumped++;
+      } else {
+        skipped++;
+      }
+    }
+    if (stall) {
+      EXPECT_THAT(stalled_frame.load(), Eq(stall));
+      during_stall++;
+      std::this_thread::sleep_for(std::chrono::milliseconds(kStallMs));
+    } else {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  stop = true;
+  committer.join();
+
+  EXPECT_THAT(skipped, Ge(during_stall));
+  printf("%" PRIu64 " frames, %d dumps, %d skipped\n", frames.load(), dumped, skipped);
+}
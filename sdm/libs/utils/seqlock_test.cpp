@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <utils/seqlock.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+using namespace testing;
+using sdm::SeqLock;
+
+namespace {
+
+// Every field carries the write count, so a torn copy shows up as fields that disagree.
+struct Snapshot {
+  uint64_t count;
+  uint32_t words[13];
+  uint8_t tail[3];
+};
+
+Snapshot MakeSnapshot(uint64_t count) {
+  Snapshot snapshot;
+  snapshot.count = count;
+  for (auto &word : snapshot.words) {
+    word = uint32_t(count);
+  }
+  for (auto &byte : snapshot.tail) {
+    byte = uint8_t(count);
+  }
+  return snapshot;
+}
+
+bool IsConsistent(const Snapshot &snapshot) {
+  for (auto word : snapshot.words) {
+    if (word != uint32_t(snapshot.count)) {
+      return false;
+    }
+  }
+  for (auto byte : snapshot.tail) {
+    if (byte != uint8_t(snapshot.count)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(SeqLockTestCases, ReadsTheLastWrite) {
+  SeqLock<Snapshot> lock;
+  Snapshot snapshot = MakeSnapshot(7);
+  EXPECT_THAT(lock.Read(&snapshot), Eq(2u));
+  EXPECT_THAT(snapshot.count, Eq(0u));
+  EXPECT_TRUE(IsConsistent(snapshot));
+
+  lock.Write(MakeSnapshot(1));
+  lock.Write(MakeSnapshot(2));
+  EXPECT_THAT(lock.Read(&snapshot), Eq(6u));
+  EXPECT_THAT(snapshot.count, Eq(2u));
+  EXPECT_TRUE(IsConsistent(snapshot));
+}
+
+TEST(SeqLockTestCases, ConcurrentReadsAreNeverTorn) {
+  const uint64_t kWrites = 200000;
+  SeqLock<Snapshot> lock;
+  std::atomic<bool> done(false);
+  std::atomic<uint64_t> torn(0);
+  std::atomic<uint64_t> reads(0);
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 3; i++) {
+    readers.emplace_back([&]() {
+      uint32_t last_seq = 0;
+      uint64_t last_count = 0;
+      while (!done.load()) {
+        Snapshot snapshot;
+        uint32_t seq = lock.Read(&snapshot);
+        // Sequence numbers are even, advance by two per write and never go back.
+        if (!IsConsistent(snapshot) || (seq & 1) || seq < last_seq ||
+            snapshot.count < last_count || snapshot.count != (seq - 2) / 2) {
+          torn++;
+        }
+        last_seq = seq;
+        last_count = snapshot.count;
+        reads++;
+      }
+    });
+  }
+
+  for (uint64_t count = 1; count <= kWrites; count++) {
+    lock.Write(MakeSnapshot(count));
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  Snapshot snapshot;
+  lock.Read(&snapshot);
+  EXPECT_THAT(snapshot.count, Eq(kWrites));
+  EXPECT_THAT(reads.load(), Gt(0u));
+  EXPECT_THAT(torn.load(), Eq(0u));
+}
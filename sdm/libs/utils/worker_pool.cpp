@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+#include <utils/worker_pool.h>
+
+#include <algorithm>
+#include <utility>
+
+#define __CLASS__ "WorkerPool"
+
+namespace sdm {
+
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::steady_clock;
+
+struct LaneConfig {
+  const char *name;
+  int priority;
+  size_t max_depth;
+};
+
+static const LaneConfig kLaneConfig[kLaneMax] = {
+  { "HWC_Hotplug", kThreadPriorityUrgent, 8 },
+  { "HWC_DispReset", kThreadPriorityUrgent, 4 },
+  { "HWC_Notify", 0, 32 },
+  { "HWC_VmIPC", 0, 16 },
+  { "HWC_FrameDump", 10, 4 },
+};
+
+WorkerPool *WorkerPool::GetInstance() {
+  // Never destroyed, lane threads may still be blocked on composer locks at process exit.
+  static WorkerPool *s_instance = new WorkerPool();
+  return s_instance;
+}
+
+WorkerPool::WorkerPool() {
+  for (int i = 0; i < kLaneMax; i++) {
+    lanes_[i].name = kLaneConfig[i].name;
+    lanes_[i].priority = kLaneConfig[i].priority;
+    lanes_[i].max_depth = kLaneConfig[i].max_depth;
+  }
+}
+
+int WorkerPool::Post(WorkerLane lane, Task task, uint64_t coalesce_key) {
+  if (lane < 0 || lane >= kLaneMax || !task) {
+    return -EINVAL;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  Lane &worker_lane = lanes_[lane];
+
+  if (coalesce_key != kNoCoalesce) {
+    for (auto &pending : worker_lane.queue) {
+      if (pending.coalesce_key == coalesce_key) {
+        worker_lane.stats.coalesced++;
+        return 0;
+      }
+    }
+  }
+
+  if (worker_lane.queue.size() >= worker_lane.max_depth) {
+    worker_lane.stats.rejected++;
+    DLOGW("%s queue full, dropping task", worker_lane.name);
+    return -EBUSY;
+  }
+
+  if (!worker_lane.worker.joinable()) {
+    worker_lane.worker = std::thread(&WorkerPool::WorkerThread, this, lane);
+  }
+
+  PendingTask pending;
+  pending.task = std::move(task);
+  pending.coalesce_key = coalesce_key;
+  pending.seq = worker_lane.next_seq++;
+  pending.posted = steady_clock::now();
+  worker_lane.queue.push_back(std::move(pending));
+  worker_lane.stats.posted++;
+  worker_lane.stats.max_depth = std::max(worker_lane.stats.max_depth, worker_lane.queue.size());
+  work_cv_.notify_all();
+
+  return 0;
+}
+
+void WorkerPool::Drain(WorkerLane lane) {
+  if (lane < 0 || lane >= kLaneMax) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  Lane &worker_lane = lanes_[lane];
+  if (worker_lane.worker.get_id() == std::this_thread::get_id()) {
+    DLOGW("Drain of %s from its own thread ignored", worker_lane.name);
+    return;
+  }
+
+  uint64_t target_seq = worker_lane.next_seq - 1;
+  done_cv_.wait(lock, [&worker_lane, target_seq] { return worker_lane.done_seq >= target_seq; });
+}
+
+void WorkerPool::WorkerThread(WorkerLane lane) {
+  Lane &worker_lane = lanes_[lane];
+  prctl(PR_SET_NAME, worker_lane.name, 0, 0, 0);
+  if (worker_lane.priority) {
+    setpriority(PRIO_PROCESS, 0, worker_lane.priority);
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    work_cv_.wait(lock, [&worker_lane] { return !worker_lane.queue.empty(); });
+
+    PendingTask pending = std::move(worker_lane.queue.front());
+    worker_lane.queue.pop_front();
+    auto start = steady_clock::now();
+    uint64_t wait_us = UINT64(duration_cast<microseconds>(start - pending.posted).count());
+
+    lock.unlock();
+    pending.task();
+    pending.task = nullptr;
+    auto run_us = UINT64(duration_cast<microseconds>(steady_clock::now() - start).count());
+    lock.lock();
+
+    LaneStats &stats = worker_lane.stats;
+    stats.completed++;
+    stats.total_wait_us += wait_us;
+    stats.max_wait_us = std::max(stats.max_wait_us, wait_us);
+    stats.max_run_us = std::max(stats.max_run_us, run_us);
+    worker_lane.done_seq = pending.seq;
+    done_cv_.notify_all();
+  }
+}
+
+void WorkerPool::Dump(std::ostringstream *os) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  *os << "\n------------Worker Pool---------------";
+  for (auto &worker_lane : lanes_) {
+    const LaneStats &stats = worker_lane.stats;
+    uint64_t avg_wait_us = stats.completed ? (stats.total_wait_us / stats.completed) : 0;
+    *os << "\n" << worker_lane.name << ": depth " << worker_lane.queue.size();
+    *os << " (max " << stats.max_depth << "/" << worker_lane.max_depth << ")";
+    *os << ", posted " << stats.posted << ", coalesced " << stats.coalesced;
+    *os << ", rejected " << stats.rejected << ", completed " << stats.completed;
+    *os << ", wait avg/max " << avg_wait_us << "/" << stats.max_wait_us << " us";
+    *os << ", run max " << stats.max_run_us << " us";
+  }
+  *os << "\n---------------------------------------\n";
+}
+
+}  // namespace sdm
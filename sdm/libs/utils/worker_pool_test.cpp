@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <utils/worker_pool.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+using namespace testing;
+using sdm::WorkerLane;
+using sdm::WorkerPool;
+
+namespace {
+
+// The pool is process wide, each test leaves its lanes drained.
+class WorkerPoolTestCases : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    Open();
+    for (WorkerLane lane : {sdm::kLaneNotify, sdm::kLaneDisplayReset}) {
+      pool_->Drain(lane);
+    }
+  }
+
+  // Keeps the lane thread busy until Open, so that later posts stay pending. Returns once the
+  // lane has started on it.
+  void Block(WorkerLane lane) {
+    std::atomic<bool> started {false};
+    open_ = false;
+    ASSERT_THAT(pool_->Post(lane, [this, &started] {
+      started = true;
+      while (!open_) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }), Eq(0));
+    while (!started) {
+      std::this_thread::yield();
+    }
+  }
+
+  void Open() { open_ = true; }
+
+  WorkerPool *pool_ = WorkerPool::GetInstance();
+  std::atomic<bool> open_ {true};
+};
+
+}  // namespace
+
+TEST_F(WorkerPoolTestCases, RunsInPostingOrder) {
+  std::mutex mutex;
+  std::vector<int> order;
+  Block(sdm::kLaneNotify);
+  for (int i = 0; i < 20; i++) {
+    ASSERT_THAT(pool_->Post(sdm::kLaneNotify, [&mutex, &order, i] {
+      std::lock_guard<std::mutex> lock(mutex);
+      order.push_back(i);
+    }), Eq(0));
+  }
+  Open();
+  pool_->Drain(sdm::kLaneNotify);
+
+  std::vector<int> expected;
+  for (int i = 0; i < 20; i++) {
+    expected.push_back(i);
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  EXPECT_THAT(order, ContainerEq(expected));
+}
+
+TEST_F(WorkerPoolTestCases, PendingKeyIsCoalesced) {
+  const uint64_t kKey = 31;
+  std::atomic<int> first {0};
+  std::atomic<int> second {0};
+  std::atomic<int> other {0};
+  Block(sdm::kLaneNotify);
+  EXPECT_THAT(pool_->Post(sdm::kLaneNotify, [&first] { first++; }, kKey), Eq(0));
+  EXPECT_THAT(pool_->Post(sdm::kLaneNotify, [&second] { second++; }, kKey), Eq(0));
+  EXPECT_THAT(pool_->Post(sdm::kLaneNotify, [&other] { other++; }, kKey + 1), Eq(0));
+  Open();
+  pool_->Drain(sdm::kLaneNotify);
+  EXPECT_THAT(first.load(), Eq(1));
+  EXPECT_THAT(second.load(), Eq(0));
+  EXPECT_THAT(other.load(), Eq(1));
+
+  // Once the first has run, the key is posted again.
+  EXPECT_THAT(pool_->Post(sdm::kLaneNotify, [&second] { second++; }, kKey), Eq(0));
+  pool_->Drain(sdm::kLaneNotify);
+  EXPECT_THAT(second.load(), Eq(1));
+}
+
+TEST_F(WorkerPoolTestCases, FullLaneRejects) {
+  // The display reset lane holds 4 pending tasks behind the running one.
+  std::atomic<int> runs {0};
+  Block(sdm::kLaneDisplayReset);
+  for (uint64_t key = 1; key <= 4; key++) {
+    ASSERT_THAT(pool_->Post(sdm::kLaneDisplayReset, [&runs] { runs++; }, key), Eq(0));
+  }
+  EXPECT_THAT(pool_->Post(sdm::kLaneDisplayReset, [&runs] { runs++; }), Eq(-EBUSY));
+  EXPECT_THAT(pool_->Post(sdm::kLaneDisplayReset, [&runs] { runs++; }, 5), Eq(-EBUSY));
+  // A duplicate of pending work is coalesced, not rejected.
+  EXPECT_THAT(pool_->Post(sdm::kLaneDisplayReset, [&runs] { runs++; }, 2), Eq(0));
+
+  Open();
+  pool_->Drain(sdm::kLaneDisplayReset);
+  EXPECT_THAT(runs.load(), Eq(4));
+  EXPECT_THAT(pool_->Post(sdm::kLaneDisplayReset, [&runs] { runs++; }), Eq(0));
+  pool_->Drain(sdm::kLaneDisplayReset);
+  EXPECT_THAT(runs.load(), Eq(5));
+}
+
+TEST_F(WorkerPoolTestCases, InvalidPostFails) {
+  EXPECT_THAT(pool_->Post(sdm::kLaneMax, [] {}), Eq(-EINVAL));
+  EXPECT_THAT(pool_->Post(sdm::kLaneNotify, nullptr), Eq(-EINVAL));
+}
+
+TEST_F(WorkerPoolTestCases, DrainWaitsForEarlierPosts) {
+  std::atomic<int> done {0};
+  for (int i = 0; i < 3; i++) {
+    ASSERT_THAT(pool_->Post(sdm::kLaneNotify, [&done] {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      done++;
+    }), Eq(0));
+  }
+  pool_->Drain(sdm::kLaneNotify);
+  EXPECT_THAT(done.load(), Eq(3));
+}
+
+TEST_F(WorkerPoolTestCases, DrainFromLaneReturns) {
+  std::atomic<bool> drained {false};
+  std::atomic<bool> later_ran {false};
+  Block(sdm::kLaneNotify);
+  ASSERT_THAT(pool_->Post(sdm::kLaneNotify, [this, &drained] {
+    // Waiting here for the task behind would never end.
+    pool_->Drain(sdm::kLaneNotify);
+    drained = true;
+  }), Eq(0));
+  ASSERT_THAT(pool_->Post(sdm::kLaneNotify, [&later_ran] { later_ran = true; }), Eq(0));
+  Open();
+  pool_->Drain(sdm::kLaneNotify);
+  EXPECT_TRUE(drained);
+  EXPECT_TRUE(later_ran);
+}
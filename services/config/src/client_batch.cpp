@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <display_config_batch.h>
+
+#include "client_impl.h"
+
+namespace DisplayConfig {
+
+void ClientBatch::Add(uint32_t op_code, const void *input, size_t input_size, void *output,
+                      size_t output_size, int *error) {
+  BatchEntry header = {op_code, 0, static_cast<uint32_t>(input_size), 0};
+  size_t offset = request_.size();
+  request_.resize(offset + sizeof(header) + BatchPayloadSize(header.size), 0);
+  memcpy(request_.data() + offset, &header, sizeof(header));
+  if (input_size) {
+    memcpy(request_.data() + offset + sizeof(header), input, input_size);
+  }
+
+  Entry entry;
+  entry.op_code = op_code;
+  entry.output = output;
+  entry.output_size = output_size;
+  entry.error = error;
+  entries_.push_back(entry);
+}
+
+void ClientBatch::Complete(const Entry &entry, int error, const uint8_t *output,
+                           size_t output_size) {
+  // Outputs are only taken when they have the size of the result the call expects.
+  if (!error && entry.output && output_size == entry.output_size) {
+    memcpy(entry.output, output, output_size);
+  } else if (!error && entry.output_size) {
+    error = -EINVAL;
+  }
+
+  if (entry.error) {
+    *entry.error = error;
+  }
+}
+
+void ClientBatch::IsDisplayConnected(DisplayType dpy, bool *connected, int *error) {
+  Add(kIsDisplayConnected, &dpy, sizeof(dpy), connected, sizeof(*connected), error);
+}
+
+void ClientBatch::GetConfigCount(DisplayType dpy, uint32_t *count, int *error) {
+  Add(kGetConfigCount, &dpy, sizeof(dpy), count, sizeof(*count), error);
+}
+
+void ClientBatch::GetActiveConfig(DisplayType dpy, uint32_t *config, int *error) {
+  Add(kGetActiveConfig, &dpy, sizeof(dpy), config, sizeof(*config), error);
+}
+
+void ClientBatch::SetActiveConfig(DisplayType dpy, uint32_t config, int *error) {
+  struct ConfigParams input = {dpy, config};
+  Add(kSetActiveConfig, &input, sizeof(input), nullptr, 0, error);
+}
+
+void ClientBatch::GetDisplayAttributes(uint32_t config_index, DisplayType dpy,
+                                       Attributes *attributes, int *error) {
+  struct AttributesParams input = {config_index, dpy};
+  Add(kGetDisplayAttributes, &input, sizeof(input), attributes, sizeof(*attributes), error);
+}
+
+void ClientBatch::SetPanelBrightness(uint32_t level, int *error) {
+  Add(kSetPanelBrightness, &level, sizeof(level), nullptr, 0, error);
+}
+
+void ClientBatch::GetPanelBrightness(uint32_t *level, int *error) {
+  Add(kGetPanelBrightness, nullptr, 0, level, sizeof(*level), error);
+}
+
+void ClientBatch::IsHDRSupported(uint32_t disp_id, bool *supported, int *error) {
+  Add(kIsHdrSupported, &disp_id, sizeof(disp_id), supported, sizeof(*supported), error);
+}
+
+void ClientBatch::IsBuiltInDisplay(uint32_t disp_id, bool *is_builtin, int *error) {
+  Add(kIsBuiltinDisplay, &disp_id, sizeof(disp_id), is_builtin, sizeof(*is_builtin), error);
+}
+
+void ClientBatch::SetIdleTimeout(uint32_t value, int *error) {
+  Add(kSetIdleTimeout, &value, sizeof(value), nullptr, 0, error);
+}
+
+int ClientBatch::Execute() {
+  if (entries_.empty()) {
+    return 0;
+  }
+
+  ClientImpl *impl = static_cast<ClientImpl *>(intf_);
+  int error = 0;
+  ByteStream output_params;
+  if (!impl || !impl->display_config_ || entries_.size() > kMaxBatchEntries) {
+    error = -EINVAL;
+  } else {
+    ByteStream input_params;
+    input_params.setToExternal(request_.data(), request_.size());
+    auto hidl_cb = [&error, &output_params] (int32_t err, ByteStream params,
+                                             HandleStream handles) {
+      error = err;
+      output_params = params;
+    };
+    impl->display_config_->perform(impl->client_handle_, kBatch, input_params, {}, hidl_cb);
+  }
+
+  // The reply has one result per queued call, in order.
+  const uint8_t *data = output_params.data();
+  size_t size = output_params.size();
+  size_t offset = 0;
+  size_t index = 0;
+  while (!error && index < entries_.size()) {
+    BatchEntry result = {};
+    if ((size - offset) < sizeof(result)) {
+      error = -EINVAL;
+      break;
+    }
+    memcpy(&result, data + offset, sizeof(result));
+    offset += sizeof(result);
+
+    uint32_t payload_size = BatchPayloadSize(result.size);
+    if (result.op_code != entries_[index].op_code || result.size > payload_size ||
+        (size - offset) < payload_size) {
+      error = -EINVAL;
+      break;
+    }
+    Complete(entries_[index], result.error, data + offset, result.size);
+    offset += payload_size;
+    index++;
+  }
+
+  for (; index < entries_.size(); index++) {
+    Complete(entries_[index], error, nullptr, 0);
+  }
+  Clear();
+
+  return error;
+}
+
+void ClientBatch::Clear() {
+  request_.clear();
+  entries_.clear();
+}
+
+}  // namespace DisplayConfig
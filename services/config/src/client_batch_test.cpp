@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <display_config_batch.h>
+#include <display_config_status.h>
+
+#include <chrono>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+using namespace testing;
+using namespace DisplayConfig;
+
+namespace {
+
+const DisplayType kDisplay = DisplayType::kPrimary;
+const auto kRunTime = std::chrono::milliseconds(500);
+
+// The getters brightness, refresh rate and idle status pollers run.
+struct PolledValues {
+  uint32_t active_config = 0;
+  uint32_t config_count = 0;
+  uint32_t brightness_level = 0;
+  bool connected = false;
+};
+
+const uint32_t kPolledCalls = 4;
+
+int PollSingleCalls(ClientInterface *intf, PolledValues *values) {
+  int error = intf->GetActiveConfig(kDisplay, &values->active_config);
+  error = error ? error : intf->GetConfigCount(kDisplay, &values->config_count);
+  error = error ? error : intf->GetPanelBrightness(&values->brightness_level);
+  return error ? error : intf->IsDisplayConnected(kDisplay, &values->connected);
+}
+
+int PollBatch(ClientBatch *batch, PolledValues *values) {
+  int errors[kPolledCalls] = {};
+  batch->GetActiveConfig(kDisplay, &values->active_config, &errors[0]);
+  batch->GetConfigCount(kDisplay, &values->config_count, &errors[1]);
+  batch->GetPanelBrightness(&values->brightness_level, &errors[2]);
+  batch->IsDisplayConnected(kDisplay, &values->connected, &errors[3]);
+  int error = batch->Execute();
+  for (uint32_t i = 0; !error && i < kPolledCalls; i++) {
+    error = errors[i];
+  }
+  return error;
+}
+
+// Runs poll for kRunTime and returns the display config calls it made per second, each run of
+// poll counting as calls_per_run calls. Returns 0 if a run failed.
+template <class Poll>
+double GetCallsPerSecond(uint32_t calls_per_run, Poll poll) {
+  auto start = std::chrono::steady_clock::now();
+  auto end = start + kRunTime;
+  uint64_t runs = 0;
+  auto now = start;
+  do {
+    if (poll()) {
+      return 0;
+    }
+    runs++;
+    now = std::chrono::steady_clock::now();
+  } while (now < end);
+
+  std::chrono::duration<double> elapsed = now - start;
+  return double(runs * calls_per_run) / elapsed.count();
+}
+
+// Runs against the Display Config service of the device, the tests are skipped without it.
+class ClientBatchTestCases : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    if (ClientInterface::Create("client_batch_test", nullptr, &intf_)) {
+      intf_ = nullptr;
+      GTEST_SKIP() << "Display Config service is not running";
+    }
+  }
+
+  void TearDown() override { ClientInterface::Destroy(intf_); }
+
+  ClientInterface *intf_ = nullptr;
+};
+
+}  // namespace
+
+TEST(ClientBatchNoServiceTestCases, ExecuteFailsEveryCall) {
+  ClientBatch batch(nullptr);
+  EXPECT_THAT(batch.Execute(), Eq(0));
+
+  uint32_t level = 0;
+  int errors[2] = {1, 1};
+  batch.GetPanelBrightness(&level, &errors[0]);
+  batch.SetIdleTimeout(500, &errors[1]);
+  EXPECT_THAT(batch.Size(), Eq(2u));
+  EXPECT_THAT(batch.Execute(), Eq(-EINVAL));
+  EXPECT_THAT(errors[0], Eq(-EINVAL));
+  EXPECT_THAT(errors[1], Eq(-EINVAL));
+  EXPECT_THAT(batch.Size(), Eq(0u));
+}
+
+TEST_F(ClientBatchTestCases, BatchMatchesSingleCalls) {
+  PolledValues single;
+  ASSERT_THAT(PollSingleCalls(intf_, &single), Eq(0));
+
+  ClientBatch batch(intf_);
+  PolledValues batched;
+  ASSERT_THAT(PollBatch(&batch, &batched), Eq(0));
+  EXPECT_THAT(batched.active_config, Eq(single.active_config));
+  EXPECT_THAT(batched.config_count, Eq(single.config_count));
+  EXPECT_THAT(batched.brightness_level, Eq(single.brightness_level));
+  EXPECT_THAT(batched.connected, Eq(single.connected));
+}
+
+TEST_F(ClientBatchTestCases, StatusPageMatchesSingleCalls) {
+  DisplayStatusReader reader;
+  ASSERT_THAT(reader.Init(intf_), Eq(0));
+  DisplayStatus status;
+  if (reader.Read(kDisplay, &status) == -ENODATA) {
+    GTEST_SKIP() << "Nothing published for the display yet";
+  }
+
+  PolledValues single;
+  ASSERT_THAT(PollSingleCalls(intf_, &single), Eq(0));
+  if (status.fields & kStatusActiveConfig) {
+    EXPECT_THAT(status.active_config, Eq(single.active_config));
+  }
+}
+
+// Calls per second of the polled getters as one perform() each, as one batch and as reads of the
+// status page.
+TEST_F(ClientBatchTestCases, CallsPerSecond) {
+  PolledValues values;
+  double single = GetCallsPerSecond(kPolledCalls, [&] {
+    return PollSingleCalls(intf_, &values);
+  });
+
+  ClientBatch batch(intf_);
+  double batched = GetCallsPerSecond(kPolledCalls, [&] {
+    return PollBatch(&batch, &values);
+  });
+
+  DisplayStatusReader reader;
+  ASSERT_THAT(reader.Init(intf_), Eq(0));
+  DisplayStatus status;
+  // One read gets all of the published values of the display.
+  double status_page = GetCallsPerSecond(1, [&] {
+    int error = reader.Read(kDisplay, &status);
+    return (error == -ENODATA) ? 0 : error;
+  });
+
+  printf("single calls: %.0f calls/s\n", single);
+  printf("batched calls: %.0f calls/s\n", batched);
+  printf("status page reads: %.0f calls/s\n", status_page);
+  ASSERT_THAT(single, Gt(0.0));
+  EXPECT_THAT(batched, Gt(single));
+  EXPECT_THAT(status_page, Gt(batched));
+}
@@ -35,7 +35,12 @@
 namespace DisplayConfig {
 
 int ClientImpl::Init(std::string client_name, ConfigCallback *callback) {
-  display_config_ = IDisplayConfig::getService();
+  return Init(IDisplayConfig::getService(), client_name, callback);
+}
+
+int ClientImpl::Init(android::sp<IDisplayConfig> display_config, std::string client_name,
+                     ConfigCallback *callback) {
+  display_config_ = display_config;
   // Unable to find Display Config 2.0 service. Fail Init.
   if (!display_config_) {
     return -1;
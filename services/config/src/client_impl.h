@@ -68,9 +68,16 @@ class ClientCallback: public IDisplayConfigCallback {
   ConfigCallback *callback_ = nullptr;
 };
 
+class ClientBatch;
+class DisplayStatusReader;
+class CwbStreamClient;
+
 class ClientImpl : public ClientInterface {
  public:
   int Init(std::string client_name, ConfigCallback *callback);
+  // As above, registering with the given service instead of the one from the service manager.
+  int Init(android::sp<IDisplayConfig> display_config, std::string client_name,
+           ConfigCallback *callback);
   void DeInit();
 
   virtual int IsDisplayConnected(DisplayType dpy, bool *connected);
@@ -130,6 +137,10 @@ class ClientImpl : public ClientInterface {
   virtual int DummyDisplayConfigAPI();
 
  private:
+  friend class ClientBatch;
+  friend class DisplayStatusReader;
+  friend class CwbStreamClient;
+
   android::sp<IDisplayConfig> display_config_ = nullptr;
   uint64_t client_handle_ = 0;
 };
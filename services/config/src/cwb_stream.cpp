@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <new>
+
+#include "client_impl.h"
+#include "cwb_stream.h"
+#include "shared_page.h"
+
+namespace DisplayConfig {
+
+static std::atomic<CwbStreamHandler *> s_handler {nullptr};
+
+// The page is shared between processes, so the futex calls must not be process private.
+static void FutexWake(std::atomic<uint32_t> *word) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+static int FutexWait(std::atomic<uint32_t> *word, uint32_t value, const struct timespec *timeout) {
+  if (syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT, value, timeout, nullptr,
+              0) < 0) {
+    return -errno;
+  }
+
+  return 0;
+}
+
+static int64_t GetMonotonicNs() {
+  struct timespec ts = {};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (static_cast<int64_t>(ts.tv_sec) * 1000000000LL) + ts.tv_nsec;
+}
+
+void SetCwbStreamHandler(CwbStreamHandler *handler) {
+  s_handler.store(handler, std::memory_order_release);
+}
+
+void PublishCwbStreamFrame(CwbStreamPage *page, uint32_t frame, int32_t status,
+                           int64_t timestamp_ns) {
+  CwbStreamSlot &slot = page->slots[frame % page->num_buffers];
+  slot.frame.store(frame, std::memory_order_relaxed);
+  slot.status.store(status, std::memory_order_relaxed);
+  slot.timestamp_ns.store(timestamp_ns, std::memory_order_relaxed);
+  page->filled.store(frame + 1, std::memory_order_release);
+  FutexWake(&page->filled);
+}
+
+int CreateCwbStream(const CwbStreamConfig &config,
+                    const std::vector<const native_handle_t *> &buffers,
+                    CwbStreamInstance *stream) {
+  CwbStreamHandler *handler = s_handler.load(std::memory_order_acquire);
+  if (!handler) {
+    return -ENOTSUP;
+  }
+
+  if (!config.num_buffers || config.num_buffers > kMaxCwbStreamBuffers ||
+      config.num_buffers != buffers.size()) {
+    return -EINVAL;
+  }
+
+  // Downscaling is done by the CPU post-processing, which native streams skip.
+  bool native = (config.format == kCwbStreamNative);
+  bool valid_format = native || (config.format == kCwbStreamRGBA8888) ||
+                      (config.format == kCwbStreamNV12);
+  bool valid_downscale = (config.downscale == 1) ||
+                         (!native && ((config.downscale == 2) ||
+                                      (config.downscale == kMaxCwbStreamDownscale)));
+  if (!valid_format || !valid_downscale) {
+    return -EINVAL;
+  }
+
+  void *addr = nullptr;
+  int fd = -1;
+  int error = CreateSharedPage("display_config_cwb_stream", sizeof(CwbStreamPage), false, &fd,
+                               &addr);
+  if (error) {
+    return error;
+  }
+
+  CwbStreamPage *page = new (addr) CwbStreamPage();
+  page->num_buffers = config.num_buffers;
+
+  uint32_t id = 0;
+  error = handler->StartCwbStream(config, buffers, page, &id);
+  if (error) {
+    munmap(addr, sizeof(CwbStreamPage));
+    close(fd);
+    return error;
+  }
+
+  stream->id = id;
+  stream->fd = fd;
+  stream->page = page;
+
+  return 0;
+}
+
+void DestroyCwbStream(CwbStreamInstance *stream) {
+  if (!stream->page) {
+    return;
+  }
+
+  CwbStreamHandler *handler = s_handler.load(std::memory_order_acquire);
+  if (handler) {
+    handler->StopCwbStream(stream->id);
+  }
+
+  // Wakes up a client still waiting for a buffer.
+  stream->page->stopped.store(1, std::memory_order_release);
+  FutexWake(&stream->page->filled);
+
+  munmap(stream->page, sizeof(CwbStreamPage));
+  close(stream->fd);
+  *stream = {};
+}
+
+int CwbStreamClient::Start(ClientInterface *intf, const CwbStreamConfig &config,
+                           const std::vector<const native_handle_t *> &buffers) {
+  if (!intf || page_) {
+    return -EINVAL;
+  }
+
+  ClientImpl *impl = static_cast<ClientImpl *>(intf);
+  if (!impl->display_config_) {
+    return -ENODEV;
+  }
+
+  std::vector<hidl_handle> handles;
+  for (auto buffer : buffers) {
+    handles.push_back(buffer);
+  }
+
+  CwbStreamConfig input = config;
+  ByteStream input_params;
+  input_params.setToExternal(reinterpret_cast<uint8_t*>(&input), sizeof(input));
+  HandleStream input_handles = handles;
+
+  int error = 0;
+  int fd = -1;
+  uint32_t output[2] = {};  // stream id, page size
+  auto hidl_cb = [&error, &fd, &output] (int32_t err, ByteStream params,
+                                         HandleStream handles) {
+    error = err;
+    if (params.size() == sizeof(output)) {
+      memcpy(output, params.data(), sizeof(output));
+    }
+    const native_handle_t *handle = handles.size() ? handles[0].getNativeHandle() : nullptr;
+    if (!error && handle && handle->numFds == 1) {
+      // The handle is released once the callback returns.
+      fd = fcntl(handle->data[0], F_DUPFD_CLOEXEC, 0);
+    }
+  };
+
+  impl->display_config_->perform(impl->client_handle_, kStartCwbStream, input_params,
+                                 input_handles, hidl_cb);
+  if (error) {
+    return error;
+  }
+
+  void *addr = nullptr;
+  if (fd >= 0 && output[1] == sizeof(CwbStreamPage)) {
+    addr = MapSharedPage(fd, sizeof(CwbStreamPage), true);
+  }
+  if (fd >= 0) {
+    close(fd);
+  }
+
+  intf_ = intf;
+  stream_id_ = output[0];
+  page_ = static_cast<CwbStreamPage *>(addr);
+  if (!page_ || page_->magic != kCwbStreamPageMagic || page_->version != kCwbStreamPageVersion ||
+      page_->num_buffers != config.num_buffers) {
+    ALOGW("Failed to map stream page of stream %u", stream_id_);
+    Stop();
+    return -EINVAL;
+  }
+  acquired_ = 0;
+
+  return 0;
+}
+
+void CwbStreamClient::Stop() {
+  if (!intf_) {
+    return;
+  }
+
+  ClientImpl *impl = static_cast<ClientImpl *>(intf_);
+  if (impl->display_config_) {
+    ByteStream input_params;
+    input_params.setToExternal(reinterpret_cast<uint8_t*>(&stream_id_), sizeof(stream_id_));
+    auto hidl_cb = [] (int32_t err, ByteStream params, HandleStream handles) {};
+    impl->display_config_->perform(impl->client_handle_, kStopCwbStream, input_params, {},
+                                   hidl_cb);
+  }
+
+  if (page_) {
+    munmap(page_, sizeof(CwbStreamPage));
+  }
+  intf_ = nullptr;
+  page_ = nullptr;
+  stream_id_ = 0;
+  acquired_ = 0;
+}
+
+int CwbStreamClient::Acquire(int timeout_ms, CwbStreamFrame *frame) {
+  if (!page_ || !frame) {
+    return -EINVAL;
+  }
+
+  int64_t deadline_ns = GetMonotonicNs() + (static_cast<int64_t>(timeout_ms) * 1000000LL);
+  uint32_t filled = page_->filled.load(std::memory_order_acquire);
+  while (filled == acquired_) {
+    if (page_->stopped.load(std::memory_order_acquire)) {
+      return -EPIPE;
+    }
+
+    struct timespec timeout = {};
+    if (timeout_ms >= 0) {
+      int64_t remaining_ns = deadline_ns - GetMonotonicNs();
+      if (remaining_ns <= 0) {
+        return -ETIMEDOUT;
+      }
+      timeout.tv_sec = remaining_ns / 1000000000LL;
+      timeout.tv_nsec = remaining_ns % 1000000000LL;
+    }
+
+    int error = FutexWait(&page_->filled, filled, (timeout_ms >= 0) ? &timeout : nullptr);
+    if (error == -ETIMEDOUT) {
+      return error;
+    }
+    filled = page_->filled.load(std::memory_order_acquire);
+  }
+
+  const CwbStreamSlot &slot = page_->slots[acquired_ % page_->num_buffers];
+  frame->index = acquired_ % page_->num_buffers;
+  frame->frame = slot.frame.load(std::memory_order_relaxed);
+  frame->status = slot.status.load(std::memory_order_relaxed);
+  frame->timestamp_ns = slot.timestamp_ns.load(std::memory_order_relaxed);
+  acquired_++;
+
+  return 0;
+}
+
+int CwbStreamClient::Release() {
+  if (!page_) {
+    return -EINVAL;
+  }
+
+  if (page_->released.load(std::memory_order_relaxed) == acquired_) {
+    return -EINVAL;
+  }
+  page_->released.fetch_add(1, std::memory_order_release);
+
+  return 0;
+}
+
+uint32_t CwbStreamClient::GetDroppedFrames() const {
+  return page_ ? page_->dropped.load(std::memory_order_relaxed) : 0;
+}
+
+}  // namespace DisplayConfig
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __CWB_STREAM_H__
+#define __CWB_STREAM_H__
+
+#include <display_config_cwb_stream.h>
+#include <vector>
+
+namespace DisplayConfig {
+
+// A stream started on behalf of a client, along with the shared page the service owns for it.
+struct CwbStreamInstance {
+  uint32_t id = 0;
+  int fd = -1;
+  CwbStreamPage *page = nullptr;
+};
+
+int CreateCwbStream(const CwbStreamConfig &config,
+                    const std::vector<const native_handle_t *> &buffers,
+                    CwbStreamInstance *stream);
+void DestroyCwbStream(CwbStreamInstance *stream);
+
+}  // namespace DisplayConfig
+
+#endif  // __CWB_STREAM_H__
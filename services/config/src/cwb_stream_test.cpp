@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "client_impl.h"
+#include "cwb_stream.h"
+using namespace testing;
+using namespace DisplayConfig;
+using ::android::hardware::hidl_string;
+
+namespace {
+
+// A writeback path in place of the composer. Every present it completes the buffer armed on the
+// previous one and arms the next free buffer of the ring, as HWCSession::CWB does.
+class StubWriteback : public CwbStreamHandler {
+ public:
+  explicit StubWriteback(std::chrono::microseconds present_period)
+    : present_period_(present_period) {}
+
+  int StartCwbStream(const CwbStreamConfig &config,
+                     const std::vector<const native_handle_t *> &buffers, CwbStreamPage *page,
+                     uint32_t *stream_id) override {
+    if (page_) {
+      return -EBUSY;
+    }
+    page_ = page;
+    num_buffers_ = config.num_buffers;
+    armed_ = 0;
+    pending_ = false;
+    presents_ = 0;
+    exit_ = false;
+    thread_ = std::thread([this] { Present(); });
+    *stream_id = 1;
+    return 0;
+  }
+
+  int StopCwbStream(uint32_t stream_id) override {
+    if (!page_ || stream_id != 1) {
+      return -EINVAL;
+    }
+    exit_ = true;
+    thread_.join();
+    page_ = nullptr;
+    return 0;
+  }
+
+  uint32_t GetArmed() const { return armed_; }
+  uint32_t GetPresents() const { return presents_; }
+
+ private:
+  void Present() {
+    auto next_present = std::chrono::steady_clock::now();
+    while (!exit_) {
+      if (pending_) {
+        int64_t timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        PublishCwbStreamFrame(page_, armed_ - 1, 0, timestamp_ns);
+        pending_ = false;
+      }
+
+      uint32_t released = page_->released.load(std::memory_order_acquire);
+      if ((armed_ - released) >= num_buffers_) {
+        page_->dropped.fetch_add(1, std::memory_order_relaxed);
+      } else {
+        armed_++;
+        pending_ = true;
+      }
+      presents_++;
+
+      next_present += present_period_;
+      std::this_thread::sleep_until(next_present);
+    }
+  }
+
+  std::chrono::microseconds present_period_;
+  CwbStreamPage *page_ = nullptr;
+  uint32_t num_buffers_ = 0;
+  std::atomic<uint32_t> armed_ {0};
+  bool pending_ = false;
+  std::atomic<uint32_t> presents_ {0};
+  std::atomic<bool> exit_ {false};
+  std::thread thread_;
+};
+
+// The part of the Display Config service that manages the streams of a client, as in DeviceImpl.
+class StubService : public IDisplayConfig {
+ public:
+  ::android::hardware::Return<void> registerClient(
+      const hidl_string &client_name, const android::sp<IDisplayConfigCallback> &callback,
+      registerClient_cb _hidl_cb) override {
+    _hidl_cb(0, 1);
+    return Void();
+  }
+
+  ::android::hardware::Return<void> perform(uint64_t client_handle, uint32_t op_code,
+                                            const ByteStream &input_params,
+                                            const HandleStream &input_handles,
+                                            perform_cb _hidl_cb) override {
+    switch (op_code) {
+      case kStartCwbStream:
+        StartStream(input_params, input_handles, _hidl_cb);
+        break;
+      case kStopCwbStream:
+        _hidl_cb(StopStreams(), {}, {});
+        break;
+      case kDestroy:
+        StopStreams();
+        _hidl_cb(0, {}, {});
+        break;
+      default:
+        _hidl_cb(-EINVAL, {}, {});
+        break;
+    }
+    return Void();
+  }
+
+  // As on the death of the client.
+  int StopStreams() {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (streams_.empty()) {
+      return -EINVAL;
+    }
+    for (auto &stream : streams_) {
+      DestroyCwbStream(&stream);
+    }
+    streams_.clear();
+    return 0;
+  }
+
+ private:
+  void StartStream(const ByteStream &input_params, const HandleStream &input_handles,
+                   perform_cb _hidl_cb) {
+    CwbStreamConfig config;
+    memcpy(&config, input_params.data(), sizeof(config));
+    std::vector<const native_handle_t *> buffers;
+    for (size_t i = 0; i < input_handles.size(); i++) {
+      buffers.push_back(input_handles[i].getNativeHandle());
+    }
+
+    CwbStreamInstance stream;
+    int error = CreateCwbStream(config, buffers, &stream);
+    if (error) {
+      _hidl_cb(error, {}, {});
+      return;
+    }
+
+    native_handle_t *handle = native_handle_create(1, 0);
+    handle->data[0] = fcntl(stream.fd, F_DUPFD_CLOEXEC, 0);
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      streams_.push_back(stream);
+    }
+
+    uint32_t output[2] = {stream.id, static_cast<uint32_t>(sizeof(CwbStreamPage))};
+    ByteStream output_params;
+    output_params.setToExternal(reinterpret_cast<uint8_t *>(output), sizeof(output));
+    std::vector<hidl_handle> handles;
+    handles.push_back(handle);
+    HandleStream output_handles = handles;
+    _hidl_cb(0, output_params, output_handles);
+
+    native_handle_close(handle);
+    native_handle_delete(handle);
+  }
+
+  std::mutex lock_;
+  std::vector<CwbStreamInstance> streams_;
+};
+
+class CwbStreamTestCases : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    service_ = new StubService();
+    ASSERT_THAT(client_.Init(service_, "cwb_stream_test", nullptr), Eq(0));
+    for (uint32_t i = 0; i < kMaxCwbStreamBuffers; i++) {
+      buffers_.push_back(native_handle_create(0, 0));
+    }
+  }
+
+  void TearDown() override {
+    stream_.Stop();
+    SetCwbStreamHandler(nullptr);
+    client_.DeInit();
+    for (auto buffer : buffers_) {
+      native_handle_delete(const_cast<native_handle_t *>(buffer));
+    }
+  }
+
+  // Installs a stub writeback presenting every present_period.
+  StubWriteback *InstallWriteback(std::chrono::microseconds present_period) {
+    writeback_.reset(new StubWriteback(present_period));
+    SetCwbStreamHandler(writeback_.get());
+    return writeback_.get();
+  }
+
+  int Start(uint32_t num_buffers) {
+    CwbStreamConfig config;
+    config.num_buffers = num_buffers;
+    std::vector<const native_handle_t *> buffers(buffers_.begin(),
+                                                 buffers_.begin() + num_buffers);
+    return stream_.Start(&client_, config, buffers);
+  }
+
+  android::sp<StubService> service_;
+  ClientImpl client_;
+  std::vector<const native_handle_t *> buffers_;
+  std::unique_ptr<StubWriteback> writeback_;
+  CwbStreamClient stream_;
+};
+
+const auto kFastPresent = std::chrono::microseconds(0);
+const auto kPresent120Hz = std::chrono::microseconds(8333);
+
+}  // namespace
+
+TEST_F(CwbStreamTestCases, StartNeedsHandlerAndValidRing) {
+  EXPECT_THAT(Start(3), Eq(-ENOTSUP));
+
+  InstallWriteback(kPresent120Hz);
+  EXPECT_THAT(Start(0), Eq(-EINVAL));
+  std::vector<const native_handle_t *> too_many(kMaxCwbStreamBuffers + 1, buffers_[0]);
+  CwbStreamConfig config;
+  config.num_buffers = kMaxCwbStreamBuffers + 1;
+  EXPECT_THAT(stream_.Start(&client_, config, too_many), Eq(-EINVAL));
+  config.num_buffers = 2;
+  config.downscale = 2;
+  EXPECT_THAT(stream_.Start(&client_, config, {buffers_[0], buffers_[1]}), Eq(-EINVAL));
+
+  EXPECT_THAT(Start(3), Eq(0));
+  EXPECT_THAT(Start(3), Eq(-EINVAL));
+}
+
+TEST_F(CwbStreamTestCases, BuffersCompleteInRingOrder) {
+  InstallWriteback(std::chrono::microseconds(500));
+  ASSERT_THAT(Start(3), Eq(0));
+
+  int64_t last_timestamp_ns = 0;
+  for (uint32_t i = 0; i < 20; i++) {
+    CwbStreamFrame frame;
+    ASSERT_THAT(stream_.Acquire(1000, &frame), Eq(0));
+    EXPECT_THAT(frame.frame, Eq(i));
+    EXPECT_THAT(frame.index, Eq(i % 3));
+    EXPECT_THAT(frame.status, Eq(0));
+    EXPECT_THAT(frame.timestamp_ns, Gt(last_timestamp_ns));
+    last_timestamp_ns = frame.timestamp_ns;
+    EXPECT_THAT(stream_.Release(), Eq(0));
+  }
+  EXPECT_THAT(stream_.Release(), Eq(-EINVAL));
+}
+
+TEST_F(CwbStreamTestCases, HeldBuffersAreNotOverwritten) {
+  StubWriteback *writeback = InstallWriteback(std::chrono::microseconds(500));
+  ASSERT_THAT(Start(3), Eq(0));
+
+  CwbStreamFrame frames[3];
+  for (auto &frame : frames) {
+    ASSERT_THAT(stream_.Acquire(1000, &frame), Eq(0));
+  }
+  CwbStreamFrame frame;
+  EXPECT_THAT(stream_.Acquire(50, &frame), Eq(-ETIMEDOUT));
+  EXPECT_THAT(writeback->GetArmed(), Eq(3u));
+  EXPECT_THAT(stream_.GetDroppedFrames(), Gt(0u));
+
+  // Releasing one buffer lets the composer fill it again.
+  EXPECT_THAT(stream_.Release(), Eq(0));
+  ASSERT_THAT(stream_.Acquire(1000, &frame), Eq(0));
+  EXPECT_THAT(frame.frame, Eq(3u));
+  EXPECT_THAT(frame.index, Eq(0u));
+}
+
+TEST_F(CwbStreamTestCases, ServiceStopWakesWaitingClient) {
+  InstallWriteback(kPresent120Hz);
+  ASSERT_THAT(Start(2), Eq(0));
+  CwbStreamFrame frames[2];
+  for (auto &frame : frames) {
+    ASSERT_THAT(stream_.Acquire(1000, &frame), Eq(0));
+  }
+
+  std::atomic<int> error {0};
+  std::thread waiter([this, &error] {
+    CwbStreamFrame frame;
+    error = stream_.Acquire(-1, &frame);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_THAT(error.load(), Eq(0));
+  EXPECT_THAT(service_->StopStreams(), Eq(0));
+  waiter.join();
+  EXPECT_THAT(error.load(), Eq(-EPIPE));
+}
+
+// A client that keeps up with 120 Hz presents gets every frame.
+TEST_F(CwbStreamTestCases, ClientKeepingUpDropsNothing) {
+  InstallWriteback(kPresent120Hz);
+  ASSERT_THAT(Start(3), Eq(0));
+  for (uint32_t i = 0; i < 60; i++) {
+    CwbStreamFrame frame;
+    ASSERT_THAT(stream_.Acquire(1000, &frame), Eq(0));
+    EXPECT_THAT(frame.frame, Eq(i));
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    ASSERT_THAT(stream_.Release(), Eq(0));
+  }
+  EXPECT_THAT(stream_.GetDroppedFrames(), Eq(0u));
+}
+
+// Presents as fast as the stub writeback runs, for the overhead of the ring itself: no request,
+// handle or task per buffer, only the page counters and a futex wake.
+TEST_F(CwbStreamTestCases, Throughput) {
+  const uint32_t kBuffers = 100000;
+  StubWriteback *writeback = InstallWriteback(kFastPresent);
+  ASSERT_THAT(Start(3), Eq(0));
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < kBuffers; i++) {
+    CwbStreamFrame frame;
+    ASSERT_THAT(stream_.Acquire(1000, &frame), Eq(0));
+    ASSERT_THAT(frame.frame, Eq(i));
+    ASSERT_THAT(stream_.Release(), Eq(0));
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  double buffers_per_second = kBuffers / elapsed.count();
+  printf("%u buffers in %.3f s, %.0f buffers/s, %u of %u presents dropped\n", kBuffers,
+         elapsed.count(), buffers_per_second, stream_.GetDroppedFrames(),
+         writeback->GetPresents());
+}
@@ -63,10 +63,14 @@
 * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
 #include <string>
 #include <vector>
 
 #include "device_impl.h"
+#include "status_page.h"
 
 namespace DisplayConfig {
 
@@ -162,6 +166,13 @@ void DeviceImpl::serviceDied(uint64_t client_handle,
 DeviceImpl::DeviceClientContext::DeviceClientContext(
             const sp<IDisplayConfigCallback> callback) : callback_(callback) { }
 
+DeviceImpl::DeviceClientContext::~DeviceClientContext() {
+  std::lock_guard<std::mutex> lock(stream_lock_);
+  for (auto &stream : streams_) {
+    DestroyCwbStream(&stream);
+  }
+}
+
 sp<IDisplayConfigCallback> DeviceImpl::DeviceClientContext::GetDeviceConfigCallback() {
   return callback_;
 }
@@ -896,6 +907,92 @@ void DeviceImpl::DeviceClientContext::ParseAllowIdleFallback(perform_cb _hidl_cb
   _hidl_cb(error, {}, {});
 }
 
+void DeviceImpl::DeviceClientContext::ParseStartCwbStream(const ByteStream &input_params,
+                                                          const HandleStream &input_handles,
+                                                          perform_cb _hidl_cb) {
+  CwbStreamConfig config;
+  if (input_params.size() != sizeof(config)) {
+    _hidl_cb(-EINVAL, {}, {});
+    return;
+  }
+  memcpy(&config, input_params.data(), sizeof(config));
+
+  std::vector<const native_handle_t *> buffers;
+  for (size_t i = 0; i < input_handles.size(); i++) {
+    if (!input_handles[i].getNativeHandle()) {
+      _hidl_cb(-EINVAL, {}, {});
+      return;
+    }
+    buffers.push_back(input_handles[i].getNativeHandle());
+  }
+
+  CwbStreamInstance stream;
+  int32_t error = CreateCwbStream(config, buffers, &stream);
+  if (error) {
+    _hidl_cb(error, {}, {});
+    return;
+  }
+
+  int fd = fcntl(stream.fd, F_DUPFD_CLOEXEC, 0);
+  native_handle_t *handle = (fd >= 0) ? native_handle_create(1, 0) : nullptr;
+  if (!handle) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    DestroyCwbStream(&stream);
+    _hidl_cb(-ENOMEM, {}, {});
+    return;
+  }
+  handle->data[0] = fd;
+
+  {
+    std::lock_guard<std::mutex> lock(stream_lock_);
+    streams_.push_back(stream);
+  }
+
+  uint32_t output[2] = {stream.id, static_cast<uint32_t>(sizeof(CwbStreamPage))};
+  ByteStream output_params;
+  output_params.setToExternal(reinterpret_cast<uint8_t*>(output), sizeof(output));
+  std::vector<hidl_handle> handles;
+  handles.push_back(handle);
+  HandleStream output_handles = handles;
+
+  _hidl_cb(0, output_params, output_handles);
+
+  native_handle_close(handle);
+  native_handle_delete(handle);
+}
+
+void DeviceImpl::DeviceClientContext::ParseStopCwbStream(const ByteStream &input_params,
+                                                         perform_cb _hidl_cb) {
+  uint32_t stream_id = 0;
+  if (input_params.size() != sizeof(stream_id)) {
+    _hidl_cb(-EINVAL, {}, {});
+    return;
+  }
+  memcpy(&stream_id, input_params.data(), sizeof(stream_id));
+
+  CwbStreamInstance stream;
+  {
+    std::lock_guard<std::mutex> lock(stream_lock_);
+    for (auto it = streams_.begin(); it != streams_.end(); it++) {
+      if (it->id == stream_id) {
+        stream = *it;
+        streams_.erase(it);
+        break;
+      }
+    }
+  }
+
+  if (!stream.page) {
+    _hidl_cb(-EINVAL, {}, {});
+    return;
+  }
+
+  DestroyCwbStream(&stream);
+  _hidl_cb(0, {}, {});
+}
+
 Return<void> DeviceImpl::perform(uint64_t client_handle, uint32_t op_code,
                                  const ByteStream &input_params, const HandleStream &input_handles,
                                  perform_cb _hidl_cb) {
@@ -919,6 +1016,15 @@ Return<void> DeviceImpl::perform(uint64_t client_handle, uint32_t op_code,
     _hidl_cb(error, {}, {});
      return Void();
   }
+
+  Dispatch(client, client_handle, op_code, input_params, input_handles, _hidl_cb);
+  return Void();
+}
+
+void DeviceImpl::Dispatch(const std::shared_ptr<DeviceClientContext> &client,
+                          uint64_t client_handle, uint32_t op_code,
+                          const ByteStream &input_params, const HandleStream &input_handles,
+                          perform_cb _hidl_cb) {
   switch (op_code) {
     case kIsDisplayConnected:
       client->ParseIsDisplayConnected(input_params, _hidl_cb);
@@ -1073,6 +1179,18 @@ Return<void> DeviceImpl::perform(uint64_t client_handle, uint32_t op_code,
     case kAllowIdleFallback:
       client->ParseAllowIdleFallback(_hidl_cb);
       break;
+    case kBatch:
+      ParseBatch(client, client_handle, input_params, _hidl_cb);
+      break;
+    case kGetStatusPage:
+      ParseGetStatusPage(_hidl_cb);
+      break;
+    case kStartCwbStream:
+      client->ParseStartCwbStream(input_params, input_handles, _hidl_cb);
+      break;
+    case kStopCwbStream:
+      client->ParseStopCwbStream(input_params, _hidl_cb);
+      break;
     case kDummyOpcode:
       _hidl_cb(-EINVAL, {}, {});
       break;
@@ -1080,7 +1198,104 @@ Return<void> DeviceImpl::perform(uint64_t client_handle, uint32_t op_code,
       _hidl_cb(-EINVAL, {}, {});
       break;
   }
-  return Void();
+}
+
+void DeviceImpl::ParseBatch(const std::shared_ptr<DeviceClientContext> &client,
+                            uint64_t client_handle, const ByteStream &input_params,
+                            perform_cb _hidl_cb) {
+  const uint8_t *data = input_params.data();
+  size_t size = input_params.size();
+  size_t offset = 0;
+  uint32_t count = 0;
+  std::vector<uint8_t> output;
+  output.reserve(size);
+
+  while (offset < size) {
+    BatchEntry entry = {};
+    if ((size - offset) < sizeof(entry) || ++count > kMaxBatchEntries) {
+      _hidl_cb(-EINVAL, {}, {});
+      return;
+    }
+    memcpy(&entry, data + offset, sizeof(entry));
+    offset += sizeof(entry);
+
+    uint32_t payload_size = BatchPayloadSize(entry.size);
+    if (entry.size > payload_size || (size - offset) < payload_size) {
+      _hidl_cb(-EINVAL, {}, {});
+      return;
+    }
+
+    // Every entry gets exactly one result. Calls that carry handles, destroy the client or nest
+    // another batch are refused.
+    bool handled = false;
+    auto entry_cb = [&output, &entry, &handled](int32_t error, const ByteStream &params,
+                                                const HandleStream &handles) {
+      if (handled) {
+        return;
+      }
+      handled = true;
+
+      BatchEntry result = {entry.op_code, error, static_cast<uint32_t>(params.size()), 0};
+      size_t result_offset = output.size();
+      output.resize(result_offset + sizeof(result) + BatchPayloadSize(result.size), 0);
+      memcpy(output.data() + result_offset, &result, sizeof(result));
+      if (params.size()) {
+        memcpy(output.data() + result_offset + sizeof(result), params.data(), params.size());
+      }
+    };
+
+    switch (entry.op_code) {
+      case kBatch:
+      case kDestroy:
+      case kGetStatusPage:
+      case kSetCwbOutputBuffer:
+      case kStartCwbStream:
+      case kStopCwbStream:
+        break;
+      default:
+        ByteStream entry_params;
+        entry_params.setToExternal(const_cast<uint8_t*>(data + offset), entry.size);
+        Dispatch(client, client_handle, entry.op_code, entry_params, {}, entry_cb);
+        break;
+    }
+    if (!handled) {
+      entry_cb(-EINVAL, {}, {});
+    }
+    offset += payload_size;
+  }
+
+  ByteStream output_params;
+  output_params.setToExternal(output.data(), output.size());
+  _hidl_cb(0, output_params, {});
+}
+
+void DeviceImpl::ParseGetStatusPage(perform_cb _hidl_cb) {
+  int fd = StatusPage::GetInstance()->DupFd();
+  if (fd < 0) {
+    _hidl_cb(fd, {}, {});
+    return;
+  }
+
+  native_handle_t *handle = native_handle_create(1, 0);
+  if (!handle) {
+    close(fd);
+    _hidl_cb(-ENOMEM, {}, {});
+    return;
+  }
+  handle->data[0] = fd;
+
+  std::vector<hidl_handle> handles;
+  handles.push_back(handle);
+  HandleStream output_handles = handles;
+  uint32_t page_size = static_cast<uint32_t>(sizeof(DisplayStatusPage));
+  ByteStream output_params;
+  output_params.setToExternal(reinterpret_cast<uint8_t*>(&page_size), sizeof(page_size));
+
+  _hidl_cb(0, output_params, output_handles);
+
+  // hidl_handle does not own the native handle, the reply has been sent by now.
+  native_handle_close(handle);
+  native_handle_delete(handle);
 }
 
 }  // namespace DisplayConfig
@@ -76,6 +76,7 @@
 #include <vector>
 #include <shared_mutex>
 
+#include "cwb_stream.h"
 #include "opcode_types.h"
 
 namespace DisplayConfig {
@@ -100,6 +101,7 @@ class DeviceImpl : public IDisplayConfig, public android::hardware::hidl_death_r
   class DeviceClientContext : public ConfigCallback {
    public:
     explicit DeviceClientContext(const sp<IDisplayConfigCallback> callback);
+    ~DeviceClientContext();
 
     void SetDeviceConfigIntf(ConfigInterface *intf);
     ConfigInterface* GetDeviceConfigIntf();
@@ -163,10 +165,15 @@ class DeviceImpl : public IDisplayConfig, public android::hardware::hidl_death_r
     void ParseIsSupportedConfigSwitch(const ByteStream &input_params, perform_cb _hidl_cb);
     void ParseGetDisplayType(const ByteStream &input_params, perform_cb _hidl_cb);
     void ParseAllowIdleFallback(perform_cb _hidl_cb);
+    void ParseStartCwbStream(const ByteStream &input_params, const HandleStream &input_handles,
+                             perform_cb _hidl_cb);
+    void ParseStopCwbStream(const ByteStream &input_params, perform_cb _hidl_cb);
 
    private:
     ConfigInterface *intf_ = nullptr;
     const sp<IDisplayConfigCallback> callback_;
+    std::mutex stream_lock_;
+    std::vector<CwbStreamInstance> streams_;  // stopped when the client goes away
   };
 
   Return<void> registerClient(const hidl_string &client_name, const sp<IDisplayConfigCallback>& cb,
@@ -176,6 +183,12 @@ class DeviceImpl : public IDisplayConfig, public android::hardware::hidl_death_r
   void serviceDied(uint64_t client_handle,
                    const android::wp<::android::hidl::base::V1_0::IBase>& callback);
   void ParseDestroy(uint64_t client_handle, perform_cb _hidl_cb);
+  void Dispatch(const std::shared_ptr<DeviceClientContext> &client, uint64_t client_handle,
+                uint32_t op_code, const ByteStream &input_params,
+                const HandleStream &input_handles, perform_cb _hidl_cb);
+  void ParseBatch(const std::shared_ptr<DeviceClientContext> &client, uint64_t client_handle,
+                  const ByteStream &input_params, perform_cb _hidl_cb);
+  void ParseGetStatusPage(perform_cb _hidl_cb);
 
   ClientContext *intf_ = nullptr;
   std::map<uint64_t, std::shared_ptr<DeviceClientContext>> display_config_map_;
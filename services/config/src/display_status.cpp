@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <new>
+
+#include "client_impl.h"
+#include "shared_page.h"
+#include "status_page.h"
+
+namespace DisplayConfig {
+
+int GetStatusSlot(DisplayType dpy) {
+  switch (dpy) {
+    case DisplayType::kPrimary:
+      return 0;
+    case DisplayType::kExternal:
+      return 1;
+    case DisplayType::kVirtual:
+      return 2;
+    case DisplayType::kBuiltIn2:
+      return 3;
+    default:
+      break;
+  }
+
+  return -EINVAL;
+}
+
+static void MergeStatus(uint32_t fields, const DisplayStatus &from, DisplayStatus *to) {
+  if (fields & kStatusActiveConfig) {
+    to->active_config = from.active_config;
+  }
+  if (fields & kStatusRefreshRate) {
+    to->refresh_rate = from.refresh_rate;
+  }
+  if (fields & kStatusBrightness) {
+    to->brightness_level = from.brightness_level;
+  }
+  if (fields & kStatusQsync) {
+    to->qsync_enabled = from.qsync_enabled;
+    to->qsync_refresh_rate = from.qsync_refresh_rate;
+  }
+  if (fields & kStatusIdle) {
+    to->idle = from.idle;
+  }
+  to->fields |= fields;
+}
+
+static bool SameStatus(const DisplayStatus &a, const DisplayStatus &b) {
+  return a.fields == b.fields && a.active_config == b.active_config &&
+         a.refresh_rate == b.refresh_rate && a.brightness_level == b.brightness_level &&
+         a.qsync_refresh_rate == b.qsync_refresh_rate && a.qsync_enabled == b.qsync_enabled &&
+         a.idle == b.idle;
+}
+
+StatusPage *StatusPage::GetInstance() {
+  static StatusPage *s_instance = new StatusPage();
+  return s_instance;
+}
+
+int StatusPage::Init() {
+  if (page_) {
+    return 0;
+  }
+
+  void *addr = nullptr;
+  int error = CreateSharedPage("display_config_status", sizeof(DisplayStatusPage), true, &fd_,
+                               &addr);
+  if (error) {
+    return error;
+  }
+
+  page_ = new (addr) DisplayStatusPage();
+
+  return 0;
+}
+
+int StatusPage::Publish(DisplayType dpy, uint32_t fields, const DisplayStatus &status) {
+  int slot = GetStatusSlot(dpy);
+  if (slot < 0) {
+    return slot;
+  }
+
+  std::lock_guard<std::mutex> lock(lock_);
+  int error = Init();
+  if (error) {
+    return error;
+  }
+
+  DisplayStatus merged = status_[slot];
+  MergeStatus(fields, status, &merged);
+  if (SameStatus(merged, status_[slot])) {
+    return 0;
+  }
+
+  status_[slot] = merged;
+  page_->displays[slot].Write(merged);
+
+  return 0;
+}
+
+int StatusPage::DupFd() {
+  std::lock_guard<std::mutex> lock(lock_);
+  int error = Init();
+  if (error) {
+    return error;
+  }
+
+  int fd = fcntl(fd_, F_DUPFD_CLOEXEC, 0);
+  return (fd < 0) ? -errno : fd;
+}
+
+int PublishDisplayStatus(DisplayType dpy, uint32_t fields, const DisplayStatus &status) {
+  return StatusPage::GetInstance()->Publish(dpy, fields, status);
+}
+
+int DisplayStatusReader::Init(ClientInterface *intf) {
+  if (!intf) {
+    return -EINVAL;
+  }
+
+  ClientImpl *impl = static_cast<ClientImpl *>(intf);
+  if (!impl->display_config_) {
+    return -ENODEV;
+  }
+
+  DeInit();
+
+  int error = 0;
+  int fd = -1;
+  uint32_t page_size = 0;
+  auto hidl_cb = [&error, &fd, &page_size] (int32_t err, ByteStream params,
+                                            HandleStream handles) {
+    error = err;
+    if (params.size() == sizeof(page_size)) {
+      memcpy(&page_size, params.data(), sizeof(page_size));
+    }
+    const native_handle_t *handle = handles.size() ? handles[0].getNativeHandle() : nullptr;
+    if (!error && handle && handle->numFds == 1) {
+      // The handle is released once the callback returns.
+      fd = fcntl(handle->data[0], F_DUPFD_CLOEXEC, 0);
+    }
+  };
+
+  impl->display_config_->perform(impl->client_handle_, kGetStatusPage, {}, {}, hidl_cb);
+  if (error) {
+    return error;
+  }
+  if (fd < 0 || page_size != sizeof(DisplayStatusPage)) {
+    // Mapping a page of a different layout would read past its end.
+    ALOGW("Unsupported status page size %u", page_size);
+    if (fd >= 0) {
+      close(fd);
+    }
+    return -EINVAL;
+  }
+
+  void *addr = MapSharedPage(fd, sizeof(DisplayStatusPage), false);
+  close(fd);
+  if (!addr) {
+    return -ENOMEM;
+  }
+
+  const DisplayStatusPage *page = static_cast<const DisplayStatusPage *>(addr);
+  if (page->magic != kStatusPageMagic || page->version != kStatusPageVersion ||
+      page->size != sizeof(DisplayStatusPage)) {
+    ALOGW("Unsupported status page version %u", page->version);
+    munmap(addr, sizeof(DisplayStatusPage));
+    return -EINVAL;
+  }
+
+  page_ = page;
+  size_ = sizeof(DisplayStatusPage);
+
+  return 0;
+}
+
+void DisplayStatusReader::DeInit() {
+  if (page_) {
+    munmap(const_cast<DisplayStatusPage *>(page_), size_);
+    page_ = nullptr;
+    size_ = 0;
+  }
+}
+
+int DisplayStatusReader::Read(DisplayType dpy, DisplayStatus *status, uint32_t *sequence) const {
+  if (!page_ || !status) {
+    return -EINVAL;
+  }
+
+  int slot = GetStatusSlot(dpy);
+  if (slot < 0) {
+    return slot;
+  }
+
+  uint32_t seq = page_->displays[slot].Read(status);
+  if (sequence) {
+    *sequence = seq;
+  }
+
+  return status->fields ? 0 : -ENODATA;
+}
+
+}  // namespace DisplayConfig
@@ -30,6 +30,8 @@
 #ifndef __OPCODE_TYPES_H__
 #define __OPCODE_TYPES_H__
 
+#include <stdint.h>
+
 namespace DisplayConfig {
 
 enum OpCode {
@@ -84,10 +86,30 @@ enum OpCode {
   kGetDisplayType = 48,
   kAllowIdleFallback = 49,
   kDummyOpcode = 50,
+  kBatch = 51,
+  kGetStatusPage = 52,
+  kStartCwbStream = 53,
+  kStopCwbStream = 54,
 
   kDestroy = 0xFFFF, // Destroy sequence execution
 };
 
+// kBatch input is a sequence of entries, each a BatchEntry followed by size bytes of input padded
+// to kBatchAlignment. The output has the same layout, with the error and output of every entry.
+struct BatchEntry {
+  uint32_t op_code;
+  int32_t error;
+  uint32_t size;
+  uint32_t reserved;
+};
+
+static const uint32_t kBatchAlignment = 8;
+static const uint32_t kMaxBatchEntries = 64;
+
+inline uint32_t BatchPayloadSize(uint32_t size) {
+  return (size + kBatchAlignment - 1) & ~(kBatchAlignment - 1);
+}
+
 }  // namespace DisplayConfig
 
 #endif  // __OPCODE_TYPES_H__
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <log/log.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "shared_page.h"
+
+namespace DisplayConfig {
+
+int CreateSharedPage(const char *name, size_t size, bool read_only_clients, int *fd,
+                     void **addr) {
+  int page_fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (page_fd < 0) {
+    int error = -errno;
+    ALOGE("Failed to create %s, errno = %d", name, errno);
+    return error;
+  }
+
+  if (ftruncate(page_fd, static_cast<off_t>(size)) < 0) {
+    int error = -errno;
+    ALOGE("Failed to size %s, errno = %d", name, errno);
+    close(page_fd);
+    return error;
+  }
+
+  void *page = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, page_fd, 0);
+  if (page == MAP_FAILED) {
+    int error = -errno;
+    ALOGE("Failed to map %s, errno = %d", name, errno);
+    close(page_fd);
+    return error;
+  }
+
+  int seals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+#ifdef F_SEAL_FUTURE_WRITE
+  // Keeps the mapping above writable while later mappings can only be read-only.
+  if (read_only_clients) {
+    seals |= F_SEAL_FUTURE_WRITE;
+  }
+#endif
+  if (fcntl(page_fd, F_ADD_SEALS, seals) < 0) {
+    ALOGW("Failed to seal %s, errno = %d", name, errno);
+  }
+
+  *fd = page_fd;
+  *addr = page;
+
+  return 0;
+}
+
+void *MapSharedPage(int fd, size_t size, bool writable) {
+  int prot = PROT_READ | (writable ? PROT_WRITE : 0);
+  void *page = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+  if (page == MAP_FAILED) {
+    ALOGW("Failed to map shared page, errno = %d", errno);
+    return nullptr;
+  }
+
+  return page;
+}
+
+}  // namespace DisplayConfig
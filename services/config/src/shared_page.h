@@ -0,0 +1,23 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __SHARED_PAGE_H__
+#define __SHARED_PAGE_H__
+
+#include <stddef.h>
+
+namespace DisplayConfig {
+
+// Creates a memfd of size bytes mapped read-write into the calling process. The size is sealed,
+// with read_only_clients writes through mappings made later from the fd are refused as well.
+// Returns 0 or a negative errno.
+int CreateSharedPage(const char *name, size_t size, bool read_only_clients, int *fd, void **addr);
+
+// Maps a page received from the service, returns nullptr on failure.
+void *MapSharedPage(int fd, size_t size, bool writable);
+
+}  // namespace DisplayConfig
+
+#endif  // __SHARED_PAGE_H__
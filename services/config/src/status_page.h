@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __STATUS_PAGE_H__
+#define __STATUS_PAGE_H__
+
+#include <display_config_status.h>
+#include <mutex>
+
+namespace DisplayConfig {
+
+// Owner of the shared status page in the service process. The page lives in a sealed memfd that
+// clients can only map read-only. It is created on first use and kept for the process lifetime.
+class StatusPage {
+ public:
+  static StatusPage *GetInstance();
+
+  int Publish(DisplayType dpy, uint32_t fields, const DisplayStatus &status);
+  // Returns a new fd of the page for a client, or a negative errno.
+  int DupFd();
+
+ private:
+  int Init();
+
+  std::mutex lock_;
+  int fd_ = -1;
+  DisplayStatusPage *page_ = nullptr;
+  DisplayStatus status_[kMaxStatusDisplays] = {};
+};
+
+int GetStatusSlot(DisplayType dpy);
+
+}  // namespace DisplayConfig
+
+#endif  // __STATUS_PAGE_H__